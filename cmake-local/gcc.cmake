@@ -9,7 +9,16 @@ if (CMAKE_COMPILER_IS_GNUCC)
     
     set(CMAKE_CXX_FLAGS_RELEASE "-O3 -DNDEBUG")
     if (CMAKE_SYSTEM_PROCESSOR MATCHES "Intel" OR CMAKE_SYSTEM_PROCESSOR MATCHES "x86")
-        set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -msse4.2 -mpopcnt -funroll-loops")
+        # target SSE4.2 in all build types, so that debug and test builds exercise
+        # the same SSSE3/SSE4.2 code paths as release ones
+        set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -msse4.2 -mpopcnt")
+        set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -msse4.2 -mpopcnt")
+        set(CMAKE_CXX_FLAGS_RELEASE "${CMAKE_CXX_FLAGS_RELEASE} -funroll-loops")
+    endif()
+
+    if(HOST_AVX2)
+        set(CMAKE_C_FLAGS "${CMAKE_C_FLAGS} -mavx2")
+        set(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -mavx2")
     endif()
 
     if(WERROR)
@@ -36,69 +36,13 @@
 #include <nvbio/strings/alphabet.h>
 #include <nvbio/alignment/alignment.h>
 #include <nvbio/alignment/batched.h>
+#include <nvbio/alignment/substitution_matrix.h>
 #include <thrust/sequence.h>
 #include <stdio.h>
 #include <stdlib.h>
 
 using namespace nvbio;
 
-int8 s_blosum62[] =
-{
- 4,  0, -2, -1, -2,  0, -2, -1, -1, -1, -1, -2, -4, -1, -1, -1,  1,  0,  0, -3, -2, -2, -1,  0,
- 0,  9, -3, -4, -2, -3, -3, -1, -3, -1, -1, -3, -4, -3, -3, -3, -1, -1, -1, -2, -2, -3, -3, -2,
--2, -3,  6,  2, -3, -1, -1, -3, -1, -4, -3,  1, -4, -1,  0, -2,  0, -1, -3, -4, -3,  4,  1, -1,
--1, -4,  2,  5, -3, -2,  0, -3,  1, -3, -2,  0, -4, -1,  2,  0,  0, -1, -2, -3, -2,  1,  4, -1,
--2, -2, -3, -3,  6, -3, -1,  0, -3,  0,  0, -3, -4, -4, -3, -3, -2, -2, -1,  1,  3, -3, -3, -1,
- 0, -3, -1, -2, -3,  6, -2, -4, -2, -4, -3,  0, -4, -2, -2, -2,  0, -2, -3, -2, -3, -1, -2, -1,
--2, -3, -1,  0, -1, -2,  8, -3, -1, -3, -2,  1, -4, -2,  0,  0, -1, -2, -3, -2,  2,  0,  0, -1,
--1, -1, -3, -3,  0, -4, -3,  4, -3,  2,  1, -3, -4, -3, -3, -3, -2, -1,  3, -3, -1, -3, -3, -1,
--1, -3, -1,  1, -3, -2, -1, -3,  5, -2, -1,  0, -4, -1,  1,  2,  0, -1, -2, -3, -2,  0,  1, -1,
--1, -1, -4, -3,  0, -4, -3,  2, -2,  4,  2, -3, -4, -3, -2, -2, -2, -1,  1, -2, -1, -4, -3, -1,
--1, -1, -3, -2,  0, -3, -2,  1, -1,  2,  5, -2, -4, -2,  0, -1, -1, -1,  1, -1, -1, -3, -1, -1,
--2, -3,  1,  0, -3,  0,  1, -3,  0, -3, -2,  6, -4, -2,  0,  0,  1,  0, -3, -4, -2,  3,  0, -1,
--4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,  1, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,
--1, -3, -1, -1, -4, -2, -2, -3, -1, -3, -2, -2, -4,  7, -1, -2, -1, -1, -2, -4, -3, -2, -1, -2,
--1, -3,  0,  2, -3, -2,  0, -3,  1, -2,  0,  0, -4, -1,  5,  1,  0, -1, -2, -2, -1,  0,  3, -1,
--1, -3, -2,  0, -3, -2,  0, -3,  2, -2, -1,  0, -4, -2,  1,  5, -1, -1, -3, -3, -2, -1,  0, -1,
- 1, -1,  0,  0, -2,  0, -1, -2,  0, -2, -1,  1, -4, -1,  0, -1,  4,  1, -2, -3, -2,  0,  0,  0,
- 0, -1, -1, -1, -2, -2, -2, -1, -1, -1, -1,  0, -4, -1, -1, -1,  1,  5,  0, -2, -2, -1, -1,  0,
- 0, -1, -3, -2, -1, -3, -3,  3, -2,  1,  1, -3, -4, -2, -2, -3, -2,  0,  4, -3, -1, -3, -2, -1,
--3, -2, -4, -3,  1, -2, -2, -3, -3, -2, -1, -4, -4, -4, -2, -3, -3, -2, -3, 11,  2, -4, -3, -2,
--2, -2, -3, -2,  3, -3,  2, -1, -2, -1, -1, -2, -4, -3, -1, -2, -2, -2, -1,  2,  7, -3, -2, -1,
--2, -3,  4,  1, -3, -1,  0, -3,  0, -4, -3,  3, -4, -2,  0, -1,  0, -1, -3, -4, -3,  4,  1, -1,
--1, -3,  1,  4, -3, -2,  0, -3,  1, -3, -1,  0, -4, -1,  3,  0,  0, -1, -2, -3, -2,  1,  4, -1,
- 0, -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -4, -2, -1, -1,  0,  0, -1, -2, -1, -1, -1, -1,
-};
-
-// A scoring scheme class that will be used in conjunction with the \ref GotohAligner;
-//
-template <typename matrix_iterator>
-struct BlosumScheme
-{
-    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE BlosumScheme(const matrix_iterator m, const int32 gap_open, const int32 gap_ext) :
-        m_matrix(m), m_gap_open(gap_open), m_gap_ext(gap_ext) {}
-
-    // return the maximum match bonus at the given quality score
-    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 match(const uint8 q = 0) const { return 11; };
-
-    // return the substitution score at the given (reference,query) position (r_i,q_j),
-    // with values (r,q) and quality score qq
-    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 substitution(
-        const uint32 r_i, const uint32 q_j,
-        const uint8  r,  const uint8   q,
-        const uint8  qq = 0) const { return int8( m_matrix[ r + q*24 ] ); };
-
-    // return gap open and extension penalties for the pattern (query) and the text (reference)
-    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 pattern_gap_open()      const { return m_gap_open; };
-    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 pattern_gap_extension() const { return m_gap_ext; };
-    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_open()         const { return m_gap_open; };
-    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_extension()    const { return m_gap_ext; };
-
-    const matrix_iterator   m_matrix;
-    const int32             m_gap_open;
-    const int32             m_gap_ext;
-};
-
 // main test entry point
 //
 int main(int argc, char* argv[])
@@ -109,11 +53,18 @@ int main(int argc, char* argv[])
     const uint32 P         = 128;
     const uint32 T         = 1024;
 
-    // alloc a device vector for holding the Blosum-62 scoring matrix
-    nvbio::vector<device_tag,uint8> d_blosum62( 24*24 );
+    // select the substitution matrix, either one of the built-in ones or a file in NCBI format
+    aln::SubstitutionMatrix matrix( aln::SubstitutionMatrix::BLOSUM62 );
+    if (argc > 1 && matrix.set( argv[1] ) == false)
+        return 1;
+
+    log_info(stderr, "  matrix: %s\n", matrix.name());
+
+    // alloc a device vector for holding the scoring matrix
+    nvbio::vector<device_tag,int8> d_matrix( 24*24 );
 
     // copy the matrix to the device
-    thrust::copy( s_blosum62, s_blosum62 + 24*24, d_blosum62.begin() );
+    thrust::copy( matrix.data(), matrix.data() + 24*24, d_matrix.begin() );
 
     // alloc the storage for the host strings
     nvbio::vector<host_tag,uint8>  h_pattern_strings( P * n_strings );
@@ -184,7 +135,7 @@ int main(int argc, char* argv[])
         log_info(stderr, "  GCUPS (Constant/T): %.1f\n", (1.0e-9f * float(P*T) * float(n_strings) * float(n_tests))/timer.seconds());
     }
     {
-        const BlosumScheme< cuda::ldg_pointer<uint8> > scoring( cuda::make_ldg_pointer( raw_pointer( d_blosum62 ) ), -5, -3 );
+        const aln::MatrixGotohScheme< cuda::ldg_pointer<int8> > scoring( cuda::make_ldg_pointer( raw_pointer( d_matrix ) ), matrix.max_score(), -5, -3 );
 
         Timer timer;
         timer.start();
@@ -203,10 +154,10 @@ int main(int argc, char* argv[])
         cudaDeviceSynchronize();
 
         timer.stop();
-        log_info(stderr, "  GCUPS (Blosum62/P): %.1f\n", (1.0e-9f * float(P*T) * float(n_strings) * float(n_tests))/timer.seconds());
+        log_info(stderr, "  GCUPS (Matrix/P): %.1f\n", (1.0e-9f * float(P*T) * float(n_strings) * float(n_tests))/timer.seconds());
     }
     {
-        const BlosumScheme< cuda::ldg_pointer<uint8> > scoring( cuda::make_ldg_pointer( raw_pointer( d_blosum62 ) ), -5, -3 );
+        const aln::MatrixGotohScheme< cuda::ldg_pointer<int8> > scoring( cuda::make_ldg_pointer( raw_pointer( d_matrix ) ), matrix.max_score(), -5, -3 );
 
         Timer timer;
         timer.start();
@@ -225,7 +176,41 @@ int main(int argc, char* argv[])
         cudaDeviceSynchronize();
 
         timer.stop();
-        log_info(stderr, "  GCUPS (Blosum62/T): %.1f\n", (1.0e-9f * float(P*T) * float(n_strings) * float(n_tests))/timer.seconds());
+        log_info(stderr, "  GCUPS (Matrix/T): %.1f\n", (1.0e-9f * float(P*T) * float(n_strings) * float(n_tests))/timer.seconds());
+    }
+
+    {
+        // score a subset of the problems on the host, building a query profile per pattern
+        const uint32 n_host_strings = 1000;
+
+        int32 checksum[2] = { 0, 0 };
+        float seconds[2];
+        for (uint32 simd = 0; simd < 2; ++simd)
+        {
+            Timer timer;
+            timer.start();
+
+            aln::QueryProfile profile;
+            for (uint32 i = 0; i < n_host_strings; ++i)
+            {
+                const vector_view<const uint8*> pattern( P, raw_pointer( h_pattern_strings ) + i*P );
+                const vector_view<const uint8*> text(    T, raw_pointer( h_text_strings )    + i*T );
+
+                profile.build( matrix, pattern );
+
+                checksum[simd] += simd ?
+                    aln::query_profile_score( profile, text, -5, -3 ) :
+                    aln::query_profile_score_scalar( profile, text, -5, -3 );
+            }
+
+            timer.stop();
+            seconds[simd] = timer.seconds();
+        }
+        if (checksum[0] != checksum[1])
+            log_error(stderr, "  mismatching host scores: %d != %d\n", checksum[0], checksum[1]);
+
+        log_info(stderr, "  GCUPS (Host/profile): %.2f\n", (1.0e-9f * float(P*T) * float(n_host_strings))/seconds[0]);
+        log_info(stderr, "  GCUPS (Host/striped): %.2f\n", (1.0e-9f * float(P*T) * float(n_host_strings))/seconds[1]);
     }
 
     log_info(stderr, "protein SW... done\n");
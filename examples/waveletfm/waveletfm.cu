@@ -32,7 +32,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/timer.h>
 #include <nvbio/basic/vector.h>
 #include <nvbio/basic/packed_vector.h>
 #include <nvbio/strings/alphabet.h>
@@ -42,56 +45,88 @@
 
 using namespace nvbio;
 
-// main test entry point
-//
-int main(int argc, char* argv[])
-{
-    log_info(stderr, "waveletfm... started\n");
-
-    const char* proteins = "ACDEFGHIKLMNOPQRSTVWYBZX";
-    const uint32 text_len = 24;
-    const uint32 alphabet_bits = AlphabetTraits<PROTEIN>::SYMBOL_SIZE;
-    const uint32 alphabet_size = 1u << alphabet_bits;
+static const uint32 alphabet_bits = AlphabetTraits<PROTEIN>::SYMBOL_SIZE;
+static const uint32 alphabet_size = 1u << alphabet_bits;
 
-    // print the text
-    log_info(stderr, "  text: %s\n", proteins);
-
-    // allocate a host packed vector
-    PackedVector<host_tag,alphabet_bits,true> h_text( text_len );
-
-    // pack the string
-    from_string<PROTEIN>( proteins, proteins + text_len, h_text.begin() );
+typedef PackedVector<host_tag,alphabet_bits,true>   h_text_type;
+typedef PackedVector<device_tag,alphabet_bits,true> d_text_type;
 
-    // copy it to the device
-    PackedVector<device_tag,alphabet_bits,true> d_text( h_text );
-
-    // allocate a vector for the BWT
-    PackedVector<device_tag,alphabet_bits,true> d_bwt( text_len + 1 );
+// the available wavelet tree layouts
+//
+enum WaveletLayout
+{
+    kPlainLayout        = 1u,
+    kInterleavedLayout  = 2u,
+};
 
-    BWTParams bwt_params;
+// a functor matching a pattern sampled at a pseudo-random position of the text
+//
+template <typename fm_index_type, typename text_iterator>
+struct match_functor
+{
+    typedef uint32 argument_type;
+    typedef uint2  result_type;
 
-    // build the BWT
-    const uint32 primary = cuda::bwt( text_len, d_text.begin(), d_bwt.begin(), &bwt_params );
+    // constructor
+    NVBIO_HOST_DEVICE
+    match_functor(
+        const fm_index_type _fmi,
+        const text_iterator _text,
+        const uint32        _text_len,
+        const uint32        _pattern_len) :
+        fmi( _fmi ), text( _text ), text_len( _text_len ), pattern_len( _pattern_len ) {}
 
-    // print the BWT
+    // unary operator
+    NVBIO_HOST_DEVICE
+    uint2 operator() (const uint32 i) const
     {
-        char proteins_bwt[ 25 ];
+        LCG_random rand( i );
+        rand.next();
 
-        to_string<PROTEIN>( d_bwt.begin(), d_bwt.begin() + text_len, proteins_bwt );
+        const uint32 offset = (rand.next() >> 8) % (text_len - pattern_len + 1u);
 
-        log_info(stderr, "  bwt: %s (primary %u)\n", proteins_bwt, primary);
+        return match( fmi, text + offset, pattern_len );
     }
 
-    // define our wavelet tree storage type and its plain view
-    typedef WaveletTreeStorage<device_tag>                          wavelet_tree_type;
-    typedef WaveletTreeStorage<device_tag>::const_plain_view_type   wavelet_tree_view_type;
+    const fm_index_type fmi;
+    const text_iterator text;
+    const uint32        text_len;
+    const uint32        pattern_len;
+};
+
+// build an FM-index on top of a wavelet tree with the given layout, and use it
+// to match a batch of patterns sampled from the text
+//
+template <typename wavelet_tree_type>
+void search(
+    const char*         layout_name,
+    const uint32        text_len,
+    const char*         proteins,
+    const d_text_type&  d_text,
+    const d_text_type&  d_bwt,
+    const uint32        primary,
+    const uint32        n_queries,
+    const uint32        pattern_len)
+{
+    log_info(stderr, "  %s wavelet tree:\n", layout_name);
+
+    // define the plain view of our wavelet tree storage type
+    typedef typename wavelet_tree_type::const_plain_view_type   wavelet_tree_view_type;
 
     // build a wavelet tree
     wavelet_tree_type wavelet_bwt;
 
+    Timer timer;
+    timer.start();
+
     // setup the wavelet tree
     setup( text_len, d_bwt.begin(), wavelet_bwt );
 
+    cudaDeviceSynchronize();
+    timer.stop();
+
+    log_info(stderr, "    build: %.2f ms\n", timer.seconds() * 1000.0f);
+
     typedef nvbio::vector<device_tag,uint32>::const_iterator            l2_iterator;
     typedef fm_index<wavelet_tree_view_type, null_type, l2_iterator>    fm_index_type;
 
@@ -116,22 +151,144 @@ int main(int argc, char* argv[])
         wavelet_bwt_view,
         null_type() );
 
-    // do some string matching using our newly built FM-index - once again
-    // we are doing it on the host, though all data is on the device: the entire
-    // loop would be better moved to the device in a real app.
-    log_info(stderr, "  string matching:\n");
-    for (uint32 i = 0; i < text_len; ++i)
+    if (proteins)
     {
-        // match the i-th suffix of the text
-        const uint32 pattern_len = text_len - i;
+        // do some string matching using our newly built FM-index - once again
+        // we are doing it on the host, though all data is on the device: the entire
+        // loop would be better moved to the device in a real app.
+        log_info(stderr, "    string matching:\n");
+        for (uint32 i = 0; i < text_len; ++i)
+        {
+            // match the i-th suffix of the text
+            const uint32 pattern_len = text_len - i;
 
-        // compute the SA range containing the occurrences of the pattern we are after
-        const uint2 range = match( fmi, d_text.begin() + i, pattern_len );
+            // compute the SA range containing the occurrences of the pattern we are after
+            const uint2 range = match( fmi, d_text.begin() + i, pattern_len );
 
-        // print the number of occurrences of our pattern, equal to the SA range size
-        log_info(stderr, "    rank(%s): %u\n", proteins + i, 1u + range.y - range.x);
+            // print the number of occurrences of our pattern, equal to the SA range size
+            log_info(stderr, "      rank(%s): %u\n", proteins + i, 1u + range.y - range.x);
+        }
     }
 
+    // and now match a whole batch of patterns in parallel, this time on the device
+    const uint32 query_len = nvbio::min( pattern_len, text_len );
+
+    nvbio::vector<device_tag,uint2> d_ranges( n_queries );
+
+    timer.start();
+
+    nvbio::transform<device_tag>(
+        n_queries,
+        thrust::make_counting_iterator<uint32>(0u),
+        d_ranges.begin(),
+        match_functor<fm_index_type,typename d_text_type::const_iterator>( fmi, d_text.begin(), text_len, query_len ) );
+
+    cudaDeviceSynchronize();
+    timer.stop();
+
+    // count the total number of occurrences, which must not depend on the layout
+    const nvbio::vector<host_tag,uint2> h_ranges( d_ranges );
+
+    uint64 n_occurrences = 0;
+    for (uint32 i = 0; i < n_queries; ++i)
+        n_occurrences += h_ranges[i].x <= h_ranges[i].y ? 1u + h_ranges[i].y - h_ranges[i].x : 0u;
+
+    log_info(stderr, "    matched %u patterns of length %u: %.2f M queries/s (%llu occurrences)\n",
+        n_queries, query_len,
+        1.0e-6f * float(n_queries) / timer.seconds(),
+        (unsigned long long)n_occurrences);
+}
+
+// main test entry point
+//
+int main(int argc, char* argv[])
+{
+    const char* example = "ACDEFGHIKLMNOPQRSTVWYBZX";
+
+    uint32 text_len    = 0;
+    uint32 n_queries   = 1024*1024;
+    uint32 pattern_len = 8;
+    uint32 layouts     = kPlainLayout | kInterleavedLayout;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp( argv[i], "-length" ) == 0)
+            text_len = atoi( argv[++i] )*1000;
+        else if (strcmp( argv[i], "-queries" ) == 0)
+            n_queries = atoi( argv[++i] )*1000;
+        else if (strcmp( argv[i], "-pattern-length" ) == 0)
+            pattern_len = atoi( argv[++i] );
+        else if (strcmp( argv[i], "-layout" ) == 0)
+        {
+            ++i;
+            if      (strcmp( argv[i], "plain" ) == 0)       layouts = kPlainLayout;
+            else if (strcmp( argv[i], "interleaved" ) == 0) layouts = kInterleavedLayout;
+            else if (strcmp( argv[i], "both" ) == 0)        layouts = kPlainLayout | kInterleavedLayout;
+            else
+            {
+                log_error(stderr, "unknown layout \"%s\", expected plain|interleaved|both\n", argv[i]);
+                return 1;
+            }
+        }
+    }
+
+    log_info(stderr, "waveletfm... started\n");
+
+    // use the example string, or generate a random text if a length was specified
+    std::vector<char> proteins( example, example + strlen( example ) );
+    if (text_len)
+    {
+        LCG_random rand;
+
+        proteins.resize( text_len );
+        for (uint32 i = 0; i < text_len; ++i)
+            proteins[i] = example[ (rand.next() >> 8) % 24u ];
+    }
+    text_len = uint32( proteins.size() );
+    proteins.push_back( '\0' );
+
+    // print the text
+    if (text_len <= 64)
+        log_info(stderr, "  text: %s\n", &proteins[0]);
+    else
+        log_info(stderr, "  text: %u symbols\n", text_len);
+
+    // allocate a host packed vector
+    h_text_type h_text( text_len );
+
+    // pack the string
+    from_string<PROTEIN>( &proteins[0], &proteins[0] + text_len, h_text.begin() );
+
+    // copy it to the device
+    d_text_type d_text( h_text );
+
+    // allocate a vector for the BWT
+    d_text_type d_bwt( text_len + 1 );
+
+    BWTParams bwt_params;
+
+    // build the BWT
+    const uint32 primary = cuda::bwt( text_len, d_text.begin(), d_bwt.begin(), &bwt_params );
+
+    // print the BWT
+    if (text_len <= 64)
+    {
+        char proteins_bwt[ 65 ];
+
+        to_string<PROTEIN>( d_bwt.begin(), d_bwt.begin() + text_len, proteins_bwt );
+
+        log_info(stderr, "  bwt: %s (primary %u)\n", proteins_bwt, primary);
+    }
+
+    // print the matches of all suffixes only for short texts
+    const char* suffixes = text_len <= 64 ? &proteins[0] : NULL;
+
+    if (layouts & kPlainLayout)
+        search< WaveletTreeStorage<device_tag> >( "plain", text_len, suffixes, d_text, d_bwt, primary, n_queries, pattern_len );
+
+    if (layouts & kInterleavedLayout)
+        search< InterleavedWaveletTreeStorage<device_tag> >( "interleaved", text_len, suffixes, d_text, d_bwt, primary, n_queries, pattern_len );
+
     log_info(stderr, "waveletfm... done\n");
     return 0;
 }
@@ -43,6 +43,7 @@
 #include <nvbio/basic/numbers.h>
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/packedstream_transcode.h>
 #include <nvbio/basic/thrust_view.h>
 #include <nvbio/basic/dna.h>
 #include <nvbio/basic/exceptions.h>
@@ -273,8 +274,7 @@ void save_bpac(const uint32 seq_length, const uint32* string_storage, const char
     pac_stream_type pac_string( nvbio::plain_view( pac_storage ) );
         stream_type     string( string_storage );
 
-    for (uint32 i = 0; i < seq_length; ++i)
-        pac_string[i] = string[i];
+    packed_repack( int64( seq_length ), string, pac_string );
 
     // save the uint8 stream
     if (save_stream( output_file, seq_bytes, nvbio::raw_pointer( pac_storage ) ) == false)
@@ -521,9 +521,8 @@ int build(
             uint32* h_rbase_stream = nvbio::plain_view( h_bwt_storage );
             stream_type h_rstring( h_rbase_stream );
 
-            // reverse the string
-            for (uint32 i = 0; i < seq_length; ++i)
-                h_rstring[i] = h_string[ seq_length - i - 1u ];
+            // reverse the string, a word at a time
+            packed_reverse( uint32( seq_length ), const_stream_type( nvbio::plain_view( h_string_storage ) ), h_rstring );
 
             // and now swap the vectors
             h_bwt_storage.swap( h_string_storage );
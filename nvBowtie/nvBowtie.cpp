@@ -39,6 +39,7 @@
 #include <nvbio/io/fmindex/fmindex.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/sequence/sequence_mmap.h>
+#include <nvbio/io/index_server.h>
 #include <nvbio/io/output/output_file.h>
 #include <nvBowtie/bowtie2/cuda/params.h>
 #include <nvBowtie/bowtie2/cuda/stats.h>
@@ -140,6 +141,7 @@ int main(int argc, char* argv[])
         log_info(stderr,"    --device            int [0]        select the given cuda device(s) (e.g. --device 0 --device 1 ...)\n");
         log_info(stderr,"    --file-ref                         load reference from file\n");
         log_info(stderr,"    --server-ref                       load reference from server\n");
+        log_info(stderr,"    --index-server      string         attach to the named reference of an nvFM-server daemon\n");
         log_info(stderr,"    --phred33                          qualities are ASCII characters equal to Phred quality + 33\n");
         log_info(stderr,"    --phred64                          qualities are ASCII characters equal to Phred quality + 64\n");
         log_info(stderr,"    --solexa-quals                     qualities are in the Solexa format\n");
@@ -237,6 +239,7 @@ int main(int argc, char* argv[])
     const char* read_name2      = "";
     const char* reference_name  = "";
     const char* output_name     = "";
+    const char* index_server    = NULL;
 
     for (int32 i = 1; i < argc; ++i)
     {
@@ -272,6 +275,12 @@ int main(int argc, char* argv[])
         else if (strcmp( argv[i], "-server-ref" )  == 0 ||
                  strcmp( argv[i], "--server-ref" ) == 0)
             from_file = false;
+        else if (strcmp( argv[i], "-index-server" )  == 0 ||
+                 strcmp( argv[i], "--index-server" ) == 0)
+        {
+            index_server = argv[++i];
+            from_file    = false;
+        }
         else if (strcmp( argv[i], "-input" )  == 0 ||
                  strcmp( argv[i], "--input" ) == 0)
         {
@@ -471,6 +480,21 @@ int main(int argc, char* argv[])
         // Load the reference
         //
 
+        // attach to the current generation of the reference served by an nvFM-server daemon:
+        // the daemon keeps it mapped for as long as we stay connected, even if it gets swapped
+        io::IndexServerClient index_client;
+        std::string           mapped_reference_name;
+        if (index_server)
+        {
+            if (index_client.connect( index_server ) == false ||
+                index_client.attach( reference_name, mapped_reference_name ) == false)
+            {
+                log_error(stderr, "unable to attach to reference \"%s\" on index server \"%s\"\n", reference_name, index_server);
+                return 1;
+            }
+            reference_name = mapped_reference_name.c_str();
+        }
+
         SharedPointer<nvbio::io::SequenceData> reference_data;
         SharedPointer<nvbio::io::FMIndexData>  driver_data;
         if (from_file)
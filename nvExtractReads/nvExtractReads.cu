@@ -31,6 +31,7 @@
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/shared_pointer.h>
 #include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_nvr.h>
 #include <nvbio/basic/dna.h>
 #include <thrust/host_vector.h>
 #include <thrust/device_vector.h>
@@ -204,11 +205,70 @@ bool to_packed(const char* reads_name, void* output_file, void* output_index, co
     return true;
 }
 
+bool to_nvr(const char* reads_name, const char* out_name, const char* options, const Alphabet alphabet, const io::QualityEncoding qencoding, const io::SequenceEncoding flags)
+{
+    log_visible(stderr, "opening read file \"%s\"\n", reads_name);
+    SharedPointer<nvbio::io::SequenceDataStream> read_data_file(
+        nvbio::io::open_sequence_file(reads_name,
+        qencoding,
+        uint32(-1),
+        uint32(-1),
+        flags )
+    );
+
+    if (read_data_file == NULL || read_data_file->is_ok() == false)
+    {
+        log_error(stderr, "    failed opening file \"%s\"\n", reads_name);
+        return false;
+    }
+
+    SharedPointer<nvbio::io::SequenceDataOutputStream> output_file(
+        nvbio::io::open_output_sequence_file( out_name, options ) );
+
+    if (output_file == NULL || output_file->is_ok() == false)
+    {
+        log_error(stderr, "    failed opening file \"%s\"\n", out_name);
+        return false;
+    }
+
+    const uint32 batch_size = 512*1024;
+
+    uint32 n_reads = 0;
+    uint64 n_bps   = 0;
+
+    io::SequenceDataHost h_read_data;
+
+    // loop through all read batches
+    while (1)
+    {
+        // load a new batch of reads
+        if (io::next( alphabet, &h_read_data, read_data_file.get(), batch_size ) == 0)
+            break;
+
+        // and append them to the container
+        output_file->next( h_read_data );
+        if (output_file->is_ok() == false)
+        {
+            log_error( stderr, "unable to write to output\n");
+            return false;
+        }
+
+        n_reads += h_read_data.size();
+        n_bps   += h_read_data.bps();
+
+        log_verbose(stderr,"\r    %u reads (%.2fGbps)    ", n_reads, float( n_bps ) * 1.0e-9f);
+    }
+    log_verbose_cont(stderr,"\n");
+    return true;
+}
+
 enum Format
 {
     ASCII_FORMAT   = 0u,
     PACKED2_FORMAT = 1u,
     PACKED4_FORMAT = 2u,
+    NVR2_FORMAT    = 3u,
+    NVR4_FORMAT    = 4u,
 };
 
 int main(int argc, char* argv[])
@@ -224,6 +284,9 @@ int main(int argc, char* argv[])
         log_info(stderr, "  -a | --ascii                 ASCII_FORMAT output\n");
         log_info(stderr, "  -p2 | --packed-2             2-bits packed output\n");
         log_info(stderr, "  -p4 | --packed-4             4-bits packed output\n");
+        log_info(stderr, "  -nvr2 | --nvr-2              2-bits .nvr read container output\n");
+        log_info(stderr, "  -nvr4 | --nvr-4              4-bits .nvr read container output\n");
+        log_info(stderr, "  --nvr-options string         .nvr options, e.g. \"binned,tokens,block=65536\"\n");
         log_info(stderr, "  -i  | --idx string           save an index file\n");
         exit(0);
     }
@@ -231,6 +294,7 @@ int main(int argc, char* argv[])
     const char* reads_name  = argv[argc-2];
     const char* out_name    = argv[argc-1];
     const char* idx_name    = NULL;
+    const char* nvr_options = NULL;
     bool  forward           = true;
     bool  reverse           = true;
     Format format           = ASCII_FORMAT;
@@ -268,6 +332,20 @@ int main(int argc, char* argv[])
         {
             format = PACKED4_FORMAT;
         }
+        else if (strcmp( argv[i], "-nvr2" ) == 0 ||
+                 strcmp( argv[i], "--nvr-2" ) == 0)     // 2-bits .nvr container
+        {
+            format = NVR2_FORMAT;
+        }
+        else if (strcmp( argv[i], "-nvr4" ) == 0 ||
+                 strcmp( argv[i], "--nvr-4" ) == 0)     // 4-bits .nvr container
+        {
+            format = NVR4_FORMAT;
+        }
+        else if (strcmp( argv[i], "--nvr-options" ) == 0) // .nvr options
+        {
+            nvr_options = argv[++i];
+        }
         else if (strcmp( argv[i], "-i" ) == 0 ||
                  strcmp( argv[i], "--idx" ) == 0)       // index file
         {
@@ -275,6 +353,33 @@ int main(int argc, char* argv[])
         }
     }
 
+    uint32       encoding_flags  = 0u;
+    if (forward) encoding_flags |= io::FORWARD;
+    if (reverse) encoding_flags |= io::REVERSE_COMPLEMENT;
+
+    if (format == NVR2_FORMAT || format == NVR4_FORMAT)
+    {
+        // the .nvr container is written through its own SequenceDataOutputStream
+        if (io::is_nvr_file( out_name ) == false)
+        {
+            log_error(stderr, "    the output of the .nvr formats must have a .nvr extension\n");
+            return 1;
+        }
+
+        log_visible(stderr,"nvExtractReads... started\n");
+
+        const bool success = to_nvr(
+            reads_name,
+            out_name,
+            nvr_options,
+            format == NVR2_FORMAT ? DNA : DNA_N,
+            qencoding,
+            io::SequenceEncoding(encoding_flags) );
+
+        log_visible(stderr,"nvExtractReads... done\n");
+        return success ? 0u : 1u;
+    }
+
     std::string out_string = out_name;
     // parse out file extension; look for .fastq.gz, .fastq suffixes
     uint32 len = uint32( strlen(out_name) );
@@ -322,11 +427,7 @@ int main(int argc, char* argv[])
 
     log_visible(stderr,"nvExtractReads... started\n");
 
-    uint32       encoding_flags  = 0u;
-    if (forward) encoding_flags |= io::FORWARD;
-    if (reverse) encoding_flags |= io::REVERSE_COMPLEMENT;
-
-    bool success;
+    bool success = false;
 
     switch (format)
     {
@@ -339,6 +440,8 @@ int main(int argc, char* argv[])
     case PACKED4_FORMAT:
         success = to_packed<4u>( reads_name, output_file, output_index, qencoding, io::SequenceEncoding(encoding_flags) );
         break;
+    default:
+        break;
     }
 
     if (output_file)  gzclose( output_file );
@@ -0,0 +1,502 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include "index_daemon.h"
+#include <nvbio/basic/console.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdio.h>
+
+#ifndef WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#include <signal.h>
+#endif
+
+namespace nvbio {
+
+///
+/// A background thread loading a new index generation
+///
+struct IndexLoader : public Thread<IndexLoader>
+{
+    IndexLoader(IndexDaemon* _daemon, const SharedPointer<IndexGeneration>& _generation, const MappingOptions& _options) :
+        daemon( _daemon ), generation( _generation ), options( _options ), m_done( false ) {}
+
+    void run()
+    {
+        log_info(stderr, "loading index \"%s\" (generation %u) from \"%s\"... started\n",
+            generation->name.c_str(), generation->generation, generation->genome_prefix.c_str());
+
+        generation->reference.set_mapping_options( options );
+        generation->fmindex.set_mapping_options( options );
+
+        const bool success =
+            generation->reference.load( DNA, generation->genome_prefix.c_str(), generation->mapped_name.c_str() ) &&
+            generation->fmindex.load( generation->genome_prefix.c_str(), generation->mapped_name.c_str() );
+
+        log_info(stderr, "loading index \"%s\" (generation %u)... %s\n",
+            generation->name.c_str(), generation->generation, success ? "done" : "failed");
+
+        // hand our reference over to the daemon: the reference count isn't atomic,
+        // so it must be released under the daemon's lock
+        daemon->publish( generation, success );
+
+        ScopedLock lock( &m_done_mutex );
+        m_done = true;
+    }
+
+    // return true once the loader has finished, and can be joined
+    //
+    bool done()
+    {
+        ScopedLock lock( &m_done_mutex );
+        return m_done;
+    }
+
+    IndexDaemon*                    daemon;
+    SharedPointer<IndexGeneration>  generation;
+    MappingOptions                  options;
+    Mutex                           m_done_mutex;
+    bool                            m_done;
+};
+
+namespace {
+
+// split a command line into whitespace-separated tokens
+//
+std::vector<std::string> tokenize(const std::string& line)
+{
+    std::vector<std::string> tokens;
+
+    size_t begin = line.find_first_not_of( " \t\r" );
+    while (begin != std::string::npos)
+    {
+        const size_t end = line.find_first_of( " \t\r", begin );
+        tokens.push_back( line.substr( begin, end == std::string::npos ? std::string::npos : end - begin ) );
+        begin = line.find_first_not_of( " \t\r", end );
+    }
+    return tokens;
+}
+
+// format a memory size in MB
+//
+std::string format_mb(const uint64 bytes)
+{
+    char buffer[32];
+    snprintf( buffer, sizeof(buffer), "%.1f MB", float(bytes) / float(1024*1024) );
+    return std::string( buffer );
+}
+
+// format an unsigned integer
+//
+std::string format_uint(const uint32 value)
+{
+    char buffer[16];
+    snprintf( buffer, sizeof(buffer), "%u", value );
+    return std::string( buffer );
+}
+
+// the prefix of each item line of a multi-line reply: since index names can't contain
+// whitespace, item lines can never be mistaken for the final "ok" / "error" status line
+//
+const char LIST_ITEM[] = "  ";
+
+} // anonymous namespace
+
+// start loading a named index in the background
+//
+bool IndexDaemon::load(const std::string& name, const std::string& genome_prefix, const bool swap, std::string& reply)
+{
+    // index names are single tokens of printable characters, as the control protocol relies on it
+    bool valid_name = name.empty() == false;
+    for (size_t i = 0; i < name.length(); ++i)
+        valid_name = valid_name && isgraph( (unsigned char)name[i] );
+
+    if (valid_name == false)
+    {
+        reply = "error invalid index name \"" + name + "\"";
+        return false;
+    }
+
+    SharedPointer<IndexGeneration> generation( new IndexGeneration );
+    {
+        ScopedLock lock( &m_mutex );
+
+        Entry& entry = m_indices[ name ];
+        if (entry.loading)
+        {
+            reply = "error \"" + name + "\" is already being loaded";
+            return false;
+        }
+        if (swap == false && entry.current)
+        {
+            reply = "error \"" + name + "\" is already loaded, use swap to replace it";
+            return false;
+        }
+        if (swap == true && !entry.current)
+        {
+            reply = "error \"" + name + "\" is not loaded";
+            return false;
+        }
+
+        entry.loading = true;
+
+        generation->name          = name;
+        generation->genome_prefix = genome_prefix;
+        generation->generation    = ++entry.last_generation;
+
+        // the first generation is mapped under the plain index name, so that it can also be
+        // accessed directly; later ones get a unique name, returned to clients by attach
+        generation->mapped_name = generation->generation == 1 ? name : name + "." + format_uint( generation->generation );
+    }
+
+    SharedPointer<IndexLoader> loader( new IndexLoader( this, generation, m_options ) );
+    m_loaders.push_back( loader );
+
+    // the loader now holds the only reference to the generation: drop ours before
+    // starting it, as the reference count isn't atomic
+    const std::string mapped_name = generation->mapped_name;
+    generation = SharedPointer<IndexGeneration>();
+
+    loader->create();
+
+    reply = "ok loading \"" + name + "\" as \"" + mapped_name + "\"";
+    return true;
+}
+
+// publish a loaded generation, taking over the caller's reference
+//
+void IndexDaemon::publish(SharedPointer<IndexGeneration>& generation, const bool success)
+{
+    ScopedLock lock( &m_mutex );
+
+    Entry& entry = m_indices[ generation->name ];
+    entry.loading = false;
+
+    if (success == false)
+    {
+        // keep serving the previous generation, if any
+        m_retired.push_back( generation );
+    }
+    else
+    {
+        // retire the previous generation: it will be released once its clients have detached
+        if (entry.current)
+            m_retired.push_back( entry.current );
+
+        entry.current = generation;
+    }
+
+    // release the caller's reference while still holding the lock
+    generation = SharedPointer<IndexGeneration>();
+}
+
+// detach a connection from all its indices
+//
+void IndexDaemon::detach_all(Connection& connection)
+{
+    ScopedLock lock( &m_mutex );
+
+    for (uint32 i = 0; i < connection.attached.size(); ++i)
+        connection.attached[i]->clients--;
+
+    connection.attached.clear();
+}
+
+// release retired generations without clients, and join finished loaders
+//
+void IndexDaemon::collect()
+{
+    std::vector< SharedPointer<IndexGeneration> > released;
+    {
+        ScopedLock lock( &m_mutex );
+
+        for (uint32 i = 0; i < m_retired.size();)
+        {
+            if (m_retired[i]->clients == 0)
+            {
+                released.push_back( m_retired[i] );
+                m_retired.erase( m_retired.begin() + i );
+            }
+            else
+                ++i;
+        }
+    }
+
+    // release the mapped objects outside of the lock
+    for (uint32 i = 0; i < released.size(); ++i)
+        log_info(stderr, "releasing index \"%s\" (generation %u)\n", released[i]->name.c_str(), released[i]->generation);
+
+    released.clear();
+
+    for (uint32 i = 0; i < m_loaders.size();)
+    {
+        if (m_loaders[i]->done())
+        {
+            m_loaders[i]->join();
+            m_loaders.erase( m_loaders.begin() + i );
+        }
+        else
+            ++i;
+    }
+}
+
+// process a command line, returning the reply
+//
+std::string IndexDaemon::process(Connection& connection, const std::string& line)
+{
+    const std::vector<std::string> tokens = tokenize( line );
+    if (tokens.empty())
+        return "error empty command";
+
+    const std::string& cmd = tokens[0];
+
+    if ((cmd == "load" || cmd == "swap") && tokens.size() == 3)
+    {
+        std::string reply;
+        load( tokens[1], tokens[2], cmd == "swap", reply );
+        return reply;
+    }
+    else if (cmd == "unload" && tokens.size() == 2)
+    {
+        ScopedLock lock( &m_mutex );
+
+        std::map<std::string,Entry>::iterator it = m_indices.find( tokens[1] );
+        if (it == m_indices.end() || !it->second.current)
+            return "error \"" + tokens[1] + "\" is not loaded";
+        if (it->second.loading)
+            return "error \"" + tokens[1] + "\" is being loaded";
+
+        // stop accepting new clients, and release the index as soon as all the attached ones are gone;
+        // the entry itself is kept to make sure a later load won't reuse a mapped name still in use
+        SharedPointer<IndexGeneration> generation = it->second.current;
+        m_retired.push_back( generation );
+        it->second.current = SharedPointer<IndexGeneration>();
+
+        return "ok unloading \"" + tokens[1] + "\" (" + format_uint( generation->clients ) + " clients attached)";
+    }
+    else if (cmd == "attach" && tokens.size() == 2)
+    {
+        ScopedLock lock( &m_mutex );
+
+        std::map<std::string,Entry>::iterator it = m_indices.find( tokens[1] );
+        if (it == m_indices.end() || !it->second.current)
+            return "error \"" + tokens[1] + "\" is not loaded";
+
+        SharedPointer<IndexGeneration> generation = it->second.current;
+        generation->clients++;
+        connection.attached.push_back( generation );
+        return "ok " + generation->mapped_name;
+    }
+    else if (cmd == "detach" && tokens.size() == 2)
+    {
+        ScopedLock lock( &m_mutex );
+
+        for (uint32 i = 0; i < connection.attached.size(); ++i)
+        {
+            if (connection.attached[i]->name == tokens[1])
+            {
+                connection.attached[i]->clients--;
+                connection.attached.erase( connection.attached.begin() + i );
+                return "ok";
+            }
+        }
+        return "error not attached to \"" + tokens[1] + "\"";
+    }
+    else if (cmd == "list" && tokens.size() == 1)
+    {
+        ScopedLock lock( &m_mutex );
+
+        std::string reply;
+        uint64      total = 0;
+
+        for (std::map<std::string,Entry>::const_iterator it = m_indices.begin(); it != m_indices.end(); ++it)
+        {
+            const SharedPointer<IndexGeneration>& generation = it->second.current;
+            if (generation)
+            {
+                reply += LIST_ITEM + it->first +
+                    " generation="  + format_uint( generation->generation ) +
+                    " mapped="      + generation->mapped_name +
+                    " prefix="      + generation->genome_prefix +
+                    " clients="     + format_uint( generation->clients ) +
+                    " memory="      + format_mb( generation->memory_footprint() ) +
+                    (it->second.loading ? " (swapping)" : "") + "\n";
+
+                total += generation->memory_footprint();
+            }
+            else if (it->second.loading)
+                reply += LIST_ITEM + it->first + " (loading)\n";
+        }
+        for (uint32 i = 0; i < m_retired.size(); ++i)
+        {
+            reply += LIST_ITEM + m_retired[i]->name +
+                " generation="  + format_uint( m_retired[i]->generation ) +
+                " mapped="      + m_retired[i]->mapped_name +
+                " clients="     + format_uint( m_retired[i]->clients ) +
+                " memory="      + format_mb( m_retired[i]->memory_footprint() ) + " (retired)\n";
+
+            total += m_retired[i]->memory_footprint();
+        }
+        return reply + "ok total memory " + format_mb( total );
+    }
+    else if (cmd == "shutdown" && tokens.size() == 1)
+    {
+        m_shutdown = true;
+        return "ok";
+    }
+    return "error unknown command \"" + line + "\"";
+}
+
+#ifndef WIN32
+
+// run the daemon on a given control socket
+//
+int IndexDaemon::run(const char* socket_path)
+{
+    // don't die writing to clients which went away
+    signal( SIGPIPE, SIG_IGN );
+
+    sockaddr_un address;
+    memset( &address, 0, sizeof(address) );
+    address.sun_family = AF_UNIX;
+    if (strlen( socket_path ) >= sizeof(address.sun_path))
+    {
+        log_error(stderr, "control socket path too long: \"%s\"\n", socket_path);
+        return 1;
+    }
+    strcpy( address.sun_path, socket_path );
+
+    // remove any stale socket
+    unlink( socket_path );
+
+    const int listener = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if (listener == -1 ||
+        bind( listener, (const sockaddr*)&address, sizeof(address) ) != 0 ||
+        listen( listener, 16 ) != 0)
+    {
+        log_error(stderr, "could not create control socket \"%s\"\n", socket_path);
+        return 1;
+    }
+
+    log_visible(stderr, "nvFM-server listening on \"%s\"\n", socket_path);
+
+    std::vector<Connection> connections;
+
+    while (m_shutdown == false)
+    {
+        std::vector<pollfd> fds( connections.size() + 1u );
+        for (uint32 i = 0; i < connections.size(); ++i)
+        {
+            fds[i].fd     = connections[i].socket;
+            fds[i].events = POLLIN;
+        }
+        fds.back().fd     = listener;
+        fds.back().events = POLLIN;
+
+        // wake up periodically to collect finished loads
+        poll( &fds[0], fds.size(), 500 );
+
+        // serve the existing connections
+        for (int32 i = int32( connections.size() ) - 1; i >= 0; --i)
+        {
+            if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0)
+                continue;
+
+            Connection& connection = connections[i];
+
+            char buffer[4096];
+            const ssize_t n_bytes = recv( connection.socket, buffer, sizeof(buffer), 0 );
+            if (n_bytes <= 0)
+            {
+                // the client went away: detach it from everything
+                detach_all( connection );
+                close( connection.socket );
+                connections.erase( connections.begin() + i );
+                continue;
+            }
+            connection.input.append( buffer, n_bytes );
+
+            // process all complete lines
+            size_t eol;
+            while ((eol = connection.input.find( '\n' )) != std::string::npos)
+            {
+                const std::string line = connection.input.substr( 0, eol );
+                connection.input.erase( 0, eol + 1 );
+
+                const std::string reply = process( connection, line ) + "\n";
+                send( connection.socket, reply.c_str(), reply.length(), 0 );
+            }
+        }
+
+        // accept new connections
+        if (fds.back().revents & POLLIN)
+        {
+            const int client = accept( listener, NULL, NULL );
+            if (client != -1)
+            {
+                connections.push_back( Connection() );
+                connections.back().socket = client;
+            }
+        }
+
+        collect();
+    }
+
+    log_visible(stderr, "nvFM-server shutting down\n");
+
+    for (uint32 i = 0; i < connections.size(); ++i)
+    {
+        detach_all( connections[i] );
+        close( connections[i].socket );
+    }
+    close( listener );
+    unlink( socket_path );
+
+    // wait for all pending loads
+    for (uint32 i = 0; i < m_loaders.size(); ++i)
+        m_loaders[i]->join();
+
+    m_loaders.clear();
+    return 0;
+}
+
+#else
+
+int IndexDaemon::run(const char* socket_path)
+{
+    log_error(stderr, "daemon mode is not supported on this platform\n");
+    return 1;
+}
+
+#endif
+
+} // namespace nvbio
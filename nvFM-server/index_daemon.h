@@ -0,0 +1,128 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/io/fmindex/fmindex.h>
+#include <nvbio/io/sequence/sequence_mmap.h>
+#include <nvbio/basic/mmap.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/basic/shared_pointer.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace nvbio {
+
+struct IndexLoader;
+
+///
+/// A loaded version of a named index, i.e. its reference and FM-index mapped objects
+///
+struct IndexGeneration
+{
+    IndexGeneration() : generation( 0 ), clients( 0 ) {}
+
+    /// return the total amount of shared memory used by this generation
+    ///
+    uint64 memory_footprint() const { return reference.memory_footprint() + fmindex.memory_footprint(); }
+
+    std::string                 name;               ///< the index name
+    std::string                 mapped_name;        ///< the name of the memory mapped objects
+    std::string                 genome_prefix;      ///< the genome prefix this generation was loaded from
+    uint32                      generation;         ///< the generation number
+    uint32                      clients;            ///< the number of attached clients
+    io::SequenceDataMMAPServer  reference;          ///< the mapped reference
+    io::FMIndexDataMMAPServer   fmindex;            ///< the mapped FM-index
+};
+
+///
+/// A daemon serving several named indices at once through a local control socket.
+/// Indices can be loaded, swapped and unloaded at any time: loads happen on a background
+/// thread, and a swapped or unloaded generation is released only once all of its clients
+/// have detached.
+/// See io::IndexServerClient for a description of the protocol.
+///
+struct IndexDaemon
+{
+    /// constructor
+    ///
+    IndexDaemon(const MappingOptions& options) : m_options( options ), m_shutdown( false ) {}
+
+    /// start loading a named index in the background
+    ///
+    /// \param name             the index name
+    /// \param genome_prefix    the genome prefix to load
+    /// \param swap             whether to replace an existing index
+    /// \param reply            the reply message
+    bool load(const std::string& name, const std::string& genome_prefix, const bool swap, std::string& reply);
+
+    /// run the daemon on a given control socket until a shutdown command is received
+    ///
+    int run(const char* socket_path);
+
+    /// publish a loaded generation; called by the loader threads, which hand over
+    /// their reference: it is released under the daemon's lock, and reset on return
+    ///
+    void publish(SharedPointer<IndexGeneration>& generation, const bool success);
+
+private:
+    struct Connection
+    {
+        int                                             socket;
+        std::string                                     input;
+        std::vector< SharedPointer<IndexGeneration> >   attached;
+    };
+
+    struct Entry
+    {
+        Entry() : last_generation( 0 ), loading( false ) {}
+
+        uint32                          last_generation;
+        bool                            loading;
+        SharedPointer<IndexGeneration>  current;
+    };
+
+    // process a command line, returning the reply
+    std::string process(Connection& connection, const std::string& line);
+
+    // detach a connection from all its indices
+    void detach_all(Connection& connection);
+
+    // release retired generations without clients, and join finished loaders
+    void collect();
+
+    MappingOptions                                  m_options;
+    Mutex                                           m_mutex;
+    std::map<std::string,Entry>                     m_indices;
+    std::vector< SharedPointer<IndexGeneration> >   m_retired;
+    std::vector< SharedPointer<IndexLoader> >       m_loaders;
+    bool                                            m_shutdown;
+};
+
+} // namespace nvbio
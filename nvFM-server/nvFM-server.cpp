@@ -31,6 +31,7 @@
 #include <nvbio/io/fmindex/fmindex.h>
 #include <nvbio/io/sequence/sequence_mmap.h>
 #include <nvbio/basic/mmap.h>
+#include "index_daemon.h"
 #include <string.h>
 #include <string>
 
@@ -40,22 +41,96 @@ int main(int argc, char* argv[])
 {
     if (argc == 1)
     {
-        fprintf(stderr, "nvFM-server genome-prefix mapped-name\n");
+        fprintf(stderr, "nvFM-server [options] genome-prefix mapped-name\n");
+        fprintf(stderr, "nvFM-server [options] -daemon socket-path [name=genome-prefix ...]\n");
+        fprintf(stderr, "options:\n");
+        fprintf(stderr, "  -huge-pages 2M|1G           back the mapped objects with huge pages\n");
+        fprintf(stderr, "  -hugetlbfs  path            the hugetlbfs mount point to use\n");
+        fprintf(stderr, "  -numa interleave|replicate  interleave the mapped objects across NUMA nodes,\n");
+        fprintf(stderr, "                              or replicate them on each node\n");
+        exit(1);
+    }
+
+    MappingOptions mapping_options;
+    const char*    daemon_socket = NULL;
+
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; ++arg)
+    {
+        if (strcmp( argv[arg], "-huge-pages" ) == 0 && arg+1 < argc)
+        {
+            ++arg;
+            if (strcmp( argv[arg], "2M" ) == 0)
+                mapping_options.page_size = MappingOptions::HUGE_PAGES_2MB;
+            else if (strcmp( argv[arg], "1G" ) == 0)
+                mapping_options.page_size = MappingOptions::HUGE_PAGES_1GB;
+            else
+            {
+                fprintf(stderr, "invalid -huge-pages value \"%s\", expected 2M or 1G\n", argv[arg]);
+                exit(1);
+            }
+        }
+        else if (strcmp( argv[arg], "-daemon" ) == 0 && arg+1 < argc)
+            daemon_socket = argv[++arg];
+        else if (strcmp( argv[arg], "-hugetlbfs" ) == 0 && arg+1 < argc)
+            mapping_options.hugetlbfs_path = argv[++arg];
+        else if (strcmp( argv[arg], "-numa" ) == 0 && arg+1 < argc)
+        {
+            ++arg;
+            if (strcmp( argv[arg], "interleave" ) == 0)
+                mapping_options.numa_policy = MappingOptions::NUMA_INTERLEAVE;
+            else if (strcmp( argv[arg], "replicate" ) == 0)
+                mapping_options.numa_policy = MappingOptions::NUMA_REPLICATE;
+            else
+            {
+                fprintf(stderr, "invalid -numa value \"%s\", expected interleave or replicate\n", argv[arg]);
+                exit(1);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "unknown option \"%s\"\n", argv[arg]);
+            exit(1);
+        }
+    }
+
+    if (daemon_socket)
+    {
+        IndexDaemon daemon( mapping_options );
+
+        // start loading all the indices specified on the command line
+        for (; arg < argc; ++arg)
+        {
+            const char* separator = strchr( argv[arg], '=' );
+            const std::string name   = separator ? std::string( argv[arg], separator - argv[arg] ) : std::string( argv[arg] );
+            const std::string prefix = separator ? std::string( separator + 1 )       : std::string( argv[arg] );
+
+            std::string reply;
+            if (daemon.load( name, prefix, false, reply ) == false)
+                fprintf(stderr, "%s\n", reply.c_str());
+        }
+        return daemon.run( daemon_socket );
+    }
+
+    if (arg >= argc)
+    {
+        fprintf(stderr, "nvFM-server [options] genome-prefix mapped-name\n");
         exit(1);
     }
 
     fprintf(stderr, "nvFM-server started\n");
 
-    const char* file_name = argv[1];
-    const char* mapped_name = argc == 3 ? argv[2] : argv[1];
+    const char* file_name   = argv[arg];
+    const char* mapped_name = arg+1 < argc ? argv[arg+1] : argv[arg];
 
     io::SequenceDataMMAPServer reference_driver;
+    reference_driver.set_mapping_options( mapping_options );
     reference_driver.load( DNA, file_name, mapped_name );
 
     io::FMIndexDataMMAPServer fmindex_driver;
+    fmindex_driver.set_mapping_options( mapping_options );
     fmindex_driver.load( file_name, mapped_name );
 
     getc(stdin);
     return 0;
 }
-
@@ -73,6 +73,7 @@ struct BloomFilters
 
     void get_kmers(const KmersType type, nvbio::vector<nvbio::host_tag,uint32>& bf);
     void set_kmers(const KmersType type, const nvbio::vector<nvbio::host_tag,uint32>& bf);
+    void set_kmers(const KmersType type, const uint64 n_words, const uint32* bf);
     void set_threshold(const nvbio::vector<nvbio::host_tag,uint32>& _threshold);
 
     void set_device() const;
@@ -104,6 +105,17 @@ void merged_stats(
     const BloomFilters<nvbio::device_tag>*  d_bloom_filters,
     nvbio::vector<nvbio::host_tag,uint64>&  stats);
 
+/// compute Bloom filter usage statistics
+///
+template <typename system_tag>
+void compute_bloom_filter_stats(
+    const uint64                    n_words,
+    const uint32*                   words,
+    const uint32                    K,
+    float&                          occupancy,
+    float&                          approx_size,
+    float&                          fp);
+
 /// compute Bloom filter usage statistics
 ///
 template <typename system_tag>
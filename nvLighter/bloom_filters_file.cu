@@ -0,0 +1,238 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// bloom_filters_file.cu
+//
+
+#include "bloom_filters_file.h"
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/numbers.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+using namespace nvbio;
+
+namespace {
+
+// the fixed key used to fingerprint the hash functions
+const uint64 HASH_CHECK_KEY = 0x0123456789ABCDEFull;
+
+// round an offset up to the filter section alignment
+//
+uint64 align_offset(const uint64 offset)
+{
+    return ((offset + BLOOM_FILTERS_FILE_ALIGNMENT - 1u) / BLOOM_FILTERS_FILE_ALIGNMENT) * BLOOM_FILTERS_FILE_ALIGNMENT;
+}
+
+// write a filter section, padding the file up to its offset
+//
+bool write_section(FILE* file, const uint64 offset, const uint32* words, const uint64 n_words)
+{
+    const char zeros[1024] = { 0 };
+
+    uint64 pos = uint64( ftell( file ) );
+    while (pos < offset)
+    {
+        const uint64 n = nvbio::min( offset - pos, uint64( sizeof(zeros) ) );
+        if (fwrite( zeros, 1u, size_t(n), file ) != size_t(n))
+            return false;
+
+        pos += n;
+    }
+
+    // write in chunks of at most 256MB, as some platforms don't like larger writes
+    const uint64 CHUNK_WORDS = 64u*1024u*1024u;
+    for (uint64 i = 0; i < n_words; i += CHUNK_WORDS)
+    {
+        const uint64 n = nvbio::min( n_words - i, CHUNK_WORDS );
+        if (fwrite( words + i, sizeof(uint32), size_t(n), file ) != size_t(n))
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+// build a header for the current build's hash functions and filter parameters
+//
+BloomFiltersFileHeader make_bloom_filters_header(
+    const BloomFiltersStage stage,
+    const uint32            k,
+    const uint64            genome_size,
+    const float             alpha,
+    const uint64            sampled_words,
+    const uint64            trusted_words,
+    const uint32*           threshold)
+{
+    BloomFiltersFileHeader header;
+    memset( &header, 0, sizeof(header) );
+
+    header.magic            = BLOOM_FILTERS_FILE_MAGIC;
+    header.version          = BLOOM_FILTERS_FILE_VERSION;
+    header.stage            = stage;
+    header.k                = k;
+    header.sampled_hashes   = SAMPLED_KMERS_FILTER_K;
+    header.trusted_hashes   = TRUSTED_KMERS_FILTER_K;
+    header.hash_check[0]    = hash_functor1()( HASH_CHECK_KEY );
+    header.hash_check[1]    = hash_functor2()( HASH_CHECK_KEY );
+    header.genome_size      = genome_size;
+    header.alpha            = alpha;
+    header.sampled_words    = sampled_words;
+    header.trusted_words    = stage == TRUSTED_KMERS_STAGE ? trusted_words : 0u;
+    header.sampled_offset   = align_offset( sizeof(BloomFiltersFileHeader) );
+    header.trusted_offset   = align_offset( header.sampled_offset + header.sampled_words * sizeof(uint32) );
+
+    if (stage == TRUSTED_KMERS_STAGE && threshold != NULL)
+    {
+        for (uint32 i = 0; i < BLOOM_FILTERS_THRESHOLDS; ++i)
+            header.threshold[i] = threshold[i];
+    }
+    return header;
+}
+
+// save a set of Bloom filters to a file
+//
+bool save_bloom_filters(
+    const char*                     file_name,
+    const BloomFiltersFileHeader&   header,
+    const uint32*                   sampled_kmers,
+    const uint32*                   trusted_kmers)
+{
+    // write to a temporary file first, so as to never leave a truncated file behind
+    // in place of a valid one
+    std::string temp_name = std::string( file_name ) + ".tmp";
+
+    FILE* file = fopen( temp_name.c_str(), "wb" );
+    if (file == NULL)
+    {
+        log_error(stderr, "  unable to open \"%s\" for writing\n", temp_name.c_str());
+        return false;
+    }
+
+    bool ok = fwrite( &header, sizeof(header), 1u, file ) == 1u;
+
+    ok = ok && write_section( file, header.sampled_offset, sampled_kmers, header.sampled_words );
+
+    if (header.stage == TRUSTED_KMERS_STAGE)
+        ok = ok && write_section( file, header.trusted_offset, trusted_kmers, header.trusted_words );
+
+    ok = (fclose( file ) == 0) && ok;
+
+    if (ok == false)
+    {
+        log_error(stderr, "  failed writing \"%s\"\n", temp_name.c_str());
+        remove( temp_name.c_str() );
+        return false;
+    }
+
+    // replace any previous file
+    remove( file_name );
+    if (rename( temp_name.c_str(), file_name ) != 0)
+    {
+        log_error(stderr, "  unable to rename \"%s\" to \"%s\"\n", temp_name.c_str(), file_name);
+        return false;
+    }
+    return true;
+}
+
+// map a Bloom filters file and validate it against the current build
+//
+bool MappedBloomFilters::attach(const char* file_name)
+{
+    const uint8* data = (const uint8*)m_file.init( file_name );
+    if (data == NULL)
+    {
+        log_error(stderr, "  unable to map \"%s\"\n", file_name);
+        return false;
+    }
+
+    const uint64 file_size = m_file.size();
+    if (file_size < sizeof(BloomFiltersFileHeader))
+    {
+        log_error(stderr, "  \"%s\" is not a Bloom filters file\n", file_name);
+        return false;
+    }
+
+    memcpy( &m_header, data, sizeof(BloomFiltersFileHeader) );
+
+    if (m_header.magic != BLOOM_FILTERS_FILE_MAGIC)
+    {
+        log_error(stderr, "  \"%s\" is not a Bloom filters file\n", file_name);
+        return false;
+    }
+    if (m_header.version != BLOOM_FILTERS_FILE_VERSION)
+    {
+        log_error(stderr, "  \"%s\": unsupported version %u\n", file_name, m_header.version);
+        return false;
+    }
+    if (m_header.stage != SAMPLED_KMERS_STAGE &&
+        m_header.stage != TRUSTED_KMERS_STAGE)
+    {
+        log_error(stderr, "  \"%s\": invalid stage %u\n", file_name, m_header.stage);
+        return false;
+    }
+
+    // the filters can only be reused with the very same hash functions
+    if (m_header.sampled_hashes != SAMPLED_KMERS_FILTER_K ||
+        m_header.trusted_hashes != TRUSTED_KMERS_FILTER_K ||
+        m_header.hash_check[0]  != hash_functor1()( HASH_CHECK_KEY ) ||
+        m_header.hash_check[1]  != hash_functor2()( HASH_CHECK_KEY ))
+    {
+        log_error(stderr, "  \"%s\": built with incompatible hash functions\n", file_name);
+        return false;
+    }
+
+    // kmers are packed in 64-bit codes
+    if (m_header.k == 0u || m_header.k > 32u)
+    {
+        log_error(stderr, "  \"%s\": invalid kmer length %u\n", file_name, m_header.k);
+        return false;
+    }
+
+    // the blocked filters are accessed by 128-bit blocks
+    if ((m_header.sampled_words & 3u) || (m_header.trusted_words & 3u) ||
+        (m_header.sampled_offset % BLOOM_FILTERS_FILE_ALIGNMENT) ||
+        (m_header.trusted_offset % BLOOM_FILTERS_FILE_ALIGNMENT))
+    {
+        log_error(stderr, "  \"%s\": misaligned filters\n", file_name);
+        return false;
+    }
+
+    if (m_header.sampled_offset + m_header.sampled_words * sizeof(uint32) > file_size ||
+        (m_header.stage == TRUSTED_KMERS_STAGE &&
+         m_header.trusted_offset + m_header.trusted_words * sizeof(uint32) > file_size))
+    {
+        log_error(stderr, "  \"%s\" is truncated\n", file_name);
+        return false;
+    }
+
+    m_sampled_kmers = (const uint32*)( data + m_header.sampled_offset );
+    m_trusted_kmers = m_header.stage == TRUSTED_KMERS_STAGE ? (const uint32*)( data + m_header.trusted_offset ) : NULL;
+    return true;
+}
@@ -0,0 +1,149 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// bloom_filters_file.h
+//
+
+#pragma once
+
+#include "utils.h"
+#include <nvbio/basic/mmap.h>
+
+///@addtogroup nvLighterModule
+///@{
+
+static const uint32 BLOOM_FILTERS_FILE_MAGIC   = 0x424C564Eu;    // "NVLB"
+static const uint32 BLOOM_FILTERS_FILE_VERSION = 1u;
+
+/// the alignment of the filter sections within a Bloom filters file, chosen so
+/// that a mapped filter starts on a page boundary
+///
+static const uint64 BLOOM_FILTERS_FILE_ALIGNMENT = 4096u;
+
+/// the number of entries of the trusted kmer threshold table
+///
+static const uint32 BLOOM_FILTERS_THRESHOLDS = 100u;
+
+/// The nvLighter pass after which a Bloom filters file has been saved
+///
+enum BloomFiltersStage
+{
+    SAMPLED_KMERS_STAGE = 1,   ///< only the sampled kmers filter is available
+    TRUSTED_KMERS_STAGE = 2,   ///< both filters and the thresholds are available, the run can skip to error correction
+};
+
+/// The header of a Bloom filters file, followed by the sampled and trusted kmer filters.
+/// Besides the filter geometry, it records all the parameters that must match for the filters
+/// to be reused: the kmer length, the number of hashes of each filter, a fingerprint of the
+/// hash functions, and the trusted kmer thresholds derived from the sampling pass.
+///
+struct BloomFiltersFileHeader
+{
+    uint32  magic;                  ///< BLOOM_FILTERS_FILE_MAGIC
+    uint32  version;                ///< BLOOM_FILTERS_FILE_VERSION
+    uint32  stage;                  ///< the BloomFiltersStage the file has been saved at
+    uint32  k;                      ///< kmer length
+    uint32  sampled_hashes;         ///< number of hash functions of the sampled kmers filter
+    uint32  trusted_hashes;         ///< number of hash functions of the trusted kmers filter
+    uint64  hash_check[2];          ///< the two hash functions applied to a fixed key
+    uint64  genome_size;            ///< the genome size the filters have been sized for
+    float   alpha;                  ///< the kmer sampling frequency
+    uint32  reserved;
+    uint64  sampled_words;          ///< size of the sampled kmers filter, in 32-bit words
+    uint64  trusted_words;          ///< size of the trusted kmers filter, in 32-bit words
+    uint64  sampled_offset;         ///< file offset of the sampled kmers filter
+    uint64  trusted_offset;         ///< file offset of the trusted kmers filter
+    uint32  threshold[BLOOM_FILTERS_THRESHOLDS];  ///< the trusted kmer thresholds
+};
+
+/// build a header for the current build's hash functions and filter parameters
+///
+BloomFiltersFileHeader make_bloom_filters_header(
+    const BloomFiltersStage stage,
+    const uint32            k,
+    const uint64            genome_size,
+    const float             alpha,
+    const uint64            sampled_words,
+    const uint64            trusted_words,
+    const uint32*           threshold);
+
+/// save a set of Bloom filters to a file; the filter sizes and offsets are taken from the header,
+/// and the trusted kmers filter is only written at TRUSTED_KMERS_STAGE
+///
+/// \param file_name        the output file name
+/// \param header           the file header, as returned by make_bloom_filters_header()
+/// \param sampled_kmers    the sampled kmers filter
+/// \param trusted_kmers    the trusted kmers filter
+///
+bool save_bloom_filters(
+    const char*                     file_name,
+    const BloomFiltersFileHeader&   header,
+    const uint32*                   sampled_kmers,
+    const uint32*                   trusted_kmers);
+
+///
+/// A Bloom filters file attached through a read-only memory mapping, so that
+/// the filters are paged in on demand rather than rebuilt or copied
+///
+struct MappedBloomFilters
+{
+    /// constructor
+    ///
+    MappedBloomFilters() : m_sampled_kmers( NULL ), m_trusted_kmers( NULL ) {}
+
+    /// map a Bloom filters file and validate it against the current build
+    ///
+    /// \param file_name    the file name
+    /// \return             true on success
+    ///
+    bool attach(const char* file_name);
+
+    /// return the file header
+    ///
+    const BloomFiltersFileHeader& header() const { return m_header; }
+
+    /// return the stage the file has been saved at
+    ///
+    BloomFiltersStage stage() const { return BloomFiltersStage( m_header.stage ); }
+
+    /// return the mapped sampled kmers filter
+    ///
+    const uint32* sampled_kmers() const { return m_sampled_kmers; }
+
+    /// return the mapped trusted kmers filter, or NULL if not available
+    ///
+    const uint32* trusted_kmers() const { return m_trusted_kmers; }
+
+private:
+    nvbio::MappedDiskFile   m_file;
+    BloomFiltersFileHeader  m_header;
+    const uint32*           m_sampled_kmers;
+    const uint32*           m_trusted_kmers;
+};
+
+///@}  // group nvLighterModule
@@ -93,6 +93,15 @@ void BloomFilters<system_tag>::set_kmers(const KmersType type, const nvbio::vect
     else                       trusted_kmers_storage = bf;
 }
 template <typename system_tag>
+void BloomFilters<system_tag>::set_kmers(const KmersType type, const uint64 n_words, const uint32* bf)
+{
+    set_device();
+
+    nvbio::vector<system_tag,uint32>& storage = get_kmers( type );
+    storage.resize( n_words );
+    thrust::copy( bf, bf + n_words, storage.begin() );
+}
+template <typename system_tag>
 void BloomFilters<system_tag>::set_threshold(const nvbio::vector<nvbio::host_tag,uint32>& _threshold)
 {
     set_device();
@@ -230,8 +239,8 @@ struct block_occupancy_functor
 //
 template <typename system_tag>
 void compute_bloom_filter_stats(
-    const BloomFilters<system_tag>& bloom_filters,
-    const KmersType                 type,
+    const uint64                    n_words,
+    const uint32*                   words,
     const uint32                    K,
     float&                          occupancy,
     float&                          approx_size,
@@ -240,20 +249,13 @@ void compute_bloom_filter_stats(
     typedef typename nvbio::if_equal<system_tag,nvbio::device_tag,thrust::device_ptr<const uint32>, const uint32*>::type uint_pointer_type;
     typedef typename nvbio::if_equal<system_tag,nvbio::device_tag,thrust::device_ptr<const uint4>,  const uint4*>::type  uint4_pointer_type;
 
-    bloom_filters.set_device();
-
-    const nvbio::vector<system_tag,uint32>& bf = bloom_filters.get_kmers( type );
-
-    const uint32  n_words = uint32( bf.size() );
-    const uint32* words   = raw_pointer( bf );
-
     // compute the number of bits set
     nvbio::vector<system_tag,uint8> temp_storage;
 
     const uint64 bits_per_word = 32;
 
     const uint64 bits_set = nvbio::reduce(
-        n_words,
+        uint32( n_words ),
         thrust::make_transform_iterator(
             thrust::make_transform_iterator(
                 uint_pointer_type( words ), nvbio::popc_functor<uint32>() ),
@@ -270,7 +272,7 @@ void compute_bloom_filter_stats(
   #else
     // compute the actual false positive rate - using the block-occupancy
     fp = float( nvbio::reduce(
-        n_words / 4,
+        uint32( n_words / 4 ),
         thrust::make_transform_iterator(
             uint4_pointer_type( (const uint4*)words ),
             block_occupancy_functor( K ) ),
@@ -278,3 +280,27 @@ void compute_bloom_filter_stats(
         temp_storage ) / double(n_words / 4) );
   #endif
 }
+
+// compute Bloom filter usage statistics
+//
+template <typename system_tag>
+void compute_bloom_filter_stats(
+    const BloomFilters<system_tag>& bloom_filters,
+    const KmersType                 type,
+    const uint32                    K,
+    float&                          occupancy,
+    float&                          approx_size,
+    float&                          fp)
+{
+    bloom_filters.set_device();
+
+    const nvbio::vector<system_tag,uint32>& bf = bloom_filters.get_kmers( type );
+
+    compute_bloom_filter_stats<system_tag>(
+        bf.size(),
+        raw_pointer( bf ),
+        K,
+        occupancy,
+        approx_size,
+        fp );
+}
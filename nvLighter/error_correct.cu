@@ -94,6 +94,13 @@ struct ErrorCorrectFunctor
     NVBIO_HOST_DEVICE
     void mark_solid_kmers(const int read_len, const string_type& read, bool* solid) const
     {
+      #if defined(__CUDA_ARCH__)
+        KmerMarker<trusted_filter_type,bool*> marker( trusted_kmers, solid );
+      #else
+        // on the host, look up the kmers in prefetched batches
+        BatchedKmerMarker<trusted_filter_type,bool*> marker( trusted_kmers, solid );
+      #endif
+
         KmerCode kmer( K );
         for (int i = 0; i < K-1; ++i)
             kmer.push_back( read[i] );
@@ -102,8 +109,11 @@ struct ErrorCorrectFunctor
         {
             kmer.push_back( read[i] );
 
-            solid[ i - K + 1 ] = is_trusted( kmer );
+            solid[ i - K + 1 ] = false;
+            if (kmer.is_valid())
+                marker.query( kmer.code, uint32( i - K + 1 ) );
         }
+        marker.flush();
     }
 
     /// find the longest stored kmer
@@ -767,9 +777,11 @@ bool ErrorCorrectStage::process(PipelineContext& context)
 
     // declare the Bloom filter types
     typedef nvbio::blocked_bloom_filter<hash_functor1, hash_functor2, nvbio::cuda::ldg_pointer<uint4> > trusted_filter_type;
+    typedef nvbio::blocked_bloom_filter<hash_functor1, hash_functor2, const uint4*>                     host_trusted_filter_type;
 
-    // declare the error corrector functor
-    typedef ErrorCorrectFunctor<string_set_type,qual_set_type,trusted_filter_type> functor_type;
+    // declare the error corrector functors
+    typedef ErrorCorrectFunctor<string_set_type,qual_set_type,trusted_filter_type>      functor_type;
+    typedef ErrorCorrectFunctor<string_set_type,qual_set_type,host_trusted_filter_type> host_functor_type;
 
     log_debug(stderr, "  error correction... started\n" );
 
@@ -839,11 +851,11 @@ bool ErrorCorrectStage::process(PipelineContext& context)
             // build an editable view
             nvbio::io::SequenceDataEdit<DNA_N,nvbio::io::SequenceDataView> h_read_edit( h_read_view );
 
-            // build the Bloom filter
-            trusted_filter_type trusted_filter( TRUSTED_KMERS_FILTER_K, trusted_filter_size, (const uint4*)trusted_filter_storage );
+            // build the Bloom filter, using plain pointers so that its blocks can be prefetched
+            host_trusted_filter_type trusted_filter( TRUSTED_KMERS_FILTER_K, trusted_filter_size, (const uint4*)trusted_filter_storage );
 
             // build the kmer sampling functor
-            const functor_type error_corrector(
+            const host_functor_type error_corrector(
                 k,
                 h_read_edit.sequence_string_set(),
                 h_read_edit.qual_string_set(),
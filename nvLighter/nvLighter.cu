@@ -35,6 +35,7 @@
 #include <nvbio/basic/omp.h>
 
 #include "bloom_filters.h"
+#include "bloom_filters_file.h"
 #include "input_thread.h"
 #include "output_thread.h"
 #include "sample_kmers.h"
@@ -133,6 +134,22 @@ char get_bad_quality(nvbio::io::SequenceDataStream* reads_file)
     return (char)nvbio::min( t1, t2 );
 }
 
+// fetch a merged Bloom filter on the host, copying it from the first device if
+// it's not available in host memory
+//
+const uint32* fetch_kmers(
+    BloomFilters<host_tag>*         h_bloom_filters,
+    BloomFilters<device_tag>*       d_bloom_filters,
+    const KmersType                 type,
+    nvbio::vector<host_tag,uint32>& temp)
+{
+    if (h_bloom_filters)
+        return raw_pointer( h_bloom_filters->get_kmers( type ) );
+
+    d_bloom_filters[0].get_kmers( type, temp );
+    return raw_pointer( temp );
+}
+
 float infer_alpha(nvbio::io::SequenceDataStream* reads_file, const uint64 genome_size)
 {
     log_info(stderr, "  inferring alpha... started\n" );
@@ -204,6 +221,8 @@ int main(int argc, char* argv[])
         log_info(stderr, "   -newQual   int       [disabled]         # new quality score value\n");
         log_info(stderr, "   -no-cpu                                 # disable CPU usage\n");
         log_info(stderr, "   -no-gpu                                 # disable GPU usage\n");
+        log_info(stderr, "   -save-filters  string                   # save the kmer Bloom filters to a file\n");
+        log_info(stderr, "   -load-filters  string                   # attach to previously saved kmer Bloom filters\n");
         return 0;
     }
 
@@ -213,6 +232,7 @@ int main(int argc, char* argv[])
     io::QualityEncoding qencoding = io::Phred;
     int   threads                 = 0;
     uint32 k                      = 11u;
+    bool   k_specified            = false;
     uint64 genome_size            = 0;
     float  alpha                  = 0.0;
     float  max_correction         = 4.0f;
@@ -220,6 +240,8 @@ int main(int argc, char* argv[])
     float  bf_factor              = 1.0f; // original: 1.5
     bool   cpu                    = true;
     bool   gpu                    = true;
+    const char* save_filters_name = NULL;
+    const char* load_filters_name = NULL;
 
     std::vector<int> devices(0);
 
@@ -260,12 +282,14 @@ int main(int argc, char* argv[])
             k           = atoi( argv[++i] );
             genome_size = atol( argv[++i] );
             alpha       = atof( argv[++i] );
+            k_specified = true;
         }
         else if (strcmp( argv[i], "-K" )              == 0)  // setup kmer length, genome size and sampling frequency
         {
             k           = atoi( argv[++i] );
             genome_size = atol( argv[++i] );
             alpha       = 0.0f;
+            k_specified = true;
         }
         else if (strcmp( argv[i], "-maxcor" )         == 0)  // setup max correction factor
             max_correction = (float)atoi( argv[++i] );
@@ -273,6 +297,12 @@ int main(int argc, char* argv[])
             new_quality = argv[++i][0];
         else if (strcmp( argv[i], "-bf" )             == 0)  // Bloom filter expansion factor
             bf_factor = atof( argv[++i] );
+        else if ((strcmp( argv[i], "-save-filters" )  == 0) ||  // save the Bloom filters
+                 (strcmp( argv[i], "--save-filters" ) == 0))
+            save_filters_name = argv[++i];
+        else if ((strcmp( argv[i], "-load-filters" )  == 0) ||  // load the Bloom filters
+                 (strcmp( argv[i], "--load-filters" ) == 0))
+            load_filters_name = argv[++i];
     }
 
     // if no devices were specified, and the gpu is enabled, pick GPU 0
@@ -281,6 +311,41 @@ int main(int argc, char* argv[])
 
     uint32 device_count = uint32( devices.size() );
 
+    // attach to the saved Bloom filters, taking the parameters they have been built with
+    MappedBloomFilters mapped_filters;
+    bool skip_sampling = false;
+    bool skip_marking  = false;
+
+    if (load_filters_name)
+    {
+        log_info(stderr, "  attaching Bloom filters \"%s\"... started\n", load_filters_name);
+        if (mapped_filters.attach( load_filters_name ) == false)
+            return 1;
+
+        // the hash functions have been validated by attach(), while the kmer length can
+        // only be checked against an explicit request
+        const BloomFiltersFileHeader& header = mapped_filters.header();
+        if (k_specified && k != header.k)
+        {
+            log_error(stderr, "  the saved Bloom filters use %u-mers, %u-mers were requested\n", header.k, k);
+            return 1;
+        }
+        if (k_specified && genome_size != header.genome_size)
+            log_warning(stderr, "  the saved Bloom filters were sized for a genome of %llu bps, using it instead of %llu\n", header.genome_size, genome_size);
+
+        k           = header.k;
+        genome_size = header.genome_size;
+        alpha       = header.alpha;
+
+        skip_sampling = true;
+        skip_marking  = mapped_filters.stage() == TRUSTED_KMERS_STAGE;
+
+        log_info(stderr, "  attaching Bloom filters \"%s\"... done\n", load_filters_name);
+        log_verbose(stderr, "    k = %u, genome size = %llu, alpha = %f, %s\n",
+            k, genome_size, alpha,
+            skip_marking ? "sampled and trusted kmers" : "sampled kmers");
+    }
+
     // check whether the genome size has been specified
     if (genome_size == 0u)
     {
@@ -302,9 +367,13 @@ int main(int argc, char* argv[])
         log_verbose(stderr, "  optimal m(0.0005f) = %.2f\n", trusted_kmers_bf_factor );
         log_verbose(stderr, "  optimal k(0.0005f) = %u\n", optimal_bloom_filter_hashes( trusted_kmers_bf_factor ) );
 
-        // compute the Bloom filter sizes, in words
-        const uint64 sampled_kmers_bf_words = align<8u>( uint64( float(genome_size) * bf_factor * (sampled_kmers_bf_factor / 32.0f) ) );
-        const uint64 trusted_kmers_bf_words = align<8u>( uint64( float(genome_size) * bf_factor * (trusted_kmers_bf_factor / 32.0f) ) );
+        // compute the Bloom filter sizes, in words, unless they have been loaded
+        const uint64 sampled_kmers_bf_words = skip_sampling ?
+            mapped_filters.header().sampled_words :
+            align<8u>( uint64( float(genome_size) * bf_factor * (sampled_kmers_bf_factor / 32.0f) ) );
+        const uint64 trusted_kmers_bf_words = skip_marking ?
+            mapped_filters.header().trusted_words :
+            align<8u>( uint64( float(genome_size) * bf_factor * (trusted_kmers_bf_factor / 32.0f) ) );
 
         const uint32 bits_per_word = 32u;
 
@@ -339,9 +408,25 @@ int main(int argc, char* argv[])
             }
         }
 
-        if (cpu && h_bloom_filters.setup( -1, sampled_kmers_bf_words, trusted_kmers_bf_words ) == false)
+        // the host reads the loaded filters straight from the mapped file
+        if (cpu && h_bloom_filters.setup(
+                -1,
+                skip_sampling ? 0u : sampled_kmers_bf_words,
+                skip_marking  ? 0u : trusted_kmers_bf_words ) == false)
             cpu = false;
 
+        // while the devices get a copy
+        for (uint32 i = 0; i < device_count; ++i)
+        {
+            if (skip_sampling)
+                d_bloom_filters[i].set_kmers( SAMPLED_KMERS, sampled_kmers_bf_words, mapped_filters.sampled_kmers() );
+            if (skip_marking)
+                d_bloom_filters[i].set_kmers( TRUSTED_KMERS, trusted_kmers_bf_words, mapped_filters.trusted_kmers() );
+        }
+
+        const uint32* h_sampled_kmers = skip_sampling ? mapped_filters.sampled_kmers() : raw_pointer( h_bloom_filters.sampled_kmers_storage );
+        const uint32* h_trusted_kmers = skip_marking  ? mapped_filters.trusted_kmers() : raw_pointer( h_bloom_filters.trusted_kmers_storage );
+
         if (cpu == false)
         {
             h_bloom_filters_ptr = NULL;
@@ -412,6 +497,9 @@ int main(int argc, char* argv[])
         log_info(stderr, "  bad quality threshold: '%c'\n", bad_quality);
         
         log_info(stderr,"  sample kmers... started\n");
+        if (skip_sampling)
+            log_info(stderr,"  using the sampled kmers from \"%s\"\n", load_filters_name);
+        else
         {
             //
             // The following code implements a parallel nvbio::Pipeline to sample kmers from the input
@@ -480,10 +568,31 @@ int main(int argc, char* argv[])
 
             log_verbose(stderr,"  total time  : %.1fs\n", time);
             log_verbose(stderr,"  peak memory : %.1f GB\n", float( peak_resident_memory() ) / float(1024*1024*1024));
+
+            // save the sampled kmers, so that a later run can resume from here
+            if (save_filters_name)
+            {
+                log_info(stderr,"  saving sampled kmers to \"%s\"\n", save_filters_name);
+
+                nvbio::vector<host_tag,uint32> temp;
+                const BloomFiltersFileHeader header = make_bloom_filters_header(
+                    SAMPLED_KMERS_STAGE, k, genome_size, alpha,
+                    sampled_kmers_bf_words, 0u, NULL );
+
+                if (save_bloom_filters(
+                    save_filters_name,
+                    header,
+                    fetch_kmers( h_bloom_filters_ptr, d_bloom_filters, SAMPLED_KMERS, temp ),
+                    NULL ) == false)
+                    return 1;
+            }
         }
         log_info(stderr,"  sample kmers... done\n");
 
         log_info(stderr,"  mark trusted kmers... started\n");
+        if (skip_marking)
+            log_info(stderr,"  using the trusted kmers from \"%s\"\n", load_filters_name);
+        else
         {
             //
             // The following code implements a parallel nvbio::Pipeline to mark trusted kmers in the input
@@ -502,7 +611,17 @@ int main(int argc, char* argv[])
                 float approx_size;
                 float FP;
 
-                if (device_count)
+                if (skip_sampling)
+                {
+                    compute_bloom_filter_stats<host_tag>(
+                        sampled_kmers_bf_words,
+                        h_sampled_kmers,
+                        SAMPLED_KMERS_FILTER_K,
+                        occupancy,
+                        approx_size,
+                        FP );
+                }
+                else if (device_count)
                 {
                     compute_bloom_filter_stats(
                         d_bloom_filters[0],
@@ -585,7 +704,7 @@ int main(int argc, char* argv[])
                 marking_stage[device_count] = TrustedKmersStage(
                     -threads,
                     k,
-                    sampled_kmers_bf_words * bits_per_word, raw_pointer( h_bloom_filters.sampled_kmers_storage ),
+                    sampled_kmers_bf_words * bits_per_word, h_sampled_kmers,
                     trusted_kmers_bf_words * bits_per_word, raw_pointer( h_bloom_filters.trusted_kmers_storage ),
                     raw_pointer( h_bloom_filters.threshold ),
                     &marking_stats );
@@ -627,6 +746,26 @@ int main(int argc, char* argv[])
 
             log_verbose(stderr,"  total time  : %.1fs\n", time);
             log_verbose(stderr,"  peak memory : %.1f GB\n", float( peak_resident_memory() ) / float(1024*1024*1024));
+
+            // save both filters, so that a later run can skip straight to error correction
+            if (save_filters_name)
+            {
+                log_info(stderr,"  saving sampled and trusted kmers to \"%s\"\n", save_filters_name);
+
+                nvbio::vector<host_tag,uint32> sampled_temp;
+                nvbio::vector<host_tag,uint32> trusted_temp;
+                const BloomFiltersFileHeader header = make_bloom_filters_header(
+                    TRUSTED_KMERS_STAGE, k, genome_size, alpha,
+                    sampled_kmers_bf_words, trusted_kmers_bf_words,
+                    raw_pointer( threshold ) );
+
+                if (save_bloom_filters(
+                    save_filters_name,
+                    header,
+                    skip_sampling ? h_sampled_kmers : fetch_kmers( h_bloom_filters_ptr, d_bloom_filters, SAMPLED_KMERS, sampled_temp ),
+                    fetch_kmers( h_bloom_filters_ptr, d_bloom_filters, TRUSTED_KMERS, trusted_temp ) ) == false)
+                    return 1;
+            }
         }
         log_info(stderr,"  mark trusted kmers... done\n");
 
@@ -646,7 +785,17 @@ int main(int argc, char* argv[])
                 float approx_size;
                 float FP;
 
-                if (device_count)
+                if (skip_marking)
+                {
+                    compute_bloom_filter_stats<host_tag>(
+                        trusted_kmers_bf_words,
+                        h_trusted_kmers,
+                        TRUSTED_KMERS_FILTER_K,
+                        occupancy,
+                        approx_size,
+                        FP );
+                }
+                else if (device_count)
                 {
                     compute_bloom_filter_stats(
                         d_bloom_filters[0],
@@ -703,7 +852,7 @@ int main(int argc, char* argv[])
                 ec_stage[device_count] = ErrorCorrectStage(
                     -threads,
                     k,
-                    trusted_kmers_bf_words * bits_per_word, raw_pointer( h_bloom_filters.trusted_kmers_storage ),
+                    trusted_kmers_bf_words * bits_per_word, h_trusted_kmers,
                     raw_pointer( h_bloom_filters.stats ),
                     max_correction,
                     bad_quality,
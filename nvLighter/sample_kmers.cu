@@ -75,6 +75,25 @@ struct SampleKmersFunctor
     ///
     NVBIO_HOST_DEVICE
     void operator() (const uint32 i) const
+    {
+      #if defined(__CUDA_ARCH__)
+        KmerInserter<filter_type> sink( filter );
+      #else
+        // on the host, insert the kmers in prefetched batches
+        BatchedKmerInserter<filter_type> sink( filter );
+      #endif
+        sample( i, sink );
+        sink.flush();
+    }
+
+    /// sample the kmers of a string, passing them to a sink
+    ///
+    ///\param i     input string index
+    ///\param sink  the kmer sink
+    ///
+    template <typename sink_type>
+    NVBIO_HOST_DEVICE
+    void sample(const uint32 i, sink_type& sink) const
     {
         typedef typename string_set_type::string_type                   string_type;
         typedef typename string_traits<string_type>::forward_iterator   forward_iterator;
@@ -112,7 +131,7 @@ struct SampleKmersFunctor
                     if (float( random.next() ) / float(LCG_random::MAX) < alpha)
                     {
                         // insert the kmer
-                        filter.insert( kmer );
+                        sink.insert( kmer );
                     }
                 }
 
@@ -364,6 +383,13 @@ struct TrustedKmersFunctor
         for (uint32 j = 0; j < (occur_cnt+31)/32; ++j)
             occur_storage[j] = 0u;
 
+      #if defined(__CUDA_ARCH__)
+        KmerMarker<sampled_filter_type, nvbio::PackedStream<uint32*,uint8,1u,false> > occur_marker( sampled_filter, occur );
+      #else
+        // on the host, look up the kmers in prefetched batches
+        BatchedKmerMarker<sampled_filter_type, nvbio::PackedStream<uint32*,uint8,1u,false> > occur_marker( sampled_filter, occur );
+      #endif
+
         // mark occurring kmers
         for (uint32 j = 0; j < len; ++j)
         {
@@ -377,10 +403,7 @@ struct TrustedKmersFunctor
                     kmer_len++;
 
                 if (kmer_len >= k) // check whether we have an actual 'k'-mer
-                {
-                    if (sampled_filter[ kmer ])
-                        occur[j - k + 1] = true;
-                }
+                    occur_marker.query( kmer, j - k + 1 );
 
                 // shift the kmer to the right, dropping the last symbol
                 kmer <<= 2;
@@ -397,6 +420,14 @@ struct TrustedKmersFunctor
                 kmer_len = 0u;
             }
         }
+        occur_marker.flush();
+
+      #if defined(__CUDA_ARCH__)
+        KmerInserter<trusted_filter_type> trusted_sink( trusted_filter );
+      #else
+        // on the host, insert the kmers in prefetched batches
+        BatchedKmerInserter<trusted_filter_type> trusted_sink( trusted_filter );
+      #endif
 
         // mark trusted kmers
         int32 zero_cnt = 0;
@@ -445,7 +476,7 @@ struct TrustedKmersFunctor
                 kmer |= c; // insert the new character at the end of the kmer (in a big-endian encoding)
 
                 if (popc( trusted ) == k) // check whether we have an actual 'k'-mer - i.e. k trusted positions in a row
-                    trusted_filter.insert( kmer );
+                    trusted_sink.insert( kmer );
             }
 
             // shift the kmer to the right, dropping the last symbol
@@ -456,6 +487,7 @@ struct TrustedKmersFunctor
             trusted <<= 1;
             trusted &= trusted_mask;
         }
+        trusted_sink.flush();
     }
 
     const uint32                k;
@@ -33,6 +33,7 @@
 #include <nvbio/basic/numbers.h>
 #include <nvbio/basic/threads.h>
 #include <nvbio/basic/cuda/arch.h>
+#include <nvbio/basic/bloom_filter.h>
 
 enum {
     ERROR_FREE    = 0,
@@ -137,6 +138,115 @@ struct KmerCode
     int    invalid;
 };
 
+enum { KMER_BATCH_SIZE = 256 };
+
+///
+/// A kmer sink inserting each kmer in a Bloom filter as soon as it's produced
+///
+template <typename filter_type>
+struct KmerInserter
+{
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    KmerInserter(filter_type& _filter) : filter( _filter ) {}
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void insert(const uint64 kmer) { filter.insert( kmer ); }
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void flush() {}
+
+    filter_type& filter;
+};
+
+///
+/// A host kmer sink buffering the kmers of a read and inserting them in a Bloom filter
+/// in batches, so as to prefetch the filter blocks of the upcoming kmers
+///
+template <typename filter_type>
+struct BatchedKmerInserter
+{
+    BatchedKmerInserter(filter_type& _filter) : filter( _filter ), size( 0u ) {}
+
+    void insert(const uint64 kmer)
+    {
+        kmers[ size++ ] = kmer;
+        if (size == KMER_BATCH_SIZE)
+            flush();
+    }
+
+    void flush()
+    {
+        nvbio::bloom_filter_insert_batch( filter, size, kmers );
+        size = 0u;
+    }
+
+    filter_type& filter;
+    uint64       kmers[KMER_BATCH_SIZE];
+    uint32       size;
+};
+
+///
+/// A kmer sink looking up each kmer in a Bloom filter as soon as it's produced,
+/// and setting the flag corresponding to its position if found
+///
+template <typename filter_type, typename flags_type>
+struct KmerMarker
+{
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    KmerMarker(const filter_type& _filter, flags_type _flags) : filter( _filter ), flags( _flags ) {}
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void query(const uint64 kmer, const uint32 pos)
+    {
+        if (filter[ kmer ])
+            flags[ pos ] = true;
+    }
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void flush() {}
+
+    const filter_type& filter;
+    flags_type         flags;
+};
+
+///
+/// A host kmer sink buffering the kmers of a read and looking them up in a Bloom filter
+/// in batches, setting the flags corresponding to the positions of the ones found
+///
+template <typename filter_type, typename flags_type>
+struct BatchedKmerMarker
+{
+    BatchedKmerMarker(const filter_type& _filter, flags_type _flags) : filter( _filter ), flags( _flags ), size( 0u ) {}
+
+    void query(const uint64 kmer, const uint32 pos)
+    {
+        kmers[ size ]     = kmer;
+        positions[ size ] = pos;
+        if (++size == KMER_BATCH_SIZE)
+            flush();
+    }
+
+    void flush()
+    {
+        uint8 found[KMER_BATCH_SIZE];
+
+        nvbio::bloom_filter_has_batch( filter, size, kmers, found );
+
+        for (uint32 i = 0; i < size; ++i)
+        {
+            if (found[i])
+                flags[ positions[i] ] = true;
+        }
+        size = 0u;
+    }
+
+    const filter_type& filter;
+    flags_type         flags;
+    uint64             kmers[KMER_BATCH_SIZE];
+    uint32             positions[KMER_BATCH_SIZE];
+    uint32             size;
+};
+
 struct SequenceStats
 {
     SequenceStats() : m_reads(0), m_bps(0), m_time(0) {}
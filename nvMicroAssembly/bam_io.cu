@@ -44,10 +44,16 @@ HTSBAMReader::HTSBAMReader(const char *fname)
 	if (header == NULL) {
 		throw nvbio::runtime_error("Error parsing BAM file header");
 	}
+	// look for a .bai/.csi index next to the file; without one, region
+	// queries fall back to a sequential scan of the (sorted) file
+	idx = sam_index_load(fp, fname);
 }
 
 HTSBAMReader::~HTSBAMReader()
 {
+	if (idx) {
+		hts_idx_destroy(idx);
+	}
 	bam_hdr_destroy(header);
 	sam_close(fp);
 }
@@ -160,38 +166,114 @@ bool HTSBAMReader::read_aln_batch(BAM_alignment_batch_SoA& batch, const uint64 b
 
 // loads reads overlapping the specified interval [s, e] (including the end points)
 // the interval is 0-based (note: the record position is 0-based)
-// this is a temporary hack -- should use bam index file instead
+// if the BAM file is indexed, the records are fetched through an index iterator;
+// otherwise the file is scanned sequentially from the end of the previous interval,
+// which requires the intervals to be requested in sorted order
 // returns false if no records were read
 bool HTSBAMReader::read_aln_batch_intv(BAM_alignment_batch_SoA& batch, const uint32 contig, const uint64 start, const uint64 end)
 {
-	long new_offset = -1;
+	const uint64 n_alns = batch.num_alns;
 
 	H_VectorU32 cigar_temp(64);
-	bam1_t *b = (bam1_t*)calloc(1, sizeof(bam1_t));
+	bam1_t *b = bam_init1();
+	if (idx) {
+		// the iterator interval is half-open
+		hts_itr_t* itr = sam_itr_queryi(idx, contig, start, end + 1);
+		if (itr == NULL) {
+			bam_destroy1(b);
+			return false;
+		}
+		while (sam_itr_next(fp, itr, b) >= 0) {
+			if(b->core.flag & BAM_FUNMAP) continue;
+			parse_aln_rec(batch, b, cigar_temp);
+			batch.num_alns++;
+		}
+		hts_itr_destroy(itr);
+	} else {
+		long new_offset = -1;
+		while(1) {
+			if (sam_read1(fp, header, b) < 0) break;
+			if(b->core.tid > contig || (b->core.tid == contig && b->core.pos > end)) break; // reads one more record, should jump back
+			if(b->core.flag & BAM_FUNMAP) continue;
+			if(b->core.tid == contig && (bam_endpos(b) >= start)) {
+				if(new_offset == -1) {
+					new_offset = bgzf_tell(fp->fp.bgzf);
+				}
+				parse_aln_rec(batch, b, cigar_temp);
+				batch.num_alns++;
+			}
+		}
+
+		if(new_offset != -1) {
+			fp_offset = new_offset;
+		}
+
+		bgzf_seek(fp->fp.bgzf, fp_offset, SEEK_SET);
+	}
+	bam_destroy1(b);
+
+	if (batch.num_alns == n_alns) {
+		return false;
+	}
+	return true;
+}
+
+// loads the raw records overlapping the interval [s, e] into recs[0, n_recs)
+// the record buffers already stored in recs are reused, and new ones are allocated as needed
+// returns false if no records were read
+bool HTSBAMReader::read_aln_recs_intv(std::vector<bam1_t*>& recs, uint64& n_recs, const uint32 contig, const uint64 start, const uint64 end)
+{
+	n_recs = 0;
+
+	hts_itr_t* itr = NULL;
+	if (idx) {
+		itr = sam_itr_queryi(idx, contig, start, end + 1);
+		if (itr == NULL) {
+			return false;
+		}
+	}
+
+	long new_offset = -1;
 	while(1) {
-		if (sam_read1(fp, header, b) < 0) break;
-		if(b->core.tid > contig || (b->core.tid == contig && b->core.pos > end)) break; // reads one more record, should jump back
-		if(b->core.flag & BAM_FUNMAP) continue;
-		if(b->core.tid == contig && (bam_endpos(b) >= start)) {
+		if (n_recs == recs.size()) {
+			recs.push_back(bam_init1());
+		}
+		bam1_t* b = recs[n_recs];
+
+		if (itr) {
+			if (sam_itr_next(fp, itr, b) < 0) break;
+			if(b->core.flag & BAM_FUNMAP) continue;
+		} else {
+			if (sam_read1(fp, header, b) < 0) break;
+			if(b->core.tid > contig || (b->core.tid == contig && b->core.pos > end)) break;
+			if(b->core.flag & BAM_FUNMAP) continue;
+			if(b->core.tid != contig || (bam_endpos(b) < start)) continue;
 			if(new_offset == -1) {
 				new_offset = bgzf_tell(fp->fp.bgzf);
 			}
-			//printf("Read: %u %u %u\n", b->core.tid+1, b->core.pos+1, b->core.l_qseq);
-			parse_aln_rec(batch, b, cigar_temp);
-			batch.num_alns++;
 		}
+		n_recs++;
 	}
 
-	if(new_offset != -1) {
-		fp_offset = new_offset;
+	if (itr) {
+		hts_itr_destroy(itr);
+	} else {
+		if(new_offset != -1) {
+			fp_offset = new_offset;
+		}
+		bgzf_seek(fp->fp.bgzf, fp_offset, SEEK_SET);
 	}
+	return n_recs > 0;
+}
 
-	bgzf_seek(fp->fp.bgzf, fp_offset, SEEK_SET);
-
-	if (batch.num_alns == 0) {
-		return false;
+// appends the raw records recs[0, n_recs) to the batch
+void HTSBAMReader::append_aln_recs(BAM_alignment_batch_SoA& batch, const std::vector<bam1_t*>& recs, const uint64 n_recs)
+{
+	H_VectorU32 cigar_temp(64);
+	for(uint64 i = 0; i < n_recs; i++) {
+		parse_aln_rec(batch, recs[i], cigar_temp);
+		batch.num_alns++;
 	}
-	return true;
 }
 
 bool HTSBAMReader::read_aln_batch(std::vector<bam1_t*>& batch, const uint64 batch_size) {
@@ -208,6 +290,99 @@ bool HTSBAMReader::read_aln_batch(std::vector<bam1_t*>& batch, const uint64 batc
 }
 
 
+/** ---- Region Prefetching ---- **/
+
+HTSBAMRegionPrefetcher::HTSBAMRegionPrefetcher(const char *fname, const std::vector<genome_loc>& regions, const uint32 depth)
+: reader(fname), regions(regions), slots(nvbio::max(depth, 1u)), n_produced(0), n_consumed(0), started(false)
+{
+	for(uint32 i = 0; i < slots.size(); i++) {
+		slots[i].n_recs = 0;
+	}
+}
+
+HTSBAMRegionPrefetcher::~HTSBAMRegionPrefetcher()
+{
+	if (started) {
+		// let the loader run to completion by draining the remaining regions
+		while (consumed() < regions.size()) {
+			while (produced() == consumed()) {
+				yield();
+			}
+			ScopedLock guard(&lock);
+			n_consumed++;
+		}
+		join();
+	}
+	for(uint32 i = 0; i < slots.size(); i++) {
+		for(uint64 j = 0; j < slots[i].recs.size(); j++) {
+			bam_destroy1(slots[i].recs[j]);
+		}
+	}
+}
+
+uint32 HTSBAMRegionPrefetcher::produced()
+{
+	ScopedLock guard(&lock);
+	return n_produced;
+}
+
+uint32 HTSBAMRegionPrefetcher::consumed()
+{
+	ScopedLock guard(&lock);
+	return n_consumed;
+}
+
+void HTSBAMRegionPrefetcher::start()
+{
+	started = true;
+	create();
+}
+
+// loader thread: fetch the regions in order, staying at most slots.size() regions ahead of the consumer
+void HTSBAMRegionPrefetcher::run()
+{
+	const uint32 depth = uint32(slots.size());
+	for(uint32 i = 0; i < regions.size(); i++) {
+		// wait for the slot to be released
+		while (i - consumed() >= depth) {
+			yield();
+		}
+
+		region_slot& slot = slots[i % depth];
+		const genome_loc& r = regions[i];
+		reader.read_aln_recs_intv(slot.recs, slot.n_recs, r.contig, r.start, r.stop);
+
+		ScopedLock guard(&lock);
+		n_produced++;
+	}
+}
+
+// waits for the next region and appends its reads to the batch
+bool HTSBAMRegionPrefetcher::next(BAM_alignment_batch_SoA& batch, uint64* n_alns)
+{
+	const uint32 i = consumed();
+	if (i >= regions.size()) {
+		return false;
+	}
+	if (!started) {
+		start();
+	}
+
+	while (produced() <= i) {
+		yield();
+	}
+
+	const region_slot& slot = slots[i % slots.size()];
+	reader.append_aln_recs(batch, slot.recs, slot.n_recs);
+	if (n_alns) {
+		*n_alns = slot.n_recs;
+	}
+
+	ScopedLock guard(&lock);
+	n_consumed++;
+	return true;
+}
+
 /** ---- Write Functionality ---- **/
 
 HTSBAMWriter::HTSBAMWriter(const char *fname)
@@ -33,7 +33,10 @@
 
 #include <thrust/gather.h>
 
+#include <nvbio/basic/threads.h>
+
 #include "assembly_types.h"
+#include "regions.h"
 
 using namespace nvbio;
 
@@ -348,19 +351,69 @@ public:
 private:
 	samFile* fp;
 	long fp_offset;
+	hts_idx_t* idx; // BAM index (.bai/.csi), NULL if not available
 
 public:
 	HTSBAMReader(const char *fname);
 	~HTSBAMReader();
 
+	// true if region queries are served through the BAM index
+	bool has_index() const { return idx != NULL; }
+
 	bool read_aln_batch(std::vector<bam1_t*>& batch, const uint64 batch_size = 1000000);
 	bool read_aln_batch(BAM_alignment_batch_SoA& batch, const uint64 batch_size = 1000000);
 	bool read_aln_batch_intv(BAM_alignment_batch_SoA& batch, const uint32 contig = 1u, const uint64 start = 0u, const uint64 end = 1000000);
+
+	// loads the raw records overlapping the interval [start, end] into recs[0, n_recs),
+	// reusing (and growing) the record buffers already present in recs
+	bool read_aln_recs_intv(std::vector<bam1_t*>& recs, uint64& n_recs, const uint32 contig, const uint64 start, const uint64 end);
+
+	// appends the raw records recs[0, n_recs) to the batch
+	void append_aln_recs(BAM_alignment_batch_SoA& batch, const std::vector<bam1_t*>& recs, const uint64 n_recs);
 private:
 	bool read_hdr(void);
 	void parse_aln_rec(BAM_alignment_batch_SoA& batch, bam1_t* b, H_VectorU32& cigar_temp);
 };
 
+// background loader of the reads overlapping a list of regions:
+// the records of the next regions are fetched and decompressed on a separate
+// thread (through its own file handle) while the current region is being processed;
+// at most depth regions are kept in flight
+struct HTSBAMRegionPrefetcher : public Thread<HTSBAMRegionPrefetcher>
+{
+public:
+	HTSBAMRegionPrefetcher(const char *fname, const std::vector<genome_loc>& regions, const uint32 depth = 4u);
+	~HTSBAMRegionPrefetcher();
+
+	// start fetching in the background
+	void start();
+
+	// waits for the next region and appends its reads to the batch;
+	// returns false once all regions have been consumed
+	bool next(BAM_alignment_batch_SoA& batch, uint64* n_alns = NULL);
+
+	// thread entry point
+	void run();
+
+private:
+	struct region_slot
+	{
+		std::vector<bam1_t*> recs; // record buffers, reused across regions
+		uint64 n_recs;
+	};
+
+	uint32 produced();
+	uint32 consumed();
+
+	HTSBAMReader reader;
+	std::vector<genome_loc> regions;
+	std::vector<region_slot> slots;
+	Mutex lock;
+	volatile uint32 n_produced;
+	volatile uint32 n_consumed;
+	bool started;
+};
+
 /**------------------- BAM Writer -------------**/
 
 // htslib-based BAM file writer
@@ -33,7 +33,8 @@
 #include "assembly.h"
 
 // loads reads overlapping multiple active regions from a BAM file
-// BAM index files should be used instead for better performance
+// the regions are fetched through the BAM index (if present) by a background
+// loader, which reads ahead while the previous regions are being parsed
 // note: start_pos is 0-based
 void load_active_regions_temp(const char* bam_fname,
 		const uint32 n_active_regions,
@@ -42,19 +43,26 @@ void load_active_regions_temp(const char* bam_fname,
 		H_VectorActiveRegions& active_regions,
 		BAM_alignment_batch_SoA& h_batch)
 {
-	HTSBAMReader bam_reader(bam_fname);
+	std::vector<genome_loc> locs(n_active_regions);
+	for(uint32 i = 0; i < n_active_regions; i++) {
+		locs[i].contig = 0u;
+		locs[i].start = start_pos;
+		locs[i].stop = start_pos + active_region_size - 1;
+		start_pos += active_region_size;
+	}
+
+	HTSBAMRegionPrefetcher prefetcher(bam_fname, locs);
+	prefetcher.start();
 	for(uint32 i = 0; i < n_active_regions; i++) {
 		active_region r;
-		r.genome_loc.contig = 0u;
-		r.genome_loc.start = start_pos;
-		r.genome_loc.stop = start_pos + active_region_size - 1;
+		r.genome_loc = locs[i];
 		r.read_batch_offset = h_batch.num_alns;
-		if(!bam_reader.read_aln_batch_intv(h_batch, r.genome_loc.contig, r.genome_loc.start, r.genome_loc.stop)) {
-			printf("No reads were loaded for region %u starting at %u. \n", i, start_pos);
+		uint64 n_alns = 0;
+		if(!prefetcher.next(h_batch, &n_alns) || n_alns == 0) {
+			printf("No reads were loaded for region %u starting at %llu. \n", i, (unsigned long long)locs[i].start);
 		}
 		r.n_reads = h_batch.num_alns - r.read_batch_offset;
 		active_regions.push_back(r);
-		start_pos += active_region_size;
 	}
 }
 
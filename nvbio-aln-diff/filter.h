@@ -28,6 +28,7 @@
 #pragma once
 
 #include <nvbio-aln-diff/alignment.h>
+#include <nvbio/basic/threads.h>
 #include <stdio.h>
 
 namespace nvbio {
@@ -75,7 +76,8 @@ struct Filter
         }
     }
 
-    // push a statistic into the filter
+    // push a statistic into the filter;
+    // thread-safe, as the filter is shared by all the analyzer shards
     //
     void operator() (const int32 delta, const uint32 flags, const Statistics stat, const uint32 read_id)
     {
@@ -86,6 +88,8 @@ struct Filter
             (m_stats & stat) &&
             (m_delta > 0 ? delta >= m_delta : delta <= m_delta))
         {
+            ScopedLock lock( &m_lock );
+
             fwrite( &read_id, sizeof(uint32), 1u, m_file );
 
             ++m_filtered;
@@ -105,6 +109,7 @@ struct Filter
     uint32 m_stats;
     int32  m_delta;
     uint32 m_filtered;
+    Mutex  m_lock;
 };
 
 } // namespace alndiff
@@ -28,11 +28,13 @@
 #include <nvbio-aln-diff/se_analyzer.h>
 #include <nvbio-aln-diff/pe_analyzer.h>
 #include <nvbio-aln-diff/alignment.h>
+#include <nvbio-aln-diff/pipeline.h>
 #include <nvbio-aln-diff/utils.h>
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/console.h>
 #include <nvbio/basic/html.h>
 #include <nvbio/basic/shared_pointer.h>
+#include <nvbio/basic/omp.h>
 #include <cuda_runtime_api.h>
 #include <vector_types.h>
 #include <vector_functions.h>
@@ -47,6 +49,39 @@ void crcInit();
 using namespace nvbio;
 using namespace alndiff;
 
+void log_summary(const SEAnalyzer& analyzer)
+{
+    log_verbose(stderr, "  mismatched          : %5.2f%%\n", 100.0f * analyzer.mismatched());
+    log_verbose(stderr, "  mapped [L]          : %5.2f%%\n", 100.0f * analyzer.mapped.avg_L());
+    log_verbose(stderr, "  mapped [R]          : %5.2f%%\n", 100.0f * analyzer.mapped.avg_R());
+    log_verbose(stderr, "  mapped [L&R]        : %5.2f%%\n", 100.0f * analyzer.mapped.avg_L_and_R());
+    log_verbose(stderr, "  mapped/unmapped [L] : %5.2f%%\n", 100.0f * analyzer.mapped.avg_L_not_R());
+    log_verbose(stderr, "  mapped/unmapped [R] : %5.2f%%\n", 100.0f * analyzer.mapped.avg_R_not_L());
+    log_verbose(stderr, "  different ref       : %5.2f%%\n", 100.0f * analyzer.different_ref());
+    log_verbose(stderr, "  distant             : %5.2f%%\n", 100.0f * analyzer.distant());
+    log_verbose(stderr, "  discordant          : %5.2f%%\n", 100.0f * analyzer.discordant());
+    log_verbose(stderr, "  filtered            : %u\n", analyzer.filtered());
+}
+
+void log_summary(const PEAnalyzer& analyzer)
+{
+    log_verbose(stderr, "  mismatched          : %5.2f%%\n", 100.0f * analyzer.mismatched());
+    log_verbose(stderr, "  mapped [L]          : %5.2f%%\n", 100.0f * analyzer.mapped.avg_L());
+    log_verbose(stderr, "  mapped [R]          : %5.2f%%\n", 100.0f * analyzer.mapped.avg_R());
+    log_verbose(stderr, "  mapped [L&R]        : %5.2f%%\n", 100.0f * analyzer.mapped.avg_L_and_R());
+    log_verbose(stderr, "  mapped/unmapped [L] : %5.2f%%\n", 100.0f * analyzer.mapped.avg_L_not_R());
+    log_verbose(stderr, "  mapped/unmapped [R] : %5.2f%%\n", 100.0f * analyzer.mapped.avg_R_not_L());
+    log_verbose(stderr, "  paired [L]          : %5.2f%%\n", 100.0f * analyzer.paired.avg_L());
+    log_verbose(stderr, "  paired [R]          : %5.2f%%\n", 100.0f * analyzer.paired.avg_R());
+    log_verbose(stderr, "  paired [L&R]        : %5.2f%%\n", 100.0f * analyzer.paired.avg_L_and_R());
+    log_verbose(stderr, "  paired/unpaired [L] : %5.2f%%\n", 100.0f * analyzer.paired.avg_L_not_R());
+    log_verbose(stderr, "  paired/unpaired [R] : %5.2f%%\n", 100.0f * analyzer.paired.avg_R_not_L());
+    log_verbose(stderr, "  different ref       : %5.2f%%\n", 100.0f * analyzer.different_ref());
+    log_verbose(stderr, "  distant             : %5.2f%%\n", 100.0f * analyzer.distant());
+    log_verbose(stderr, "  discordant          : %5.2f%%\n", 100.0f * analyzer.discordant());
+    log_verbose(stderr, "  filtered            : %u\n", analyzer.filtered());
+}
+
 
 int main(int argc, char* argv[])
 {
@@ -65,6 +100,8 @@ int main(int argc, char* argv[])
     int32  filter_delta = 5;
     bool   paired = false;
     bool   id_check = true;
+    uint32 n_threads = 0;
+    uint64 max_pending = 2u*1024u*1024u;
 
     int arg = 1;
     while (arg < argc)
@@ -89,6 +126,16 @@ int main(int argc, char* argv[])
             id_check = false;
             ++arg;
         }
+        else if (strcmp( argv[arg], "-threads" ) == 0)
+        {
+            n_threads = atoi(argv[++arg]);
+            ++arg;
+        }
+        else if (strcmp( argv[arg], "-max-pending" ) == 0)
+        {
+            max_pending = atoi(argv[++arg]);
+            ++arg;
+        }
         else if (strcmp( argv[arg], "-filter" ) == 0)
         {
             filter_name = argv[++arg];
@@ -206,7 +253,9 @@ int main(int argc, char* argv[])
         log_info(stderr, "nvbio-aln-diff [OPTIONS] <file1> <file2>\n");
         log_info(stderr, "OPTIONS:\n");
         log_info(stderr, "  -paired                   # paired-end input\n" );
-        log_info(stderr, "  -no-ids                   # do not perform id checks\n" );
+        log_info(stderr, "  -no-ids                   # do not perform id checks (inputs must be in the same order)\n" );
+        log_info(stderr, "  -threads <int>            # number of analysis threads\n" );
+        log_info(stderr, "  -max-pending <int>        # maximum number of unmatched records kept in memory\n" );
         log_info(stderr, "  -report <file-name>       # HTML report\n" );
         log_info(stderr, "  -filter <file-name>\n" );
         log_info(stderr, "          <flags={distant|discordant|diff-ref}>\n" );
@@ -243,148 +292,71 @@ int main(int argc, char* argv[])
         log_info(stderr, "  delta : %d\n", filter_delta);
     }
 
+    if (n_threads == 0)
+        n_threads = omp_get_num_procs();
+
+    omp_set_num_threads( n_threads );
+
+    const uint32 BATCH_SIZE = 500000;
+
     if (argc == arg + 2)
     {
         const char *aln_file_nameL = argv[arg];
         const char *aln_file_nameR = argv[arg+1];
 
-        if (paired)
-        {
-            const char *aln_file_nameL = argv[arg];
-            const char *aln_file_nameR = argv[arg+1];
+        SharedPointer<AlignmentStream> aln_streamL = SharedPointer<AlignmentStream>( open_alignment_file( aln_file_nameL ) );
+        SharedPointer<AlignmentStream> aln_streamR = SharedPointer<AlignmentStream>( open_alignment_file( aln_file_nameR ) );
 
-            SharedPointer<AlignmentStream> aln_streamL = SharedPointer<AlignmentStream>( open_alignment_file( aln_file_nameL ) );
-            SharedPointer<AlignmentStream> aln_streamR = SharedPointer<AlignmentStream>( open_alignment_file( aln_file_nameR ) );
+        if (aln_streamL == NULL || aln_streamL->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameL); exit(1); }
+        if (aln_streamR == NULL || aln_streamR->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameR); exit(1); }
 
-            if (aln_streamL == NULL || aln_streamL->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameL); exit(1); }
-            if (aln_streamR == NULL || aln_streamR->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameR); exit(1); }
-
-            const uint32 BATCH_SIZE = 500000;
-            std::vector<Alignment> batchL( BATCH_SIZE );
-            std::vector<Alignment> batchR( BATCH_SIZE );
+        Filter filter( filter_name, filter_flags, filter_stats, filter_delta );
 
-            Filter filter( filter_name, filter_flags, filter_stats, filter_delta );
-            SharedPointer<PEAnalyzer> analyzer = SharedPointer<PEAnalyzer>( new PEAnalyzer( filter, id_check ) );
+        if (paired)
+        {
+            InterleavedPairSource sourceL( aln_streamL.get(), BATCH_SIZE, aln_file_nameL );
+            InterleavedPairSource sourceR( aln_streamR.get(), BATCH_SIZE, aln_file_nameR );
 
-            uint32 n_batch = 0;
-            while (1)
-            {
-                const uint32 batch_sizeL = aln_streamL->next_batch( BATCH_SIZE, &batchL[0] );
-                const uint32 batch_sizeR = aln_streamR->next_batch( BATCH_SIZE, &batchR[0] );
+            RecordMatcher<AlignmentPair> matcher( id_check, max_pending );
 
-                const uint32 min_batch_size = nvbio::min( batch_sizeL, batch_sizeR );
-                const uint32 max_batch_size = nvbio::max( batch_sizeL, batch_sizeR );
+            std::vector<PEAnalyzer*> analyzers( n_threads );
+            for (uint32 i = 0; i < n_threads; ++i)
+                analyzers[i] = new PEAnalyzer( filter, id_check );
 
-                if (min_batch_size != max_batch_size)
-                    log_warning(stderr, "alignment files have different size\n");
+            compare( sourceL, sourceR, matcher, analyzers );
 
-                log_info(stderr, "analizing batch[%u]: %u alignments (%.1f M)\n", n_batch, min_batch_size, float(n_batch * BATCH_SIZE + min_batch_size)*1.0e-6f);
+            if (report_name)
+                analyzers[0]->generate_report( aln_file_nameL, aln_file_nameR, report_name );
 
-                for (uint32 i = 0; i < min_batch_size; i += 2)
-                {
-                    const Alignment* alnL1 = &batchL[i];
-                    const Alignment* alnL2 = &batchL[i+1];
-                    const Alignment* alnR1 = &batchR[i];
-                    const Alignment* alnR2 = &batchR[i+1];
-
-                    if (alnL1->is_mapped() && alnL1->mate == alnL2->mate)
-                    {
-                        log_error(stderr, "alignments %u and %u in \"%s\" refer to the same mate, must come from different reads\n", i, i+1, aln_file_nameL);
-                        return 1;
-                    }
-                    if (alnR1->is_mapped() && alnR1->mate == alnR2->mate)
-                    {
-                        log_error(stderr, "alignments %u and %u in \"%s\" refer to the same mate, must come from different reads\n", i, i+1, aln_file_nameR);
-                        return 1;
-                    }
-
-                    if (alnL1->mate) std::swap( alnL1, alnL2 );
-                    if (alnR1->mate) std::swap( alnR1, alnR2 );
-
-                    analyzer->push(
-                        AlignmentPair( *alnL1, *alnL2 ),
-                        AlignmentPair( *alnR1, *alnR2 ));
-                }
+            analyzers[0]->flush();
 
-                if (report_name)
-                    analyzer->generate_report( aln_file_nameL, aln_file_nameR, report_name );
-
-                analyzer->flush();
-
-                log_verbose(stderr, "  mismatched          : %5.2f%%\n", 100.0f * analyzer->mismatched());
-                log_verbose(stderr, "  mapped [L]          : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L());
-                log_verbose(stderr, "  mapped [R]          : %5.2f%%\n", 100.0f * analyzer->mapped.avg_R());
-                log_verbose(stderr, "  mapped [L&R]        : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L_and_R());
-                log_verbose(stderr, "  mapped/unmapped [L] : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L_not_R());
-                log_verbose(stderr, "  mapped/unmapped [R] : %5.2f%%\n", 100.0f * analyzer->mapped.avg_R_not_L());
-                log_verbose(stderr, "  paired [L]          : %5.2f%%\n", 100.0f * analyzer->paired.avg_L());
-                log_verbose(stderr, "  paired [R]          : %5.2f%%\n", 100.0f * analyzer->paired.avg_R());
-                log_verbose(stderr, "  paired [L&R]        : %5.2f%%\n", 100.0f * analyzer->paired.avg_L_and_R());
-                log_verbose(stderr, "  paired/unpaired [L] : %5.2f%%\n", 100.0f * analyzer->paired.avg_L_not_R());
-                log_verbose(stderr, "  paired/unpaired [R] : %5.2f%%\n", 100.0f * analyzer->paired.avg_R_not_L());
-                log_verbose(stderr, "  different ref       : %5.2f%%\n", 100.0f * analyzer->different_ref());
-                log_verbose(stderr, "  distant             : %5.2f%%\n", 100.0f * analyzer->distant());
-                log_verbose(stderr, "  discordant          : %5.2f%%\n", 100.0f * analyzer->discordant());
-                log_verbose(stderr, "  filtered            : %u\n", analyzer->filtered());
-
-                if (min_batch_size < BATCH_SIZE)
-                    break;
+            log_summary( *analyzers[0] );
 
-                ++n_batch;
-            }
+            for (uint32 i = 0; i < n_threads; ++i)
+                delete analyzers[i];
         }
         else
         {
-            SharedPointer<AlignmentStream> aln_streamL = SharedPointer<AlignmentStream>( open_alignment_file( aln_file_nameL ) );
-            SharedPointer<AlignmentStream> aln_streamR = SharedPointer<AlignmentStream>( open_alignment_file( aln_file_nameR ) );
-
-            if (aln_streamL == NULL || aln_streamL->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameL); exit(1); }
-            if (aln_streamR == NULL || aln_streamR->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameR); exit(1); }
-
-            const uint32 BATCH_SIZE = 500000;
-            std::vector<Alignment> batchL( BATCH_SIZE );
-            std::vector<Alignment> batchR( BATCH_SIZE );
-
-            Filter filter( filter_name, filter_flags, filter_stats, filter_delta );
-            SharedPointer<SEAnalyzer> analyzer = SharedPointer<SEAnalyzer>( new SEAnalyzer( filter ) );
-
-            uint32 n_batch = 0;
-            while (1)
-            {
-                const uint32 batch_sizeL = aln_streamL->next_batch( BATCH_SIZE, &batchL[0] );
-                const uint32 batch_sizeR = aln_streamR->next_batch( BATCH_SIZE, &batchR[0] );
-
-                if (batch_sizeL != batch_sizeR)
-                    log_warning(stderr, "alignment files have different size\n");
-
-                const uint32 min_batch_size = nvbio::min( batch_sizeL, batch_sizeR );
+            AlignmentSource sourceL( aln_streamL.get(), BATCH_SIZE );
+            AlignmentSource sourceR( aln_streamR.get(), BATCH_SIZE );
 
-                log_info(stderr, "analizing batch[%u]: %u alignments (%.1f M)\n", n_batch, min_batch_size, float(n_batch * BATCH_SIZE + min_batch_size)*1.0e-6f);
+            RecordMatcher<Alignment> matcher( id_check, max_pending );
 
-                for (uint32 i = 0; i < min_batch_size; ++i)
-                    analyzer->push( batchL[i], batchR[i] );
+            std::vector<SEAnalyzer*> analyzers( n_threads );
+            for (uint32 i = 0; i < n_threads; ++i)
+                analyzers[i] = new SEAnalyzer( filter );
 
-                if (report_name)
-                    analyzer->generate_report( aln_file_nameL, aln_file_nameR, report_name );
+            compare( sourceL, sourceR, matcher, analyzers );
 
-                analyzer->flush();
+            if (report_name)
+                analyzers[0]->generate_report( aln_file_nameL, aln_file_nameR, report_name );
 
-                log_verbose(stderr, "  mismatched          : %5.2f%%\n", 100.0f * analyzer->mismatched());
-                log_verbose(stderr, "  mapped [L]          : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L());
-                log_verbose(stderr, "  mapped [R]          : %5.2f%%\n", 100.0f * analyzer->mapped.avg_R());
-                log_verbose(stderr, "  mapped [L&R]        : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L_and_R());
-                log_verbose(stderr, "  mapped/unmapped [L] : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L_not_R());
-                log_verbose(stderr, "  mapped/unmapped [R] : %5.2f%%\n", 100.0f * analyzer->mapped.avg_R_not_L());
-                log_verbose(stderr, "  different ref       : %5.2f%%\n", 100.0f * analyzer->different_ref());
-                log_verbose(stderr, "  distant             : %5.2f%%\n", 100.0f * analyzer->distant());
-                log_verbose(stderr, "  discordant          : %5.2f%%\n", 100.0f * analyzer->discordant());
-                log_verbose(stderr, "  filtered            : %u\n", analyzer->filtered());
+            analyzers[0]->flush();
 
-                if (min_batch_size < BATCH_SIZE)
-                    break;
+            log_summary( *analyzers[0] );
 
-                ++n_batch;
-            }
+            for (uint32 i = 0; i < n_threads; ++i)
+                delete analyzers[i];
         }
     }
     else if (argc == arg + 4)
@@ -405,70 +377,31 @@ int main(int argc, char* argv[])
         if (aln_streamL1 == NULL || aln_streamL1->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameL1); exit(1); }
         if (aln_streamL2 == NULL || aln_streamL2->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameL2); exit(1); }
 
-        if (aln_streamR2 == NULL || aln_streamR1->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameR1); exit(1); }
+        if (aln_streamR1 == NULL || aln_streamR1->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameR1); exit(1); }
         if (aln_streamR2 == NULL || aln_streamR2->is_ok() == false) { log_error(stderr, "failed opening \"%s\"\n", aln_file_nameR2); exit(1); }
 
-        const uint32 BATCH_SIZE = 500000;
-        std::vector<Alignment> batchL1( BATCH_SIZE );
-        std::vector<Alignment> batchL2( BATCH_SIZE );
-        std::vector<Alignment> batchR1( BATCH_SIZE );
-        std::vector<Alignment> batchR2( BATCH_SIZE );
+        SplitPairSource sourceL( aln_streamL1.get(), aln_streamL2.get(), BATCH_SIZE );
+        SplitPairSource sourceR( aln_streamR1.get(), aln_streamR2.get(), BATCH_SIZE );
 
-        Filter filter( filter_name, filter_flags, filter_stats, filter_delta );
-        SharedPointer<PEAnalyzer> analyzer = SharedPointer<PEAnalyzer>( new PEAnalyzer( filter, id_check ) );
+        RecordMatcher<AlignmentPair> matcher( id_check, max_pending );
 
-        uint32 n_batch = 0;
-        while (1)
-        {
-            const uint32 batch_sizeL1 = aln_streamL1->next_batch( BATCH_SIZE, &batchL1[0] );
-            const uint32 batch_sizeL2 = aln_streamL2->next_batch( BATCH_SIZE, &batchL2[0] );
-            const uint32 batch_sizeR1 = aln_streamR1->next_batch( BATCH_SIZE, &batchR1[0] );
-            const uint32 batch_sizeR2 = aln_streamR2->next_batch( BATCH_SIZE, &batchR2[0] );
+        Filter filter( filter_name, filter_flags, filter_stats, filter_delta );
 
-            const uint32 min_batch_size = nvbio::min(
-                nvbio::min( batch_sizeL1, batch_sizeL2 ),
-                nvbio::min( batch_sizeR1, batch_sizeR2 ) );
+        std::vector<PEAnalyzer*> analyzers( n_threads );
+        for (uint32 i = 0; i < n_threads; ++i)
+            analyzers[i] = new PEAnalyzer( filter, id_check );
 
-            const uint32 max_batch_size = nvbio::min(
-                nvbio::max( batch_sizeL1, batch_sizeL2 ),
-                nvbio::max( batch_sizeR1, batch_sizeR2 ) );
+        compare( sourceL, sourceR, matcher, analyzers );
 
-            if (min_batch_size != max_batch_size)
-                log_warning(stderr, "alignment files have different size\n");
+        if (report_name)
+            analyzers[0]->generate_report( aln_file_nameL, aln_file_nameR, report_name );
 
-            log_info(stderr, "analizing batch[%u]: %u alignments (%.1f M)\n", n_batch, min_batch_size, float(n_batch * BATCH_SIZE + min_batch_size)*1.0e-6f);
+        analyzers[0]->flush();
 
-            for (uint32 i = 0; i < min_batch_size; ++i)
-                analyzer->push(
-                    AlignmentPair( batchL1[i], batchL2[i] ),
-                    AlignmentPair( batchR1[i], batchR2[i] ));
+        log_summary( *analyzers[0] );
 
-            if (report_name)
-                analyzer->generate_report( aln_file_nameL, aln_file_nameR, report_name );
-
-            analyzer->flush();
-
-            log_verbose(stderr, "  mismatched          : %5.2f%%\n", 100.0f * analyzer->mismatched());
-            log_verbose(stderr, "  mapped [L]          : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L());
-            log_verbose(stderr, "  mapped [R]          : %5.2f%%\n", 100.0f * analyzer->mapped.avg_R());
-            log_verbose(stderr, "  mapped [L&R]        : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L_and_R());
-            log_verbose(stderr, "  mapped/unmapped [L] : %5.2f%%\n", 100.0f * analyzer->mapped.avg_L_not_R());
-            log_verbose(stderr, "  mapped/unmapped [R] : %5.2f%%\n", 100.0f * analyzer->mapped.avg_R_not_L());
-            log_verbose(stderr, "  paired [L]          : %5.2f%%\n", 100.0f * analyzer->paired.avg_L());
-            log_verbose(stderr, "  paired [R]          : %5.2f%%\n", 100.0f * analyzer->paired.avg_R());
-            log_verbose(stderr, "  paired [L&R]        : %5.2f%%\n", 100.0f * analyzer->paired.avg_L_and_R());
-            log_verbose(stderr, "  paired/unpaired [L] : %5.2f%%\n", 100.0f * analyzer->paired.avg_L_not_R());
-            log_verbose(stderr, "  paired/unpaired [R] : %5.2f%%\n", 100.0f * analyzer->paired.avg_R_not_L());
-            log_verbose(stderr, "  different ref       : %5.2f%%\n", 100.0f * analyzer->different_ref());
-            log_verbose(stderr, "  distant             : %5.2f%%\n", 100.0f * analyzer->distant());
-            log_verbose(stderr, "  discordant          : %5.2f%%\n", 100.0f * analyzer->discordant());
-            log_verbose(stderr, "  filtered            : %u\n", analyzer->filtered());
-
-            if (min_batch_size < BATCH_SIZE)
-                break;
-
-            ++n_batch;
-        }
+        for (uint32 i = 0; i < n_threads; ++i)
+            delete analyzers[i];
     }
 
     cudaDeviceReset();
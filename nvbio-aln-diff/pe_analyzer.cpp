@@ -331,6 +331,48 @@ void generate_summary_cell(FILE* html_output, const std::string file_name, const
 
 } // anonymous namespace
 
+void PEAnalyzer::merge(const PEAnalyzer& other)
+{
+    mapped.merge( other.mapped );
+    paired.merge( other.paired );
+    unique.merge( other.unique );
+    ambiguous.merge( other.ambiguous );
+    not_ambiguous.merge( other.not_ambiguous );
+    paired_L_not_R_by_mapQ.merge( other.paired_L_not_R_by_mapQ );
+    paired_R_not_L_by_mapQ.merge( other.paired_R_not_L_by_mapQ );
+    unique_L_not_R_by_mapQ.merge( other.unique_L_not_R_by_mapQ );
+    unique_R_not_L_by_mapQ.merge( other.unique_R_not_L_by_mapQ );
+    ambiguous_L_not_R_by_mapQ.merge( other.ambiguous_L_not_R_by_mapQ );
+    ambiguous_R_not_L_by_mapQ.merge( other.ambiguous_R_not_L_by_mapQ );
+    n += other.n;
+    n_mismatched += other.n_mismatched;
+    n_different_ref12.merge( other.n_different_ref12 );
+    n_different_ref1.merge( other.n_different_ref1 );
+    n_different_ref2.merge( other.n_different_ref2 );
+    n_different_ref.merge( other.n_different_ref );
+    n_different_ref_unique.merge( other.n_different_ref_unique );
+    n_different_ref_not_ambiguous.merge( other.n_different_ref_not_ambiguous );
+    n_distant12.merge( other.n_distant12 );
+    n_distant1.merge( other.n_distant1 );
+    n_distant2.merge( other.n_distant2 );
+    n_distant.merge( other.n_distant );
+    n_distant_unique.merge( other.n_distant_unique );
+    n_distant_not_ambiguous.merge( other.n_distant_not_ambiguous );
+    n_discordant12.merge( other.n_discordant12 );
+    n_discordant1.merge( other.n_discordant1 );
+    n_discordant2.merge( other.n_discordant2 );
+    n_discordant.merge( other.n_discordant );
+    n_discordant_unique.merge( other.n_discordant_unique );
+    n_discordant_not_ambiguous.merge( other.n_discordant_not_ambiguous );
+    al_stats.merge( other.al_stats );
+    distant_stats.merge( other.distant_stats );
+    discordant_stats.merge( other.discordant_stats );
+    sec_score_by_score_l.merge( other.sec_score_by_score_l );
+    sec_score_by_score_r.merge( other.sec_score_by_score_r );
+    sec_ed_by_ed_l.merge( other.sec_ed_by_ed_l );
+    sec_ed_by_ed_r.merge( other.sec_ed_by_ed_r );
+}
+
 void PEAnalyzer::generate_report(const char* aln_file_nameL, const char* aln_file_nameR, const char* report)
 {
     if (report == NULL)
@@ -42,6 +42,10 @@ struct PEAnalyzer
         const AlignmentPair& alnL,
         const AlignmentPair& alnR);
 
+    // merge the statistics gathered by another analyzer (e.g. a shard)
+    //
+    void merge(const PEAnalyzer& other);
+
     void generate_report(const char* aln_file_nameL, const char* aln_file_nameR, const char* report);
 
     // flush any open files
@@ -0,0 +1,125 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio-aln-diff/pipeline.h>
+
+namespace nvbio {
+namespace alndiff {
+
+AlignmentLoader::AlignmentLoader(AlignmentStream* stream, const uint32 batch_size) :
+    m_stream( stream ),
+    m_batch_size( batch_size ),
+    m_loaded( 0 ),
+    m_released( 0 ),
+    m_done( false ),
+    m_consumed( 0 )
+{
+    m_batches[0].resize( batch_size );
+    m_batches[1].resize( batch_size );
+    m_sizes[0] = m_sizes[1] = 0;
+
+    create();
+}
+
+AlignmentLoader::~AlignmentLoader()
+{
+    // release all batches until the decoder is done
+    while (1)
+    {
+        {
+            ScopedLock lock( &m_lock );
+            m_released = m_loaded;
+            if (m_done)
+                break;
+        }
+        yield();
+    }
+    join();
+}
+
+uint32 AlignmentLoader::released()
+{
+    ScopedLock lock( &m_lock );
+    return m_released;
+}
+
+// decode the stream, staying at most two batches ahead of the consumer
+//
+void AlignmentLoader::run()
+{
+    for (uint32 i = 0; ; ++i)
+    {
+        // wait for the batch to be released
+        while (i - released() >= 2u)
+            yield();
+
+        const uint32 n = m_stream->next_batch( m_batch_size, &m_batches[i & 1u][0] );
+        m_sizes[i & 1u] = n;
+
+        ScopedLock lock( &m_lock );
+        if (n)
+            ++m_loaded;
+
+        if (n < m_batch_size)
+        {
+            m_done = true;
+            break;
+        }
+    }
+}
+
+// get the next batch, releasing the previous one
+//
+uint32 AlignmentLoader::next(const Alignment** batch)
+{
+    if (m_consumed)
+    {
+        ScopedLock lock( &m_lock );
+        m_released = m_consumed;
+    }
+
+    while (1)
+    {
+        {
+            ScopedLock lock( &m_lock );
+            if (m_loaded > m_consumed)
+                break;
+            if (m_done)
+                return 0u;
+        }
+        yield();
+    }
+
+    const uint32 slot = m_consumed & 1u;
+    ++m_consumed;
+
+    *batch = &m_batches[slot][0];
+    return m_sizes[slot];
+}
+
+} // alndiff namespace
+} // nvbio namespace
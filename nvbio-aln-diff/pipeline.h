@@ -0,0 +1,409 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio-aln-diff/alignment.h>
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/console.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace nvbio {
+namespace alndiff {
+
+///
+/// An alignment stream decoder running ahead of its consumer on a separate thread,
+/// using a pair of batches: one being decoded while the other one is consumed
+///
+struct AlignmentLoader : public Thread<AlignmentLoader>
+{
+    /// constructor: starts decoding
+    ///
+    AlignmentLoader(AlignmentStream* stream, const uint32 batch_size);
+
+    /// destructor: waits for the decoding thread
+    ///
+    ~AlignmentLoader();
+
+    /// get the next batch, which stays valid until the following call;
+    /// returns 0 at the end of the stream
+    ///
+    uint32 next(const Alignment** batch);
+
+    /// thread entry point
+    ///
+    void run();
+
+private:
+    uint32 released();
+
+    AlignmentStream*        m_stream;
+    uint32                  m_batch_size;
+    std::vector<Alignment>  m_batches[2];
+    uint32                  m_sizes[2];
+    Mutex                   m_lock;
+    volatile uint32         m_loaded;
+    volatile uint32         m_released;
+    volatile bool           m_done;
+    uint32                  m_consumed;
+};
+
+///
+/// A source of records to compare, either single alignments or alignment pairs
+///
+template <typename T>
+struct RecordSource
+{
+    /// virtual destructor
+    ///
+    virtual ~RecordSource() {}
+
+    /// fetch the next batch of records, returning its size (0 at the end of the input)
+    ///
+    virtual uint32 next(std::vector<T>& batch) = 0;
+};
+
+///
+/// Single-end alignments from a single file
+///
+struct AlignmentSource : public RecordSource<Alignment>
+{
+    AlignmentSource(AlignmentStream* stream, const uint32 batch_size) : m_loader( stream, batch_size ) {}
+
+    uint32 next(std::vector<Alignment>& batch)
+    {
+        const Alignment* alns;
+        const uint32 n = m_loader.next( &alns );
+        batch.assign( alns, alns + n );
+        return n;
+    }
+
+    AlignmentLoader m_loader;
+};
+
+///
+/// Paired-end alignments from a single file, where the two mates of each pair are stored consecutively
+///
+struct InterleavedPairSource : public RecordSource<AlignmentPair>
+{
+    InterleavedPairSource(AlignmentStream* stream, const uint32 batch_size, const char* file_name) :
+        m_loader( stream, batch_size & ~1u ), m_file_name( file_name ), m_offset( 0 ) {}
+
+    uint32 next(std::vector<AlignmentPair>& batch)
+    {
+        const Alignment* alns;
+        const uint32 n = m_loader.next( &alns );
+
+        batch.resize( n/2 );
+        for (uint32 i = 0; i + 1 < n; i += 2)
+        {
+            const Alignment* aln1 = &alns[i];
+            const Alignment* aln2 = &alns[i+1];
+
+            if (aln1->is_mapped() && aln1->mate == aln2->mate)
+            {
+                log_error(stderr, "alignments %llu and %llu in \"%s\" refer to the same mate, must come from different reads\n", m_offset + i, m_offset + i + 1, m_file_name);
+                exit(1);
+            }
+            if (aln1->mate) std::swap( aln1, aln2 );
+
+            batch[i/2] = AlignmentPair( *aln1, *aln2 );
+        }
+        m_offset += n;
+        return n/2;
+    }
+
+    AlignmentLoader m_loader;
+    const char*     m_file_name;
+    uint64          m_offset;
+};
+
+///
+/// Paired-end alignments from two files, one per mate, stored in the same order
+///
+struct SplitPairSource : public RecordSource<AlignmentPair>
+{
+    SplitPairSource(AlignmentStream* stream1, AlignmentStream* stream2, const uint32 batch_size) :
+        m_loader1( stream1, batch_size ), m_loader2( stream2, batch_size ) {}
+
+    uint32 next(std::vector<AlignmentPair>& batch)
+    {
+        const Alignment* alns1;
+        const Alignment* alns2;
+        const uint32 n1 = m_loader1.next( &alns1 );
+        const uint32 n2 = m_loader2.next( &alns2 );
+
+        if (n1 != n2)
+            log_warning(stderr, "mate files have different size\n");
+
+        const uint32 n = nvbio::min( n1, n2 );
+        batch.resize( n );
+        for (uint32 i = 0; i < n; ++i)
+            batch[i] = AlignmentPair( alns1[i], alns2[i] );
+
+        return n;
+    }
+
+    AlignmentLoader m_loader1;
+    AlignmentLoader m_loader2;
+};
+
+/// the key used to match a record with its counterpart
+///
+inline uint64 record_key(const Alignment& aln)      { return (uint64(aln.read_id) << 1) | (aln.mate & 1u); }
+inline uint64 record_key(const AlignmentPair& aln)  { return uint64(aln.read_id()); }
+
+///
+/// Match the records of the two inputs, either by position (if the inputs are known
+/// to be in identical order) or by read id.
+/// In the latter case, records whose counterpart has not been seen yet are kept pending;
+/// at most max_pending of them are kept, evicting the oldest ones as unmatched, so that
+/// memory stays bounded even when the two inputs are in completely different order.
+///
+template <typename T>
+struct RecordMatcher
+{
+    /// constructor
+    ///
+    /// \param by_id            match the records by read id rather than by position
+    /// \param max_pending      maximum number of pending records
+    ///
+    RecordMatcher(const bool by_id, const uint64 max_pending) :
+        m_by_id( by_id ), m_max_pending( max_pending ), m_seq( 0 )
+    {
+        unmatched[0] = unmatched[1] = 0;
+    }
+
+    /// match a new batch of records from each input, appending the matched pairs to outL/outR
+    ///
+    void match(
+        const std::vector<T>&   L,
+        const std::vector<T>&   R,
+        std::vector<T>&         outL,
+        std::vector<T>&         outR)
+    {
+        outL.resize(0);
+        outR.resize(0);
+
+        const uint32 nL = uint32( L.size() );
+        const uint32 nR = uint32( R.size() );
+
+        if (m_by_id == false)
+        {
+            const uint32 n = nvbio::min( nL, nR );
+            outL.insert( outL.end(), L.begin(), L.begin() + n );
+            outR.insert( outR.end(), R.begin(), R.begin() + n );
+            unmatched[0] += nL - n;
+            unmatched[1] += nR - n;
+            return;
+        }
+
+        // fast path: as long as nothing is pending, records in the same order pair up directly
+        uint32 i = 0;
+        if (m_pending[0].empty() && m_pending[1].empty())
+        {
+            const uint32 n = nvbio::min( nL, nR );
+            while (i < n && record_key( L[i] ) == record_key( R[i] ))
+                ++i;
+
+            outL.insert( outL.end(), L.begin(), L.begin() + i );
+            outR.insert( outR.end(), R.begin(), R.begin() + i );
+        }
+
+        // slow path: match the remaining records through the pending sets
+        for (uint32 j = i; j < nvbio::max( nL, nR ); ++j)
+        {
+            if (j < nL) push( L[j], 0u, outL, outR );
+            if (j < nR) push( R[j], 1u, outL, outR );
+        }
+
+        // drop the stale entries of the eviction queue
+        if (m_order.size() > 2u * (m_pending[0].size() + m_pending[1].size()) + nL + nR)
+        {
+            std::deque<Entry> order;
+            for (typename std::deque<Entry>::const_iterator it = m_order.begin(); it != m_order.end(); ++it)
+            {
+                typename Pending::const_iterator p = m_pending[it->side].find( it->key );
+                if (p != m_pending[it->side].end() && p->second.first == it->seq)
+                    order.push_back( *it );
+            }
+            m_order.swap( order );
+        }
+    }
+
+    /// mark all the records still pending as unmatched
+    ///
+    void finish()
+    {
+        unmatched[0] += m_pending[0].size();
+        unmatched[1] += m_pending[1].size();
+        m_pending[0].clear();
+        m_pending[1].clear();
+        m_order.clear();
+    }
+
+    /// return the number of records currently pending
+    ///
+    uint64 pending() const { return m_pending[0].size() + m_pending[1].size(); }
+
+    uint64 unmatched[2];
+
+private:
+    typedef std::map< uint64, std::pair<uint64,T> > Pending;
+
+    struct Entry
+    {
+        uint64 key;
+        uint64 seq;
+        uint32 side;
+    };
+
+    void push(const T& rec, const uint32 side, std::vector<T>& outL, std::vector<T>& outR)
+    {
+        const uint64 key = record_key( rec );
+
+        // look for the counterpart
+        typename Pending::iterator it = m_pending[1u - side].find( key );
+        if (it != m_pending[1u - side].end())
+        {
+            outL.push_back( side == 0u ? rec : it->second.second );
+            outR.push_back( side == 0u ? it->second.second : rec );
+            m_pending[1u - side].erase( it );
+            return;
+        }
+
+        // a duplicate key on the same side can't be matched
+        if (m_pending[side].find( key ) != m_pending[side].end())
+        {
+            ++unmatched[side];
+            return;
+        }
+
+        m_pending[side].insert( std::make_pair( key, std::make_pair( m_seq, rec ) ) );
+
+        const Entry e = { key, m_seq, side };
+        m_order.push_back( e );
+        ++m_seq;
+
+        // keep the pending sets bounded, evicting the oldest records
+        while (m_pending[0].size() + m_pending[1].size() > m_max_pending)
+        {
+            const Entry e = m_order.front();
+            m_order.pop_front();
+
+            typename Pending::iterator it = m_pending[e.side].find( e.key );
+            if (it != m_pending[e.side].end() && it->second.first == e.seq)
+            {
+                m_pending[e.side].erase( it );
+                ++unmatched[e.side];
+            }
+        }
+    }
+
+    bool                m_by_id;
+    uint64              m_max_pending;
+    uint64              m_seq;
+    Pending             m_pending[2];
+    std::deque<Entry>   m_order;
+};
+
+///
+/// Push matched records into a set of analyzer shards in parallel, each shard
+/// taking a contiguous slice of the batch
+///
+template <typename Analyzer, typename T>
+void analyze(
+    std::vector<Analyzer*>&     shards,
+    const std::vector<T>&       L,
+    const std::vector<T>&       R)
+{
+    const int32  n_shards = int32( shards.size() );
+    const uint64 n        = L.size();
+
+    #pragma omp parallel for
+    for (int32 s = 0; s < n_shards; ++s)
+    {
+        const uint64 begin = (n * uint64(s))     / uint64(n_shards);
+        const uint64 end   = (n * uint64(s + 1)) / uint64(n_shards);
+
+        Analyzer* analyzer = shards[s];
+        for (uint64 i = begin; i < end; ++i)
+            analyzer->push( L[i], R[i] );
+    }
+}
+
+///
+/// Run the comparison pipeline: the two inputs are decoded on separate threads,
+/// matched, and analyzed by a set of shards which are finally merged into the first one
+///
+template <typename Analyzer, typename T>
+void compare(
+    RecordSource<T>&            sourceL,
+    RecordSource<T>&            sourceR,
+    RecordMatcher<T>&           matcher,
+    std::vector<Analyzer*>&     shards)
+{
+    std::vector<T> batchL;
+    std::vector<T> batchR;
+    std::vector<T> matchedL;
+    std::vector<T> matchedR;
+
+    uint64 n_records = 0;
+    uint32 n_batch   = 0;
+    while (1)
+    {
+        const uint32 batch_sizeL = sourceL.next( batchL );
+        const uint32 batch_sizeR = sourceR.next( batchR );
+        if (batch_sizeL == 0 && batch_sizeR == 0)
+            break;
+
+        matcher.match( batchL, batchR, matchedL, matchedR );
+
+        analyze( shards, matchedL, matchedR );
+
+        n_records += matchedL.size();
+        log_info(stderr, "analizing batch[%u]: %u records matched (%.1f M), %llu pending\n", n_batch, uint32( matchedL.size() ), float(n_records)*1.0e-6f, matcher.pending());
+        ++n_batch;
+    }
+    matcher.finish();
+
+    if (matcher.unmatched[0] || matcher.unmatched[1])
+        log_warning(stderr, "unmatched records: %llu [L], %llu [R]\n", matcher.unmatched[0], matcher.unmatched[1]);
+
+    // merge all the shards into the first one, counting the unmatched records as mismatches
+    for (uint32 s = 1; s < shards.size(); ++s)
+        shards[0]->merge( *shards[s] );
+
+    shards[0]->n_mismatched += uint32( nvbio::max( matcher.unmatched[0], matcher.unmatched[1] ) );
+}
+
+} // namespace alndiff
+} // namespace nvbio
@@ -167,6 +167,28 @@ void generate_summary_cell(FILE* html_output, const std::string file_name, const
 
 } // anonymous namespace
 
+void SEAnalyzer::merge(const SEAnalyzer& other)
+{
+    mapped.merge( other.mapped );
+    unique.merge( other.unique );
+    ambiguous.merge( other.ambiguous );
+    not_ambiguous.merge( other.not_ambiguous );
+    mapped_L_not_R_by_mapQ.merge( other.mapped_L_not_R_by_mapQ );
+    mapped_R_not_L_by_mapQ.merge( other.mapped_R_not_L_by_mapQ );
+    unique_L_not_R_by_mapQ.merge( other.unique_L_not_R_by_mapQ );
+    unique_R_not_L_by_mapQ.merge( other.unique_R_not_L_by_mapQ );
+    ambiguous_L_not_R_by_mapQ.merge( other.ambiguous_L_not_R_by_mapQ );
+    ambiguous_R_not_L_by_mapQ.merge( other.ambiguous_R_not_L_by_mapQ );
+    n += other.n;
+    n_mismatched += other.n_mismatched;
+    n_different_ref.merge( other.n_different_ref );
+    n_distant.merge( other.n_distant );
+    n_discordant.merge( other.n_discordant );
+    al_stats.merge( other.al_stats );
+    distant_stats.merge( other.distant_stats );
+    discordant_stats.merge( other.discordant_stats );
+}
+
 void SEAnalyzer::generate_report(const char* aln_file_name1, const char* aln_file_name2, const char* report)
 {
     if (report == NULL)
@@ -42,6 +42,10 @@ struct SEAnalyzer
         const Alignment& aln1,
         const Alignment& aln2);
 
+    // merge the statistics gathered by another analyzer (e.g. a shard)
+    //
+    void merge(const SEAnalyzer& other);
+
     void generate_report(const char* aln_file_name1, const char* aln_file_name2, const char* report);
 
     // flush any open files
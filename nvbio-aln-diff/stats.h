@@ -47,6 +47,19 @@ struct StatsPartition
     Histogram2d<32,10>  diff_hist_by_value_pos;
     Histogram2d<7,12>   diff_hist_by_mapQ1;
     Histogram2d<7,12>   diff_hist_by_mapQ2;
+
+    void merge(const StatsPartition& other)
+    {
+        hist.merge( other.hist );
+        hist_by_length.merge( other.hist_by_length );
+        hist_by_mapQ.merge( other.hist_by_mapQ );
+        diff_hist.merge( other.diff_hist );
+        diff_hist_by_length.merge( other.diff_hist_by_length );
+        diff_hist_by_value_neg.merge( other.diff_hist_by_value_neg );
+        diff_hist_by_value_pos.merge( other.diff_hist_by_value_pos );
+        diff_hist_by_mapQ1.merge( other.diff_hist_by_mapQ1 );
+        diff_hist_by_mapQ2.merge( other.diff_hist_by_mapQ2 );
+    }
 };
 
 template <Type TYPE_T, Bins BINS_T>
@@ -129,6 +142,12 @@ struct Stats
         }
     }
 
+    void merge(const Stats& other)
+    {
+        l.merge( other.l );
+        r.merge( other.r );
+    }
+
     Partition   l;
     Partition   r;
 };
@@ -144,6 +163,19 @@ struct AlignmentStats
     Stats<LOWER,LINEAR>        lower_ins;
     Stats<LOWER,LINEAR>        lower_dels;
     Stats<LOWER,LINEAR>        lower_mms;
+
+    void merge(const AlignmentStats& other)
+    {
+        higher_score.merge( other.higher_score );
+        lower_ed.merge( other.lower_ed );
+        higher_mapQ.merge( other.higher_mapQ );
+        longer_mapping.merge( other.longer_mapping );
+        higher_pos.merge( other.higher_pos );
+        lower_subs.merge( other.lower_subs );
+        lower_ins.merge( other.lower_ins );
+        lower_dels.merge( other.lower_dels );
+        lower_mms.merge( other.lower_mms );
+    }
 };
 
 } // namespace alndiff
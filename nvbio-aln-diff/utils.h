@@ -55,6 +55,16 @@ struct BooleanStats
     float avg_R_not_L() const { return n ? float(R_not_L) / float(n) : 0.0f; }
     float avg_L_and_R() const { return n ? float(L_and_R) / float(n) : 0.0f; }
 
+    void merge(const BooleanStats& other)
+    {
+        L       += other.L;
+        R       += other.R;
+        L_not_R += other.L_not_R;
+        R_not_L += other.R_not_L;
+        L_and_R += other.L_and_R;
+        n       += other.n;
+    }
+
     uint32 L;
     uint32 R;
     uint32 L_not_R;
@@ -83,6 +93,13 @@ struct Histogram
         ++count;
     }
 
+    void merge(const Histogram& other)
+    {
+        for (uint32 i = 0; i < 2*X; ++i)
+            bins[i] += other.bins[i];
+        count += other.count;
+    }
+
     uint32  count;
     uint32  bins[2*X];
 };
@@ -129,6 +146,14 @@ struct Histogram2d
     }
     uint32 operator() (const int32 i, const int32 j) const { return bins[i + X][j + Y]; }
 
+    void merge(const Histogram2d& other)
+    {
+        for (uint32 i = 0; i < 2*X; ++i)
+            for (uint32 j = 0; j < 2*Y; ++j)
+                bins[i][j] += other.bins[i][j];
+        count += other.count;
+    }
+
     uint32  count;
     uint32  bins[2*X][2*Y];
 };
@@ -0,0 +1,161 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// alignment_bench.cu
+//
+
+#include "bench.h"
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/vector_view.h>
+#include <nvbio/alignment/alignment.h>
+#include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/utils.h>
+#include <vector>
+
+namespace nvbio {
+namespace bench {
+
+namespace {
+
+// score a batch of fixed-size pattern/text pairs with a given aligner
+//
+template <typename aligner_type>
+struct AlignmentScore
+{
+    typedef typename aln::column_storage_type<aligner_type>::type cell_type;
+
+    AlignmentScore(
+        const aligner_type          _aligner,
+        const uint32                _n_pairs,
+        const uint32                _M,
+        const uint32                _N,
+        const std::vector<uint8>&   _patterns,
+        const std::vector<uint8>&   _texts) :
+        aligner( _aligner ), n_pairs( _n_pairs ), M( _M ), N( _N ), patterns( _patterns ), texts( _texts ), checksum(0) {}
+
+    void operator() ()
+    {
+        int64 sum = 0;
+
+        #pragma omp parallel reduction(+:sum)
+        {
+            // per-thread column storage, large enough for both the pattern and the text
+            std::vector<cell_type> column( nvbio::max( M, N ) );
+
+            #pragma omp for
+            for (int32 i = 0; i < int32( n_pairs ); ++i)
+            {
+                aln::BestSink<int32> sink;
+                aln::alignment_score(
+                    aligner,
+                    vector_view<const uint8*>( M, &patterns[ i*M ] ),
+                    aln::trivial_quality_string(),
+                    vector_view<const uint8*>( N, &texts[ i*N ] ),
+                    Field_traits<int32>::min(),
+                    sink,
+                    &column[0] );
+
+                sum += sink.score;
+            }
+        }
+        checksum = sum;
+    }
+
+    const aligner_type          aligner;
+    const uint32                n_pairs;
+    const uint32                M;
+    const uint32                N;
+    const std::vector<uint8>&   patterns;
+    const std::vector<uint8>&   texts;
+    int64                       checksum;
+};
+
+// run a single aligner benchmark
+//
+template <typename aligner_type>
+void run_alignment(
+    BenchRunner&                runner,
+    const char*                 name,
+    const aligner_type          aligner,
+    const uint32                n_pairs,
+    const uint32                M,
+    const uint32                N,
+    const std::vector<uint8>&   patterns,
+    const std::vector<uint8>&   texts)
+{
+    AlignmentScore<aligner_type> body( aligner, n_pairs, M, N, patterns, texts );
+    runner.run( name, "GCUPS", 1.0e-9 * double( n_pairs ) * double( M ) * double( N ), body );
+}
+
+} // anonymous namespace
+
+// DP alignment benchmarks
+//
+void alignment_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "alignment" ) == false)
+        return;
+
+    const uint32 M       = 150u;
+    const uint32 N       = 300u;
+    const uint32 n_pairs = runner.scaled( 4096u );
+
+    std::vector<uint8> patterns( n_pairs * M );
+    std::vector<uint8> texts( n_pairs * N );
+
+    // plant each pattern in its text with a few random edits, to mimic candidate verification
+    make_dna( n_pairs * N, runner.options().seed, &texts[0] );
+    {
+        BenchRandom random( runner.options().seed + 1u );
+        for (uint32 i = 0; i < n_pairs; ++i)
+        {
+            const uint32 offset = random.next( N - M );
+            for (uint32 j = 0; j < M; ++j)
+                patterns[ i*M + j ] = random.next(32u) ? texts[ i*N + offset + j ] : uint8( random.next(4u) );
+        }
+    }
+
+    aln::SimpleSmithWatermanScheme sw_scoring;
+    sw_scoring.m_match     =  2;
+    sw_scoring.m_mismatch  = -1;
+    sw_scoring.m_deletion  = -1;
+    sw_scoring.m_insertion = -1;
+
+    aln::SimpleGotohScheme gotoh_scoring;
+    gotoh_scoring.m_match    =  2;
+    gotoh_scoring.m_mismatch = -3;
+    gotoh_scoring.m_gap_open = -5;
+    gotoh_scoring.m_gap_ext  = -2;
+
+    run_alignment( runner, "alignment/sw-local",        aln::make_smith_waterman_aligner<aln::LOCAL>( sw_scoring ), n_pairs, M, N, patterns, texts );
+    run_alignment( runner, "alignment/gotoh-local",     aln::make_gotoh_aligner<aln::LOCAL>( gotoh_scoring ),       n_pairs, M, N, patterns, texts );
+    run_alignment( runner, "alignment/ed-semi-global",  aln::make_edit_distance_aligner<aln::SEMI_GLOBAL>(),        n_pairs, M, N, patterns, texts );
+}
+
+} // namespace bench
+} // namespace nvbio
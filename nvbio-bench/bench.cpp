@@ -0,0 +1,229 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// bench.cpp
+//
+
+#include "bench.h"
+#include <nvbio/basic/version.h>
+#include <nvbio/basic/numbers.h>
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+
+namespace nvbio {
+namespace bench {
+
+// return true if the given benchmark (or group, if used as a prefix) is selected
+//
+bool BenchRunner::enabled(const char* name) const
+{
+    if (m_options.filter == NULL)
+        return true;
+
+    // the filter selects all benchmarks it is a prefix of, and the group they belong to
+    const uint32 name_len   = uint32( strlen( name ) );
+    const uint32 filter_len = uint32( strlen( m_options.filter ) );
+    return strncmp( name, m_options.filter, nvbio::min( name_len, filter_len ) ) == 0;
+}
+
+// scale a dataset size by the global scaling factor
+//
+uint32 BenchRunner::scaled(const uint32 size) const
+{
+    return nvbio::max( uint32( float(size) * m_options.scale ), 1u );
+}
+
+// record the timings of a benchmark run
+//
+void BenchRunner::record(const char* name, const char* unit, const double work, std::vector<double>& times)
+{
+    BenchResult result;
+    result.name = name;
+    result.unit = unit;
+    result.work = work;
+    result.reps = uint32( times.size() );
+
+    if (times.empty())
+    {
+        result.min_time    = 0.0;
+        result.median_time = 0.0;
+        result.mean_time   = 0.0;
+        result.max_time    = 0.0;
+    }
+    else
+    {
+        std::sort( times.begin(), times.end() );
+
+        const size_t n = times.size();
+
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i)
+            sum += times[i];
+
+        result.min_time    = times.front();
+        result.max_time    = times.back();
+        result.mean_time   = sum / double(n);
+        result.median_time = (n & 1) ? times[n/2] : (times[n/2-1] + times[n/2]) * 0.5;
+    }
+
+    log_info(stderr, "  %-28s : %10.2f %-8s (best %10.2f, median %.4fs, %u reps)\n",
+        name,
+        result.throughput(), unit,
+        result.peak_throughput(),
+        result.median_time,
+        result.reps );
+
+    m_results.push_back( result );
+}
+
+namespace {
+
+// write a JSON-escaped string
+//
+void json_string(FILE* file, const std::string& str)
+{
+    fputc( '"', file );
+    for (size_t i = 0; i < str.length(); ++i)
+    {
+        const char c = str[i];
+        if (c == '"' || c == '\\')
+            fprintf( file, "\\%c", c );
+        else if ((unsigned char)c < 0x20)
+            fprintf( file, "\\u%04x", uint32( (unsigned char)c ) );
+        else
+            fputc( c, file );
+    }
+    fputc( '"', file );
+}
+
+} // anonymous namespace
+
+// write the results in JSON format
+//
+bool write_json(const char* filename, const BenchOptions& options, const std::vector<BenchResult>& results)
+{
+    FILE* file = strcmp( filename, "-" ) == 0 ? stdout : fopen( filename, "w" );
+    if (file == NULL)
+    {
+        log_error(stderr, "unable to open \"%s\" for writing\n", filename);
+        return false;
+    }
+
+    fprintf( file, "{\n" );
+    fprintf( file, "  \"version\" : \"%u.%u.%u\",\n", NVBIO_MAJOR_VERSION, NVBIO_MINOR_VERSION, NVBIO_VERSION % 100 );
+    fprintf( file, "  \"options\" : { \"warmup\" : %u, \"reps\" : %u, \"scale\" : %g, \"seed\" : %u, \"threads\" : %u },\n",
+        options.warmup,
+        options.reps,
+        options.scale,
+        options.seed,
+        options.threads );
+    fprintf( file, "  \"results\" : [\n" );
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& r = results[i];
+
+        fprintf( file, "    { \"name\" : " );
+        json_string( file, r.name );
+        fprintf( file, ", \"unit\" : " );
+        json_string( file, r.unit );
+        fprintf( file, ", \"throughput\" : %.6g, \"peak_throughput\" : %.6g, \"work\" : %.6g, \"reps\" : %u, \"min_time\" : %.6g, \"median_time\" : %.6g, \"mean_time\" : %.6g, \"max_time\" : %.6g }%s\n",
+            r.throughput(),
+            r.peak_throughput(),
+            r.work,
+            r.reps,
+            r.min_time,
+            r.median_time,
+            r.mean_time,
+            r.max_time,
+            i+1 < results.size() ? "," : "" );
+    }
+    fprintf( file, "  ]\n" );
+    fprintf( file, "}\n" );
+
+    if (file != stdout)
+        fclose( file );
+    return true;
+}
+
+// write the results in CSV format
+//
+bool write_csv(const char* filename, const std::vector<BenchResult>& results)
+{
+    FILE* file = strcmp( filename, "-" ) == 0 ? stdout : fopen( filename, "w" );
+    if (file == NULL)
+    {
+        log_error(stderr, "unable to open \"%s\" for writing\n", filename);
+        return false;
+    }
+
+    fprintf( file, "name,unit,throughput,peak_throughput,work,reps,min_time,median_time,mean_time,max_time\n" );
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchResult& r = results[i];
+
+        fprintf( file, "%s,%s,%.6g,%.6g,%.6g,%u,%.6g,%.6g,%.6g,%.6g\n",
+            r.name.c_str(),
+            r.unit.c_str(),
+            r.throughput(),
+            r.peak_throughput(),
+            r.work,
+            r.reps,
+            r.min_time,
+            r.median_time,
+            r.mean_time,
+            r.max_time );
+    }
+
+    if (file != stdout)
+        fclose( file );
+    return true;
+}
+
+// generate a random DNA string, in 2-bit encoding
+//
+void make_dna(const uint32 len, const uint32 seed, uint8* dna)
+{
+    BenchRandom random( seed );
+    for (uint32 i = 0; i < len; ++i)
+        dna[i] = uint8( random.next(4u) );
+}
+
+// generate a random DNA string, in ASCII
+//
+void make_dna_string(const uint32 len, const uint32 seed, char* dna)
+{
+    static const char ACGT[4] = { 'A', 'C', 'G', 'T' };
+
+    BenchRandom random( seed );
+    for (uint32 i = 0; i < len; ++i)
+        dna[i] = ACGT[ random.next(4u) ];
+}
+
+} // namespace bench
+} // namespace nvbio
@@ -0,0 +1,212 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// bench.h
+//
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/console.h>
+#include <vector>
+#include <string>
+
+namespace nvbio {
+namespace bench {
+
+/// The global benchmarking options
+///
+struct BenchOptions
+{
+    BenchOptions() :
+        warmup( 1u ),
+        reps( 5u ),
+        scale( 1.0f ),
+        seed( 1u ),
+        threads( 1u ),
+        filter( NULL ),
+        tmp_dir( "." ) {}
+
+    uint32      warmup;     ///< number of untimed warm-up runs
+    uint32      reps;       ///< number of timed repetitions
+    float       scale;      ///< dataset scaling factor
+    uint32      seed;       ///< random seed used to generate the synthetic datasets
+    uint32      threads;    ///< number of host threads
+    const char* filter;     ///< optional prefix selecting the benchmarks to run
+    const char* tmp_dir;    ///< directory used for the temporary files of I/O benchmarks
+};
+
+/// The result of a single benchmark
+///
+struct BenchResult
+{
+    std::string name;       ///< the benchmark name, in the form group/test
+    std::string unit;       ///< the throughput unit
+    double      work;       ///< the amount of work performed by each repetition, in units
+    uint32      reps;       ///< number of timed repetitions
+    double      min_time;   ///< minimum repetition time, in seconds
+    double      median_time;///< median repetition time, in seconds
+    double      mean_time;  ///< mean repetition time, in seconds
+    double      max_time;   ///< maximum repetition time, in seconds
+
+    /// the throughput measured on the median repetition
+    ///
+    double throughput() const { return median_time > 0.0 ? work / median_time : 0.0; }
+
+    /// the throughput measured on the fastest repetition
+    ///
+    double peak_throughput() const { return min_time > 0.0 ? work / min_time : 0.0; }
+};
+
+/// The benchmark runner: it applies the warm-up/repetition policy to each benchmark
+/// and collects the results.
+///
+/// A benchmark body is any functor exposing:
+///
+/// \code
+/// void operator() ();
+/// \endcode
+///
+/// while the amount of work (e.g. bytes, queries or cells) performed by each call
+/// is passed explicitly, together with the unit scaling used for reporting.
+///
+struct BenchRunner
+{
+    /// constructor
+    ///
+    BenchRunner(const BenchOptions& options) : m_options( options ) {}
+
+    /// return the options
+    ///
+    const BenchOptions& options() const { return m_options; }
+
+    /// return true if the given benchmark (or group, if used as a prefix) is selected
+    ///
+    bool enabled(const char* name) const;
+
+    /// scale a dataset size by the global scaling factor
+    ///
+    uint32 scaled(const uint32 size) const;
+
+    /// run a benchmark
+    ///
+    /// \param name         benchmark name, in the form group/test
+    /// \param unit         throughput unit, e.g. "MB/s"
+    /// \param work         amount of work per repetition, in the throughput unit numerator (e.g. MB)
+    /// \param body         the benchmark body
+    ///
+    template <typename Functor>
+    void run(const char* name, const char* unit, const double work, Functor& body)
+    {
+        if (enabled( name ) == false)
+            return;
+
+        log_verbose(stderr, "  %s... started\n", name);
+
+        for (uint32 i = 0; i < m_options.warmup; ++i)
+            body();
+
+        std::vector<double> times( m_options.reps );
+        for (uint32 i = 0; i < m_options.reps; ++i)
+        {
+            Timer timer;
+            timer.start();
+
+            body();
+
+            timer.stop();
+            times[i] = timer.seconds();
+        }
+
+        record( name, unit, work, times );
+    }
+
+    /// record the timings of a benchmark run
+    ///
+    void record(const char* name, const char* unit, const double work, std::vector<double>& times);
+
+    /// return the collected results
+    ///
+    const std::vector<BenchResult>& results() const { return m_results; }
+
+private:
+    BenchOptions             m_options;
+    std::vector<BenchResult> m_results;
+};
+
+/// write the results in JSON format
+///
+bool write_json(const char* filename, const BenchOptions& options, const std::vector<BenchResult>& results);
+
+/// write the results in CSV format
+///
+bool write_csv(const char* filename, const std::vector<BenchResult>& results);
+
+/// A simple, platform independent LCG used to generate reproducible synthetic datasets
+///
+struct BenchRandom
+{
+    BenchRandom(const uint32 seed) : m_state( uint64(seed) * 2654435761u + 1u ) {}
+
+    /// return the next 32-bit random number
+    ///
+    uint32 next()
+    {
+        m_state = m_state * uint64(6364136223846793005ull) + uint64(1442695040888963407ull);
+        return uint32( m_state >> 33 );
+    }
+
+    /// return a random number in [0,n)
+    ///
+    uint32 next(const uint32 n) { return next() % n; }
+
+private:
+    uint64 m_state;
+};
+
+/// generate a random DNA string, in 2-bit encoding
+///
+void make_dna(const uint32 len, const uint32 seed, uint8* dna);
+
+/// generate a random DNA string, in ASCII
+///
+void make_dna_string(const uint32 len, const uint32 seed, char* dna);
+
+// the individual benchmark groups
+void fastq_bench(BenchRunner& runner);
+void packing_bench(BenchRunner& runner);
+void bgzf_bench(BenchRunner& runner);
+void fmindex_bench(BenchRunner& runner);
+void qgram_bench(BenchRunner& runner);
+void alignment_bench(BenchRunner& runner);
+void pipeline_bench(BenchRunner& runner);
+void bloom_bench(BenchRunner& runner);
+
+} // namespace bench
+} // namespace nvbio
@@ -0,0 +1,220 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// bloom_bench.cpp
+//
+
+#include "bench.h"
+#include <nvbio/basic/bloom_filter.h>
+#include <nvbio/basic/numbers.h>
+#include <stdio.h>
+#include <vector>
+
+namespace nvbio {
+namespace bench {
+
+namespace {
+
+struct hash_functor1
+{
+    uint64 operator() (const uint64 kmer) const { return nvbio::hash( kmer ); }
+};
+struct hash_functor2
+{
+    uint64 operator() (const uint64 kmer) const { return nvbio::hash2( kmer ); }
+};
+
+typedef blocked_bloom_filter<hash_functor1, hash_functor2, uint64_2*>       filter_type;
+typedef blocked_bloom_filter<hash_functor1, hash_functor2, const uint64_2*> const_filter_type;
+
+static const uint32 BLOOM_K     = 8u;     // the number of hashes used by nvLighter's trusted kmer filter
+static const uint32 BLOOM_KMER  = 31u;    // the kmer length
+
+// extract the rolling 2-bit codes of all the kmers of a random DNA string
+//
+void make_kmers(const uint32 n_kmers, const uint32 seed, std::vector<uint64>& kmers)
+{
+    const uint32 len   = n_kmers + BLOOM_KMER - 1u;
+    const uint64 kmask = (uint64(1u) << (BLOOM_KMER*2)) - 1u;
+
+    std::vector<uint8> dna( len );
+    make_dna( len, seed, &dna[0] );
+
+    kmers.resize( n_kmers );
+
+    uint64 kmer = 0u;
+    for (uint32 i = 0; i < len; ++i)
+    {
+        kmer = ((kmer << 2) | dna[i]) & kmask;
+        if (i + 1u >= BLOOM_KMER)
+            kmers[ i + 1u - BLOOM_KMER ] = kmer;
+    }
+}
+
+// insert a set of keys one at a time
+//
+struct BloomInsert
+{
+    BloomInsert(const filter_type _filter, const std::vector<uint64>& _keys) : filter( _filter ), keys( _keys ) {}
+
+    void operator() ()
+    {
+        for (uint32 i = 0; i < uint32( keys.size() ); ++i)
+            filter.insert( keys[i] );
+    }
+
+    filter_type                 filter;
+    const std::vector<uint64>&  keys;
+};
+
+// insert a set of keys in prefetched batches
+//
+struct BloomInsertBatched
+{
+    BloomInsertBatched(const filter_type _filter, const std::vector<uint64>& _keys) : filter( _filter ), keys( _keys ) {}
+
+    void operator() ()
+    {
+        bloom_filter_insert_batch( filter, uint32( keys.size() ), &keys[0] );
+    }
+
+    filter_type                 filter;
+    const std::vector<uint64>&  keys;
+};
+
+// look up a set of keys one at a time
+//
+struct BloomHas
+{
+    BloomHas(const const_filter_type _filter, const std::vector<uint64>& _keys) : filter( _filter ), keys( _keys ), hits( 0u ) {}
+
+    void operator() ()
+    {
+        uint32 n_hits = 0;
+        for (uint32 i = 0; i < uint32( keys.size() ); ++i)
+            n_hits += filter.has( keys[i] ) ? 1u : 0u;
+
+        hits = n_hits;
+    }
+
+    const_filter_type           filter;
+    const std::vector<uint64>&  keys;
+    uint32                      hits;
+};
+
+// look up a set of keys in prefetched batches
+//
+struct BloomHasBatched
+{
+    BloomHasBatched(const const_filter_type _filter, const std::vector<uint64>& _keys) :
+        filter( _filter ), keys( _keys ), found( _keys.size() ), hits( 0u ) {}
+
+    void operator() ()
+    {
+        hits = bloom_filter_has_batch( filter, uint32( keys.size() ), &keys[0], &found[0] );
+    }
+
+    const_filter_type           filter;
+    const std::vector<uint64>&  keys;
+    std::vector<uint8>          found;
+    uint32                      hits;
+};
+
+} // anonymous namespace
+
+// Bloom filter benchmarks: insertion and lookup throughput, probing keys one at a time
+// or in prefetched batches, for filters ranging from cache-resident to a few hundred MBs
+//
+void bloom_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "bloom" ) == false)
+        return;
+
+    const uint32 n_keys = runner.scaled( 4u*1024u*1024u );
+
+    // the inserted kmers, and a disjoint set of kmers used as negative queries
+    std::vector<uint64> keys;
+    std::vector<uint64> queries;
+    make_kmers( n_keys, runner.options().seed,      keys );
+    make_kmers( n_keys, runner.options().seed + 1u, queries );
+
+    // mix positive and negative queries
+    for (uint32 i = 0; i < n_keys; i += 2)
+        queries[i] = keys[i];
+
+    const uint32 filter_mbs[] = { 4u, 64u, 512u };
+
+    for (uint32 f = 0; f < sizeof(filter_mbs) / sizeof(uint32); ++f)
+    {
+        const uint64 filter_bytes = uint64( runner.scaled( filter_mbs[f] * 1024u ) ) * 1024u;
+        const uint64 filter_bits  = filter_bytes * 8u;
+
+        char insert_name[64];
+        char insert_batched_name[64];
+        char has_name[64];
+        char has_batched_name[64];
+        sprintf( insert_name,         "bloom/insert-%uMB",         filter_mbs[f] );
+        sprintf( insert_batched_name, "bloom/insert-batched-%uMB", filter_mbs[f] );
+        sprintf( has_name,            "bloom/has-%uMB",            filter_mbs[f] );
+        sprintf( has_batched_name,    "bloom/has-batched-%uMB",    filter_mbs[f] );
+
+        if (runner.enabled( insert_name )         == false &&
+            runner.enabled( insert_batched_name ) == false &&
+            runner.enabled( has_name )            == false &&
+            runner.enabled( has_batched_name )    == false)
+            continue;
+
+        std::vector<uint64_2> storage( filter_bytes / sizeof(uint64_2) );
+
+        const filter_type       filter( BLOOM_K, filter_bits, &storage[0] );
+        const const_filter_type const_filter( BLOOM_K, filter_bits, &storage[0] );
+
+        const double mprobes = 1.0e-6 * double( n_keys );
+
+        BloomInsert insert( filter, keys );
+        runner.run( insert_name, "Mprobes/s", mprobes, insert );
+
+        BloomInsertBatched insert_batched( filter, keys );
+        runner.run( insert_batched_name, "Mprobes/s", mprobes, insert_batched );
+
+        // make sure the filter is populated even if insertion was filtered out
+        insert_batched();
+
+        BloomHas has( const_filter, queries );
+        runner.run( has_name, "Mprobes/s", mprobes, has );
+
+        BloomHasBatched has_batched( const_filter, queries );
+        runner.run( has_batched_name, "Mprobes/s", mprobes, has_batched );
+
+        if (runner.enabled( has_name ) && runner.enabled( has_batched_name ) && has.hits != has_batched.hits)
+            log_warning(stderr, "  bloom: batched lookups found %u keys, expected %u\n", has_batched.hits, has.hits);
+    }
+}
+
+} // namespace bench
+} // namespace nvbio
@@ -0,0 +1,396 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// index_bench.cu
+//
+
+#include "bench.h"
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/vector.h>
+#include <nvbio/basic/packedstream.h>
+#include <nvbio/fmindex/bwt.h>
+#include <nvbio/fmindex/fmindex.h>
+#include <nvbio/qgram/qgram.h>
+#include <thrust/host_vector.h>
+#include <thrust/transform.h>
+#include <thrust/sort.h>
+#include <thrust/reduce.h>
+#include <thrust/scan.h>
+#include <thrust/binary_search.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
+#include <vector>
+
+namespace nvbio {
+namespace bench {
+
+namespace {
+
+const uint32 OCC_INT = 64u;
+const uint32 PLEN    = 20u;
+
+typedef PackedStream<uint32*,uint8,2u,true,uint32>                              packed_stream_type;
+typedef PackedStream<const uint32*,uint8,2u,true,uint32>                        bwt_type;
+typedef rank_dictionary<2u, OCC_INT, bwt_type, const uint32*, const uint32*>    rank_dict_type;
+typedef fm_index<rank_dict_type, ssa_nop>                                       fm_index_type;
+typedef fm_index_type::range_type                                               range_type;
+
+// the host-side storage of a synthetic FM-index
+//
+struct FMIndexData
+{
+    uint32                      len;
+    uint32                      primary;
+    thrust::host_vector<uint32> text;
+    thrust::host_vector<uint32> bwt;
+    thrust::host_vector<uint32> occ;
+    thrust::host_vector<uint32> L2;
+    thrust::host_vector<uint32> count_table;
+
+    // build the index of a random text
+    //
+    void build(const uint32 _len, const uint32 seed)
+    {
+        len = _len;
+
+        const uint32 WORDS     = util::divide_ri( len, 16u );
+        const uint32 OCC_WORDS = util::divide_ri( len, OCC_INT ) * 4u;
+
+        text.resize( align<4>( WORDS ), 0u );
+        bwt.resize( align<4>( WORDS ), 0u );
+        occ.resize( align<4>( OCC_WORDS ), 0u );
+        L2.resize( 5 );
+        count_table.resize( 256 );
+
+        packed_stream_type text_stream( &text[0] );
+
+        BenchRandom random( seed );
+        for (uint32 i = 0; i < len; ++i)
+            text_stream[i] = random.next(4u);
+
+        std::vector<int32> sa( len+1, 0u );
+        gen_sa( len, text_stream, &sa[0] );
+
+        packed_stream_type bwt_stream( &bwt[0] );
+        primary = gen_bwt_from_sa( len, text_stream, &sa[0], bwt_stream );
+
+        build_occurrence_table<2u,OCC_INT>(
+            bwt_stream,
+            bwt_stream + len,
+            &occ[0],
+            &L2[1] );
+
+        // transform the L2 table into a cumulative sum
+        L2[0] = 0;
+        for (uint32 c = 0; c < 4; ++c)
+            L2[c+1] += L2[c];
+
+        gen_bwt_count_table( &count_table[0] );
+    }
+
+    // return an FM-index view
+    //
+    fm_index_type index() const
+    {
+        return fm_index_type(
+            len,
+            primary,
+            &L2[0],
+            rank_dict_type(
+                bwt_type( &bwt[0] ),
+                &occ[0],
+                &count_table[0] ),
+            ssa_nop() );
+    }
+};
+
+// perform a batch of single character rank queries
+//
+struct FMRank
+{
+    FMRank(const fm_index_type _fmi, const std::vector<uint32>& _queries) : fmi( _fmi ), queries( _queries ), checksum(0) {}
+
+    void operator() ()
+    {
+        const int32 n_queries = int32( queries.size() );
+
+        uint64 sum = 0;
+        #pragma omp parallel for reduction(+:sum)
+        for (int32 i = 0; i < n_queries; ++i)
+            sum += rank( fmi.rank_dict(), queries[i], queries[i] & 3u );
+
+        checksum = sum;
+    }
+
+    const fm_index_type         fmi;
+    const std::vector<uint32>&  queries;
+    uint64                      checksum;
+};
+
+// perform a batch of exact backward searches
+//
+struct FMBackwardSearch
+{
+    FMBackwardSearch(const fm_index_type _fmi, const std::vector<uint8>& _patterns) : fmi( _fmi ), patterns( _patterns ), n_hits(0) {}
+
+    void operator() ()
+    {
+        const int32 n_patterns = int32( patterns.size() / PLEN );
+
+        uint64 hits = 0;
+        #pragma omp parallel for reduction(+:hits)
+        for (int32 i = 0; i < n_patterns; ++i)
+        {
+            const range_type range = match( fmi, &patterns[ i*PLEN ], PLEN );
+            hits += range.y >= range.x ? 1u : 0u;
+        }
+
+        if (hits != uint64( n_patterns ))
+            log_warning(stderr, "  fm-index/backward-search: %llu out of %d patterns not found\n", uint64( n_patterns ) - hits, n_patterns);
+
+        n_hits = hits;
+    }
+
+    const fm_index_type         fmi;
+    const std::vector<uint8>&   patterns;
+    uint64                      n_hits;
+};
+
+// build a host-side q-gram index, following the same procedure of QGramIndexDevice::build()
+//
+struct QGramBuild
+{
+    typedef const uint32*                                       word_iterator;
+    typedef PackedStream<word_iterator,uint8,2u,true,uint32>    string_type;
+
+    QGramBuild(
+        const uint32                        _Q,
+        const uint32                        _QL,
+        const uint32                        _string_len,
+        const thrust::host_vector<uint32>&  _string,
+        QGramIndexHost&                     _qgram_index) :
+        Q( _Q ), QL( _QL ), string_len( _string_len ), string( _string ), qgram_index( _qgram_index ) {}
+
+    void operator() ()
+    {
+        typedef QGramIndexHost::qgram_type qgram_type;
+
+        qgram_index.symbol_size = 2u;
+        qgram_index.Q           = Q;
+        qgram_index.QL          = QL;
+        qgram_index.QLS         = (Q - QL) * 2u;
+        qgram_index.n_qgrams    = string_len;
+
+        thrust::host_vector<qgram_type> all_qgrams( string_len );
+        thrust::host_vector<uint32>     counts( string_len + 1u );
+
+        // build the list of q-grams
+        thrust::transform(
+            thrust::make_counting_iterator<uint32>(0u),
+            thrust::make_counting_iterator<uint32>(0u) + string_len,
+            all_qgrams.begin(),
+            string_qgram_functor<string_type>( Q, 2u, string_len, string_type( &string[0] ) ) );
+
+        // build the list of q-gram indices
+        qgram_index.index.resize( string_len );
+        thrust::copy(
+            thrust::make_counting_iterator<uint32>(0u),
+            thrust::make_counting_iterator<uint32>(0u) + string_len,
+            qgram_index.index.begin() );
+
+        // sort the q-grams together with their coordinates
+        thrust::sort_by_key(
+            all_qgrams.begin(),
+            all_qgrams.end(),
+            qgram_index.index.begin() );
+
+        // copy only the unique q-grams and count them
+        qgram_index.qgrams.resize( string_len );
+        qgram_index.n_unique_qgrams = uint32( thrust::reduce_by_key(
+            all_qgrams.begin(),
+            all_qgrams.end(),
+            thrust::make_constant_iterator<uint32>(1u),
+            qgram_index.qgrams.begin(),
+            counts.begin() ).first - qgram_index.qgrams.begin() );
+
+        const uint32 n_unique_qgrams = qgram_index.n_unique_qgrams;
+        qgram_index.qgrams.resize( n_unique_qgrams );
+
+        // scan the counts to get the slots
+        counts[ n_unique_qgrams ] = 0u;
+        qgram_index.slots.resize( n_unique_qgrams + 1u );
+        thrust::exclusive_scan(
+            counts.begin(),
+            counts.begin() + n_unique_qgrams + 1u,
+            qgram_index.slots.begin() );
+
+        // build the LUT
+        const uint64 lut_size = uint64(1u) << (2u*QL);
+
+        qgram_index.lut.resize( lut_size+1 );
+        thrust::lower_bound(
+            qgram_index.qgrams.begin(),
+            qgram_index.qgrams.begin() + n_unique_qgrams,
+            thrust::make_transform_iterator( thrust::make_counting_iterator<uint32>(0), shift_left<qgram_type>( qgram_index.QLS ) ),
+            thrust::make_transform_iterator( thrust::make_counting_iterator<uint32>(0), shift_left<qgram_type>( qgram_index.QLS ) ) + lut_size,
+            qgram_index.lut.begin() );
+
+        qgram_index.lut[ lut_size ] = n_unique_qgrams;
+    }
+
+    const uint32                        Q;
+    const uint32                        QL;
+    const uint32                        string_len;
+    const thrust::host_vector<uint32>&  string;
+    QGramIndexHost&                     qgram_index;
+};
+
+// perform a batch of q-gram lookups
+//
+struct QGramQuery
+{
+    QGramQuery(
+        QGramIndexHost&                     _qgram_index,
+        const thrust::host_vector<uint64>&  _queries,
+        thrust::host_vector<uint2>&         _ranges) :
+        qgram_index( _qgram_index ), queries( _queries ), ranges( _ranges ) {}
+
+    void operator() ()
+    {
+        thrust::transform(
+            queries.begin(),
+            queries.end(),
+            ranges.begin(),
+            nvbio::plain_view( qgram_index ) );
+    }
+
+    QGramIndexHost&                     qgram_index;
+    const thrust::host_vector<uint64>&  queries;
+    thrust::host_vector<uint2>&         ranges;
+};
+
+} // anonymous namespace
+
+// FM-index rank and backward search benchmarks
+//
+void fmindex_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "fm-index" ) == false)
+        return;
+
+    const uint32 len       = runner.scaled( 16u*1024u*1024u );
+    const uint32 n_queries = runner.scaled( 4u*1024u*1024u );
+
+    FMIndexData data;
+    data.build( len, runner.options().seed );
+
+    const fm_index_type fmi = data.index();
+
+    // generate random rank queries
+    std::vector<uint32> queries( n_queries );
+    {
+        BenchRandom random( runner.options().seed + 1u );
+        for (uint32 i = 0; i < n_queries; ++i)
+            queries[i] = random.next( len );
+    }
+
+    FMRank rank_bench( fmi, queries );
+    runner.run( "fm-index/rank", "Mq/s", 1.0e-6 * double( n_queries ), rank_bench );
+
+    // extract the patterns from random text positions, so as to guarantee they are found
+    const uint32 n_patterns = n_queries / PLEN;
+
+    std::vector<uint8> patterns( n_patterns * PLEN );
+    {
+        const packed_stream_type text( &data.text[0] );
+
+        BenchRandom random( runner.options().seed + 2u );
+        for (uint32 i = 0; i < n_patterns; ++i)
+        {
+            const uint32 pos = random.next( len - PLEN );
+            for (uint32 j = 0; j < PLEN; ++j)
+                patterns[ i*PLEN + j ] = text[ pos + j ];
+        }
+    }
+
+    FMBackwardSearch search_bench( fmi, patterns );
+    runner.run( "fm-index/backward-search", "Mq/s", 1.0e-6 * double( n_patterns ), search_bench );
+}
+
+// q-gram index build and query benchmarks
+//
+void qgram_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "qgram" ) == false)
+        return;
+
+    const uint32 Q         = 20u;
+    const uint32 QL        = 10u;
+    const uint32 len       = runner.scaled( 16u*1024u*1024u );
+    const uint32 n_queries = runner.scaled( 4u*1024u*1024u );
+
+    // generate a random packed text
+    thrust::host_vector<uint32> text( util::divide_ri( len, 16u ), 0u );
+    {
+        packed_stream_type text_stream( &text[0] );
+
+        BenchRandom random( runner.options().seed );
+        for (uint32 i = 0; i < len; ++i)
+            text_stream[i] = random.next(4u);
+    }
+
+    QGramIndexHost qgram_index;
+
+    QGramBuild build( Q, QL, len, text, qgram_index );
+    runner.run( "qgram/build", "Mq-grams/s", 1.0e-6 * double( len ), build );
+
+    // make sure the index exists even if the build was filtered out
+    if (runner.enabled( "qgram/build" ) == false)
+        build();
+
+    // extract the query q-grams from random text positions
+    thrust::host_vector<uint64> queries( n_queries );
+    thrust::host_vector<uint2>  ranges( n_queries );
+    {
+        typedef PackedStream<const uint32*,uint8,2u,true,uint32> const_stream_type;
+
+        const string_qgram_functor<const_stream_type> qgram( Q, 2u, len, const_stream_type( &text[0] ) );
+
+        BenchRandom random( runner.options().seed + 1u );
+        for (uint32 i = 0; i < n_queries; ++i)
+            queries[i] = qgram( random.next( len - Q ) );
+    }
+
+    QGramQuery query( qgram_index, queries, ranges );
+    runner.run( "qgram/query", "Mq/s", 1.0e-6 * double( n_queries ), query );
+}
+
+} // namespace bench
+} // namespace nvbio
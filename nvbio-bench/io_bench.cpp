@@ -0,0 +1,252 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// io_bench.cpp
+//
+
+#include "bench.h"
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/fastq/fastq.h>
+#include <nvbio/io/output/output_databuffer.h>
+#include <nvbio/io/output/output_gzip.h>
+#include <zlib/zlib.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace nvbio {
+namespace bench {
+
+namespace {
+
+// generate a synthetic FASTQ file image, made of fixed-length reads
+//
+void make_fastq(const uint32 n_reads, const uint32 read_len, const uint32 seed, std::string& fastq)
+{
+    BenchRandom random( seed );
+
+    std::vector<char> bp( read_len );
+    std::vector<char> q( read_len );
+
+    fastq.clear();
+    fastq.reserve( size_t( n_reads ) * (2u*read_len + 32u) );
+
+    char name[64];
+    for (uint32 i = 0; i < n_reads; ++i)
+    {
+        make_dna_string( read_len, random.next(), &bp[0] );
+
+        // a quality profile slowly degrading along the read
+        for (uint32 j = 0; j < read_len; ++j)
+            q[j] = char( '!' + 40u - (j * 20u) / read_len - random.next(8u) );
+
+        sprintf( name, "@read.%u/1\n", i );
+        fastq.append( name );
+        fastq.append( &bp[0], read_len );
+        fastq.append( "\n+\n" );
+        fastq.append( &q[0], read_len );
+        fastq.append( "\n" );
+    }
+}
+
+// a FASTQ writer discarding everything but the read and base counts
+//
+struct CountingWriter
+{
+    CountingWriter() : n_reads(0), n_bps(0) {}
+
+    void push_back(const uint32 read_len, const char* name, const uint8* bp, const uint8* q)
+    {
+        n_reads++;
+        n_bps += read_len;
+    }
+
+    uint32 n_reads;
+    uint64 n_bps;
+};
+
+// parse a FASTQ file from start to end
+//
+struct FASTQParse
+{
+    FASTQParse(const char* _filename, const uint32 _n_reads) : filename( _filename ), n_reads( _n_reads ) {}
+
+    void operator() ()
+    {
+        FASTQ_file file( filename );
+        FASTQ_reader<FASTQ_file> reader( file );
+
+        CountingWriter writer;
+        while (reader.read( 1024u, writer )) {}
+
+        if (writer.n_reads != n_reads)
+            log_warning(stderr, "  fastq/parse: expected %u reads, got %u\n", n_reads, writer.n_reads);
+    }
+
+    const char* filename;
+    uint32      n_reads;
+};
+
+// compress a set of BGZF blocks, in parallel
+//
+struct BGZFDeflate
+{
+    BGZFDeflate(
+        std::vector<io::DataBuffer>& _input,
+        std::vector<io::DataBuffer>& _output) : input( _input ), output( _output ) {}
+
+    void operator() ()
+    {
+        const int32 n_blocks = int32( input.size() );
+
+        #pragma omp parallel for
+        for (int32 i = 0; i < n_blocks; ++i)
+        {
+            io::BGZFCompressor bgzf;
+
+            output[i].rewind();
+            bgzf.start_block( output[i] );
+            bgzf.compress( output[i], input[i] );
+            bgzf.end_block( output[i] );
+        }
+    }
+
+    std::vector<io::DataBuffer>& input;
+    std::vector<io::DataBuffer>& output;
+};
+
+// decompress a set of BGZF blocks, in parallel
+//
+struct BGZFInflate
+{
+    BGZFInflate(std::vector<io::DataBuffer>& _input) : input( _input ) {}
+
+    void operator() ()
+    {
+        const int32 n_blocks = int32( input.size() );
+
+        #pragma omp parallel
+        {
+            std::vector<uint8> block( io::DataBuffer::BUFFER_SIZE + io::DataBuffer::BUFFER_EXTRA );
+
+            #pragma omp for
+            for (int32 i = 0; i < n_blocks; ++i)
+            {
+                z_stream stream;
+                stream.zalloc   = Z_NULL;
+                stream.zfree    = Z_NULL;
+                stream.opaque   = Z_NULL;
+                stream.next_in  = (Bytef*)input[i].get_base_ptr();
+                stream.avail_in = input[i].get_pos();
+
+                // decode the gzip member
+                inflateInit2( &stream, 15 + 16 );
+
+                stream.next_out  = (Bytef*)&block[0];
+                stream.avail_out = uint32( block.size() );
+                if (inflate( &stream, Z_FINISH ) != Z_STREAM_END)
+                    log_warning(stderr, "  bgzf/inflate: corrupt block %d\n", i);
+
+                inflateEnd( &stream );
+            }
+        }
+    }
+
+    std::vector<io::DataBuffer>& input;
+};
+
+} // anonymous namespace
+
+// FASTQ parsing benchmarks
+//
+void fastq_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "fastq" ) == false)
+        return;
+
+    const uint32 n_reads  = runner.scaled( 200000u );
+    const uint32 read_len = 100u;
+
+    std::string fastq;
+    make_fastq( n_reads, read_len, runner.options().seed, fastq );
+
+    const std::string filename = std::string( runner.options().tmp_dir ) + "/nvbio-bench.fastq";
+
+    FILE* file = fopen( filename.c_str(), "wb" );
+    if (file == NULL)
+    {
+        log_error(stderr, "unable to open \"%s\" for writing\n", filename.c_str());
+        return;
+    }
+    fwrite( fastq.c_str(), 1u, fastq.length(), file );
+    fclose( file );
+
+    FASTQParse parse( filename.c_str(), n_reads );
+    runner.run( "fastq/parse", "MB/s", 1.0e-6 * double( fastq.length() ), parse );
+
+    remove( filename.c_str() );
+}
+
+// BGZF compression and decompression benchmarks
+//
+void bgzf_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "bgzf" ) == false)
+        return;
+
+    // use a FASTQ image as a reasonably compressible payload
+    std::string payload;
+    make_fastq( runner.scaled( 100000u ), 100u, runner.options().seed, payload );
+
+    const uint32 BLOCK_SIZE = io::DataBuffer::BUFFER_SIZE;
+    const uint32 n_blocks   = util::divide_ri( uint32( payload.length() ), BLOCK_SIZE );
+
+    std::vector<io::DataBuffer> input( n_blocks );
+    std::vector<io::DataBuffer> output( n_blocks );
+
+    for (uint32 i = 0; i < n_blocks; ++i)
+    {
+        const uint32 begin = i * BLOCK_SIZE;
+        const uint32 end   = nvbio::min( begin + BLOCK_SIZE, uint32( payload.length() ) );
+        input[i].append_data( payload.c_str() + begin, end - begin );
+    }
+
+    BGZFDeflate deflate( input, output );
+    runner.run( "bgzf/deflate", "MB/s", 1.0e-6 * double( payload.length() ), deflate );
+
+    // make sure the compressed blocks exist even if deflate was filtered out
+    if (runner.enabled( "bgzf/inflate" ) && runner.enabled( "bgzf/deflate" ) == false)
+        deflate();
+
+    BGZFInflate inflate( output );
+    runner.run( "bgzf/inflate", "MB/s", 1.0e-6 * double( payload.length() ), inflate );
+}
+
+} // namespace bench
+} // namespace nvbio
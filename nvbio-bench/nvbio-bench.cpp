@@ -0,0 +1,177 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// nvbio-bench.cpp
+//
+
+#include "bench.h"
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/profiling.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace nvbio;
+using namespace nvbio::bench;
+
+void print_usage()
+{
+    fprintf(stderr, "nvbio-bench [options] [benchmark-prefix]\n");
+    fprintf(stderr, "  run the host-side nvbio benchmarks on fixed synthetic datasets\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -warmup   int     (default 1)     number of untimed warm-up runs\n");
+    fprintf(stderr, "  -reps     int     (default 5)     number of timed repetitions\n");
+    fprintf(stderr, "  -scale    float   (default 1)     dataset scaling factor\n");
+    fprintf(stderr, "  -seed     int     (default 1)     dataset random seed\n");
+    fprintf(stderr, "  -threads  int     (default all)   number of host threads\n");
+    fprintf(stderr, "  -tmp      dir     (default .)     directory for temporary files\n");
+    fprintf(stderr, "  -json     file                    write the results in JSON format (- for stdout)\n");
+    fprintf(stderr, "  -csv      file                    write the results in CSV format (- for stdout)\n");
+    fprintf(stderr, "  -verbosity int                    logging verbosity\n");
+    fprintf(stderr, "benchmarks:\n");
+    fprintf(stderr, "  fastq/parse\n");
+    fprintf(stderr, "  packing/pack-2bit, packing/unpack-2bit\n");
+    fprintf(stderr, "  bgzf/deflate, bgzf/inflate\n");
+    fprintf(stderr, "  fm-index/rank, fm-index/backward-search\n");
+    fprintf(stderr, "  qgram/build, qgram/query\n");
+    fprintf(stderr, "  alignment/sw-local, alignment/gotoh-local, alignment/ed-semi-global\n");
+    fprintf(stderr, "  pipeline/read-pack\n");
+    fprintf(stderr, "  bloom/insert[-batched]-{4,64,512}MB, bloom/has[-batched]-{4,64,512}MB\n");
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        BenchOptions options;
+
+        const char* json_name = NULL;
+        const char* csv_name  = NULL;
+        int         threads   = omp_get_num_procs();
+
+        for (int i = 1; i < argc; ++i)
+        {
+            if (strcmp( argv[i], "-warmup" ) == 0)
+                options.warmup = uint32( atoi( argv[++i] ) );
+            else if (strcmp( argv[i], "-reps" ) == 0)
+                options.reps = nvbio::max( uint32( atoi( argv[++i] ) ), 1u );
+            else if (strcmp( argv[i], "-scale" ) == 0)
+                options.scale = float( atof( argv[++i] ) );
+            else if (strcmp( argv[i], "-seed" ) == 0)
+                options.seed = uint32( atoi( argv[++i] ) );
+            else if (strcmp( argv[i], "-threads" ) == 0)
+                threads = atoi( argv[++i] );
+            else if (strcmp( argv[i], "-tmp" ) == 0)
+                options.tmp_dir = argv[++i];
+            else if (strcmp( argv[i], "-json" ) == 0)
+                json_name = argv[++i];
+            else if (strcmp( argv[i], "-csv" ) == 0)
+                csv_name = argv[++i];
+            else if (strcmp( argv[i], "-verbosity" ) == 0)
+                set_verbosity( Verbosity( atoi( argv[++i] ) ) );
+            else if (strcmp( argv[i], "-help" ) == 0 || strcmp( argv[i], "-h" ) == 0)
+            {
+                print_usage();
+                return 0;
+            }
+            else if (argv[i][0] == '-')
+            {
+                log_error(stderr, "unknown option \"%s\"\n", argv[i]);
+                print_usage();
+                return 1;
+            }
+            else
+                options.filter = argv[i];
+        }
+
+        omp_set_num_threads( threads );
+        options.threads = uint32( threads );
+
+        log_info(stderr, "nvbio-bench... started\n");
+        log_info(stderr, "  threads : %d\n", threads);
+        log_info(stderr, "  warm-up : %u\n", options.warmup);
+        log_info(stderr, "  reps    : %u\n", options.reps);
+        log_info(stderr, "  scale   : %.2f\n", options.scale);
+        log_info(stderr, "  seed    : %u\n", options.seed);
+
+        BenchRunner runner( options );
+
+        fastq_bench( runner );
+        packing_bench( runner );
+        bgzf_bench( runner );
+        fmindex_bench( runner );
+        qgram_bench( runner );
+        alignment_bench( runner );
+        pipeline_bench( runner );
+        bloom_bench( runner );
+
+        log_info(stderr, "nvbio-bench... done: %u benchmarks\n", uint32( runner.results().size() ));
+
+        // print the hardware counters of the instrumented library regions, if enabled
+        NVBIO_PROFILE_REPORT( stderr );
+
+        if (json_name && write_json( json_name, options, runner.results() ) == false)
+            return 1;
+
+        if (csv_name && write_csv( csv_name, runner.results() ) == false)
+            return 1;
+    }
+    catch (nvbio::bad_alloc& e)
+    {
+        log_error(stderr, "caught a nvbio::bad_alloc exception:\n");
+        log_error(stderr, "  %s\n", e.what());
+        return 1;
+    }
+    catch (nvbio::logic_error& e)
+    {
+        log_error(stderr, "caught a nvbio::logic_error exception:\n");
+        log_error(stderr, "  %s\n", e.what());
+        return 1;
+    }
+    catch (nvbio::runtime_error& e)
+    {
+        log_error(stderr, "caught a nvbio::runtime_error exception:\n");
+        log_error(stderr, "  %s\n", e.what());
+        return 1;
+    }
+    catch (std::bad_alloc& e)
+    {
+        log_error(stderr, "caught a std::bad_alloc exception:\n");
+        log_error(stderr, "  %s\n", e.what());
+        return 1;
+    }
+    catch (...)
+    {
+        log_error(stderr, "caught an unknown exception!\n");
+        return 1;
+    }
+    return 0;
+}
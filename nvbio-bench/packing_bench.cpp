@@ -0,0 +1,108 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// packing_bench.cpp
+//
+
+#include "bench.h"
+#include <nvbio/basic/dna.h>
+#include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/numbers.h>
+#include <vector>
+
+namespace nvbio {
+namespace bench {
+
+namespace {
+
+typedef PackedStream<uint32*,uint8,2u,true,uint32> packed_stream_type;
+
+// pack an ASCII DNA string into a 2-bit packed stream
+//
+struct Pack
+{
+    Pack(const uint32 _len, const char* _string, uint32* _words) : len( _len ), string( _string ), words( _words ) {}
+
+    void operator() ()
+    {
+        packed_stream_type packed( words );
+        for (uint32 i = 0; i < len; ++i)
+            packed[i] = char_to_dna( string[i] );
+    }
+
+    uint32      len;
+    const char* string;
+    uint32*     words;
+};
+
+// unpack a 2-bit packed stream into an ASCII DNA string
+//
+struct Unpack
+{
+    Unpack(const uint32 _len, uint32* _words, char* _string) : len( _len ), words( _words ), string( _string ) {}
+
+    void operator() ()
+    {
+        packed_stream_type packed( words );
+        dna_to_string( packed, len, string );
+    }
+
+    uint32  len;
+    uint32* words;
+    char*   string;
+};
+
+} // anonymous namespace
+
+// sequence packing benchmarks
+//
+void packing_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "packing" ) == false)
+        return;
+
+    const uint32 len = runner.scaled( 64u*1024u*1024u );
+
+    std::vector<char>   string( len + 1u );
+    std::vector<uint32> words( util::divide_ri( len, 16u ) + 1u, 0u );
+
+    make_dna_string( len, runner.options().seed, &string[0] );
+
+    Pack pack( len, &string[0], &words[0] );
+    runner.run( "packing/pack-2bit", "Mbp/s", 1.0e-6 * double( len ), pack );
+
+    // make sure the packed string exists even if packing was filtered out
+    if (runner.enabled( "packing/pack-2bit" ) == false)
+        pack();
+
+    Unpack unpack( len, &words[0], &string[0] );
+    runner.run( "packing/unpack-2bit", "Mbp/s", 1.0e-6 * double( len ), unpack );
+}
+
+} // namespace bench
+} // namespace nvbio
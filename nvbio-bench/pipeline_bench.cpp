@@ -0,0 +1,156 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// pipeline_bench.cpp
+//
+
+#include "bench.h"
+#include <nvbio/basic/pipeline.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/dna.h>
+#include <nvbio/basic/packedstream.h>
+#include <vector>
+#include <string.h>
+
+namespace nvbio {
+namespace bench {
+
+namespace {
+
+const uint32 BATCH_SIZE = 1024u*1024u;
+
+// the source stage, copying fixed-size batches out of an in-memory ASCII dataset
+//
+struct ReadStage
+{
+    typedef void                argument_type;
+    typedef std::vector<char>   return_type;
+
+    ReadStage(const std::vector<char>& _dataset) : dataset( _dataset ), offset(0) {}
+
+    bool process(PipelineContext& context)
+    {
+        if (offset >= dataset.size())
+            return false;
+
+        std::vector<char>* batch = context.output<std::vector<char> >();
+
+        const size_t n = nvbio::min( uint64( BATCH_SIZE ), uint64( dataset.size() - offset ) );
+        batch->resize( n );
+        memcpy( &(*batch)[0], &dataset[ offset ], n );
+
+        offset += n;
+        return true;
+    }
+
+    const std::vector<char>&    dataset;
+    size_t                      offset;
+};
+
+// the transform stage, packing each batch into a 2-bit stream
+//
+struct PackStage
+{
+    typedef std::vector<char>   argument_type;
+    typedef std::vector<uint32> return_type;
+
+    bool process(PipelineContext& context)
+    {
+        const std::vector<char>* batch  = context.input<std::vector<char> >( 0 );
+              std::vector<uint32>* words = context.output<std::vector<uint32> >();
+
+        const uint32 n = uint32( batch->size() );
+        words->resize( util::divide_ri( n, 16u ) + 1u );
+
+        PackedStream<uint32*,uint8,2u,true,uint32> packed( &(*words)[0] );
+        for (uint32 i = 0; i < n; ++i)
+            packed[i] = char_to_dna( (*batch)[i] );
+
+        return true;
+    }
+};
+
+// the sink, counting the packed words it receives
+//
+struct CountSink
+{
+    typedef std::vector<uint32> argument_type;
+
+    CountSink() : n_words(0) {}
+
+    bool process(PipelineContext& context)
+    {
+        n_words += context.input<std::vector<uint32> >( 0 )->size();
+        return true;
+    }
+
+    uint64 n_words;
+};
+
+// run the whole pipeline to completion
+//
+struct PipelineRun
+{
+    PipelineRun(const std::vector<char>& _dataset) : dataset( _dataset ) {}
+
+    void operator() ()
+    {
+        ReadStage read_stage( dataset );
+        PackStage pack_stage;
+        CountSink count_sink;
+
+        Pipeline pipeline;
+        const uint32 in   = pipeline.append_stage( &read_stage, 4u );
+        const uint32 pack = pipeline.append_stage( &pack_stage, 4u );
+        const uint32 out  = pipeline.append_sink( &count_sink );
+        pipeline.add_dependency( in, pack );
+        pipeline.add_dependency( pack, out );
+        pipeline.run();
+    }
+
+    const std::vector<char>& dataset;
+};
+
+} // anonymous namespace
+
+// host task-pipeline throughput benchmarks
+//
+void pipeline_bench(BenchRunner& runner)
+{
+    if (runner.enabled( "pipeline" ) == false)
+        return;
+
+    std::vector<char> dataset( runner.scaled( 64u*1024u*1024u ) );
+    make_dna_string( uint32( dataset.size() ), runner.options().seed, &dataset[0] );
+
+    PipelineRun body( dataset );
+    runner.run( "pipeline/read-pack", "Mbp/s", 1.0e-6 * double( dataset.size() ), body );
+}
+
+} // namespace bench
+} // namespace nvbio
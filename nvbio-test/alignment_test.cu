@@ -41,7 +41,11 @@
 #include <nvbio/basic/dna.h>
 #include <nvbio/alignment/alignment.h>
 #include <nvbio/alignment/batched.h>
+#include <nvbio/alignment/extension.h>
 #include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/substitution_matrix.h>
+#include <nvbio/alignment/myers/myers_simd.h>
+#include <nvbio/strings/string_set.h>
 #include <thrust/device_vector.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -211,6 +215,18 @@ __global__ void alignment_test_kernel(const aligner_type aligner, const uint32 N
     score[tid] = sink.score;
 }
 
+//
+// A Gotoh scoring scheme with different gap costs for the pattern and the text
+//
+struct AsymmetricGotohScheme : public SimpleGotohScheme
+{
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_open()               const { return m_text_gap_open; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_extension()          const { return m_text_gap_ext; };
+
+    int32 m_text_gap_open;
+    int32 m_text_gap_ext;
+};
+
 //
 // A class for making a single alignment test, testing both scoring and traceback
 //
@@ -293,6 +309,45 @@ struct SingleTest
         }
     }
 
+    // test linear-space alignment traceback
+    //
+    // \param test              test name
+    // \param aligner           alignment algorithm
+    //
+    template <uint32 N, uint32 M, typename aligner_type>
+    void linear(const char* test, const aligner_type aligner)
+    {
+        typedef ScoreMatrices<N,M,typename aligner_type::aligner_tag> SWMatrices;
+
+        SharedPointer<SWMatrices> mat = SharedPointer<SWMatrices>( new SWMatrices() );
+
+        const uint8* str_hptr = nvbio::raw_pointer( str_hvec );
+        const uint8* ref_hptr = nvbio::raw_pointer( ref_hvec );
+
+        const int32 ref_score = ref_sw<M,N>( str_hptr, ref_hptr, aligner, mat.get() );
+
+        TestBacktracker backtracker;
+        backtracker.clear();
+
+        const Alignment<int32> aln = aln::hirschberg_alignment_traceback(
+            aligner,
+            vector_view<const uint8*>( M, str_hptr ),
+            trivial_quality_string(),
+            vector_view<const uint8*>( N, ref_hptr ),
+            -1000,
+            backtracker );
+
+        const int32 aln_score = backtracker.score( aligner, aln.source.x, str_hptr, ref_hptr );
+        const std::string aln_string = rle( backtracker.aln ).c_str();
+        fprintf(stderr, "    %15s : ", test);
+        fprintf(stderr, "%d - %s - [%u:%u] x [%u:%u]\n", aln.score, aln_string.c_str(), aln.source.x, aln.sink.x, aln.source.y, aln.sink.y);
+        if (aln.score != ref_score || aln_score != ref_score)
+        {
+            log_error(stderr, "    expected %s linear-space score %d, got %d (backtracking score %d)\n", test, ref_score, aln.score, aln_score);
+            exit(1);
+        }
+    }
+
     // test banded alignment
     //
     // \param test              test name
@@ -610,6 +665,73 @@ void banded_edit_distance_test(
         fprintf(stderr, "  synthetic Edit Distance test %u... passed!\n", test_id);
 }
 
+// compare the batched Myers edit distance against the scalar one on random pairs,
+// with patterns spanning several 64-bit blocks and symbols outside the alphabet
+//
+template <AlignmentType TYPE>
+void batch_myers_test(const char* name)
+{
+    typedef ConcatenatedStringSet<const uint8*,const uint32*> string_set_type;
+
+    const uint32 N_PAIRS   = 1001;
+    const int32  MIN_SCORE = -60;
+
+    std::vector<uint8>  patterns;
+    std::vector<uint8>  texts;
+    std::vector<uint32> pattern_offsets( 1, 0u );
+    std::vector<uint32> text_offsets( 1, 0u );
+
+    for (uint32 i = 0; i < N_PAIRS; ++i)
+    {
+        const uint32 m     = rand() % 200;
+        const uint32 n     = rand() % 300;
+        const uint32 begin = uint32( patterns.size() );
+
+        for (uint32 j = 0; j < m; ++j)
+            patterns.push_back( rand() % 5 );
+
+        // derive the text from the pattern, so as to get a mix of valid and invalid alignments
+        for (uint32 j = 0; j < n; ++j)
+            texts.push_back( (j < m && rand() % 4) ? patterns[ begin + j ] : rand() % 4 );
+
+        pattern_offsets.push_back( uint32( patterns.size() ) );
+        text_offsets.push_back( uint32( texts.size() ) );
+    }
+    patterns.push_back( 0u );
+    texts.push_back( 0u );
+
+    const string_set_type pattern_set( N_PAIRS, &patterns[0], &pattern_offsets[0] );
+    const string_set_type text_set( N_PAIRS, &texts[0], &text_offsets[0] );
+
+    const EditDistanceAligner<TYPE,MyersTag<4> > aligner = make_edit_distance_aligner<TYPE,MyersTag<4> >();
+
+    std::vector< BestSink<int32> > sinks( N_PAIRS );
+    batch_myers_score( aligner, pattern_set, text_set, MIN_SCORE, &sinks[0] );
+
+    std::vector<uint64> column;
+    for (uint32 i = 0; i < N_PAIRS; ++i)
+    {
+        const string_set_type::string_type pattern = pattern_set[i];
+        const string_set_type::string_type text    = text_set[i];
+
+        column.resize( 7u * ((pattern.length() + 63u) / 64u) + 1u );
+
+        BestSink<int32> sink;
+        alignment_score( aligner, pattern, trivial_quality_string(), text, MIN_SCORE, sink, &column[0] );
+
+        if (sink.score  != sinks[i].score  ||
+            sink.sink.x != sinks[i].sink.x ||
+            sink.sink.y != sinks[i].sink.y)
+        {
+            log_error(stderr, "    %s pair %u (%u x %u): batched score %d at (%u,%u), expected %d at (%u,%u)\n",
+                name, i, pattern.length(), text.length(),
+                sinks[i].score, sinks[i].sink.x, sinks[i].sink.y,
+                sink.score, sink.sink.x, sink.sink.y);
+            exit(1);
+        }
+    }
+}
+
 void test(int argc, char* argv[])
 {
                      uint32 n_tests          = 1;
@@ -792,6 +914,202 @@ void test(int argc, char* argv[])
             test.full<BLOCKDIM,N,M>( "semi-global", make_gotoh_aligner<aln::SEMI_GLOBAL>( scoring ), "4M1D3M" );
             test.banded<BLOCKDIM, 7u, N, M>( "banded-semi-global", make_gotoh_aligner<aln::SEMI_GLOBAL>( scoring ), "4M1D3M" );
         }
+        {
+            fprintf(stderr,"  testing Myers edit distance...\n");
+            test.full<BLOCKDIM,N,M>(      "global", make_edit_distance_aligner<aln::GLOBAL, aln::MyersTag<4> >(),      "1M2D3M1D3M10D" );
+            test.full<BLOCKDIM,N,M>( "semi-global", make_edit_distance_aligner<aln::SEMI_GLOBAL, aln::MyersTag<4> >(), "4M1I2M" );
+        }
+    }
+
+    if (TEST_MASK & FUNCTIONAL)
+    {
+        fprintf(stderr,"  testing multi-word Myers edit distance...\n");
+        NVBIO_VAR_UNUSED const uint32 BLOCKDIM = 128;
+        NVBIO_VAR_UNUSED const uint32 M = 130;
+        NVBIO_VAR_UNUSED const uint32 N = 200;
+
+        thrust::host_vector<uint8> str_hvec( M );
+        thrust::host_vector<uint8> ref_hvec( N );
+
+        uint8* str_hptr = nvbio::raw_pointer( str_hvec );
+        uint8* ref_hptr = nvbio::raw_pointer( ref_hvec );
+
+        // a pattern spanning three 64-bit words, with two mismatches, one insertion and one deletion
+        string_to_dna("TGTTGGCCCAGTGTGAATCGATTAAGGGTTAAGTAAGTGTGATGCATACGTCCTTTACTTGCTGTGTCCACCCCATGGGACTGGCATTTTTATTACACTCAAAACAGAACTCGGGTAATTTTGACAGGTC", str_hptr);
+        string_to_dna("GCTAAAGACAATTACATAACATACACGTCAGCACGAAACTTGTTGGCCCAGTGTGAATCGCTTAAGGGTTAAGTAAGTGTGATGCATACGCCTTTACTTGCTGTGTCCACCCCATCGGACTGGCATTTTTATTACACTCAGAAACAGAACTCGGGTAATTTTGACAGGTCACGCAGAGGCGCGCCCTCCTGAAGTGCGTG", ref_hptr);
+
+        SingleTest test;
+        nvbio::cuda::thrust_copy_vector(test.str_hvec, str_hvec);
+        nvbio::cuda::thrust_copy_vector(test.ref_hvec, ref_hvec);
+        nvbio::cuda::thrust_copy_vector(test.str_dvec, str_hvec);
+        nvbio::cuda::thrust_copy_vector(test.ref_dvec, ref_hvec);
+
+        test.full<BLOCKDIM,N,M>(      "global", make_edit_distance_aligner<aln::GLOBAL, aln::MyersTag<4> >(),      "3D1M1D2M2D1M13D1M2D1M2D1M2D1M5D21M1D50M1I50M40D" );
+        test.full<BLOCKDIM,N,M>( "semi-global", make_edit_distance_aligner<aln::SEMI_GLOBAL, aln::MyersTag<4> >(), "29M1D50M1I50M" );
+
+  #if defined(__AVX2__)
+        fprintf(stderr,"  testing batched Myers edit distance (AVX2)...\n");
+  #else
+        fprintf(stderr,"  testing batched Myers edit distance...\n");
+  #endif
+        batch_myers_test<aln::GLOBAL>( "global" );
+        batch_myers_test<aln::SEMI_GLOBAL>( "semi-global" );
+
+        fprintf(stderr,"  testing linear-space traceback...\n");
+        aln::SimpleGotohScheme scoring;
+        scoring.m_match    =  2;
+        scoring.m_mismatch = -3;
+        scoring.m_gap_open = -5;
+        scoring.m_gap_ext  = -2;
+
+        test.linear<N,M>(        "ed-global", make_edit_distance_aligner<aln::GLOBAL>() );
+        test.linear<N,M>(   "ed-semi-global", make_edit_distance_aligner<aln::SEMI_GLOBAL>() );
+        test.linear<N,M>(     "gotoh-global", make_gotoh_aligner<aln::GLOBAL>( scoring ) );
+        test.linear<N,M>(      "gotoh-local", make_gotoh_aligner<aln::LOCAL>( scoring ) );
+        test.linear<N,M>("gotoh-semi-global", make_gotoh_aligner<aln::SEMI_GLOBAL>( scoring ) );
+
+        // insertions and deletions must pay the pattern and text gap costs respectively
+        {
+            AsymmetricGotohScheme asymmetric_scoring;
+            asymmetric_scoring.m_match         =  2;
+            asymmetric_scoring.m_mismatch      = -3;
+            asymmetric_scoring.m_gap_open      = -5;
+            asymmetric_scoring.m_gap_ext       = -2;
+            asymmetric_scoring.m_text_gap_open = -9;
+            asymmetric_scoring.m_text_gap_ext  = -1;
+
+            test.linear<N,M>(     "asym-global", make_gotoh_aligner<aln::GLOBAL>( asymmetric_scoring ) );
+            test.linear<N,M>(      "asym-local", make_gotoh_aligner<aln::LOCAL>( asymmetric_scoring ) );
+            test.linear<N,M>("asym-semi-global", make_gotoh_aligner<aln::SEMI_GLOBAL>( asymmetric_scoring ) );
+        }
+
+        fprintf(stderr,"  testing X-drop extension...\n");
+        {
+            // extend the pattern from its true start in the text, at offset 40
+            aln::ExtensionParams params;
+            params.xdrop = 30;
+            params.zdrop = 20;
+
+            TestBacktracker backtracker;
+            backtracker.clear();
+
+            const aln::ExtensionAlignment ext = aln::extension_alignment_traceback(
+                make_gotoh_aligner<aln::LOCAL>( scoring ),
+                vector_view<const uint8*>( M, str_hptr ),
+                trivial_quality_string(),
+                vector_view<const uint8*>( N - 40u, ref_hptr + 40u ),
+                0,
+                params,
+                backtracker );
+
+            const std::string aln_string = rle( backtracker.aln ).c_str();
+            fprintf(stderr, "          extension : %d - %s - [0:%u] x [0:%u] (band %u)\n", ext.score, aln_string.c_str(), ext.sink.x, ext.sink.y, ext.max_band);
+            if (ext.traceback_failed || ext.score != 238 || ext.global_score != 238 || ext.global_text_end != 130u || strcmp( aln_string.c_str(), "29M1D50M1I50M" ) != 0)
+            {
+                log_error(stderr, "    expected extension 238 - 29M1D50M1I50M, got %d - %s\n", ext.score, aln_string.c_str());
+                exit(1);
+            }
+        }
+
+        fprintf(stderr,"  testing banded X-drop extension...\n");
+        {
+            aln::SimpleGotohScheme band_scoring;
+            band_scoring.m_match    =  3;
+            band_scoring.m_mismatch = -6;
+            band_scoring.m_gap_open = -5;
+            band_scoring.m_gap_ext  = -1;
+
+            const aln::GotohAligner<aln::LOCAL,aln::SimpleGotohScheme> band_aligner = make_gotoh_aligner<aln::LOCAL>( band_scoring );
+
+            const uint32 BAND_M = 100;
+            const uint32 BAND_N = 150;
+
+            uint8 pattern[BAND_M];
+            uint8 text[BAND_N];
+
+            for (uint32 t = 0; t < 500; ++t)
+            {
+                // derive the text from the pattern with random substitutions and indels
+                for (uint32 j = 0; j < BAND_M; ++j)
+                    pattern[j] = rand() % 4;
+
+                for (uint32 i = 0, j = 0; i < BAND_N; ++i)
+                {
+                    const uint32 r = rand() % 20;
+                    if (r == 0)         // skip a few pattern characters
+                        j += 1 + rand() % 3;
+
+                    if (j >= BAND_M || r == 1)
+                        text[i] = rand() % 4;   // insert a random character
+                    else if (r == 2)
+                    {
+                        text[i] = rand() % 4;   // substitute a pattern character
+                        ++j;
+                    }
+                    else
+                        text[i] = pattern[j++];
+                }
+
+                aln::ExtensionParams params;
+                params.xdrop = 20;
+                params.zdrop = 0;
+
+                const aln::ExtensionAlignment full = aln::extension_alignment_score(
+                    band_aligner,
+                    vector_view<const uint8*>( BAND_M, pattern ),
+                    trivial_quality_string(),
+                    vector_view<const uint8*>( BAND_N, text ),
+                    0,
+                    params );
+
+                // a band wider than the matrix must not change anything
+                params.max_band = BAND_M + BAND_N;
+                const aln::ExtensionAlignment wide = aln::extension_alignment_score(
+                    band_aligner,
+                    vector_view<const uint8*>( BAND_M, pattern ),
+                    trivial_quality_string(),
+                    vector_view<const uint8*>( BAND_N, text ),
+                    0,
+                    params );
+
+                if (wide.score != full.score || wide.sink.x != full.sink.x || wide.sink.y != full.sink.y || wide.global_score != full.global_score)
+                {
+                    log_error(stderr, "    wide banded extension %d differs from the unbanded one %d\n", wide.score, full.score);
+                    exit(1);
+                }
+
+                // narrow bands can only lower the score, and must trace back to a valid alignment
+                for (uint32 band = 1; band <= 8; band *= 2)
+                {
+                    params.max_band = band;
+
+                    TestBacktracker backtracker;
+                    backtracker.clear();
+
+                    const aln::ExtensionAlignment narrow = aln::extension_alignment_traceback(
+                        band_aligner,
+                        vector_view<const uint8*>( BAND_M, pattern ),
+                        trivial_quality_string(),
+                        vector_view<const uint8*>( BAND_N, text ),
+                        0,
+                        params,
+                        backtracker );
+
+                    if (narrow.traceback_failed)
+                    {
+                        log_error(stderr, "    extension with band %u: traceback left the stored band\n", band);
+                        exit(1);
+                    }
+
+                    const int32 aln_score = backtracker.score( band_aligner, 0u, pattern, text );
+                    if (narrow.score > full.score || aln_score != narrow.score)
+                    {
+                        log_error(stderr, "    extension with band %u: score %d, alignment score %d, unbanded score %d\n", band, narrow.score, aln_score, full.score);
+                        exit(1);
+                    }
+                }
+            }
+        }
     }
 
     if (TEST_MASK & FUNCTIONAL)
@@ -903,6 +1221,63 @@ void test(int argc, char* argv[])
         test.full<BLOCKDIM,N,M>( "semi-global", aligner, "1I1M2I1M3I136M" );
     }
 
+  #if defined(__SSE2__)
+    if (TEST_MASK & FUNCTIONAL)
+    {
+        fprintf(stderr,"  testing SSE2 query profile scoring...\n");
+        const uint32 SYMBOLS = aln::SubstitutionMatrix::SYMBOLS;
+
+        std::vector<uint8> pattern;
+        std::vector<uint8> text;
+
+        for (uint32 t = 0; t < 2000; ++t)
+        {
+            const aln::SubstitutionMatrix matrix( aln::SubstitutionMatrix::Builtin( rand() % 8 ) );
+
+            const uint32 M = 1u + rand() % 200;
+            const uint32 N = 1u + rand() % 300;
+
+            pattern.resize( M );
+            text.resize( N );
+            for (uint32 j = 0; j < M; ++j) pattern[j] = rand() % SYMBOLS;
+            for (uint32 i = 0; i < N; ++i) text[i]    = rand() % SYMBOLS;
+
+            // make half of the texts share a noisy copy of the pattern
+            if (rand() % 2)
+            {
+                for (uint32 i = 0; i < nvbio::min( M, N ); ++i)
+                {
+                    if (rand() % 6)
+                        text[i] = pattern[i];
+                }
+            }
+
+            // cover both gap_open <= gap_ext and the opposite case, which the SIMD path must reject
+            const int32 gap_open = -int32( 1 + rand() % 12 );
+            const int32 gap_ext  = -int32( 1 + rand() % 4 );
+
+            const aln::QueryProfile profile( matrix, vector_view<const uint8*>( M, &pattern[0] ) );
+            const vector_view<const uint8*> text_view( N, &text[0] );
+
+            uint2 scalar_sink;
+            uint2 sse2_sink;
+            uint2 sink;
+            const int32 scalar_score = aln::query_profile_score_scalar( profile, text_view, gap_open, gap_ext, &scalar_sink );
+            const int32 sse2_score   = aln::priv::query_profile_score_sse2( profile, text_view, gap_open, gap_ext, &sse2_sink );
+            const int32 score        = aln::query_profile_score( profile, text_view, gap_open, gap_ext, &sink );
+
+            if (score != scalar_score || sink.x != scalar_sink.x || sink.y != scalar_sink.y ||
+                (sse2_score >= 0 && (sse2_score != scalar_score || sse2_sink.x != scalar_sink.x || sse2_sink.y != scalar_sink.y)) ||
+                (sse2_score >= 0 && gap_open > gap_ext))
+            {
+                log_error(stderr, "  query profile scores differ: %d (sse2) / %d (dispatch) != %d (scalar)\n", sse2_score, score, scalar_score);
+                log_error(stderr, "    %s, M = %u, N = %u, gap open = %d, gap ext = %d\n", matrix.name(), M, N, gap_open, gap_ext);
+                exit(1);
+            }
+        }
+    }
+  #endif
+
     // do a larger speed test of the Gotoh alignment
     if (TEST_MASK & (ED | SW | GOTOH))
     {
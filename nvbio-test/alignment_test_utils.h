@@ -519,11 +519,11 @@ int32 ref_sw(
         return mat->H[N][M];
 }
 
-template <uint32 M, uint32 N, aln::AlignmentType TYPE>
+template <uint32 M, uint32 N, aln::AlignmentType TYPE, typename algorithm_tag>
 int32 ref_sw(
     const uint8*                                        str,
     const uint8*                                        ref,
-    const aln::EditDistanceAligner<TYPE>                aligner,
+    const aln::EditDistanceAligner<TYPE,algorithm_tag>  aligner,
     ScoreMatrices<N,M,aln::EditDistanceTag>*            mat)
 {
     return ref_sw<M,N>(
@@ -544,6 +544,8 @@ int32 ref_sw(
 
     const int32 G_o = scoring.pattern_gap_open();
     const int32 G_e = scoring.pattern_gap_extension();
+    const int32 T_o = scoring.text_gap_open();
+    const int32 T_e = scoring.text_gap_extension();
     const int32 S   = scoring.mismatch();
     const int32 V   = scoring.match();
 
@@ -563,7 +565,7 @@ int32 ref_sw(
     }
     for (uint32 i = 1; i <= N; ++i)
     {
-        mat->H[i][0] = (TYPE == aln::GLOBAL) ? G_o + G_e * (i-1) : 0;
+        mat->H[i][0] = (TYPE == aln::GLOBAL) ? T_o + T_e * (i-1) : 0;
         mat->E[i][0] = mat->F[i][0] = (TYPE != LOCAL) ? -100000 : 0;
         mat->H_flow[i][0] = '*';
         mat->E_flow[i][0] = '*';
@@ -582,10 +584,10 @@ int32 ref_sw(
             const int32 S_ij = (r_i == s_j) ? V : S;
 
             mat->E_flow[i][j] = mat->E[i][j-1] + G_e > mat->H[i][j-1] + G_o ? '-' : 'H';
-            mat->F_flow[i][j] = mat->F[i-1][j] + G_e > mat->H[i-1][j] + G_o ? '|' : 'H';
+            mat->F_flow[i][j] = mat->F[i-1][j] + T_e > mat->H[i-1][j] + T_o ? '|' : 'H';
 
             mat->E[i][j] = nvbio::max( mat->E[i][j-1] + G_e, mat->H[i][j-1] + G_o );
-            mat->F[i][j] = nvbio::max( mat->F[i-1][j] + G_e, mat->H[i-1][j] + G_o );
+            mat->F[i][j] = nvbio::max( mat->F[i-1][j] + T_e, mat->H[i-1][j] + T_o );
 
             mat->H_flow[i][j] = mat->F[i][j] > mat->E[i][j] ?
                 (mat->F[i][j] > mat->H[i-1][j-1] + S_ij ? 'F' : '\\') :
@@ -644,9 +646,9 @@ struct TestBacktracker
 
     // compute the score of the resulting alignment
     //
-    template <AlignmentType TYPE>
+    template <AlignmentType TYPE, typename algorithm_tag>
     int32 score(
-        EditDistanceAligner<TYPE>               aligner,
+        EditDistanceAligner<TYPE,algorithm_tag> aligner,
         const uint32                            offset,
         const uint8*                            str,
         const uint8*                            ref)
@@ -30,17 +30,243 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <vector>
 #include <algorithm>
 #include <nvbio/basic/timer.h>
 #include <nvbio/basic/console.h>
 #include <nvbio/basic/cuda/arch.h>
+#include <nvbio/basic/arena.h>
+#include <nvbio/basic/uninitialized_vector.h>
 
 namespace nvbio {
 
+namespace {
+
+// check that a pointer has the arena's default alignment
+//
+bool is_aligned(const void* ptr) { return (size_t( ptr ) & (HostArena::DEFAULT_ALIGNMENT-1u)) == 0u; }
+
+// test the HostArena mark/rewind semantics
+//
+void arena_test()
+{
+    HostArena arena;
+
+    // allocations are released in LIFO order, rewinding to a mark
+    uint8* a = arena.alloc<uint8>( 100 );
+    memset( a, 1, 100 );
+
+    const HostArena::Mark mark1 = arena.mark();
+    const uint64          used1 = arena.used();
+
+    uint8* b = arena.alloc<uint8>( 1000 );
+    memset( b, 2, 1000 );
+
+    const HostArena::Mark mark2 = arena.mark();
+    const uint64          used2 = arena.used();
+
+    // this doesn't fit the first chunk, and needs a new one
+    uint8* c = arena.alloc<uint8>( 3u << 20 );
+    memset( c, 3, 3u << 20 );
+
+    if (is_aligned( a ) == false || is_aligned( b ) == false || is_aligned( c ) == false)
+    {
+        log_error( stderr, "  arena: misaligned allocation\n" );
+        exit(1);
+    }
+    if (b < a + 100 || arena.used() < used2 + (3u << 20) || arena.high_water() < arena.used())
+    {
+        log_error( stderr, "  arena: wrong usage after allocating (%llu bytes)\n", arena.used() );
+        exit(1);
+    }
+
+    arena.rewind( mark2 );
+    if (arena.used() != used2 || a[99] != 1 || b[999] != 2)
+    {
+        log_error( stderr, "  arena: wrong state after rewinding a chunk (%llu bytes)\n", arena.used() );
+        exit(1);
+    }
+
+    arena.rewind( mark1 );
+    if (arena.used() != used1 || a[99] != 1)
+    {
+        log_error( stderr, "  arena: wrong state after rewinding (%llu bytes)\n", arena.used() );
+        exit(1);
+    }
+
+    // the released storage is handed out again
+    if (arena.alloc<uint8>( 1000 ) != b)
+    {
+        log_error( stderr, "  arena: rewound storage was not reused\n" );
+        exit(1);
+    }
+
+    // once empty, all chunks are consolidated in a single one covering the high-water mark
+    const uint64 high_water = arena.high_water();
+
+    arena.reset();
+    if (arena.used() != 0u || arena.high_water() != high_water || arena.capacity() < high_water)
+    {
+        log_error( stderr, "  arena: wrong state after a reset (%llu / %llu bytes)\n", arena.capacity(), high_water );
+        exit(1);
+    }
+
+    // and in steady state no more chunks are added
+    const uint64 capacity = arena.capacity();
+    for (uint32 r = 0; r < 4; ++r)
+    {
+        arena.alloc<uint8>( 100 );
+        arena.alloc<uint8>( 1000 );
+        arena.alloc<uint8>( 3u << 20 );
+        if (arena.capacity() != capacity)
+        {
+            log_error( stderr, "  arena: the capacity grew in steady state (%llu / %llu bytes)\n", arena.capacity(), capacity );
+            exit(1);
+        }
+        arena.reset();
+    }
+
+    // scopes rewind the arena on exit, even when nested
+    {
+        HostArena::Scope scope( arena );
+        uint32* p = scope.alloc<uint32>( 1000 );
+        p[999] = 42u;
+
+        const uint64 used = arena.used();
+        {
+            HostArena::Scope inner( arena );
+            float* q = inner.alloc<float>( 2u << 20 );
+            q[0] = 1.0f;
+
+            if (is_aligned( q ) == false || arena.used() < used + (8u << 20))
+            {
+                log_error( stderr, "  arena: wrong usage in a nested scope (%llu bytes)\n", arena.used() );
+                exit(1);
+            }
+        }
+        if (arena.used() != used || p[999] != 42u)
+        {
+            log_error( stderr, "  arena: nested scope not rewound (%llu bytes)\n", arena.used() );
+            exit(1);
+        }
+    }
+    if (arena.used() != 0u)
+    {
+        log_error( stderr, "  arena: scope not rewound (%llu bytes)\n", arena.used() );
+        exit(1);
+    }
+
+    // the thread arena is created once per thread
+    if (&thread_arena() != &thread_arena())
+    {
+        log_error( stderr, "  arena: thread arena is not persistent\n" );
+        exit(1);
+    }
+}
+
+// check the contents of a vector against the sequence 0, 1, 2, ...
+//
+bool check_sequence(const uninitialized_vector<uint32>& vec, const uint64 n)
+{
+    for (uint64 i = 0; i < n; ++i)
+    {
+        if (vec[i] != uint32(i))
+            return false;
+    }
+    return true;
+}
+
+// test that growing and copying an uninitialized_vector preserves its contents
+//
+void uninitialized_vector_test(const uint32 flags)
+{
+    const uint64 n_small = 1000u;
+    const uint64 n_large = 1u << 20;    // large enough to be mapped from the OS
+
+    uninitialized_vector<uint32> vec( flags );
+    for (uint64 i = 0; i < n_small; ++i)
+        vec.push_back( uint32(i) );
+
+    if (vec.size() != n_small || check_sequence( vec, n_small ) == false)
+    {
+        log_error( stderr, "  uninitialized_vector: push_back lost the contents\n" );
+        exit(1);
+    }
+
+    // grow past the mapping threshold, moving the contents
+    vec.resize( n_large );
+    if (vec.size() != n_large || vec.capacity() < n_large || check_sequence( vec, n_small ) == false)
+    {
+        log_error( stderr, "  uninitialized_vector: resize lost the contents\n" );
+        exit(1);
+    }
+
+    for (uint64 i = n_small; i < n_large; ++i)
+        vec[i] = uint32(i);
+
+    // grow again, filling the new elements
+    vec.resize( 3u*n_large, 7u );
+    if (vec.size() != 3u*n_large || check_sequence( vec, n_large ) == false)
+    {
+        log_error( stderr, "  uninitialized_vector: filling resize lost the contents\n" );
+        exit(1);
+    }
+    for (uint64 i = n_large; i < 3u*n_large; ++i)
+    {
+        if (vec[i] != 7u)
+        {
+            log_error( stderr, "  uninitialized_vector: element %llu not filled\n", i );
+            exit(1);
+        }
+    }
+
+    // shrinking keeps the storage
+    const uint64 capacity = vec.capacity();
+    vec.resize( n_large );
+    if (vec.capacity() != capacity || check_sequence( vec, n_large ) == false)
+    {
+        log_error( stderr, "  uninitialized_vector: shrinking lost the contents\n" );
+        exit(1);
+    }
+
+    // copy construction and assignment
+    uninitialized_vector<uint32> copy( vec );
+
+    uninitialized_vector<uint32> assigned( flags );
+    assigned.push_back( 5u );
+    assigned = vec;
+
+    if (copy.size()     != n_large || copy.flags() != flags || check_sequence( copy, n_large ) == false ||
+        assigned.size() != n_large || check_sequence( assigned, n_large ) == false ||
+        copy.data() == vec.data())
+    {
+        log_error( stderr, "  uninitialized_vector: copies do not match the original\n" );
+        exit(1);
+    }
+
+    // and copies are independent
+    copy[0] = 1u;
+    if (vec[0] != 0u || assigned[0] != 0u)
+    {
+        log_error( stderr, "  uninitialized_vector: copies share storage\n" );
+        exit(1);
+    }
+}
+
+} // anonymous namespace
+
 int alloc_test()
 {
     log_info( stderr, "alloc test... started\n" );
+
+    log_info( stderr, "  host arena\n" );
+    arena_test();
+
+    log_info( stderr, "  uninitialized vector\n" );
+    uninitialized_vector_test( HOST_ALLOC_DEFAULT );
+    uninitialized_vector_test( HOST_ALLOC_FIRST_TOUCH );
+
     const uint32 N_TESTS = 32;
 
     for (size_t size = 1024*1024; size <= size_t(1u << 30); size *= 4)
@@ -33,6 +33,9 @@
 #include <string.h>
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/cache.h>
+#include <nvbio/basic/page_cache.h>
+#include <nvbio/basic/exceptions.h>
+#include <vector>
 
 using namespace nvbio;
 
@@ -66,6 +69,74 @@ struct CacheManager
     uint32 m_size;
 };
 
+struct OrderedCacheManager
+{
+    // constructor
+    OrderedCacheManager() : m_size(0) {}
+
+    // acquire element i
+    bool acquire(const uint32 i)
+    {
+        if (m_size >= 4u)
+            return false;
+
+        ++m_size;
+        return true;
+    }
+
+    // release element i
+    void release(const uint32 i)
+    {
+        m_released.push_back( i );
+        --m_size;
+    }
+
+    // is cache usage below the low-watermark?
+    bool low_watermark() const
+    {
+        return (m_size < 4u);
+    }
+
+    uint32              m_size;
+    std::vector<uint32> m_released;
+};
+
+struct IdentityPageLoader : public PageLoader<uint32>
+{
+    // constructor
+    IdentityPageLoader(const uint32 page_size) : m_page_size( page_size ), m_loads(0) {}
+
+    // load a page
+    void load(const uint32 page, uint32* buffer)
+    {
+        for (uint32 i = 0; i < m_page_size; ++i)
+            buffer[i] = page * m_page_size + i;
+
+        ++m_loads;
+    }
+
+    uint32 m_page_size;
+    uint32 m_loads;
+};
+
+struct FailingPageLoader : public IdentityPageLoader
+{
+    // constructor
+    FailingPageLoader(const uint32 page_size, const uint32 failing_page) :
+        IdentityPageLoader( page_size ), m_failing_page( failing_page ) {}
+
+    // load a page, failing on the given one
+    void load(const uint32 page, uint32* buffer)
+    {
+        if (page == m_failing_page)
+            throw runtime_error( "failed reading page %u", page );
+
+        IdentityPageLoader::load( page, buffer );
+    }
+
+    uint32 m_failing_page;
+};
+
 int cache_test()
 {
     printf("cache test... started\n");
@@ -94,6 +165,183 @@ int cache_test()
         printf("  error: overflow was expected, but did not occurr!\n");
     else
         printf("  test overflow... done\n");
+
+    printf("  test LRU order... started\n");
+    {
+        OrderedCacheManager ordered_manager;
+
+        LRU<OrderedCacheManager> ordered_cache( ordered_manager );
+        for (uint32 i = 0; i < 4; ++i)
+        {
+            ordered_cache.pin(i);
+            ordered_cache.unpin(i);
+        }
+
+        // touch the two oldest elements, which should make 2 and 3 the next victims
+        ordered_cache.pin(1); ordered_cache.unpin(1);
+        ordered_cache.pin(0); ordered_cache.unpin(0);
+
+        ordered_cache.pin(4); ordered_cache.unpin(4);
+        ordered_cache.pin(5); ordered_cache.unpin(5);
+
+        if (ordered_manager.m_released.size() != 2u ||
+            ordered_manager.m_released[0] != 2u ||
+            ordered_manager.m_released[1] != 3u)
+        {
+            printf("  error: unexpected LRU eviction order\n");
+            exit(1);
+        }
+    }
+    printf("  test LRU order... done\n");
+
+    printf("  test page cache... started\n");
+    {
+        const uint32 PAGE_SIZE = 64;
+        const uint32 N_PAGES   = 32;
+
+        IdentityPageLoader loader( PAGE_SIZE );
+
+        PageCache<uint32> page_cache;
+        page_cache.setup( PAGE_SIZE * N_PAGES - 7u, PAGE_SIZE, 4u, &loader );
+
+        page_cache_iterator<uint32> it( &page_cache );
+        for (uint32 r = 0; r < 3; ++r)
+        {
+            for (uint32 i = 0; i < PAGE_SIZE * N_PAGES - 7u; ++i)
+            {
+                if (it[i] != i)
+                {
+                    printf("  error: page cache mismatch at %u: %u\n", i, it[i]);
+                    exit(1);
+                }
+            }
+        }
+        if (page_cache.misses() != loader.m_loads ||
+            page_cache.misses() != 3u * N_PAGES ||
+            page_cache.hits() + page_cache.misses() != 3u * (PAGE_SIZE * N_PAGES - 7u))
+        {
+            printf("  error: unexpected page cache statistics (%u loads, %llu misses)\n",
+                loader.m_loads, (unsigned long long)page_cache.misses());
+            exit(1);
+        }
+
+        // pinned pages must survive a full scan
+        page_cache.pin( 3 );
+        const uint32 loads = loader.m_loads;
+        for (uint32 i = 0; i < PAGE_SIZE * N_PAGES - 7u; ++i)
+            it[i];
+
+        if (loader.m_loads != loads + N_PAGES - 1u)
+        {
+            printf("  error: pinned page was evicted\n");
+            exit(1);
+        }
+        page_cache.unpin( 3 );
+
+        // and all pages can't be pinned at once
+        bool overflow = false;
+        try
+        {
+            for (uint32 p = 0; p < N_PAGES; ++p)
+                page_cache.pin( p );
+        }
+        catch (cache_overflow)
+        {
+            overflow = true;
+        }
+        if (overflow == false)
+        {
+            printf("  error: overflow was expected, but did not occurr!\n");
+            exit(1);
+        }
+
+        // the page which didn't fit must have been left out of the cache
+        for (uint32 p = 0; p < 4u; ++p)
+            page_cache.unpin( p );
+
+        for (uint32 i = 0; i < PAGE_SIZE * N_PAGES - 7u; ++i)
+        {
+            if (it[i] != i)
+            {
+                printf("  error: page cache mismatch at %u after an overflow: %u\n", i, it[i]);
+                exit(1);
+            }
+        }
+    }
+    printf("  test page cache... done\n");
+
+    printf("  test page loading errors... started\n");
+    {
+        const uint32 PAGE_SIZE = 64;
+        const uint32 N_PAGES   = 32;
+
+        FailingPageLoader loader( PAGE_SIZE, 5u );
+
+        PageCache<uint32> page_cache;
+        page_cache.setup( PAGE_SIZE * N_PAGES, PAGE_SIZE, 4u, &loader );
+
+        page_cache_iterator<uint32> it( &page_cache );
+
+        // fail both on a free frame and when evicting, through fetch() and pin()
+        for (uint32 r = 0; r < 2; ++r)
+        {
+            for (uint32 m = 0; m < 2; ++m)
+            {
+                bool failed = false;
+                try
+                {
+                    if (m == 0)
+                        it[ 5u * PAGE_SIZE + r ];
+                    else
+                        page_cache.pin( 5u );
+                }
+                catch (runtime_error)
+                {
+                    failed = true;
+                }
+                if (failed == false)
+                {
+                    printf("  error: loading error was expected, but did not occurr!\n");
+                    exit(1);
+                }
+            }
+
+            // scan all pages but the failing one, filling the cache
+            for (uint32 i = 0; i < PAGE_SIZE * N_PAGES; ++i)
+            {
+                if (i / PAGE_SIZE == 5u)
+                    continue;
+
+                if (it[i] != i)
+                {
+                    printf("  error: page cache mismatch at %u after a loading error: %u\n", i, it[i]);
+                    exit(1);
+                }
+            }
+        }
+
+        // once the page can be read, it must be loaded again rather than found in a lost frame
+        loader.m_failing_page = N_PAGES;
+        for (uint32 r = 0; r < 2; ++r)
+        {
+            for (uint32 i = 0; i < PAGE_SIZE * N_PAGES; ++i)
+            {
+                if (it[i] != i)
+                {
+                    printf("  error: page cache mismatch at %u after recovering: %u\n", i, it[i]);
+                    exit(1);
+                }
+            }
+        }
+
+        // and all the frames must still be usable
+        for (uint32 p = 0; p < 4u; ++p)
+            page_cache.pin( p );
+        for (uint32 p = 0; p < 4u; ++p)
+            page_cache.unpin( p );
+    }
+    printf("  test page loading errors... done\n");
+
     printf("cache test... done\n");
     return 0u;
 }
\ No newline at end of file
@@ -51,8 +51,11 @@
 #include <nvbio/fmindex/ssa.h>
 #include <nvbio/fmindex/fmindex.h>
 #include <nvbio/fmindex/backtrack.h>
+#include <nvbio/fmindex/search_scheme.h>
+#include <nvbio/fmindex/batched_locate.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/fmindex/fmindex.h>
+#include <nvbio/io/fmindex/fmindex_paged.h>
 
 using namespace nvbio;
 
@@ -716,6 +719,226 @@ void synthetic_test(const uint32 LEN, const uint32 QUERIES)
     fprintf(stderr, "  shuffled alignment tests... done\n" );
 }
 
+//
+// build a host FM-index over a 2-bit text
+//
+template <typename text_type>
+void build_host_fmindex(
+    const uint32            LEN,
+    const text_type         text,
+    uint32&                 primary,
+    std::vector<uint32>&    bwt_vec,
+    std::vector<uint32>&    occ_vec,
+    std::vector<uint32>&    ssa_vec,
+    uint32*                 L2)
+{
+    const uint32 SA_INT = 16;
+    const uint32 WORDS  = align<4>( util::divide_ri( LEN, 16u ) );
+
+    std::vector<int32> sa( LEN+1 );
+    gen_sa( LEN, text, &sa[0] );
+
+    bwt_vec.resize( WORDS, 0u );
+    occ_vec.resize( WORDS, 0u );
+
+    typedef PackedStream<uint32*,uint8,2u,true> stream_type;
+    stream_type bwt( &bwt_vec[0] );
+
+    primary = gen_bwt_from_sa( LEN, text, &sa[0], bwt );
+
+    build_occurrence_table<2u,64u>(
+        bwt,
+        bwt + LEN,
+        &occ_vec[0],
+        &L2[1] );
+
+    L2[0] = 0;
+    for (uint32 c = 0; c < 4; ++c)
+        L2[c+1] += L2[c];
+
+    ssa_vec.resize( (LEN + SA_INT) / SA_INT );
+    for (uint32 i = 0; i < ssa_vec.size(); ++i)
+        ssa_vec[i] = uint32( sa[i*SA_INT] );
+    ssa_vec[0] = uint32(-1);
+}
+
+//
+// A string-set of fixed length patterns stored as plain symbol arrays
+//
+struct PatternSet
+{
+    typedef vector_view<const uint8*> string_type;
+
+    PatternSet(const uint32 n, const uint32 len, const uint8* symbols) : m_n( n ), m_len( len ), m_symbols( symbols ) {}
+
+    uint32      size() const { return m_n; }
+    string_type operator[] (const uint32 i) const { return string_type( m_len, m_symbols + i*m_len ); }
+
+    uint32       m_n;
+    uint32       m_len;
+    const uint8* m_symbols;
+};
+
+//
+// A backtracking delegate used to count the total number of occurrences on the host
+//
+struct HostCountDelegate
+{
+    HostCountDelegate() : m_count(0) {}
+
+    void operator() (const uint2 range) { m_count += range.y + 1u - range.x; }
+
+    uint64 m_count;
+};
+
+//
+// test the search scheme filter against a brute-force Hamming distance search
+//
+void search_scheme_test(const uint32 LEN, const uint32 N_QUERIES)
+{
+    fprintf(stderr, "  search scheme test... started\n");
+
+    const uint32 PLEN  = 40;
+    const uint32 WORDS = align<4>( util::divide_ri( LEN, 16u ) );
+
+    typedef PackedStream<uint32*,uint8,2u,true> stream_type;
+
+    std::vector<uint32> text_vec( WORDS, 0u );
+    std::vector<uint32> rtext_vec( WORDS, 0u );
+    stream_type text( &text_vec[0] );
+    stream_type rtext( &rtext_vec[0] );
+
+    for (uint32 i = 0; i < LEN; ++i)
+        text[i] = rand() % 4;
+
+    // plant some approximate repeats
+    for (uint32 r = 0; r < LEN / 500; ++r)
+    {
+        const uint32 src = rand() % (LEN - PLEN);
+        const uint32 dst = rand() % (LEN - PLEN);
+        for (uint32 j = 0; j < PLEN; ++j)
+            text[dst+j] = (rand() % 16) ? uint8( text[src+j] ) : uint8( rand() % 4 );
+    }
+
+    for (uint32 i = 0; i < LEN; ++i)
+        rtext[i] = text[LEN-1-i];
+
+    uint32 count_table[256];
+    gen_bwt_count_table( count_table );
+
+    uint32 primary, rprimary;
+    uint32 L2[5], rL2[5];
+    std::vector<uint32> bwt_vec, occ_vec, ssa_vec;
+    std::vector<uint32> rbwt_vec, rocc_vec, rssa_vec;
+
+    build_host_fmindex( LEN, text,  primary,  bwt_vec,  occ_vec,  ssa_vec,  L2 );
+    build_host_fmindex( LEN, rtext, rprimary, rbwt_vec, rocc_vec, rssa_vec, rL2 );
+
+    typedef PackedStream<const uint32*,uint8,2u,true>                           bwt_type;
+    typedef rank_dictionary<2u, 64u, bwt_type, const uint32*, const uint32*>    rank_dict_type;
+    typedef SSA_index_multiple_context<16u, const uint32*>                      ssa_type;
+    typedef fm_index<rank_dict_type, ssa_type>                                  fm_index_type;
+    typedef fm_index<rank_dict_type, null_type>                                 rfm_index_type;
+
+    const fm_index_type f_fmi(
+        LEN,
+        primary,
+        L2,
+        rank_dict_type( bwt_type( &bwt_vec[0] ), &occ_vec[0], count_table ),
+        ssa_type( &ssa_vec[0] ) );
+
+    const rfm_index_type r_fmi(
+        LEN,
+        rprimary,
+        rL2,
+        rank_dict_type( bwt_type( &rbwt_vec[0] ), &rocc_vec[0], count_table ),
+        null_type() );
+
+    // sample the patterns from the text, adding up to 3 mismatches
+    std::vector<uint8> patterns( N_QUERIES * PLEN );
+    for (uint32 i = 0; i < N_QUERIES; ++i)
+    {
+        const uint32 offset = (i == 0) ? 0u : (i == 1) ? LEN - PLEN : rand() % (LEN - PLEN);
+        for (uint32 j = 0; j < PLEN; ++j)
+            patterns[ i*PLEN + j ] = text[ offset + j ];
+
+        const uint32 n_mismatches = rand() % 4;
+        for (uint32 m = 0; m < n_mismatches; ++m)
+            patterns[ i*PLEN + rand() % PLEN ] = rand() % 4;
+    }
+    const PatternSet pattern_set( N_QUERIES, PLEN, &patterns[0] );
+
+    for (uint32 k = 0; k <= 3; ++k)
+    {
+        // find all occurrences with a brute-force search
+        std::vector<uint64> expected_hits;
+        for (uint32 i = 0; i < N_QUERIES; ++i)
+        {
+            for (uint32 p = 0; p + PLEN <= LEN; ++p)
+            {
+                uint32 mismatches = 0;
+                for (uint32 j = 0; j < PLEN && mismatches <= k; ++j)
+                    mismatches += (patterns[ i*PLEN + j ] != text[p+j]) ? 1u : 0u;
+
+                if (mismatches <= k)
+                    expected_hits.push_back( (uint64( i ) << 32) | p );
+            }
+        }
+
+        for (uint32 s = 0; s < 2; ++s)
+        {
+            const SearchScheme scheme = s ? seed_01x0_search_scheme( k ) : pigeonhole_search_scheme( k );
+
+            Timer timer;
+            timer.start();
+
+            SearchSchemeFilterHost<fm_index_type,rfm_index_type> filter;
+            const uint64 n_hits = filter.rank( f_fmi, r_fmi, scheme, pattern_set );
+
+            timer.stop();
+            const float scheme_time = timer.seconds();
+
+            std::vector<uint2> hits( n_hits );
+            filter.locate( 0u, n_hits, hits.begin() );
+
+            // sort the hits by string-id and position
+            std::vector<uint64> sorted_hits( n_hits );
+            for (uint64 i = 0; i < n_hits; ++i)
+                sorted_hits[i] = (uint64( hits[i].y ) << 32) | hits[i].x;
+            std::sort( sorted_hits.begin(), sorted_hits.end() );
+
+            // and compare them against the brute-force search
+            if (sorted_hits != expected_hits)
+            {
+                fprintf(stderr, "  \nerror : %s search scheme with %u mismatches found %llu hits, expected %llu\n",
+                    s ? "01*0" : "pigeonhole", k,
+                    (unsigned long long)n_hits,
+                    (unsigned long long)expected_hits.size());
+                exit(1);
+            }
+
+            // compare with an exhaustive backtracking search
+            timer.start();
+
+            std::vector<uint4> stack( PLEN*4 );
+            uint64 n_backtrack_hits = 0;
+            for (uint32 i = 0; i < N_QUERIES; ++i)
+            {
+                HostCountDelegate counter;
+                hamming_backtrack( f_fmi, &patterns[ i*PLEN ], PLEN, 0u, k, &stack[0], counter );
+                n_backtrack_hits += counter.m_count;
+            }
+            timer.stop();
+
+            fprintf(stderr, "    %-10s k=%u : %6llu hits, %7.2f ms (backtracking: %6llu hits, %7.2f ms)\n",
+                s ? "01*0" : "pigeonhole", k,
+                (unsigned long long)n_hits, scheme_time * 1000.0f,
+                (unsigned long long)n_backtrack_hits, timer.seconds() * 1000.0f);
+        }
+    }
+    fprintf(stderr, "  search scheme test... done\n");
+}
+
 //
 // A backtracking delegate used to count the total number of occurrences
 //
@@ -1003,6 +1226,158 @@ void backtrack_test(const char* index_file, const char* reads_name, const uint32
         log_warning(stderr, "unable to load \"%s\"\n", index_file);
 }
 
+//
+// test the batched host locate against the sequential one
+//
+void batched_locate_test(const uint32 LEN, const uint32 N_QUERIES)
+{
+    fprintf(stderr, "  batched locate test... started\n");
+
+    const uint32 PLEN  = 10;
+    const uint32 RLEN  = 100;
+    const uint32 WORDS = align<4>( util::divide_ri( LEN, 16u ) );
+
+    typedef PackedStream<uint32*,uint8,2u,true> stream_type;
+
+    std::vector<uint32> text_vec( WORDS, 0u );
+    stream_type text( &text_vec[0] );
+
+    for (uint32 i = 0; i < LEN; ++i)
+        text[i] = rand() % 4;
+
+    // plant some exact repeats, so as to get large ranges
+    for (uint32 r = 0; r < LEN / 200; ++r)
+    {
+        const uint32 src = rand() % (LEN - RLEN);
+        const uint32 dst = rand() % (LEN - RLEN);
+        for (uint32 j = 0; j < RLEN; ++j)
+            text[dst+j] = uint8( text[src+j] );
+    }
+
+    uint32 count_table[256];
+    gen_bwt_count_table( count_table );
+
+    uint32 primary;
+    uint32 L2[5];
+    std::vector<uint32> bwt_vec, occ_vec, ssa_vec;
+
+    build_host_fmindex( LEN, text, primary, bwt_vec, occ_vec, ssa_vec, L2 );
+
+    typedef PackedStream<const uint32*,uint8,2u,true>                           bwt_type;
+    typedef rank_dictionary<2u, 64u, bwt_type, const uint32*, const uint32*>    rank_dict_type;
+    typedef SSA_index_multiple_context<16u, const uint32*>                      ssa_type;
+    typedef fm_index<rank_dict_type, ssa_type>                                  fm_index_type;
+
+    const fm_index_type fmi(
+        LEN,
+        primary,
+        L2,
+        rank_dict_type( bwt_type( &bwt_vec[0] ), &occ_vec[0], count_table ),
+        ssa_type( &ssa_vec[0] ) );
+
+    // rank short patterns sampled from the text
+    std::vector<uint2> ranges( N_QUERIES );
+    uint64 n_hits = 0;
+    for (uint32 i = 0; i < N_QUERIES; ++i)
+    {
+        ranges[i] = match( fmi, text + rand() % (LEN - PLEN), PLEN );
+        n_hits += 1u + ranges[i].y - ranges[i].x;
+    }
+
+    std::vector<uint32> batched_hits( n_hits );
+    std::vector<uint32> hits( n_hits );
+
+    Timer timer;
+    timer.start();
+
+    batched_locate_ranges( fmi, N_QUERIES, &ranges[0], &batched_hits[0] );
+
+    timer.stop();
+    const float batched_time = timer.seconds();
+
+    timer.start();
+
+    for (uint32 i = 0, k = 0; i < N_QUERIES; ++i)
+    {
+        for (uint32 r = ranges[i].x; r <= ranges[i].y; ++r)
+            hits[k++] = locate( fmi, r );
+    }
+
+    timer.stop();
+
+    if (batched_hits != hits)
+    {
+        fprintf(stderr, "  \nerror : batched locate mismatch\n");
+        exit(1);
+    }
+
+    fprintf(stderr, "    %llu hits : %7.2f ms (sequential: %7.2f ms)\n",
+        (unsigned long long)n_hits, batched_time * 1000.0f, timer.seconds() * 1000.0f);
+
+    fprintf(stderr, "  batched locate test... done\n");
+}
+
+//
+// test the out-of-core FM-index against the in-core one, paging it through a cache
+// much smaller than the index
+//
+void paged_fmindex_test(const char* index_file, const uint32 n_queries)
+{
+    io::FMIndexDataHost h_fmi;
+    if (h_fmi.load( index_file, io::FMIndexData::FORWARD | io::FMIndexData::SA ) == false)
+    {
+        log_warning(stderr, "unable to load \"%s\"\n", index_file);
+        return;
+    }
+
+    fprintf(stderr, "  paged FM-index test... started\n");
+
+    io::FMIndexDataPaged p_fmi;
+    if (p_fmi.load( index_file, 16u*1024u*1024u, io::FMIndexDataPaged::FORWARD | io::FMIndexDataPaged::SA ) == false)
+    {
+        fprintf(stderr, "  \nerror : unable to page \"%s\"\n", index_file);
+        exit(1);
+    }
+
+    const io::FMIndexData::fm_index_type      fmi  = h_fmi.index();
+    const io::FMIndexDataPaged::fm_index_type pfmi = p_fmi.index();
+
+    const uint32 PLEN = 12;
+    uint8 pattern[PLEN];
+
+    uint64 n_hits = 0;
+    for (uint32 i = 0; i < n_queries; ++i)
+    {
+        for (uint32 j = 0; j < PLEN; ++j)
+            pattern[j] = uint8( rand() % 4 );
+
+        const uint2 range  = match( fmi,  pattern, PLEN );
+        const uint2 prange = match( pfmi, pattern, PLEN );
+        if (range.x != prange.x || range.y != prange.y)
+        {
+            fprintf(stderr, "  \nerror : paged match mismatch: [%u,%u] != [%u,%u]\n", prange.x, prange.y, range.x, range.y);
+            exit(1);
+        }
+
+        // locate the first few occurrences
+        for (uint32 r = range.x; r <= range.y && r < range.x + 4u; ++r, ++n_hits)
+        {
+            const uint32 pos  = locate( fmi,  r );
+            const uint32 ppos = locate( pfmi, r );
+            if (pos != ppos)
+            {
+                fprintf(stderr, "  \nerror : paged locate mismatch at row %u: %u != %u\n", r, ppos, pos);
+                exit(1);
+            }
+        }
+    }
+
+    fprintf(stderr, "    %llu hits, %llu page misses\n",
+        (unsigned long long)n_hits, (unsigned long long)p_fmi.misses());
+
+    fprintf(stderr, "  paged FM-index test... done\n");
+}
+
 int fmindex_test(int argc, char* argv[])
 {
     uint32 synth_len     = 10000000;
@@ -1011,6 +1386,9 @@ int fmindex_test(int argc, char* argv[])
     const char* index_name = "./data/human.NCBI36/Human.NCBI36";
     const char* reads_name = "./data/SRR493095_1.fastq.gz";
     uint32 backtrack_queries = 64*1024;
+    uint32 scheme_queries    = 256;
+    uint32 locate_queries    = 4096;
+    uint32 paged_queries     = 4096;
     uint32 threads           = omp_get_num_procs();
 
     for (int i = 0; i < argc; ++i)
@@ -1021,6 +1399,12 @@ int fmindex_test(int argc, char* argv[])
             synth_queries = atoi( argv[++i] )*1000;
         else if (strcmp( argv[i], "-backtrack-queries" ) == 0)
             backtrack_queries = atoi( argv[++i] ) * 1024;
+        else if (strcmp( argv[i], "-scheme-queries" ) == 0)
+            scheme_queries = atoi( argv[++i] );
+        else if (strcmp( argv[i], "-locate-queries" ) == 0)
+            locate_queries = atoi( argv[++i] );
+        else if (strcmp( argv[i], "-paged-queries" ) == 0)
+            paged_queries = atoi( argv[++i] );
         else if (strcmp( argv[i], "-index" ) == 0)
             index_name = argv[++i];
         else if (strcmp( argv[i], "-reads" ) == 0)
@@ -1039,6 +1423,15 @@ int fmindex_test(int argc, char* argv[])
         synthetic_test<uint64>( synth_len, synth_queries );
     }
 
+    if (scheme_queries)
+        search_scheme_test( 256*1024, scheme_queries );
+
+    if (locate_queries)
+        batched_locate_test( 1024*1024, locate_queries );
+
+    if (paged_queries)
+        paged_fmindex_test( index_name, paged_queries );
+
     if (backtrack_queries)
         backtrack_test( index_name, reads_name, backtrack_queries );
 
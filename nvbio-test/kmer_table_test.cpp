@@ -0,0 +1,240 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// kmer_table_test.cpp
+//
+
+#include <nvbio/basic/kmer_table.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/timer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <map>
+
+namespace nvbio {
+
+namespace {
+
+// check the counts of all kmers in a table against a reference map
+//
+bool check_counts(const HostKmerTable& table, const std::map<uint64,uint32>& ref, const char* name)
+{
+    if (table.size() != ref.size())
+    {
+        log_error( stderr, "  %s: wrong size: %llu != %llu\n", name, table.size(), uint64( ref.size() ) );
+        return false;
+    }
+
+    for (std::map<uint64,uint32>::const_iterator it = ref.begin(); it != ref.end(); ++it)
+    {
+        const uint64 slot = table.find( it->first );
+        if (slot == HostKmerTable::INVALID_SLOT)
+        {
+            log_error( stderr, "  %s: key %llx not found\n", name, it->first );
+            return false;
+        }
+        if (table.slot_key( slot ) != it->first || table.slot_count( slot ) != it->second)
+        {
+            log_error( stderr, "  %s: key %llx has count %u != %u\n", name, it->first, table.slot_count( slot ), it->second );
+            return false;
+        }
+    }
+
+    // check that all copied keys are in the reference
+    std::vector<uint64> keys( table.size() );
+    std::vector<uint32> counts( table.size() );
+    const uint64 n_copied = table.copy( &keys[0], &counts[0] );
+    if (n_copied != ref.size())
+    {
+        log_error( stderr, "  %s: copied %llu keys != %llu\n", name, n_copied, uint64( ref.size() ) );
+        return false;
+    }
+    for (uint64 i = 0; i < n_copied; ++i)
+    {
+        std::map<uint64,uint32>::const_iterator it = ref.find( keys[i] );
+        if (it == ref.end() || it->second != counts[i])
+        {
+            log_error( stderr, "  %s: copied key %llx is wrong\n", name, keys[i] );
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int kmer_table_test()
+{
+    printf("kmer table test... started\n");
+
+    // count a skewed random kmer set, inserting one key at a time
+    {
+        const uint32 n_kmers = 100000;
+
+        std::vector<uint64>      kmers( n_kmers );
+        std::map<uint64,uint32>  ref;
+
+        srand(0);
+        for (uint32 i = 0; i < n_kmers; ++i)
+        {
+            // draw from a small pool half of the time, to get some repeated keys
+            const uint64 r = (uint64( rand() ) << 31) | uint64( rand() );
+            kmers[i] = (i & 1) ? r : (r % 1000u);
+            ref[ kmers[i] ]++;
+        }
+        // and make sure the special key gets tested too
+        if (--ref[ kmers[0] ] == 0u)
+            ref.erase( kmers[0] );
+
+        kmers[0] = HostKmerTable::EMPTY_KEY;
+        ref[ kmers[0] ]++;
+
+        HostKmerTable table( n_kmers );
+        for (uint32 i = 0; i < n_kmers; ++i)
+            table.insert( kmers[i] );
+
+        if (check_counts( table, ref, "single" ) == false)
+            exit(1);
+
+        // insert the same set in bulk, starting from a tiny table to exercise growth
+        HostKmerTable bulk_table;
+
+        Timer timer;
+        timer.start();
+
+        bulk_table.insert( n_kmers, &kmers[0] );
+
+        timer.stop();
+
+        if (check_counts( bulk_table, ref, "bulk" ) == false)
+            exit(1);
+
+        log_info( stderr, "  bulk insertion: %.2f M kmers/s\n", 1.0e-6f * float(n_kmers) / timer.seconds() );
+
+        // check bulk counting
+        std::vector<uint32> counts( n_kmers );
+        bulk_table.count( n_kmers, &kmers[0], &counts[0] );
+        for (uint32 i = 0; i < n_kmers; ++i)
+        {
+            if (counts[i] != ref[ kmers[i] ])
+            {
+                log_error( stderr, "  bulk count: key %llx has count %u != %u\n", kmers[i], counts[i], ref[ kmers[i] ] );
+                exit(1);
+            }
+        }
+
+        // check the spectrum
+        const uint32 max_count = 64;
+        std::vector<uint64> spectrum( max_count + 1u );
+        std::vector<uint64> ref_spectrum( max_count + 1u, 0u );
+        bulk_table.spectrum( max_count, &spectrum[0] );
+
+        for (std::map<uint64,uint32>::const_iterator it = ref.begin(); it != ref.end(); ++it)
+            ++ref_spectrum[ nvbio::min( it->second, max_count ) ];
+
+        for (uint32 i = 0; i <= max_count; ++i)
+        {
+            if (spectrum[i] != ref_spectrum[i])
+            {
+                log_error( stderr, "  spectrum[%u] = %llu != %llu\n", i, spectrum[i], ref_spectrum[i] );
+                exit(1);
+            }
+        }
+
+        // check that clearing empties the table
+        bulk_table.clear();
+        if (bulk_table.size() || bulk_table.count( kmers[1] ))
+        {
+            log_error( stderr, "  clear: table not empty\n" );
+            exit(1);
+        }
+    }
+
+    // insert keys colliding on the same probe sequence, forcing overflows
+    {
+        const uint32 n_kmers  = 256;
+        const uint32 max_keys = HostKmerTable::MAX_PROBES * HostKmerTable::BUCKET_SLOTS;
+
+        // pick keys all hashing to the first bucket of any table of up to 4096 buckets
+        std::vector<uint64>      kmers;
+        std::map<uint64,uint32>  ref;
+        for (uint64 key = 0; kmers.size() < n_kmers; ++key)
+        {
+            if ((hash( key ) & 4095u) == 0u)
+            {
+                kmers.push_back( key );
+                ref[ key ] = 1u;
+            }
+        }
+
+        // single insertions never grow the table, so that once the shared probe sequence
+        // is full all further keys must be rejected
+        {
+            HostKmerTable table;
+            const uint64 capacity = table.capacity();
+
+            for (uint32 i = 0; i < n_kmers; ++i)
+            {
+                const bool overflow = table.insert( kmers[i] ) == HostKmerTable::INVALID_SLOT;
+                if (overflow != (i >= max_keys))
+                {
+                    log_error( stderr, "  overflow: key %u %s\n", i, overflow ? "rejected" : "accepted" );
+                    exit(1);
+                }
+            }
+            if (table.size() != max_keys || table.capacity() != capacity)
+            {
+                log_error( stderr, "  overflow: %llu keys in %llu slots\n", table.size(), table.capacity() );
+                exit(1);
+            }
+        }
+
+        // the bulk insertion only reserves enough room for its maximum load, and has
+        // to grow the table further to place the overflowing keys
+        {
+            const HostKmerTable reserved( n_kmers );
+
+            HostKmerTable table;
+            table.insert( n_kmers, &kmers[0] );
+
+            if (table.capacity() <= reserved.capacity())
+            {
+                log_error( stderr, "  overflow: the table was not grown (%llu slots)\n", table.capacity() );
+                exit(1);
+            }
+            if (check_counts( table, ref, "overflow" ) == false)
+                exit(1);
+        }
+    }
+
+    printf("kmer table test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
@@ -0,0 +1,207 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// lz4_test.cpp
+//
+
+#include <nvbio/io/input_stream.h>
+#include <nvbio/io/output_stream.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/omp.h>
+#include <lz4/lz4frame.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace nvbio {
+
+namespace {
+
+const char* LZ4_TEST_FILE = "nvbio-test.lz4";
+
+// read a whole file through a ParallelLZ4InputFile, in chunks of random sizes,
+// returning true if it matches the given content and the stream reports no errors
+//
+bool read_and_compare(const std::vector<uint8>& data, const uint32 max_chunk)
+{
+    ParallelLZ4InputFile file( LZ4_TEST_FILE );
+    if (file.is_valid() == false)
+        return false;
+
+    std::vector<uint8> chunk( max_chunk );
+
+    uint64 offset = 0;
+    while (1)
+    {
+        const uint32 n_bytes = 1u + rand() % max_chunk;
+        const uint32 n_read  = file.read( n_bytes, &chunk[0] );
+
+        if (offset + n_read > data.size() ||
+            memcmp( &chunk[0], &data[0] + offset, n_read ) != 0)
+            return false;
+
+        offset += n_read;
+        if (n_read < n_bytes)
+            break;
+    }
+    return offset == data.size() && file.is_valid();
+}
+
+// write a whole buffer through a ParallelLZ4OutputFile, in chunks of random sizes
+//
+bool write(const std::vector<uint8>& data, const uint32 block_size_id, const bool checksums, const uint32 max_chunk)
+{
+    ParallelLZ4OutputFile file( LZ4_TEST_FILE, "1", block_size_id, checksums );
+    if (file.is_valid() == false)
+        return false;
+
+    for (uint64 offset = 0; offset < data.size();)
+    {
+        const uint32 n_bytes = uint32( nvbio::min( uint64( 1u + rand() % max_chunk ), data.size() - offset ) );
+        if (file.write( n_bytes, &data[0] + offset ) != n_bytes)
+            return false;
+
+        offset += n_bytes;
+    }
+    return true;
+}
+
+// flip a byte of the test file at a given offset from its beginning or, if negative, its end
+//
+void corrupt(const int64 offset)
+{
+    FILE* file = fopen( LZ4_TEST_FILE, "r+b" );
+    fseek( file, long( offset ), offset < 0 ? SEEK_END : SEEK_SET );
+
+    const int c = fgetc( file );
+    fseek( file, long( offset ), offset < 0 ? SEEK_END : SEEK_SET );
+    fputc( c ^ 0x20, file );
+    fclose( file );
+}
+
+} // anonymous namespace
+
+int lz4_test()
+{
+    printf("LZ4 test... started\n");
+
+    const int max_threads = omp_get_max_threads();
+
+    // build a mix of compressible text and incompressible runs, not aligned to any block size
+    std::vector<uint8> data( 5u*1024u*1024u + 12345u );
+    {
+        const char dna[] = "ACGT";
+        for (uint32 i = 0; i < data.size(); ++i)
+            data[i] = (i / 300000u) & 1u ? uint8( rand() ) : uint8( dna[ (i * 7u + rand() % 2u) & 3u ] );
+    }
+
+    const uint32 threads[] = { 1u, 2u, 4u };
+
+    for (uint32 block_size_id = 4; block_size_id <= 7; ++block_size_id)
+    {
+        for (uint32 checksums = 0; checksums < 2; ++checksums)
+        {
+            for (uint32 t = 0; t < 3; ++t)
+            {
+                // write and read with different thread counts, so as to use different batch sizes
+                omp_set_num_threads( threads[t] );
+                if (write( data, block_size_id, checksums, 3u*1024u*1024u ) == false)
+                {
+                    log_error(stderr, "  failed writing %s\n", LZ4_TEST_FILE);
+                    exit(1);
+                }
+
+                omp_set_num_threads( threads[ (t + 1u) % 3u ] );
+                if (read_and_compare( data, 1024u*1024u ) == false)
+                {
+                    log_error(stderr, "  round-trip mismatch (block size id %u, checksums %u, %u threads)\n",
+                        block_size_id, checksums, threads[t]);
+                    exit(1);
+                }
+            }
+        }
+    }
+    omp_set_num_threads( max_threads );
+
+    // corrupt data must be detected by the header, block and content checksums
+    {
+        const int64 offsets[] = { 5, 7 + 4 + 100, -1 };
+        const char* names[]   = { "header", "block", "content" };
+
+        for (uint32 i = 0; i < 3; ++i)
+        {
+            if (write( data, 4u, true, 1024u*1024u ) == false)
+            {
+                log_error(stderr, "  failed writing %s\n", LZ4_TEST_FILE);
+                exit(1);
+            }
+            corrupt( offsets[i] );
+
+            if (read_and_compare( data, 1024u*1024u ))
+            {
+                log_error(stderr, "  %s checksum mismatch not detected\n", names[i]);
+                exit(1);
+            }
+        }
+    }
+
+    // frames with linked blocks written by the reference encoder must be decoded too
+    {
+        LZ4F_preferences_t preferences;
+        memset( &preferences, 0, sizeof(preferences) );
+        preferences.frameInfo.blockSizeID         = max64KB;
+        preferences.frameInfo.blockMode           = blockLinked;
+        preferences.frameInfo.contentChecksumFlag = contentChecksumEnabled;
+
+        std::vector<uint8> frame( LZ4F_compressFrameBound( data.size(), &preferences ) );
+        const size_t frame_size = LZ4F_compressFrame( &frame[0], frame.size(), &data[0], data.size(), &preferences );
+
+        FILE* file = fopen( LZ4_TEST_FILE, "wb" );
+        if (LZ4F_isError( frame_size ) || file == NULL || fwrite( &frame[0], 1u, frame_size, file ) != frame_size)
+        {
+            log_error(stderr, "  failed writing %s\n", LZ4_TEST_FILE);
+            exit(1);
+        }
+        fclose( file );
+
+        if (read_and_compare( data, 1024u*1024u ) == false)
+        {
+            log_error(stderr, "  linked frame mismatch\n");
+            exit(1);
+        }
+    }
+
+    remove( LZ4_TEST_FILE );
+
+    printf("LZ4 test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
@@ -58,6 +58,9 @@ int qgram_test(int argc, char* argv[]);
 int sequence_test(int argc, char* argv[]);
 int wavelet_test(int argc, char* argv[]);
 int bloom_filter_test(int argc, char* argv[]);
+int kmer_table_test();
+int vcf_test();
+int lz4_test();
 
 namespace cuda { void scan_test(); }
 namespace aln { void test(int argc, char* argv[]); }
@@ -86,6 +89,9 @@ enum Tests {
     kSequence       = 131072u,
     kWaveletTree    = 262144u,
     kBloomFilter    = 524288u,
+    kKmerTable      = 1048576u,
+    kVCF            = 2097152u,
+    kLZ4            = 4194304u,
     kALL            = 0xFFFFFFFFu
 };
 
@@ -151,6 +157,12 @@ int main(int argc, char* argv[])
                     tests = kWaveletTree;
                 else if (strcmp( argv[arg], "-bloom-filter" ) == 0)
                     tests = kBloomFilter;
+                else if (strcmp( argv[arg], "-kmer-table" ) == 0)
+                    tests = kKmerTable;
+                else if (strcmp( argv[arg], "-vcf" ) == 0)
+                    tests = kVCF;
+                else if (strcmp( argv[arg], "-lz4" ) == 0)
+                    tests = kLZ4;
 
                 ++arg;
             }
@@ -216,6 +228,9 @@ int main(int argc, char* argv[])
         if (tests & kSequence)      sequence_test( argc, argv+arg );
         if (tests & kWaveletTree)   wavelet_test( argc, argv+arg );
         if (tests & kBloomFilter)   bloom_filter_test( argc, argv+arg );
+        if (tests & kKmerTable)     kmer_table_test();
+        if (tests & kVCF)           vcf_test();
+        if (tests & kLZ4)           lz4_test();
 
         cudaDeviceReset();
     	return 0;
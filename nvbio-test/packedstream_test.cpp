@@ -35,6 +35,9 @@
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/cached_iterator.h>
 #include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/packedstream_transcode.h>
+#include <nvbio/basic/timer.h>
+#include <vector>
 #include <sais.h>
 
 using namespace nvbio;
@@ -70,6 +73,132 @@ bool check_forward_stream(const uint8* uncomp_stream, CompStream comp_stream)
     return true;
 }
 
+// the transcoding operators under test, each with its symbol-by-symbol definition
+//
+struct RepackOp
+{
+    static const char* name() { return "repack"; }
+    static uint8 expected(const uint8* in, const uint32 n, const uint32 i) { return in[i]; }
+
+    template <typename InStream, typename OutStream>
+    static uint64 run(const uint32 n, const InStream in, OutStream out) { packed_repack( n, in, out ); return 0u; }
+};
+struct ReverseOp
+{
+    static const char* name() { return "reverse"; }
+    static uint8 expected(const uint8* in, const uint32 n, const uint32 i) { return in[n-1-i]; }
+
+    template <typename InStream, typename OutStream>
+    static uint64 run(const uint32 n, const InStream in, OutStream out) { packed_reverse( n, in, out ); return 0u; }
+};
+struct ReverseComplementOp
+{
+    static const char* name() { return "reverse-complement"; }
+    static uint8 expected(const uint8* in, const uint32 n, const uint32 i) { const uint8 c = in[n-1-i]; return c < 4u ? 3u - c : c; }
+
+    template <typename InStream, typename OutStream>
+    static uint64 run(const uint32 n, const InStream in, OutStream out) { packed_reverse_complement( n, in, out ); return 0u; }
+};
+struct WidenOp
+{
+    static const char* name() { return "widen"; }
+    static uint8 expected(const uint8* in, const uint32 n, const uint32 i) { return in[i]; }
+
+    template <typename InStream, typename OutStream>
+    static uint64 run(const uint32 n, const InStream in, OutStream out) { packed_widen( n, in, out ); return 0u; }
+};
+struct NarrowOp
+{
+    static const char* name() { return "narrow"; }
+    static uint8 expected(const uint8* in, const uint32 n, const uint32 i) { return in[i] < 4u ? in[i] : 2u; }
+
+    template <typename InStream, typename OutStream>
+    static uint64 run(const uint32 n, const InStream in, OutStream out) { return packed_narrow( n, in, out, uint8(2u) ); }
+};
+
+// check a bulk transcoding operator against its symbol-by-symbol definition on random
+// ranges, making sure the symbols outside the output range are left untouched
+//
+template <typename Op, typename in_word, uint32 IN_BITS, bool IN_BE, typename out_word, uint32 OUT_BITS, bool OUT_BE>
+bool check_transcode(const uint32 n_trials, const uint32 max_len)
+{
+    typedef PackedStream<const in_word*,uint8,IN_BITS,IN_BE>   in_stream_type;
+    typedef PackedStream<out_word*,uint8,OUT_BITS,OUT_BE>      out_stream_type;
+
+    const uint32 IN_SYMBOLS_PER_WORD  = uint32( 8u * sizeof(in_word) )  / IN_BITS;
+    const uint32 OUT_SYMBOLS_PER_WORD = uint32( 8u * sizeof(out_word) ) / OUT_BITS;
+
+    for (uint32 trial = 0; trial < n_trials; ++trial)
+    {
+        const uint32 in_offset  = rand() % 64u;
+        const uint32 out_offset = rand() % 64u;
+        const uint32 n          = trial ? rand() % max_len : max_len;
+
+        std::vector<in_word>  in_storage( (in_offset + n) / IN_SYMBOLS_PER_WORD + 1u );
+        std::vector<out_word> out_storage( (out_offset + n) / OUT_SYMBOLS_PER_WORD + 1u );
+        for (uint32 i = 0; i < in_storage.size(); ++i)  in_storage[i]  = in_word( uint32( rand() ) ^ (uint32( rand() ) << 16) );
+        for (uint32 i = 0; i < out_storage.size(); ++i) out_storage[i] = out_word( uint32( rand() ) ^ (uint32( rand() ) << 16) );
+
+        // compute the reference output symbol by symbol
+        std::vector<uint8> in_symbols( n + 1u );
+        const in_stream_type in( &in_storage[0] );
+        uint64 n_count = 0;
+        for (uint32 i = 0; i < n; ++i)
+        {
+            in_symbols[i] = in[ in_offset + i ];
+            n_count += in_symbols[i] >= 4u ? 1u : 0u;
+        }
+
+        std::vector<out_word> ref_storage( out_storage );
+        out_stream_type ref( &ref_storage[0] );
+        for (uint32 i = 0; i < n; ++i)
+            ref[ out_offset + i ] = Op::expected( &in_symbols[0], n, i );
+
+        // run the bulk operator
+        const uint64 r = Op::run( n, in + in_offset, out_stream_type( &out_storage[0] ) + out_offset );
+
+        if (out_storage != ref_storage)
+        {
+            out_stream_type out( &out_storage[0] );
+            for (uint32 i = 0; i < out_offset + n + OUT_SYMBOLS_PER_WORD; ++i)
+            {
+                if (i < out_storage.size() * OUT_SYMBOLS_PER_WORD && out[i] != ref[i])
+                {
+                    fprintf(stderr, "  %s error (%u-bit %s %s -> %u-bit %s %s, n: %u, offsets: %u, %u) at %u : found %u, expected %u\n",
+                        Op::name(),
+                        IN_BITS,  sizeof(in_word)  == 1 ? "uint8" : "uint32", IN_BE  ? "BE" : "LE",
+                        OUT_BITS, sizeof(out_word) == 1 ? "uint8" : "uint32", OUT_BE ? "BE" : "LE",
+                        n, in_offset, out_offset,
+                        i, uint32( out[i] ), uint32( ref[i] ));
+                    return false;
+                }
+            }
+        }
+        if (same_type<Op,NarrowOp>::pred && r != n_count)
+        {
+            fprintf(stderr, "  narrow error: found %llu N's, expected %llu\n", r, n_count);
+            return false;
+        }
+    }
+    return true;
+}
+
+// check a transcoding operator on all combinations of word types and endianness
+//
+template <typename Op, uint32 IN_BITS, uint32 OUT_BITS>
+bool check_transcode(const uint32 n_trials, const uint32 max_len)
+{
+    return
+        check_transcode<Op,uint32,IN_BITS,true, uint32,OUT_BITS,true> ( n_trials, max_len ) &&
+        check_transcode<Op,uint32,IN_BITS,true, uint32,OUT_BITS,false>( n_trials, max_len ) &&
+        check_transcode<Op,uint32,IN_BITS,false,uint32,OUT_BITS,true> ( n_trials, max_len ) &&
+        check_transcode<Op,uint32,IN_BITS,false,uint32,OUT_BITS,false>( n_trials, max_len ) &&
+        check_transcode<Op,uint8, IN_BITS,true, uint32,OUT_BITS,true> ( n_trials, max_len ) &&
+        check_transcode<Op,uint8, IN_BITS,false,uint32,OUT_BITS,false>( n_trials, max_len ) &&
+        check_transcode<Op,uint32,IN_BITS,true, uint8, OUT_BITS,true> ( n_trials, max_len ) &&
+        check_transcode<Op,uint32,IN_BITS,false,uint8, OUT_BITS,false>( n_trials, max_len );
+}
+
 int packedstream_test()
 {
     // TODO: FIXME: the std::sort( stream.begin(), stream.begin() + LEN ); call
@@ -421,5 +550,60 @@ int packedstream_test()
         fprintf(stderr, "2-bit uint4-stream test... done\n");
     }
     */
+    {
+  #if defined(__SSSE3__)
+        fprintf(stderr, "packed stream transcoding test (SSSE3)... started\n");
+  #else
+        fprintf(stderr, "packed stream transcoding test... started\n");
+  #endif
+
+        if (check_transcode<RepackOp,2,2>( 200, 1000 )            == false ||
+            check_transcode<RepackOp,4,4>( 200, 1000 )            == false ||
+            check_transcode<RepackOp,8,8>( 200, 1000 )            == false ||
+            check_transcode<ReverseOp,2,2>( 200, 1000 )           == false ||
+            check_transcode<ReverseOp,4,4>( 200, 1000 )           == false ||
+            check_transcode<ReverseComplementOp,2,2>( 200, 1000 ) == false ||
+            check_transcode<ReverseComplementOp,4,4>( 200, 1000 ) == false ||
+            check_transcode<WidenOp,2,4>( 200, 1000 )             == false ||
+            check_transcode<NarrowOp,4,2>( 200, 1000 )            == false)
+            exit(1);
+
+        // exercise the parallel path
+        if (check_transcode<ReverseComplementOp,uint32,2,true,uint32,2,true>( 2, 3000000 ) == false ||
+            check_transcode<NarrowOp,uint32,4,true,uint32,2,true>( 2, 3000000 )            == false)
+            exit(1);
+
+        // measure the reverse-complement throughput against the symbol by symbol version
+        {
+            const uint32 n = 32*1024*1024;
+            std::vector<uint32> in_storage( n / 16u ), out_storage( n / 16u );
+            for (uint32 i = 0; i < n / 16u; ++i)
+                in_storage[i] = uint32( rand() ) ^ (uint32( rand() ) << 16);
+
+            typedef PackedStream<const uint32*,uint8,2,true> in_stream_type;
+            typedef PackedStream<uint32*,uint8,2,true>       out_stream_type;
+
+            const in_stream_type in( &in_storage[0] );
+                out_stream_type out( &out_storage[0] );
+
+            Timer timer;
+            timer.start();
+            for (uint32 i = 0; i < n; ++i)
+                out[i] = 3u - in[n-1-i];
+            timer.stop();
+            const float serial_time = timer.seconds();
+
+            timer.start();
+            packed_reverse_complement( n, in, out );
+            timer.stop();
+            const float bulk_time = timer.seconds();
+
+            fprintf(stderr, "  reverse-complement: %.1f M symbols/s (symbol by symbol: %.1f M symbols/s)\n",
+                1.0e-6f * float(n) / bulk_time,
+                1.0e-6f * float(n) / serial_time);
+        }
+
+        fprintf(stderr, "packed stream transcoding test... done\n");
+    }
 	return 0;
 }
@@ -37,6 +37,10 @@
 #include <nvbio/basic/dna.h>
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/sequence/sequence_mmap.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/io/sequence/sequence_nvr.h>
+#include <nvbio/io/sequence/sequence_pac.h>
+#include <nvbio/basic/bnt.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -44,6 +48,40 @@ using namespace nvbio;
 
 namespace nvbio {
 
+namespace {
+
+// check the conversion of a .pac sequence to a given alphabet against the original 2-bit symbols
+//
+template <Alphabet ALPHABET>
+bool check_pac_conversion(const io::SequenceDataPAC& pac_data, const std::vector<uint8>& seq, const char* name)
+{
+    io::SequenceDataHost converted;
+    if (pac_data.convert( ALPHABET, &converted ) == false ||
+        converted.size() != pac_data.size() ||
+        converted.bps()  != seq.size())
+    {
+        log_error(stderr,"  pac conversion to %s failed\n", name);
+        return false;
+    }
+
+    const io::ConstSequenceDataView                                  view( converted );
+    const io::SequenceDataAccess<ALPHABET,io::ConstSequenceDataView> access( view );
+
+    for (uint32 i = 0; i < seq.size(); ++i)
+    {
+        // the RNA alphabets have U in place of T
+        const char c        = to_char<ALPHABET>( access.sequence_stream()[i] );
+        const char expected = (ALPHABET == RNA || ALPHABET == RNA_N) && seq[i] == 3u ? 'U' : dna_to_char( seq[i] );
+        if (c != expected)
+        {
+            log_error(stderr,"  pac conversion to %s: symbol %u is %c instead of %c\n", name, i, c, expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
 
 int sequence_test(int argc, char* argv[])
 {
@@ -62,6 +100,267 @@ int sequence_test(int argc, char* argv[])
 
     try
     {
+        // write a random read set to an .nvr container, and read it back with random access
+        {
+            log_verbose(stderr, "  testing nvr round-trip\n");
+
+            typedef io::SequenceDataAccess<DNA_N,io::ConstSequenceDataView> access_type;
+
+            const uint32 N_READS   = 5000;
+            const char*  nvr_name  = "nvbio-test.nvr";
+            const char   bases[5]  = { 'A', 'C', 'G', 'T', 'N' };
+
+            io::SequenceDataHost reads;
+            {
+                SharedPointer<io::SequenceDataEncoder> encoder( io::create_encoder( DNA_N, &reads ) );
+
+                std::vector<uint8> read_bp( 150 );
+                std::vector<uint8> read_q( 150 );
+                char name[64];
+
+                encoder->begin_batch();
+                for (uint32 i = 0; i < N_READS; ++i)
+                {
+                    const uint32 read_len = 1u + rand() % 150;
+                    for (uint32 j = 0; j < read_len; ++j)
+                    {
+                        read_bp[j] = bases[ rand() % 5 ];
+                        read_q[j]  = uint8( rand() % 42 );
+                    }
+                    sprintf( name, "SRR%u.%u/%u", 1000u + i / 700u, i, 1u + (i & 1u) );
+
+                    encoder->push_back(
+                        read_len,
+                        name,
+                        &read_bp[0],
+                        &read_q[0],
+                        io::Phred,
+                        uint32(-1),
+                        0u,
+                        0u,
+                        io::SequenceDataEncoder::NO_OP );
+                }
+                encoder->end_batch();
+            }
+
+            // write the container in small blocks, so as to test the block index
+            {
+                SharedPointer<io::SequenceDataOutputStream> output( io::open_output_sequence_file( nvr_name, "tokens,block=1000" ) );
+                if (output == NULL || output->is_ok() == false)
+                {
+                    log_error(stderr,"  failed opening %s for writing\n", nvr_name);
+                    return 0;
+                }
+                output->next( reads );
+                if (output->is_ok() == false)
+                {
+                    log_error(stderr,"  failed writing %s\n", nvr_name);
+                    return 0;
+                }
+            }
+
+            {
+                io::SequenceDataNVR nvr;
+                if (nvr.load( nvr_name ) == false || nvr.size() != N_READS)
+                {
+                    log_error(stderr,"  failed loading %s\n", nvr_name);
+                    return 0;
+                }
+
+                const io::ConstSequenceDataView ref_view( reads );
+                const access_type               ref_access( ref_view );
+
+                io::NVRNameStorage names;
+                for (uint32 t = 0; t < 2000; ++t)
+                {
+                    const uint32 read_id = rand() % N_READS;
+                    const uint32 block   = nvr.find_block( read_id );
+                    const uint32 i       = uint32( read_id - nvr.first_seq( block ) );
+
+                    const io::ConstSequenceDataView view = nvr.block( block, &names );
+                    const access_type               access( view );
+
+                    const access_type::sequence_string ref_read  = ref_access.get_read( read_id );
+                    const access_type::sequence_string read      = access.get_read( i );
+                    const access_type::qual_string     ref_quals = ref_access.get_quals( read_id );
+                    const access_type::qual_string     quals     = access.get_quals( i );
+
+                    bool match = nvr.check( block ) && read.length() == ref_read.length() &&
+                                 strcmp( view.name_stream()     + view.name_index()[i],
+                                         ref_view.name_stream() + ref_view.name_index()[read_id] ) == 0;
+
+                    for (uint32 j = 0; match && j < read.length(); ++j)
+                        match = read[j] == ref_read[j] && quals[j] == ref_quals[j];
+
+                    if (match == false)
+                    {
+                        log_error(stderr,"  nvr read %u (block %u) does not match the original\n", read_id, block);
+                        return 0;
+                    }
+                }
+            }
+            remove( nvr_name );
+        }
+
+        // write a small BWA reference, and check that the .pac view, its conversions
+        // and the regular loaders all see the same sequences
+        {
+            log_verbose(stderr, "  testing pac view\n");
+
+            typedef io::SequenceDataAccess<DNA,io::PacSequenceDataView>   pac_access_type;
+            typedef io::SequenceDataAccess<DNA,io::ConstSequenceDataView> dna_access_type;
+
+            const char*  pac_prefix = "nvbio-test-pac";
+
+            // span several conversion blocks, with a last sequence whose length is not a multiple of 4
+            const uint32 N_SEQS = 3;
+            const uint32 seq_lengths[N_SEQS] = { 150001u, 37u, 160002u };
+
+            BNTSeq bns;
+            bns.n_seqs  = N_SEQS;
+            bns.n_holes = 0;
+
+            std::vector<uint8> seq;
+            for (uint32 i = 0; i < N_SEQS; ++i)
+            {
+                BNTAnnInfo ann_info;
+                BNTAnnData ann_data;
+
+                char name[64];
+                sprintf( name, "chr%u", i );
+                ann_info.name   = name;
+                ann_data.offset = int64( seq.size() );
+                ann_data.len    = int32( seq_lengths[i] );
+
+                bns.anns_info.push_back( ann_info );
+                bns.anns_data.push_back( ann_data );
+
+                for (uint32 j = 0; j < seq_lengths[i]; ++j)
+                    seq.push_back( uint8( rand() % 4 ) );
+            }
+            bns.l_pac = int64( seq.size() );
+            save_bns( bns, pac_prefix );
+
+            // write the .pac file: 4 big-endian symbols per byte, followed by the number of symbols
+            // in the last byte (and by an extra padding byte if that is full)
+            {
+                const uint32 seq_length = uint32( seq.size() );
+
+                std::vector<uint8> pac( util::divide_ri( seq_length, 4u ), 0u );
+                for (uint32 i = 0; i < seq_length; ++i)
+                    pac[i >> 2] |= seq[i] << ((~i & 3u) << 1);
+
+                if (seq_length % 4u == 0u)
+                    pac.push_back( 0u );
+                pac.push_back( uint8( seq_length % 4u ) );
+
+                const std::string pac_name = std::string( pac_prefix ) + ".pac";
+                FILE* file = fopen( pac_name.c_str(), "wb" );
+                if (file == NULL || fwrite( &pac[0], 1u, pac.size(), file ) != pac.size())
+                {
+                    log_error(stderr,"  failed writing %s\n", pac_name.c_str());
+                    return 0;
+                }
+                fclose( file );
+            }
+
+            io::SequenceDataPAC pac_data;
+            if (pac_data.load( pac_prefix ) == false ||
+                pac_data.size() != N_SEQS ||
+                pac_data.bps()  != seq.size())
+            {
+                log_error(stderr,"  failed mapping %s.pac\n", pac_prefix);
+                return 0;
+            }
+
+            const io::PacSequenceDataView pac_view( pac_data );
+            const pac_access_type         pac_access( pac_view );
+
+            // check the view against the original sequences
+            for (uint32 i = 0; i < N_SEQS; ++i)
+            {
+                const pac_access_type::sequence_string read = pac_access.get_read( i );
+
+                bool match = read.length() == seq_lengths[i] &&
+                             bns.anns_info[i].name == pac_view.name_stream() + pac_view.name_index()[i];
+
+                for (uint32 j = 0; match && j < read.length(); ++j)
+                    match = read[j] == seq[ bns.anns_data[i].offset + j ];
+
+                if (match == false)
+                {
+                    log_error(stderr,"  pac view sequence %u does not match the original\n", i);
+                    return 0;
+                }
+            }
+
+            // check the conversions to all supported alphabets
+            if (check_pac_conversion<DNA>(     pac_data, seq, "DNA" )     == false ||
+                check_pac_conversion<DNA_N>(   pac_data, seq, "DNA_N" )   == false ||
+                check_pac_conversion<RNA>(     pac_data, seq, "RNA" )     == false ||
+                check_pac_conversion<RNA_N>(   pac_data, seq, "RNA_N" )   == false ||
+                check_pac_conversion<PROTEIN>( pac_data, seq, "PROTEIN" ) == false)
+                return 0;
+
+            // and check the view against the regular and the memory mapped loaders
+            {
+                io::SequenceDataHost loaded;
+                if (io::load_sequence_file( DNA, &loaded, pac_prefix ) == false)
+                {
+                    log_error(stderr,"  loading %s failed\n", pac_prefix);
+                    return 0;
+                }
+
+                io::SequenceDataMMAPServer server;
+                if (server.load( DNA, pac_prefix, "nvbio-test-pac", io::SequenceFlags( io::SEQUENCE_DATA | io::SEQUENCE_NAMES ) ) == false)
+                {
+                    log_error(stderr,"  server mapping of %s failed\n", pac_prefix);
+                    return 0;
+                }
+
+                // scope the client so as to make sure it's destroyed before the server
+                {
+                    io::SequenceDataMMAP client;
+                    if (client.load( "nvbio-test-pac" ) == false)
+                    {
+                        log_error(stderr,"  client mapping of %s failed\n", pac_prefix);
+                        return 0;
+                    }
+
+                    const io::ConstSequenceDataView loaded_view( loaded );
+                    const io::ConstSequenceDataView mapped_view( client );
+                    const dna_access_type           loaded_access( loaded_view );
+                    const dna_access_type           mapped_access( mapped_view );
+
+                    bool match = loaded.size() == N_SEQS && loaded.bps() == seq.size() &&
+                                 client.size() == N_SEQS && client.bps() == seq.size();
+
+                    for (uint32 i = 0; match && i < N_SEQS; ++i)
+                    {
+                        match = loaded_view.sequence_index()[i+1] == pac_view.sequence_index()[i+1] &&
+                                mapped_view.sequence_index()[i+1] == pac_view.sequence_index()[i+1] &&
+                                strcmp( mapped_view.name_stream() + mapped_view.name_index()[i],
+                                        pac_view.name_stream()    + pac_view.name_index()[i] ) == 0;
+                    }
+                    for (uint32 i = 0; match && i < seq.size(); ++i)
+                    {
+                        match = loaded_access.sequence_stream()[i] == pac_access.sequence_stream()[i] &&
+                                mapped_access.sequence_stream()[i] == pac_access.sequence_stream()[i];
+                    }
+
+                    if (match == false)
+                    {
+                        log_error(stderr,"  pac view and loaded versions of %s do not match!\n", pac_prefix);
+                        return 0;
+                    }
+                }
+            }
+
+            remove( (std::string( pac_prefix ) + ".pac").c_str() );
+            remove( (std::string( pac_prefix ) + ".ann").c_str() );
+            remove( (std::string( pac_prefix ) + ".amb").c_str() );
+        }
+
         if (index_name != NULL)
         {
             log_verbose(stderr, "  loading sequence file %s\n", index_name );
@@ -101,6 +101,31 @@ void check(const input_set& in_string_set, const output_set& out_string_set)
     }
 }
 
+// time a batch of host copies of a string set into another, checking the result
+//
+template <typename input_set, typename output_set>
+void cpu_copy_test(
+    const char*         name,
+    const uint32        N_tests,
+    const uint32        N_symbols,
+    const input_set&    in_string_set,
+          output_set&   out_string_set)
+{
+    fprintf(stderr, "  test cpu %s copy... started\n", name);
+
+    Timer timer;
+    timer.start();
+
+    for (uint32 i = 0; i < N_tests; ++i)
+        copy( in_string_set, out_string_set );
+
+    timer.stop();
+
+    // check that the string sets match
+    check( in_string_set, out_string_set );
+    fprintf(stderr, "  test cpu %s copy... done:   %.2f GSYMS\n", name, (1.0e-9f*float(N_symbols))*(float(N_tests)/timer.seconds()));
+}
+
 void make_test_string_set(
     const uint32                  SYMBOL_SIZE,
     const uint32                  N_strings,
@@ -121,6 +146,147 @@ void make_test_string_set(
     }
 }
 
+// check the host copies on strings of ragged lengths, including runs of empty strings,
+// a whole tile of them, and a string spanning several word blocks: this exercises the
+// boundary words of the packed concatenated copies and the partial tiles of the strided ones
+//
+template <uint32 SYMBOL_SIZE>
+void cpu_ragged_copy_test()
+{
+    fprintf(stderr, "  test cpu ragged copies... started\n");
+
+    const uint32 SYMBOLS_PER_WORD = (8u*sizeof(uint32)) / SYMBOL_SIZE;
+    const uint32 SYMBOL_MASK      = (1u << SYMBOL_SIZE) - 1u;
+
+    typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,false> packed_stream_type;
+
+    typedef SparseStringSet<uint8*,uint2*>                                          sparse_set;
+    typedef SparseStringSet<packed_stream_type,const uint2*>                        packed_sparse_set;
+    typedef ConcatenatedStringSet<packed_stream_type,uint32*>                       packed_concat_set;
+    typedef StridedStringSet<uint8*,uint32*>                                        strided_set;
+    typedef StridedPackedStringSet<uint32*,uint8,SYMBOL_SIZE,false,uint32*>         strided_packed_set;
+
+    // a string count which is not a multiple of the strided copy tiles
+    const uint32 N_strings = 5u*64u + 13u;
+
+    LCG_random rand;
+
+    // pick the string lengths, spacing the strings out by random gaps
+    thrust::host_vector<uint2> h_ranges( N_strings );
+
+    uint32 N_symbols = 0u;
+    uint32 max_len   = 0u;
+    uint32 offset    = 0u;
+    for (uint32 i = 0; i < N_strings; ++i)
+    {
+        uint32 len;
+        if (i < 3u || i + 2u >= N_strings || (i >= 64u && i < 133u) || i % 7u == 0u)
+            len = 0u;
+        else if (i == 150u)
+            len = 20000u;
+        else
+            len = rand.next() % 200u;
+
+        offset += rand.next() % 5u;
+        h_ranges[i] = make_uint2( offset, offset + len );
+        offset += len;
+
+        N_symbols += len;
+        max_len    = nvbio::max( max_len, len );
+    }
+
+    thrust::host_vector<uint8>  h_string( offset );
+    thrust::host_vector<uint32> h_packed_string( util::divide_ri( offset, SYMBOLS_PER_WORD ) );
+
+    packed_stream_type h_packed_stream( thrust::raw_pointer_cast( &h_packed_string.front() ) );
+    for (uint32 i = 0; i < offset; ++i)
+        h_packed_stream[i] = h_string[i] = rand.next() & SYMBOL_MASK;
+
+    const sparse_set h_sparse_set(
+        N_strings,
+        thrust::raw_pointer_cast( &h_string.front() ),
+        thrust::raw_pointer_cast( &h_ranges.front() ) );
+
+    const packed_sparse_set h_packed_sparse_set(
+        N_strings,
+        h_packed_stream,
+        thrust::raw_pointer_cast( &h_ranges.front() ) );
+
+    // write the packed concatenated output at an unaligned position of a sentinel-filled
+    // stream, which must be preserved around the output
+    const uint32 out_index = 3u;
+    const uint32 N_words   = util::divide_ri( out_index + N_symbols, SYMBOLS_PER_WORD ) + 1u;
+
+    thrust::host_vector<uint32> h_out_packed_string( N_words );
+    thrust::host_vector<uint32> h_out_packed_offsets( N_strings+1 );
+
+    packed_stream_type h_out_packed_stream( thrust::raw_pointer_cast( &h_out_packed_string.front() ) );
+
+    packed_concat_set h_out_packed_concat_set(
+        N_strings,
+        h_out_packed_stream + out_index,
+        thrust::raw_pointer_cast( &h_out_packed_offsets.front() ) );
+
+    for (uint32 r = 0; r < 2; ++r)
+    {
+        std::fill( h_out_packed_string.begin(), h_out_packed_string.end(), 0xFFFFFFFFu );
+
+        if (r == 0)
+            copy( h_sparse_set, h_out_packed_concat_set );
+        else
+            copy( h_packed_sparse_set, h_out_packed_concat_set );
+
+        check( h_sparse_set, h_out_packed_concat_set );
+
+        for (uint32 i = 0; i < N_words * SYMBOLS_PER_WORD; ++i)
+        {
+            if (i >= out_index && i < out_index + N_symbols)
+                continue;
+
+            if (h_out_packed_stream[i] != SYMBOL_MASK)
+            {
+                fprintf(stderr, "    \nerror: packed concatenated copy overwrote symbol %u outside of the output\n", i);
+                exit(1);
+            }
+        }
+    }
+
+    // copy the packed concatenated set, the sparse and the packed sparse sets into strided ones
+    thrust::host_vector<uint8>  h_out_strided_string( max_len * N_strings );
+    thrust::host_vector<uint32> h_out_strided_lengths( N_strings );
+    thrust::host_vector<uint32> h_out_strided_packed_string( util::divide_ri( max_len, SYMBOLS_PER_WORD ) * N_strings );
+    thrust::host_vector<uint32> h_out_strided_packed_lengths( N_strings );
+
+    strided_set h_out_strided_set(
+        N_strings,
+        N_strings,
+        thrust::raw_pointer_cast( &h_out_strided_string.front() ),
+        thrust::raw_pointer_cast( &h_out_strided_lengths.front() ) );
+
+    strided_packed_set h_out_strided_packed_set(
+        N_strings,
+        N_strings,
+        thrust::raw_pointer_cast( &h_out_strided_packed_string.front() ),
+        thrust::raw_pointer_cast( &h_out_strided_packed_lengths.front() ) );
+
+    copy( h_sparse_set, h_out_strided_set );
+    check( h_sparse_set, h_out_strided_set );
+
+    copy( h_packed_sparse_set, h_out_strided_set );
+    check( h_sparse_set, h_out_strided_set );
+
+    copy( h_out_packed_concat_set, h_out_strided_set );
+    check( h_sparse_set, h_out_strided_set );
+
+    copy( h_sparse_set, h_out_strided_packed_set );
+    check( h_sparse_set, h_out_strided_packed_set );
+
+    copy( h_out_packed_concat_set, h_out_strided_packed_set );
+    check( h_sparse_set, h_out_strided_packed_set );
+
+    fprintf(stderr, "  test cpu ragged copies... done\n");
+}
+
 int string_set_test(int argc, char* argv[])
 {
     fprintf(stderr, "nvbio/basic/string_set test... started\n");
@@ -174,6 +340,8 @@ int string_set_test(int argc, char* argv[])
                     TEST_MASK |= SPARSE_TO_PACKED_CONCAT;
                 else if (strcmp( temp, "concat-to-packed-concat" ) == 0)
                     TEST_MASK |= CONCAT_TO_PACKED_CONCAT;
+                else if (strcmp( temp, "concat-to-strided" ) == 0)
+                    TEST_MASK |= CONCAT_TO_STRIDED;
                 else if (strcmp( temp, "sparse-to-strided" ) == 0)
                     TEST_MASK |= SPARSE_TO_STRIDED;
                 else if (strcmp( temp, "packed-concat-to-strided" ) == 0)
@@ -189,7 +357,7 @@ int string_set_test(int argc, char* argv[])
                 else if (strcmp( temp, "packed-sparse-to-strided-packed" ) == 0)
                     TEST_MASK |= PACKED_SPARSE_TO_STRIDED_PACKED;
 
-                if (end[i] == '\0')
+                if (*end == '\0')
                     break;
 
                 ++end; begin = end;
@@ -224,113 +392,121 @@ int string_set_test(int argc, char* argv[])
         thrust::raw_pointer_cast( &d_base_string.front() ),
         thrust::raw_pointer_cast( &d_base_ranges.front() ) );
 
-    // copy a packed sparse string set into a strided packed string set
-    if ((TEST_MASK & PACKED_SPARSE_TO_STRIDED) && (TEST_MASK & CPU))
+    // run all the host copies
+    if (TEST_MASK & CPU)
     {
-        fprintf(stderr, "  test cpu packed-sparse  -> strided        copy... started\n");
-        const uint32 N_words = (N_spacing + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
+        cpu_ragged_copy_test<SYMBOL_SIZE>();
 
         typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,false> packed_stream_type;
 
-        typedef SparseStringSet<packed_stream_type,const uint2*> input_set;
-        typedef StridedStringSet<
-            uint8*,
-            uint32*>                                                  output_set;
+        typedef ConcatenatedStringSet<uint8*,uint32*>                                   concat_set;
+        typedef ConcatenatedStringSet<packed_stream_type,uint32*>                       packed_concat_set;
+        typedef SparseStringSet<packed_stream_type,const uint2*>                        packed_sparse_set;
+        typedef StridedStringSet<uint8*,uint32*>                                        strided_set;
+        typedef StridedPackedStringSet<uint32*,uint8,SYMBOL_SIZE,false,uint32*>         strided_packed_set;
 
-        thrust::host_vector<uint32>  h_in_string( N_strings * N_words );
-        thrust::host_vector<uint2>   h_in_ranges( N_strings );
+        const uint32 N_symbols       = N_strings * N;
+        const uint32 N_spaced_words  = (N_strings * N_spacing + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
+        const uint32 N_concat_words  = (N_symbols + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
 
-        packed_stream_type h_packed_stream(
-            thrust::raw_pointer_cast( &h_in_string.front() ) );
+        // build a packed sparse copy of the base string set
+        thrust::host_vector<uint32> h_packed_sparse_string( N_spaced_words );
 
-        LCG_random rand;
-        for (uint32 i = 0; i < N_strings; ++i)
-        {
-            h_in_ranges[i] = make_uint2( N_spacing*i, N_spacing*i + N );
-            for (uint32 j = 0; j < N_spacing; ++j)
-                h_packed_stream[ i * N_spacing + j ] = rand.next() & ((1u << SYMBOL_SIZE) - 1u);
-        }
+        packed_stream_type h_packed_sparse_stream( thrust::raw_pointer_cast( &h_packed_sparse_string.front() ) );
+        for (uint32 i = 0; i < N_strings * N_spacing; ++i)
+            h_packed_sparse_stream[i] = h_base_string[i];
 
-        input_set h_in_string_set(
+        const packed_sparse_set h_packed_sparse_set(
             N_strings,
-            h_packed_stream,
-            thrust::raw_pointer_cast( &h_in_ranges.front() ) );
+            h_packed_sparse_stream,
+            thrust::raw_pointer_cast( &h_base_ranges.front() ) );
+
+        // build the concatenated, packed-concatenated and strided-packed input sets
+        thrust::host_vector<uint8>  h_concat_string( N_symbols );
+        thrust::host_vector<uint32> h_concat_offsets( N_strings+1 );
+        thrust::host_vector<uint32> h_packed_concat_string( N_concat_words );
+        thrust::host_vector<uint32> h_packed_concat_offsets( N_strings+1 );
+        thrust::host_vector<uint32> h_strided_packed_string( N_strings * N_words );
+        thrust::host_vector<uint32> h_strided_packed_lengths( N_strings );
+
+        concat_set h_concat_set(
+            N_strings,
+            thrust::raw_pointer_cast( &h_concat_string.front() ),
+            thrust::raw_pointer_cast( &h_concat_offsets.front() ) );
 
-        // build the host output string set
-        thrust::host_vector<uint8>   h_out_stream( N_strings * N );
-        thrust::host_vector<uint32>  h_out_lengths( N_strings );
+        packed_concat_set h_packed_concat_set(
+            N_strings,
+            packed_stream_type( thrust::raw_pointer_cast( &h_packed_concat_string.front() ) ),
+            thrust::raw_pointer_cast( &h_packed_concat_offsets.front() ) );
 
-        output_set h_out_string_set(
+        strided_packed_set h_strided_packed_set(
             N_strings,
             N_strings,
-            thrust::raw_pointer_cast( &h_out_stream.front() ),
-            thrust::raw_pointer_cast( &h_out_lengths.front() ) );
-
-        Timer timer;
-        timer.start();
-
-        // copy intput set into the output set
-        for (uint32 i = 0; i < N_tests; ++i)
-            copy( h_in_string_set, h_out_string_set );
-
-        timer.stop();
-        fprintf(stderr, "  test cpu packed-sparse  -> strided        copy... done:   %.2f GSYMS\n", (1.0e-9f*float(N_strings*N))*(float(N_tests)/timer.seconds()));
-    }
-    // copy a packed sparse string set into a strided packed string set
-    if ((TEST_MASK & PACKED_SPARSE_TO_STRIDED_PACKED) && (TEST_MASK & CPU))
-    {
-        fprintf(stderr, "  test cpu packed-sparse  -> strided-packed copy... started\n");
-        const uint32 N_words = (N_spacing + SYMBOLS_PER_WORD-1) / SYMBOLS_PER_WORD;
-
-        typedef PackedStream<uint32*,uint8,SYMBOL_SIZE,false> packed_stream_type;
-
-        typedef SparseStringSet<packed_stream_type,const uint2*> input_set;
-        typedef StridedPackedStringSet<
-            uint32*,
-            uint8,
-            SYMBOL_SIZE,
-            false,
-            uint32*>                                                  output_set;
-
-        thrust::host_vector<uint32>  h_in_string( N_strings * N_words );
-        thrust::host_vector<uint2>   h_in_ranges( N_strings );
-
-        packed_stream_type h_packed_stream(
-            thrust::raw_pointer_cast( &h_in_string.front() ) );
-
-        LCG_random rand;
-        for (uint32 i = 0; i < N_strings; ++i)
-        {
-            h_in_ranges[i] = make_uint2( N_spacing*i, N_spacing*i + N );
-            for (uint32 j = 0; j < N_spacing; ++j)
-                h_packed_stream[ i * N_spacing + j ] = rand.next() & ((1u << SYMBOL_SIZE) - 1u);
-        }
-
-        input_set h_in_string_set(
+            thrust::raw_pointer_cast( &h_strided_packed_string.front() ),
+            thrust::raw_pointer_cast( &h_strided_packed_lengths.front() ) );
+
+        copy( h_base_string_set, h_concat_set );
+        copy( h_base_string_set, h_packed_concat_set );
+        copy( h_base_string_set, h_strided_packed_set );
+
+        check( h_base_string_set, h_concat_set );
+        check( h_base_string_set, h_packed_concat_set );
+        check( h_base_string_set, h_strided_packed_set );
+
+        // build the output sets
+        thrust::host_vector<uint8>  h_out_concat_string( N_symbols );
+        thrust::host_vector<uint32> h_out_concat_offsets( N_strings+1 );
+        thrust::host_vector<uint32> h_out_packed_concat_string( N_concat_words );
+        thrust::host_vector<uint32> h_out_packed_concat_offsets( N_strings+1 );
+        thrust::host_vector<uint8>  h_out_strided_string( N_strings * N );
+        thrust::host_vector<uint32> h_out_strided_lengths( N_strings );
+        thrust::host_vector<uint32> h_out_strided_packed_string( N_strings * N_words );
+        thrust::host_vector<uint32> h_out_strided_packed_lengths( N_strings );
+
+        concat_set h_out_concat_set(
             N_strings,
-            h_packed_stream,
-            thrust::raw_pointer_cast( &h_in_ranges.front() ) );
+            thrust::raw_pointer_cast( &h_out_concat_string.front() ),
+            thrust::raw_pointer_cast( &h_out_concat_offsets.front() ) );
 
-        // build the output string set
-        thrust::host_vector<uint32>  h_out_stream( N_strings * N_words );
-        thrust::host_vector<uint32>  h_out_lengths( N_strings );
+        packed_concat_set h_out_packed_concat_set(
+            N_strings,
+            packed_stream_type( thrust::raw_pointer_cast( &h_out_packed_concat_string.front() ) ),
+            thrust::raw_pointer_cast( &h_out_packed_concat_offsets.front() ) );
 
-        output_set h_out_string_set(
+        strided_set h_out_strided_set(
             N_strings,
             N_strings,
-            thrust::raw_pointer_cast( &h_out_stream.front() ),
-            thrust::raw_pointer_cast( &h_out_lengths.front() ) );
+            thrust::raw_pointer_cast( &h_out_strided_string.front() ),
+            thrust::raw_pointer_cast( &h_out_strided_lengths.front() ) );
 
-        Timer timer;
-        timer.start();
-
-        // copy intput set into the output set
-        for (uint32 i = 0; i < N_tests; ++i)
-            copy( h_in_string_set, h_out_string_set );
-
-        timer.stop();
-
-        fprintf(stderr, "  test cpu packed-sparse  -> strided-packed copy... done:   %.2f GSYMS\n", (1.0e-9f*float(N_strings*N))*(float(N_tests)/timer.seconds()));
+        strided_packed_set h_out_strided_packed_set(
+            N_strings,
+            N_strings,
+            thrust::raw_pointer_cast( &h_out_strided_packed_string.front() ),
+            thrust::raw_pointer_cast( &h_out_strided_packed_lengths.front() ) );
+
+        if (TEST_MASK & SPARSE_TO_CONCAT)
+            cpu_copy_test( "sparse         -> concat        ", N_tests, N_symbols, h_base_string_set, h_out_concat_set );
+        if (TEST_MASK & SPARSE_TO_PACKED_CONCAT)
+            cpu_copy_test( "sparse         -> packed-concat ", N_tests, N_symbols, h_base_string_set, h_out_packed_concat_set );
+        if (TEST_MASK & CONCAT_TO_PACKED_CONCAT)
+            cpu_copy_test( "concat         -> packed-concat ", N_tests, N_symbols, h_concat_set, h_out_packed_concat_set );
+        if (TEST_MASK & CONCAT_TO_STRIDED)
+            cpu_copy_test( "concat         -> strided       ", N_tests, N_symbols, h_concat_set, h_out_strided_set );
+        if (TEST_MASK & SPARSE_TO_STRIDED)
+            cpu_copy_test( "sparse         -> strided       ", N_tests, N_symbols, h_base_string_set, h_out_strided_set );
+        if (TEST_MASK & PACKED_CONCAT_TO_STRIDED)
+            cpu_copy_test( "packed-concat  -> strided       ", N_tests, N_symbols, h_packed_concat_set, h_out_strided_set );
+        if (TEST_MASK & PACKED_SPARSE_TO_STRIDED)
+            cpu_copy_test( "packed-sparse  -> strided       ", N_tests, N_symbols, h_packed_sparse_set, h_out_strided_set );
+        if (TEST_MASK & STRIDED_PACKED_TO_STRIDED)
+            cpu_copy_test( "strided-packed -> strided       ", N_tests, N_symbols, h_strided_packed_set, h_out_strided_set );
+        if (TEST_MASK & CONCAT_TO_STRIDED_PACKED)
+            cpu_copy_test( "concat         -> strided-packed", N_tests, N_symbols, h_concat_set, h_out_strided_packed_set );
+        if (TEST_MASK & PACKED_CONCAT_TO_STRIDED_PACKED)
+            cpu_copy_test( "packed-concat  -> strided-packed", N_tests, N_symbols, h_packed_concat_set, h_out_strided_packed_set );
+        if (TEST_MASK & PACKED_SPARSE_TO_STRIDED_PACKED)
+            cpu_copy_test( "packed-sparse  -> strided-packed", N_tests, N_symbols, h_packed_sparse_set, h_out_strided_packed_set );
     }
 
     // copy a sparse string set into a concatenated one
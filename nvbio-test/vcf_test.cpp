@@ -0,0 +1,179 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+// vcf_test.cpp
+//
+
+#include <nvbio/io/vcf.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/dna.h>
+#include <htslib/bgzf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+namespace nvbio {
+
+namespace {
+
+const char VCF_TEXT[] =
+    "##fileformat=VCFv4.2\n"
+    "##INFO=<ID=END,Number=1,Type=Integer,Description=\"End position\">\n"
+    "##INFO=<ID=DB,Number=0,Type=Flag,Description=\"dbSNP membership\">\n"
+    "##contig=<ID=chr1,length=1000>\n"
+    "##contig=<ID=chr2,length=1000>\n"
+    "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\n"
+    "chr1\t10\trs1\tA\tG\t29.5\tPASS\tDB\n"
+    "chr1\t20\t.\tAC\tA,ACT\t50\tPASS\t.\n"
+    "chr1\t30\t.\tG\t.\t.\tPASS\tEND=35\n"
+    "chr2\t5\t.\tT\tC\t300\tPASS\t.\n"
+    "chr2\t8\t.\tGATTACA\tG\t0.4\tPASS\tDB;END=14\n";
+
+// the variants expected from VCF_TEXT
+//
+struct ExpectedVariant
+{
+    const char* chrom;
+    uint32      start;
+    uint32      stop;
+    const char* ref;
+    const char* var;
+    uint8       quality;
+};
+
+const ExpectedVariant EXPECTED[] = {
+    { "chr1", 10, 11, "A",       "G",   29   },
+    { "chr1", 20, 22, "AC",      "A",   50   },
+    { "chr1", 20, 22, "AC",      "ACT", 50   },
+    { "chr1", 30, 35, "G",       "G",   0xff },
+    { "chr2",  5,  6, "T",       "C",   254  },
+    { "chr2",  8, 14, "GATTACA", "G",   0    },
+};
+
+// extract a string from a packed IUPAC16 vector
+//
+std::string extract(const PackedVector<host_tag,4>& symbols, const uint32 begin, const uint32 len)
+{
+    std::string str( len, ' ' );
+    for (uint32 i = 0; i < len; ++i)
+        str[i] = iupac16_to_char( symbols[ begin + i ] );
+    return str;
+}
+
+// check a loaded database against the expected variants
+//
+bool check_variants(const io::SNPDatabase& db, const char* name)
+{
+    const uint32 n_variants = uint32( sizeof(EXPECTED) / sizeof(EXPECTED[0]) );
+
+    if (db.ref_variant_index.size() != n_variants ||
+        db.reference_sequence_names.size() != n_variants ||
+        db.sequence_positions.size() != n_variants ||
+        db.variant_qualities.size() != n_variants)
+    {
+        log_error(stderr, "  %s: %llu variants, expected %u\n", name, uint64( db.ref_variant_index.size() ), n_variants);
+        return false;
+    }
+
+    for (uint32 i = 0; i < n_variants; ++i)
+    {
+        const io::SNP_sequence_index& index = db.ref_variant_index[i];
+
+        const std::string ref = extract( db.reference_sequences, index.reference_start, index.reference_len );
+        const std::string var = extract( db.variants,            index.variant_start,   index.variant_len );
+
+        if (db.reference_sequence_names[i] != EXPECTED[i].chrom ||
+            db.sequence_positions[i].x     != EXPECTED[i].start ||
+            db.sequence_positions[i].y     != EXPECTED[i].stop  ||
+            db.variant_qualities[i]        != EXPECTED[i].quality ||
+            ref != EXPECTED[i].ref ||
+            var != EXPECTED[i].var)
+        {
+            log_error(stderr, "  %s: variant %u mismatch: %s:%u-%u %s -> %s (%u)\n", name, i,
+                db.reference_sequence_names[i].c_str(),
+                db.sequence_positions[i].x,
+                db.sequence_positions[i].y,
+                ref.c_str(),
+                var.c_str(),
+                uint32( db.variant_qualities[i] ));
+            return false;
+        }
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int vcf_test()
+{
+    printf("VCF test... started\n");
+
+    const char* vcf_name  = "nvbio-test.vcf";
+    const char* bgzf_name = "nvbio-test.vcf.gz";
+
+    // write the same records as plain text and BGZF-compressed VCF
+    {
+        FILE* file = fopen( vcf_name, "wb" );
+        if (file == NULL || fwrite( VCF_TEXT, 1, sizeof(VCF_TEXT)-1, file ) != sizeof(VCF_TEXT)-1)
+        {
+            log_error(stderr, "  failed writing %s\n", vcf_name);
+            exit(1);
+        }
+        fclose( file );
+    }
+    {
+        BGZF* file = bgzf_open( bgzf_name, "w" );
+        if (file == NULL || bgzf_write( file, VCF_TEXT, sizeof(VCF_TEXT)-1 ) != ssize_t( sizeof(VCF_TEXT)-1 ))
+        {
+            log_error(stderr, "  failed writing %s\n", bgzf_name);
+            exit(1);
+        }
+        bgzf_close( file );
+    }
+
+    // the parallel text parser and htslib must agree on all the fields
+    {
+        io::SNPDatabase db;
+        if (io::loadVCF( db, vcf_name ) == false || check_variants( db, "plain VCF" ) == false)
+            exit(1);
+    }
+    {
+        io::SNPDatabase db;
+        if (io::loadVCF( db, bgzf_name ) == false || check_variants( db, "BGZF VCF" ) == false)
+            exit(1);
+    }
+
+    remove( vcf_name );
+    remove( bgzf_name );
+
+    printf("VCF test... done\n");
+    return 0;
+}
+
+} // namespace nvbio
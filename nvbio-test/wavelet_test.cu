@@ -34,10 +34,11 @@
 #include <nvbio/strings/wavelet_tree.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <vector>
 
 namespace nvbio {
 
-template <typename BitStreamIterator, typename IndexIterator>
+template <typename wavelet_tree_type>
 struct text_functor
 {
     typedef uint32 argument_type;
@@ -46,19 +47,58 @@ struct text_functor
     // constructor
     NVBIO_HOST_DEVICE
     text_functor(
-        WaveletTree<BitStreamIterator,IndexIterator> _tree) : tree(_tree) {}
+        wavelet_tree_type _tree) : tree(_tree) {}
 
     // unary operator
     NVBIO_HOST_DEVICE
     uint8 operator() (const uint32 i) const { return text( tree, i ); }
 
-    WaveletTree<BitStreamIterator,IndexIterator> tree;
+    wavelet_tree_type tree;
 };
 
-template <typename BitStreamIterator, typename IndexIterator>
-text_functor<BitStreamIterator,IndexIterator> make_text_functor(WaveletTree<BitStreamIterator,IndexIterator> _tree)
+template <typename wavelet_tree_type>
+text_functor<wavelet_tree_type> make_text_functor(wavelet_tree_type _tree)
 {
-    return text_functor<BitStreamIterator,IndexIterator>( _tree );
+    return text_functor<wavelet_tree_type>( _tree );
+}
+
+// check the text and the ranks of a host wavelet tree against the original string
+//
+template <typename wavelet_tree_type>
+bool check_wavelet_tree(const char* name, const uint32 text_len, const uint8* h_text, const wavelet_tree_type tree)
+{
+    for (uint32 i = 0; i < text_len; ++i)
+    {
+        const uint32 c = text( tree, i );
+        const uint32 r = h_text[i];
+
+        if (c != r)
+        {
+            log_error(stderr, "error in %s text(%u): expected %u, got %u!\n", name, i, r, c);
+            return false;
+        }
+    }
+
+    // keep running counts of all symbols, and check a sample of the ranks against them
+    std::vector<uint32> counts( 256, 0u );
+    for (uint32 i = 0; i < text_len; ++i)
+    {
+        ++counts[ h_text[i] ];
+
+        if ((i % 97) == 0)
+        {
+            for (uint32 c = 0; c < 256; c += 3)
+            {
+                const uint32 n = rank( tree, i, c );
+                if (n != counts[c])
+                {
+                    log_error(stderr, "error in %s rank(%u,%u): expected %u, got %u!\n", name, i, c, counts[c], n);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
 }
 
 int wavelet_test(int argc, char* argv[])
@@ -135,6 +175,64 @@ int wavelet_test(int argc, char* argv[])
             }
         }
 
+        // build the same tree on the host
+        {
+            typedef WaveletTreeStorage<host_tag>            h_wavelet_tree_type;
+            typedef InterleavedWaveletTreeStorage<host_tag> h_interleaved_tree_type;
+
+            h_wavelet_tree_type h_wavelet_tree;
+
+            Timer timer;
+            timer.start();
+
+            setup( text_len, h_text.begin(), h_wavelet_tree );
+
+            timer.stop();
+            log_info(stderr, "  host build: %.1f M symbols/s\n", 1.0e-6f * float(text_len) / timer.seconds());
+
+            if (check_wavelet_tree( "host", text_len, raw_pointer( h_text ), plain_view( (const h_wavelet_tree_type&)h_wavelet_tree ) ) == false)
+                return 1;
+
+            // convert it to the interleaved layout
+            h_interleaved_tree_type h_interleaved_tree;
+            interleave( h_wavelet_tree, h_interleaved_tree );
+
+            if (check_wavelet_tree( "interleaved", text_len, raw_pointer( h_text ), plain_view( (const h_interleaved_tree_type&)h_interleaved_tree ) ) == false)
+                return 1;
+        }
+
+        // build an interleaved tree on the device
+        {
+            typedef InterleavedWaveletTreeStorage<device_tag> interleaved_tree_type;
+
+            interleaved_tree_type interleaved_tree;
+
+            setup( text_len, d_text.begin(), interleaved_tree );
+
+            // extract the text
+            nvbio::vector<device_tag,uint8> d_extracted_text( text_len );
+            nvbio::transform<device_tag>(
+                text_len,
+                thrust::make_counting_iterator<uint32>(0),
+                d_extracted_text.begin(),
+                make_text_functor( plain_view(interleaved_tree) ) );
+
+            // and copy it back to the host
+            nvbio::vector<host_tag,uint8> h_extracted_text( d_extracted_text );
+
+            for (uint32 i = 0; i < text_len; ++i)
+            {
+                const uint32 c = h_extracted_text[i];
+                const uint32 r = h_text[i];
+
+                if (c != r)
+                {
+                    log_error(stderr, "error in interleaved text(%u): expected %u, got %u!\n", i, r, c);
+                    return 1;
+                }
+            }
+        }
+
         log_info(stderr, "wavelet test... done\n");
     }
     catch (...)
@@ -98,6 +98,11 @@
 ///        best2 );                                             // alignment sink
 ///
 /// \endcode
+///\par
+/// Protein alignments can be scored with substitution matrices, either built-in (BLOSUM45 to BLOSUM90,
+/// PAM30, PAM70 and PAM250) or loaded from NCBI-formatted files, through a \ref MatrixGotohScheme;
+/// on the host, a \ref QueryProfile built once per pattern drives the scalar and SSE2 local aligners
+/// of nvbio/alignment/substitution_matrix.h.
 ///
 ///\anchor AlignersAnchor
 /// \section AlignersSection Aligners and Alignment Algorithms
@@ -117,6 +122,14 @@
 /// - \ref PatternBlockingTag : a DP algorithm which blocks the matrix in stripes along the pattern
 /// - \ref TextBlockingTag : a DP algorithm which blocks the matrix in stripes along the text
 /// - \ref MyersTag : the Myers bit-vector algorithm, a very fast algorithm to perform edit distance computations
+///\par
+/// On the host, large batches of edit distance problems can also be scored with
+/// \ref batch_myers_score() (see nvbio/alignment/myers/myers_simd.h), which, when compiled with AVX2 support,
+/// runs four Myers bit-vector problems per instruction.
+///\par
+/// Seed hits can be extended into long references with extension_alignment_score() and
+/// extension_alignment_traceback() (see nvbio/alignment/extension.h), which run a Gotoh aligner
+/// over an adaptive band pruned by X-drop, and stop early at Z-drop points.
 ///
 /// \section TracebackSection Traceback
 ///\par
@@ -132,6 +145,12 @@
 ///
 /// - banded_alignment_traceback()
 /// - alignment_traceback()
+///\par
+/// The whole-matrix traceback needs temporary storage proportional to the size of the DP matrix
+/// divided by the checkpointing interval, which becomes prohibitive for long alignments.
+/// On the host, hirschberg_alignment_traceback() offers an alternative mode for all aligners, which
+/// recomputes the DP with Hirschberg's divide and conquer strategy keeping only O(n+m) memory,
+/// at the cost of roughly twice the work, and reports the alignment through the same backtracer.
 ///
 /// \subsection Backtracer Backtracer Model
 ///\par
@@ -670,6 +689,47 @@ Alignment<int32> alignment_traceback(
     const int32             min_score,
     backtracer_type&        backtracer);
 
+///
+/// Backtrace an optimal alignment in linear space using Hirschberg's divide and conquer algorithm.
+///
+/// This is a host-only, high level function: it allocates O(pattern.length()) temporary storage,
+/// independently of the text length, and doesn't impose any limit on the size of the problem;
+/// the scores are kept at 32-bit precision throughout.
+/// For Gotoh aligners insertions are scored with the pattern gap costs and deletions with
+/// the text gap costs. With symmetric gap costs the reported alignment has the same score as
+/// the one reported by alignment_traceback(), though among several co-optimal alignments the
+/// two functions might pick different ones; with asymmetric costs the scores may differ, as
+/// the other DP kernels score all gaps but the leading text gaps with the pattern gap costs.
+///
+/// \tparam aligner_type        an \ref Aligner "Aligner" algorithm
+/// \tparam pattern_string      a string representing the pattern.
+/// \tparam qual_string         an array representing the pattern qualities.
+/// \tparam text_string         a string representing the text.
+/// \tparam backtracer_type     a model of \ref Backtracer.
+///
+/// \param aligner              alignment algorithm
+/// \param pattern              pattern to be aligned
+/// \param quals                pattern quality scores
+/// \param text                 text to align the pattern to
+/// \param min_score            minimum accepted score
+/// \param backtracer           backtracking delegate
+///
+/// \return                     reported alignment
+///
+template <
+    typename        aligner_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type>
+Alignment<int32> hirschberg_alignment_traceback(
+    const aligner_type      aligner,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+    const int32             min_score,
+    backtracer_type&        backtracer);
+
 #if defined(__CUDACC__)
 namespace warp {
 
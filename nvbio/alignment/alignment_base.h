@@ -78,10 +78,14 @@ struct PatternBlockingTag {};  ///< block along the pattern
 ///\anchor TextBlockingTag
 struct TextBlockingTag {};     ///< block along the text (at the moment, this is only supported for scoring)
 
-/// Myers bit-vector algorithm, only supported for the EditDistanceAligner
+/// Myers bit-vector algorithm, only supported for the EditDistanceAligner.
+/// Full DP scoring and traceback use Hyyro's blocked formulation with 64-bit words, supporting
+/// GLOBAL and SEMI_GLOBAL alignment of patterns of arbitrary length (LOCAL alignment, which is
+/// degenerate under unit costs, falls back to the standard DP).
+/// Symbols outside the alphabet never match.
 ///
 ///\tparam ALPHABET_SIZE_T      the size of the alphabet, in symbols; currently there are fast
-///                             specializations for alphabets of 2, 4 and 5 symbols.
+///                             banded specializations for alphabets of 2, 4 and 5 symbols.
 ///
 ///\anchor MyersTag
 template <uint32 ALPHABET_SIZE_T> struct MyersTag { static const uint32 ALPHABET_SIZE = ALPHABET_SIZE_T; }; ///< Myers bit-vector algorithm
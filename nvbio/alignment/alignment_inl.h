@@ -32,8 +32,10 @@
 #include <nvbio/alignment/alignment_base_inl.h>
 #include <nvbio/alignment/sw/sw_inl.h>
 #include <nvbio/alignment/ed/ed_inl.h>
+#include <nvbio/alignment/myers/myers_inl.h>
 #include <nvbio/alignment/gotoh/gotoh_inl.h>
 #include <nvbio/alignment/hamming/hamming_inl.h>
+#include <nvbio/alignment/hirschberg/hirschberg_inl.h>
 
 #if defined(__CUDACC__)
 #include <nvbio/alignment/sw/sw_warp_inl.h>
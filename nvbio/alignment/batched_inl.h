@@ -34,6 +34,8 @@
 #include <nvbio/basic/cuda/work_queue.h>
 #include <nvbio/basic/strided_iterator.h>
 #include <nvbio/basic/vector.h>
+#include <nvbio/basic/arena.h>
+#include <nvbio/basic/profiling.h>
 #include <nvbio/strings/prefetcher.h>
 #if defined(_OPENMP)
 #include <omp.h>
@@ -295,14 +297,22 @@ void BatchedAlignmentScore<stream_type,HostThreadScheduler>::enact(stream_type s
         stream.max_text_length(),
         stream.size() );
 
-    nvbio::vector<host_tag,uint8> temp_vec( min_temp_size );
-    cell_type* columns = (cell_type*)nvbio::raw_pointer( temp_vec );
+    // use the provided temporary storage if large enough, or fall back to the thread's arena:
+    // in both cases the columns are left uninitialized, so that each of them gets first
+    // touched by the thread which owns it
+    HostArena::Scope temp_scope( thread_arena() );
+
+    cell_type* columns = (temp != NULL && temp_size >= min_temp_size) ?
+        (cell_type*)temp :
+        temp_scope.alloc<cell_type>( util::divide_ri( min_temp_size, sizeof(cell_type) ) );
 
     #if defined(_OPENMP)
-    #pragma omp parallel for
+    #pragma omp parallel
     #endif
-    for (int work_id = 0; work_id < int( stream.size() ); ++work_id)
     {
+        // profile each thread's share of the work
+        NVBIO_PROFILE_REGION( "alignment/batch-score" );
+
       #if defined(_OPENMP)
         const uint32 thread_id = omp_get_thread_num();
       #else
@@ -316,8 +326,14 @@ void BatchedAlignmentScore<stream_type,HostThreadScheduler>::enact(stream_type s
         // for the CPU it might be better to keep column storage contiguous
         cell_type* column = columns + thread_id * column_size;
 
-        // and solve the actual alignment problem
-        batched_alignment_score( stream, column, work_id, thread_id );
+        #if defined(_OPENMP)
+        #pragma omp for
+        #endif
+        for (int work_id = 0; work_id < int( stream.size() ); ++work_id)
+        {
+            // and solve the actual alignment problem
+            batched_alignment_score( stream, column, work_id, thread_id );
+        }
     }
 }
 
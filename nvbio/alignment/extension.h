@@ -0,0 +1,185 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/alignment/alignment_base.h>
+#include <nvbio/alignment/utils.h>
+
+namespace nvbio {
+namespace aln {
+
+///
+///@addtogroup Alignment
+///@{
+///
+
+///
+///@addtogroup Extension Seed Extension
+/// Host-side Gotoh extension of an anchored alignment, typically a seed hit, into a long text.
+/// Rather than scoring the full matrix or a fixed band, the extension keeps an adaptive band
+/// of columns per text row: cells falling more than \ref ExtensionParams::xdrop "xdrop" below the
+/// best score seen so far are pruned, and the band grows by one diagonal per row on its right side
+/// and shrinks on both sides as cells die.
+/// The extension stops when the band becomes empty, or when the score drops by more than
+/// \ref ExtensionParams::zdrop "zdrop" (plus a gap extension for each diagonal of difference)
+/// below the best cell, which splits long alignments at large indels or rearrangements
+/// rather than bridging them.
+///\par
+/// The pattern and text are both anchored at their first character, with an initial score
+/// given by the caller (e.g. the seed score); extending to the left of a seed is done by passing
+/// reversed strings.
+///@{
+///
+
+///
+/// Parameters of an extension
+///
+struct ExtensionParams
+{
+    ExtensionParams() : xdrop( 100 ), zdrop( 100 ), max_band( 0u ) {}
+
+    int32   xdrop;      ///< prune the cells scoring more than xdrop below the best one
+    int32   zdrop;      ///< stop when the best score of a row is more than zdrop below the best one, diagonal shifts aside; 0 to disable
+    uint32  max_band;   ///< the maximum distance of a cell from the main diagonal; 0 for no limit
+};
+
+///
+/// The result of an extension
+///
+struct ExtensionAlignment
+{
+    ExtensionAlignment() :
+        score( 0 ),
+        sink( make_uint2( 0u, 0u ) ),
+        global_score( Field_traits<int32>::min() ),
+        global_text_end( uint32(-1) ),
+        text_end( 0u ),
+        max_band( 0u ),
+        zdropped( false ),
+        traceback_failed( false ) {}
+
+    int32   score;              ///< best score, including the initial one
+    uint2   sink;               ///< the end of the best extension, as (text,pattern) lengths
+    int32   global_score;       ///< best score of an extension reaching the end of the pattern, if any
+    uint32  global_text_end;    ///< the text length of the best end-to-end extension, or uint32(-1)
+    uint32  text_end;           ///< the number of text rows processed before stopping
+    uint32  max_band;           ///< the widest band used, in cells
+    bool    zdropped;           ///< true if the extension was stopped by the Z-drop test
+    bool    traceback_failed;   ///< true if the traceback was stopped on leaving the stored band, in which case the backtracer holds an incomplete alignment
+};
+
+///
+/// Score the extension of an alignment anchored at the beginning of a pattern and a text,
+/// using a Gotoh aligner with an adaptive X-drop band and Z-drop termination.
+///
+/// \tparam TYPE                the AlignmentType of the aligner, which is ignored
+/// \tparam scoring_scheme_type a model of \ref GotohScoringScheme
+/// \tparam algorithm_tag       the algorithm tag of the aligner, which is ignored
+/// \tparam pattern_string      a string representing the pattern.
+/// \tparam qual_string         an array representing the pattern qualities.
+/// \tparam text_string         a string representing the text.
+///
+/// \param aligner              alignment algorithm
+/// \param pattern              pattern to be extended
+/// \param quals                pattern quality scores
+/// \param text                 text to extend the pattern into
+/// \param h0                   the initial score, i.e. the score of the anchor
+/// \param params               extension parameters
+///
+/// \return                     the extension result
+///
+template <
+    AlignmentType   TYPE,
+    typename        scoring_scheme_type,
+    typename        algorithm_tag,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string>
+ExtensionAlignment extension_alignment_score(
+    const GotohAligner<TYPE,scoring_scheme_type,algorithm_tag> aligner,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+    const int32             h0,
+    const ExtensionParams   params);
+
+///
+/// Extend an alignment anchored at the beginning of a pattern and a text, as
+/// extension_alignment_score() does, and backtrace the best extension into a \ref Backtracer.
+/// The direction vectors are kept only for the cells inside the band, so that memory is
+/// proportional to the band area rather than to the whole matrix.
+/// As for the other traceback functions, the first and last calls to the backtracer are
+/// clip(pattern.length() - sink.y) and clip(0).
+/// Should the traceback ever point outside of the stored band, it is stopped without the
+/// final clip(0) call and ExtensionAlignment::traceback_failed is set: the backtracer content
+/// must then be discarded.
+///
+/// \tparam TYPE                the AlignmentType of the aligner, which is ignored
+/// \tparam scoring_scheme_type a model of \ref GotohScoringScheme
+/// \tparam algorithm_tag       the algorithm tag of the aligner, which is ignored
+/// \tparam pattern_string      a string representing the pattern.
+/// \tparam qual_string         an array representing the pattern qualities.
+/// \tparam text_string         a string representing the text.
+/// \tparam backtracer_type     a model of \ref Backtracer.
+///
+/// \param aligner              alignment algorithm
+/// \param pattern              pattern to be extended
+/// \param quals                pattern quality scores
+/// \param text                 text to extend the pattern into
+/// \param h0                   the initial score, i.e. the score of the anchor
+/// \param params               extension parameters
+/// \param backtracer           backtracking delegate
+///
+/// \return                     the extension result
+///
+template <
+    AlignmentType   TYPE,
+    typename        scoring_scheme_type,
+    typename        algorithm_tag,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type>
+ExtensionAlignment extension_alignment_traceback(
+    const GotohAligner<TYPE,scoring_scheme_type,algorithm_tag> aligner,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+    const int32             h0,
+    const ExtensionParams   params,
+    backtracer_type&        backtracer);
+
+///@} // end of the Extension group
+///@} // end of the Alignment group
+
+} // namespace aln
+} // namespace nvbio
+
+#include <nvbio/alignment/extension_inl.h>
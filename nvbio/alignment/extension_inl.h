@@ -0,0 +1,367 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <vector>
+
+namespace nvbio {
+namespace aln {
+
+namespace priv {
+
+///@addtogroup private
+///@{
+
+///
+/// The adaptive band X-drop / Z-drop Gotoh extension engine.
+///
+/// The DP matrix is indexed by (i,j), with i running along the text and j along the pattern;
+/// the H and F values of the previous row are kept in two arrays over the pattern, which hold
+/// NEG_INF outside of the band. If STORE_FLOW is true, the direction vectors of each band
+/// row are appended to a flat flow buffer, for the traceback.
+///
+template <
+    bool            STORE_FLOW,
+    typename        scoring_scheme_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string>
+struct ExtensionContext
+{
+    static const int32 NEG_INF = -(1 << 28);
+
+    ExtensionContext(
+        const scoring_scheme_type   _scheme,
+        const pattern_string        _pattern,
+        const qual_string           _quals,
+        const text_string           _text) :
+        m_scheme( _scheme ),
+        m_pattern( _pattern ),
+        m_quals( _quals ),
+        m_text( _text ),
+        m_H( _pattern.length()+1, NEG_INF ),
+        m_F( _pattern.length()+1, NEG_INF ) {}
+
+    // run the extension
+    //
+    ExtensionAlignment run(const int32 h0, const ExtensionParams params)
+    {
+        const uint32 M  = m_pattern.length();
+        const uint32 N  = m_text.length();
+        const int32  go = m_scheme.pattern_gap_open();
+        const int32  ge = m_scheme.pattern_gap_extension();
+
+        int32* H = &m_H[0];
+        int32* F = &m_F[0];
+
+        ExtensionAlignment result;
+        result.score = h0;
+        result.sink  = make_uint2( 0u, 0u );
+        if (M == 0)
+        {
+            result.global_score    = h0;
+            result.global_text_end = 0u;
+        }
+
+        // the first row: only insertions
+        uint32 beg = 0u;
+        uint32 end = 1u;
+        H[0] = h0;
+        if (STORE_FLOW)
+        {
+            m_row_begin.push_back( 0u );
+            m_row_offset.push_back( 0u );
+            m_flow.push_back( SINK );
+        }
+        for (int32 e = h0 + go; end <= M && e >= h0 - params.xdrop; e += ge)
+        {
+            if (params.max_band && end > params.max_band)
+                break;
+
+            H[end] = e;
+            if (STORE_FLOW)
+                m_flow.push_back( uint8( INSERTION | (end > 1u ? INSERTION_EXT : 0u) ) );
+
+            if (end == M)
+            {
+                result.global_score    = e;
+                result.global_text_end = 0u;
+            }
+            ++end;
+        }
+        result.max_band = end - beg;
+
+        uint32 i = 1;
+        for (; i <= N && beg < end; ++i)
+        {
+            // the band can grow by one diagonal on the right
+            end = nvbio::min( end + 1u, M + 1u );
+
+            // the diagonal predecessor of the first cell comes from the previous row
+            int32 diag = NEG_INF;
+            if (params.max_band)
+            {
+                const uint32 new_beg = nvbio::max( beg, i > params.max_band ? i - params.max_band : 0u );
+                end = nvbio::min( end, i + params.max_band + 1u );
+                if (new_beg >= end)
+                    break;
+
+                diag = new_beg ? H[new_beg-1] : NEG_INF;
+
+                // the cells left out of the band are dead from this row on
+                for (uint32 j = beg; j < new_beg; ++j) { H[j] = NEG_INF; F[j] = NEG_INF; }
+                beg = new_beg;
+            }
+            else
+                diag = beg ? H[beg-1] : NEG_INF;
+
+            if (STORE_FLOW)
+            {
+                m_row_begin.push_back( beg );
+                m_row_offset.push_back( uint32( m_flow.size() ) );
+            }
+
+            const uint8 r = m_text[i-1];
+
+            int32  E         = NEG_INF;
+            int32  row_max   = NEG_INF;
+            uint32 row_max_j = beg;
+
+            for (uint32 j = beg; j < end; ++j)
+            {
+                const int32 f_ext  = F[j] + ge;
+                const int32 f_open = H[j] + go;
+                F[j] = nvbio::max( f_ext, f_open );
+
+                uint32 flow;
+                int32  h;
+                if (j == 0)
+                {
+                    h    = F[0];
+                    flow = DELETION;
+                }
+                else
+                {
+                    // the left neighbour of the first cell lies outside of the band
+                    const int32 e_ext  = E + ge;
+                    const int32 e_open = j > beg ? H[j-1] + go : NEG_INF;
+                    E = nvbio::max( e_ext, e_open );
+
+                    h    = diag + m_scheme.substitution( i-1, j, r, m_pattern[j-1], uint8( m_quals[j-1] ) );
+                    flow = SUBSTITUTION;
+
+                    // break ties the same way the full DP does
+                    if (F[j] > E) { if (F[j] > h) { h = F[j]; flow = DELETION;  } }
+                    else          { if (E    > h) { h = E;    flow = INSERTION; } }
+
+                    if (e_ext > e_open)
+                        flow |= INSERTION_EXT;
+                }
+                if (f_ext > f_open)
+                    flow |= DELETION_EXT;
+
+                diag = H[j];
+                H[j] = h;
+
+                if (STORE_FLOW)
+                    m_flow.push_back( uint8( flow ) );
+
+                if (h > row_max)
+                {
+                    row_max   = h;
+                    row_max_j = j;
+                }
+            }
+
+            if (end == M+1 && H[M] > result.global_score)
+            {
+                result.global_score    = H[M];
+                result.global_text_end = i;
+            }
+
+            if (row_max > result.score)
+            {
+                result.score = row_max;
+                result.sink  = make_uint2( i, row_max_j );
+            }
+            else if (params.zdrop > 0)
+            {
+                // Z-drop: compare against the best cell, not penalizing the diagonal shift more than a gap would
+                const int32 di = int32(i)         - int32(result.sink.x);
+                const int32 dj = int32(row_max_j) - int32(result.sink.y);
+                const int32 shift = di > dj ? di - dj : dj - di;
+                if (result.score - row_max > params.zdrop - ge * shift)
+                {
+                    result.zdropped = true;
+                    ++i;
+                    break;
+                }
+            }
+
+            // X-drop: prune the dead cells at both ends of the band
+            const int32 threshold = result.score - params.xdrop;
+
+            uint32 new_beg = beg;
+            while (new_beg < end && nvbio::max( H[new_beg], F[new_beg] ) < threshold)
+                ++new_beg;
+
+            uint32 new_end = end;
+            while (new_end > new_beg && nvbio::max( H[new_end-1], F[new_end-1] ) < threshold)
+                --new_end;
+
+            for (uint32 j = beg; j < new_beg; ++j) { H[j] = NEG_INF; F[j] = NEG_INF; }
+            for (uint32 j = new_end; j < end; ++j) { H[j] = NEG_INF; F[j] = NEG_INF; }
+
+            result.max_band = nvbio::max( result.max_band, end - beg );
+
+            beg = new_beg;
+            end = new_end;
+        }
+        result.text_end = i-1;
+        return result;
+    }
+
+    // backtrace the extension ending at the given sink, returning false if the
+    // path left the stored band, in which case the backtracer holds a partial alignment
+    //
+    template <typename backtracer_type>
+    bool traceback(const uint2 sink, backtracer_type& backtracer) const
+    {
+        enum TracebackState { H_STATE, E_STATE, F_STATE };
+
+        backtracer.clip( m_pattern.length() - sink.y );
+
+        TracebackState state = H_STATE;
+        uint32 i = sink.x;
+        uint32 j = sink.y;
+        while (i > 0u || j > 0u)
+        {
+            // fail rather than read outside of the stored band
+            const uint32 row_end = i+1 < m_row_offset.size() ? m_row_offset[i+1] : uint32( m_flow.size() );
+            if (j < m_row_begin[i] || m_row_offset[i] + j - m_row_begin[i] >= row_end)
+                return false;
+
+            const uint8 flow = m_flow[ m_row_offset[i] + j - m_row_begin[i] ];
+            if (state == H_STATE)
+            {
+                const uint32 dir = flow & HMASK;
+                if (dir == SUBSTITUTION)
+                {
+                    backtracer.push( SUBSTITUTION );
+                    --i; --j;
+                }
+                else
+                    state = (dir == INSERTION) ? E_STATE : F_STATE;
+            }
+            else if (state == E_STATE)
+            {
+                backtracer.push( INSERTION );
+                state = (flow & INSERTION_EXT) ? E_STATE : H_STATE;
+                --j;
+            }
+            else
+            {
+                backtracer.push( DELETION );
+                state = (flow & DELETION_EXT) ? F_STATE : H_STATE;
+                --i;
+            }
+        }
+
+        backtracer.clip( 0u );
+        return true;
+    }
+
+    scoring_scheme_type     m_scheme;
+    pattern_string          m_pattern;
+    qual_string             m_quals;
+    text_string             m_text;
+    std::vector<int32>      m_H;
+    std::vector<int32>      m_F;
+    std::vector<uint32>     m_row_begin;
+    std::vector<uint32>     m_row_offset;
+    std::vector<uint8>      m_flow;
+};
+
+///@} // end of private group
+
+} // namespace priv
+
+//
+// Score the extension of an alignment anchored at the beginning of a pattern and a text.
+//
+template <
+    AlignmentType   TYPE,
+    typename        scoring_scheme_type,
+    typename        algorithm_tag,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string>
+ExtensionAlignment extension_alignment_score(
+    const GotohAligner<TYPE,scoring_scheme_type,algorithm_tag> aligner,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+    const int32             h0,
+    const ExtensionParams   params)
+{
+    priv::ExtensionContext<false,scoring_scheme_type,pattern_string,qual_string,text_string> context(
+        aligner.scheme, pattern, quals, text );
+
+    return context.run( h0, params );
+}
+
+//
+// Extend an alignment anchored at the beginning of a pattern and a text, and backtrace it.
+//
+template <
+    AlignmentType   TYPE,
+    typename        scoring_scheme_type,
+    typename        algorithm_tag,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type>
+ExtensionAlignment extension_alignment_traceback(
+    const GotohAligner<TYPE,scoring_scheme_type,algorithm_tag> aligner,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+    const int32             h0,
+    const ExtensionParams   params,
+    backtracer_type&        backtracer)
+{
+    priv::ExtensionContext<true,scoring_scheme_type,pattern_string,qual_string,text_string> context(
+        aligner.scheme, pattern, quals, text );
+
+    ExtensionAlignment result = context.run( h0, params );
+    result.traceback_failed = context.traceback( result.sink, backtracer ) == false;
+    return result;
+}
+
+} // namespace aln
+} // namespace nvbio
@@ -0,0 +1,570 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/alignment/alignment_base.h>
+#include <vector>
+
+namespace nvbio {
+namespace aln {
+
+namespace priv {
+
+///@addtogroup private
+///@{
+
+///
+/// Host-side scoring adapters exposing a uniform affine-gap interface over the different
+/// aligner families, as needed by the linear-space traceback:
+/// a linear gap model is simply an affine one whose open and extension costs coincide.
+///
+template <typename aligner_type> struct HirschbergScoring {};
+
+///
+/// edit distance adapter
+///
+template <AlignmentType TYPE, typename algorithm_tag>
+struct HirschbergScoring< EditDistanceAligner<TYPE,algorithm_tag> >
+{
+    HirschbergScoring(const EditDistanceAligner<TYPE,algorithm_tag> aligner) {}
+
+    int32 substitution(const uint32 i, const uint32 j, const uint8 r, const uint8 q, const uint8 qq) const { return r == q ? 0 : -1; }
+    int32 deletion_open()       const { return -1; }
+    int32 deletion_extension()  const { return -1; }
+    int32 insertion_open()      const { return -1; }
+    int32 insertion_extension() const { return -1; }
+};
+
+///
+/// Smith-Waterman adapter
+///
+template <AlignmentType TYPE, typename scoring_scheme_type, typename algorithm_tag>
+struct HirschbergScoring< SmithWatermanAligner<TYPE,scoring_scheme_type,algorithm_tag> >
+{
+    HirschbergScoring(const SmithWatermanAligner<TYPE,scoring_scheme_type,algorithm_tag> aligner) : m_scheme( aligner.scheme ) {}
+
+    int32 substitution(const uint32 i, const uint32 j, const uint8 r, const uint8 q, const uint8 qq) const
+    {
+        return r == q ? m_scheme.match(qq) : m_scheme.mismatch(r,q,qq);
+    }
+    int32 deletion_open()       const { return m_scheme.deletion(); }
+    int32 deletion_extension()  const { return m_scheme.deletion(); }
+    int32 insertion_open()      const { return m_scheme.insertion(); }
+    int32 insertion_extension() const { return m_scheme.insertion(); }
+
+    scoring_scheme_type m_scheme;
+};
+
+///
+/// Gotoh adapter: insertions consume the pattern and pay the pattern gap costs,
+/// deletions consume the text and pay the text gap costs
+///
+template <AlignmentType TYPE, typename scoring_scheme_type, typename algorithm_tag>
+struct HirschbergScoring< GotohAligner<TYPE,scoring_scheme_type,algorithm_tag> >
+{
+    HirschbergScoring(const GotohAligner<TYPE,scoring_scheme_type,algorithm_tag> aligner) : m_scheme( aligner.scheme ) {}
+
+    // the DP passes 1-based pattern coordinates to the scheme
+    int32 substitution(const uint32 i, const uint32 j, const uint8 r, const uint8 q, const uint8 qq) const
+    {
+        return m_scheme.substitution( i, j+1, r, q, qq );
+    }
+    int32 deletion_open()       const { return m_scheme.text_gap_open(); }
+    int32 deletion_extension()  const { return m_scheme.text_gap_extension(); }
+    int32 insertion_open()      const { return m_scheme.pattern_gap_open(); }
+    int32 insertion_extension() const { return m_scheme.pattern_gap_extension(); }
+
+    scoring_scheme_type m_scheme;
+};
+
+///
+/// Linear-space (Hirschberg / Myers-Miller) traceback context.
+///
+/// The DP matrix is indexed by (i,j), where i runs along the text and j along the pattern,
+/// and holds three states: H (any), E (insertion, consuming the pattern) and F (deletion,
+/// consuming the text). Subproblems are rectangles [i0,i1] x [j0,j1] which are split along the
+/// text; a forward pass over the upper half and a reverse pass over the lower half, both keeping
+/// only a couple of rows over the pattern, locate the cell where an optimal path crosses the
+/// middle row, and whether it crosses it in the middle of a deletion.
+/// Small subproblems are solved with a full DP keeping the direction vectors.
+///
+/// Each subproblem carries two flags: start_gap signals that the path enters the rectangle
+/// continuing a deletion opened above it, while end_gap signals that the path must leave the
+/// rectangle with a deletion which continues below it.
+///
+template <
+    AlignmentType   TYPE,
+    typename        scoring_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type>
+struct HirschbergContext
+{
+    static const int32  NEG_INF    = -(1 << 28);
+    static const uint32 BASE_CELLS = 16u*1024u;
+
+    HirschbergContext(
+        const scoring_type      _scoring,
+        const pattern_string    _pattern,
+        const qual_string       _quals,
+        const text_string       _text,
+        backtracer_type&        _backtracer) :
+        m_scoring( _scoring ),
+        m_pattern( _pattern ),
+        m_quals( _quals ),
+        m_text( _text ),
+        m_backtracer( _backtracer ),
+        m_H( _pattern.length()+1 ),
+        m_F( _pattern.length()+1 ),
+        m_Hr( _pattern.length()+1 ),
+        m_Fr( _pattern.length()+1 ) {}
+
+    int32 sub(const uint32 i, const uint32 j) const
+    {
+        return m_scoring.substitution( i, j, m_text[i], m_pattern[j], uint8( m_quals[j] ) );
+    }
+
+    // forward pass over the rows (i0,i1] and the columns [j0,j1], leaving row i1 in (H,F):
+    // H[j] is the best score of a path from (i0,j0) to (i1,j), and F[j] the best score of a
+    // path ending with a deletion.
+    //
+    void forward(const uint32 i0, const uint32 i1, const uint32 j0, const uint32 j1, const bool start_gap)
+    {
+        int32* H = &m_H[0];
+        int32* F = &m_F[0];
+
+        H[j0] = start_gap ? NEG_INF : 0;
+        F[j0] = start_gap ? 0       : NEG_INF;
+
+        int32 E = NEG_INF;
+        for (uint32 j = j0+1; j <= j1; ++j)
+        {
+            E    = nvbio::max( E + m_scoring.insertion_extension(), H[j-1] + m_scoring.insertion_open() );
+            H[j] = E;
+            F[j] = NEG_INF;
+        }
+
+        for (uint32 i = i0+1; i <= i1; ++i)
+        {
+            int32 diag = H[j0];
+            F[j0] = nvbio::max( F[j0] + m_scoring.deletion_extension(), H[j0] + m_scoring.deletion_open() );
+            H[j0] = F[j0];
+
+            E = NEG_INF;
+            for (uint32 j = j0+1; j <= j1; ++j)
+            {
+                F[j] = nvbio::max( F[j] + m_scoring.deletion_extension(), H[j]   + m_scoring.deletion_open() );
+                E    = nvbio::max( E    + m_scoring.insertion_extension(), H[j-1] + m_scoring.insertion_open() );
+
+                const int32 h = nvbio::max( nvbio::max( E, F[j] ), diag + sub( i-1, j-1 ) );
+                diag = H[j];
+                H[j] = h;
+            }
+        }
+    }
+
+    // reverse pass over the rows [i0,i1) and the columns [j0,j1], leaving row i0 in (Hr,Fr):
+    // Hr[j] is the best score of a path from (i0,j) to (i1,j1), and Fr[j] the best score of a
+    // path starting with a deletion, counting its opening cost.
+    //
+    void reverse(const uint32 i0, const uint32 i1, const uint32 j0, const uint32 j1, const bool end_gap)
+    {
+        int32* H = &m_Hr[0];
+        int32* F = &m_Fr[0];
+
+        // a path ending with a deletion continuing below the rectangle is a reversed path
+        // starting with a deletion which has already been opened
+        H[j1] = end_gap ? NEG_INF : 0;
+        F[j1] = end_gap ? m_scoring.deletion_open() - m_scoring.deletion_extension() : NEG_INF;
+
+        int32 E = NEG_INF;
+        for (int32 j = int32(j1)-1; j >= int32(j0); --j)
+        {
+            E    = nvbio::max( E + m_scoring.insertion_extension(), H[j+1] + m_scoring.insertion_open() );
+            H[j] = E;
+            F[j] = NEG_INF;
+        }
+
+        for (int32 i = int32(i1)-1; i >= int32(i0); --i)
+        {
+            int32 diag = H[j1];
+            F[j1] = nvbio::max( F[j1] + m_scoring.deletion_extension(), H[j1] + m_scoring.deletion_open() );
+            H[j1] = F[j1];
+
+            E = NEG_INF;
+            for (int32 j = int32(j1)-1; j >= int32(j0); --j)
+            {
+                F[j] = nvbio::max( F[j] + m_scoring.deletion_extension(), H[j]   + m_scoring.deletion_open() );
+                E    = nvbio::max( E    + m_scoring.insertion_extension(), H[j+1] + m_scoring.insertion_open() );
+
+                const int32 h = nvbio::max( nvbio::max( E, F[j] ), diag + sub( i, j ) );
+                diag = H[j];
+                H[j] = h;
+            }
+        }
+    }
+
+    // solve a subproblem, pushing its edits backwards
+    //
+    void solve(const uint32 i0, const uint32 i1, const uint32 j0, const uint32 j1, const bool start_gap, const bool end_gap)
+    {
+        if (i1 - i0 <= 1u || (i1 - i0 + 1u)*(j1 - j0 + 1u) <= BASE_CELLS)
+        {
+            solve_base( i0, i1, j0, j1, start_gap, end_gap );
+            return;
+        }
+
+        const uint32 i_mid = (i0 + i1) / 2;
+
+        forward( i0, i_mid, j0, j1, start_gap );
+        reverse( i_mid, i1, j0, j1, end_gap );
+
+        // find the column where the optimal path crosses the middle row
+        const int32 gap_join = m_scoring.deletion_extension() - m_scoring.deletion_open();
+
+        uint32 j_mid    = j0;
+        bool   mid_gap  = false;
+        int32  best     = NEG_INF*4;
+        for (uint32 j = j0; j <= j1; ++j)
+        {
+            const int32 h = m_H[j] + m_Hr[j];
+            const int32 f = m_F[j] + m_Fr[j] + gap_join;
+            if (h > best) { best = h; j_mid = j; mid_gap = false; }
+            if (f > best) { best = f; j_mid = j; mid_gap = true; }
+        }
+
+        // solve the lower half first, as edits are pushed backwards
+        solve( i_mid, i1, j_mid, j1, mid_gap, end_gap );
+        solve( i0, i_mid, j0, j_mid, start_gap, mid_gap );
+    }
+
+    // solve a small subproblem with a full DP
+    //
+    void solve_base(const uint32 i0, const uint32 i1, const uint32 j0, const uint32 j1, const bool start_gap, const bool end_gap)
+    {
+        const uint32 n_rows = i1 - i0 + 1u;
+        const uint32 n_cols = j1 - j0 + 1u;
+
+        m_flow.resize( n_rows * n_cols );
+        uint8* flow = &m_flow[0];
+
+        int32* H = &m_H[0];
+        int32* F = &m_F[0];
+
+        H[j0] = start_gap ? NEG_INF : 0;
+        F[j0] = start_gap ? 0       : NEG_INF;
+        flow[0] = SINK;
+
+        int32 E = NEG_INF;
+        for (uint32 j = j0+1; j <= j1; ++j)
+        {
+            const int32 e_ext  = E      + m_scoring.insertion_extension();
+            const int32 e_open = H[j-1] + m_scoring.insertion_open();
+            E    = nvbio::max( e_ext, e_open );
+            H[j] = E;
+            F[j] = NEG_INF;
+            flow[ j - j0 ] = uint8( INSERTION | (e_ext > e_open ? INSERTION_EXT : 0u) );
+        }
+
+        for (uint32 i = i0+1; i <= i1; ++i)
+        {
+            uint8* row = flow + (i - i0) * n_cols;
+
+            int32 diag = H[j0];
+            {
+                const int32 f_ext  = F[j0] + m_scoring.deletion_extension();
+                const int32 f_open = H[j0] + m_scoring.deletion_open();
+                F[j0] = nvbio::max( f_ext, f_open );
+                H[j0] = F[j0];
+                row[0] = uint8( DELETION | (f_ext > f_open ? DELETION_EXT : 0u) );
+            }
+
+            E = NEG_INF;
+            for (uint32 j = j0+1; j <= j1; ++j)
+            {
+                const int32 f_ext  = F[j]   + m_scoring.deletion_extension();
+                const int32 f_open = H[j]   + m_scoring.deletion_open();
+                const int32 e_ext  = E      + m_scoring.insertion_extension();
+                const int32 e_open = H[j-1] + m_scoring.insertion_open();
+                F[j] = nvbio::max( f_ext, f_open );
+                E    = nvbio::max( e_ext, e_open );
+
+                const int32 top  = F[j];
+                const int32 left = E;
+                      int32 h    = diag + sub( i-1, j-1 );
+
+                // break ties the same way the checkpointed DP does
+                uint32 dir = SUBSTITUTION;
+                if (top > left) { if (top  > h) { h = top;  dir = DELETION;  } }
+                else            { if (left > h) { h = left; dir = INSERTION; } }
+
+                diag = H[j];
+                H[j] = h;
+
+                row[ j - j0 ] = uint8( dir |
+                    (f_ext > f_open ? DELETION_EXT  : 0u) |
+                    (e_ext > e_open ? INSERTION_EXT : 0u) );
+            }
+        }
+
+        // and trace the path back from (i1,j1)
+        enum State { H_STATE, E_STATE, F_STATE };
+        State  state = end_gap ? F_STATE : H_STATE;
+        uint32 i = i1;
+        uint32 j = j1;
+        while (i > i0 || j > j0)
+        {
+            const uint8 f = flow[ (i - i0) * n_cols + (j - j0) ];
+            if (state == H_STATE)
+            {
+                const uint32 dir = f & HMASK;
+                if (dir == SUBSTITUTION)
+                {
+                    m_backtracer.push( SUBSTITUTION );
+                    --i; --j;
+                }
+                else
+                    state = (dir == INSERTION) ? E_STATE : F_STATE;
+            }
+            else if (state == E_STATE)
+            {
+                m_backtracer.push( INSERTION );
+                state = (f & INSERTION_EXT) ? E_STATE : H_STATE;
+                --j;
+            }
+            else
+            {
+                m_backtracer.push( DELETION );
+                state = (f & DELETION_EXT) ? F_STATE : H_STATE;
+                --i;
+            }
+        }
+    }
+
+    // find the end cell of the best alignment, returning its score
+    //
+    int32 find_sink(uint2* sink)
+    {
+        const uint32 M = m_pattern.length();
+        const uint32 N = m_text.length();
+
+        if (TYPE == GLOBAL)
+        {
+            forward( 0u, N, 0u, M, false );
+            *sink = make_uint2( N, M );
+            return m_H[M];
+        }
+
+        int32* H = &m_H[0];
+        int32* F = &m_F[0];
+
+        // the first row: the text has not been consumed yet
+        int32 E = NEG_INF;
+        H[0] = 0;
+        F[0] = NEG_INF;
+        for (uint32 j = 1; j <= M; ++j)
+        {
+            E    = nvbio::max( E + m_scoring.insertion_extension(), H[j-1] + m_scoring.insertion_open() );
+            H[j] = TYPE == LOCAL ? nvbio::max( E, 0 ) : E;
+            F[j] = NEG_INF;
+        }
+
+        // like BestSink, keep the last of several equal scores
+        int32 best_score = NEG_INF;
+        uint2 best_sink  = make_uint2( uint32(-1), uint32(-1) );
+
+        for (uint32 i = 1; i <= N; ++i)
+        {
+            // the text prefix is always free
+            int32 diag = H[0];
+            F[0] = NEG_INF;
+            H[0] = 0;
+
+            E = NEG_INF;
+            for (uint32 j = 1; j <= M; ++j)
+            {
+                F[j] = nvbio::max( F[j] + m_scoring.deletion_extension(), H[j]   + m_scoring.deletion_open() );
+                E    = nvbio::max( E    + m_scoring.insertion_extension(), H[j-1] + m_scoring.insertion_open() );
+
+                int32 h = nvbio::max( nvbio::max( E, F[j] ), diag + sub( i-1, j-1 ) );
+                if (TYPE == LOCAL)
+                {
+                    h = nvbio::max( h, 0 );
+                    if (h >= best_score)
+                    {
+                        best_score = h;
+                        best_sink  = make_uint2( i, j );
+                    }
+                }
+                diag = H[j];
+                H[j] = h;
+            }
+
+            if (TYPE == SEMI_GLOBAL && H[M] >= best_score)
+            {
+                best_score = H[M];
+                best_sink  = make_uint2( i, M );
+            }
+        }
+        *sink = best_sink;
+        return best_score;
+    }
+
+    // find the start cell of the best alignment ending at the given sink
+    //
+    uint2 find_source(const uint2 sink)
+    {
+        if (TYPE == GLOBAL)
+            return make_uint2( 0u, 0u );
+
+        const uint32 j1 = sink.y;
+
+        int32* H = &m_Hr[0];
+        int32* F = &m_Fr[0];
+
+        // anchored reverse pass from the sink
+        H[j1] = 0;
+        F[j1] = NEG_INF;
+
+        int32 E = NEG_INF;
+        for (int32 j = int32(j1)-1; j >= 0; --j)
+        {
+            E    = nvbio::max( E + m_scoring.insertion_extension(), H[j+1] + m_scoring.insertion_open() );
+            H[j] = E;
+            F[j] = NEG_INF;
+        }
+
+        // keep the source closest to the sink
+        int32 best_score = TYPE == LOCAL ? 0 : H[0];
+        uint2 best_source = TYPE == LOCAL ? sink : make_uint2( sink.x, 0u );
+        if (TYPE == LOCAL)
+        {
+            for (int32 j = int32(j1)-1; j >= 0; --j)
+            {
+                if (H[j] > best_score)
+                {
+                    best_score  = H[j];
+                    best_source = make_uint2( sink.x, uint32(j) );
+                }
+            }
+        }
+
+        for (int32 i = int32(sink.x)-1; i >= 0; --i)
+        {
+            int32 diag = H[j1];
+            F[j1] = nvbio::max( F[j1] + m_scoring.deletion_extension(), H[j1] + m_scoring.deletion_open() );
+            H[j1] = F[j1];
+
+            E = NEG_INF;
+            for (int32 j = int32(j1)-1; j >= 0; --j)
+            {
+                F[j] = nvbio::max( F[j] + m_scoring.deletion_extension(), H[j]   + m_scoring.deletion_open() );
+                E    = nvbio::max( E    + m_scoring.insertion_extension(), H[j+1] + m_scoring.insertion_open() );
+
+                const int32 h = nvbio::max( nvbio::max( E, F[j] ), diag + sub( i, j ) );
+                diag = H[j];
+                H[j] = h;
+
+                if (TYPE == LOCAL && h > best_score)
+                {
+                    best_score  = h;
+                    best_source = make_uint2( uint32(i), uint32(j) );
+                }
+            }
+            if (TYPE == SEMI_GLOBAL && H[0] > best_score)
+            {
+                best_score  = H[0];
+                best_source = make_uint2( uint32(i), 0u );
+            }
+        }
+        return best_source;
+    }
+
+    scoring_type            m_scoring;
+    pattern_string          m_pattern;
+    qual_string             m_quals;
+    text_string             m_text;
+    backtracer_type&        m_backtracer;
+    std::vector<int32>      m_H;
+    std::vector<int32>      m_F;
+    std::vector<int32>      m_Hr;
+    std::vector<int32>      m_Fr;
+    std::vector<uint8>      m_flow;
+};
+
+///@} // end of private group
+
+} // namespace priv
+
+//
+// Backtrace an optimal alignment in linear space using Hirschberg's divide and conquer algorithm.
+//
+template <
+    typename        aligner_type,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        backtracer_type>
+Alignment<int32> hirschberg_alignment_traceback(
+    const aligner_type      aligner,
+    const pattern_string    pattern,
+    const qual_string       quals,
+    const text_string       text,
+    const int32             min_score,
+    backtracer_type&        backtracer)
+{
+    typedef priv::HirschbergScoring<aligner_type> scoring_type;
+    typedef priv::HirschbergContext<
+        aligner_type::TYPE,
+        scoring_type,
+        pattern_string,
+        qual_string,
+        text_string,
+        backtracer_type>                          context_type;
+
+    context_type context( scoring_type( aligner ), pattern, quals, text, backtracer );
+
+    uint2 sink;
+    const int32 score = context.find_sink( &sink );
+    if (sink.x == uint32(-1) || score < min_score)
+        return Alignment<int32>( score, make_uint2( uint32(-1), uint32(-1) ), make_uint2( uint32(-1), uint32(-1) ) );
+
+    const uint2 source = context.find_source( sink );
+
+    backtracer.clip( pattern.length() - sink.y );
+    context.solve( source.x, sink.x, source.y, sink.y, false, false );
+    backtracer.clip( source.y );
+
+    return Alignment<int32>( score, source, sink );
+}
+
+} // namespace aln
+} // namespace nvbio
@@ -0,0 +1,730 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/popcount.h>
+#include <nvbio/alignment/sink.h>
+#include <nvbio/alignment/utils.h>
+#include <nvbio/alignment/alignment_base_inl.h>
+#include <nvbio/alignment/sw/sw_inl.h>
+#include <nvbio/alignment/ed/ed_utils.h>
+
+namespace nvbio {
+namespace aln {
+
+namespace priv {
+
+///@addtogroup private
+///@{
+
+///
+/// Advance a 64-bit block of the Myers/Hyyro bit-vector edit distance matrix by one text column.
+/// The block keeps the vertical deltas of the column in the (Pv,Mv) pair, and receives the
+/// horizontal delta entering from the row right above the block; the function returns the
+/// horizontal delta leaving the block at bit out_bit.
+///
+/// \param Eq           the pattern equality mask of the current text symbol
+/// \param Pv           in/out positive vertical deltas
+/// \param Mv           in/out negative vertical deltas
+/// \param hin          horizontal delta entering the block, in [-1,1]
+/// \param out_bit      the last bit of the block, used to compute the output delta
+/// \param Ph           output positive horizontal deltas, one per block row
+/// \param Mh           output negative horizontal deltas, one per block row
+///
+/// \return             horizontal delta leaving the block
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+int32 myers_advance_block(
+          uint64    Eq,
+          uint64&   Pv,
+          uint64&   Mv,
+    const int32     hin,
+    const uint32    out_bit,
+          uint64&   Ph,
+          uint64&   Mh)
+{
+    const uint64 Xv = Eq | Mv;
+    if (hin < 0)
+        Eq |= 1u;
+
+    const uint64 Xh = (((Eq & Pv) + Pv) ^ Pv) | Eq;
+    Ph = Mv | ~(Xh | Pv);
+    Mh = Pv & Xh;
+
+    const int32 hout = int32( (Ph >> out_bit) & 1u ) - int32( (Mh >> out_bit) & 1u );
+
+    uint64 Ph_s = Ph << 1;
+    uint64 Mh_s = Mh << 1;
+    if (hin < 0)      Mh_s |= 1u;
+    else if (hin > 0) Ph_s |= 1u;
+
+    Pv = Mh_s | ~(Xv | Ph_s);
+    Mv = Ph_s & Xv;
+    return hout;
+}
+
+///
+/// Build the Myers pattern equality masks for the window [begin,end) of a pattern,
+/// laid out as ALPHABET_SIZE consecutive runs of W words.
+/// Pattern symbols outside the alphabet never match.
+///
+template <uint32 ALPHABET_SIZE, typename pattern_string, typename peq_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void myers_build_peq(
+    const pattern_string    pattern,
+    const uint32            begin,
+    const uint32            end,
+    const uint32            W,
+          peq_type          peq)
+{
+    for (uint32 i = 0; i < ALPHABET_SIZE*W; ++i)
+        peq[i] = 0u;
+
+    for (uint32 i = begin; i < end; ++i)
+    {
+        const uint32 c = uint32( pattern[i] );
+        if (c < ALPHABET_SIZE)
+            peq[ c*W + (i - begin)/64u ] |= uint64(1u) << ((i - begin) & 63u);
+    }
+}
+
+///
+/// Fetch the equality mask of the w-th block for a given text symbol
+///
+template <uint32 ALPHABET_SIZE, typename peq_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint64 myers_peq(const peq_type peq, const uint32 c, const uint32 W, const uint32 w)
+{
+    return c < ALPHABET_SIZE ? uint64( peq[ c*W + w ] ) : uint64(0u);
+}
+
+///
+/// Return the number of pattern rows covered by the b-th of W 64-bit blocks
+///
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 myers_block_rows(const uint32 b, const uint32 W, const uint32 M)
+{
+    return b == W-1u ? M - b*64u : 64u;
+}
+
+///
+/// Calculate the edit distance between a pattern of up to 64 symbols and a text,
+/// keeping the whole bit-vector column in registers.
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        text_string,
+    typename        sink_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool myers_word_score(
+    const pattern_string    pattern,
+    const text_string       text,
+    const int32             min_score,
+          sink_type&        sink)
+{
+    const uint32 M = pattern.length();
+    const uint32 N = text.length();
+
+    uint64 peq[ALPHABET_SIZE];
+    myers_build_peq<ALPHABET_SIZE>( pattern, 0u, M, 1u, peq );
+
+    const uint32 out_bit = M-1u;
+    const int32  hin     = TYPE == GLOBAL ? 1 : 0;
+
+    uint64 Pv = ~uint64(0u);
+    uint64 Mv =  uint64(0u);
+    uint64 Ph, Mh;
+
+    int32 dist = int32(M);
+    bool  found = false;
+
+    for (uint32 t = 0; t < N; ++t)
+    {
+        const uint64 Eq = myers_peq<ALPHABET_SIZE>( peq, uint32( text[t] ), 1u, 0u );
+
+        dist += myers_advance_block( Eq, Pv, Mv, hin, out_bit, Ph, Mh );
+
+        // report a potential hit
+        if (TYPE == SEMI_GLOBAL && -dist >= min_score)
+        {
+            sink.report( -dist, make_uint2( t+1, M ) );
+            found = true;
+        }
+    }
+    if (TYPE == GLOBAL && -dist >= min_score)
+    {
+        sink.report( -dist, make_uint2( N, M ) );
+        found = true;
+    }
+    return found;
+}
+
+///
+/// Calculate the edit distance between a pattern of arbitrary length and a text,
+/// splitting the bit-vector column in 64-bit blocks stored in the given column.
+/// Semi-global alignment uses Ukkonen's cut-off to only advance the blocks which
+/// can still contain cells within the minimum score.
+///
+/// The column must provide (ALPHABET_SIZE+3)*ceil(pattern_len/64) cells.
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        text_string,
+    typename        sink_type,
+    typename        column_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool myers_blocked_score(
+    const pattern_string    pattern,
+    const text_string       text,
+    const int32             min_score,
+          sink_type&        sink,
+          column_type       column)
+{
+    const uint32 M = pattern.length();
+    const uint32 N = text.length();
+    const uint32 W = (M + 63u) / 64u;
+
+    // the maximum distance we are interested in
+    const int32 k = nvbio::min( -min_score, int32( TYPE == GLOBAL ? nvbio::max( M, N ) : M ) );
+
+    // lay out the equality masks, the vertical deltas and the block scores in the column
+    column_type peq   = column;
+    column_type Pv    = column + ALPHABET_SIZE*W;
+    column_type Mv    = column + (ALPHABET_SIZE+1u)*W;
+    column_type score = column + (ALPHABET_SIZE+2u)*W;
+
+    myers_build_peq<ALPHABET_SIZE>( pattern, 0u, M, W, peq );
+
+    // with semi-global alignment, activate only the blocks whose first row is within reach
+    uint32 last_block = TYPE == SEMI_GLOBAL ?
+        nvbio::min( uint32( (k + 64) / 64 ), W ) - 1u :
+        W-1u;
+
+    for (uint32 b = 0; b <= last_block; ++b)
+    {
+        Pv[b]    = ~uint64(0u);
+        Mv[b]    =  uint64(0u);
+        score[b] = uint64( b*64u + myers_block_rows( b, W, M ) );
+    }
+
+    bool found = false;
+
+    for (uint32 t = 0; t < N; ++t)
+    {
+        const uint32 c = uint32( text[t] );
+
+        int32 hout = TYPE == GLOBAL ? 1 : 0;
+
+        for (uint32 b = 0; b <= last_block; ++b)
+        {
+            uint64 Pv_b = Pv[b];
+            uint64 Mv_b = Mv[b];
+            uint64 Ph, Mh;
+
+            hout = myers_advance_block(
+                myers_peq<ALPHABET_SIZE>( peq, c, W, b ),
+                Pv_b, Mv_b,
+                hout,
+                myers_block_rows( b, W, M ) - 1u,
+                Ph, Mh );
+
+            Pv[b]    = Pv_b;
+            Mv[b]    = Mv_b;
+            score[b] = uint64( int32( score[b] ) + hout );
+        }
+
+        if (TYPE == SEMI_GLOBAL)
+        {
+            // adjust the set of active blocks following Ukkonen's cut-off
+            if (last_block+1u < W &&
+                int32( score[last_block] ) - hout <= k &&
+                ((myers_peq<ALPHABET_SIZE>( peq, c, W, last_block+1u ) & 1u) || hout < 0))
+            {
+                // activate the next block, assuming all its cells were out of reach in the previous column
+                const uint32 b = ++last_block;
+
+                uint64 Pv_b = ~uint64(0u);
+                uint64 Mv_b =  uint64(0u);
+                uint64 Ph, Mh;
+
+                const int32 prev_score = int32( score[b-1] ) - hout + int32( myers_block_rows( b, W, M ) );
+
+                hout = myers_advance_block(
+                    myers_peq<ALPHABET_SIZE>( peq, c, W, b ),
+                    Pv_b, Mv_b,
+                    hout,
+                    myers_block_rows( b, W, M ) - 1u,
+                    Ph, Mh );
+
+                Pv[b]    = Pv_b;
+                Mv[b]    = Mv_b;
+                score[b] = uint64( prev_score + hout );
+            }
+            else
+            {
+                // deactivate all the trailing blocks whose cells are all out of reach
+                while (last_block > 0 && int32( score[last_block] ) >= k + 64)
+                    --last_block;
+            }
+
+            // report a potential hit
+            if (last_block == W-1u && int32( score[W-1u] ) <= k)
+            {
+                sink.report( -int32( score[W-1u] ), make_uint2( t+1, M ) );
+                found = true;
+            }
+        }
+    }
+    if (TYPE == GLOBAL && -int32( score[W-1u] ) >= min_score)
+    {
+        sink.report( -int32( score[W-1u] ), make_uint2( N, M ) );
+        found = true;
+    }
+    return found;
+}
+
+///
+/// Calculate the edit distance between a pattern and a text with the Myers/Hyyro bit-vector algorithm.
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        text_string,
+    typename        sink_type,
+    typename        column_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool myers_score(
+    const pattern_string    pattern,
+    const text_string       text,
+    const int32             min_score,
+          sink_type&        sink,
+          column_type       column)
+{
+    const uint32 M = pattern.length();
+    if (M == 0u || min_score > 0)
+        return false;
+
+    return (M <= 64u) ?
+        myers_word_score<TYPE,ALPHABET_SIZE>( pattern, text, min_score, sink ) :
+        myers_blocked_score<TYPE,ALPHABET_SIZE>( pattern, text, min_score, sink, column );
+}
+
+///
+/// Run the Myers/Hyyro algorithm on the window [window_id*CHECKPOINTS, (window_id+1)*CHECKPOINTS) of the pattern,
+/// using the checkpointed row at the beginning of the window (stored as a negated score) to provide
+/// the horizontal deltas entering the window.
+///
+/// If FLOW is false, the last row of the window is stored in the next checkpoint, or, if the window
+/// terminates the pattern, the alignment end-points are reported to the sink; the first window also
+/// stores the initial row in the first checkpoint.
+///
+/// If FLOW is true, the flow direction of each cell is stored in the submatrix instead, deriving it
+/// from the horizontal and vertical deltas around the cell, and breaking ties the same way the
+/// Smith-Waterman DP does.
+///
+/// All bit-vectors are kept in local storage, as the window never exceeds CHECKPOINTS rows.
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    uint32          CHECKPOINTS,
+    bool            FLOW,
+    typename        pattern_string,
+    typename        text_string,
+    typename        sink_type,
+    typename        checkpoint_type,
+    typename        submatrix_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void myers_checkpointed_window(
+    const pattern_string    pattern,
+    const text_string       text,
+    const int32             min_score,
+          sink_type&        sink,
+    checkpoint_type         checkpoints,
+    const uint32            window_id,
+    submatrix_type          submatrix)
+{
+    const uint32 W_MAX = (CHECKPOINTS + 63u) / 64u;
+
+    const uint32 M = pattern.length();
+    const uint32 N = text.length();
+
+    const uint32 window_begin = window_id * CHECKPOINTS;
+    const uint32 window_end   = nvbio::min( window_begin + CHECKPOINTS, M );
+    const uint32 H            = window_end - window_begin;
+    const uint32 W            = (H + 63u) / 64u;
+
+    uint64 peq[ ALPHABET_SIZE * W_MAX ];
+    uint64 Pv[ W_MAX ];
+    uint64 Mv[ W_MAX ];
+
+    myers_build_peq<ALPHABET_SIZE>( pattern, window_begin, window_end, W, peq );
+
+    for (uint32 b = 0; b < W; ++b)
+    {
+        Pv[b] = ~uint64(0u);
+        Mv[b] =  uint64(0u);
+    }
+
+    // the scores of the first and last row of the window in the previous column
+    int32 begin_score = int32( window_begin );
+    int32 end_score   = int32( window_end );
+
+    for (uint32 t = 0; t < N; ++t)
+    {
+        const uint32 c = uint32( text[t] );
+
+        // fetch the first row of the window
+        int32 row_score;
+        if (window_id == 0u)
+        {
+            row_score = TYPE == GLOBAL ? int32(t+1) : 0;
+            if (FLOW == false)
+                checkpoints[t] = -row_score;
+        }
+        else
+            row_score = -int32( checkpoints[ window_id*N + t ] );
+
+        int32 hout = row_score - begin_score;
+        begin_score = row_score;
+
+        for (uint32 b = 0; b < W; ++b)
+        {
+            const uint64 Eq     = myers_peq<ALPHABET_SIZE>( peq, c, W, b );
+            const uint64 Pv_old = Pv[b];
+            const uint64 Mv_old = Mv[b];
+            uint64 Ph, Mh;
+
+            const uint32 rows = myers_block_rows( b, W, H );
+
+            hout = myers_advance_block( Eq, Pv[b], Mv[b], hout, rows - 1u, Ph, Mh );
+
+            if (FLOW)
+            {
+                for (uint32 r = 0; r < rows; ++r)
+                {
+                    uint8 op;
+                    if ((Eq >> r) & 1u)
+                        op = SUBSTITUTION;
+                    else
+                    {
+                        const int32 h     = int32( (Ph     >> r) & 1u ) - int32( (Mh     >> r) & 1u );
+                        const int32 v     = int32( (Pv[b]  >> r) & 1u ) - int32( (Mv[b]  >> r) & 1u );
+                        const int32 v_old = int32( (Pv_old >> r) & 1u ) - int32( (Mv_old >> r) & 1u );
+
+                        // the diagonal predecessor is one below the cell iff h + v_old = 1,
+                        // otherwise follow the lowest gap, preferring insertions on ties
+                        op = (h + v_old == 1) ? SUBSTITUTION :
+                             (h > v)          ? DELETION     :
+                                                INSERTION;
+                    }
+                    submatrix[ t * CHECKPOINTS + b*64u + r ] = op;
+                }
+            }
+        }
+
+        if (FLOW == false)
+        {
+            end_score += hout;
+
+            if (window_end < M)
+                checkpoints[ (window_id+1u)*N + t ] = -end_score;
+            else if (TYPE == SEMI_GLOBAL && -end_score >= min_score)
+                sink.report( -end_score, make_uint2( t+1, M ) );
+        }
+    }
+    if (FLOW == false && TYPE == GLOBAL && window_end == M && -end_score >= min_score)
+        sink.report( -end_score, make_uint2( N, M ) );
+}
+
+///
+/// Calculate the alignment score between a pattern and a text, using the Myers/Hyyro bit-vector algorithm.
+///
+/// \tparam TYPE                the alignment type
+/// \tparam pattern_string      pattern string 
+/// \tparam quals_string        pattern qualities
+/// \tparam text_string         text string
+/// \tparam column_type         temporary column storage
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        column_type>
+struct alignment_score_dispatch<
+    EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >,
+    pattern_string,
+    qual_string,
+    text_string,
+    column_type>
+{
+    typedef EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> > aligner_type;
+
+    /// dispatch scoring across the whole pattern
+    ///
+    /// \param aligner      scoring scheme
+    /// \param pattern      pattern string (horizontal
+    /// \param quals        pattern qualities
+    /// \param text         text string (vertical)
+    /// \param min_score    minimum score
+    /// \param sink         output alignment sink
+    /// \param column       temporary storage for (ALPHABET_SIZE+3)*ceil(pattern_len/64) cells,
+    ///                     only used if the pattern is longer than 64 symbols
+    ///
+    /// \return             true iff the minimum score was reached
+    ///
+    template <typename sink_type>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    static bool dispatch(
+        const aligner_type      aligner,
+        const pattern_string    pattern,
+        const qual_string       quals,
+        const text_string       text,
+        const  int32            min_score,
+              sink_type&        sink,
+              column_type       column)
+    {
+        if (TYPE == LOCAL)
+        {
+            // unit-cost local edit distance is degenerate: keep using the text-blocking DP
+            typedef alignment_score_dispatch<EditDistanceAligner<TYPE,TextBlockingTag>,pattern_string,qual_string,text_string,column_type> dp_dispatcher;
+            return dp_dispatcher::dispatch( make_edit_distance_aligner<TYPE,TextBlockingTag>(), pattern, quals, text, min_score, sink, column );
+        }
+        return myers_score<TYPE,ALPHABET_SIZE>( pattern, text, min_score, sink, column );
+    }
+};
+
+///
+/// Calculate the alignment score between a pattern and a text, using the Myers/Hyyro bit-vector algorithm.
+///
+/// \tparam TYPE                the alignment type
+/// \tparam pattern_string      pattern string 
+/// \tparam quals_string        pattern qualities
+/// \tparam text_string         text string
+/// \tparam column_type         temporary column storage
+///
+template <
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        qual_string,
+    typename        text_string,
+    typename        column_type>
+struct alignment_checkpointed_dispatch<
+    CHECKPOINTS,
+    EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >,
+    pattern_string,
+    qual_string,
+    text_string,
+    column_type>
+{
+    typedef EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> > aligner_type;
+
+    typedef alignment_checkpointed_dispatch<CHECKPOINTS,EditDistanceAligner<TYPE>,pattern_string,qual_string,text_string,column_type> dp_dispatcher;
+
+    ///
+    /// Calculate a set of checkpoints of the DP matrix for the alignment between a pattern
+    /// and a text, using the edit distance.
+    ///
+    /// \tparam checkpoint_type     a class to represent the collection of checkpoints,
+    ///                             represented as a linear array storing each checkpointed
+    ///                             band contiguously.
+    ///                             The class has to provide the const indexing operator[].
+    ///
+    /// \param aligner      scoring scheme
+    /// \param pattern      pattern string (horizontal
+    /// \param quals        pattern qualities
+    /// \param text         text string (vertical)
+    /// \param min_score    minimum score
+    /// \param sink         output alignment sink
+    /// \param checkpoints  output checkpoints
+    ///
+    /// \return             true iff the minimum score was reached
+    ///
+    template <
+        typename    sink_type,
+        typename    checkpoint_type>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    static
+    void dispatch_checkpoints(
+        const aligner_type      aligner,
+        const pattern_string    pattern,
+        const qual_string       quals,
+        const text_string       text,
+        const  int32            min_score,
+              sink_type&        sink,
+        checkpoint_type         checkpoints,
+              column_type       column)
+    {
+        if (TYPE == LOCAL)
+        {
+            // unit-cost local edit distance is degenerate: keep using the pattern-blocking DP
+            dp_dispatcher::dispatch_checkpoints( make_edit_distance_aligner<TYPE>(), pattern, quals, text, min_score, sink, checkpoints, column );
+            return;
+        }
+
+        const uint32 n_checkpoints = (pattern.length() + CHECKPOINTS-1) / CHECKPOINTS;
+
+        for (uint32 window_id = 0; window_id < n_checkpoints; ++window_id)
+        {
+            myers_checkpointed_window<TYPE,ALPHABET_SIZE,CHECKPOINTS,false>(
+                pattern, text, min_score, sink, checkpoints, window_id, (uint8*)NULL );
+        }
+    }
+
+    ///
+    /// Compute the banded Dynamic Programming submatrix between two given checkpoints,
+    /// storing its flow at each cell.
+    /// The function returns the submatrix width.
+    ///
+    /// \tparam checkpoint_type     a class to represent the collection of checkpoints,
+    ///                             represented as a linear array storing each checkpointed
+    ///                             band contiguously.
+    ///                             The class has to provide the const indexing operator[].
+    ///
+    /// \tparam submatrix_type      a class to store the flow submatrix, represented
+    ///                             as a linear array of size (BAND_LEN*CHECKPOINTS).
+    ///                             The class has to provide the non-const indexing operator[].
+    ///                             Note that the submatrix entries can assume only 3 values,
+    ///                             and could hence be packed in 2 bits.
+    ///
+    /// \param checkpoints          the set of checkpointed rows
+    /// \param checkpoint_id        the starting checkpoint used as the beginning of the submatrix
+    /// \param submatrix            the output submatrix
+    ///
+    /// \return                     the submatrix width
+    ///
+    template <
+        typename      checkpoint_type,
+        typename      submatrix_type>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    static
+    uint32 dispatch_submatrix(
+        const aligner_type      aligner,
+        const pattern_string    pattern,
+        const qual_string       quals,
+        const text_string       text,
+        const int32             min_score,
+        checkpoint_type         checkpoints,
+        const uint32            checkpoint_id,
+        submatrix_type          submatrix,
+        column_type             column)
+    {
+        if (TYPE == LOCAL)
+            return dp_dispatcher::dispatch_submatrix( make_edit_distance_aligner<TYPE>(), pattern, quals, text, min_score, checkpoints, checkpoint_id, submatrix, column );
+
+        NullSink null_sink;
+        myers_checkpointed_window<TYPE,ALPHABET_SIZE,CHECKPOINTS,true>(
+            pattern, text, min_score, null_sink, checkpoints, checkpoint_id, submatrix );
+
+        const uint32 window_begin = checkpoint_id * CHECKPOINTS;
+        const uint32 window_end   = nvbio::min( window_begin + CHECKPOINTS, uint32(pattern.length()) );
+        return window_end - window_begin;
+    }
+};
+
+///
+/// Given the Dynamic Programming submatrix between two checkpoints,
+/// backtrace from a given destination cell, using edit distance.
+/// The function returns the resulting source cell.
+///
+/// \tparam CHECKPOINTS         number of DP rows between each checkpoint
+///
+/// \tparam checkpoint_type     a class to represent the collection of checkpoints,
+///                             represented as a linear array storing each checkpointed
+///                             band contiguously.
+///                             The class has to provide the const indexing operator[].
+///
+/// \tparam submatrix_type      a class to store the flow submatrix, represented
+///                             as a linear array of size (BAND_LEN*CHECKPOINTS).
+///                             The class has to provide the const indexing operator[].
+///                             Note that the submatrix entries can assume only 3 values,
+///                             and could hence be packed in 2 bits.
+///
+/// \tparam output_type         a class to store the resulting list of backtracking operations.
+///                             Needs to provide a single method:
+///                                 void push(uint8 op)
+///
+/// \param checkpoints          precalculated checkpoints
+/// \param checkpoint_id        index of the first checkpoint defining the DP submatrix,
+///                             storing all bands between checkpoint_id and checkpoint_id+1.
+/// \param submatrix            precalculated flow submatrix
+/// \param submatrix_height     submatrix width
+/// \param submatrix_height     submatrix height
+/// \param sink                 in/out sink of the DP solution
+/// \param output               backtracking output handler
+///
+/// \return                     true if the alignment source has been found, false otherwise
+///
+template <
+    uint32          CHECKPOINTS,
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        checkpoint_type,
+    typename        submatrix_type,
+    typename        backtracer_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+bool alignment_traceback(
+    const EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >    aligner,
+    checkpoint_type                                             checkpoints,
+    const uint32                                                checkpoint_id,
+    submatrix_type                                              submatrix,
+    const uint32                                                submatrix_width,
+    const uint32                                                submatrix_height,
+          uint8&                                                state,
+          uint2&                                                sink,
+    backtracer_type&                                            backtracer)
+{
+    return alignment_traceback<CHECKPOINTS>(
+        make_smith_waterman_aligner<TYPE>( EditDistanceSWScheme() ),
+        checkpoints,
+        checkpoint_id,
+        submatrix,
+        submatrix_width,
+        submatrix_height,
+        state,
+        sink,
+        backtracer );
+}
+
+/// @} // end of private group
+
+} // namespace priv
+
+} // namespace aln
+} // namespace nvbio
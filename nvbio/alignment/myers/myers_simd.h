@@ -0,0 +1,382 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/alignment/alignment.h>
+#include <nvbio/alignment/sink.h>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace nvbio {
+namespace aln {
+
+///@addtogroup Alignment
+///@{
+
+///
+/// Calculate the edit distance of a batch of pattern/text pairs on the host, using the
+/// Myers/Hyyro bit-vector algorithm with 64-bit blocks.
+/// When compiled with AVX2 support (see the HOST_AVX2 CMake option), four pairs are processed
+/// at once, each in its own 64-bit lane, with patterns of arbitrary length split in as many
+/// blocks as needed;
+/// otherwise each pair is scored independently through \ref alignment_score.
+/// Work is spread across all available OpenMP threads.
+///
+/// \tparam TYPE                the alignment type, GLOBAL or SEMI_GLOBAL
+/// \tparam ALPHABET_SIZE       the alphabet size; pattern and text symbols outside it never match
+/// \tparam pattern_set_type    a \ref StringSetAnchor "String Set" containing the patterns
+/// \tparam text_set_type       a \ref StringSetAnchor "String Set" containing the texts
+///
+/// \param aligner              the aligner
+/// \param patterns             the patterns
+/// \param texts                the texts, one per pattern
+/// \param min_score            the minimum accepted score
+/// \param sinks                the output sinks, one per pattern
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_set_type,
+    typename        text_set_type>
+void batch_myers_score(
+    const EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >    aligner,
+    const pattern_set_type                                      patterns,
+    const text_set_type                                         texts,
+    const int32                                                 min_score,
+    BestSink<int32>*                                            sinks);
+
+///@} // end of Alignment group
+
+namespace priv {
+
+///@addtogroup private
+///@{
+
+#if defined(__AVX2__)
+
+///
+/// Advance four independent 64-bit Myers/Hyyro blocks by one text column, one per AVX2 lane;
+/// the horizontal deltas entering and leaving the blocks are represented as pairs of
+/// positive/negative 0/1 values, and the output deltas are taken at the given bit of each lane.
+///
+inline
+void myers_advance_avx2(
+          __m256i   Eq,
+          __m256i&  Pv,
+          __m256i&  Mv,
+    const __m256i   hinP,
+    const __m256i   hinM,
+    const __m256i   out_bit,
+          __m256i&  houtP,
+          __m256i&  houtM)
+{
+    const __m256i ones = _mm256_set1_epi64x( -1 );
+    const __m256i one  = _mm256_set1_epi64x( 1 );
+
+    const __m256i Xv = _mm256_or_si256( Eq, Mv );
+    Eq = _mm256_or_si256( Eq, hinM );
+
+    const __m256i Xh = _mm256_or_si256(
+        _mm256_xor_si256( _mm256_add_epi64( _mm256_and_si256( Eq, Pv ), Pv ), Pv ),
+        Eq );
+
+    __m256i Ph = _mm256_or_si256( Mv, _mm256_xor_si256( _mm256_or_si256( Xh, Pv ), ones ) );
+    __m256i Mh = _mm256_and_si256( Pv, Xh );
+
+    houtP = _mm256_and_si256( _mm256_srlv_epi64( Ph, out_bit ), one );
+    houtM = _mm256_and_si256( _mm256_srlv_epi64( Mh, out_bit ), one );
+
+    Ph = _mm256_or_si256( _mm256_slli_epi64( Ph, 1 ), hinP );
+    Mh = _mm256_or_si256( _mm256_slli_epi64( Mh, 1 ), hinM );
+
+    Pv = _mm256_or_si256( Mh, _mm256_xor_si256( _mm256_or_si256( Xv, Ph ), ones ) );
+    Mv = _mm256_and_si256( Ph, Xv );
+}
+
+///
+/// Score up to four pattern/text pairs with the Myers/Hyyro algorithm, assigning each pair
+/// to a 64-bit AVX2 lane; patterns are split in 64-bit blocks, and all lanes advance as many
+/// blocks as needed by the longest pattern.
+///
+/// \param count        the number of pairs, at most 4
+/// \param storage      temporary storage, resized as needed
+///
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_string,
+    typename        text_string>
+void myers_score_avx2(
+    const uint32            count,
+    const pattern_string*   patterns,
+    const text_string*      texts,
+    const int32             min_score,
+    BestSink<int32>*        sinks,
+    std::vector<uint64>&    storage)
+{
+    const uint32 LANES = 4u;
+
+    int64  M[LANES];
+    int64  N[LANES];
+    int64  last_word[LANES];
+    int64  last_bit[LANES];
+    uint32 W = 0u;
+    uint32 max_N = 0u;
+
+    for (uint32 l = 0; l < LANES; ++l)
+    {
+        const uint32 m = l < count ? uint32( patterns[l].length() ) : 0u;
+        const uint32 n = l < count ? uint32( texts[l].length() )    : 0u;
+
+        M[l]         = m;
+        N[l]         = n;
+        last_word[l] = m ? int64( (m - 1u) / 64u ) : int64(-1);
+        last_bit[l]  = m ? int64( (m - 1u) & 63u ) : int64(0);
+
+        W     = nvbio::max( W, (m + 63u) / 64u );
+        max_N = nvbio::max( max_N, n );
+    }
+    if (W == 0u)
+        return;
+
+    // lay out the interleaved equality masks, with an extra all-zero symbol for the
+    // symbols outside the alphabet, followed by the vertical deltas
+    storage.resize( ((ALPHABET_SIZE+1u)*W + 2u*W) * LANES );
+
+    uint64* peq = &storage[0];
+    uint64* Pv  = peq + (ALPHABET_SIZE+1u)*W*LANES;
+    uint64* Mv  = Pv  + W*LANES;
+
+    for (uint32 i = 0; i < (ALPHABET_SIZE+1u)*W*LANES; ++i)
+        peq[i] = 0u;
+
+    for (uint32 l = 0; l < count; ++l)
+    {
+        for (uint32 i = 0; i < uint32( M[l] ); ++i)
+        {
+            const uint32 c = uint32( patterns[l][i] );
+            if (c < ALPHABET_SIZE)
+                peq[ (c*W + i/64u)*LANES + l ] |= uint64(1u) << (i & 63u);
+        }
+    }
+    for (uint32 i = 0; i < W*LANES; ++i)
+    {
+        Pv[i] = ~uint64(0u);
+        Mv[i] =  uint64(0u);
+    }
+
+    const __m256i one        = _mm256_set1_epi64x( 1 );
+    const __m256i bit63      = _mm256_set1_epi64x( 63 );
+    const __m256i N_v        = _mm256_loadu_si256( (const __m256i*)N );
+    const __m256i last_word_v= _mm256_loadu_si256( (const __m256i*)last_word );
+    const __m256i last_bit_v = _mm256_loadu_si256( (const __m256i*)last_bit );
+    const __m256i hin_top    = TYPE == GLOBAL ? one : _mm256_setzero_si256();
+
+    // the current distance, and the best distance found so far (initialized to the threshold)
+    __m256i dist      = _mm256_loadu_si256( (const __m256i*)M );
+    __m256i best_dist = _mm256_set1_epi64x( -min_score );
+    __m256i best_pos  = _mm256_setzero_si256();
+
+    // the register copy of the vertical deltas of single-block patterns
+    __m256i Pv_0 = _mm256_set1_epi64x( -1 );
+    __m256i Mv_0 = _mm256_setzero_si256();
+
+    for (uint32 t = 0; t < max_N; ++t)
+    {
+        // fetch the text symbols of all lanes, mapping exhausted lanes to the all-zero symbol
+        int64 sym[LANES];
+        for (uint32 l = 0; l < LANES; ++l)
+        {
+            const uint32 c = int64(t) < N[l] ? uint32( texts[l][t] ) : ALPHABET_SIZE;
+            sym[l] = int64( nvbio::min( c, ALPHABET_SIZE ) ) * W;
+        }
+        __m256i hinP = hin_top;
+        __m256i hinM = _mm256_setzero_si256();
+        __m256i houtP, houtM;
+
+        if (W == 1u)
+        {
+            // keep the whole column in registers
+            const __m256i Eq = _mm256_set_epi64x(
+                int64( peq[ sym[3]*LANES + 3 ] ),
+                int64( peq[ sym[2]*LANES + 2 ] ),
+                int64( peq[ sym[1]*LANES + 1 ] ),
+                int64( peq[ sym[0]*LANES + 0 ] ) );
+
+            myers_advance_avx2( Eq, Pv_0, Mv_0, hinP, hinM, last_bit_v, houtP, houtM );
+
+            dist = _mm256_add_epi64( dist, _mm256_sub_epi64( houtP, houtM ) );
+        }
+        else
+        {
+            for (uint32 w = 0; w < W; ++w)
+            {
+                __m256i Pv_w = _mm256_loadu_si256( (const __m256i*)(Pv + w*LANES) );
+                __m256i Mv_w = _mm256_loadu_si256( (const __m256i*)(Mv + w*LANES) );
+
+                // extract the output deltas from the last pattern row for lanes ending in this block
+                const __m256i is_last = _mm256_cmpeq_epi64( last_word_v, _mm256_set1_epi64x( w ) );
+
+                const uint64* peq_w = peq + w*LANES;
+                const __m256i Eq = _mm256_set_epi64x(
+                    int64( peq_w[ sym[3]*LANES + 3 ] ),
+                    int64( peq_w[ sym[2]*LANES + 2 ] ),
+                    int64( peq_w[ sym[1]*LANES + 1 ] ),
+                    int64( peq_w[ sym[0]*LANES + 0 ] ) );
+
+                myers_advance_avx2(
+                    Eq,
+                    Pv_w, Mv_w,
+                    hinP, hinM,
+                    _mm256_blendv_epi8( bit63, last_bit_v, is_last ),
+                    houtP, houtM );
+
+                dist = _mm256_add_epi64( dist,
+                    _mm256_and_si256( _mm256_sub_epi64( houtP, houtM ), is_last ) );
+
+                _mm256_storeu_si256( (__m256i*)(Pv + w*LANES), Pv_w );
+                _mm256_storeu_si256( (__m256i*)(Mv + w*LANES), Mv_w );
+
+                hinP = houtP;
+                hinM = houtM;
+            }
+        }
+
+        // track the best end-point of each lane still consuming its text
+        const __m256i active = _mm256_cmpgt_epi64( N_v, _mm256_set1_epi64x( t ) );
+        const __m256i better = TYPE == SEMI_GLOBAL ?
+            _mm256_andnot_si256( _mm256_cmpgt_epi64( dist, best_dist ), active ) :
+            _mm256_and_si256( _mm256_cmpeq_epi64( N_v, _mm256_set1_epi64x( t+1 ) ), active );
+
+        best_dist = _mm256_blendv_epi8( best_dist, dist, better );
+        best_pos  = _mm256_blendv_epi8( best_pos, _mm256_set1_epi64x( t+1 ), better );
+    }
+
+    int64 best_dist_l[LANES];
+    int64 best_pos_l[LANES];
+    _mm256_storeu_si256( (__m256i*)best_dist_l, best_dist );
+    _mm256_storeu_si256( (__m256i*)best_pos_l,  best_pos );
+
+    for (uint32 l = 0; l < count; ++l)
+    {
+        if (M[l] == 0)
+            continue;
+
+        // with global alignment, an empty text leaves the whole pattern unaligned
+        const int32 score = TYPE == GLOBAL && N[l] == 0 ? -int32( M[l] ) : -int32( best_dist_l[l] );
+
+        if (TYPE == GLOBAL ? score >= min_score : best_pos_l[l] != 0)
+            sinks[l].report( score, make_uint2( uint32( TYPE == GLOBAL ? N[l] : best_pos_l[l] ), uint32( M[l] ) ) );
+    }
+}
+
+#endif // __AVX2__
+
+/// @} // end of private group
+
+} // namespace priv
+
+//
+// Calculate the edit distance of a batch of pattern/text pairs on the host, using the
+// Myers/Hyyro bit-vector algorithm with 64-bit blocks.
+//
+template <
+    AlignmentType   TYPE,
+    uint32          ALPHABET_SIZE,
+    typename        pattern_set_type,
+    typename        text_set_type>
+void batch_myers_score(
+    const EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> >    aligner,
+    const pattern_set_type                                      patterns,
+    const text_set_type                                         texts,
+    const int32                                                 min_score,
+    BestSink<int32>*                                            sinks)
+{
+    typedef typename pattern_set_type::string_type  pattern_string;
+    typedef typename text_set_type::string_type     text_string;
+
+    const uint32 n_pairs = uint32( patterns.size() );
+
+  #if defined(__AVX2__)
+    const uint32 n_groups = (n_pairs + 3u) / 4u;
+
+    #pragma omp parallel
+    {
+        std::vector<uint64> storage;
+
+        #pragma omp for schedule(dynamic,64)
+        for (int32 g = 0; g < int32( n_groups ); ++g)
+        {
+            const uint32 begin = uint32(g) * 4u;
+            const uint32 count = nvbio::min( begin + 4u, n_pairs ) - begin;
+
+            pattern_string p[4];
+            text_string    t[4];
+            for (uint32 l = 0; l < count; ++l)
+            {
+                p[l] = patterns[ begin + l ];
+                t[l] = texts[ begin + l ];
+            }
+
+            priv::myers_score_avx2<TYPE,ALPHABET_SIZE>( count, p, t, min_score, sinks + begin, storage );
+        }
+    }
+  #else
+    #pragma omp parallel
+    {
+        std::vector<uint64> column;
+
+        #pragma omp for schedule(dynamic,64)
+        for (int32 i = 0; i < int32( n_pairs ); ++i)
+        {
+            const pattern_string pattern = patterns[i];
+            const text_string    text    = texts[i];
+
+            column.resize( (ALPHABET_SIZE+3u) * ((pattern.length() + 63u) / 64u) + 1u );
+
+            alignment_score(
+                aligner,
+                pattern,
+                trivial_quality_string(),
+                text,
+                min_score,
+                sinks[i],
+                &column[0] );
+        }
+    }
+  #endif
+}
+
+} // namespace aln
+} // namespace nvbio
@@ -0,0 +1,230 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/strings/alphabet.h>
+#include <nvbio/alignment/alignment_base.h>
+#include <nvbio/alignment/utils.h>
+#include <vector>
+
+namespace nvbio {
+namespace aln {
+
+///@addtogroup Alignment
+///@{
+
+///
+///@addtogroup SubstitutionMatrices Substitution Matrices
+/// Protein alignment scoring through substitution matrices over the 24-letter \ref PROTEIN alphabet.
+/// A \ref SubstitutionMatrix can be one of the built-in BLOSUM and PAM tables, or loaded from a file
+/// in the NCBI text format; it can be used directly with the GotohAligner through a
+/// \ref MatrixGotohScheme, on both the host and the device, or expanded into a per-pattern
+/// \ref QueryProfile for the host local aligners, which look up a whole row of scores
+/// for each text symbol rather than a matrix cell per pattern/text symbol pair.
+///@{
+///
+
+///
+/// A protein substitution matrix, holding the scores of each pattern symbol q against each
+/// text symbol r in row-major order, i.e. at q * SYMBOLS + r.
+/// The pyrrolysine symbol O takes the scores of the stop column '*' of the NCBI tables.
+///
+struct SubstitutionMatrix
+{
+    static const uint32 SYMBOLS = AlphabetTraits<PROTEIN>::SYMBOL_COUNT;
+
+    /// the built-in matrices
+    ///
+    enum Builtin
+    {
+        BLOSUM45 = 0,
+        BLOSUM50 = 1,
+        BLOSUM62 = 2,
+        BLOSUM80 = 3,
+        BLOSUM90 = 4,
+        PAM30    = 5,
+        PAM70    = 6,
+        PAM250   = 7,
+    };
+
+    /// constructor
+    ///
+    SubstitutionMatrix(const Builtin matrix = BLOSUM62) { set( matrix ); }
+
+    /// select a built-in matrix
+    ///
+    void set(const Builtin matrix);
+
+    /// select a built-in matrix by name (e.g. "BLOSUM62", case insensitive), or load
+    /// the given file if the name doesn't match any of them
+    ///
+    /// \return     true on success
+    ///
+    bool set(const char* name);
+
+    /// load a matrix in the NCBI text format, i.e. a header listing the column symbols
+    /// followed by one row per symbol; comment lines start with '#'.
+    /// Symbols missing from the file score as the smallest entry of the matrix.
+    ///
+    /// \return     true on success
+    ///
+    bool load(const char* filename);
+
+    /// return the score of the pattern symbol q against the text symbol r
+    ///
+    int32 operator() (const uint8 q, const uint8 r) const { return m_scores[ q * SYMBOLS + r ]; }
+
+    /// return the matrix entries
+    ///
+    const int8* data() const { return m_scores; }
+
+    /// return the matrix name
+    ///
+    const char* name() const { return m_name; }
+
+    /// return the largest entry
+    ///
+    int32 max_score() const { return m_max_score; }
+
+    /// return the smallest entry
+    ///
+    int32 min_score() const { return m_min_score; }
+
+    /// return a host \ref GotohScoringScheme scoring substitutions with this matrix
+    ///
+    MatrixGotohScheme<const int8*> gotoh_scheme(const int32 gap_open, const int32 gap_ext) const
+    {
+        return MatrixGotohScheme<const int8*>( m_scores, m_max_score, gap_open, gap_ext );
+    }
+
+    int8    m_scores[SYMBOLS*SYMBOLS];
+    int32   m_max_score;
+    int32   m_min_score;
+    char    m_name[64];
+};
+
+///
+/// A query profile, i.e. a substitution matrix expanded along a pattern so that for each text
+/// symbol r the scores against all pattern positions are contiguous in memory.
+/// The profile is kept in two layouts: a linear one, used by the scalar aligner, and
+/// the striped one of Farrar's algorithm, with the pattern split in LANES segments
+/// processed in parallel by the SIMD aligner.
+///
+struct QueryProfile
+{
+    static const uint32 LANES = 8;  ///< 16-bit lanes in a 128-bit vector
+
+    /// empty constructor
+    ///
+    QueryProfile() : m_length( 0u ), m_segments( 0u ), m_max_score( 0 ) {}
+
+    /// build the profile of a given pattern
+    ///
+    template <typename pattern_string>
+    QueryProfile(const SubstitutionMatrix& matrix, const pattern_string pattern) { build( matrix, pattern ); }
+
+    /// build the profile of a given pattern
+    ///
+    /// \param matrix       the substitution matrix
+    /// \param pattern      the pattern, a string of \ref PROTEIN symbols
+    ///
+    template <typename pattern_string>
+    void build(const SubstitutionMatrix& matrix, const pattern_string pattern);
+
+    /// return the pattern length
+    ///
+    uint32 length() const { return m_length; }
+
+    /// return the scores of all pattern positions against a given text symbol
+    ///
+    const int8* row(const uint8 r) const { return &m_profile[ r * m_length ]; }
+
+    /// return the striped scores of all pattern positions against a given text symbol:
+    /// the score of position j = l * segments + s is found at entry s * LANES + l
+    ///
+    const int16* striped_row(const uint8 r) const { return &m_striped[ r * m_segments * LANES ]; }
+
+    uint32              m_length;
+    uint32              m_segments;
+    int32               m_max_score;
+    std::vector<int8>   m_profile;
+    std::vector<int16>  m_striped;
+};
+
+///
+/// Compute the best local Gotoh alignment score of a profiled pattern against a text on the host,
+/// using the SSE2 striped algorithm where available and the scalar one otherwise; the SIMD
+/// path computes in 16 bits and falls back to the scalar one whenever the score gets too
+/// close to saturation, or when gap_open > gap_ext (i.e. opening a gap costs less than extending it).
+/// As for the GotohScoringScheme, a gap of length L costs gap_open + (L-1) * gap_ext.
+///
+/// \param profile      the pattern's query profile
+/// \param text         the text, a string of \ref PROTEIN symbols
+/// \param gap_open     the (negative) gap open score
+/// \param gap_ext      the (negative) gap extension score
+/// \param sink         if not NULL, the (text,pattern) end of a cell achieving the best score
+///
+/// \return             the best score
+///
+template <typename text_string>
+int32 query_profile_score(
+    const QueryProfile& profile,
+    const text_string   text,
+    const int32         gap_open,
+    const int32         gap_ext,
+    uint2*              sink = NULL);
+
+///
+/// Compute the best local Gotoh alignment score of a profiled pattern against a text on the host,
+/// using the scalar algorithm; among equal scores the sink is the first cell in text-major order.
+///
+/// \param profile      the pattern's query profile
+/// \param text         the text, a string of \ref PROTEIN symbols
+/// \param gap_open     the (negative) gap open score
+/// \param gap_ext      the (negative) gap extension score
+/// \param sink         if not NULL, the (text,pattern) end of the best scoring cell
+///
+/// \return             the best score
+///
+template <typename text_string>
+int32 query_profile_score_scalar(
+    const QueryProfile& profile,
+    const text_string   text,
+    const int32         gap_open,
+    const int32         gap_ext,
+    uint2*              sink = NULL);
+
+///@} // end of the SubstitutionMatrices group
+///@} // end of the Alignment group
+
+} // namespace aln
+} // namespace nvbio
+
+#include <nvbio/alignment/substitution_matrix_inl.h>
@@ -0,0 +1,691 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/basic/console.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace nvbio {
+namespace aln {
+
+namespace priv {
+
+///@addtogroup private
+///@{
+
+//
+// The built-in substitution matrices, in the symbol order of the PROTEIN alphabet
+// (A,C,D,E,F,G,H,I,K,L,M,N,O,P,Q,R,S,T,V,W,Y,B,Z,X), with O mapped to the NCBI stop column.
+//
+inline const int8* builtin_substitution_matrix(const SubstitutionMatrix::Builtin matrix, const char** name)
+{
+    static const int8 s_blosum45[24*24] =
+    {
+      5, -1, -2, -1, -2,  0, -2, -1, -1, -1, -1, -1, -5, -1, -1, -2,  1,  0,  0, -2, -2, -1, -1,  0,
+     -1, 12, -3, -3, -2, -3, -3, -3, -3, -2, -2, -2, -5, -4, -3, -3, -1, -1, -1, -5, -3, -2, -3, -2,
+     -2, -3,  7,  2, -4, -1,  0, -4,  0, -3, -3,  2, -5, -1,  0, -1,  0, -1, -3, -4, -2,  5,  1, -1,
+     -1, -3,  2,  6, -3, -2,  0, -3,  1, -2, -2,  0, -5,  0,  2,  0,  0, -1, -3, -3, -2,  1,  4, -1,
+     -2, -2, -4, -3,  8, -3, -2,  0, -3,  1,  0, -2, -5, -3, -4, -2, -2, -1,  0,  1,  3, -3, -3, -1,
+      0, -3, -1, -2, -3,  7, -2, -4, -2, -3, -2,  0, -5, -2, -2, -2,  0, -2, -3, -2, -3, -1, -2, -1,
+     -2, -3,  0,  0, -2, -2, 10, -3, -1, -2,  0,  1, -5, -2,  1,  0, -1, -2, -3, -3,  2,  0,  0, -1,
+     -1, -3, -4, -3,  0, -4, -3,  5, -3,  2,  2, -2, -5, -2, -2, -3, -2, -1,  3, -2,  0, -3, -3, -1,
+     -1, -3,  0,  1, -3, -2, -1, -3,  5, -3, -1,  0, -5, -1,  1,  3, -1, -1, -2, -2, -1,  0,  1, -1,
+     -1, -2, -3, -2,  1, -3, -2,  2, -3,  5,  2, -3, -5, -3, -2, -2, -3, -1,  1, -2,  0, -3, -2, -1,
+     -1, -2, -3, -2,  0, -2,  0,  2, -1,  2,  6, -2, -5, -2,  0, -1, -2, -1,  1, -2,  0, -2, -1, -1,
+     -1, -2,  2,  0, -2,  0,  1, -2,  0, -3, -2,  6, -5, -2,  0,  0,  1,  0, -3, -4, -2,  4,  0, -1,
+     -5, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5,  1, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5,
+     -1, -4, -1,  0, -3, -2, -2, -2, -1, -3, -2, -2, -5,  9, -1, -2, -1, -1, -3, -3, -3, -2, -1, -1,
+     -1, -3,  0,  2, -4, -2,  1, -2,  1, -2,  0,  0, -5, -1,  6,  1,  0, -1, -3, -2, -1,  0,  4, -1,
+     -2, -3, -1,  0, -2, -2,  0, -3,  3, -2, -1,  0, -5, -2,  1,  7, -1, -1, -2, -2, -1, -1,  0, -1,
+      1, -1,  0,  0, -2,  0, -1, -2, -1, -3, -2,  1, -5, -1,  0, -1,  4,  2, -1, -4, -2,  0,  0,  0,
+      0, -1, -1, -1, -1, -2, -2, -1, -1, -1, -1,  0, -5, -1, -1, -1,  2,  5,  0, -3, -1,  0, -1,  0,
+      0, -1, -3, -3,  0, -3, -3,  3, -2,  1,  1, -3, -5, -3, -3, -2, -1,  0,  5, -3, -1, -3, -3, -1,
+     -2, -5, -4, -3,  1, -2, -3, -2, -2, -2, -2, -4, -5, -3, -2, -2, -4, -3, -3, 15,  3, -4, -2, -2,
+     -2, -3, -2, -2,  3, -3,  2,  0, -1,  0,  0, -2, -5, -3, -1, -1, -2, -1, -1,  3,  8, -2, -2, -1,
+     -1, -2,  5,  1, -3, -1,  0, -3,  0, -3, -2,  4, -5, -2,  0, -1,  0,  0, -3, -4, -2,  4,  2, -1,
+     -1, -3,  1,  4, -3, -2,  0, -3,  1, -2, -1,  0, -5, -1,  4,  0,  0, -1, -3, -2, -2,  2,  4, -1,
+      0, -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -5, -1, -1, -1,  0,  0, -1, -2, -1, -1, -1, -1,
+    };
+
+    static const int8 s_blosum50[24*24] =
+    {
+      5, -1, -2, -1, -3,  0, -2, -1, -1, -2, -1, -1, -5, -1, -1, -2,  1,  0,  0, -3, -2, -2, -1, -1,
+     -1, 13, -4, -3, -2, -3, -3, -2, -3, -2, -2, -2, -5, -4, -3, -4, -1, -1, -1, -5, -3, -3, -3, -2,
+     -2, -4,  8,  2, -5, -1, -1, -4, -1, -4, -4,  2, -5, -1,  0, -2,  0, -1, -4, -5, -3,  5,  1, -1,
+     -1, -3,  2,  6, -3, -3,  0, -4,  1, -3, -2,  0, -5, -1,  2,  0, -1, -1, -3, -3, -2,  1,  5, -1,
+     -3, -2, -5, -3,  8, -4, -1,  0, -4,  1,  0, -4, -5, -4, -4, -3, -3, -2, -1,  1,  4, -4, -4, -2,
+      0, -3, -1, -3, -4,  8, -2, -4, -2, -4, -3,  0, -5, -2, -2, -3,  0, -2, -4, -3, -3, -1, -2, -2,
+     -2, -3, -1,  0, -1, -2, 10, -4,  0, -3, -1,  1, -5, -2,  1,  0, -1, -2, -4, -3,  2,  0,  0, -1,
+     -1, -2, -4, -4,  0, -4, -4,  5, -3,  2,  2, -3, -5, -3, -3, -4, -3, -1,  4, -3, -1, -4, -3, -1,
+     -1, -3, -1,  1, -4, -2,  0, -3,  6, -3, -2,  0, -5, -1,  2,  3,  0, -1, -3, -3, -2,  0,  1, -1,
+     -2, -2, -4, -3,  1, -4, -3,  2, -3,  5,  3, -4, -5, -4, -2, -3, -3, -1,  1, -2, -1, -4, -3, -1,
+     -1, -2, -4, -2,  0, -3, -1,  2, -2,  3,  7, -2, -5, -3,  0, -2, -2, -1,  1, -1,  0, -3, -1, -1,
+     -1, -2,  2,  0, -4,  0,  1, -3,  0, -4, -2,  7, -5, -2,  0, -1,  1,  0, -3, -4, -2,  4,  0, -1,
+     -5, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5,  1, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5, -5,
+     -1, -4, -1, -1, -4, -2, -2, -3, -1, -4, -3, -2, -5, 10, -1, -3, -1, -1, -3, -4, -3, -2, -1, -2,
+     -1, -3,  0,  2, -4, -2,  1, -3,  2, -2,  0,  0, -5, -1,  7,  1,  0, -1, -3, -1, -1,  0,  4, -1,
+     -2, -4, -2,  0, -3, -3,  0, -4,  3, -3, -2, -1, -5, -3,  1,  7, -1, -1, -3, -3, -1, -1,  0, -1,
+      1, -1,  0, -1, -3,  0, -1, -3,  0, -3, -2,  1, -5, -1,  0, -1,  5,  2, -2, -4, -2,  0,  0, -1,
+      0, -1, -1, -1, -2, -2, -2, -1, -1, -1, -1,  0, -5, -1, -1, -1,  2,  5,  0, -3, -2,  0, -1,  0,
+      0, -1, -4, -3, -1, -4, -4,  4, -3,  1,  1, -3, -5, -3, -3, -3, -2,  0,  5, -3, -1, -4, -3, -1,
+     -3, -5, -5, -3,  1, -3, -3, -3, -3, -2, -1, -4, -5, -4, -1, -3, -4, -3, -3, 15,  2, -5, -2, -3,
+     -2, -3, -3, -2,  4, -3,  2, -1, -2, -1,  0, -2, -5, -3, -1, -1, -2, -2, -1,  2,  8, -3, -2, -1,
+     -2, -3,  5,  1, -4, -1,  0, -4,  0, -4, -3,  4, -5, -2,  0, -1,  0,  0, -4, -5, -3,  5,  2, -1,
+     -1, -3,  1,  5, -4, -2,  0, -3,  1, -3, -1,  0, -5, -1,  4,  0,  0, -1, -3, -2, -2,  2,  5, -1,
+     -1, -2, -1, -1, -2, -2, -1, -1, -1, -1, -1, -1, -5, -2, -1, -1, -1,  0, -1, -3, -1, -1, -1, -1,
+    };
+
+    static const int8 s_blosum62[24*24] =
+    {
+      4,  0, -2, -1, -2,  0, -2, -1, -1, -1, -1, -2, -4, -1, -1, -1,  1,  0,  0, -3, -2, -2, -1,  0,
+      0,  9, -3, -4, -2, -3, -3, -1, -3, -1, -1, -3, -4, -3, -3, -3, -1, -1, -1, -2, -2, -3, -3, -2,
+     -2, -3,  6,  2, -3, -1, -1, -3, -1, -4, -3,  1, -4, -1,  0, -2,  0, -1, -3, -4, -3,  4,  1, -1,
+     -1, -4,  2,  5, -3, -2,  0, -3,  1, -3, -2,  0, -4, -1,  2,  0,  0, -1, -2, -3, -2,  1,  4, -1,
+     -2, -2, -3, -3,  6, -3, -1,  0, -3,  0,  0, -3, -4, -4, -3, -3, -2, -2, -1,  1,  3, -3, -3, -1,
+      0, -3, -1, -2, -3,  6, -2, -4, -2, -4, -3,  0, -4, -2, -2, -2,  0, -2, -3, -2, -3, -1, -2, -1,
+     -2, -3, -1,  0, -1, -2,  8, -3, -1, -3, -2,  1, -4, -2,  0,  0, -1, -2, -3, -2,  2,  0,  0, -1,
+     -1, -1, -3, -3,  0, -4, -3,  4, -3,  2,  1, -3, -4, -3, -3, -3, -2, -1,  3, -3, -1, -3, -3, -1,
+     -1, -3, -1,  1, -3, -2, -1, -3,  5, -2, -1,  0, -4, -1,  1,  2,  0, -1, -2, -3, -2,  0,  1, -1,
+     -1, -1, -4, -3,  0, -4, -3,  2, -2,  4,  2, -3, -4, -3, -2, -2, -2, -1,  1, -2, -1, -4, -3, -1,
+     -1, -1, -3, -2,  0, -3, -2,  1, -1,  2,  5, -2, -4, -2,  0, -1, -1, -1,  1, -1, -1, -3, -1, -1,
+     -2, -3,  1,  0, -3,  0,  1, -3,  0, -3, -2,  6, -4, -2,  0,  0,  1,  0, -3, -4, -2,  3,  0, -1,
+     -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,  1, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4,
+     -1, -3, -1, -1, -4, -2, -2, -3, -1, -3, -2, -2, -4,  7, -1, -2, -1, -1, -2, -4, -3, -2, -1, -2,
+     -1, -3,  0,  2, -3, -2,  0, -3,  1, -2,  0,  0, -4, -1,  5,  1,  0, -1, -2, -2, -1,  0,  3, -1,
+     -1, -3, -2,  0, -3, -2,  0, -3,  2, -2, -1,  0, -4, -2,  1,  5, -1, -1, -3, -3, -2, -1,  0, -1,
+      1, -1,  0,  0, -2,  0, -1, -2,  0, -2, -1,  1, -4, -1,  0, -1,  4,  1, -2, -3, -2,  0,  0,  0,
+      0, -1, -1, -1, -2, -2, -2, -1, -1, -1, -1,  0, -4, -1, -1, -1,  1,  5,  0, -2, -2, -1, -1,  0,
+      0, -1, -3, -2, -1, -3, -3,  3, -2,  1,  1, -3, -4, -2, -2, -3, -2,  0,  4, -3, -1, -3, -2, -1,
+     -3, -2, -4, -3,  1, -2, -2, -3, -3, -2, -1, -4, -4, -4, -2, -3, -3, -2, -3, 11,  2, -4, -3, -2,
+     -2, -2, -3, -2,  3, -3,  2, -1, -2, -1, -1, -2, -4, -3, -1, -2, -2, -2, -1,  2,  7, -3, -2, -1,
+     -2, -3,  4,  1, -3, -1,  0, -3,  0, -4, -3,  3, -4, -2,  0, -1,  0, -1, -3, -4, -3,  4,  1, -1,
+     -1, -3,  1,  4, -3, -2,  0, -3,  1, -3, -1,  0, -4, -1,  3,  0,  0, -1, -2, -3, -2,  1,  4, -1,
+      0, -2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -4, -2, -1, -1,  0,  0, -1, -2, -1, -1, -1, -1,
+    };
+
+    static const int8 s_blosum80[24*24] =
+    {
+      7, -1, -3, -2, -4,  0, -3, -3, -1, -3, -2, -3, -8, -1, -2, -3,  2,  0, -1, -5, -4, -3, -2, -1,
+     -1, 13, -7, -7, -4, -6, -7, -2, -6, -3, -3, -5, -8, -6, -5, -6, -2, -2, -2, -5, -5, -6, -7, -4,
+     -3, -7, 10,  2, -6, -3, -2, -7, -2, -7, -6,  2, -8, -3, -1, -3, -1, -2, -6, -8, -6,  6,  1, -3,
+     -2, -7,  2,  8, -6, -4,  0, -6,  1, -6, -4, -1, -8, -2,  3, -1, -1, -2, -4, -6, -5,  1,  6, -2,
+     -4, -4, -6, -6, 10, -6, -2, -1, -5,  0,  0, -6, -8, -6, -5, -5, -4, -4, -2,  0,  4, -6, -6, -3,
+      0, -6, -3, -4, -6,  9, -4, -7, -3, -7, -5, -1, -8, -5, -4, -4, -1, -3, -6, -6, -6, -2, -4, -3,
+     -3, -7, -2,  0, -2, -4, 12, -6, -1, -5, -4,  1, -8, -4,  1,  0, -2, -3, -5, -4,  3, -1,  0, -2,
+     -3, -2, -7, -6, -1, -7, -6,  7, -5,  2,  2, -6, -8, -5, -5, -5, -4, -2,  4, -5, -3, -6, -6, -2,
+     -1, -6, -2,  1, -5, -3, -1, -5,  8, -4, -3,  0, -8, -2,  2,  3, -1, -1, -4, -6, -4, -1,  1, -2,
+     -3, -3, -7, -6,  0, -7, -5,  2, -4,  6,  3, -6, -8, -5, -4, -4, -4, -3,  1, -4, -2, -7, -5, -2,
+     -2, -3, -6, -4,  0, -5, -4,  2, -3,  3,  9, -4, -8, -4, -1, -3, -3, -1,  1, -3, -3, -5, -3, -2,
+     -3, -5,  2, -1, -6, -1,  1, -6,  0, -6, -4,  9, -8, -4,  0, -1,  1,  0, -5, -7, -4,  5, -1, -2,
+     -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8,  1, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8,
+     -1, -6, -3, -2, -6, -5, -4, -5, -2, -5, -4, -4, -8, 12, -3, -3, -2, -3, -4, -7, -6, -4, -2, -3,
+     -2, -5, -1,  3, -5, -4,  1, -5,  2, -4, -1,  0, -8, -3,  9,  1, -1, -1, -4, -4, -3, -1,  5, -2,
+     -3, -6, -3, -1, -5, -4,  0, -5,  3, -4, -3, -1, -8, -3,  1,  9, -2, -2, -4, -5, -4, -2,  0, -2,
+      2, -2, -1, -1, -4, -1, -2, -4, -1, -4, -3,  1, -8, -2, -1, -2,  7,  2, -3, -6, -3,  0, -1, -1,
+      0, -2, -2, -2, -4, -3, -3, -2, -1, -3, -1,  0, -8, -3, -1, -2,  2,  8,  0, -5, -3, -1, -2, -1,
+     -1, -2, -6, -4, -2, -6, -5,  4, -4,  1,  1, -5, -8, -4, -4, -4, -3,  0,  7, -5, -3, -6, -4, -2,
+     -5, -5, -8, -6,  0, -6, -4, -5, -6, -4, -3, -7, -8, -7, -4, -5, -6, -5, -5, 16,  3, -8, -5, -5,
+     -4, -5, -6, -5,  4, -6,  3, -3, -4, -2, -3, -4, -8, -6, -3, -4, -3, -3, -3,  3, 11, -5, -4, -3,
+     -3, -6,  6,  1, -6, -2, -1, -6, -1, -7, -5,  5, -8, -4, -1, -2,  0, -1, -6, -8, -5,  6,  0, -3,
+     -2, -7,  1,  6, -6, -4,  0, -6,  1, -5, -3, -1, -8, -2,  5,  0, -1, -2, -4, -5, -4,  0,  6, -1,
+     -1, -4, -3, -2, -3, -3, -2, -2, -2, -2, -2, -2, -8, -3, -2, -2, -1, -1, -2, -5, -3, -3, -1, -2,
+    };
+
+    static const int8 s_blosum90[24*24] =
+    {
+      5, -1, -3, -1, -3,  0, -2, -2, -1, -2, -2, -2, -6, -1, -1, -2,  1,  0, -1, -4, -3, -2, -1, -1,
+     -1,  9, -5, -6, -3, -4, -5, -2, -4, -2, -2, -4, -6, -4, -4, -5, -2, -2, -2, -4, -4, -4, -5, -3,
+     -3, -5,  7,  1, -5, -2, -2, -5, -1, -5, -4,  1, -6, -3, -1, -3, -1, -2, -5, -6, -4,  4,  0, -2,
+     -1, -6,  1,  6, -5, -3, -1, -4,  0, -4, -3, -1, -6, -2,  2, -1, -1, -1, -3, -5, -4,  0,  4, -2,
+     -3, -3, -5, -5,  7, -5, -2, -1, -4,  0, -1, -4, -6, -4, -4, -4, -3, -3, -2,  0,  3, -4, -4, -2,
+      0, -4, -2, -3, -5,  6, -3, -5, -2, -5, -4, -1, -6, -3, -3, -3, -1, -3, -5, -4, -5, -2, -3, -2,
+     -2, -5, -2, -1, -2, -3,  8, -4, -1, -4, -3,  0, -6, -3,  1,  0, -2, -2, -4, -3,  1, -1,  0, -2,
+     -2, -2, -5, -4, -1, -5, -4,  5, -4,  1,  1, -4, -6, -4, -4, -4, -3, -1,  3, -4, -2, -5, -4, -2,
+     -1, -4, -1,  0, -4, -2, -1, -4,  6, -3, -2,  0, -6, -2,  1,  2, -1, -1, -3, -5, -3, -1,  1, -1,
+     -2, -2, -5, -4,  0, -5, -4,  1, -3,  5,  2, -4, -6, -4, -3, -3, -3, -2,  0, -3, -2, -5, -4, -2,
+     -2, -2, -4, -3, -1, -4, -3,  1, -2,  2,  7, -3, -6, -3,  0, -2, -2, -1,  0, -2, -2, -4, -2, -1,
+     -2, -4,  1, -1, -4, -1,  0, -4,  0, -4, -3,  7, -6, -3,  0, -1,  0,  0, -4, -5, -3,  4, -1, -2,
+     -6, -6, -6, -6, -6, -6, -6, -6, -6, -6, -6, -6,  1, -6, -6, -6, -6, -6, -6, -6, -6, -6, -6, -6,
+     -1, -4, -3, -2, -4, -3, -3, -4, -2, -4, -3, -3, -6,  8, -2, -3, -2, -2, -3, -5, -4, -3, -2, -2,
+     -1, -4, -1,  2, -4, -3,  1, -4,  1, -3,  0,  0, -6, -2,  7,  1, -1, -1, -3, -3, -3, -1,  4, -1,
+     -2, -5, -3, -1, -4, -3,  0, -4,  2, -3, -2, -1, -6, -3,  1,  6, -1, -2, -3, -4, -3, -2,  0, -2,
+      1, -2, -1, -1, -3, -1, -2, -3, -1, -3, -2,  0, -6, -2, -1, -1,  5,  1, -2, -4, -3,  0, -1, -1,
+      0, -2, -2, -1, -3, -3, -2, -1, -1, -2, -1,  0, -6, -2, -1, -2,  1,  6, -1, -4, -2, -1, -1, -1,
+     -1, -2, -5, -3, -2, -5, -4,  3, -3,  0,  0, -4, -6, -3, -3, -3, -2, -1,  5, -3, -3, -4, -3, -2,
+     -4, -4, -6, -5,  0, -4, -3, -4, -5, -3, -2, -5, -6, -5, -3, -4, -4, -4, -3, 11,  2, -6, -4, -3,
+     -3, -4, -4, -4,  3, -5,  1, -2, -3, -2, -2, -3, -6, -4, -3, -3, -3, -2, -3,  2,  8, -4, -3, -2,
+     -2, -4,  4,  0, -4, -2, -1, -5, -1, -5, -4,  4, -6, -3, -1, -2,  0, -1, -4, -6, -4,  4,  0, -2,
+     -1, -5,  0,  4, -4, -3,  0, -4,  1, -4, -2, -1, -6, -2,  4,  0, -1, -1, -3, -4, -3,  0,  4, -1,
+     -1, -3, -2, -2, -2, -2, -2, -2, -1, -2, -1, -2, -6, -2, -1, -2, -1, -1, -2, -3, -2, -2, -1, -2,
+    };
+
+    static const int8 s_pam30[24*24] =
+    {
+      6, -6, -3, -2, -8, -2, -7, -5, -7, -6, -5, -4,-17, -2, -4, -7,  0, -1, -2,-13, -8, -3, -3, -3,
+     -6, 10,-14,-14,-13, -9, -7, -6,-14,-15,-13,-11,-17, -8,-14, -8, -3, -8, -6,-15, -4,-12,-14, -9,
+     -3,-14,  8,  2,-15, -3, -4, -7, -4,-12,-11,  2,-17, -8, -2,-10, -4, -5, -8,-15,-11,  6,  1, -5,
+     -2,-14,  2,  8,-14, -4, -5, -5, -4, -9, -7, -2,-17, -5,  1, -9, -4, -6, -6,-17, -8,  1,  6, -5,
+     -8,-13,-15,-14,  9, -9, -6, -2,-14, -3, -4, -9,-17,-10,-13, -9, -6, -9, -8, -4,  2,-10,-13, -8,
+     -2, -9, -3, -4, -9,  6, -9,-11, -7,-10, -8, -3,-17, -6, -7, -9, -2, -6, -5,-15,-14, -3, -5, -5,
+     -7, -7, -4, -5, -6, -9,  9, -9, -6, -6,-10,  0,-17, -4,  1, -2, -6, -7, -6, -7, -3, -1, -1, -5,
+     -5, -6, -7, -5, -2,-11, -9,  8, -6, -1, -1, -5,-17, -8, -8, -5, -7, -2,  2,-14, -6, -6, -6, -5,
+     -7,-14, -4, -4,-14, -7, -6, -6,  7, -8, -2, -1,-17, -6, -3,  0, -4, -3, -9,-12, -9, -2, -4, -5,
+     -6,-15,-12, -9, -3,-10, -6, -1, -8,  7,  1, -7,-17, -7, -5, -8, -8, -7, -2, -6, -7, -9, -7, -6,
+     -5,-13,-11, -7, -4, -8,-10, -1, -2,  1, 11, -9,-17, -8, -4, -4, -5, -4, -1,-13,-11,-10, -5, -5,
+     -4,-11,  2, -2, -9, -3,  0, -5, -1, -7, -9,  8,-17, -6, -3, -6,  0, -2, -8, -8, -4,  6, -3, -3,
+    -17,-17,-17,-17,-17,-17,-17,-17,-17,-17,-17,-17,  1,-17,-17,-17,-17,-17,-17,-17,-17,-17,-17,-17,
+     -2, -8, -8, -5,-10, -6, -4, -8, -6, -7, -8, -6,-17,  8, -3, -4, -2, -4, -6,-14,-13, -7, -4, -5,
+     -4,-14, -2,  1,-13, -7,  1, -8, -3, -5, -4, -3,-17, -3,  8, -2, -5, -5, -7,-13,-12, -3,  6, -5,
+     -7, -8,-10, -9, -9, -9, -2, -5,  0, -8, -4, -6,-17, -4, -2,  8, -3, -6, -8, -2,-10, -7, -4, -6,
+      0, -3, -4, -4, -6, -2, -6, -7, -4, -8, -5,  0,-17, -2, -5, -3,  6,  0, -6, -5, -7, -1, -5, -3,
+     -1, -8, -5, -6, -9, -6, -7, -2, -3, -7, -4, -2,-17, -4, -5, -6,  0,  7, -3,-13, -6, -3, -6, -4,
+     -2, -6, -8, -6, -8, -5, -6,  2, -9, -2, -1, -8,-17, -6, -7, -8, -6, -3,  7,-15, -7, -8, -6, -5,
+    -13,-15,-15,-17, -4,-15, -7,-14,-12, -6,-13, -8,-17,-14,-13, -2, -5,-13,-15, 13, -5,-10,-14,-11,
+     -8, -4,-11, -8,  2,-14, -3, -6, -9, -7,-11, -4,-17,-13,-12,-10, -7, -6, -7, -5, 10, -6, -9, -7,
+     -3,-12,  6,  1,-10, -3, -1, -6, -2, -9,-10,  6,-17, -7, -3, -7, -1, -3, -8,-10, -6,  6,  0, -5,
+     -3,-14,  1,  6,-13, -5, -1, -6, -4, -7, -5, -3,-17, -4,  6, -4, -5, -6, -6,-14, -9,  0,  6, -5,
+     -3, -9, -5, -5, -8, -5, -5, -5, -5, -6, -5, -3,-17, -5, -5, -6, -3, -4, -5,-11, -7, -5, -5, -5,
+    };
+
+    static const int8 s_pam70[24*24] =
+    {
+      5, -4, -1, -1, -6,  0, -4, -2, -4, -4, -3, -2,-11,  0, -2, -4,  1,  1, -1, -9, -5, -1, -1, -2,
+     -4,  9, -9, -9, -8, -6, -5, -4, -9,-10, -9, -7,-11, -5, -9, -5, -1, -5, -4,-11, -2, -8, -9, -6,
+     -1, -9,  6,  3,-10, -1, -1, -5, -2, -8, -7,  3,-11, -4,  0, -6, -1, -2, -5,-10, -7,  5,  2, -3,
+     -1, -9,  3,  6, -9, -2, -2, -4, -2, -6, -4,  0,-11, -3,  2, -5, -2, -3, -4,-11, -6,  2,  5, -3,
+     -6, -8,-10, -9,  8, -7, -4,  0, -9, -1, -2, -6,-11, -7, -9, -7, -4, -6, -5, -2,  4, -7, -9, -5,
+      0, -6, -1, -2, -7,  6, -6, -6, -5, -7, -6, -1,-11, -3, -4, -6,  0, -3, -3,-10, -9, -1, -3, -3,
+     -4, -5, -1, -2, -4, -6,  8, -6, -3, -4, -6,  1,-11, -2,  2,  0, -3, -4, -4, -5, -1,  0,  1, -3,
+     -2, -4, -5, -4,  0, -6, -6,  7, -4,  1,  1, -3,-11, -5, -5, -3, -4, -1,  3, -9, -4, -4, -4, -3,
+     -4, -9, -2, -2, -9, -5, -3, -4,  6, -5,  0,  0,-11, -4, -1,  2, -2, -1, -6, -7, -7, -1, -2, -3,
+     -4,-10, -8, -6, -1, -7, -4,  1, -5,  6,  2, -5,-11, -5, -3, -6, -6, -4,  0, -4, -4, -6, -4, -4,
+     -3, -9, -7, -4, -2, -6, -6,  1,  0,  2, 10, -5,-11, -5, -2, -2, -3, -2,  0, -8, -7, -6, -3, -3,
+     -2, -7,  3,  0, -6, -1,  1, -3,  0, -5, -5,  6,-11, -3, -1, -3,  1,  0, -5, -6, -3,  5, -1, -2,
+    -11,-11,-11,-11,-11,-11,-11,-11,-11,-11,-11,-11,  1,-11,-11,-11,-11,-11,-11,-11,-11,-11,-11,-11,
+      0, -5, -4, -3, -7, -3, -2, -5, -4, -5, -5, -3,-11,  7, -1, -2,  0, -2, -3, -9, -9, -4, -2, -3,
+     -2, -9,  0,  2, -9, -4,  2, -5, -1, -3, -2, -1,-11, -1,  7,  0, -3, -3, -4, -8, -8, -1,  5, -2,
+     -4, -5, -6, -5, -7, -6,  0, -3,  2, -6, -2, -3,-11, -2,  0,  8, -1, -4, -5,  0, -7, -4, -2, -3,
+      1, -1, -1, -2, -4,  0, -3, -4, -2, -6, -3,  1,-11,  0, -3, -1,  5,  2, -3, -3, -5,  0, -2, -1,
+      1, -5, -2, -3, -6, -3, -4, -1, -1, -4, -2,  0,-11, -2, -3, -4,  2,  6, -1, -8, -4, -1, -3, -2,
+     -1, -4, -5, -4, -5, -3, -4,  3, -6,  0,  0, -5,-11, -3, -4, -5, -3, -1,  6,-10, -5, -5, -4, -2,
+     -9,-11,-10,-11, -2,-10, -5, -9, -7, -4, -8, -6,-11, -9, -8,  0, -3, -8,-10, 13, -3, -7,-10, -7,
+     -5, -2, -7, -6,  4, -9, -1, -4, -7, -4, -7, -3,-11, -9, -8, -7, -5, -4, -5, -3,  9, -4, -7, -5,
+     -1, -8,  5,  2, -7, -1,  0, -4, -1, -6, -6,  5,-11, -4, -1, -4,  0, -1, -5, -7, -4,  5,  1, -2,
+     -1, -9,  2,  5, -9, -3,  1, -4, -2, -4, -3, -1,-11, -2,  5, -2, -2, -3, -4,-10, -7,  1,  5, -3,
+     -2, -6, -3, -3, -5, -3, -3, -3, -3, -4, -3, -2,-11, -3, -2, -3, -1, -2, -2, -7, -5, -2, -3, -3,
+    };
+
+    static const int8 s_pam250[24*24] =
+    {
+      2, -2,  0,  0, -3,  1, -1, -1, -1, -2, -1,  0, -8,  1,  0, -2,  1,  1,  0, -6, -3,  0,  0,  0,
+     -2, 12, -5, -5, -4, -3, -3, -2, -5, -6, -5, -4, -8, -3, -5, -4,  0, -2, -2, -8,  0, -4, -5, -3,
+      0, -5,  4,  3, -6,  1,  1, -2,  0, -4, -3,  2, -8, -1,  2, -1,  0,  0, -2, -7, -4,  3,  3, -1,
+      0, -5,  3,  4, -5,  0,  1, -2,  0, -3, -2,  1, -8, -1,  2, -1,  0,  0, -2, -7, -4,  3,  3, -1,
+     -3, -4, -6, -5,  9, -5, -2,  1, -5,  2,  0, -3, -8, -5, -5, -4, -3, -3, -1,  0,  7, -4, -5, -2,
+      1, -3,  1,  0, -5,  5, -2, -3, -2, -4, -3,  0, -8,  0, -1, -3,  1,  0, -1, -7, -5,  0,  0, -1,
+     -1, -3,  1,  1, -2, -2,  6, -2,  0, -2, -2,  2, -8,  0,  3,  2, -1, -1, -2, -3,  0,  1,  2, -1,
+     -1, -2, -2, -2,  1, -3, -2,  5, -2,  2,  2, -2, -8, -2, -2, -2, -1,  0,  4, -5, -1, -2, -2, -1,
+     -1, -5,  0,  0, -5, -2,  0, -2,  5, -3,  0,  1, -8, -1,  1,  3,  0,  0, -2, -3, -4,  1,  0, -1,
+     -2, -6, -4, -3,  2, -4, -2,  2, -3,  6,  4, -3, -8, -3, -2, -3, -3, -2,  2, -2, -1, -3, -3, -1,
+     -1, -5, -3, -2,  0, -3, -2,  2,  0,  4,  6, -2, -8, -2, -1,  0, -2, -1,  2, -4, -2, -2, -2, -1,
+      0, -4,  2,  1, -3,  0,  2, -2,  1, -3, -2,  2, -8,  0,  1,  0,  1,  0, -2, -4, -2,  2,  1,  0,
+     -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8,  1, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8, -8,
+      1, -3, -1, -1, -5,  0,  0, -2, -1, -3, -2,  0, -8,  6,  0,  0,  1,  0, -1, -6, -5, -1,  0, -1,
+      0, -5,  2,  2, -5, -1,  3, -2,  1, -2, -1,  1, -8,  0,  4,  1, -1, -1, -2, -5, -4,  1,  3, -1,
+     -2, -4, -1, -1, -4, -3,  2, -2,  3, -3,  0,  0, -8,  0,  1,  6,  0, -1, -2,  2, -4, -1,  0, -1,
+      1,  0,  0,  0, -3,  1, -1, -1,  0, -3, -2,  1, -8,  1, -1,  0,  2,  1, -1, -2, -3,  0,  0,  0,
+      1, -2,  0,  0, -3,  0, -1,  0,  0, -2, -1,  0, -8,  0, -1, -1,  1,  3,  0, -5, -3,  0, -1,  0,
+      0, -2, -2, -2, -1, -1, -2,  4, -2,  2,  2, -2, -8, -1, -2, -2, -1,  0,  4, -6, -2, -2, -2, -1,
+     -6, -8, -7, -7,  0, -7, -3, -5, -3, -2, -4, -4, -8, -6, -5,  2, -2, -5, -6, 17,  0, -5, -6, -4,
+     -3,  0, -4, -4,  7, -5,  0, -1, -4, -1, -2, -2, -8, -5, -4, -4, -3, -3, -2,  0, 10, -3, -4, -2,
+      0, -4,  3,  3, -4,  0,  1, -2,  1, -3, -2,  2, -8, -1,  1, -1,  0,  0, -2, -5, -3,  3,  2, -1,
+      0, -5,  3,  3, -5,  0,  2, -2,  0, -3, -2,  1, -8,  0,  3,  0,  0, -1, -2, -6, -4,  2,  3, -1,
+      0, -3, -1, -1, -2, -1, -1, -1, -1, -1, -1,  0, -8, -1, -1, -1,  0,  0, -1, -4, -2, -1, -1, -1,
+    };
+
+    switch (matrix)
+    {
+    case SubstitutionMatrix::BLOSUM45: *name = "BLOSUM45"; return s_blosum45;
+    case SubstitutionMatrix::BLOSUM50: *name = "BLOSUM50"; return s_blosum50;
+    case SubstitutionMatrix::BLOSUM80: *name = "BLOSUM80"; return s_blosum80;
+    case SubstitutionMatrix::BLOSUM90: *name = "BLOSUM90"; return s_blosum90;
+    case SubstitutionMatrix::PAM30:    *name = "PAM30";    return s_pam30;
+    case SubstitutionMatrix::PAM70:    *name = "PAM70";    return s_pam70;
+    case SubstitutionMatrix::PAM250:   *name = "PAM250";   return s_pam250;
+    default:                           *name = "BLOSUM62"; return s_blosum62;
+    }
+}
+
+// map a matrix file symbol to a PROTEIN symbol, returning uint32(-1) if it's not part of the alphabet;
+// the stop symbol '*' is mapped to O unless the matrix provides an explicit O.
+//
+inline uint32 substitution_matrix_symbol(const char c, const bool stop_as_O)
+{
+    if (c == '*')
+        return stop_as_O ? uint32( char_to_protein( 'O' ) ) : uint32(-1);
+
+    const char uc = char( toupper( c ) );
+    const uint8 s = char_to_protein( uc );
+    return protein_to_char( s ) == uc ? uint32( s ) : uint32(-1);
+}
+
+///@} // end of private group
+
+} // namespace priv
+
+// select a built-in matrix
+//
+inline void SubstitutionMatrix::set(const Builtin matrix)
+{
+    const char* name;
+    const int8* scores = priv::builtin_substitution_matrix( matrix, &name );
+
+    strcpy( m_name, name );
+    m_max_score = Field_traits<int32>::min();
+    m_min_score = Field_traits<int32>::max();
+    for (uint32 i = 0; i < SYMBOLS*SYMBOLS; ++i)
+    {
+        m_scores[i] = scores[i];
+        m_max_score = nvbio::max( m_max_score, int32( scores[i] ) );
+        m_min_score = nvbio::min( m_min_score, int32( scores[i] ) );
+    }
+}
+
+// select a built-in matrix by name, or load it from a file
+//
+inline bool SubstitutionMatrix::set(const char* name)
+{
+    static const char*   names[]    = { "BLOSUM45", "BLOSUM50", "BLOSUM62", "BLOSUM80", "BLOSUM90", "PAM30", "PAM70", "PAM250" };
+    static const Builtin matrices[] = {  BLOSUM45,   BLOSUM50,   BLOSUM62,   BLOSUM80,   BLOSUM90,   PAM30,   PAM70,   PAM250  };
+
+    for (uint32 i = 0; i < sizeof(matrices)/sizeof(Builtin); ++i)
+    {
+        const char* a = name;
+        const char* b = names[i];
+        while (*a && toupper( *a ) == *b) { ++a; ++b; }
+        if (*a == '\0' && *b == '\0')
+        {
+            set( matrices[i] );
+            return true;
+        }
+    }
+    return load( name );
+}
+
+// load a matrix in the NCBI text format
+//
+inline bool SubstitutionMatrix::load(const char* filename)
+{
+    FILE* file = fopen( filename, "r" );
+    if (file == NULL)
+    {
+        log_error(stderr, "unable to open substitution matrix \"%s\"\n", filename);
+        return false;
+    }
+
+    uint32 columns[64];
+    uint32 n_columns = 0;
+    bool   row_seen[SYMBOLS] = { false };
+    bool   col_seen[SYMBOLS] = { false };
+    int32  scores[SYMBOLS*SYMBOLS];
+    int32  min_score = Field_traits<int32>::max();
+    int32  max_score = Field_traits<int32>::min();
+    bool   stop_as_O = true;
+
+    char line[1024];
+    while (fgets( line, sizeof(line), file ))
+    {
+        char* p = line;
+        while (isspace( *p )) ++p;
+        if (*p == '\0' || *p == '#')
+            continue;
+
+        if (n_columns == 0)
+        {
+            // the header, listing the column symbols
+            stop_as_O = strchr( p, 'O' ) == NULL && strchr( p, 'o' ) == NULL;
+            for (; *p && n_columns < 64; ++p)
+            {
+                if (!isspace( *p ))
+                    columns[ n_columns++ ] = priv::substitution_matrix_symbol( *p, stop_as_O );
+            }
+            continue;
+        }
+
+        const char   c = *p++;
+        const uint32 q = priv::substitution_matrix_symbol( c, stop_as_O );
+
+        for (uint32 i = 0; i < n_columns; ++i)
+        {
+            char* end;
+            const long v = strtol( p, &end, 10 );
+            if (end == p)
+            {
+                log_error(stderr, "malformed row '%c' in substitution matrix \"%s\"\n", c, filename);
+                fclose( file );
+                return false;
+            }
+            p = end;
+
+            const uint32 r = columns[i];
+            if (q == uint32(-1) || r == uint32(-1))
+                continue;
+
+            scores[ q * SYMBOLS + r ] = int32( v );
+            row_seen[q] = true;
+            col_seen[r] = true;
+            min_score = nvbio::min( min_score, int32( v ) );
+            max_score = nvbio::max( max_score, int32( v ) );
+        }
+    }
+    fclose( file );
+
+    if (n_columns == 0 || max_score < min_score)
+    {
+        log_error(stderr, "empty substitution matrix \"%s\"\n", filename);
+        return false;
+    }
+    if (min_score < -128 || max_score > 127)
+    {
+        log_error(stderr, "substitution matrix \"%s\" scores out of the [-128,127] range\n", filename);
+        return false;
+    }
+
+    for (uint32 q = 0; q < SYMBOLS; ++q)
+        for (uint32 r = 0; r < SYMBOLS; ++r)
+            m_scores[ q * SYMBOLS + r ] = int8( row_seen[q] && col_seen[r] ? scores[ q * SYMBOLS + r ] : min_score );
+
+    strncpy( m_name, filename, sizeof(m_name)-1 );
+    m_name[ sizeof(m_name)-1 ] = '\0';
+    m_min_score = min_score;
+    m_max_score = max_score;
+    return true;
+}
+
+// build the profile of a given pattern
+//
+template <typename pattern_string>
+void QueryProfile::build(const SubstitutionMatrix& matrix, const pattern_string pattern)
+{
+    const uint32 M = pattern.length();
+    const uint32 S = SubstitutionMatrix::SYMBOLS;
+
+    m_length    = M;
+    m_segments  = (M + LANES-1) / LANES;
+    m_max_score = matrix.max_score();
+
+    // the linear layout
+    m_profile.resize( S * M );
+    for (uint32 r = 0; r < S; ++r)
+    {
+        int8* row = &m_profile[ r * M ];
+        for (uint32 j = 0; j < M; ++j)
+            row[j] = int8( matrix( pattern[j], r ) );
+    }
+
+    // the striped layout; the padding positions past the end of the pattern get a large
+    // negative score, so that they never extend an alignment
+    const uint32 n_segments = m_segments;
+    m_striped.resize( S * n_segments * LANES );
+    for (uint32 r = 0; r < S; ++r)
+    {
+        int16* row = &m_striped[ r * n_segments * LANES ];
+        for (uint32 s = 0; s < n_segments; ++s)
+        {
+            for (uint32 l = 0; l < LANES; ++l)
+            {
+                const uint32 j = l * n_segments + s;
+                row[ s * LANES + l ] = j < M ? int16( matrix( pattern[j], r ) ) : int16( -16384 );
+            }
+        }
+    }
+}
+
+// compute the best local alignment score of a profiled pattern with the scalar algorithm
+//
+template <typename text_string>
+int32 query_profile_score_scalar(
+    const QueryProfile& profile,
+    const text_string   text,
+    const int32         gap_open,
+    const int32         gap_ext,
+    uint2*              sink)
+{
+    const int32  NEG_INF = -(1 << 28);
+    const uint32 M = profile.length();
+    const uint32 N = text.length();
+
+    std::vector<int32> H( M+1, 0 );
+    std::vector<int32> F( M+1, NEG_INF );
+
+    int32 best_score = 0;
+    uint2 best_sink  = make_uint2( 0u, 0u );
+
+    for (uint32 i = 0; i < N; ++i)
+    {
+        // a single row of scores for the current text symbol
+        const int8* S_i = profile.row( text[i] );
+
+        int32 diag = 0;
+        int32 E    = NEG_INF;
+        for (uint32 j = 1; j <= M; ++j)
+        {
+            F[j] = nvbio::max( F[j] + gap_ext, H[j]   + gap_open );
+            E    = nvbio::max( E    + gap_ext, H[j-1] + gap_open );
+
+            const int32 h = nvbio::max( nvbio::max( nvbio::max( E, F[j] ), diag + int32( S_i[j-1] ) ), 0 );
+            diag = H[j];
+            H[j] = h;
+
+            if (h > best_score)
+            {
+                best_score = h;
+                best_sink  = make_uint2( i+1, j );
+            }
+        }
+    }
+    if (sink)
+        *sink = best_sink;
+
+    return best_score;
+}
+
+#if defined(__SSE2__)
+
+namespace priv {
+
+///@addtogroup private
+///@{
+
+//
+// Farrar's striped local Gotoh alignment with 16-bit saturated scores.
+// Returns -1 if the scores got close enough to saturation that the result cannot be trusted,
+// or if opening a gap is cheaper than extending it, as the lazy-F loop stops as soon as
+// extending F no longer beats opening a new gap, which only holds for gap_open <= gap_ext.
+//
+template <typename text_string>
+int32 query_profile_score_sse2(
+    const QueryProfile& profile,
+    const text_string   text,
+    const int32         gap_open,
+    const int32         gap_ext,
+    uint2*              sink)
+{
+    const uint32 LANES    = QueryProfile::LANES;
+    const uint32 M        = profile.length();
+    const uint32 N        = text.length();
+    const uint32 segments = profile.m_segments;
+
+    if (gap_open > gap_ext)
+        return -1;
+
+    // the largest safe score
+    const int32 max_safe = 32767 - nvbio::max( profile.m_max_score, 0 );
+
+    std::vector<__m128i> H_store( segments );
+    std::vector<__m128i> H_load( segments );
+    std::vector<__m128i> E( segments );
+
+    const __m128i zero   = _mm_setzero_si128();
+    const __m128i G_o    = _mm_set1_epi16( int16( -gap_open ) );
+    const __m128i G_e    = _mm_set1_epi16( int16( -gap_ext ) );
+
+    for (uint32 s = 0; s < segments; ++s)
+    {
+        H_store[s] = zero;
+        H_load[s]  = zero;
+        E[s]       = zero;
+    }
+
+    int32 best_score = 0;
+    uint2 best_sink  = make_uint2( 0u, 0u );
+
+    for (uint32 i = 0; i < N; ++i)
+    {
+        const __m128i* S_i = reinterpret_cast<const __m128i*>( profile.striped_row( text[i] ) );
+
+        __m128i F       = zero;
+        __m128i row_max = zero;
+
+        // the diagonal term of the first segment comes from the previous lane's last segment
+        __m128i H = _mm_slli_si128( H_store[ segments-1 ], 2 );
+
+        std::swap( H_store, H_load );
+
+        for (uint32 s = 0; s < segments; ++s)
+        {
+            H = _mm_adds_epi16( H, _mm_loadu_si128( S_i + s ) );
+            H = _mm_max_epi16( H, E[s] );
+            H = _mm_max_epi16( H, F );
+            H = _mm_max_epi16( H, zero );
+            row_max = _mm_max_epi16( row_max, H );
+            H_store[s] = H;
+
+            // the gaps leaving this cell
+            H    = _mm_subs_epi16( H, G_o );
+            E[s] = _mm_max_epi16( _mm_subs_epi16( E[s], G_e ), H );
+            F    = _mm_max_epi16( _mm_subs_epi16( F, G_e ), H );
+
+            H = H_load[s];
+        }
+
+        // lazy-F loop: propagate the vertical gaps across lanes, until they can no longer
+        // improve any cell
+        for (uint32 k = 0; k < LANES; ++k)
+        {
+            F = _mm_slli_si128( F, 2 );
+
+            bool done = false;
+            for (uint32 s = 0; s < segments; ++s)
+            {
+                const __m128i H_old = H_store[s];
+                const __m128i H_new = _mm_max_epi16( H_old, F );
+                H_store[s] = H_new;
+                row_max    = _mm_max_epi16( row_max, H_new );
+                E[s]       = _mm_max_epi16( E[s], _mm_subs_epi16( H_new, G_o ) );
+
+                F = _mm_subs_epi16( F, G_e );
+                if (_mm_movemask_epi8( _mm_cmpgt_epi16( F, _mm_subs_epi16( H_old, G_o ) ) ) == 0)
+                {
+                    done = true;
+                    break;
+                }
+            }
+            if (done)
+                break;
+        }
+
+        // reduce the row maximum
+        __m128i m = row_max;
+        m = _mm_max_epi16( m, _mm_srli_si128( m, 8 ) );
+        m = _mm_max_epi16( m, _mm_srli_si128( m, 4 ) );
+        m = _mm_max_epi16( m, _mm_srli_si128( m, 2 ) );
+        const int32 row_best = int16( _mm_extract_epi16( m, 0 ) );
+
+        if (row_best > best_score)
+        {
+            if (row_best >= max_safe)
+                return -1;
+
+            // locate the pattern position of the new best cell
+            best_score = row_best;
+            for (uint32 s = 0; s < segments; ++s)
+            {
+                int16 lanes[LANES];
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes ), H_store[s] );
+                for (uint32 l = 0; l < LANES; ++l)
+                {
+                    const uint32 j = l * segments + s;
+                    if (j < M && lanes[l] == row_best && (best_sink.x != i+1 || j+1 < best_sink.y))
+                        best_sink = make_uint2( i+1, j+1 );
+                }
+            }
+        }
+    }
+    if (sink)
+        *sink = best_sink;
+
+    return best_score;
+}
+
+///@} // end of private group
+
+} // namespace priv
+
+#endif // __SSE2__
+
+// compute the best local alignment score of a profiled pattern
+//
+template <typename text_string>
+int32 query_profile_score(
+    const QueryProfile& profile,
+    const text_string   text,
+    const int32         gap_open,
+    const int32         gap_ext,
+    uint2*              sink)
+{
+  #if defined(__SSE2__)
+    if (profile.length())
+    {
+        const int32 score = priv::query_profile_score_sse2( profile, text, gap_open, gap_ext, sink );
+        if (score >= 0)
+            return score;
+    }
+  #endif
+    return query_profile_score_scalar( profile, text, gap_open, gap_ext, sink );
+}
+
+} // namespace aln
+} // namespace nvbio
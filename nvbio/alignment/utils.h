@@ -59,6 +59,7 @@ template <typename aligner_type> struct column_storage_type {
     typedef null_type type;    ///< the type of the column cells
 };
 template <AlignmentType TYPE, typename algorithm_tag>                        struct column_storage_type< EditDistanceAligner<TYPE,algorithm_tag> >                  { typedef  int16 type; };
+template <AlignmentType TYPE, uint32 ALPHABET_SIZE>                         struct column_storage_type< EditDistanceAligner<TYPE,MyersTag<ALPHABET_SIZE> > >      { typedef uint64 type; };
 template <AlignmentType TYPE, typename scoring_type, typename algorithm_tag> struct column_storage_type< HammingDistanceAligner<TYPE,scoring_type,algorithm_tag> >  { typedef  int16 type; };
 template <AlignmentType TYPE, typename scoring_type, typename algorithm_tag> struct column_storage_type< SmithWatermanAligner<TYPE,scoring_type,algorithm_tag> >    { typedef  int16 type; };
 template <AlignmentType TYPE, typename scoring_type, typename algorithm_tag> struct column_storage_type< GotohAligner<TYPE,scoring_type,algorithm_tag> >            { typedef short2 type; };
@@ -133,6 +134,37 @@ struct SimpleGotohScheme
     int32 m_gap_ext;
 };
 
+///
+/// A \ref GotohScoringScheme model scoring substitutions through a square matrix,
+/// e.g. a protein \ref SubstitutionMatrix: the score of a text symbol r against a pattern
+/// symbol q is found at matrix[ q * SYMBOLS + r ], with a single indexed load per cell.
+///
+/// \tparam matrix_iterator     an iterator to the matrix entries, e.g. const int8* on the host
+///                             or a cuda::ldg_pointer<int8> on the device
+/// \tparam SYMBOLS             the number of symbols in the alphabet
+///
+template <typename matrix_iterator, uint32 SYMBOLS = 24u>
+struct MatrixGotohScheme
+{
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE MatrixGotohScheme() {}
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE MatrixGotohScheme(
+        const matrix_iterator matrix, const int32 max_match, const int32 gap_open, const int32 gap_ext) :
+        m_matrix(matrix), m_match(max_match), m_gap_open(gap_open), m_gap_ext(gap_ext) {}
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 match(const uint8 q = 0)      const { return m_match; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 mismatch(const uint8 a, const uint8 b, const uint8 q = 0)   const { return int8( m_matrix[ b * SYMBOLS + a ] ); };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 substitution(const uint32 r_i, const uint32 q_j, const uint8 r, const uint8 q, const uint8 qq = 0) const { return int8( m_matrix[ q * SYMBOLS + r ] ); };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 pattern_gap_open()            const { return m_gap_open; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 pattern_gap_extension()       const { return m_gap_ext; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_open()               const { return m_gap_open; };
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE int32 text_gap_extension()          const { return m_gap_ext; };
+
+    matrix_iterator m_matrix;
+    int32           m_match;
+    int32           m_gap_open;
+    int32           m_gap_ext;
+};
+
 ///
 /// Calculate the maximum possible number of pattern gaps that could occur in a
 /// given score boundary
@@ -0,0 +1,216 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/basic/arena.h>
+#include <nvbio/basic/numbers.h>
+
+#if !defined(WIN32)
+#include <pthread.h>
+#endif
+
+namespace nvbio {
+
+// destructor
+//
+HostArena::~HostArena()
+{
+    for (uint32 i = 0; i < m_chunks.size(); ++i)
+        host_free( m_chunks[i].ptr, m_chunks[i].size );
+}
+
+// add a new chunk
+//
+void HostArena::add_chunk(const uint64 bytes)
+{
+    // grow geometrically to bound the number of chunks in flight
+    uint64 size = nvbio::max( bytes, uint64( MIN_CHUNK_SIZE ) );
+    size = nvbio::max( size, capacity() );
+
+    Chunk chunk;
+    chunk.ptr    = (uint8*)host_alloc( size, m_flags );
+    chunk.size   = size;
+    chunk.offset = 0;
+    m_chunks.push_back( chunk );
+}
+
+// make sure the arena can serve at least the given number of bytes from a single chunk
+//
+void HostArena::reserve(const uint64 bytes)
+{
+    if (m_used == 0 && m_chunks.size() == 1u && m_chunks[0].size >= bytes)
+        return;
+
+    if (m_used == 0)
+    {
+        // merge everything into a single chunk
+        const uint64 size = nvbio::max( bytes, capacity() );
+        for (uint32 i = 0; i < m_chunks.size(); ++i)
+            host_free( m_chunks[i].ptr, m_chunks[i].size );
+        m_chunks.clear();
+
+        add_chunk( size );
+    }
+    else if (m_chunks.back().size - m_chunks.back().offset < bytes)
+        add_chunk( bytes );
+}
+
+// allocate an uninitialized block
+//
+void* HostArena::alloc(const uint64 bytes, const uint64 alignment)
+{
+    // try to fit the request in the current chunk
+    if (m_chunks.size())
+    {
+        Chunk& chunk = m_chunks.back();
+
+        const uint64 base   = uint64( size_t( chunk.ptr ) );
+        const uint64 offset = ((base + chunk.offset + alignment-1) & ~(alignment-1)) - base;
+        if (offset + bytes <= chunk.size)
+        {
+            m_used      += offset + bytes - chunk.offset;
+            chunk.offset = offset + bytes;
+            m_high_water = nvbio::max( m_high_water, m_used );
+            return chunk.ptr + offset;
+        }
+    }
+
+    // add a new chunk; the allocation is at least page aligned
+    add_chunk( bytes + alignment );
+
+    Chunk& chunk = m_chunks.back();
+    chunk.offset = bytes;
+    m_used      += bytes;
+
+    // once the chunks are consolidated, this block might need padding to its alignment
+    m_high_water = nvbio::max( m_high_water, m_used + alignment - 1u );
+    return chunk.ptr;
+}
+
+// return the current allocation mark
+//
+HostArena::Mark HostArena::mark() const
+{
+    Mark r;
+    r.chunk  = uint32( m_chunks.size() );
+    r.offset = m_chunks.size() ? m_chunks.back().offset : 0u;
+    return r;
+}
+
+// release all allocations performed after a given mark
+//
+void HostArena::rewind(const Mark mark)
+{
+    // release the chunks added after the mark
+    while (m_chunks.size() > mark.chunk)
+    {
+        m_used -= m_chunks.back().offset;
+        if (mark.chunk == 0u && m_chunks.size() == 1u)
+            break; // keep the first chunk around
+
+        host_free( m_chunks.back().ptr, m_chunks.back().size );
+        m_chunks.pop_back();
+    }
+
+    if (mark.chunk && mark.chunk == m_chunks.size())
+    {
+        Chunk& chunk = m_chunks.back();
+        m_used -= chunk.offset - mark.offset;
+        chunk.offset = mark.offset;
+    }
+    else if (mark.chunk == 0u && m_chunks.size())
+        m_chunks.back().offset = 0u;
+
+    // once empty, consolidate the high-water mark in a single chunk
+    if (m_used == 0 && m_chunks.size() && m_chunks[0].size < m_high_water)
+        reserve( m_high_water );
+}
+
+// release all allocations
+//
+void HostArena::reset()
+{
+    Mark empty;
+    empty.chunk  = 0;
+    empty.offset = 0;
+    rewind( empty );
+}
+
+// return the total capacity of the arena
+//
+uint64 HostArena::capacity() const
+{
+    uint64 r = 0;
+    for (uint32 i = 0; i < m_chunks.size(); ++i)
+        r += m_chunks[i].size;
+    return r;
+}
+
+#if defined(WIN32)
+
+// return the arena of the calling thread
+//
+HostArena& thread_arena()
+{
+    // NOTE: Windows thread-local arenas are not released on thread exit
+    static __declspec(thread) HostArena* arena = NULL;
+    if (arena == NULL)
+        arena = new HostArena();
+
+    return *arena;
+}
+
+#else
+
+namespace {
+
+pthread_key_t  s_arena_key;
+pthread_once_t s_arena_once = PTHREAD_ONCE_INIT;
+
+void delete_arena(void* arena) { delete (HostArena*)arena; }
+
+void create_arena_key() { pthread_key_create( &s_arena_key, delete_arena ); }
+
+} // anonymous namespace
+
+// return the arena of the calling thread
+//
+HostArena& thread_arena()
+{
+    pthread_once( &s_arena_once, create_arena_key );
+
+    HostArena* arena = (HostArena*)pthread_getspecific( s_arena_key );
+    if (arena == NULL)
+    {
+        arena = new HostArena();
+        pthread_setspecific( s_arena_key, arena );
+    }
+    return *arena;
+}
+
+#endif
+
+} // namespace nvbio
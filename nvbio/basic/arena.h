@@ -0,0 +1,173 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! \file arena.h
+ *   \brief Define a reusable bump allocator for temporary host storage
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/system.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup Basic
+///@{
+
+///
+/// A stack-like bump allocator for the temporary buffers requested by batched
+/// algorithms on every call.
+/// Allocations are carved out of large uninitialized chunks obtained through host_alloc(),
+/// and released in LIFO order rewinding to a previously taken mark (typically through a
+/// HostArena::Scope).
+/// When an allocation does not fit the current chunk a new one is added, and as soon as
+/// the arena is rewound to empty all chunks are merged into a single one covering the
+/// high-water mark, so that in steady state all requests are served without touching
+/// the system allocator.
+///
+///\code
+/// void my_batch(const uint32 n)
+/// {
+///     HostArena::Scope scope( thread_arena() );
+///     uint32* temp = scope.alloc<uint32>( n );
+///     ...
+/// } // temp is released here
+///\endcode
+///
+struct HostArena
+{
+    static const uint64 DEFAULT_ALIGNMENT = 64u;    ///< cache-line alignment
+    static const uint64 MIN_CHUNK_SIZE    = 1u << 20;
+
+    /// an allocation mark
+    ///
+    struct Mark
+    {
+        uint32 chunk;
+        uint64 offset;
+    };
+
+    /// a scoped allocation context, rewinding the arena on destruction
+    ///
+    struct Scope
+    {
+        Scope(HostArena& arena) : m_arena( arena ), m_mark( arena.mark() ) {}
+        ~Scope() { m_arena.rewind( m_mark ); }
+
+        /// allocate uninitialized storage for n elements of type T
+        ///
+        template <typename T>
+        T* alloc(const uint64 n) { return (T*)m_arena.alloc( n * sizeof(T) ); }
+
+    private:
+        Scope(const Scope&);
+        Scope& operator=(const Scope&);
+
+        HostArena&  m_arena;
+        Mark        m_mark;
+    };
+
+    /// constructor
+    ///
+    /// \param flags        a combination of HostAllocFlags used for the chunks
+    ///
+    explicit HostArena(const uint32 flags = HOST_ALLOC_DEFAULT) : m_flags( flags ), m_high_water( 0 ), m_used( 0 ) {}
+
+    /// destructor
+    ///
+    ~HostArena();
+
+    /// make sure the arena can serve at least the given number of bytes from a single chunk
+    ///
+    void reserve(const uint64 bytes);
+
+    /// allocate an uninitialized block
+    ///
+    /// \param bytes        the block size
+    /// \param alignment    the block alignment, a power of 2
+    ///
+    void* alloc(const uint64 bytes, const uint64 alignment = DEFAULT_ALIGNMENT);
+
+    /// allocate uninitialized storage for n elements of type T
+    ///
+    template <typename T>
+    T* alloc(const uint64 n) { return (T*)alloc( n * sizeof(T) ); }
+
+    /// return the current allocation mark
+    ///
+    Mark mark() const;
+
+    /// release all allocations performed after a given mark
+    ///
+    void rewind(const Mark mark);
+
+    /// release all allocations
+    ///
+    void reset();
+
+    /// return the number of bytes currently allocated
+    ///
+    uint64 used() const { return m_used; }
+
+    /// return the largest number of bytes ever allocated at once, including the
+    /// alignment padding the allocations would need in a single chunk
+    ///
+    uint64 high_water() const { return m_high_water; }
+
+    /// return the total capacity of the arena
+    ///
+    uint64 capacity() const;
+
+private:
+    struct Chunk
+    {
+        uint8*  ptr;
+        uint64  size;
+        uint64  offset;
+    };
+
+    void add_chunk(const uint64 bytes);
+
+    HostArena(const HostArena&);
+    HostArena& operator=(const HostArena&);
+
+    uint32              m_flags;
+    std::vector<Chunk>  m_chunks;
+    uint64              m_high_water;
+    uint64              m_used;
+};
+
+/// return the arena of the calling thread, created on first use and
+/// released on thread exit
+///
+HostArena& thread_arena();
+
+///@} Basic
+
+} // namespace nvbio
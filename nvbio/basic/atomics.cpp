@@ -195,4 +195,37 @@ uint64 host_atomic_or(uint64* value, const uint64 op)
 #endif
 }
 
+uint32 host_atomic_cas(uint32* value, const uint32 compare, const uint32 op)
+{
+#if defined(__GNUC__)
+    return __sync_val_compare_and_swap( value, compare, op );
+#elif defined(WIN32)
+    return uint32( InterlockedCompareExchange( reinterpret_cast<LONG volatile*>(value), LONG(op), LONG(compare) ) );
+#else
+    Mutex mutex;
+    ScopedLock lock( &mutex );
+
+    const uint32 old = *value;
+    if (old == compare)
+        *value = op;
+    return old;
+#endif
+}
+uint64 host_atomic_cas(uint64* value, const uint64 compare, const uint64 op)
+{
+#if defined(__GNUC__)
+    return __sync_val_compare_and_swap( value, compare, op );
+#elif defined(WIN32)
+    return uint64( InterlockedCompareExchange64( reinterpret_cast<LONGLONG volatile*>(value), LONGLONG(op), LONGLONG(compare) ) );
+#else
+    Mutex mutex;
+    ScopedLock lock( &mutex );
+
+    const uint64 old = *value;
+    if (old == compare)
+        *value = op;
+    return old;
+#endif
+}
+
 } // namespace nvbio
@@ -30,6 +30,7 @@
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/atomics.h>
 #include <nvbio/basic/static_vector.h>
+#include <nvbio/basic/system.h>
 
 namespace nvbio {
 
@@ -95,6 +96,18 @@ namespace nvbio {
 /// }
 ///\endcode
 ///
+/// \section BatchedProbesSection Batched Host Probes
+///\par
+/// On the host, each probe of a large filter is typically a cache miss: bloom_filter_insert_batch() and
+/// bloom_filter_has_batch() process a whole batch of keys at once, hashing each key a single time and
+/// prefetching the blocks of the upcoming keys while the current one is being set or tested:
+///
+///\code
+/// // look up all the kmers of a read
+/// uint8 found[MAX_KMERS];
+/// const uint32 n_found = bloom_filter_has_batch( filter, n_kmers, kmers, found );
+///\endcode
+///
 
 ///@addtogroup Basic
 ///@{
@@ -240,6 +253,28 @@ struct inplace_or<uint64_4>
     }
 };
 
+///
+/// a helper to prefetch the blocks of a Bloom filter's storage from the host;
+/// generic iterators do not expose an address to prefetch, and are left alone
+///
+template <typename Iterator>
+struct bloom_filter_prefetcher
+{
+    NVBIO_FORCEINLINE static void prefetch(const Iterator storage, const uint64 i) {}
+    NVBIO_FORCEINLINE static void prefetch_write(const Iterator storage, const uint64 i) {}
+};
+
+///
+/// a helper to prefetch the blocks of a Bloom filter's storage from the host,
+/// specialized for plain pointers
+///
+template <typename T>
+struct bloom_filter_prefetcher<T*>
+{
+    NVBIO_FORCEINLINE static void prefetch(const T* storage, const uint64 i)       { host_prefetch( storage + i ); }
+    NVBIO_FORCEINLINE static void prefetch_write(const T* storage, const uint64 i) { host_prefetch_write( storage + i ); }
+};
+
 ///
 /// A Bloom filter implementation.
 /// This class is <i>storage-free</i>, and can used both from the host and the device.
@@ -368,6 +403,39 @@ struct blocked_bloom_filter
     NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
     bool operator[] (const Key key) const { return has( key ); }
 
+    /// compute the pair of hashes used to probe the filter for a given key
+    ///
+    template <typename Key>
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint64_2 hash(const Key key) const;
+
+    /// return the index of the block addressed by a pair of hashes
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint64 block_index(const uint64_2 h) const { return (h.x % m_size) / BLOCK_SIZE; }
+
+    /// insert a key given its pair of hashes
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void insert_hashed(const uint64_2 h, const OrOperator or_op = OrOperator());
+
+    /// check for a key given its pair of hashes
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    bool has_hashed(const uint64_2 h) const;
+
+    /// issue a host software prefetch for the block addressed by a pair of hashes;
+    /// this is a no-op unless the storage iterator is a plain pointer
+    ///
+    NVBIO_FORCEINLINE
+    void prefetch(const uint64_2 h) const { bloom_filter_prefetcher<Iterator>::prefetch( m_storage, block_index( h ) ); }
+
+    /// issue a host software prefetch for the block addressed by a pair of hashes,
+    /// signaling the intent to modify it
+    ///
+    NVBIO_FORCEINLINE
+    void prefetch_for_insert(const uint64_2 h) const { bloom_filter_prefetcher<Iterator>::prefetch_write( m_storage, block_index( h ) ); }
+
     uint32          m_k;
     uint64          m_size;
     Iterator        m_storage;
@@ -375,6 +443,70 @@ struct blocked_bloom_filter
     Hash2           m_hash2;
 };
 
+/// the default number of keys a batched Bloom filter probe looks ahead of
+///
+static const uint32 BLOOM_FILTER_PREFETCH_DIST = 8u;
+
+/// insert a batch of keys in a blocked Bloom filter from the host.
+/// Each key is hashed once, and the blocks addressed by the next PREFETCH_DIST keys are
+/// prefetched while the current one is being set, so that the cache misses of independent
+/// probes overlap instead of being paid one at a time.
+///
+/// \tparam PREFETCH_DIST      the prefetching distance, in keys
+///
+/// \param filter              the Bloom filter
+/// \param n_keys              the number of keys
+/// \param keys                the keys
+///
+template <uint32 PREFETCH_DIST, typename Hash1, typename Hash2, typename Iterator, typename OrOperator, typename KeyIterator>
+void bloom_filter_insert_batch(
+    blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>&  filter,
+    const uint32                                            n_keys,
+    const KeyIterator                                       keys);
+
+/// insert a batch of keys in a blocked Bloom filter from the host, using the
+/// default prefetching distance
+///
+template <typename Hash1, typename Hash2, typename Iterator, typename OrOperator, typename KeyIterator>
+void bloom_filter_insert_batch(
+    blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>&  filter,
+    const uint32                                            n_keys,
+    const KeyIterator                                       keys)
+{
+    bloom_filter_insert_batch<BLOOM_FILTER_PREFETCH_DIST>( filter, n_keys, keys );
+}
+
+/// check a batch of keys against a blocked Bloom filter from the host,
+/// prefetching the blocks of the next PREFETCH_DIST keys while testing the current one.
+///
+/// \tparam PREFETCH_DIST      the prefetching distance, in keys
+///
+/// \param filter              the Bloom filter
+/// \param n_keys              the number of keys
+/// \param keys                the keys
+/// \param results             the output membership flags, one per key
+/// \return                    the number of keys found in the filter
+///
+template <uint32 PREFETCH_DIST, typename Hash1, typename Hash2, typename Iterator, typename OrOperator, typename KeyIterator, typename OutputIterator>
+uint32 bloom_filter_has_batch(
+    const blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>&    filter,
+    const uint32                                                    n_keys,
+    const KeyIterator                                               keys,
+          OutputIterator                                            results);
+
+/// check a batch of keys against a blocked Bloom filter from the host, using the
+/// default prefetching distance
+///
+template <typename Hash1, typename Hash2, typename Iterator, typename OrOperator, typename KeyIterator, typename OutputIterator>
+uint32 bloom_filter_has_batch(
+    const blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>&    filter,
+    const uint32                                                    n_keys,
+    const KeyIterator                                               keys,
+          OutputIterator                                            results)
+{
+    return bloom_filter_has_batch<BLOOM_FILTER_PREFETCH_DIST>( filter, n_keys, keys, results );
+}
+
 /// compute the optimal number of Bloom filter hash functions given the
 /// number of bits per key
 ///
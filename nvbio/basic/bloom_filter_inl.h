@@ -115,6 +115,20 @@ blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::blocked_bloom_filter(
     m_hash1( hash1 ),
     m_hash2( hash2 ) {}
 
+template <
+    typename Hash1,     // first hash generator function
+    typename Hash2,     // second hash generator function
+    typename Iterator,  // storage iterator - must be one of {uint32|uint2|uint4|uint64|uint64_2|uint64_4}
+    typename OrOperator>
+template <typename Key>
+uint64_2 blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::hash(const Key key) const
+{
+    uint64_2 h;
+    h.x = m_hash1( key );
+    h.y = m_hash2( key );
+    return h;
+}
+
 template <
     typename Hash1,     // first hash generator function
     typename Hash2,     // second hash generator function
@@ -123,10 +137,31 @@ template <
 template <typename Key>
 void blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::insert(const Key key, const OrOperator or_op)
 {
-    const uint64 h0 = m_hash1( key );
-    const uint64 h1 = m_hash2( key );
+    insert_hashed( hash( key ), or_op );
+}
+
+template <
+    typename Hash1,     // first hash generator function
+    typename Hash2,     // second hash generator function
+    typename Iterator,  // storage iterator - must be one of {uint32|uint2|uint4|uint64|uint64_2|uint64_4}
+    typename OrOperator>
+template <typename Key>
+bool blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::has(const Key key) const
+{
+    return has_hashed( hash( key ) );
+}
+
+template <
+    typename Hash1,     // first hash generator function
+    typename Hash2,     // second hash generator function
+    typename Iterator,  // storage iterator - must be one of {uint32|uint2|uint4|uint64|uint64_2|uint64_4}
+    typename OrOperator>
+void blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::insert_hashed(const uint64_2 h, const OrOperator or_op)
+{
+    const uint64 h0 = h.x;
+    const uint64 h1 = h.y;
 
-    const uint64 block_idx = (h0 % m_size) / BLOCK_SIZE;
+    const uint64 block_idx = block_index( h );
           block_type block = vector_type( 0u );
 
     #if defined(__CUDA_ARCH__)
@@ -151,13 +186,12 @@ template <
     typename Hash2,     // second hash generator function
     typename Iterator,  // storage iterator - must be one of {uint32|uint2|uint4|uint64|uint64_2|uint64_4}
     typename OrOperator>
-template <typename Key>
-bool blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::has(const Key key) const
+bool blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::has_hashed(const uint64_2 h) const
 {
-    const uint64 h0 = m_hash1( key );
-    const uint64 h1 = m_hash2( key );
+    const uint64 h0 = h.x;
+    const uint64 h1 = h.y;
 
-    const uint64 block_idx = (h0 % m_size) / BLOCK_SIZE;
+    const uint64 block_idx = block_index( h );
     const block_type block = m_storage[block_idx];
 
     #if defined(__CUDA_ARCH__)
@@ -178,4 +212,80 @@ bool blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>::has(const Key key) c
     return true;
 }
 
+// insert a batch of keys in a blocked Bloom filter, keeping a ring of the hashes of the
+// next PREFETCH_DIST keys whose blocks have already been prefetched
+//
+template <uint32 PREFETCH_DIST, typename Hash1, typename Hash2, typename Iterator, typename OrOperator, typename KeyIterator>
+void bloom_filter_insert_batch(
+    blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>&  filter,
+    const uint32                                            n_keys,
+    const KeyIterator                                       keys)
+{
+    uint64_2 ring[PREFETCH_DIST];
+
+    // fill the prefetching window
+    const uint32 n_prologue = n_keys < PREFETCH_DIST ? n_keys : PREFETCH_DIST;
+    for (uint32 i = 0; i < n_prologue; ++i)
+    {
+        ring[i] = filter.hash( keys[i] );
+        filter.prefetch_for_insert( ring[i] );
+    }
+
+    for (uint32 i = 0; i < n_keys; ++i)
+    {
+        const uint32   slot = i % PREFETCH_DIST;
+        const uint64_2 h    = ring[slot];
+
+        // replace this key's slot with the one PREFETCH_DIST keys ahead
+        if (i + PREFETCH_DIST < n_keys)
+        {
+            ring[slot] = filter.hash( keys[i + PREFETCH_DIST] );
+            filter.prefetch_for_insert( ring[slot] );
+        }
+
+        filter.insert_hashed( h );
+    }
+}
+
+// check a batch of keys against a blocked Bloom filter, keeping a ring of the hashes of the
+// next PREFETCH_DIST keys whose blocks have already been prefetched
+//
+template <uint32 PREFETCH_DIST, typename Hash1, typename Hash2, typename Iterator, typename OrOperator, typename KeyIterator, typename OutputIterator>
+uint32 bloom_filter_has_batch(
+    const blocked_bloom_filter<Hash1,Hash2,Iterator,OrOperator>&    filter,
+    const uint32                                                    n_keys,
+    const KeyIterator                                               keys,
+          OutputIterator                                            results)
+{
+    uint64_2 ring[PREFETCH_DIST];
+
+    // fill the prefetching window
+    const uint32 n_prologue = n_keys < PREFETCH_DIST ? n_keys : PREFETCH_DIST;
+    for (uint32 i = 0; i < n_prologue; ++i)
+    {
+        ring[i] = filter.hash( keys[i] );
+        filter.prefetch( ring[i] );
+    }
+
+    uint32 n_hits = 0;
+    for (uint32 i = 0; i < n_keys; ++i)
+    {
+        const uint32   slot = i % PREFETCH_DIST;
+        const uint64_2 h    = ring[slot];
+
+        // replace this key's slot with the one PREFETCH_DIST keys ahead
+        if (i + PREFETCH_DIST < n_keys)
+        {
+            ring[slot] = filter.hash( keys[i + PREFETCH_DIST] );
+            filter.prefetch( ring[slot] );
+        }
+
+        const bool hit = filter.has_hashed( h );
+
+        results[i] = hit;
+        n_hits += hit ? 1u : 0u;
+    }
+    return n_hits;
+}
+
 } // namespace nvbio
@@ -40,7 +40,9 @@ namespace nvbio {
 ///
 /// bool acquire(const uint32 item);
 ///     try to acquire/load an element, returning false in case of failure:
-///     the latter will trigger a cache release cycle.
+///     the latter will trigger a cache release cycle. Any exception thrown
+///     by acquire() is propagated to the caller of pin(), after removing the
+///     element from the cache.
 ///
 /// void release(const uint32 item);
 ///     release an element, freeing any of the relative resources.
@@ -69,8 +69,26 @@ void LRU<CacheManager>::pin(const uint32 item)
         if (m_last == 0xFFFFFFFFu)
             m_last  = m_first;
 
-        if (m_manager->acquire( item ) == false)
-            release_cycle( item );
+        try
+        {
+            if (m_manager->acquire( item ) == false)
+                release_cycle( item );
+        }
+        catch (...)
+        {
+            // nothing could be released, or the manager failed to acquire the element:
+            // remove it from the head of the LRU list (where it's still found, as pinned
+            // elements are never released), leaving the cache consistent
+            m_first = m_cache_list[ list_idx ].m_next;
+            if (m_first != 0xFFFFFFFFu)
+                m_cache_list[ m_first ].m_prev = 0xFFFFFFFFu;
+            else
+                m_last = 0xFFFFFFFFu;
+
+            m_cache_map.erase( item );
+            m_cache_pool.push( list_idx );
+            throw;
+        }
     }
     else
     {
@@ -112,12 +130,20 @@ void LRU<CacheManager>::touch(const uint32 list_idx, List& list)
     if (list.m_next != 0xFFFFFFFFu)
     {
         List& next = m_cache_list[ list.m_next ];
-        next.m_next = list.m_prev;
+        next.m_prev = list.m_prev;
     }
     else // mark the new end of list
         m_last = list.m_prev;
 
     // re-insert at the beginning of the LRU list
+    list.m_prev = 0xFFFFFFFFu;
+    list.m_next = m_first;
+
+    if (m_first != 0xFFFFFFFFu)
+    {
+        List& first = m_cache_list[ m_first ];
+        first.m_prev = list_idx;
+    }
     m_first = list_idx;
 }
 
@@ -153,13 +179,13 @@ void LRU<CacheManager>::release_cycle(const uint32 item_to_acquire)
             List& prev = m_cache_list[ list.m_prev ];
             prev.m_next = list.m_next;
         }
-        else // mark the list as empty
-            m_first = 0xFFFFFFFFu;
+        else // mark the new beginning of list
+            m_first = list.m_next;
 
         if (list.m_next != 0xFFFFFFFFu)
         {
             List& next = m_cache_list[ list.m_next ];
-            next.m_next = list.m_prev;
+            next.m_prev = list.m_prev;
         }
         else // mark the new end of list
             m_last = list.m_prev;
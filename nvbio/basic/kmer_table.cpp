@@ -0,0 +1,443 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/basic/kmer_table.h>
+#include <nvbio/basic/system.h>
+#include <nvbio/basic/omp.h>
+#include <vector>
+
+namespace nvbio {
+
+const uint32 HostKmerTable::BUCKET_SLOTS;
+const uint32 HostKmerTable::MAX_PROBES;
+const uint64 HostKmerTable::EMPTY_KEY;
+const uint64 HostKmerTable::INVALID_SLOT;
+const uint64 HostKmerTable::BATCH_SIZE;
+
+namespace {
+
+typedef HostKmerTable::Bucket Bucket;
+
+const uint64 MIN_BUCKETS      = 64u;
+const uint64 CACHE_LINE_SIZE  = 64u;
+const uint64 COPY_BLOCK_SIZE  = 64u*1024u;   // the number of buckets assigned to each task by copy()
+
+// load a key which might be concurrently claimed by other threads
+//
+NVBIO_FORCEINLINE uint64 load_key(const uint64* key)
+{
+    return *(const volatile uint64*)key;
+}
+
+// return the first bucket of the probe sequence of a key
+//
+NVBIO_FORCEINLINE uint64 home_bucket(const uint64 key, const uint64 n_buckets)
+{
+    return hash( key ) & (n_buckets - 1u);
+}
+
+// return the number of buckets probed for each key
+//
+NVBIO_FORCEINLINE uint64 max_probes(const uint64 n_buckets)
+{
+    return nvbio::min( uint64( HostKmerTable::MAX_PROBES ), n_buckets );
+}
+
+// insert a key in a bucket array, claiming a slot with a compare-and-swap if it's not present
+//
+uint64 insert_into(Bucket* buckets, const uint64 n_buckets, const uint64 key, const uint32 count, bool& is_new)
+{
+    const uint64 mask    = n_buckets - 1u;
+    const uint64 nprobes = max_probes( n_buckets );
+
+    is_new = false;
+
+    uint64 b = home_bucket( key, n_buckets );
+    for (uint64 probe = 0; probe < nprobes; ++probe, b = (b + 1u) & mask)
+    {
+        Bucket& bucket = buckets[b];
+
+        for (uint32 s = 0; s < HostKmerTable::BUCKET_SLOTS; ++s)
+        {
+            uint64 slot_key = load_key( &bucket.keys[s] );
+
+            if (slot_key == HostKmerTable::EMPTY_KEY)
+            {
+                // try to claim this slot: if somebody else got there first, the CAS returns
+                // the key they stored, which might well be our own
+                slot_key = host_atomic_cas( &bucket.keys[s], HostKmerTable::EMPTY_KEY, key );
+                if (slot_key == HostKmerTable::EMPTY_KEY)
+                {
+                    is_new   = true;
+                    slot_key = key;
+                }
+            }
+
+            if (slot_key == key)
+            {
+                host_atomic_add( &bucket.counts[s], count );
+                return b * HostKmerTable::BUCKET_SLOTS + s;
+            }
+        }
+    }
+    return HostKmerTable::INVALID_SLOT;
+}
+
+// allocate an empty, cache-line aligned bucket array, first-touching it in parallel
+//
+Bucket* alloc_buckets(const uint64 n_buckets, void** alloc, uint64* alloc_bytes)
+{
+    *alloc_bytes = n_buckets * sizeof(Bucket) + CACHE_LINE_SIZE;
+    *alloc       = host_alloc( *alloc_bytes );
+
+    Bucket* buckets = (Bucket*)( (uint64( *alloc ) + CACHE_LINE_SIZE - 1u) & ~(CACHE_LINE_SIZE - 1u) );
+
+    #pragma omp parallel for schedule(static)
+    for (int64 b = 0; b < int64( n_buckets ); ++b)
+    {
+        for (uint32 s = 0; s < HostKmerTable::BUCKET_SLOTS; ++s)
+        {
+            buckets[b].keys[s]   = HostKmerTable::EMPTY_KEY;
+            buckets[b].counts[s] = 0u;
+        }
+        buckets[b].pad = 0u;
+    }
+    return buckets;
+}
+
+} // anonymous namespace
+
+// constructor
+//
+HostKmerTable::HostKmerTable(const uint64 n_keys, const float max_load) :
+    m_buckets( NULL ),
+    m_alloc( NULL ),
+    m_alloc_bytes( 0u ),
+    m_n_buckets( 0u ),
+    m_size( 0u ),
+    m_empty_key_used( 0u ),
+    m_empty_key_count( 0u ),
+    m_max_load( max_load )
+{
+    grow( MIN_BUCKETS );
+    reserve( n_keys );
+}
+
+// destructor
+//
+HostKmerTable::~HostKmerTable()
+{
+    if (m_alloc)
+        host_free( m_alloc, m_alloc_bytes );
+}
+
+// make room for the given number of distinct keys at the maximum load factor
+//
+void HostKmerTable::reserve(const uint64 n_keys)
+{
+    const uint64 n_slots   = uint64( double( n_keys ) / double( m_max_load ) ) + 1u;
+    const uint64 n_buckets = util::divide_ri( n_slots, uint64( BUCKET_SLOTS ) );
+
+    if (n_buckets > m_n_buckets)
+        grow( n_buckets );
+}
+
+// remove all keys, keeping the storage
+//
+void HostKmerTable::clear()
+{
+    #pragma omp parallel for schedule(static)
+    for (int64 b = 0; b < int64( m_n_buckets ); ++b)
+    {
+        for (uint32 s = 0; s < BUCKET_SLOTS; ++s)
+        {
+            m_buckets[b].keys[s]   = EMPTY_KEY;
+            m_buckets[b].counts[s] = 0u;
+        }
+    }
+    m_size            = 0u;
+    m_empty_key_used  = 0u;
+    m_empty_key_count = 0u;
+}
+
+// insert a key without updating the table size
+//
+uint64 HostKmerTable::insert_key(const uint64 key, const uint32 count, bool& is_new)
+{
+    if (key == EMPTY_KEY)
+    {
+        // the empty key gets its own slot, past all regular ones
+        is_new = host_atomic_or( &m_empty_key_used, 1u ) == 0u;
+        host_atomic_add( &m_empty_key_count, count );
+        return capacity();
+    }
+    return insert_into( m_buckets, m_n_buckets, key, count, is_new );
+}
+
+// insert a key, adding count to its occurrences
+//
+uint64 HostKmerTable::insert(const uint64 key, const uint32 count)
+{
+    bool is_new;
+    const uint64 slot = insert_key( key, count, is_new );
+    if (is_new)
+        host_atomic_add( &m_size, uint64(1u) );
+
+    return slot;
+}
+
+// find a key
+//
+uint64 HostKmerTable::find(const uint64 key) const
+{
+    if (key == EMPTY_KEY)
+        return m_empty_key_used ? capacity() : INVALID_SLOT;
+
+    const uint64 mask    = m_n_buckets - 1u;
+    const uint64 nprobes = max_probes( m_n_buckets );
+
+    uint64 b = home_bucket( key, m_n_buckets );
+    for (uint64 probe = 0; probe < nprobes; ++probe, b = (b + 1u) & mask)
+    {
+        const Bucket& bucket = m_buckets[b];
+
+        for (uint32 s = 0; s < BUCKET_SLOTS; ++s)
+        {
+            const uint64 slot_key = load_key( &bucket.keys[s] );
+
+            if (slot_key == key)
+                return b * BUCKET_SLOTS + s;
+
+            // keys are never removed, hence an empty slot ends the probe sequence
+            if (slot_key == EMPTY_KEY)
+                return INVALID_SLOT;
+        }
+    }
+    return INVALID_SLOT;
+}
+
+// return the number of occurrences of a key
+//
+uint32 HostKmerTable::count(const uint64 key) const
+{
+    const uint64 slot = find( key );
+    return slot == INVALID_SLOT ? 0u : slot_count( slot );
+}
+
+// return true if the given slot is used
+//
+bool HostKmerTable::is_used(const uint64 slot) const
+{
+    if (slot == capacity())
+        return m_empty_key_used != 0u;
+
+    return m_buckets[ slot / BUCKET_SLOTS ].keys[ slot % BUCKET_SLOTS ] != EMPTY_KEY;
+}
+
+// return the key stored in a used slot
+//
+uint64 HostKmerTable::slot_key(const uint64 slot) const
+{
+    if (slot == capacity())
+        return EMPTY_KEY;
+
+    return m_buckets[ slot / BUCKET_SLOTS ].keys[ slot % BUCKET_SLOTS ];
+}
+
+// return the count stored in a used slot
+//
+uint32 HostKmerTable::slot_count(const uint64 slot) const
+{
+    if (slot == capacity())
+        return m_empty_key_count;
+
+    return m_buckets[ slot / BUCKET_SLOTS ].counts[ slot % BUCKET_SLOTS ];
+}
+
+// grow the table to at least the given number of buckets, rehashing all keys
+//
+void HostKmerTable::grow(uint64 n_buckets)
+{
+    // round to a power of two
+    uint64 new_n_buckets = MIN_BUCKETS;
+    while (new_n_buckets < n_buckets)
+        new_n_buckets *= 2u;
+
+    if (new_n_buckets <= m_n_buckets)
+        new_n_buckets = m_n_buckets * 2u;
+
+    for (;;)
+    {
+        void*   new_alloc;
+        uint64  new_alloc_bytes;
+        Bucket* new_buckets = alloc_buckets( new_n_buckets, &new_alloc, &new_alloc_bytes );
+
+        // rehash all keys in parallel
+        uint32 failed = 0u;
+
+        #pragma omp parallel for
+        for (int64 b = 0; b < int64( m_n_buckets ); ++b)
+        {
+            const Bucket& bucket = m_buckets[b];
+            for (uint32 s = 0; s < BUCKET_SLOTS; ++s)
+            {
+                if (bucket.keys[s] == EMPTY_KEY)
+                    continue;
+
+                bool is_new;
+                if (insert_into( new_buckets, new_n_buckets, bucket.keys[s], bucket.counts[s], is_new ) == INVALID_SLOT)
+                    failed = 1u;
+            }
+        }
+
+        if (failed == 0u)
+        {
+            if (m_alloc)
+                host_free( m_alloc, m_alloc_bytes );
+
+            m_buckets     = new_buckets;
+            m_alloc       = new_alloc;
+            m_alloc_bytes = new_alloc_bytes;
+            m_n_buckets   = new_n_buckets;
+            return;
+        }
+
+        // some probe sequence overflowed even in the larger table: try again with twice as many buckets
+        host_free( new_alloc, new_alloc_bytes );
+        new_n_buckets *= 2u;
+    }
+}
+
+// retry the insertion of keys which overflowed their probe sequence, growing the table
+//
+void HostKmerTable::insert_overflows(const uint64 n_overflows, const uint64* keys, const uint32* counts)
+{
+    for (uint64 i = 0; i < n_overflows; ++i)
+    {
+        while (insert( keys[i], counts[i] ) == INVALID_SLOT)
+            grow( m_n_buckets * 2u );
+    }
+}
+
+// copy all keys and counts in slot order
+//
+uint64 HostKmerTable::copy(uint64* keys, uint32* counts) const
+{
+    const uint64 n_blocks = util::divide_ri( m_n_buckets, COPY_BLOCK_SIZE );
+
+    // count the used slots of each block of buckets
+    std::vector<uint64> offsets( n_blocks + 1u, 0u );
+
+    #pragma omp parallel for
+    for (int64 block = 0; block < int64( n_blocks ); ++block)
+    {
+        const uint64 begin = uint64( block ) * COPY_BLOCK_SIZE;
+        const uint64 end   = nvbio::min( begin + COPY_BLOCK_SIZE, m_n_buckets );
+
+        uint64 n_used = 0;
+        for (uint64 b = begin; b < end; ++b)
+        {
+            for (uint32 s = 0; s < BUCKET_SLOTS; ++s)
+                n_used += m_buckets[b].keys[s] != EMPTY_KEY ? 1u : 0u;
+        }
+        offsets[ block + 1u ] = n_used;
+    }
+
+    // turn the counts into output offsets
+    for (uint64 block = 0; block < n_blocks; ++block)
+        offsets[ block + 1u ] += offsets[ block ];
+
+    // and copy each block to its place
+    #pragma omp parallel for
+    for (int64 block = 0; block < int64( n_blocks ); ++block)
+    {
+        const uint64 begin = uint64( block ) * COPY_BLOCK_SIZE;
+        const uint64 end   = nvbio::min( begin + COPY_BLOCK_SIZE, m_n_buckets );
+
+        uint64 out = offsets[ block ];
+        for (uint64 b = begin; b < end; ++b)
+        {
+            for (uint32 s = 0; s < BUCKET_SLOTS; ++s)
+            {
+                if (m_buckets[b].keys[s] == EMPTY_KEY)
+                    continue;
+
+                if (keys)   keys[out]   = m_buckets[b].keys[s];
+                if (counts) counts[out] = m_buckets[b].counts[s];
+                ++out;
+            }
+        }
+    }
+
+    uint64 n_keys = offsets[ n_blocks ];
+
+    // append the empty key, if present
+    if (m_empty_key_used)
+    {
+        if (keys)   keys[n_keys]   = EMPTY_KEY;
+        if (counts) counts[n_keys] = m_empty_key_count;
+        ++n_keys;
+    }
+    return n_keys;
+}
+
+// compute the kmer spectrum
+//
+void HostKmerTable::spectrum(const uint32 max_count, uint64* histogram) const
+{
+    for (uint32 i = 0; i <= max_count; ++i)
+        histogram[i] = 0u;
+
+    #pragma omp parallel
+    {
+        // accumulate a private histogram
+        std::vector<uint64> local( max_count + 1u, 0u );
+
+        #pragma omp for
+        for (int64 b = 0; b < int64( m_n_buckets ); ++b)
+        {
+            for (uint32 s = 0; s < BUCKET_SLOTS; ++s)
+            {
+                if (m_buckets[b].keys[s] != EMPTY_KEY)
+                    ++local[ nvbio::min( m_buckets[b].counts[s], max_count ) ];
+            }
+        }
+
+        // and merge it
+        #pragma omp critical
+        {
+            for (uint32 i = 0; i <= max_count; ++i)
+                histogram[i] += local[i];
+        }
+    }
+
+    if (m_empty_key_used)
+        ++histogram[ nvbio::min( m_empty_key_count, max_count ) ];
+}
+
+} // namespace nvbio
@@ -0,0 +1,246 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*! \file kmer_table.h
+ *   \brief Define a concurrent open-addressing table counting and indexing kmers on the host
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/atomics.h>
+#include <nvbio/basic/numbers.h>
+
+namespace nvbio {
+
+///@addtogroup Basic
+///@{
+
+///
+/// A concurrent, open-addressing hash table mapping 64-bit kmers to 32-bit occurrence counts,
+/// which can be used to build kmer spectra and index the distinct kmers of a read set in a
+/// single streaming pass, with no global sort.
+///\par
+/// The table is made of cache-line sized buckets of BUCKET_SLOTS keys and counts: each key is
+/// hashed to a bucket, and collisions are resolved probing the following buckets linearly.
+/// Keys are claimed with a compare-and-swap and counts are updated with atomic additions, so
+/// that insert(), find() and count() can be called concurrently by any number of threads
+/// without locks; as keys are never removed, the first empty slot of a probe sequence ends it.
+///\par
+/// A single insertion fails, returning INVALID_SLOT, when it exhausts MAX_PROBES buckets; the
+/// bulk methods handle this, as well as the table load, growing and rehashing the table between
+/// batches. Growing is not thread-safe, and invalidates all previously returned slots.
+///\par
+/// Each distinct kmer is assigned a stable slot in [0,slots()) until the next growth, which can
+/// be used as a dense node identifier (e.g. to index de Bruijn graph vertices) to address
+/// arrays of per-kmer values stored alongside the table.
+///
+///\code
+/// HostKmerTable table( expected_kmers );
+///
+/// // count all kmers in parallel
+/// table.insert( n_kmers, kmers );
+///
+/// // and compute their spectrum
+/// std::vector<uint64> spectrum( 256 );
+/// table.spectrum( 255u, &spectrum[0] );
+///\endcode
+///
+struct HostKmerTable
+{
+    static const uint32 BUCKET_SLOTS = 5u;                  ///< the number of slots per bucket
+    static const uint32 MAX_PROBES   = 32u;                 ///< the maximum number of buckets probed per key
+    static const uint64 EMPTY_KEY    = ~uint64(0);          ///< the key marking empty slots, handled specially
+    static const uint64 INVALID_SLOT = ~uint64(0);          ///< the slot returned for missing keys
+    static const uint64 BATCH_SIZE   = 1024u*1024u;         ///< the number of keys inserted between table resizes
+
+    /// a cache-line sized bucket
+    ///
+    struct Bucket
+    {
+        uint64 keys[BUCKET_SLOTS];
+        uint32 counts[BUCKET_SLOTS];
+        uint32 pad;
+    };
+
+    /// constructor
+    ///
+    /// \param n_keys       the expected number of distinct keys
+    /// \param max_load     the maximum fraction of slots used before the bulk methods grow the table
+    ///
+    HostKmerTable(const uint64 n_keys = 0u, const float max_load = 0.7f);
+
+    /// destructor
+    ///
+    ~HostKmerTable();
+
+    /// make room for the given number of distinct keys at the maximum load factor;
+    /// not thread-safe
+    ///
+    void reserve(const uint64 n_keys);
+
+    /// remove all keys, keeping the storage
+    ///
+    void clear();
+
+    /// return the number of distinct keys
+    ///
+    uint64 size() const { return m_size; }
+
+    /// return the number of regular slots
+    ///
+    uint64 capacity() const { return m_n_buckets * BUCKET_SLOTS; }
+
+    /// return the total number of slots, including the one reserved to EMPTY_KEY
+    ///
+    uint64 slots() const { return capacity() + 1u; }
+
+    /// insert a key, adding count to its occurrences; thread-safe
+    ///
+    /// \return             the key's slot, or INVALID_SLOT if its probe sequence is full
+    ///
+    uint64 insert(const uint64 key, const uint32 count = 1u);
+
+    /// find a key; thread-safe
+    ///
+    /// \return             the key's slot, or INVALID_SLOT if not present
+    ///
+    uint64 find(const uint64 key) const;
+
+    /// return the number of occurrences of a key, or zero if not present; thread-safe
+    ///
+    uint32 count(const uint64 key) const;
+
+    /// return true if the given slot is used
+    ///
+    bool is_used(const uint64 slot) const;
+
+    /// return the key stored in a used slot
+    ///
+    uint64 slot_key(const uint64 slot) const;
+
+    /// return the count stored in a used slot
+    ///
+    uint32 slot_count(const uint64 slot) const;
+
+    /// insert a set of keys in parallel, growing the table as needed
+    ///
+    /// \param n_keys       the number of keys
+    /// \param keys         the keys
+    ///
+    template <typename KeyIterator>
+    void insert(const uint64 n_keys, const KeyIterator keys);
+
+    /// insert a set of weighted keys in parallel, growing the table as needed
+    ///
+    /// \param n_keys       the number of keys
+    /// \param keys         the keys
+    /// \param counts       the occurrences to add for each key
+    ///
+    template <typename KeyIterator, typename CountIterator>
+    void insert(const uint64 n_keys, const KeyIterator keys, const CountIterator counts);
+
+    /// find a set of keys in parallel
+    ///
+    /// \param n_keys       the number of keys
+    /// \param keys         the keys
+    /// \param slots        the output slots, INVALID_SLOT for missing keys
+    ///
+    template <typename KeyIterator, typename OutputIterator>
+    void find(const uint64 n_keys, const KeyIterator keys, OutputIterator slots) const;
+
+    /// count a set of keys in parallel
+    ///
+    /// \param n_keys       the number of keys
+    /// \param keys         the keys
+    /// \param counts       the output counts, zero for missing keys
+    ///
+    template <typename KeyIterator, typename OutputIterator>
+    void count(const uint64 n_keys, const KeyIterator keys, OutputIterator counts) const;
+
+    /// call a functor on all used slots in parallel, as:
+    ///
+    ///\code
+    /// functor( slot, key, count );
+    ///\endcode
+    ///
+    /// the functor must be safe to call concurrently from multiple threads
+    ///
+    template <typename Functor>
+    void for_each(const Functor& functor) const;
+
+    /// copy all keys and counts in slot order; either output can be NULL
+    ///
+    /// \return             the number of keys copied
+    ///
+    uint64 copy(uint64* keys, uint32* counts) const;
+
+    /// compute the kmer spectrum, i.e. the histogram of the counts, with all counts
+    /// greater than max_count accumulated in the last bin
+    ///
+    /// \param max_count    the last bin
+    /// \param histogram    the output histogram, of max_count+1 bins
+    ///
+    void spectrum(const uint32 max_count, uint64* histogram) const;
+
+private:
+    HostKmerTable(const HostKmerTable&);
+    HostKmerTable& operator=(const HostKmerTable&);
+
+    /// insert a key without updating the table size, which is left to the caller;
+    /// thread-safe
+    ///
+    /// \param is_new      set to true if the key was not present
+    /// \return            the key's slot, or INVALID_SLOT if its probe sequence is full
+    ///
+    uint64 insert_key(const uint64 key, const uint32 count, bool& is_new);
+
+    /// grow the table to at least the given number of buckets, rehashing all keys;
+    /// not thread-safe
+    ///
+    void grow(uint64 n_buckets);
+
+    /// retry the insertion of keys which overflowed their probe sequence, growing the table
+    ///
+    void insert_overflows(const uint64 n_overflows, const uint64* keys, const uint32* counts);
+
+    Bucket* m_buckets;
+    void*   m_alloc;
+    uint64  m_alloc_bytes;
+    uint64  m_n_buckets;
+    uint64  m_size;
+    uint32  m_empty_key_used;
+    uint32  m_empty_key_count;
+    float   m_max_load;
+};
+
+///@} Basic
+
+} // namespace nvbio
+
+#include <nvbio/basic/kmer_table_inl.h>
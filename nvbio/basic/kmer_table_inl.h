@@ -0,0 +1,147 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/omp.h>
+#include <vector>
+
+namespace nvbio {
+
+namespace detail {
+
+// a count iterator returning one for all keys
+//
+struct unit_count_iterator
+{
+    uint32 operator[] (const uint64 i) const { return 1u; }
+};
+
+} // namespace detail
+
+// insert a set of keys in parallel, growing the table as needed
+//
+template <typename KeyIterator>
+void HostKmerTable::insert(const uint64 n_keys, const KeyIterator keys)
+{
+    insert( n_keys, keys, detail::unit_count_iterator() );
+}
+
+// insert a set of weighted keys in parallel, growing the table as needed
+//
+template <typename KeyIterator, typename CountIterator>
+void HostKmerTable::insert(const uint64 n_keys, const KeyIterator keys, const CountIterator counts)
+{
+    std::vector<uint64> overflow_keys;
+    std::vector<uint32> overflow_counts;
+
+    for (uint64 batch_begin = 0; batch_begin < n_keys; batch_begin += BATCH_SIZE)
+    {
+        const uint64 batch_end = nvbio::min( batch_begin + BATCH_SIZE, n_keys );
+
+        // make sure the table stays below its maximum load even if all keys are new
+        reserve( m_size + (batch_end - batch_begin) );
+
+        // count the new keys per thread, rather than contending for the table size
+        uint64 n_new = 0;
+
+        #pragma omp parallel for reduction(+:n_new)
+        for (int64 i = int64( batch_begin ); i < int64( batch_end ); ++i)
+        {
+            const uint64 key   = keys[i];
+            const uint32 count = counts[i];
+
+            bool is_new;
+            if (insert_key( key, count, is_new ) != INVALID_SLOT)
+                n_new += is_new ? 1u : 0u;
+            else
+            {
+                // this key's probe sequence is full: save it for later (this is rare enough
+                // not to require anything smarter than a critical section)
+                #pragma omp critical
+                {
+                    overflow_keys.push_back( key );
+                    overflow_counts.push_back( count );
+                }
+            }
+        }
+
+        m_size += n_new;
+
+        if (overflow_keys.size())
+        {
+            insert_overflows( overflow_keys.size(), &overflow_keys[0], &overflow_counts[0] );
+
+            overflow_keys.clear();
+            overflow_counts.clear();
+        }
+    }
+}
+
+// find a set of keys in parallel
+//
+template <typename KeyIterator, typename OutputIterator>
+void HostKmerTable::find(const uint64 n_keys, const KeyIterator keys, OutputIterator slots) const
+{
+    #pragma omp parallel for
+    for (int64 i = 0; i < int64( n_keys ); ++i)
+        slots[i] = find( keys[i] );
+}
+
+// count a set of keys in parallel
+//
+template <typename KeyIterator, typename OutputIterator>
+void HostKmerTable::count(const uint64 n_keys, const KeyIterator keys, OutputIterator counts) const
+{
+    #pragma omp parallel for
+    for (int64 i = 0; i < int64( n_keys ); ++i)
+        counts[i] = count( keys[i] );
+}
+
+// call a functor on all used slots in parallel
+//
+template <typename Functor>
+void HostKmerTable::for_each(const Functor& functor) const
+{
+    #pragma omp parallel for
+    for (int64 b = 0; b < int64( m_n_buckets ); ++b)
+    {
+        const Bucket& bucket = m_buckets[b];
+        for (uint32 s = 0; s < BUCKET_SLOTS; ++s)
+        {
+            if (bucket.keys[s] != EMPTY_KEY)
+                functor( uint64(b) * BUCKET_SLOTS + s, bucket.keys[s], bucket.counts[s] );
+        }
+    }
+
+    // and finally the slot reserved to EMPTY_KEY
+    if (m_empty_key_used)
+        functor( capacity(), EMPTY_KEY, m_empty_key_count );
+}
+
+} // namespace nvbio
@@ -27,6 +27,7 @@
 
 #include <nvbio/basic/mmap.h>
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/numbers.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -48,10 +49,11 @@ struct MappedFile::Impl
 };
 struct ServerMappedFile::Impl
 {
-    Impl() : h_file( INVALID_HANDLE_VALUE ), buffer( NULL ) {} 
+    Impl() : h_file( INVALID_HANDLE_VALUE ), buffer( NULL ), file_size( 0 ) {} 
 
     HANDLE h_file;
     void*  buffer;
+    uint64 file_size;
 };
 
 MappedFile::MappedFile() : impl( new Impl() ) {}
@@ -97,6 +99,12 @@ MappedFile::~MappedFile()
 
 ServerMappedFile::ServerMappedFile() : impl( new Impl() ) {}
 
+// huge pages and NUMA placement are not supported on Windows
+void ServerMappedFile::set_options(const MappingOptions& options) {}
+void ServerMappedFile::replicate() {}
+
+uint64 ServerMappedFile::size() const { return impl->file_size; }
+
 void* ServerMappedFile::init(const char* name, const uint64 file_size, const void* src)
 {
     std::string sname = std::string("Global\\") + std::string( name );
@@ -131,6 +139,8 @@ void* ServerMappedFile::init(const char* name, const uint64 file_size, const voi
     if (src != NULL)
         CopyMemory( impl->buffer, src, file_size );
 
+    impl->file_size = file_size;
+
     log_verbose(stderr, "created file mapping object \"%s\" (%.2f %s)\n", name, (file_size > 1024*1024 ? float(file_size)/float(1024*1024) : float(file_size)), (file_size > 1024*1024 ? "MB" : "B"));
     return impl->buffer;
 }
@@ -142,6 +152,52 @@ ServerMappedFile::~ServerMappedFile()
     delete impl;
 }
 
+struct MappedDiskFile::Impl
+{
+    Impl() : h_file( INVALID_HANDLE_VALUE ), h_mapping( NULL ), buffer( NULL ), file_size( 0 ) {}
+
+    HANDLE h_file;
+    HANDLE h_mapping;
+    void*  buffer;
+    uint64 file_size;
+};
+
+MappedDiskFile::MappedDiskFile() : impl( new Impl() ) {}
+
+const void* MappedDiskFile::init(const char* file_name)
+{
+    impl->h_file = CreateFileA( file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if (impl->h_file == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx( impl->h_file, &file_size ) == FALSE || file_size.QuadPart == 0)
+        return NULL;
+
+    impl->file_size = uint64( file_size.QuadPart );
+
+    impl->h_mapping = CreateFileMapping( impl->h_file, NULL, PAGE_READONLY, 0, 0, NULL );
+    if (impl->h_mapping == NULL)
+        return NULL;
+
+    impl->buffer = MapViewOfFile( impl->h_mapping, FILE_MAP_READ, 0, 0, 0 );
+    return impl->buffer;
+}
+
+void MappedDiskFile::advise_sequential() {}
+
+const void* MappedDiskFile::data() const { return impl->buffer; }
+uint64      MappedDiskFile::size() const { return impl->file_size; }
+
+MappedDiskFile::~MappedDiskFile()
+{
+    if (impl->buffer != NULL)                 UnmapViewOfFile( impl->buffer );
+    if (impl->h_mapping != NULL)              CloseHandle( impl->h_mapping );
+    if (impl->h_file != INVALID_HANDLE_VALUE) CloseHandle( impl->h_file );
+
+    delete impl;
+}
+
 } // namespace nvbio
 
 #else
@@ -156,27 +212,236 @@ ServerMappedFile::~ServerMappedFile()
 #include <errno.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/syscall.h>
+#include <vector>
 
 namespace nvbio {
 
-struct MappedFile::Impl
+namespace {
+
+static const int NVBIO_MPOL_BIND       = 2;     // as in linux/mempolicy.h
+static const int NVBIO_MPOL_INTERLEAVE = 3;
+
+// a single shared segment
+//
+struct Segment
 {
-    Impl() : h_file( -1 ), buffer( NULL ) {} 
+    Segment() : h_file( -1 ), buffer( NULL ), size( 0 ), hugetlbfs( false ) {}
 
     int         h_file;
     void*       buffer;
+    uint64      size;
+    std::string name;
     std::string file_name;
-    uint64      file_size;
+    bool        hugetlbfs;
 };
-struct ServerMappedFile::Impl
+
+// the record published in POSIX shared memory next to each segment, telling clients
+// where the segment's contents actually live
+//
+struct SegmentLocator
+{
+    static const uint32 MAGIC = 0x4c53564eu;    // "NVSL"
+
+    uint32 magic;
+    uint32 hugetlbfs;
+    char   path[1024];
+};
+
+// return the name of the locator of a segment
+//
+std::string locator_name(const std::string& name) { return name + std::string( ".backing" ); }
+
+// return the number of configured NUMA nodes
+//
+uint32 numa_node_count()
+{
+    uint32 n_nodes = 0;
+    for (; n_nodes < 64; ++n_nodes)
+    {
+        char path[64];
+        sprintf( path, "/sys/devices/system/node/node%u", n_nodes );
+        if (access( path, F_OK ) != 0)
+            break;
+    }
+    return n_nodes ? n_nodes : 1u;
+}
+
+// return the NUMA node the calling thread is running on
+//
+uint32 numa_local_node()
+{
+#if defined(SYS_getcpu)
+    unsigned cpu, node;
+    if (syscall( SYS_getcpu, &cpu, &node, NULL ) == 0)
+        return node;
+#endif
+    return 0u;
+}
+
+// set the NUMA memory policy of a mapped range; must be called before its pages are touched
+//
+void numa_policy(void* buffer, const uint64 size, const int mode, const uint64 node_mask)
+{
+#if defined(SYS_mbind)
+    unsigned long mask = (unsigned long)node_mask;
+    if (syscall( SYS_mbind, buffer, size, mode, &mask, 65ul, 0u ) != 0)
+        log_warning(stderr, "mbind() failed (error %d), using default NUMA placement\n", errno);
+#endif
+}
+
+// return the size of a page
+//
+uint64 page_bytes(const MappingOptions::PageSize page_size)
+{
+    return page_size == MappingOptions::HUGE_PAGES_1GB ? uint64(1u) << 30 :
+           page_size == MappingOptions::HUGE_PAGES_2MB ? uint64(1u) << 21 :
+                                                         uint64( sysconf( _SC_PAGESIZE ) );
+}
+
+// return the hugetlbfs mount point to use for a given page size
+//
+std::string hugetlbfs_dir(const MappingOptions& options)
+{
+    if (options.hugetlbfs_path)
+        return std::string( options.hugetlbfs_path );
+
+    const char* env = getenv( "NVBIO_HUGETLBFS" );
+    if (env)
+        return std::string( env );
+
+    return options.page_size == MappingOptions::HUGE_PAGES_1GB ?
+        std::string( "/dev/hugepages1G" ) :
+        std::string( "/dev/hugepages" );
+}
+
+// create a segment, either in POSIX shared memory or on hugetlbfs
+//
+void create_segment(Segment& segment, const std::string& name, const uint64 file_size, const MappingOptions& options)
+{
+    const uint64 page_size = page_bytes( options.page_size );
+
+    segment.name      = name;
+    segment.hugetlbfs = options.page_size != MappingOptions::DEFAULT_PAGES;
+    segment.file_name = segment.hugetlbfs ? hugetlbfs_dir( options ) + name : name;
+    segment.size      = segment.hugetlbfs ? util::round_i( file_size, page_size ) : file_size;
+    segment.h_file    = segment.hugetlbfs ?
+        open( segment.file_name.c_str(), O_RDWR | O_CREAT, S_IRWXU ) :
+        shm_open( segment.file_name.c_str(), O_RDWR | O_CREAT, S_IRWXU );
+
+    if (segment.h_file == -1)
+        throw ServerMappedFile::mapping_error( segment.file_name.c_str(), errno );
+
+    if (ftruncate( segment.h_file, segment.size ) != 0)
+        throw ServerMappedFile::mapping_error( segment.file_name.c_str(), errno );
+
+    segment.buffer = mmap(
+        NULL,
+        segment.size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        segment.h_file,
+        0 );
+
+    if (segment.buffer == MAP_FAILED)
+    {
+        segment.buffer = NULL;
+        throw ServerMappedFile::view_error( segment.file_name.c_str(), errno );
+    }
+
+    // publish the chosen backing, replacing any stale locator left behind by a previous run
+    SegmentLocator locator;
+    memset( &locator, 0, sizeof(SegmentLocator) );
+    locator.magic     = SegmentLocator::MAGIC;
+    locator.hugetlbfs = segment.hugetlbfs ? 1u : 0u;
+
+    if (segment.file_name.length() >= sizeof(locator.path))
+        throw ServerMappedFile::mapping_error( segment.file_name.c_str(), ENAMETOOLONG );
+
+    strcpy( locator.path, segment.file_name.c_str() );
+
+    const int h_locator = shm_open( locator_name( name ).c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRWXU );
+    if (h_locator == -1)
+        throw ServerMappedFile::mapping_error( segment.file_name.c_str(), errno );
+
+    const bool written = write( h_locator, &locator, sizeof(SegmentLocator) ) == ssize_t( sizeof(SegmentLocator) );
+    const int  code    = errno;
+    close( h_locator );
+
+    if (written == false)
+        throw ServerMappedFile::mapping_error( segment.file_name.c_str(), code );
+}
+
+// release a segment created by create_segment()
+//
+void destroy_segment(Segment& segment)
+{
+    if (segment.buffer != NULL) munmap( segment.buffer, segment.size );
+    if (segment.h_file != -1)
+    {
+        close( segment.h_file );
+        if (segment.hugetlbfs)
+            unlink( segment.file_name.c_str() );
+        else
+            shm_unlink( segment.file_name.c_str() );
+
+        shm_unlink( locator_name( segment.name ).c_str() );
+    }
+}
+
+// open an existing segment, following its locator to the exact backing chosen by the server,
+// so that stale files from previous runs can never shadow the live segment
+//
+int open_segment(const std::string& name)
+{
+    const int h_locator = shm_open( locator_name( name ).c_str(), O_RDONLY, S_IRWXU );
+    if (h_locator == -1)
+        return -1;
+
+    SegmentLocator locator;
+    const bool read_ok = read( h_locator, &locator, sizeof(SegmentLocator) ) == ssize_t( sizeof(SegmentLocator) );
+    close( h_locator );
+
+    if (read_ok == false ||
+        locator.magic != SegmentLocator::MAGIC ||
+        memchr( locator.path, '\0', sizeof(locator.path) ) == NULL)
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    return locator.hugetlbfs ?
+        open( locator.path, O_RDONLY ) :
+        shm_open( name.c_str(), O_RDONLY, S_IRWXU );
+}
+
+// return the name of the replica of a segment on a given NUMA node
+//
+std::string replica_name(const std::string& name, const uint32 node)
+{
+    char suffix[32];
+    sprintf( suffix, ".numa%u", node );
+    return name + std::string( suffix );
+}
+
+} // anonymous namespace
+
+struct MappedFile::Impl
 {
     Impl() : h_file( -1 ), buffer( NULL ) {} 
 
-    int    h_file;
-    void*  buffer;
+    int         h_file;
+    void*       buffer;
     std::string file_name;
     uint64      file_size;
 };
+struct ServerMappedFile::Impl
+{
+    MappingOptions       options;
+    std::string          file_name;
+    uint64               file_size;
+    std::vector<Segment> segments;          // the primary segment, followed by the replicas
+};
 
 MappedFile::MappedFile() : impl( new Impl() ) {}
 
@@ -184,26 +449,36 @@ void* MappedFile::init(const char* name, const uint64 file_size)
 {
     impl->file_name = std::string("/") + std::string(name);
     impl->file_size = file_size;
-    impl->h_file = shm_open(
-        impl->file_name.c_str(),
-        O_RDONLY,
-        S_IRWXU );
+
+    // look for the replica local to our NUMA node first, and fall back to the primary copy
+    const uint32 node = numa_local_node();
+    if (node)
+        impl->h_file = open_segment( replica_name( impl->file_name, node ) );
+
+    if (impl->h_file == -1)
+        impl->h_file = open_segment( impl->file_name );
 
     if (impl->h_file == -1)
         throw mapping_error( impl->file_name.c_str(), errno );
 
-    ftruncate( impl->h_file, file_size );
+    // segments on hugetlbfs are rounded up to a multiple of the page size
+    struct stat file_stat;
+    if (fstat( impl->h_file, &file_stat ) == 0 && uint64( file_stat.st_size ) > file_size)
+        impl->file_size = uint64( file_stat.st_size );
 
     impl->buffer = mmap(
         NULL,
-        file_size,
+        impl->file_size,
         PROT_READ,
         MAP_SHARED,
         impl->h_file,
         0 );
 
-    if (impl->buffer == NULL)
+    if (impl->buffer == MAP_FAILED)
+    {
+        impl->buffer = NULL;
         throw view_error( impl->file_name.c_str(), errno );
+    }
 
     log_verbose(stderr, "created file mapping object \"%s\" (%.2f %s)\n", name, (file_size > 1024*1024 ? float(file_size)/float(1024*1024) : float(file_size)), (file_size > 1024*1024 ? "MB" : "B"));
     return impl->buffer;
@@ -211,6 +486,7 @@ void* MappedFile::init(const char* name, const uint64 file_size)
 MappedFile::~MappedFile()
 {
     if (impl->buffer != NULL) munmap( impl->buffer, impl->file_size );
+    if (impl->h_file != -1)   close( impl->h_file );
     //if (impl->h_file != -1)   shm_unlink( impl->file_name.c_str() );
 
     delete impl;
@@ -218,41 +494,128 @@ MappedFile::~MappedFile()
 
 ServerMappedFile::ServerMappedFile() : impl( new Impl() ) {}
 
+// set the mapping options
+//
+void ServerMappedFile::set_options(const MappingOptions& options) { impl->options = options; }
+
 void* ServerMappedFile::init(const char* name, const uint64 file_size, const void* src)
 {
     impl->file_name = std::string("/") + std::string(name);
     impl->file_size = file_size;
-    impl->h_file = shm_open(
-        impl->file_name.c_str(),
-        O_RDWR | O_CREAT,
-        S_IRWXU );
 
-    if (impl->h_file == -1)
-        throw mapping_error( impl->file_name.c_str(), errno );
+    impl->segments.resize( 1u );
 
-    ftruncate( impl->h_file, file_size );
-
-    impl->buffer = mmap(
-        NULL,
-        file_size,
-        PROT_READ | PROT_WRITE,
-        MAP_SHARED,
-        impl->h_file,
-        0 );
+    Segment& segment = impl->segments[0];
+    create_segment( segment, impl->file_name, file_size, impl->options );
 
-    if (impl->buffer == NULL)
-        throw view_error( impl->file_name.c_str(), errno );
+    // set the NUMA policy before any page gets touched
+    const uint32 n_nodes = numa_node_count();
+    if (n_nodes > 1u)
+    {
+        if (impl->options.numa_policy == MappingOptions::NUMA_INTERLEAVE)
+            numa_policy( segment.buffer, segment.size, NVBIO_MPOL_INTERLEAVE, n_nodes < 64u ? (uint64(1u) << n_nodes) - 1u : ~uint64(0u) );
+        else if (impl->options.numa_policy == MappingOptions::NUMA_REPLICATE)
+            numa_policy( segment.buffer, segment.size, NVBIO_MPOL_BIND, 1u );
+    }
 
     if (src != NULL)
-        memcpy( impl->buffer, src, file_size );
+        memcpy( segment.buffer, src, file_size );
 
     log_verbose(stderr, "created file mapping object \"%s\" (%.2f %s)\n", name, (file_size > 1024*1024 ? float(file_size)/float(1024*1024) : float(file_size)), (file_size > 1024*1024 ? "MB" : "B"));
-    return impl->buffer;
+    return segment.buffer;
+}
+
+// publish a copy of the mapped contents on each NUMA node
+//
+void ServerMappedFile::replicate()
+{
+    if (impl->options.numa_policy != MappingOptions::NUMA_REPLICATE ||
+        impl->segments.size() != 1u)
+        return;
+
+    // the primary copy lives on node 0, the replicas on all the others
+    const uint32 n_nodes = numa_node_count();
+    for (uint32 node = 1; node < n_nodes; ++node)
+    {
+        impl->segments.push_back( Segment() );
+
+        Segment& replica = impl->segments.back();
+        create_segment( replica, replica_name( impl->file_name, node ), impl->file_size, impl->options );
+        numa_policy( replica.buffer, replica.size, NVBIO_MPOL_BIND, uint64(1u) << node );
+
+        memcpy( replica.buffer, impl->segments[0].buffer, impl->file_size );
+    }
+    if (n_nodes > 1u)
+        log_verbose(stderr, "replicated file mapping object \"%s\" on %u NUMA nodes\n", impl->file_name.c_str(), n_nodes);
 }
+
+// return the total number of bytes mapped by this object, including all replicas
+//
+uint64 ServerMappedFile::size() const
+{
+    uint64 bytes = 0;
+    for (uint32 i = 0; i < impl->segments.size(); ++i)
+        bytes += impl->segments[i].size;
+    return bytes;
+}
+
 ServerMappedFile::~ServerMappedFile()
+{
+    for (uint32 i = 0; i < impl->segments.size(); ++i)
+        destroy_segment( impl->segments[i] );
+
+    delete impl;
+}
+
+struct MappedDiskFile::Impl
+{
+    Impl() : buffer( NULL ), file_size( 0 ) {}
+
+    void*  buffer;
+    uint64 file_size;
+};
+
+MappedDiskFile::MappedDiskFile() : impl( new Impl() ) {}
+
+const void* MappedDiskFile::init(const char* file_name)
+{
+    const int h_file = open( file_name, O_RDONLY );
+    if (h_file == -1)
+        return NULL;
+
+    struct stat file_stat;
+    if (fstat( h_file, &file_stat ) != 0 || file_stat.st_size == 0)
+    {
+        close( h_file );
+        return NULL;
+    }
+    impl->file_size = uint64( file_stat.st_size );
+
+    // the mapping keeps its own reference to the file, so that we can close it right away
+    void* buffer = mmap( NULL, impl->file_size, PROT_READ, MAP_PRIVATE, h_file, 0 );
+    close( h_file );
+
+    if (buffer == MAP_FAILED)
+        return NULL;
+
+    impl->buffer = buffer;
+
+    log_verbose(stderr, "mapped file \"%s\" (%.2f MB)\n", file_name, float(impl->file_size)/float(1024*1024));
+    return impl->buffer;
+}
+
+void MappedDiskFile::advise_sequential()
+{
+    if (impl->buffer)
+        madvise( impl->buffer, impl->file_size, MADV_SEQUENTIAL );
+}
+
+const void* MappedDiskFile::data() const { return impl->buffer; }
+uint64      MappedDiskFile::size() const { return impl->file_size; }
+
+MappedDiskFile::~MappedDiskFile()
 {
     if (impl->buffer != NULL) munmap( impl->buffer, impl->file_size );
-    if (impl->h_file != -1)   shm_unlink( impl->file_name.c_str() );
 
     delete impl;
 }
@@ -39,6 +39,7 @@ namespace nvbio {
 ///
 /// - MappedFile
 /// - ServerMappedFile
+/// - MappedDiskFile
 ///
 /// \section MMAPExampleSection Example
 ///
@@ -74,6 +75,24 @@ namespace nvbio {
 /// }
 ///\endcode
 ///
+/// On Linux, the server can also back its segments with huge pages and control their
+/// NUMA placement, either interleaving their pages across all nodes or replicating
+/// them on each node; clients will automatically pick the replica local to the
+/// node they are running on:
+///\code
+/// MappingOptions options;
+/// options.page_size   = MappingOptions::HUGE_PAGES_2MB;
+/// options.numa_policy = MappingOptions::NUMA_REPLICATE;
+///
+/// ServerMappedFile* mapped_file = new ServerMappedFile();
+/// mapped_file->set_options( options );
+/// void* buffer = mapped_file->init("my_file", 100*1024*1024, NULL);
+/// fill( buffer );
+///
+/// // publish a copy of the contents on each NUMA node
+/// mapped_file->replicate();
+///\endcode
+///
 /// \section TechnicalOverviewSection Technical Overview
 ///
 /// See the \ref MemoryMappingModule module documentation.
@@ -86,6 +105,36 @@ namespace nvbio {
 /// This module implements basic server-client memory mapping functionality
 ///@{
 
+///
+/// Options controlling the backing store of a ServerMappedFile.
+/// Huge pages are allocated from a hugetlbfs mount point, so that segments can be shared
+/// by name: the server publishes the backing of each segment in a small POSIX shared memory
+/// record, which clients follow to open exactly the live segment.
+///
+struct MappingOptions
+{
+    enum PageSize
+    {
+        DEFAULT_PAGES   = 0,    ///< regular pages from POSIX shared memory
+        HUGE_PAGES_2MB  = 1,    ///< 2MB huge pages
+        HUGE_PAGES_1GB  = 2,    ///< 1GB huge pages
+    };
+    enum NumaPolicy
+    {
+        NUMA_DEFAULT    = 0,    ///< use the default first-touch placement
+        NUMA_INTERLEAVE = 1,    ///< interleave pages across all NUMA nodes
+        NUMA_REPLICATE  = 2,    ///< keep one replica per NUMA node
+    };
+
+    /// constructor
+    ///
+    MappingOptions() : page_size( DEFAULT_PAGES ), numa_policy( NUMA_DEFAULT ), hugetlbfs_path( NULL ) {}
+
+    PageSize    page_size;          ///< the page size backing the segments
+    NumaPolicy  numa_policy;        ///< the NUMA placement policy
+    const char* hugetlbfs_path;     ///< the hugetlbfs mount point; if NULL, use the default for the page size
+};
+
 ///
 /// A class to map a memory object into a client process.
 /// See ServerMappedFile.
@@ -154,14 +203,66 @@ struct ServerMappedFile
     ///
     ~ServerMappedFile();
 
+    /// set the mapping options; must be called before init()
+    ///
+    void set_options(const MappingOptions& options);
+
     /// initialize the memory mapped file
     void* init(const char* name, const uint64 file_size, const void* src);
 
+    /// publish a copy of the mapped contents on each NUMA node if MappingOptions::NUMA_REPLICATE
+    /// was requested, and do nothing otherwise; must be called after the contents have been written
+    ///
+    void replicate();
+
+    /// return the total number of bytes mapped by this object, including all replicas
+    ///
+    uint64 size() const;
+
 private:
     struct Impl;
     Impl* impl;
 };
 
+///
+/// A class to map a regular file on disk read-only into the address space of the calling process,
+/// so that its contents are paged in on demand rather than copied.
+/// The mapping is released when the destructor is called.
+///
+struct MappedDiskFile
+{
+    /// constructor
+    ///
+    MappedDiskFile();
+
+    /// destructor
+    ///
+    ~MappedDiskFile();
+
+    /// map the given file, returning a pointer to its contents or NULL on failure
+    ///
+    const void* init(const char* file_name);
+
+    /// hint the kernel that the mapped contents will be read sequentially
+    ///
+    void advise_sequential();
+
+    /// return the mapped contents
+    ///
+    const void* data() const;
+
+    /// return the size of the mapped file
+    ///
+    uint64 size() const;
+
+private:
+    MappedDiskFile(const MappedDiskFile&);
+    MappedDiskFile& operator=(const MappedDiskFile&);
+
+    struct Impl;
+    Impl* impl;
+};
+
 ///@} MemoryMappingModule
 ///@} Basic
 
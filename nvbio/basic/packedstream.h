@@ -60,6 +60,9 @@ namespace nvbio {
 ///                              different memory spaces (e.g. local memory)
 /// - ForwardPackedStream :      a forward packed stream iterator
 ///
+/// Bulk host-side conversions between packed streams, e.g. packed_repack(), packed_reverse_complement(),
+/// packed_widen() and packed_narrow(), which work on whole words at a time, are available in packedstream_transcode.h.
+///
 /// \section ExampleSection Example
 ///
 ///\code
@@ -1132,8 +1132,9 @@ void serial_assign(
         // fetch the word in question
         word_type word = words[ stream_offset / SYMBOLS_PER_WORD ];
 
-        // loop through the word's bp's
-        for (uint32 i = 0; i < word_rem; ++i)
+        // loop through the word's bp's, without going past the end of the input
+        const uint32 n_symbols = uint32( nvbio::min( IndexType( word_rem ), input_len ) );
+        for (uint32 i = 0; i < n_symbols; ++i)
         {
             // fetch the bp
             const uint8 bp = input_string[i] & SYMBOL_MASK;
@@ -1268,8 +1269,9 @@ void assign_kernel(
         // fetch the word in question
         word_type word = words[ stream_offset / SYMBOLS_PER_WORD ];
 
-        // loop through the word's bp's
-        for (uint32 i = 0; i < word_rem; ++i)
+        // loop through the word's bp's, without going past the end of the input
+        const uint32 n_symbols = uint32( nvbio::min( IndexType( word_rem ), input_len ) );
+        for (uint32 i = 0; i < n_symbols; ++i)
         {
             // fetch the bp
             const uint8 bp = input_string[i] & SYMBOL_MASK;
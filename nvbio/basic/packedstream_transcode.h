@@ -0,0 +1,138 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/packedstream.h>
+
+namespace nvbio {
+
+///@addtogroup Basic
+///@{
+
+///@addtogroup PackedStreams
+///@{
+
+///\par
+/// The functions in this module are bulk, host-side counterparts of assign() for converting a
+/// range of a PackedStream into another one.
+/// Rather than going symbol by symbol through the PackedStream accessors, they extract whole
+/// 32-bit words of symbols at a time with funnel shifts, and transform them with bitwise
+/// (or, when compiled with SSSE3 support, 128-bit shuffle) operations, spreading the work across
+/// all available OpenMP threads for large ranges.
+///\par
+/// All functions work on streams whose underlying storage is a raw pointer to either uint32 or
+/// uint8 words, in any endianness, and at any symbol offset; the input and output ranges must
+/// not overlap. Only the symbols within the output range are modified.
+///
+
+/// copy a packed stream range into another one with the same symbol size, converting
+/// between word types and endianness (e.g. to turn byte-packed .pac files into uint32 streams
+/// and back)
+///
+/// \param n        the number of symbols to copy
+/// \param in       the input stream
+/// \param out      the output stream
+///
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol, uint32 SYMBOL_SIZE_T,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_repack(
+    const IndexType                                                              n,
+    const PackedStream<InputStorage,Symbol,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,IndexType>    in,
+          PackedStream<OutputStorage,Symbol,SYMBOL_SIZE_T,OUT_BIG_ENDIAN_T,IndexType>  out);
+
+/// reverse a packed stream range into another one with the same symbol size, i.e.
+/// out[i] = in[n-1-i]
+///
+/// \param n        the number of symbols to copy
+/// \param in       the input stream
+/// \param out      the output stream
+///
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol, uint32 SYMBOL_SIZE_T,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_reverse(
+    const IndexType                                                              n,
+    const PackedStream<InputStorage,Symbol,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,IndexType>    in,
+          PackedStream<OutputStorage,Symbol,SYMBOL_SIZE_T,OUT_BIG_ENDIAN_T,IndexType>  out);
+
+/// reverse-complement a DNA (2-bit) or DNA_N (4-bit) packed stream range into another one
+/// with the same symbol size; in the DNA_N case, symbols other than A,C,G,T are left unchanged
+///
+/// \param n        the number of symbols to copy
+/// \param in       the input stream
+/// \param out      the output stream
+///
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol, uint32 SYMBOL_SIZE_T,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_reverse_complement(
+    const IndexType                                                              n,
+    const PackedStream<InputStorage,Symbol,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,IndexType>    in,
+          PackedStream<OutputStorage,Symbol,SYMBOL_SIZE_T,OUT_BIG_ENDIAN_T,IndexType>  out);
+
+/// widen a 2-bit DNA packed stream range into a 4-bit DNA_N one
+///
+/// \param n        the number of symbols to copy
+/// \param in       the 2-bit input stream
+/// \param out      the 4-bit output stream
+///
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_widen(
+    const IndexType                                                      n,
+    const PackedStream<InputStorage,Symbol,2u,IN_BIG_ENDIAN_T,IndexType>       in,
+          PackedStream<OutputStorage,Symbol,4u,OUT_BIG_ENDIAN_T,IndexType>     out);
+
+/// narrow a 4-bit DNA_N packed stream range into a 2-bit DNA one, replacing all
+/// symbols other than A,C,G,T (i.e. N's) with the given one
+///
+/// \param n        the number of symbols to copy
+/// \param in       the 4-bit input stream
+/// \param out      the 2-bit output stream
+/// \param n_symbol the 2-bit symbol replacing N's
+/// \return         the number of replaced symbols
+///
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+uint64 packed_narrow(
+    const IndexType                                                      n,
+    const PackedStream<InputStorage,Symbol,4u,IN_BIG_ENDIAN_T,IndexType>       in,
+          PackedStream<OutputStorage,Symbol,2u,OUT_BIG_ENDIAN_T,IndexType>     out,
+    const uint8                                                          n_symbol = 0u);
+
+///@} PackedStreams
+///@} Basic
+
+} // namespace nvbio
+
+#include <nvbio/basic/packedstream_transcode_inl.h>
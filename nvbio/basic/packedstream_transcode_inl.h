@@ -0,0 +1,791 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/popcount.h>
+#include <nvbio/basic/omp.h>
+#include <iterator>
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+#if defined(BIG_ENDIAN)
+#undef BIG_ENDIAN
+#endif
+
+namespace nvbio {
+namespace priv {
+
+// the number of output words processed by each task
+const uint64 PACKED_TRANSCODE_BLOCK_SIZE = 4096u;
+
+// the number of symbols above which transcoding is spread across threads
+const uint64 PACKED_TRANSCODE_PARALLEL_THRESHOLD = 1000000u;
+
+// floor division of a (possibly negative) symbol position by a positive word size
+//
+NVBIO_FORCEINLINE int64 floor_div(const int64 x, const int64 d)
+{
+    return x >= 0 ? x / d : -((-x + d - 1) / d);
+}
+
+// a mask covering the bits [begin,end) of a 32-bit word
+//
+NVBIO_FORCEINLINE uint32 bit_range_mask(const uint32 begin, const uint32 end)
+{
+    const uint32 hi = end   >= 32u ? 0xFFFFFFFFu : (1u << end)   - 1u;
+    const uint32 lo = begin >= 32u ? 0xFFFFFFFFu : (1u << begin) - 1u;
+    return hi & ~lo;
+}
+
+// a mask covering the symbols [begin,end) of a 32-bit word
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+NVBIO_FORCEINLINE uint32 symbol_range_mask(const uint32 begin, const uint32 end)
+{
+    return BIG_ENDIAN ?
+        bit_range_mask( 32u - end * SYMBOL_SIZE, 32u - begin * SYMBOL_SIZE ) :
+        bit_range_mask( begin * SYMBOL_SIZE, end * SYMBOL_SIZE );
+}
+
+// reverse the bytes of a 32-bit word
+//
+NVBIO_FORCEINLINE uint32 byte_swap(const uint32 x)
+{
+    return (x >> 24) | ((x >> 8) & 0x0000FF00u) | ((x << 8) & 0x00FF0000u) | (x << 24);
+}
+
+// reverse the order of the symbols packed in a 32-bit word
+//
+template <uint32 SYMBOL_SIZE> uint32 reverse_symbols(const uint32 x);
+
+template <> NVBIO_FORCEINLINE uint32 reverse_symbols<8u>(const uint32 x) { return byte_swap( x ); }
+template <> NVBIO_FORCEINLINE uint32 reverse_symbols<4u>(const uint32 x)
+{
+    return byte_swap( ((x >> 4) & 0x0F0F0F0Fu) | ((x & 0x0F0F0F0Fu) << 4) );
+}
+template <> NVBIO_FORCEINLINE uint32 reverse_symbols<2u>(uint32 x)
+{
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    return reverse_symbols<4u>( x );
+}
+
+// complement the DNA symbols packed in a 32-bit word, leaving anything but A,C,G,T unchanged
+//
+template <uint32 SYMBOL_SIZE> uint32 complement_symbols(const uint32 x);
+
+template <> NVBIO_FORCEINLINE uint32 complement_symbols<2u>(const uint32 x) { return ~x; }
+template <> NVBIO_FORCEINLINE uint32 complement_symbols<4u>(const uint32 x)
+{
+    // flag the nibbles >= 4, i.e. N's and friends, and flip the two low bits of all others
+    const uint32 n_flags = ((x >> 2) | (x >> 3)) & 0x11111111u;
+    return x ^ ((~n_flags & 0x11111111u) * 3u);
+}
+
+// spread the 8 little-endian 2-bit symbols in the low half of x to 4-bits
+//
+NVBIO_FORCEINLINE uint32 widen_symbols(uint32 x)
+{
+    x &= 0x0000FFFFu;
+    x = (x | (x << 8)) & 0x00FF00FFu;
+    x = (x | (x << 4)) & 0x0F0F0F0Fu;
+    x = (x | (x << 2)) & 0x33333333u;
+    return x;
+}
+
+// squeeze the 8 little-endian 4-bit symbols of x (with N's already replaced) into the low half
+//
+NVBIO_FORCEINLINE uint32 narrow_symbols(uint32 x)
+{
+    x &= 0x33333333u;
+    x = (x | (x >> 2)) & 0x0F0F0F0Fu;
+    x = (x | (x >> 4)) & 0x00FF00FFu;
+    x = (x | (x >> 8)) & 0x0000FFFFu;
+    return x;
+}
+
+// access the 32-bit words of a packed stream's storage, viewing uint8 storage as made of
+// groups of four bytes packed with the same endianness as the symbols; only the bytes
+// in [byte_begin,byte_end) are ever touched
+//
+template <typename word_type, bool BIG_ENDIAN> struct packed_storage_words {};
+
+template <bool BIG_ENDIAN>
+struct packed_storage_words<uint32,BIG_ENDIAN>
+{
+    static NVBIO_FORCEINLINE uint32 load(const uint32* words, const uint64 w, const uint64 byte_begin, const uint64 byte_end)
+    {
+        return words[w];
+    }
+    static NVBIO_FORCEINLINE void store(uint32* words, const uint64 w, const uint32 v, const uint64 byte_begin, const uint64 byte_end)
+    {
+        words[w] = v;
+    }
+};
+
+template <bool BIG_ENDIAN>
+struct packed_storage_words<uint8,BIG_ENDIAN>
+{
+    static NVBIO_FORCEINLINE uint32 load(const uint8* bytes, const uint64 w, const uint64 byte_begin, const uint64 byte_end)
+    {
+        uint32 v = 0u;
+        for (uint32 i = 0; i < 4u; ++i)
+        {
+            const uint64 b = w * 4u + i;
+            if (b >= byte_begin && b < byte_end)
+                v |= uint32( bytes[b] ) << (BIG_ENDIAN ? 24u - i*8u : i*8u);
+        }
+        return v;
+    }
+    static NVBIO_FORCEINLINE void store(uint8* bytes, const uint64 w, const uint32 v, const uint64 byte_begin, const uint64 byte_end)
+    {
+        for (uint32 i = 0; i < 4u; ++i)
+        {
+            const uint64 b = w * 4u + i;
+            if (b >= byte_begin && b < byte_end)
+                bytes[b] = uint8( v >> (BIG_ENDIAN ? 24u - i*8u : i*8u) );
+        }
+    }
+};
+
+// read 32-bit words of symbols at arbitrary symbol offsets from the [begin,end) range of
+// a packed stream, zero-filling anything outside the words spanned by the range
+//
+template <typename word_type, uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+struct packed_word_reader
+{
+    static const uint32 SYMBOLS_PER_WORD = 32u / SYMBOL_SIZE;
+    static const uint32 SYMBOLS_PER_BYTE = 8u  / SYMBOL_SIZE;
+
+    packed_word_reader(const word_type* words, const uint64 begin, const uint64 end) :
+        m_words( words ),
+        m_first( int64( begin / SYMBOLS_PER_WORD ) ),
+        m_last( int64( (end - 1u) / SYMBOLS_PER_WORD ) ),
+        m_byte_begin( begin / SYMBOLS_PER_BYTE ),
+        m_byte_end( util::divide_ri( end, uint64( SYMBOLS_PER_BYTE ) ) ) {}
+
+    // fetch the w-th storage word
+    NVBIO_FORCEINLINE uint32 fetch(const int64 w) const
+    {
+        return (w >= m_first && w <= m_last) ?
+            packed_storage_words<word_type,BIG_ENDIAN>::load( m_words, uint64(w), m_byte_begin, m_byte_end ) : 0u;
+    }
+
+    // return the word holding the symbols [pos, pos + SYMBOLS_PER_WORD)
+    NVBIO_FORCEINLINE uint32 load(const int64 pos) const
+    {
+        const int64  w     = floor_div( pos, SYMBOLS_PER_WORD );
+        const uint32 shift = uint32( pos - w * SYMBOLS_PER_WORD ) * SYMBOL_SIZE;
+
+        const uint32 lo = fetch( w );
+        if (shift == 0u)
+            return lo;
+
+        const uint32 hi = fetch( w + 1 );
+        return BIG_ENDIAN ?
+            (lo << shift) | (hi >> (32u - shift)) :
+            (lo >> shift) | (hi << (32u - shift));
+    }
+
+    const word_type* m_words;
+    int64            m_first;
+    int64            m_last;
+    uint64           m_byte_begin;
+    uint64           m_byte_end;
+};
+
+// write whole 32-bit words of symbols to a packed stream, preserving all symbols outside
+// its [begin,end) range
+//
+template <typename word_type, uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+struct packed_word_writer
+{
+    static const uint32 SYMBOLS_PER_WORD = 32u / SYMBOL_SIZE;
+    static const uint32 SYMBOLS_PER_BYTE = 8u  / SYMBOL_SIZE;
+
+    packed_word_writer(word_type* words, const uint64 begin, const uint64 end) :
+        m_words( words ),
+        m_begin( begin ),
+        m_end( end ),
+        m_first( begin / SYMBOLS_PER_WORD ),
+        m_last( (end - 1u) / SYMBOLS_PER_WORD ),
+        m_byte_begin( begin / SYMBOLS_PER_BYTE ),
+        m_byte_end( util::divide_ri( end, uint64( SYMBOLS_PER_BYTE ) ) ) {}
+
+    // return the range of valid symbols of the w-th word
+    NVBIO_FORCEINLINE void valid_range(const uint64 w, uint32* i0, uint32* i1) const
+    {
+        const uint64 w_begin = w * SYMBOLS_PER_WORD;
+        *i0 = uint32( nvbio::max( m_begin, w_begin ) - w_begin );
+        *i1 = uint32( nvbio::min( m_end,   w_begin + SYMBOLS_PER_WORD ) - w_begin );
+    }
+
+    // store the w-th word
+    NVBIO_FORCEINLINE void store(const uint64 w, uint32 v) const
+    {
+        if (w == m_first || w == m_last)
+        {
+            // merge the partially covered words with their current content
+            uint32 i0, i1;
+            valid_range( w, &i0, &i1 );
+
+            const uint32 mask = symbol_range_mask<SYMBOL_SIZE,BIG_ENDIAN>( i0, i1 );
+            const uint32 old  = packed_storage_words<word_type,BIG_ENDIAN>::load( m_words, w, m_byte_begin, m_byte_end );
+            v = (old & ~mask) | (v & mask);
+        }
+        packed_storage_words<word_type,BIG_ENDIAN>::store( m_words, w, v, m_byte_begin, m_byte_end );
+    }
+
+    word_type* m_words;
+    uint64     m_begin;
+    uint64     m_end;
+    uint64     m_first;
+    uint64     m_last;
+    uint64     m_byte_begin;
+    uint64     m_byte_end;
+};
+
+#if defined(__SSSE3__)
+
+// funnel-shift four consecutive 32-bit words of symbols starting at the given storage word
+//
+template <bool BIG_ENDIAN>
+NVBIO_FORCEINLINE __m128i sse_funnel_load(const uint32* words, const int64 w, const uint32 shift)
+{
+    const __m128i lo = _mm_loadu_si128( (const __m128i*)(words + w) );
+    if (shift == 0u)
+        return lo;
+
+    const __m128i hi = _mm_loadu_si128( (const __m128i*)(words + w + 1) );
+    return BIG_ENDIAN ?
+        _mm_or_si128( _mm_sll_epi32( lo, _mm_cvtsi32_si128( shift ) ), _mm_srl_epi32( hi, _mm_cvtsi32_si128( 32u - shift ) ) ) :
+        _mm_or_si128( _mm_srl_epi32( lo, _mm_cvtsi32_si128( shift ) ), _mm_sll_epi32( hi, _mm_cvtsi32_si128( 32u - shift ) ) );
+}
+
+// split the bytes of a vector in their low and high nibbles
+//
+NVBIO_FORCEINLINE __m128i sse_lo_nibbles(const __m128i v) { return _mm_and_si128( v, _mm_set1_epi8( 0x0F ) ); }
+NVBIO_FORCEINLINE __m128i sse_hi_nibbles(const __m128i v) { return _mm_and_si128( _mm_srli_epi16( v, 4 ), _mm_set1_epi8( 0x0F ) ); }
+
+// reverse the order of the symbols within each 32-bit lane
+//
+template <uint32 SYMBOL_SIZE> __m128i sse_reverse_symbols(const __m128i v);
+
+template <> NVBIO_FORCEINLINE __m128i sse_reverse_symbols<8u>(const __m128i v)
+{
+    return _mm_shuffle_epi8( v, _mm_set_epi8( 12,13,14,15, 8,9,10,11, 4,5,6,7, 0,1,2,3 ) );
+}
+template <> NVBIO_FORCEINLINE __m128i sse_reverse_symbols<4u>(const __m128i v)
+{
+    const __m128i r = sse_reverse_symbols<8u>( v );
+    return _mm_or_si128( sse_hi_nibbles( r ), _mm_slli_epi16( sse_lo_nibbles( r ), 4 ) );
+}
+template <> NVBIO_FORCEINLINE __m128i sse_reverse_symbols<2u>(const __m128i v)
+{
+    // reverse the bytes, and then the four symbols of each byte through two nibble lookups
+    const __m128i r = sse_reverse_symbols<8u>( v );
+    const __m128i rev_lo = _mm_setr_epi8( 0,64,-128,-64, 16,80,-112,-48, 32,96,-96,-32, 48,112,-80,-16 );
+    const __m128i rev_hi = _mm_setr_epi8( 0,4,8,12, 1,5,9,13, 2,6,10,14, 3,7,11,15 );
+    return _mm_or_si128(
+        _mm_shuffle_epi8( rev_lo, sse_lo_nibbles( r ) ),
+        _mm_shuffle_epi8( rev_hi, sse_hi_nibbles( r ) ) );
+}
+
+// complement the DNA symbols of a vector
+//
+template <uint32 SYMBOL_SIZE> __m128i sse_complement_symbols(const __m128i v);
+
+template <> NVBIO_FORCEINLINE __m128i sse_complement_symbols<2u>(const __m128i v)
+{
+    return _mm_xor_si128( v, _mm_set1_epi32( -1 ) );
+}
+template <> NVBIO_FORCEINLINE __m128i sse_complement_symbols<4u>(const __m128i v)
+{
+    const __m128i comp_lo = _mm_setr_epi8( 3,2,1,0, 4,5,6,7, 8,9,10,11, 12,13,14,15 );
+    const __m128i comp_hi = _mm_slli_epi16( comp_lo, 4 );
+    return _mm_or_si128(
+        _mm_shuffle_epi8( comp_lo, sse_lo_nibbles( v ) ),
+        _mm_shuffle_epi8( comp_hi, sse_hi_nibbles( v ) ) );
+}
+
+#endif // __SSSE3__
+
+// a kernel copying, and optionally reversing and complementing, a range of symbols across
+// packed streams with the same symbol size
+//
+template <bool REVERSE, bool COMPLEMENT, uint32 SYMBOL_SIZE, bool IN_BIG_ENDIAN, bool OUT_BIG_ENDIAN, typename in_word_type, typename out_word_type>
+struct packed_copy_kernel
+{
+    static const uint32 SYMBOLS_PER_WORD = 32u / SYMBOL_SIZE;
+
+    // reversing the symbol order and switching endianness both reverse the symbols within each word
+    static const bool REVERSE_WORDS = REVERSE != (IN_BIG_ENDIAN != OUT_BIG_ENDIAN);
+
+    static const bool SIMD = same_type<in_word_type,uint32>::pred && same_type<out_word_type,uint32>::pred;
+
+    packed_copy_kernel(const uint64 n, const in_word_type* in, const uint64 in_begin, out_word_type* out, const uint64 out_begin) :
+        m_reader( in, in_begin, in_begin + n ),
+        m_writer( out, out_begin, out_begin + n ),
+        m_n( n ),
+        m_in_begin( in_begin ),
+        m_out_begin( out_begin ) {}
+
+    // return the input position of the word to be transformed into the w-th output word
+    NVBIO_FORCEINLINE int64 input_pos(const uint64 w) const
+    {
+        const int64 out_pos = int64( w * SYMBOLS_PER_WORD ) - int64( m_out_begin );
+        return REVERSE ?
+            int64( m_in_begin + m_n ) - int64( SYMBOLS_PER_WORD ) - out_pos :
+            int64( m_in_begin ) + out_pos;
+    }
+
+    // transform a single word
+    NVBIO_FORCEINLINE void word(const uint64 w) const
+    {
+        uint32 v = m_reader.load( input_pos( w ) );
+        if (REVERSE_WORDS) v = reverse_symbols<SYMBOL_SIZE>( v );
+        if (COMPLEMENT)    v = complement_symbols<SYMBOL_SIZE>( v );
+
+        m_writer.store( w, v );
+    }
+
+  #if defined(__SSSE3__)
+    // transform the four interior output words [w,w+4), returning false if they are not eligible
+    NVBIO_FORCEINLINE bool simd_block(const uint64 w) const
+    {
+        if (SIMD == false || w <= m_writer.m_first || w + 4u > m_writer.m_last)
+            return false;
+
+        // find the first storage word to load, and the in-word shift
+        const int64  pos   = REVERSE ? input_pos( w ) - 3 * int64( SYMBOLS_PER_WORD ) : input_pos( w );
+        const int64  iw    = floor_div( pos, SYMBOLS_PER_WORD );
+        const uint32 shift = uint32( pos - iw * SYMBOLS_PER_WORD ) * SYMBOL_SIZE;
+
+        if (iw < m_reader.m_first || iw + 4 > m_reader.m_last)
+            return false;
+
+        __m128i v = sse_funnel_load<IN_BIG_ENDIAN>( (const uint32*)m_reader.m_words, iw, shift );
+        if (REVERSE)       v = _mm_shuffle_epi32( v, 0x1B );
+        if (REVERSE_WORDS) v = sse_reverse_symbols<SYMBOL_SIZE>( v );
+        if (COMPLEMENT)    v = sse_complement_symbols<SYMBOL_SIZE>( v );
+
+        _mm_storeu_si128( (__m128i*)((uint32*)m_writer.m_words + w), v );
+        return true;
+    }
+  #endif
+
+    // transform the output words [begin,end)
+    uint64 block(const uint64 begin, const uint64 end) const
+    {
+        for (uint64 w = begin; w < end;)
+        {
+          #if defined(__SSSE3__)
+            if (w + 4u <= end && simd_block( w ))
+            {
+                w += 4u;
+                continue;
+            }
+          #endif
+            word( w++ );
+        }
+        return 0u;
+    }
+
+    uint64 first_word() const { return m_writer.m_first; }
+    uint64 end_word()   const { return m_writer.m_last + 1u; }
+
+    packed_word_reader<in_word_type,SYMBOL_SIZE,IN_BIG_ENDIAN>      m_reader;
+    packed_word_writer<out_word_type,SYMBOL_SIZE,OUT_BIG_ENDIAN>    m_writer;
+    uint64                                                          m_n;
+    uint64                                                          m_in_begin;
+    uint64                                                          m_out_begin;
+};
+
+// a kernel widening a 2-bit DNA stream to a 4-bit DNA_N one
+//
+template <bool IN_BIG_ENDIAN, bool OUT_BIG_ENDIAN, typename in_word_type, typename out_word_type>
+struct packed_widen_kernel
+{
+    static const bool SIMD = same_type<in_word_type,uint32>::pred && same_type<out_word_type,uint32>::pred;
+
+    packed_widen_kernel(const uint64 n, const in_word_type* in, const uint64 in_begin, out_word_type* out, const uint64 out_begin) :
+        m_reader( in, in_begin, in_begin + n ),
+        m_writer( out, out_begin, out_begin + n ),
+        m_in_begin( in_begin ),
+        m_out_begin( out_begin ) {}
+
+    // return the input position of the first symbol of the w-th output word
+    NVBIO_FORCEINLINE int64 input_pos(const uint64 w) const
+    {
+        return int64( m_in_begin ) + int64( w * 8u ) - int64( m_out_begin );
+    }
+
+    // transform a single word
+    NVBIO_FORCEINLINE void word(const uint64 w) const
+    {
+        uint32 v = m_reader.load( input_pos( w ) );
+
+        // widen the first 8 symbols in little-endian order
+        if (IN_BIG_ENDIAN) v = reverse_symbols<2u>( v );
+        v = widen_symbols( v );
+        if (OUT_BIG_ENDIAN) v = reverse_symbols<4u>( v );
+
+        m_writer.store( w, v );
+    }
+
+  #if defined(__SSSE3__)
+    // transform the eight interior output words [w,w+8), returning false if they are not eligible
+    NVBIO_FORCEINLINE bool simd_block(const uint64 w) const
+    {
+        if (SIMD == false || w <= m_writer.m_first || w + 8u > m_writer.m_last)
+            return false;
+
+        const int64  pos   = input_pos( w );
+        const int64  iw    = floor_div( pos, 16 );
+        const uint32 shift = uint32( pos - iw * 16 ) * 2u;
+
+        if (iw < m_reader.m_first || iw + 4 > m_reader.m_last)
+            return false;
+
+        __m128i v = sse_funnel_load<IN_BIG_ENDIAN>( (const uint32*)m_reader.m_words, iw, shift );
+        if (IN_BIG_ENDIAN) v = sse_reverse_symbols<2u>( v );
+
+        // widen each nibble, i.e. pair of 2-bit symbols, to a byte, and interleave the results
+        const __m128i widen = _mm_setr_epi8( 0,1,2,3, 16,17,18,19, 32,33,34,35, 48,49,50,51 );
+        const __m128i lo    = _mm_shuffle_epi8( widen, sse_lo_nibbles( v ) );
+        const __m128i hi    = _mm_shuffle_epi8( widen, sse_hi_nibbles( v ) );
+
+        __m128i out0 = _mm_unpacklo_epi8( lo, hi );
+        __m128i out1 = _mm_unpackhi_epi8( lo, hi );
+        if (OUT_BIG_ENDIAN)
+        {
+            out0 = sse_reverse_symbols<4u>( out0 );
+            out1 = sse_reverse_symbols<4u>( out1 );
+        }
+
+        uint32* out = (uint32*)m_writer.m_words + w;
+        _mm_storeu_si128( (__m128i*)(out),      out0 );
+        _mm_storeu_si128( (__m128i*)(out + 4u), out1 );
+        return true;
+    }
+  #endif
+
+    // transform the output words [begin,end)
+    uint64 block(const uint64 begin, const uint64 end) const
+    {
+        for (uint64 w = begin; w < end;)
+        {
+          #if defined(__SSSE3__)
+            if (w + 8u <= end && simd_block( w ))
+            {
+                w += 8u;
+                continue;
+            }
+          #endif
+            word( w++ );
+        }
+        return 0u;
+    }
+
+    uint64 first_word() const { return m_writer.m_first; }
+    uint64 end_word()   const { return m_writer.m_last + 1u; }
+
+    packed_word_reader<in_word_type,2u,IN_BIG_ENDIAN>      m_reader;
+    packed_word_writer<out_word_type,4u,OUT_BIG_ENDIAN>    m_writer;
+    uint64                                                 m_in_begin;
+    uint64                                                 m_out_begin;
+};
+
+// a kernel narrowing a 4-bit DNA_N stream to a 2-bit DNA one, replacing and counting N's
+//
+template <bool IN_BIG_ENDIAN, bool OUT_BIG_ENDIAN, typename in_word_type, typename out_word_type>
+struct packed_narrow_kernel
+{
+    static const bool SIMD = same_type<in_word_type,uint32>::pred && same_type<out_word_type,uint32>::pred;
+
+    packed_narrow_kernel(const uint64 n, const in_word_type* in, const uint64 in_begin, out_word_type* out, const uint64 out_begin, const uint8 n_symbol) :
+        m_reader( in, in_begin, in_begin + n ),
+        m_writer( out, out_begin, out_begin + n ),
+        m_in_begin( in_begin ),
+        m_out_begin( out_begin ),
+        m_n_symbol( n_symbol & 3u ) {}
+
+    // return the input position of the first symbol of the w-th output word
+    NVBIO_FORCEINLINE int64 input_pos(const uint64 w) const
+    {
+        return int64( m_in_begin ) + int64( w * 16u ) - int64( m_out_begin );
+    }
+
+    // narrow 8 symbols, returning the N flags in the low bit of each nibble
+    NVBIO_FORCEINLINE uint32 narrow(uint32 v, uint32* n_flags) const
+    {
+        if (IN_BIG_ENDIAN) v = reverse_symbols<4u>( v );
+
+        *n_flags = ((v >> 2) | (v >> 3)) & 0x11111111u;
+        v = (v & ~(*n_flags * 3u)) | (*n_flags * m_n_symbol);
+        return narrow_symbols( v );
+    }
+
+    // transform a single word
+    NVBIO_FORCEINLINE uint64 word(const uint64 w) const
+    {
+        const int64 pos = input_pos( w );
+
+        uint32 n0, n1;
+        uint32 v = narrow( m_reader.load( pos ), &n0 ) | (narrow( m_reader.load( pos + 8 ), &n1 ) << 16);
+        if (OUT_BIG_ENDIAN) v = reverse_symbols<2u>( v );
+
+        // count the N's among the valid symbols only
+        uint32 i0, i1;
+        m_writer.valid_range( w, &i0, &i1 );
+        n0 &= bit_range_mask( nvbio::min( i0, 8u ) * 4u,      nvbio::min( i1, 8u ) * 4u );
+        n1 &= bit_range_mask( nvbio::max( i0, 8u ) * 4u - 32u, nvbio::max( i1, 8u ) * 4u - 32u );
+
+        m_writer.store( w, v );
+        return popc( n0 ) + popc( n1 );
+    }
+
+  #if defined(__SSSE3__)
+    // narrow 8 words of symbols into 16 bytes of nibbles, counting N's
+    NVBIO_FORCEINLINE __m128i sse_narrow(__m128i v, uint32* n_count) const
+    {
+        if (IN_BIG_ENDIAN) v = sse_reverse_symbols<4u>( v );
+
+        const __m128i lo = sse_lo_nibbles( v );
+        const __m128i hi = sse_hi_nibbles( v );
+
+        const __m128i three = _mm_set1_epi8( 3 );
+        *n_count += popc( uint32( _mm_movemask_epi8( _mm_cmpgt_epi8( lo, three ) ) ) ) +
+                    popc( uint32( _mm_movemask_epi8( _mm_cmpgt_epi8( hi, three ) ) ) );
+
+        // map each symbol to its 2-bit code, and merge the pairs of each byte in a nibble
+        const char    r    = char( m_n_symbol );
+        const __m128i code = _mm_setr_epi8( 0,1,2,3, r,r,r,r, r,r,r,r, r,r,r,r );
+        return _mm_or_si128(
+            _mm_shuffle_epi8( code, lo ),
+            _mm_slli_epi16( _mm_shuffle_epi8( code, hi ), 2 ) );
+    }
+
+    // transform the four interior output words [w,w+4), returning false if they are not eligible
+    NVBIO_FORCEINLINE bool simd_block(const uint64 w, uint64* n_count) const
+    {
+        if (SIMD == false || w <= m_writer.m_first || w + 4u > m_writer.m_last)
+            return false;
+
+        const int64  pos   = input_pos( w );
+        const int64  iw    = floor_div( pos, 8 );
+        const uint32 shift = uint32( pos - iw * 8 ) * 4u;
+
+        if (iw < m_reader.m_first || iw + 8 > m_reader.m_last)
+            return false;
+
+        const uint32* in = (const uint32*)m_reader.m_words;
+
+        uint32 count = 0u;
+        const __m128i a = sse_narrow( sse_funnel_load<IN_BIG_ENDIAN>( in, iw,     shift ), &count );
+        const __m128i b = sse_narrow( sse_funnel_load<IN_BIG_ENDIAN>( in, iw + 4, shift ), &count );
+
+        // merge the nibbles of each pair of bytes, and pack the results
+        const __m128i weights = _mm_set1_epi16( 0x1001 );
+        __m128i v = _mm_packus_epi16(
+            _mm_maddubs_epi16( a, weights ),
+            _mm_maddubs_epi16( b, weights ) );
+
+        if (OUT_BIG_ENDIAN) v = sse_reverse_symbols<2u>( v );
+
+        _mm_storeu_si128( (__m128i*)((uint32*)m_writer.m_words + w), v );
+
+        *n_count += count;
+        return true;
+    }
+  #endif
+
+    // transform the output words [begin,end), returning the number of N's
+    uint64 block(const uint64 begin, const uint64 end) const
+    {
+        uint64 n_count = 0u;
+        for (uint64 w = begin; w < end;)
+        {
+          #if defined(__SSSE3__)
+            if (w + 4u <= end && simd_block( w, &n_count ))
+            {
+                w += 4u;
+                continue;
+            }
+          #endif
+            n_count += word( w++ );
+        }
+        return n_count;
+    }
+
+    uint64 first_word() const { return m_writer.m_first; }
+    uint64 end_word()   const { return m_writer.m_last + 1u; }
+
+    packed_word_reader<in_word_type,4u,IN_BIG_ENDIAN>      m_reader;
+    packed_word_writer<out_word_type,2u,OUT_BIG_ENDIAN>    m_writer;
+    uint64                                                 m_in_begin;
+    uint64                                                 m_out_begin;
+    uint32                                                 m_n_symbol;
+};
+
+// run a transcoding kernel over all its output words, in parallel for large ranges
+//
+template <typename kernel_type>
+uint64 packed_transcode(const uint64 n, const kernel_type& kernel)
+{
+    if (n == 0)
+        return 0u;
+
+    const uint64 begin = kernel.first_word();
+    const uint64 end   = kernel.end_word();
+
+  #if defined(_OPENMP)
+    if (n > PACKED_TRANSCODE_PARALLEL_THRESHOLD)
+    {
+        const uint64 n_blocks = util::divide_ri( end - begin, PACKED_TRANSCODE_BLOCK_SIZE );
+
+        uint64 r = 0u;
+
+        #pragma omp parallel for reduction(+:r)
+        for (int64 b = 0; b < int64( n_blocks ); ++b)
+        {
+            const uint64 block_begin = begin + uint64(b) * PACKED_TRANSCODE_BLOCK_SIZE;
+            const uint64 block_end   = nvbio::min( block_begin + PACKED_TRANSCODE_BLOCK_SIZE, end );
+
+            r += kernel.block( block_begin, block_end );
+        }
+        return r;
+    }
+  #endif
+    return kernel.block( begin, end );
+}
+
+// copy a range of symbols across packed streams with the same symbol size
+//
+template <bool REVERSE, bool COMPLEMENT, uint32 SYMBOL_SIZE, bool IN_BIG_ENDIAN, bool OUT_BIG_ENDIAN, typename in_word_type, typename out_word_type>
+void packed_copy(const uint64 n, const in_word_type* in, const uint64 in_begin, out_word_type* out, const uint64 out_begin)
+{
+    if (n == 0)
+        return;
+
+    typedef packed_copy_kernel<REVERSE,COMPLEMENT,SYMBOL_SIZE,IN_BIG_ENDIAN,OUT_BIG_ENDIAN,in_word_type,out_word_type> kernel_type;
+
+    packed_transcode( n, kernel_type( n, in, in_begin, out, out_begin ) );
+}
+
+} // namespace priv
+
+// copy a packed stream range into another one with the same symbol size
+//
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol, uint32 SYMBOL_SIZE_T,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_repack(
+    const IndexType                                                              n,
+    const PackedStream<InputStorage,Symbol,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,IndexType>    in,
+          PackedStream<OutputStorage,Symbol,SYMBOL_SIZE_T,OUT_BIG_ENDIAN_T,IndexType>  out)
+{
+    priv::packed_copy<false,false,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,OUT_BIG_ENDIAN_T>(
+        uint64( n ), in.stream(), uint64( in.index() ), out.stream(), uint64( out.index() ) );
+}
+
+// reverse a packed stream range into another one with the same symbol size
+//
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol, uint32 SYMBOL_SIZE_T,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_reverse(
+    const IndexType                                                              n,
+    const PackedStream<InputStorage,Symbol,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,IndexType>    in,
+          PackedStream<OutputStorage,Symbol,SYMBOL_SIZE_T,OUT_BIG_ENDIAN_T,IndexType>  out)
+{
+    priv::packed_copy<true,false,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,OUT_BIG_ENDIAN_T>(
+        uint64( n ), in.stream(), uint64( in.index() ), out.stream(), uint64( out.index() ) );
+}
+
+// reverse-complement a DNA or DNA_N packed stream range into another one
+//
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol, uint32 SYMBOL_SIZE_T,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_reverse_complement(
+    const IndexType                                                              n,
+    const PackedStream<InputStorage,Symbol,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,IndexType>    in,
+          PackedStream<OutputStorage,Symbol,SYMBOL_SIZE_T,OUT_BIG_ENDIAN_T,IndexType>  out)
+{
+    priv::packed_copy<true,true,SYMBOL_SIZE_T,IN_BIG_ENDIAN_T,OUT_BIG_ENDIAN_T>(
+        uint64( n ), in.stream(), uint64( in.index() ), out.stream(), uint64( out.index() ) );
+}
+
+// widen a 2-bit DNA packed stream range into a 4-bit DNA_N one
+//
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+void packed_widen(
+    const IndexType                                                      n,
+    const PackedStream<InputStorage,Symbol,2u,IN_BIG_ENDIAN_T,IndexType>       in,
+          PackedStream<OutputStorage,Symbol,4u,OUT_BIG_ENDIAN_T,IndexType>     out)
+{
+    typedef typename std::iterator_traits<InputStorage>::value_type  in_word_type;
+    typedef typename std::iterator_traits<OutputStorage>::value_type out_word_type;
+
+    typedef priv::packed_widen_kernel<IN_BIG_ENDIAN_T,OUT_BIG_ENDIAN_T,in_word_type,out_word_type> kernel_type;
+
+    if (n == 0)
+        return;
+
+    priv::packed_transcode( uint64( n ), kernel_type( uint64( n ), in.stream(), uint64( in.index() ), out.stream(), uint64( out.index() ) ) );
+}
+
+// narrow a 4-bit DNA_N packed stream range into a 2-bit DNA one
+//
+template <
+    typename InputStorage, typename OutputStorage, typename Symbol,
+    bool IN_BIG_ENDIAN_T, bool OUT_BIG_ENDIAN_T, typename IndexType>
+uint64 packed_narrow(
+    const IndexType                                                      n,
+    const PackedStream<InputStorage,Symbol,4u,IN_BIG_ENDIAN_T,IndexType>       in,
+          PackedStream<OutputStorage,Symbol,2u,OUT_BIG_ENDIAN_T,IndexType>     out,
+    const uint8                                                          n_symbol)
+{
+    typedef typename std::iterator_traits<InputStorage>::value_type  in_word_type;
+    typedef typename std::iterator_traits<OutputStorage>::value_type out_word_type;
+
+    typedef priv::packed_narrow_kernel<IN_BIG_ENDIAN_T,OUT_BIG_ENDIAN_T,in_word_type,out_word_type> kernel_type;
+
+    if (n == 0)
+        return 0u;
+
+    return priv::packed_transcode( uint64( n ), kernel_type( uint64( n ), in.stream(), uint64( in.index() ), out.stream(), uint64( out.index() ), n_symbol ) );
+}
+
+} // namespace nvbio
@@ -0,0 +1,257 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*! \file page_cache.h
+ *   \brief Define a bounded, LRU-managed cache of fixed-size pages loaded on demand
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/cache.h>
+#include <nvbio/basic/threads.h>
+#include <iterator>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup Basic
+///@{
+
+///
+/// The interface used by a PageCache to load its pages from their backing store
+///
+template <typename T>
+struct PageLoader
+{
+    virtual ~PageLoader() {}
+
+    /// load the given page into a buffer holding one page worth of elements
+    ///
+    /// \param page         the page to load
+    /// \param buffer       the output buffer
+    ///
+    /// Errors can be reported by throwing: the exception is propagated to the cache
+    /// access which triggered the load, and the page is left out of the cache.
+    virtual void load(const uint32 page, T* buffer) = 0;
+};
+
+///
+/// A bounded host cache presenting a large array of elements which is split into fixed-size
+/// pages, loaded on demand by a PageLoader into a fixed pool of in-memory frames.
+/// Frames are recycled according to an LRU policy, and pages can be pinned to prevent their
+/// eviction.
+///\par
+/// All methods can be called concurrently by multiple threads; each access takes a lock,
+/// which is also held while loading a missing page.
+///\par
+/// The cache can be accessed through a page_cache_iterator, which can be plugged in any
+/// of the generic containers and algorithms accepting random access iterators (e.g. the
+/// occurrence tables and sampled suffix arrays of an FM-index).
+///
+template <typename T>
+struct PageCache
+{
+    typedef T           value_type;
+
+    static const uint32 INVALID_FRAME = 0xFFFFFFFFu;
+
+    /// empty constructor
+    ///
+    PageCache();
+
+    /// setup the cache
+    ///
+    /// \param size         the total number of elements
+    /// \param page_size    the number of elements per page, must be a power of 2
+    /// \param max_pages    the maximum number of resident pages
+    /// \param loader       the page loader
+    void setup(
+        const uint64    size,
+        const uint32    page_size,
+        const uint32    max_pages,
+        PageLoader<T>*  loader);
+
+    /// return the total number of elements
+    ///
+    uint64 size() const { return m_size; }
+
+    /// return the number of elements per page
+    ///
+    uint32 page_size() const { return 1u << m_page_shift; }
+
+    /// return the total number of pages
+    ///
+    uint32 pages() const { return uint32( m_page_frame.size() ); }
+
+    /// return the maximum number of resident pages
+    ///
+    uint32 max_resident_pages() const { return m_max_pages; }
+
+    /// return the number of bytes reserved for the resident pages
+    ///
+    uint64 memory_footprint() const { return uint64( m_frames.size() ) * sizeof(T); }
+
+    /// fetch the i-th element, loading its page if needed
+    ///
+    T fetch(const uint64 i);
+
+    /// pin a page, loading it if needed and preventing its eviction;
+    /// pins are counted, and a page can be evicted again only after as many unpin() calls.
+    /// Throws cache_overflow if all pages are already pinned, and propagates loader errors.
+    ///
+    void pin(const uint32 page);
+
+    /// unpin a page
+    ///
+    void unpin(const uint32 page);
+
+    /// return the number of accesses to resident pages
+    ///
+    uint64 hits() const { return m_hits; }
+
+    /// return the number of accesses which caused a page to be loaded
+    ///
+    uint64 misses() const { return m_misses; }
+
+    /// return the number of evicted pages
+    ///
+    uint64 evictions() const { return m_evictions; }
+
+    /// reset the hit/miss counters
+    ///
+    void reset_stats();
+
+private:
+    /// the CacheManager interface expected by the LRU
+    ///
+    struct Manager
+    {
+        bool acquire(const uint32 page);
+        void release(const uint32 page);
+        bool low_watermark() const;
+
+        PageCache* m_cache;
+    };
+
+    PageCache(const PageCache&);
+    PageCache& operator=(const PageCache&);
+
+    void touch(const uint32 page);
+
+    uint64                  m_size;
+    uint32                  m_page_shift;
+    uint32                  m_max_pages;
+    uint32                  m_low_watermark;
+    uint32                  m_last_page;
+    PageLoader<T>*          m_loader;
+    std::vector<T>          m_frames;
+    std::vector<uint32>     m_free_frames;
+    std::vector<uint32>     m_page_frame;
+    std::vector<uint32>     m_page_pins;
+    Manager                 m_manager;
+    LRU<Manager>            m_lru;
+    Mutex                   m_mutex;
+    uint64                  m_hits;
+    uint64                  m_misses;
+    uint64                  m_evictions;
+};
+
+///
+/// A random access iterator over the elements of a PageCache
+///
+template <typename T>
+struct page_cache_iterator
+{
+    typedef T                                   value_type;
+    typedef T                                   reference;
+    typedef const T*                            pointer;
+    typedef int64                               difference_type;
+    typedef std::random_access_iterator_tag     iterator_category;
+
+    /// empty constructor
+    ///
+    page_cache_iterator() : m_cache( NULL ), m_offset( 0 ) {}
+
+    /// constructor
+    ///
+    page_cache_iterator(PageCache<T>* cache, const uint64 offset = 0) : m_cache( cache ), m_offset( offset ) {}
+
+    /// indexing operator
+    ///
+    value_type operator[] (const uint64 i) const { return m_cache->fetch( m_offset + i ); }
+
+    /// dereference operator
+    ///
+    value_type operator*() const { return m_cache->fetch( m_offset ); }
+
+    /// pre-increment
+    ///
+    page_cache_iterator& operator++() { ++m_offset; return *this; }
+
+    /// post-increment
+    ///
+    page_cache_iterator operator++(int) { page_cache_iterator r( *this ); ++m_offset; return r; }
+
+    /// pre-decrement
+    ///
+    page_cache_iterator& operator--() { --m_offset; return *this; }
+
+    /// post-decrement
+    ///
+    page_cache_iterator operator--(int) { page_cache_iterator r( *this ); --m_offset; return r; }
+
+    /// addition
+    ///
+    page_cache_iterator operator+(const difference_type i) const { return page_cache_iterator( m_cache, m_offset + i ); }
+
+    /// subtraction
+    ///
+    page_cache_iterator operator-(const difference_type i) const { return page_cache_iterator( m_cache, m_offset - i ); }
+
+    /// addition
+    ///
+    page_cache_iterator& operator+=(const difference_type i) { m_offset += i; return *this; }
+
+    /// subtraction
+    ///
+    page_cache_iterator& operator-=(const difference_type i) { m_offset -= i; return *this; }
+
+    /// iterator subtraction
+    ///
+    difference_type operator-(const page_cache_iterator& it) const { return difference_type( m_offset - it.m_offset ); }
+
+    PageCache<T>*   m_cache;
+    uint64          m_offset;
+};
+
+///@} Basic
+
+} // namespace nvbio
+
+#include <nvbio/basic/page_cache_inl.h>
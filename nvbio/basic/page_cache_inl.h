@@ -0,0 +1,222 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+namespace nvbio {
+
+template <typename T>
+const uint32 PageCache<T>::INVALID_FRAME;
+
+template <typename T>
+PageCache<T>::PageCache() :
+    m_size( 0 ),
+    m_page_shift( 0 ),
+    m_max_pages( 0 ),
+    m_low_watermark( 0 ),
+    m_last_page( INVALID_FRAME ),
+    m_loader( NULL ),
+    m_lru( m_manager ),
+    m_hits( 0 ),
+    m_misses( 0 ),
+    m_evictions( 0 )
+{
+    m_manager.m_cache = this;
+}
+
+// setup the cache
+//
+template <typename T>
+void PageCache<T>::setup(
+    const uint64    size,
+    const uint32    page_size,
+    const uint32    max_pages,
+    PageLoader<T>*  loader)
+{
+    ScopedLock lock( &m_mutex );
+
+    m_size       = size;
+    m_page_shift = log2( page_size );
+    m_loader     = loader;
+
+    const uint32 n_pages = uint32( (size + page_size-1) >> m_page_shift );
+
+    // there's no point in reserving more frames than pages
+    m_max_pages = nvbio::max( nvbio::min( max_pages, n_pages ), 1u );
+
+    // release pages in batches of 1/16-th of the cache
+    m_low_watermark = nvbio::max( m_max_pages / 16u, 1u );
+
+    m_frames.resize( uint64( m_max_pages ) << m_page_shift );
+    m_free_frames.resize( m_max_pages );
+    for (uint32 i = 0; i < m_max_pages; ++i)
+        m_free_frames[i] = m_max_pages-1 - i;
+
+    m_page_frame.assign( n_pages, INVALID_FRAME );
+    m_page_pins.assign( n_pages, 0u );
+
+    // start from a clean LRU
+    m_lru       = LRU<Manager>( m_manager );
+    m_last_page = INVALID_FRAME;
+
+    m_hits      = 0;
+    m_misses    = 0;
+    m_evictions = 0;
+}
+
+// move a resident, unpinned page to the front of the LRU list, or load it if missing
+//
+template <typename T>
+void PageCache<T>::touch(const uint32 page)
+{
+    if (m_page_frame[page] == INVALID_FRAME)
+        ++m_misses;
+    else
+    {
+        ++m_hits;
+
+        // skip the LRU update for pinned pages and for repeated accesses to the most recent one
+        if (m_page_pins[page] || page == m_last_page)
+            return;
+    }
+
+    m_lru.pin( page );
+    m_lru.unpin( page );
+    m_last_page = page;
+}
+
+// fetch the i-th element, loading its page if needed
+//
+template <typename T>
+T PageCache<T>::fetch(const uint64 i)
+{
+    const uint32 page = uint32( i >> m_page_shift );
+
+    ScopedLock lock( &m_mutex );
+
+    touch( page );
+
+    const uint64 frame = m_page_frame[page];
+    return m_frames[ (frame << m_page_shift) + (i & ((1u << m_page_shift)-1u)) ];
+}
+
+// pin a page
+//
+template <typename T>
+void PageCache<T>::pin(const uint32 page)
+{
+    ScopedLock lock( &m_mutex );
+
+    if (m_page_pins[page]++ == 0)
+    {
+        if (m_page_frame[page] == INVALID_FRAME)
+            ++m_misses;
+
+        try
+        {
+            m_lru.pin( page );
+        }
+        catch (...)
+        {
+            --m_page_pins[page];
+            throw;
+        }
+    }
+}
+
+// unpin a page
+//
+template <typename T>
+void PageCache<T>::unpin(const uint32 page)
+{
+    ScopedLock lock( &m_mutex );
+
+    if (--m_page_pins[page] == 0)
+        m_lru.unpin( page );
+}
+
+// reset the hit/miss counters
+//
+template <typename T>
+void PageCache<T>::reset_stats()
+{
+    ScopedLock lock( &m_mutex );
+
+    m_hits      = 0;
+    m_misses    = 0;
+    m_evictions = 0;
+}
+
+// try to load a page in a free frame
+//
+template <typename T>
+bool PageCache<T>::Manager::acquire(const uint32 page)
+{
+    if (m_cache->m_free_frames.empty())
+        return false;
+
+    const uint32 frame = m_cache->m_free_frames.back();
+    m_cache->m_free_frames.pop_back();
+
+    try
+    {
+        m_cache->m_loader->load( page, &m_cache->m_frames[ uint64( frame ) << m_cache->m_page_shift ] );
+    }
+    catch (...)
+    {
+        // give the frame back: the LRU will drop the page itself
+        m_cache->m_free_frames.push_back( frame );
+        throw;
+    }
+    m_cache->m_page_frame[page] = frame;
+    return true;
+}
+
+// evict a page, returning its frame to the free pool
+//
+template <typename T>
+void PageCache<T>::Manager::release(const uint32 page)
+{
+    m_cache->m_free_frames.push_back( m_cache->m_page_frame[page] );
+    m_cache->m_page_frame[page] = INVALID_FRAME;
+
+    if (m_cache->m_last_page == page)
+        m_cache->m_last_page = INVALID_FRAME;
+
+    ++m_cache->m_evictions;
+}
+
+// return true when enough frames are free
+//
+template <typename T>
+bool PageCache<T>::Manager::low_watermark() const
+{
+    return m_cache->m_free_frames.size() >= m_cache->m_low_watermark;
+}
+
+} // namespace nvbio
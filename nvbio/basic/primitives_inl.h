@@ -1165,7 +1165,7 @@ void radix_sort(
     ValueIterator                       values,
     nvbio::vector<host_tag,uint8>&      temp_storage)
 {
-    thrust::sort_by_key( keys, keys + n, values, temp_storage );
+    thrust::sort_by_key( keys, keys + n, values );
 }
 
 // system-wide sort by key
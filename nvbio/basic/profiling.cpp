@@ -0,0 +1,313 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/basic/profiling.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/basic/console.h>
+#include <vector>
+#include <string.h>
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <sys/time.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <pthread.h>
+#define NVBIO_PERF_EVENTS
+#endif
+
+namespace nvbio {
+
+namespace {
+
+// the global region registry
+//
+Mutex                        s_regions_lock;
+std::vector<ProfileRegion*>  s_regions;
+
+// return the wall-clock time in nanoseconds
+//
+int64 profile_time_ns()
+{
+  #if defined(WIN32)
+    LARGE_INTEGER freq, tick;
+    QueryPerformanceFrequency( &freq );
+    QueryPerformanceCounter( &tick );
+    return int64( double( tick.QuadPart ) * 1.0e9 / double( freq.QuadPart ) );
+  #elif defined(__linux__)
+    timespec _time;
+    clock_gettime( CLOCK_MONOTONIC, &_time );
+    return int64( _time.tv_sec ) * 1000000000 + int64( _time.tv_nsec );
+  #else
+    timeval _time;
+    gettimeofday( &_time, NULL );
+    return int64( _time.tv_sec ) * 1000000000 + int64( _time.tv_usec ) * 1000;
+  #endif
+}
+
+#if defined(NVBIO_PERF_EVENTS)
+
+// the per-thread perf_event group
+//
+struct ThreadCounters
+{
+    int    leader;                              // the group leader file descriptor, or -1
+    int    fds[ PROFILE_EVENT_COUNT ];          // per-event file descriptors, or -1
+    uint32 slot[ PROFILE_EVENT_COUNT ];         // position of each event in a group read
+    uint32 n_events;                            // number of events in the group
+};
+
+pthread_key_t  s_counters_key;
+pthread_once_t s_counters_once = PTHREAD_ONCE_INIT;
+
+// close a thread's counters at thread exit
+//
+void close_counters(void* ptr)
+{
+    ThreadCounters* counters = (ThreadCounters*)ptr;
+    for (uint32 e = 0; e < PROFILE_EVENT_COUNT; ++e)
+    {
+        if (counters->fds[e] >= 0)
+            close( counters->fds[e] );
+    }
+    delete counters;
+}
+
+void create_counters_key()
+{
+    pthread_key_create( &s_counters_key, close_counters );
+}
+
+// open a single counter for the calling thread, counting user-space events only
+//
+int open_counter(const uint32 type, const uint64 config, const int group)
+{
+    perf_event_attr attr;
+    memset( &attr, 0, sizeof(attr) );
+    attr.size           = sizeof(attr);
+    attr.type           = type;
+    attr.config         = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return int( syscall( __NR_perf_event_open, &attr, 0, -1, group, 0 ) );
+}
+
+// fetch the calling thread's counters, opening them on first use
+//
+ThreadCounters* thread_counters()
+{
+    pthread_once( &s_counters_once, create_counters_key );
+
+    ThreadCounters* counters = (ThreadCounters*)pthread_getspecific( s_counters_key );
+    if (counters)
+        return counters;
+
+    counters = new ThreadCounters;
+    counters->leader   = -1;
+    counters->n_events = 0;
+
+    const uint32 types[ PROFILE_EVENT_COUNT ] = {
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE,
+        PERF_TYPE_HARDWARE };
+
+    const uint64 configs[ PROFILE_EVENT_COUNT ] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        PERF_COUNT_HW_BRANCH_MISSES };
+
+    // open all events in a single group, so that they can be read atomically;
+    // events unsupported by the CPU (or the hypervisor) are simply skipped
+    for (uint32 e = 0; e < PROFILE_EVENT_COUNT; ++e)
+    {
+        counters->fds[e]  = open_counter( types[e], configs[e], counters->leader );
+        counters->slot[e] = uint32(-1);
+
+        if (counters->fds[e] >= 0)
+        {
+            if (counters->leader < 0)
+                counters->leader = counters->fds[e];
+
+            counters->slot[e] = counters->n_events++;
+        }
+    }
+
+    pthread_setspecific( s_counters_key, counters );
+    return counters;
+}
+
+#endif
+
+} // anonymous namespace
+
+// return the profiling region with the given name, creating it if needed
+//
+ProfileRegion* profile_region(const char* name)
+{
+    ScopedLock lock( &s_regions_lock );
+
+    for (size_t i = 0; i < s_regions.size(); ++i)
+    {
+        if (strcmp( s_regions[i]->name, name ) == 0)
+            return s_regions[i];
+    }
+
+    ProfileRegion* region = new ProfileRegion;
+    memset( region, 0, sizeof(ProfileRegion) );
+    region->name = name;
+
+    s_regions.push_back( region );
+    return region;
+}
+
+// read the calling thread's counters
+//
+void profile_read(ProfileCounters* counters)
+{
+    counters->valid   = 0u;
+    counters->enabled = 0u;
+    counters->running = 0u;
+
+  #if defined(NVBIO_PERF_EVENTS)
+    const ThreadCounters* thread = thread_counters();
+    if (thread->n_events)
+    {
+        // nr, time_enabled, time_running, values[nr]
+        uint64 buffer[ 3 + PROFILE_EVENT_COUNT ];
+
+        const ssize_t size = sizeof(uint64) * (3u + thread->n_events);
+        if (read( thread->leader, buffer, size ) == size)
+        {
+            counters->enabled = buffer[1];
+            counters->running = buffer[2];
+
+            for (uint32 e = 0; e < PROFILE_EVENT_COUNT; ++e)
+            {
+                if (thread->slot[e] != uint32(-1))
+                {
+                    counters->values[e] = buffer[ 3 + thread->slot[e] ];
+                    counters->valid    |= 1u << e;
+                }
+            }
+        }
+    }
+  #endif
+
+    counters->time_ns = profile_time_ns();
+}
+
+// accumulate the counter differences between two snapshots into a region
+//
+void profile_accumulate(ProfileRegion* region, const ProfileCounters& begin, const ProfileCounters& end)
+{
+    const uint32 valid = begin.valid & end.valid;
+
+    // scale the counts up if the group has been multiplexed with other events
+    const uint64 enabled = end.enabled - begin.enabled;
+    const uint64 running = end.running - begin.running;
+    const double scale   = (running && running < enabled) ? double( enabled ) / double( running ) : 1.0;
+
+    ScopedLock lock( &s_regions_lock );
+
+    region->calls++;
+    region->time_ns += uint64( end.time_ns - begin.time_ns );
+
+    for (uint32 e = 0; e < PROFILE_EVENT_COUNT; ++e)
+    {
+        if (valid & (1u << e))
+        {
+            region->values[e]  += uint64( double( end.values[e] - begin.values[e] ) * scale );
+            region->samples[e] += 1u;
+        }
+    }
+}
+
+// print a summary of all profiling regions
+//
+void profile_report(FILE* file)
+{
+    ScopedLock lock( &s_regions_lock );
+
+    if (s_regions.empty())
+        return;
+
+    log_info(file, "  profiling regions:\n");
+    log_info(file, "    %-28s %10s %10s %10s %6s %9s %9s %9s\n",
+        "region", "calls", "time (s)", "Gcycles", "IPC", "LLC-MPKI", "TLB-MPKI", "BR-MPKI");
+
+    for (size_t i = 0; i < s_regions.size(); ++i)
+    {
+        const ProfileRegion* r = s_regions[i];
+
+        char cycles[16] = "-";
+        char ipc[16]    = "-";
+        char mpki[3][16] = { "-", "-", "-" };
+
+        if (r->samples[ PROFILE_CYCLES ])
+            sprintf( cycles, "%.3f", 1.0e-9 * double( r->values[ PROFILE_CYCLES ] ) );
+
+        const uint64 instructions = r->values[ PROFILE_INSTRUCTIONS ];
+        if (r->samples[ PROFILE_INSTRUCTIONS ] && instructions)
+        {
+            if (r->samples[ PROFILE_CYCLES ] && r->values[ PROFILE_CYCLES ])
+                sprintf( ipc, "%.2f", double( instructions ) / double( r->values[ PROFILE_CYCLES ] ) );
+
+            // misses per kilo-instruction
+            const ProfileEvent misses[3] = { PROFILE_LLC_MISSES, PROFILE_DTLB_MISSES, PROFILE_BRANCH_MISSES };
+            for (uint32 m = 0; m < 3; ++m)
+            {
+                if (r->samples[ misses[m] ])
+                    sprintf( mpki[m], "%.3f", 1000.0 * double( r->values[ misses[m] ] ) / double( instructions ) );
+            }
+        }
+
+        log_info(file, "    %-28s %10llu %10.3f %10s %6s %9s %9s %9s\n",
+            r->name,
+            r->calls,
+            1.0e-9 * double( r->time_ns ),
+            cycles,
+            ipc,
+            mpki[0],
+            mpki[1],
+            mpki[2] );
+    }
+}
+
+} // namespace nvbio
@@ -28,6 +28,7 @@
 #pragma once
 
 #include <nvbio/basic/types.h>
+#include <stdio.h>
 
 namespace nvbio {
 
@@ -55,4 +56,130 @@ do { \
 #define NVBIO_STATS(stmnt)
 #endif
 
+///@addtogroup Basic
+///@{
+
+///@defgroup HostProfiling Host Profiling
+/// This module implements host-side profiling regions backed by hardware performance counters.
+/// Each region, when entered and left by a host thread, reads the thread's own counters
+/// (through Linux' perf_event interface) and accumulates the differences in a global per-region
+/// summary, which can be printed with NVBIO_PROFILE_REPORT().
+/// The counters (cycles, instructions, LLC, dTLB and branch misses) allow to tell apart memory-bound
+/// from compute-bound regressions; where the counters are not available (e.g. on other OSs, or when
+/// perf_event_paranoid forbids user-space counting) only the wall-clock time and the number of calls
+/// are tracked.
+///
+/// Regions are meant to cover whole batches of work, as entering and leaving a region costs a couple
+/// of system calls: to account for the work done by all the threads of an OpenMP loop, a region has
+/// to be opened inside the parallel section, e.g.:
+///
+/// \code
+/// #pragma omp parallel
+/// {
+///     NVBIO_PROFILE_REGION( "fm-index/rank" );
+///
+///     #pragma omp for
+///     for (int32 i = 0; i < n; ++i)
+///         ...
+/// }
+/// \endcode
+///
+/// All the macros compile to nothing unless NVBIO_ENABLE_HOST_PROFILING is defined (see the
+/// HOST_PROFILING CMake option).
+///@{
+
+/// the hardware events tracked by profiling regions
+///
+enum ProfileEvent
+{
+    PROFILE_CYCLES          = 0,
+    PROFILE_INSTRUCTIONS    = 1,
+    PROFILE_LLC_MISSES      = 2,
+    PROFILE_DTLB_MISSES     = 3,
+    PROFILE_BRANCH_MISSES   = 4,
+    PROFILE_EVENT_COUNT     = 5
+};
+
+/// a snapshot of the calling thread's event counters
+///
+struct ProfileCounters
+{
+    uint64 values[ PROFILE_EVENT_COUNT ];   ///< per-event counts
+    uint64 enabled;                         ///< time the counters have been enabled
+    uint64 running;                         ///< time the counters have been running on the PMU
+    uint32 valid;                           ///< bitmask of the events which could be read
+    int64  time_ns;                         ///< wall-clock time
+};
+
+/// the accumulated summary of a profiling region
+///
+struct ProfileRegion
+{
+    const char* name;                               ///< region name
+    uint64      calls;                              ///< number of times the region has been left
+    uint64      time_ns;                            ///< total wall-clock time, summed over all threads
+    uint64      values[ PROFILE_EVENT_COUNT ];      ///< total event counts, summed over all threads
+    uint64      samples[ PROFILE_EVENT_COUNT ];     ///< number of calls in which each event could be read
+};
+
+/// return the profiling region with the given name, creating it if needed;
+/// the name must be a string with static storage duration
+///
+ProfileRegion* profile_region(const char* name);
+
+/// read the calling thread's counters, opening them on first use
+///
+void profile_read(ProfileCounters* counters);
+
+/// accumulate the counter differences between two snapshots into a region
+///
+void profile_accumulate(ProfileRegion* region, const ProfileCounters& begin, const ProfileCounters& end);
+
+/// print a summary of all profiling regions
+///
+void profile_report(FILE* file);
+
+/// a helper class to profile a scope
+///
+struct ScopedProfileRegion
+{
+    /// constructor
+    ///
+    ScopedProfileRegion(ProfileRegion* region) : m_region( region ) { profile_read( &m_begin ); }
+
+    /// destructor
+    ///
+    ~ScopedProfileRegion()
+    {
+        ProfileCounters end;
+        profile_read( &end );
+        profile_accumulate( m_region, m_begin, end );
+    }
+
+private:
+    ProfileRegion*  m_region;
+    ProfileCounters m_begin;
+};
+
+#define NVBIO_PROFILE_CAT_(a,b) a ## b
+#define NVBIO_PROFILE_CAT(a,b)  NVBIO_PROFILE_CAT_(a,b)
+
+#if defined(NVBIO_ENABLE_HOST_PROFILING) && !defined(__CUDA_ARCH__)
+/// open a profiling region covering the rest of the enclosing scope
+///
+#define NVBIO_PROFILE_REGION(name) \
+    static nvbio::ProfileRegion* NVBIO_PROFILE_CAT(nvbio_profile_region_,__LINE__) = nvbio::profile_region( name ); \
+    nvbio::ScopedProfileRegion NVBIO_PROFILE_CAT(nvbio_profile_scope_,__LINE__)( NVBIO_PROFILE_CAT(nvbio_profile_region_,__LINE__) )
+
+/// print the summary of all profiling regions
+///
+#define NVBIO_PROFILE_REPORT(file)  nvbio::profile_report( file )
+#else
+#define NVBIO_PROFILE_REGION(name)
+#define NVBIO_PROFILE_REPORT(file)
+#endif
+
+///@} HostProfiling
+///@} Basic
+
 } // namespace nvbio
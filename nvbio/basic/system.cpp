@@ -25,7 +25,11 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <nvbio/basic/types.h>
+#include <nvbio/basic/system.h>
+#include <nvbio/basic/omp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
 
 #if defined(_WIN32)
 #include <windows.h>
@@ -34,6 +38,7 @@
 #elif defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
 #include <unistd.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
 #include <stdio.h>
 
 #endif
@@ -59,4 +64,115 @@ uint64 peak_resident_memory()
   #endif
 }
 
+namespace {
+
+// blocks at least this large are mapped directly from the OS
+const uint64 HOST_MAP_THRESHOLD = 1u << 20;
+
+// the granularity of first-touch and parallel copies
+const uint64 HOST_PAGE_SIZE = 4096u;
+
+} // anonymous namespace
+
+// allocate a block of uninitialized host memory
+//
+void* host_alloc(const uint64 bytes, const uint32 flags)
+{
+    if (bytes == 0)
+        return NULL;
+
+    void* ptr = NULL;
+
+  #if defined(_WIN32)
+    if (bytes >= HOST_MAP_THRESHOLD)
+        ptr = VirtualAlloc( NULL, SIZE_T(bytes), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE );
+    else
+        ptr = malloc( size_t(bytes) );
+  #elif defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+    if (bytes >= HOST_MAP_THRESHOLD)
+    {
+        ptr = mmap( NULL, size_t(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if (ptr == MAP_FAILED)
+            ptr = NULL;
+      #if defined(MADV_HUGEPAGE)
+        else if (flags & HOST_ALLOC_HUGE_PAGES)
+            madvise( ptr, size_t(bytes), MADV_HUGEPAGE ); // a hint: failures are not an error
+      #endif
+    }
+    else
+        ptr = malloc( size_t(bytes) );
+  #else
+    ptr = malloc( size_t(bytes) );
+  #endif
+
+    if (ptr == NULL)
+        throw std::bad_alloc();
+
+    if (flags & HOST_ALLOC_FIRST_TOUCH)
+        first_touch( ptr, bytes );
+
+    return ptr;
+}
+
+// release a block allocated with host_alloc()
+//
+void host_free(void* ptr, const uint64 bytes)
+{
+    if (ptr == NULL)
+        return;
+
+  #if defined(_WIN32)
+    if (bytes >= HOST_MAP_THRESHOLD)
+        VirtualFree( ptr, 0, MEM_RELEASE );
+    else
+        free( ptr );
+  #elif defined(__unix__) || defined(__unix) || defined(unix) || (defined(__APPLE__) && defined(__MACH__))
+    if (bytes >= HOST_MAP_THRESHOLD)
+        munmap( ptr, size_t(bytes) );
+    else
+        free( ptr );
+  #else
+    free( ptr );
+  #endif
+}
+
+// touch all the pages of a block with a parallel static schedule
+//
+void first_touch(void* ptr, const uint64 bytes)
+{
+    // small blocks are not worth a parallel region
+    if (bytes < HOST_MAP_THRESHOLD)
+        return;
+
+    volatile uint8* base    = (volatile uint8*)ptr;
+    const int64     n_pages = int64( (bytes + HOST_PAGE_SIZE-1) / HOST_PAGE_SIZE );
+
+    // rewrite the first byte of each page with its own value, which is harmless
+    // for blocks which already hold data
+    #pragma omp parallel for schedule(static)
+    for (int64 p = 0; p < n_pages; ++p)
+        base[ p * HOST_PAGE_SIZE ] = base[ p * HOST_PAGE_SIZE ];
+}
+
+// copy a block of memory in parallel
+//
+void parallel_copy(void* dst, const void* src, const uint64 bytes)
+{
+    if (bytes < HOST_MAP_THRESHOLD)
+    {
+        memcpy( dst, src, size_t(bytes) );
+        return;
+    }
+
+    const int64 n_pages = int64( (bytes + HOST_PAGE_SIZE-1) / HOST_PAGE_SIZE );
+
+    #pragma omp parallel for schedule(static)
+    for (int64 p = 0; p < n_pages; ++p)
+    {
+        const uint64 begin = uint64(p) * HOST_PAGE_SIZE;
+        const uint64 end   = begin + HOST_PAGE_SIZE < bytes ? begin + HOST_PAGE_SIZE : bytes;
+        memcpy( (uint8*)dst + begin, (const uint8*)src + begin, size_t(end - begin) );
+    }
+}
+
 } // namespace nvbio
@@ -29,8 +29,70 @@
 
 #include <nvbio/basic/types.h>
 
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
 namespace nvbio {
 
 uint64 peak_resident_memory();
 
+/// host allocation flags
+///
+enum HostAllocFlags
+{
+    HOST_ALLOC_DEFAULT     = 0x0000,   ///< plain allocation
+    HOST_ALLOC_FIRST_TOUCH = 0x0001,   ///< touch fresh pages in parallel, spreading them across the NUMA nodes of the worker threads
+    HOST_ALLOC_HUGE_PAGES  = 0x0002,   ///< ask for transparent huge pages backing, where supported
+};
+
+/// allocate a block of uninitialized host memory; large blocks are mapped directly
+/// from the OS, so that their pages are only committed when first touched
+///
+/// \param bytes        the size of the block
+/// \param flags        a combination of HostAllocFlags
+///
+void* host_alloc(const uint64 bytes, const uint32 flags = HOST_ALLOC_DEFAULT);
+
+/// release a block allocated with host_alloc()
+///
+/// \param ptr          the block
+/// \param bytes        the size the block was allocated with
+///
+void host_free(void* ptr, const uint64 bytes);
+
+/// touch all the pages of a block with a parallel static schedule, so that
+/// each page gets placed on the NUMA node of the thread which will later
+/// process it in equally scheduled loops
+///
+void first_touch(void* ptr, const uint64 bytes);
+
+/// copy a block of memory in parallel, with the same static schedule used by first_touch()
+///
+void parallel_copy(void* dst, const void* src, const uint64 bytes);
+
+/// issue a software prefetch for the cache line containing the given address,
+/// in anticipation of a read; a no-op where no prefetch intrinsic is available
+///
+NVBIO_FORCEINLINE void host_prefetch(const void* ptr)
+{
+#if defined(_MSC_VER)
+    _mm_prefetch( (const char*)ptr, _MM_HINT_T0 );
+#elif defined(__GNUC__)
+    __builtin_prefetch( ptr, 0, 3 );
+#endif
+}
+
+/// issue a software prefetch for the cache line containing the given address,
+/// in anticipation of a write
+///
+NVBIO_FORCEINLINE void host_prefetch_write(const void* ptr)
+{
+#if defined(_MSC_VER)
+    _mm_prefetch( (const char*)ptr, _MM_HINT_T0 );
+#elif defined(__GNUC__)
+    __builtin_prefetch( ptr, 1, 3 );
+#endif
+}
+
 } // namespace nvbio
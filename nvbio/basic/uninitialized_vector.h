@@ -0,0 +1,252 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*! \file uninitialized_vector.h
+ *   \brief Define host vectors with uninitialized, NUMA-aware growth
+ */
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/system.h>
+#include <nvbio/basic/vector_view.h>
+#include <string.h>
+#include <algorithm>
+
+namespace nvbio {
+
+///@addtogroup Basic
+///@{
+
+///
+/// A dynamic host vector of POD elements which, unlike nvbio::vector<host_tag,T>,
+/// does not value-initialize its elements on growth.
+/// Large buffers are mapped directly from the OS and, unless disabled, first-touched
+/// in parallel, so that their pages get spread across the NUMA nodes of the OpenMP
+/// threads which later process them with static schedules; existing contents are
+/// moved with the same schedule on reallocation.
+/// Optionally, buffers can be backed by transparent huge pages.
+///
+/// The element type must be trivially copyable and destructible.
+///
+///\code
+/// uninitialized_vector<uint32> occ( HOST_ALLOC_FIRST_TOUCH | HOST_ALLOC_HUGE_PAGES );
+/// occ.resize( n_occ );    // no serial zero-fill
+///
+/// #pragma omp parallel for
+/// for (int64 i = 0; i < int64( n_occ ); ++i)
+///     occ[i] = ...;
+///\endcode
+///
+template <typename T>
+struct uninitialized_vector
+{
+    typedef host_tag                                    system_tag;
+
+    typedef T                                           value_type;
+    typedef T*                                          iterator;
+    typedef const T*                                    const_iterator;
+    typedef T&                                          reference;
+    typedef const T&                                    const_reference;
+
+    typedef nvbio::vector_view<T*,uint64>              plain_view_type;
+    typedef nvbio::vector_view<const T*,uint64>  const_plain_view_type;
+
+    /// constructor
+    ///
+    /// \param flags       a combination of HostAllocFlags
+    ///
+    explicit uninitialized_vector(const uint32 flags = HOST_ALLOC_FIRST_TOUCH) :
+        m_ptr( NULL ), m_size( 0 ), m_capacity( 0 ), m_flags( flags ) {}
+
+    /// constructor
+    ///
+    /// \param size        the initial size, left uninitialized
+    /// \param flags       a combination of HostAllocFlags
+    ///
+    explicit uninitialized_vector(const uint64 size, const uint32 flags = HOST_ALLOC_FIRST_TOUCH) :
+        m_ptr( NULL ), m_size( 0 ), m_capacity( 0 ), m_flags( flags ) { resize( size ); }
+
+    /// copy constructor
+    ///
+    uninitialized_vector(const uninitialized_vector& other) :
+        m_ptr( NULL ), m_size( 0 ), m_capacity( 0 ), m_flags( other.m_flags ) { *this = other; }
+
+    /// destructor
+    ///
+    ~uninitialized_vector() { host_free( m_ptr, m_capacity * sizeof(T) ); }
+
+    /// assignment operator
+    ///
+    uninitialized_vector& operator=(const uninitialized_vector& other)
+    {
+        if (this != &other)
+        {
+            m_size = 0;
+            resize( other.size() );
+            parallel_copy( m_ptr, other.m_ptr, m_size * sizeof(T) );
+        }
+        return *this;
+    }
+
+    /// reserve storage for at least n elements
+    ///
+    void reserve(const uint64 n)
+    {
+        if (n <= m_capacity)
+            return;
+
+        T* ptr = (T*)host_alloc( n * sizeof(T), m_size ? (m_flags & ~HOST_ALLOC_FIRST_TOUCH) : m_flags );
+
+        // moving the old contents takes care of first-touching their pages
+        if (m_size)
+        {
+            parallel_copy( ptr, m_ptr, m_size * sizeof(T) );
+            if (m_flags & HOST_ALLOC_FIRST_TOUCH)
+                first_touch( ptr + m_size, (n - m_size) * sizeof(T) );
+        }
+
+        host_free( m_ptr, m_capacity * sizeof(T) );
+        m_ptr      = ptr;
+        m_capacity = n;
+    }
+
+    /// resize, leaving any new elements uninitialized
+    ///
+    void resize(const uint64 n)
+    {
+        if (n > m_capacity)
+            reserve( n );
+
+        m_size = n;
+    }
+
+    /// resize, filling any new elements with a given value in parallel
+    ///
+    void resize(const uint64 n, const T val)
+    {
+        const uint64 old_size = m_size;
+        resize( n );
+
+        #pragma omp parallel for schedule(static)
+        for (int64 i = int64( old_size ); i < int64( n ); ++i)
+            m_ptr[i] = val;
+    }
+
+    /// add an element at the end, growing geometrically
+    ///
+    void push_back(const T val)
+    {
+        if (m_size == m_capacity)
+            reserve( m_capacity ? m_capacity * 2u : 16u );
+
+        m_ptr[ m_size++ ] = val;
+    }
+
+    /// clear the vector, keeping its storage
+    ///
+    void clear() { m_size = 0; }
+
+    /// release all storage
+    ///
+    void release()
+    {
+        host_free( m_ptr, m_capacity * sizeof(T) );
+        m_ptr      = NULL;
+        m_size     = 0;
+        m_capacity = 0;
+    }
+
+    /// swap with another vector
+    ///
+    void swap(uninitialized_vector& other)
+    {
+        std::swap( m_ptr,      other.m_ptr );
+        std::swap( m_size,     other.m_size );
+        std::swap( m_capacity, other.m_capacity );
+        std::swap( m_flags,    other.m_flags );
+    }
+
+    uint64              size()      const { return m_size; }
+    uint64              capacity()  const { return m_capacity; }
+    bool                empty()     const { return m_size == 0; }
+    uint32              flags()     const { return m_flags; }
+
+    T*                  data()            { return m_ptr; }
+    const T*            data()      const { return m_ptr; }
+
+    iterator            begin()           { return m_ptr; }
+    const_iterator      begin()     const { return m_ptr; }
+    iterator            end()             { return m_ptr + m_size; }
+    const_iterator      end()       const { return m_ptr + m_size; }
+
+    reference           operator[] (const uint64 i)       { return m_ptr[i]; }
+    const_reference     operator[] (const uint64 i) const { return m_ptr[i]; }
+
+    reference           front()           { return m_ptr[0]; }
+    const_reference     front()     const { return m_ptr[0]; }
+    reference           back()            { return m_ptr[ m_size-1 ]; }
+    const_reference     back()      const { return m_ptr[ m_size-1 ]; }
+
+    /// conversion to plain_view_type
+    ///
+    operator plain_view_type() { return plain_view_type( m_size, m_ptr ); }
+
+    /// conversion to const_plain_view_type
+    ///
+    operator const_plain_view_type() const { return const_plain_view_type( m_size, m_ptr ); }
+
+private:
+    T*      m_ptr;
+    uint64  m_size;
+    uint64  m_capacity;
+    uint32  m_flags;
+};
+
+/// return the plain view of an uninitialized_vector
+///
+template <typename T>
+vector_view<T*,uint64> plain_view(uninitialized_vector<T>& vec) { return vector_view<T*,uint64>( vec.size(), vec.data() ); }
+
+/// return the plain view of an uninitialized_vector
+///
+template <typename T>
+vector_view<const T*,uint64> plain_view(const uninitialized_vector<T>& vec) { return vector_view<const T*,uint64>( vec.size(), vec.data() ); }
+
+/// return the raw pointer of an uninitialized_vector
+///
+template <typename T>
+T* raw_pointer(uninitialized_vector<T>& vec) { return vec.data(); }
+
+/// return the raw pointer of an uninitialized_vector
+///
+template <typename T>
+const T* raw_pointer(const uninitialized_vector<T>& vec) { return vec.data(); }
+
+///@} Basic
+
+} // namespace nvbio
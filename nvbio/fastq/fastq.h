@@ -29,6 +29,7 @@
 
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/profiling.h>
 #include <vector>
 #include <stdio.h>
 #include <stdlib.h>
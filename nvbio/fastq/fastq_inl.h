@@ -109,6 +109,8 @@ template <typename FASTQ_stream>
 template <typename Writer>
 uint32 FASTQ_reader<FASTQ_stream>::read(const uint32 n_reads, Writer& writer)
 {
+    NVBIO_PROFILE_REGION( "fastq/read" );
+
     uint32 n = 0;
     uint8 marker;
 
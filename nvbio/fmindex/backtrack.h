@@ -125,6 +125,8 @@ void hamming_backtrack(
             {
                 if (range.x <= range.y)
                     delegate( range );
+
+                continue;
             }
 
             if (cost < mismatches)
@@ -0,0 +1,102 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/fmindex/fmindex.h>
+
+namespace nvbio {
+
+///@addtogroup FMIndex
+///@{
+
+/// the default number of LF-walks each thread of a batched locate keeps in flight
+///
+static const uint32 BATCHED_LOCATE_LANES = 16u;
+
+/// locate a batch of suffix array rows from the host, i.e. compute
+/// <i>output[i] = SA[rows[i]]</i> for each i in [0,n_rows).
+///\par
+/// Rather than walking the LF mapping of each row to completion before starting the next,
+/// the batch is split in one chunk per thread, each chunk is sorted by row so that neighbouring
+/// walks start from nearby blocks of the BWT and duplicate rows collapse into a single walk,
+/// and LANES walks are advanced round-robin, prefetching the BWT word, the occurrence block
+/// and the sampled SA entry each of them will touch at its next step.
+/// This way the cache misses of independent walks overlap instead of being paid one at a time.
+///
+/// \tparam LANES           the number of interleaved walks per thread
+///
+/// \param fmi              the FM-index
+/// \param n_rows           the number of rows to locate
+/// \param rows             the input rows
+/// \param output           the output linear coordinates, one per row
+///
+template <uint32 LANES, typename fm_index_type, typename row_iterator, typename output_iterator>
+void batched_locate(
+    const fm_index_type&    fmi,
+    const uint64            n_rows,
+    const row_iterator      rows,
+          output_iterator   output);
+
+/// locate a batch of suffix array rows from the host, using the default
+/// number of interleaved walks
+///
+template <typename fm_index_type, typename row_iterator, typename output_iterator>
+void batched_locate(
+    const fm_index_type&    fmi,
+    const uint64            n_rows,
+    const row_iterator      rows,
+          output_iterator   output)
+{
+    batched_locate<BATCHED_LOCATE_LANES>( fmi, n_rows, rows, output );
+}
+
+/// locate all the rows of a batch of suffix array ranges from the host: the
+/// output holds the linear coordinates of the occurrences of each range, concatenated
+/// in range order (empty ranges, i.e. ranges with <i>y < x</i>, are skipped).
+///
+/// \param fmi              the FM-index
+/// \param n_ranges         the number of ranges
+/// \param ranges           the input (inclusive) ranges
+/// \param output           the output linear coordinates
+/// \return                 the number of located occurrences
+///
+template <typename fm_index_type, typename range_iterator, typename output_iterator>
+uint64 batched_locate_ranges(
+    const fm_index_type&    fmi,
+    const uint32            n_ranges,
+    const range_iterator    ranges,
+          output_iterator   output);
+
+///@} FMIndex
+
+} // namespace nvbio
+
+#include <nvbio/fmindex/batched_locate_inl.h>
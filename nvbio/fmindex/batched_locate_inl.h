@@ -0,0 +1,335 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/system.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/packedstream.h>
+#include <nvbio/basic/deinterleaved_iterator.h>
+#include <nvbio/fmindex/ssa.h>
+#include <vector>
+#include <algorithm>
+
+namespace nvbio {
+namespace priv {
+
+// a helper to prefetch the i-th element of an iterator from the host: a no-op by default,
+// specialized for plain pointers and for the deinterleaved views over them
+//
+template <typename Iterator>
+struct locate_prefetcher
+{
+    NVBIO_FORCEINLINE static void prefetch(const Iterator it, const uint64 i) {}
+};
+template <typename T>
+struct locate_prefetcher<T*>
+{
+    NVBIO_FORCEINLINE static void prefetch(const T* it, const uint64 i) { host_prefetch( it + i ); }
+};
+template <uint32 STRIDE, uint32 WHICH, typename BaseIterator>
+struct locate_prefetcher< deinterleaved_iterator<STRIDE,WHICH,BaseIterator> >
+{
+    NVBIO_FORCEINLINE static void prefetch(const deinterleaved_iterator<STRIDE,WHICH,BaseIterator> it, const uint64 i)
+    {
+        locate_prefetcher<BaseIterator>::prefetch( it.m_it, i*STRIDE + WHICH );
+    }
+};
+
+// a helper to prefetch the word holding the i-th symbol of a BWT
+//
+template <typename TextType>
+struct locate_text_prefetcher
+{
+    NVBIO_FORCEINLINE static void prefetch(const TextType text, const uint64 i) {}
+};
+template <typename InputStream, typename Symbol, uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename IndexType>
+struct locate_text_prefetcher< PackedStream<InputStream,Symbol,SYMBOL_SIZE,BIG_ENDIAN,IndexType> >
+{
+    typedef PackedStream<InputStream,Symbol,SYMBOL_SIZE,BIG_ENDIAN,IndexType> text_type;
+
+    NVBIO_FORCEINLINE static void prefetch(const text_type text, const uint64 i)
+    {
+        locate_prefetcher<InputStream>::prefetch( text.stream(), (uint64( text.index() ) + i) / text_type::SYMBOLS_PER_WORD );
+    }
+};
+
+// a helper to prefetch the sampled SA entry of row i, if there is one
+//
+template <typename SSAType>
+struct locate_ssa_prefetcher
+{
+    NVBIO_FORCEINLINE static void prefetch(const SSAType ssa, const uint64 i) {}
+};
+template <uint32 K, typename Iterator>
+struct locate_ssa_prefetcher< SSA_index_multiple_context<K,Iterator> >
+{
+    NVBIO_FORCEINLINE static void prefetch(const SSA_index_multiple_context<K,Iterator> ssa, const uint64 i)
+    {
+        if (ssa.has( i ))
+            locate_prefetcher<Iterator>::prefetch( ssa.m_ssa, i / K );
+    }
+};
+
+// prefetch everything the next step of an LF-walk currently sitting on row j is going to read
+//
+template <typename fm_index_type>
+NVBIO_FORCEINLINE void locate_prefetch(const fm_index_type& fmi, const typename fm_index_type::index_type j)
+{
+    typedef typename fm_index_type::index_type              index_type;
+    typedef typename fm_index_type::rank_dictionary_type    rank_dict_type;
+    typedef typename fm_index_type::suffix_array_type       suffix_array_type;
+    typedef typename rank_dict_type::text_type              text_type;
+    typedef typename rank_dict_type::occ_iterator           occ_iterator;
+    typedef typename std::iterator_traits<occ_iterator>::value_type occ_value_type;
+
+    // the number of occurrence counters packed in each element of the occurrence table
+    const uint32 OCC_DIM = vector_traits<occ_value_type>::DIM;
+
+    locate_ssa_prefetcher<suffix_array_type>::prefetch( fmi.sa(), j );
+
+    if (j == fmi.primary())
+        return;
+
+    // the BWT doesn't store $, so all rows past the primary are shifted by one
+    const index_type k = j < fmi.primary() ? j : j-1;
+
+    const rank_dict_type dict = fmi.rank_dict();
+    locate_text_prefetcher<text_type>::prefetch( dict.text(), k );
+    locate_prefetcher<occ_iterator>::prefetch(
+        dict.occ(),
+        (uint64( k / rank_dict_type::BLOCK_INTERVAL ) * rank_dict_type::SYMBOL_COUNT) / OCC_DIM );
+}
+
+// a row to locate, together with its position in the output
+//
+template <typename index_type>
+struct locate_item
+{
+    index_type  row;
+    uint64      slot;
+};
+
+// order locate items by row
+//
+struct locate_item_less
+{
+    template <typename item_type>
+    bool operator() (const item_type& a, const item_type& b) const { return a.row < b.row; }
+};
+
+// the state of an in-flight LF-walk, shared by the items [begin,end) which refer to the same row
+//
+template <typename index_type>
+struct locate_lane
+{
+    index_type  row;
+    index_type  steps;
+    uint64      begin;
+    uint64      end;
+};
+
+// start a walk from the next distinct row of a sorted list of items
+//
+template <typename fm_index_type>
+NVBIO_FORCEINLINE void locate_start_walk(
+    const fm_index_type&                                            fmi,
+    const locate_item<typename fm_index_type::index_type>*          items,
+    const uint64                                                    n_items,
+          uint64&                                                   next,
+          locate_lane<typename fm_index_type::index_type>&          lane)
+{
+    lane.row   = items[ next ].row;
+    lane.steps = 0;
+    lane.begin = next;
+
+    // all duplicates of this row share the same walk
+    for (++next; next < n_items && items[ next ].row == lane.row; ++next) {}
+
+    lane.end = next;
+
+    locate_prefetch( fmi, lane.row );
+}
+
+// locate a sorted list of items, advancing LANES LF-walks round-robin
+//
+template <uint32 LANES, typename fm_index_type, typename output_iterator>
+void locate_walks(
+    const fm_index_type&                                    fmi,
+    const locate_item<typename fm_index_type::index_type>*  items,
+    const uint64                                            n_items,
+          output_iterator                                   output)
+{
+    typedef typename fm_index_type::index_type  index_type;
+
+    const typename fm_index_type::suffix_array_type sa  = fmi.sa();
+    const typename fm_index_type::bwt_type          bwt = fmi.bwt();
+    const index_type                                primary = fmi.primary();
+
+    locate_lane<index_type> lanes[LANES];
+    uint32 n_lanes = 0;
+    uint64 next    = 0;
+
+    while (n_lanes < LANES && next < n_items)
+        locate_start_walk( fmi, items, n_items, next, lanes[ n_lanes++ ] );
+
+    while (n_lanes)
+    {
+        for (uint32 l = 0; l < n_lanes;)
+        {
+            locate_lane<index_type>& lane = lanes[l];
+
+            index_type suffix;
+            if (sa.fetch( lane.row, suffix ))
+            {
+                // the walk reached a sampled row: write out the result for all its items
+                const index_type loc = suffix + lane.steps;
+                for (uint64 i = lane.begin; i < lane.end; ++i)
+                    output[ items[i].slot ] = loc;
+
+                // and either reuse the lane for a new walk, or retire it
+                if (next < n_items)
+                {
+                    locate_start_walk( fmi, items, n_items, next, lane );
+                    ++l;
+                }
+                else
+                    lane = lanes[ --n_lanes ];
+            }
+            else
+            {
+                // take one LF step, exactly as locate() does
+                if (lane.row != primary)
+                {
+                    const uint8 c = lane.row < primary ? bwt[ lane.row ] : bwt[ lane.row-1 ];
+                    lane.row = fmi.L2(c) + rank( fmi, lane.row, c );
+                }
+                else
+                    lane.row = 0;
+
+                ++lane.steps;
+
+                // and prefetch what the next step is going to need
+                locate_prefetch( fmi, lane.row );
+                ++l;
+            }
+        }
+    }
+}
+
+} // namespace priv
+
+// locate a batch of suffix array rows from the host
+//
+template <uint32 LANES, typename fm_index_type, typename row_iterator, typename output_iterator>
+void batched_locate(
+    const fm_index_type&    fmi,
+    const uint64            n_rows,
+    const row_iterator      rows,
+          output_iterator   output)
+{
+    typedef typename fm_index_type::index_type  index_type;
+    typedef priv::locate_item<index_type>       item_type;
+
+    if (n_rows == 0)
+        return;
+
+    // split the batch in one chunk per thread, avoiding chunks too small to amortize the sorting
+    const uint64 MIN_CHUNK = 1024u;
+    const uint32 n_chunks  = uint32( nvbio::max(
+        nvbio::min( uint64( omp_get_max_threads() ), util::divide_ri( n_rows, MIN_CHUNK ) ),
+        uint64(1u) ) );
+    const uint64 chunk_size = util::divide_ri( n_rows, uint64( n_chunks ) );
+
+    std::vector<item_type> items( n_rows );
+
+    #pragma omp parallel for
+    for (int32 chunk = 0; chunk < int32( n_chunks ); ++chunk)
+    {
+        const uint64 begin = uint64( chunk ) * chunk_size;
+        const uint64 end   = nvbio::min( begin + chunk_size, n_rows );
+        if (begin >= end)
+            continue;
+
+        item_type* chunk_items = &items[0] + begin;
+
+        for (uint64 i = begin; i < end; ++i)
+        {
+            chunk_items[i - begin].row  = rows[i];
+            chunk_items[i - begin].slot = i;
+        }
+
+        // sort the chunk by row, so that consecutive walks start from neighbouring BWT blocks
+        // and duplicate rows become adjacent
+        std::sort( chunk_items, chunk_items + (end - begin), priv::locate_item_less() );
+
+        priv::locate_walks<LANES>( fmi, chunk_items, end - begin, output );
+    }
+}
+
+// locate all the rows of a batch of suffix array ranges from the host
+//
+template <typename fm_index_type, typename range_iterator, typename output_iterator>
+uint64 batched_locate_ranges(
+    const fm_index_type&    fmi,
+    const uint32            n_ranges,
+    const range_iterator    ranges,
+          output_iterator   output)
+{
+    typedef typename fm_index_type::index_type  index_type;
+    typedef typename fm_index_type::range_type  range_type;
+
+    // compute the output offset of each range
+    std::vector<uint64> offsets( n_ranges + 1u );
+    offsets[0] = 0u;
+    for (uint32 r = 0; r < n_ranges; ++r)
+    {
+        const range_type range = ranges[r];
+        offsets[r+1] = offsets[r] + (range.y >= range.x ? uint64( 1u + range.y - range.x ) : 0u);
+    }
+
+    const uint64 n_rows = offsets[ n_ranges ];
+    if (n_rows == 0)
+        return 0u;
+
+    // expand the ranges into their rows
+    std::vector<index_type> rows( n_rows );
+
+    #pragma omp parallel for
+    for (int32 r = 0; r < int32( n_ranges ); ++r)
+    {
+        const range_type range = ranges[r];
+        for (uint64 i = offsets[r]; i < offsets[r+1]; ++i)
+            rows[i] = index_type( range.x + (i - offsets[r]) );
+    }
+
+    batched_locate( fmi, n_rows, &rows[0], output );
+    return n_rows;
+}
+
+} // namespace nvbio
@@ -86,6 +86,54 @@ void extend_backwards(
     typename fm_index<TRankDictionary2,TSuffixArray2>::range_type&  r_range,
     uint8                                                           c);
 
+/// forward extension using a bidirectional FM-index, extending the range of a pattern P
+/// to the ranges of all the patterns Pc, for c in [0,4), with a single rank query.
+///
+/// \param f_fmi    forward FM-index
+/// \param r_fmi    reverse FM-index
+/// \param f_range  current forward range
+/// \param r_range  current reverse range
+/// \param f_ranges output forward ranges, one for each character
+/// \param r_ranges output reverse ranges, one for each character
+///
+template <
+    typename TRankDictionary1,
+    typename TSuffixArray1,
+    typename TRankDictionary2,
+    typename TSuffixArray2>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void extend_forward_all(
+    const fm_index<TRankDictionary1,TSuffixArray1>&                         f_fmi,
+    const fm_index<TRankDictionary2,TSuffixArray2>&                         r_fmi,
+    const typename fm_index<TRankDictionary1,TSuffixArray1>::range_type     f_range,
+    const typename fm_index<TRankDictionary2,TSuffixArray2>::range_type     r_range,
+    typename fm_index<TRankDictionary1,TSuffixArray1>::range_type*          f_ranges,
+    typename fm_index<TRankDictionary2,TSuffixArray2>::range_type*          r_ranges);
+
+/// backwards extension using a bidirectional FM-index, extending the range of a pattern P
+/// to the ranges of all the patterns cP, for c in [0,4), with a single rank query.
+///
+/// \param f_fmi    forward FM-index
+/// \param r_fmi    reverse FM-index
+/// \param f_range  current forward range
+/// \param r_range  current reverse range
+/// \param f_ranges output forward ranges, one for each character
+/// \param r_ranges output reverse ranges, one for each character
+///
+template <
+    typename TRankDictionary1,
+    typename TSuffixArray1,
+    typename TRankDictionary2,
+    typename TSuffixArray2>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void extend_backwards_all(
+    const fm_index<TRankDictionary1,TSuffixArray1>&                         f_fmi,
+    const fm_index<TRankDictionary2,TSuffixArray2>&                         r_fmi,
+    const typename fm_index<TRankDictionary1,TSuffixArray1>::range_type     f_range,
+    const typename fm_index<TRankDictionary2,TSuffixArray2>::range_type     r_range,
+    typename fm_index<TRankDictionary1,TSuffixArray1>::range_type*          f_ranges,
+    typename fm_index<TRankDictionary2,TSuffixArray2>::range_type*          r_ranges);
+
 ///@} // end of the FMIndex group
 
 } // namespace nvbio
@@ -55,8 +55,9 @@ void extend_forward(
     typedef typename fm_index<TRankDictionary1,TSuffixArray1>::range_type f_range_type;
     typedef typename fm_index<TRankDictionary2,TSuffixArray2>::range_type r_range_type;
 
-    // find the number of suffixes in T that start with Pd, for d < c
-    uint32 x = 0;
+    // find the number of suffixes in T that start with Pd, for d < c, plus the suffix P$
+    // if P is a suffix of T - i.e. if P^R is a prefix of T^R
+    uint32 x = (r_range.x <= r_fmi.primary() && r_fmi.primary() <= r_range.y) ? 1u : 0u;
     for (uint32 d = 0; d < c; ++d)
     {
         // search for (Pd)^R = dP^R in r_fmi
@@ -112,8 +113,9 @@ void extend_backwards(
     typedef typename fm_index<TRankDictionary1,TSuffixArray1>::range_type f_range_type;
     typedef typename fm_index<TRankDictionary2,TSuffixArray2>::range_type r_range_type;
 
-    // find the number of suffixes in T that start with dP, for d < c
-    uint32 x = 0;
+    // find the number of suffixes in T^R that start with P^Rd, for d < c, plus the suffix P^R$
+    // if P is a prefix of T
+    uint32 x = (f_range.x <= f_fmi.primary() && f_fmi.primary() <= f_range.y) ? 1u : 0u;
     for (uint32 d = 0; d < c; ++d)
     {
         // search for dP in f_fmi
@@ -143,4 +145,88 @@ void extend_backwards(
     r_range.x = r_range.x + x;
 }
 
+// \relates fm_index
+// forward extension using a bidirectional FM-index, extending the range of a pattern P
+// to the ranges of all the patterns Pc, for c in [0,4), with a single rank query.
+//
+template <
+    typename TRankDictionary1,
+    typename TSuffixArray1,
+    typename TRankDictionary2,
+    typename TSuffixArray2>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void extend_forward_all(
+    const fm_index<TRankDictionary1,TSuffixArray1>&                         f_fmi,
+    const fm_index<TRankDictionary2,TSuffixArray2>&                         r_fmi,
+    const typename fm_index<TRankDictionary1,TSuffixArray1>::range_type     f_range,
+    const typename fm_index<TRankDictionary2,TSuffixArray2>::range_type     r_range,
+    typename fm_index<TRankDictionary1,TSuffixArray1>::range_type*          f_ranges,
+    typename fm_index<TRankDictionary2,TSuffixArray2>::range_type*          r_ranges)
+{
+    typedef typename fm_index<TRankDictionary2,TSuffixArray2>::index_type   r_index_type;
+    typedef typename TRankDictionary2::vec4_type                            vec4_type;
+
+    // count the occurrences of all characters in the reverse range, i.e. of all (Pc)^R = cP^R
+    vec4_type cnt_l, cnt_h;
+    rank4( r_fmi, make_vector( r_range.x-1, r_range.y ), &cnt_l, &cnt_h );
+
+    // the suffix P$ comes first, if P is a suffix of T - i.e. if P^R is a prefix of T^R
+    r_index_type x = (r_range.x <= r_fmi.primary() && r_fmi.primary() <= r_range.y) ? 1u : 0u;
+
+    for (uint32 c = 0; c < 4; ++c)
+    {
+        const r_index_type n = comp( cnt_h, c ) - comp( cnt_l, c );
+
+        r_ranges[c].x = r_fmi.L2(c) + comp( cnt_l, c ) + 1;
+        r_ranges[c].y = r_fmi.L2(c) + comp( cnt_h, c );
+
+        f_ranges[c].x = f_range.x + x;
+        f_ranges[c].y = f_range.x + x + n - 1u;
+
+        x += n;
+    }
+}
+
+// \relates fm_index
+// backwards extension using a bidirectional FM-index, extending the range of a pattern P
+// to the ranges of all the patterns cP, for c in [0,4), with a single rank query.
+//
+template <
+    typename TRankDictionary1,
+    typename TSuffixArray1,
+    typename TRankDictionary2,
+    typename TSuffixArray2>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+void extend_backwards_all(
+    const fm_index<TRankDictionary1,TSuffixArray1>&                         f_fmi,
+    const fm_index<TRankDictionary2,TSuffixArray2>&                         r_fmi,
+    const typename fm_index<TRankDictionary1,TSuffixArray1>::range_type     f_range,
+    const typename fm_index<TRankDictionary2,TSuffixArray2>::range_type     r_range,
+    typename fm_index<TRankDictionary1,TSuffixArray1>::range_type*          f_ranges,
+    typename fm_index<TRankDictionary2,TSuffixArray2>::range_type*          r_ranges)
+{
+    typedef typename fm_index<TRankDictionary1,TSuffixArray1>::index_type   f_index_type;
+    typedef typename TRankDictionary1::vec4_type                            vec4_type;
+
+    // count the occurrences of all characters in the forward range, i.e. of all cP
+    vec4_type cnt_l, cnt_h;
+    rank4( f_fmi, make_vector( f_range.x-1, f_range.y ), &cnt_l, &cnt_h );
+
+    // the suffix P^R$ comes first, if P is a prefix of T
+    f_index_type x = (f_range.x <= f_fmi.primary() && f_fmi.primary() <= f_range.y) ? 1u : 0u;
+
+    for (uint32 c = 0; c < 4; ++c)
+    {
+        const f_index_type n = comp( cnt_h, c ) - comp( cnt_l, c );
+
+        f_ranges[c].x = f_fmi.L2(c) + comp( cnt_l, c ) + 1;
+        f_ranges[c].y = f_fmi.L2(c) + comp( cnt_h, c );
+
+        r_ranges[c].x = r_range.x + x;
+        r_ranges[c].y = r_range.x + x + n - 1u;
+
+        x += n;
+    }
+}
+
 } // namespace nvbio
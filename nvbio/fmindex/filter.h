@@ -28,11 +28,14 @@
 #pragma once
 
 #include <nvbio/fmindex/fmindex.h>
+#include <nvbio/fmindex/batched_locate.h>
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/numbers.h>
 #include <nvbio/basic/algorithms.h>
 #include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/profiling.h>
 #include <nvbio/basic/vector.h>
+#include <nvbio/basic/uninitialized_vector.h>
 #include <nvbio/basic/cuda/sort.h>
 #include <nvbio/basic/cuda/primitives.h>
 #include <nvbio/strings/string.h>
@@ -40,6 +43,7 @@
 #include <thrust/scan.h>
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 
 namespace nvbio {
 
@@ -126,8 +130,9 @@ struct FMIndexFilter<host_tag, fm_index_type>
     uint32                              m_n_queries;
     index_type                          m_index;
     uint64                              m_n_occurrences;
-    thrust::host_vector<range_type>     m_ranges;
-    thrust::host_vector<uint64>         m_slots;
+    uninitialized_vector<range_type>    m_ranges;
+    uninitialized_vector<uint64>        m_slots;
+    uninitialized_vector<coord_type>    m_locs;
 };
 
 ///
@@ -142,6 +142,36 @@ struct locate_results
     const index_type index;
 };
 
+template <typename range_type>
+struct hit_row
+{
+    typedef typename vector_traits<range_type>::value_type  coord_type;
+
+    typedef range_type  argument_type;
+    typedef coord_type  result_type;
+
+    // functor operator
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    result_type operator() (const range_type pair) const { return pair.x; }
+};
+
+template <typename range_type>
+struct located_results
+{
+    typedef typename vector_traits<range_type>::value_type  coord_type;
+
+    typedef range_type  first_argument_type;
+    typedef coord_type  second_argument_type;
+    typedef range_type  result_type;
+
+    // functor operator
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    result_type operator() (const range_type pair, const coord_type loc) const
+    {
+        return make_vector( loc, pair.y );
+    }
+};
+
 template <typename index_type>
 struct locate_ssa_results
 {
@@ -203,6 +233,8 @@ uint64 FMIndexFilter<host_tag, fm_index_type>::rank(
     const fm_index_type&    index,
     const string_set_type&  string_set)
 {
+    NVBIO_PROFILE_REGION( "fm-index/rank" );
+
     // save the query
     m_n_queries   = string_set.size();
     m_index       = index;
@@ -240,6 +272,8 @@ void FMIndexFilter<host_tag,fm_index_type>::locate(
     const uint64    end,
     hits_iterator   hits)
 {
+    NVBIO_PROFILE_REGION( "fm-index/locate" );
+
     // fill the output hits with (SA,string-id) coordinates
     thrust::transform(
         thrust::make_counting_iterator<uint64>(0u) + begin,
@@ -250,12 +284,21 @@ void FMIndexFilter<host_tag,fm_index_type>::locate(
             nvbio::plain_view( m_slots ),
             nvbio::plain_view( m_ranges ) ) );
 
-    // and locate the SA coordinates
+    // locate the SA coordinates of all hits in a single batch
+    m_locs.resize( end - begin );
+    batched_locate(
+        m_index,
+        end - begin,
+        thrust::make_transform_iterator( hits, fmindex::hit_row<range_type>() ),
+        m_locs.begin() );
+
+    // and rewrite the hits with their linear coordinates
     thrust::transform(
         hits,
         hits + (end - begin),
+        m_locs.begin(),
         hits,
-        fmindex::locate_results<fm_index_type>( m_index ) );
+        fmindex::located_results<range_type>() );
 }
 
 // enact the filter on an FM-index and a string-set
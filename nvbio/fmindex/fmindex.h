@@ -206,6 +206,13 @@ namespace nvbio {
 /// </td><td style="vertical-align:text-top;">
 /// given a suffix array coordinate i, return its linear coordinate SA[i]
 /// </td></tr>
+/// <tr><td style="white-space: nowrap; vertical-align:text-top;">
+/// batched_locate()<br>
+/// </td><td style="vertical-align:text-top;">
+/// fmi, n, rows, output
+/// </td><td style="vertical-align:text-top;">
+/// locate a batch of suffix array coordinates from the host, interleaving their LF-walks
+/// </td></tr>
 /// </table>
 ///
 ///\anchor BidirectionalFMIndex
@@ -29,6 +29,7 @@
 
 #include <nvbio/fmindex/fmindex.h>
 #include <nvbio/fmindex/bidir.h>
+#include <nvbio/fmindex/batched_locate.h>
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/numbers.h>
 #include <nvbio/basic/algorithms.h>
@@ -43,6 +44,7 @@
 #include <thrust/binary_search.h>
 #include <thrust/iterator/constant_iterator.h>
 #include <thrust/iterator/counting_iterator.h>
+#include <thrust/iterator/transform_iterator.h>
 
 namespace nvbio {
 
@@ -357,6 +359,7 @@ struct MEMFilter<host_tag, fm_index_type>
     uint64                              m_n_occurrences;
     HostVectorArray<rank_type>          m_mem_ranges;
     thrust::host_vector<uint64>         m_slots;
+    thrust::host_vector<coord_type>     m_locs;
 };
 
 ///
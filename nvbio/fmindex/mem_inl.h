@@ -974,6 +974,40 @@ struct lookup_ssa_results
     const index_type index;
 };
 
+template <typename coord_type>
+struct mem_row
+{
+    typedef MEMHit<coord_type>                          mem_type;
+
+    typedef mem_type    argument_type;
+    typedef coord_type  result_type;
+
+    // functor operator
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    coord_type operator() (const mem_type mem) const { return mem.coords.x; }
+};
+
+template <typename coord_type>
+struct located_results
+{
+    typedef MEMHit<coord_type>                          mem_type;
+
+    typedef mem_type    first_argument_type;
+    typedef coord_type  second_argument_type;
+    typedef mem_type    result_type;
+
+    // functor operator
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    mem_type operator() (const mem_type mem, const coord_type loc) const
+    {
+        return mem_type(
+            loc,
+            uint32( mem.coords.z ),
+            uint32( mem.coords.w ) & 0xFFu,
+            uint32( mem.coords.w ) >> 16u );
+    }
+};
+
 
 // device kernel to reorder a vector array of mem-ranges
 template <typename rank_type>
@@ -1285,19 +1319,21 @@ void MEMFilter<host_tag, fm_index_type>::locate(
             nvbio::plain_view( m_slots ),
             nvbio::plain_view( m_mem_ranges.m_arena ) ) );
 
-    // locate the SSA iterators
-    thrust::transform(
-        mems,
-        mems + n_hits,
-        mems,
-        mem::locate_ssa_results<fm_index_type>( m_f_index ) );
+    // locate the SA coordinates of all hits in a single batch
+    m_locs.resize( n_hits );
+    batched_locate(
+        m_f_index,
+        n_hits,
+        thrust::make_transform_iterator( mems, mem::mem_row<coord_type>() ),
+        m_locs.begin() );
 
-    // and perform the final lookup
+    // and rewrite the hits with their linear coordinates
     thrust::transform(
         mems,
         mems + n_hits,
+        m_locs.begin(),
         mems,
-        mem::lookup_ssa_results<fm_index_type>( m_f_index ) );
+        mem::located_results<coord_type>() );
 }
 
 // enact the filter on an FM-index and a string-set
@@ -0,0 +1,260 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/fmindex/fmindex.h>
+#include <nvbio/fmindex/bidir.h>
+#include <vector>
+
+namespace nvbio {
+
+///@addtogroup FMIndex
+///@{
+
+///
+/// A search scheme for approximate matching under the Hamming distance with a
+/// bidirectional FM-index, in the formulation of
+/// <a href="http://arxiv.org/abs/1401.0573">Kucherov, Salikhov and Tsur</a>.
+///\par
+/// The pattern is split in n_parts equal parts, and each search specifies:
+///  - the order in which the parts are matched, which must be <i>connected</i>, i.e. each
+///    part must be adjacent to the ones matched before it;
+///  - the minimum and maximum number of cumulative mismatches L[i] and U[i] allowed after
+///    matching the first i+1 parts;
+///  - the minimum number of mismatches M[i] within the i-th matched part;
+///  - optionally, the number Z of parts following the first one among which at least one
+///    must match exactly.
+///\par
+/// A scheme is <i>complete</i> for k mismatches if each distribution of at most k mismatches
+/// among the parts is accepted by at least one of its searches; matches accepted by more than
+/// one search are deduplicated by the SearchSchemeFilter.
+///
+struct SearchScheme
+{
+    static const uint32 MAX_PARTS    = 8;
+    static const uint32 MAX_SEARCHES = 16;
+
+    struct Search
+    {
+        uint8 order[MAX_PARTS];     ///< the order in which parts are matched
+        uint8 L[MAX_PARTS];         ///< the minimum number of cumulative mismatches after each step
+        uint8 U[MAX_PARTS];         ///< the maximum number of cumulative mismatches after each step
+        uint8 M[MAX_PARTS];         ///< the minimum number of mismatches within the part matched at each step
+        uint8 Z;                    ///< the number of steps after the first one containing an exact part, or 0
+    };
+
+    /// empty constructor
+    ///
+    SearchScheme() : n_parts(0), n_searches(0), max_errors(0) {}
+
+    /// constructor
+    ///
+    /// \param _n_parts     the number of parts
+    /// \param _max_errors  the maximum number of mismatches
+    SearchScheme(const uint32 _n_parts, const uint32 _max_errors) :
+        n_parts( _n_parts ), n_searches(0), max_errors( _max_errors ) {}
+
+    /// add a search, returning false if the search is not connected or the scheme is full
+    ///
+    /// \param order        the part order, n_parts entries
+    /// \param L            the cumulative lower bounds, n_parts entries
+    /// \param U            the cumulative upper bounds, n_parts entries
+    /// \param M            the per-part lower bounds, n_parts entries, or NULL
+    /// \param Z            the number of steps following the first in which an exact part must be found, or 0
+    bool add_search(
+        const uint8* order,
+        const uint8* L,
+        const uint8* U,
+        const uint8* M = NULL,
+        const uint32 Z = 0);
+
+    uint32 n_parts;                         ///< the number of parts
+    uint32 n_searches;                      ///< the number of searches
+    uint32 max_errors;                      ///< the maximum number of mismatches
+    Search searches[MAX_SEARCHES];          ///< the searches
+};
+
+/// build a pigeonhole search scheme for k mismatches: the pattern is split in k+1 parts,
+/// and the i-th search starts matching the i-th part exactly, extending right first and
+/// then left; the scheme exploits the fact that the leftmost exact part is always preceded
+/// by parts with at least one mismatch.
+///
+/// \param k        the maximum number of mismatches, in [0,MAX_PARTS); larger values throw a logic_error
+///
+SearchScheme pigeonhole_search_scheme(const uint32 k);
+
+/// build a search scheme for k mismatches based on
+/// <a href="http://dx.doi.org/10.1186/s13015-016-0072-x">01*0 seeds</a>: the pattern is split in
+/// k+2 parts, so that any occurrence contains two exact parts separated only by parts with at least
+/// one mismatch; the i-th search starts from the i-th part, the leftmost exact one, and requires
+/// one more exact part to its right.
+///
+/// \param k        the maximum number of mismatches, in [0,MAX_PARTS-1); larger values throw a logic_error
+///
+SearchScheme seed_01x0_search_scheme(const uint32 k);
+
+/// a stack entry for search_scheme_match()
+///
+struct SearchSchemeEntry
+{
+    uint2   f_range;    ///< the forward range
+    uint2   r_range;    ///< the reverse range
+    uint32  begin;      ///< the beginning of the matched pattern window
+    uint32  end;        ///< the end of the matched pattern window
+    uint8   step;       ///< the current step in the search
+    uint8   errors;     ///< the cumulative number of mismatches
+    uint8   part_errors;///< the number of mismatches in the current part
+    uint8   exact;      ///< whether an exact part has been found among the first Z steps
+};
+
+/// perform approximate matching of a pattern under the Hamming distance, applying all
+/// the searches of a given search scheme with a bidirectional FM-index.
+///\par
+/// Compared to hamming_backtrack(), which extends a single exact seed enumerating all
+/// mismatches in the rest of the pattern, the searches bound the number of mismatches
+/// after each part, pruning most branches close to the root of the search tree.
+///\par
+/// The same occurrence can be reported by more than one search, though always with the
+/// same SA range and number of mismatches.
+///
+/// \tparam FMIndex     the forward FM-index type
+/// \tparam RFMIndex    the reverse FM-index type, not requiring a sampled suffix array
+/// \tparam String      a string iterator
+/// \tparam Stack       a SearchSchemeEntry array to be used as a backtracking stack,
+///                     with room for at least 3*len+4 entries
+/// \tparam Delegate    a delegate functor used to process hits, must implement the following interface:
+///\code
+/// struct Delegate
+/// {
+///     // process a series of hits identified by their SA range
+///     void operator() (const uint2 range, const uint32 mismatches);
+/// }
+///\endcode
+///
+/// \param f_fmi        the forward FM-index
+/// \param r_fmi        the reverse FM-index
+/// \param scheme       the search scheme
+/// \param pattern      the search pattern
+/// \param len          the pattern length
+/// \param stack        the stack storage
+/// \param delegate     the delegate functor invoked on hits
+///
+template <typename FMIndex, typename RFMIndex, typename String, typename Stack, typename Delegate>
+void search_scheme_match(
+    const FMIndex&      f_fmi,
+    const RFMIndex&     r_fmi,
+    const SearchScheme& scheme,
+    const String        pattern,
+    const uint32        len,
+          Stack         stack,
+          Delegate&     delegate);
+
+///
+///\par
+/// This class implements a parallel host filter which finds all approximate occurrences of a
+/// string-set under the Hamming distance, applying a SearchScheme with a bidirectional FM-index.
+///\par
+/// The filter will first <i>rank</i> the strings, producing a deduplicated list of
+/// <i>(SA-begin,SA-end,string-id,mismatches)</i> tuples sorted by string-id, and then
+/// <i>locate</i> the individual occurrences as <i>(index-pos,string-id)</i> pairs, like
+/// FMIndexFilterHost.
+///\par
+/// Strings are distributed to all the available OpenMP threads.
+///
+/// \tparam fm_index_type   the type of the forward fm-index
+/// \tparam rfm_index_type  the type of the reverse fm-index
+///
+template <typename fm_index_type, typename rfm_index_type = fm_index_type>
+struct SearchSchemeFilterHost
+{
+    typedef host_tag            system_tag;     ///< the backend system
+    typedef fm_index_type       index_type;     ///< the index type
+    typedef uint4               rank_type;      ///< (SA-begin,SA-end,string-id,mismatches) tuples
+    typedef uint2               hit_type;       ///< (index-pos,string-id) pairs
+
+    /// enact the filter on a bidirectional FM-index and a string-set
+    ///
+    /// \param f_index          the forward FM-index
+    /// \param r_index          the reverse FM-index
+    /// \param scheme           the search scheme
+    /// \param string_set       the query string-set
+    ///
+    /// \return the total number of hits
+    ///
+    template <typename string_set_type>
+    uint64 rank(
+        const fm_index_type&    f_index,
+        const rfm_index_type&   r_index,
+        const SearchScheme&     scheme,
+        const string_set_type&  string_set);
+
+    /// enumerate all hits in a given range
+    ///
+    /// \tparam hits_iterator         a hit_type iterator
+    ///
+    /// \param begin                  the beginning of the hits sequence to locate, in [0,n_hits)
+    /// \param end                    the end of the hits sequence to locate, in [0,n_hits]
+    ///
+    template <typename hits_iterator>
+    void locate(
+        const uint64    begin,
+        const uint64    end,
+        hits_iterator   hits);
+
+    /// return the number of hits from the last rank query
+    ///
+    uint64 n_hits() const { return m_n_occurrences; }
+
+    /// return the number of distinct ranges from the last rank query
+    ///
+    uint64 n_ranges() const { return m_ranges.size(); }
+
+    /// return the deduplicated ranges, sorted by string-id
+    ///
+    const rank_type* ranges() const { return m_ranges.size() ? &m_ranges[0] : NULL; }
+
+    /// return the global ranks of the output hits (i.e. the range <i>[ranks[i-1], ranks[i])</i>
+    /// identifies the position of the hits corresponding to the i-th range in the locate output)
+    ///
+    const uint64* ranks() const { return m_slots.size() ? &m_slots[0] : NULL; }
+
+    uint32                  m_n_queries;
+    fm_index_type           m_f_index;
+    uint64                  m_n_occurrences;
+    std::vector<rank_type>  m_ranges;
+    std::vector<uint64>     m_slots;
+};
+
+///@} // end of the FMIndex group
+
+} // namespace nvbio
+
+#include <nvbio/fmindex/search_scheme_inl.h>
@@ -0,0 +1,427 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/algorithms.h>
+#include <algorithm>
+
+namespace nvbio {
+
+// add a search, returning false if the search is not connected or the scheme is full
+//
+inline bool SearchScheme::add_search(
+    const uint8* order,
+    const uint8* L,
+    const uint8* U,
+    const uint8* M,
+    const uint32 Z)
+{
+    if (n_searches >= MAX_SEARCHES || n_parts == 0 || n_parts > MAX_PARTS || Z >= n_parts)
+        return false;
+
+    // check that each part is adjacent to the ones matched before it
+    uint32 lo = order[0];
+    uint32 hi = order[0];
+    for (uint32 i = 1; i < n_parts; ++i)
+    {
+        if (order[i] + 1u == lo)
+            lo = order[i];
+        else if (order[i] == hi + 1u)
+            hi = order[i];
+        else
+            return false;
+    }
+    if (lo != 0 || hi != n_parts-1)
+        return false;
+
+    Search& search = searches[ n_searches++ ];
+    for (uint32 i = 0; i < n_parts; ++i)
+    {
+        search.order[i] = order[i];
+        search.L[i]     = L[i];
+        search.U[i]     = U[i];
+        search.M[i]     = M ? M[i] : 0u;
+    }
+    search.Z = uint8( Z );
+    return true;
+}
+
+namespace sscheme {
+
+// build the searches shared by the pigeonhole and 01*0 seed schemes: the a-th search
+// matches the a-th part exactly, then all parts to its right with at most k-a mismatches,
+// and finally all parts to its left, which must contain at least one mismatch each;
+// throws a logic_error if the scheme needs more than MAX_PARTS parts
+//
+inline SearchScheme leftmost_exact_search_scheme(const uint32 k, const uint32 n_parts, const bool seed_01x0)
+{
+    if (n_parts > SearchScheme::MAX_PARTS)
+        throw nvbio::logic_error( "search scheme: %u mismatches need %u parts, at most %u are supported\n", k, n_parts, SearchScheme::MAX_PARTS );
+
+    SearchScheme scheme( n_parts, k );
+
+    for (uint32 a = 0; a <= k && a < n_parts; ++a)
+    {
+        uint8 order[SearchScheme::MAX_PARTS];
+        uint8 L[SearchScheme::MAX_PARTS];
+        uint8 U[SearchScheme::MAX_PARTS];
+        uint8 M[SearchScheme::MAX_PARTS];
+
+        uint32 step = 0;
+        order[step] = uint8( a );
+        L[step]     = 0u;
+        U[step]     = 0u;
+        M[step]     = 0u;
+        ++step;
+
+        for (uint32 p = a+1; p < n_parts; ++p, ++step)
+        {
+            order[step] = uint8( p );
+            L[step]     = 0u;
+            U[step]     = uint8( k - a );
+            M[step]     = 0u;
+        }
+        for (uint32 p = a; p > 0; --p, ++step)
+        {
+            order[step] = uint8( p-1 );
+            L[step]     = uint8( a - p + 1 );
+            U[step]     = uint8( k );
+            M[step]     = 1u;
+        }
+
+        if (scheme.add_search( order, L, U, M, seed_01x0 ? n_parts-1 - a : 0u ) == false)
+            throw nvbio::logic_error( "search scheme: unable to add search %u of %u\n", a, nvbio::min( k+1u, n_parts ) );
+    }
+    return scheme;
+}
+
+} // namespace sscheme
+
+// build a pigeonhole search scheme for k mismatches
+//
+inline SearchScheme pigeonhole_search_scheme(const uint32 k)
+{
+    return sscheme::leftmost_exact_search_scheme( k, k+1, false );
+}
+
+// build a search scheme for k mismatches based on 01*0 seeds
+//
+inline SearchScheme seed_01x0_search_scheme(const uint32 k)
+{
+    return sscheme::leftmost_exact_search_scheme( k, k+2, true );
+}
+
+// perform approximate matching of a pattern under the Hamming distance, applying all
+// the searches of a given search scheme with a bidirectional FM-index
+//
+template <typename FMIndex, typename RFMIndex, typename String, typename Stack, typename Delegate>
+void search_scheme_match(
+    const FMIndex&      f_fmi,
+    const RFMIndex&     r_fmi,
+    const SearchScheme& scheme,
+    const String        pattern,
+    const uint32        len,
+          Stack         stack,
+          Delegate&     delegate)
+{
+    const uint32 n_parts = scheme.n_parts;
+
+    // compute the part boundaries
+    uint32 bounds[SearchScheme::MAX_PARTS+1];
+    for (uint32 p = 0; p <= n_parts; ++p)
+        bounds[p] = (len * p) / n_parts;
+
+    for (uint32 s = 0; s < scheme.n_searches; ++s)
+    {
+        const SearchScheme::Search& search = scheme.searches[s];
+
+        // start from the end of the first part, matching it right to left
+        SearchSchemeEntry root;
+        root.f_range     = make_uint2( 0u, f_fmi.length() );
+        root.r_range     = make_uint2( 0u, r_fmi.length() );
+        root.begin       = bounds[ search.order[0]+1 ];
+        root.end         = bounds[ search.order[0]+1 ];
+        root.step        = 0;
+        root.errors      = 0;
+        root.part_errors = 0;
+        root.exact       = 0;
+
+        uint32 sp = 0;
+        stack[sp++] = root;
+
+        while (sp)
+        {
+            SearchSchemeEntry entry = stack[--sp];
+
+            // advance through all completed parts
+            bool accepted = true;
+            bool finished = false;
+            while (1)
+            {
+                const uint32 part = search.order[ entry.step ];
+                const bool   right = part > search.order[0];
+
+                if (right ? entry.end < bounds[part+1] : entry.begin > bounds[part])
+                    break;
+
+                // check the part constraints
+                if (entry.part_errors < search.M[ entry.step ] ||
+                    entry.errors      < search.L[ entry.step ])
+                {
+                    accepted = false;
+                    break;
+                }
+                if (entry.step >= 1u && entry.step <= search.Z && entry.part_errors == 0u)
+                    entry.exact = 1u;
+
+                if (entry.step+1u == n_parts)
+                {
+                    finished = true;
+                    break;
+                }
+
+                ++entry.step;
+                entry.part_errors = 0;
+            }
+            if (accepted == false)
+                continue;
+
+            if (finished)
+            {
+                delegate( entry.f_range, uint32( entry.errors ) );
+                continue;
+            }
+
+            const uint32 part  = search.order[ entry.step ];
+            const bool   right = part > search.order[0];
+
+            // compute the maximum number of mismatches for this extension: the last of the
+            // Z steps following the first one must be exact, unless an exact part was already found
+            const uint32 max_errors = (search.Z && entry.step == search.Z && entry.exact == 0u) ?
+                entry.errors - entry.part_errors :
+                search.U[ entry.step ];
+
+            // check whether the remaining characters of this part can still satisfy the lower bounds
+            const uint32 remaining = right ? bounds[part+1] - entry.end : entry.begin - bounds[part];
+            if (entry.errors      + remaining < search.L[ entry.step ] ||
+                entry.part_errors + remaining < search.M[ entry.step ])
+                continue;
+
+            const uint32 pos = right ? entry.end : entry.begin-1u;
+            const uint8  c_pattern = pattern[pos];
+
+            // compute the ranges of all four children at once
+            uint2 f_ranges[4];
+            uint2 r_ranges[4];
+            if (right)
+                extend_forward_all( f_fmi, r_fmi, entry.f_range, entry.r_range, f_ranges, r_ranges );
+            else
+                extend_backwards_all( f_fmi, r_fmi, entry.f_range, entry.r_range, f_ranges, r_ranges );
+
+            // push the mismatching children first, so as to visit the matching one first
+            for (uint32 i = 0; i < 4; ++i)
+            {
+                const uint8 c = uint8( (c_pattern + 1u + i) & 3u );
+                if (f_ranges[c].x > f_ranges[c].y)
+                    continue;
+
+                // N's mismatch all characters
+                const uint32 cost = (c == c_pattern) ? 0u : 1u;
+                if (entry.errors + cost > max_errors)
+                    continue;
+
+                SearchSchemeEntry child = entry;
+                child.f_range      = f_ranges[c];
+                child.r_range      = r_ranges[c];
+                child.begin        = right ? entry.begin : entry.begin-1u;
+                child.end          = right ? entry.end+1u : entry.end;
+                child.errors      += uint8( cost );
+                child.part_errors += uint8( cost );
+
+                stack[sp++] = child;
+            }
+        }
+    }
+}
+
+namespace sscheme {
+
+// a delegate collecting the ranges found for a single pattern
+//
+struct collect_ranges
+{
+    collect_ranges(std::vector<uint4>& _ranges, const uint32 _string_id) :
+        ranges( _ranges ), string_id( _string_id ) {}
+
+    void operator() (const uint2 range, const uint32 errors)
+    {
+        ranges.push_back( make_uint4( range.x, range.y, string_id, errors ) );
+    }
+
+    std::vector<uint4>& ranges;
+    uint32              string_id;
+};
+
+// order ranges by string-id, SA range and number of mismatches
+//
+struct range_less
+{
+    bool operator() (const uint4 a, const uint4 b) const
+    {
+        return a.z < b.z || (a.z == b.z &&
+              (a.x < b.x || (a.x == b.x &&
+              (a.y < b.y || (a.y == b.y && a.w < b.w)))));
+    }
+};
+
+// compare ranges discarding the number of mismatches
+//
+struct range_equal
+{
+    bool operator() (const uint4 a, const uint4 b) const
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+};
+
+} // namespace sscheme
+
+// enact the filter on a bidirectional FM-index and a string-set
+//
+template <typename fm_index_type, typename rfm_index_type>
+template <typename string_set_type>
+uint64 SearchSchemeFilterHost<fm_index_type,rfm_index_type>::rank(
+    const fm_index_type&    f_index,
+    const rfm_index_type&   r_index,
+    const SearchScheme&     scheme,
+    const string_set_type&  string_set)
+{
+    typedef typename string_set_type::string_type string_type;
+
+    // save the query
+    m_n_queries     = string_set.size();
+    m_f_index       = f_index;
+    m_n_occurrences = 0;
+
+    const uint32 n_threads = omp_get_max_threads();
+
+    // search the strings in parallel, keeping separate output lists for each thread
+    std::vector< std::vector<uint4> > thread_ranges( n_threads );
+
+    #pragma omp parallel
+    {
+        const uint32 tid = omp_get_thread_num();
+
+        std::vector<uint4>&             ranges = thread_ranges[tid];
+        std::vector<uint4>              string_ranges;
+        std::vector<SearchSchemeEntry>  stack;
+
+        #pragma omp for schedule(dynamic,64)
+        for (int32 i = 0; i < int32( m_n_queries ); ++i)
+        {
+            const string_type string = string_set[i];
+            const uint32      len    = string.length();
+
+            stack.resize( 3u*len + 4u );
+            string_ranges.erase( string_ranges.begin(), string_ranges.end() );
+
+            sscheme::collect_ranges delegate( string_ranges, uint32(i) );
+
+            search_scheme_match(
+                f_index,
+                r_index,
+                scheme,
+                string,
+                len,
+                &stack[0],
+                delegate );
+
+            // remove the duplicates found by different searches
+            std::sort( string_ranges.begin(), string_ranges.end(), sscheme::range_less() );
+            ranges.insert(
+                ranges.end(),
+                string_ranges.begin(),
+                std::unique( string_ranges.begin(), string_ranges.end(), sscheme::range_equal() ) );
+        }
+    }
+
+    // merge all lists
+    uint64 n_ranges = 0;
+    for (uint32 t = 0; t < n_threads; ++t)
+        n_ranges += thread_ranges[t].size();
+
+    m_ranges.resize( n_ranges );
+    m_slots.resize( n_ranges );
+
+    n_ranges = 0;
+    for (uint32 t = 0; t < n_threads; ++t)
+    {
+        std::copy( thread_ranges[t].begin(), thread_ranges[t].end(), m_ranges.begin() + n_ranges );
+        n_ranges += thread_ranges[t].size();
+    }
+
+    // sort them by string-id
+    std::sort( m_ranges.begin(), m_ranges.end(), sscheme::range_less() );
+
+    // scan their size to determine the slots
+    for (uint64 r = 0; r < n_ranges; ++r)
+    {
+        m_n_occurrences += 1u + m_ranges[r].y - m_ranges[r].x;
+        m_slots[r] = m_n_occurrences;
+    }
+    return m_n_occurrences;
+}
+
+// enumerate all hits in a given range
+//
+template <typename fm_index_type, typename rfm_index_type>
+template <typename hits_iterator>
+void SearchSchemeFilterHost<fm_index_type,rfm_index_type>::locate(
+    const uint64    begin,
+    const uint64    end,
+    hits_iterator   hits)
+{
+    const uint64* slots = ranks();
+
+    #pragma omp parallel for
+    for (int64 i = int64( begin ); i < int64( end ); ++i)
+    {
+        // find the range containing this hit
+        const uint32 r = uint32( upper_bound( uint64(i), slots, m_ranges.size() ) - slots );
+
+        const uint4  range  = m_ranges[r];
+        const uint64 offset = uint64(i) - (r ? slots[r-1] : 0u);
+
+        hits[ i - int64( begin ) ] = make_uint2( uint32( nvbio::locate( m_f_index, uint32( range.x + offset ) ) ), range.z );
+    }
+}
+
+} // namespace nvbio
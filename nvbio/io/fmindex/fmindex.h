@@ -244,6 +244,11 @@ struct FMIndexDataMMAPServer : public FMIndexData
 {
     typedef FMIndexDataMMAPInfo Info;
 
+    /// set the page size and NUMA placement options of the mapped objects;
+    /// must be called before load()
+    ///
+    void set_mapping_options(const MappingOptions& options);
+
     /// load a genome from file
     ///
     /// \param genome_prefix            prefix file name
@@ -251,6 +256,10 @@ struct FMIndexDataMMAPServer : public FMIndexData
     int load(
         const char* genome_prefix, const char* mapped_name);
 
+    /// return the total number of bytes of shared memory used by the mapped objects
+    ///
+    uint64 memory_footprint() const;
+
 private:
     Info                m_info;                         ///< internal info object storage
     ServerMappedFile    m_bwt_occ_file;                 ///< internal memory-mapped forward occurrence table object server
@@ -265,7 +274,8 @@ private:
 
 ///
 /// A memory-mapped FM-index client, which can connect to a shared-memory FM-index
-/// and present it as local.
+/// and present it as local. If the server replicated the index on each NUMA node,
+/// the client will attach to the replica local to the node it is running on.
 ///
 struct FMIndexDataMMAP : public FMIndexData
 {
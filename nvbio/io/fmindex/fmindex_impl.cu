@@ -487,6 +487,28 @@ int FMIndexDataHost::load(
     return 1;
 }
 
+// set the page size and NUMA placement options of the mapped objects
+//
+void FMIndexDataMMAPServer::set_mapping_options(const MappingOptions& options)
+{
+    m_bwt_occ_file.set_options( options );
+    m_rbwt_occ_file.set_options( options );
+    m_sa_file.set_options( options );
+    m_rsa_file.set_options( options );
+    m_info_file.set_options( options );
+}
+
+// return the total number of bytes of shared memory used by the mapped objects
+//
+uint64 FMIndexDataMMAPServer::memory_footprint() const
+{
+    return m_bwt_occ_file.size() +
+           m_rbwt_occ_file.size() +
+           m_sa_file.size() +
+           m_rsa_file.size() +
+           m_info_file.size();
+}
+
 int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_name)
 {
     log_visible(stderr, "FMIndexData: loading... started\n");
@@ -643,6 +665,13 @@ int FMIndexDataMMAPServer::load(const char* genome_prefix, const char* mapped_na
             infoName.c_str(),
             sizeof(Info),
             &m_info );
+
+        // publish the per-node replicas, if requested
+        m_bwt_occ_file.replicate();
+        m_rbwt_occ_file.replicate();
+        m_sa_file.replicate();
+        m_rsa_file.replicate();
+        m_info_file.replicate();
     }
     catch (ServerMappedFile::mapping_error error)
     {
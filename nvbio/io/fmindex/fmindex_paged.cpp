@@ -0,0 +1,556 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/io/fmindex/fmindex_paged.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/exceptions.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/fmindex/bwt.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace nvbio {
+namespace io {
+
+namespace { // anonymous namespace
+
+// seek to a 64-bit file offset
+//
+bool seek64(FILE* file, const uint64 offset)
+{
+#if defined(WIN32)
+    return _fseeki64( file, int64( offset ), SEEK_SET ) == 0;
+#else
+    return fseeko( file, off_t( offset ), SEEK_SET ) == 0;
+#endif
+}
+
+// count the occurrences of each symbol in a BWT word, packed in 8-bit lanes
+//
+inline uint32 count_word(const uint32* count_table, const uint32 w)
+{
+    return count_table[ (w >>  0) & 0xFF ] +
+           count_table[ (w >>  8) & 0xFF ] +
+           count_table[ (w >> 16) & 0xFF ] +
+           count_table[ (w >> 24) & 0xFF ];
+}
+
+// add the packed counts of a word to a set of counters
+//
+inline void add_counts(uint32* cnt, const uint32 packed)
+{
+    cnt[0] += (packed >>  0) & 0xFF;
+    cnt[1] += (packed >>  8) & 0xFF;
+    cnt[2] += (packed >> 16) & 0xFF;
+    cnt[3] += (packed >> 24) & 0xFF;
+}
+
+// return the largest power of 2 not greater than n, clamped to a minimum
+//
+inline uint32 page_elements(const uint32 page_bytes, const uint32 element_bytes, const uint32 min_elements)
+{
+    const uint32 n = nvbio::max( page_bytes / element_bytes, min_elements );
+    return 1u << log2( n );
+}
+
+} // anonymous namespace
+
+///
+/// A page loader rebuilding interleaved BWT/OCC blocks from a .bwt file
+///
+struct FMIndexDataPaged::BwtOccLoader : public PageLoader<uint4>
+{
+    static const uint32 HEADER_BYTES = 5 * sizeof(uint32);
+
+    BwtOccLoader() : m_file( NULL ) {}
+    ~BwtOccLoader() { if (m_file) fclose( m_file ); }
+
+    // open the file and compute the per-page base counts
+    //
+    bool open(
+        const char*     file_name,
+        const uint32*   count_table,
+        const uint32    page_size,
+        uint32&         seq_length,
+        uint32&         primary,
+        uint32*         L2)
+    {
+        m_file = fopen( file_name, "rb" );
+        if (m_file == NULL)
+        {
+            log_warning(stderr, "unable to open bwt \"%s\"\n", file_name);
+            return false;
+        }
+
+        uint32 header[5];
+        if (fread( header, sizeof(uint32), 5, m_file ) != 5)
+        {
+            log_error(stderr, "error: failed reading bwt \"%s\"\n", file_name);
+            return false;
+        }
+        primary    = header[0];
+        seq_length = header[4];
+
+        m_count_table = count_table;
+        m_seq_length  = seq_length;
+
+        // the number of words stored in the file, and its padded counterpart
+        m_file_words = util::divide_ri( seq_length, FMIndexDataCore::BWT_SYMBOLS_PER_WORD );
+        m_seq_words  = align<4>( m_file_words );
+
+        // each page holds page_size/2 pairs of BWT and OCC blocks
+        m_page_blocks = page_size / 2;
+
+        const uint32 n_blocks = m_seq_words / 4;
+        const uint32 n_pages  = util::divide_ri( n_blocks, m_page_blocks );
+        const uint32 page_words = m_page_blocks * 4;
+
+        m_page_counts.resize( uint64( n_pages ) * 4u );
+
+        // stream through the file once, recording the symbol counts at the beginning of each page
+        uint32 cnt[4] = { 0u };
+
+        std::vector<uint32> buffer( page_words );
+        for (uint32 p = 0; p < n_pages; ++p)
+        {
+            for (uint32 c = 0; c < 4; ++c)
+                m_page_counts[ p*4 + c ] = cnt[c];
+
+            const uint32 w_begin = p * page_words;
+            const uint32 w_end   = nvbio::min( w_begin + page_words, m_file_words );
+
+            if (w_begin >= w_end)
+                continue;
+
+            if (fread( &buffer[0], sizeof(uint32), w_end - w_begin, m_file ) != w_end - w_begin)
+            {
+                log_error(stderr, "error: failed reading bwt \"%s\"\n", file_name);
+                return false;
+            }
+
+            // count all full words with the packed count table
+            const uint32 w_full = nvbio::min( w_end, seq_length / FMIndexDataCore::BWT_SYMBOLS_PER_WORD );
+            for (uint32 w = w_begin; w < w_full; ++w)
+                add_counts( cnt, count_word( count_table, buffer[ w - w_begin ] ) );
+
+            // and the trailing partial word symbol by symbol
+            if (w_full < w_end)
+            {
+                const uint32 word = buffer[ w_full - w_begin ];
+                const uint32 n    = seq_length - w_full * FMIndexDataCore::BWT_SYMBOLS_PER_WORD;
+                for (uint32 i = 0; i < n; ++i)
+                    ++cnt[ (word >> (30u - i*2u)) & 3u ];
+            }
+        }
+
+        // compute the L2 table
+        L2[0] = 0;
+        for (uint32 c = 0; c < 4; ++c)
+            L2[c+1] = L2[c] + cnt[c];
+
+        return true;
+    }
+
+    // return the number of uint4 elements of the interleaved BWT/OCC table
+    //
+    uint64 size() const { return uint64( m_seq_words / 4 ) * 2u; }
+
+    // load a page
+    //
+    void load(const uint32 page, uint4* buffer)
+    {
+        const uint32 page_words = m_page_blocks * 4;
+        const uint32 w_begin    = page * page_words;
+        const uint32 w_end      = nvbio::min( w_begin + page_words, m_file_words );
+
+        // read the BWT words in the second half of the buffer, so as to interleave them in place
+        uint32* words = reinterpret_cast<uint32*>( buffer ) + page_words;
+        for (uint32 w = 0; w < page_words; ++w)
+            words[w] = 0u;
+
+        if (w_begin < w_end)
+        {
+            if (seek64( m_file, HEADER_BYTES + uint64( w_begin ) * sizeof(uint32) ) == false ||
+                fread( words, sizeof(uint32), w_end - w_begin, m_file ) != w_end - w_begin)
+                throw runtime_error( "FMIndexDataPaged: failed reading BWT page %u", page );
+        }
+
+        uint32 cnt[4];
+        for (uint32 c = 0; c < 4; ++c)
+            cnt[c] = m_page_counts[ page*4 + c ];
+
+        for (uint32 b = 0; b < m_page_blocks; ++b)
+        {
+            const uint4 bwt = make_uint4( words[b*4+0], words[b*4+1], words[b*4+2], words[b*4+3] );
+
+            buffer[ b*2+0 ] = bwt;
+            buffer[ b*2+1 ] = make_uint4( cnt[0], cnt[1], cnt[2], cnt[3] );
+
+            // NOTE: the counts of the last block may include padding, but are never used
+            add_counts( cnt,
+                count_word( m_count_table, bwt.x ) +
+                count_word( m_count_table, bwt.y ) +
+                count_word( m_count_table, bwt.z ) +
+                count_word( m_count_table, bwt.w ) );
+        }
+    }
+
+    FILE*                   m_file;
+    const uint32*           m_count_table;
+    uint32                  m_seq_length;
+    uint32                  m_file_words;
+    uint32                  m_seq_words;
+    uint32                  m_page_blocks;
+    std::vector<uint32>     m_page_counts;
+};
+
+///
+/// A page loader reading a sampled suffix array from a .sa file
+///
+struct FMIndexDataPaged::SSALoader : public PageLoader<uint32>
+{
+    static const uint32 HEADER_BYTES = 7 * sizeof(uint32);
+
+    SSALoader() : m_file( NULL ) {}
+    ~SSALoader() { if (m_file) fclose( m_file ); }
+
+    // open the file and validate its header
+    //
+    bool open(
+        const char*     file_name,
+        const uint32    seq_length,
+        const uint32    primary,
+        const uint32    page_size)
+    {
+        m_file = fopen( file_name, "rb" );
+        if (m_file == NULL)
+        {
+            log_warning(stderr, "unable to open SSA \"%s\"\n", file_name);
+            return false;
+        }
+
+        uint32 header[7];
+        if (fread( header, sizeof(uint32), 7, m_file ) != 7)
+        {
+            log_error(stderr, "error: failed reading SSA \"%s\"\n", file_name);
+            return false;
+        }
+        if (header[0] != primary)
+        {
+            log_error(stderr, "SA file mismatch \"%s\"\n  expected primary %u, got %u\n", file_name, primary, header[0]);
+            return false;
+        }
+        if (header[5] != SA_INT)
+        {
+            log_error(stderr, "unsupported SA interval (found %u, expected %u)\n", header[5], SA_INT);
+            return false;
+        }
+        if (header[6] != seq_length)
+        {
+            log_error(stderr, "SA file mismatch \"%s\"\n  expected length %u, got %u\n", file_name, seq_length, header[6]);
+            return false;
+        }
+
+        m_size      = (seq_length + SA_INT) / SA_INT;
+        m_page_size = page_size;
+        return true;
+    }
+
+    // return the number of SSA entries
+    //
+    uint64 size() const { return m_size; }
+
+    // load a page
+    //
+    void load(const uint32 page, uint32* buffer)
+    {
+        const uint32 begin = page * m_page_size;
+        const uint32 end   = nvbio::min( begin + m_page_size, m_size );
+
+        // the first entry is not stored in the file
+        uint32 offset = 0;
+        if (begin == 0)
+        {
+            buffer[0] = uint32(-1);
+            offset    = 1;
+        }
+
+        const uint32 n = end - begin - offset;
+        if (n)
+        {
+            if (seek64( m_file, HEADER_BYTES + uint64( begin + offset - 1 ) * sizeof(uint32) ) == false ||
+                fread( buffer + offset, sizeof(uint32), n, m_file ) != n)
+                throw runtime_error( "FMIndexDataPaged: failed reading SSA page %u", page );
+        }
+
+        for (uint32 i = end - begin; i < m_page_size; ++i)
+            buffer[i] = 0u;
+    }
+
+    FILE*   m_file;
+    uint32  m_size;
+    uint32  m_page_size;
+};
+
+// constructor
+//
+FMIndexDataPaged::FMIndexDataPaged() :
+    m_flags             ( 0 ),
+    m_seq_length        ( 0 ),
+    m_primary           ( 0 ),
+    m_rprimary          ( 0 ),
+    m_bwt_occ_loader    ( NULL ),
+    m_rbwt_occ_loader   ( NULL ),
+    m_ssa_loader        ( NULL ),
+    m_rssa_loader       ( NULL )
+{
+    gen_bwt_count_table( m_count_table );
+    for (uint32 i = 0; i < 5; ++i)
+        m_L2[i] = 0;
+}
+
+// destructor
+//
+FMIndexDataPaged::~FMIndexDataPaged()
+{
+    release();
+}
+
+// release all loaders
+//
+void FMIndexDataPaged::release()
+{
+    delete m_bwt_occ_loader;
+    delete m_rbwt_occ_loader;
+    delete m_ssa_loader;
+    delete m_rssa_loader;
+
+    m_bwt_occ_loader  = NULL;
+    m_rbwt_occ_loader = NULL;
+    m_ssa_loader      = NULL;
+    m_rssa_loader     = NULL;
+
+    m_ssa  = ssa_type();
+    m_rssa = ssa_type();
+}
+
+// open a genome index, reserving a fixed amount of memory for the page caches
+//
+int FMIndexDataPaged::load(
+    const char*  genome_prefix,
+    const uint64 cache_bytes,
+    const uint32 flags,
+    const uint32 page_bytes)
+{
+    log_visible(stderr, "FMIndexDataPaged: loading... started\n");
+    log_visible(stderr, "  genome : %s\n", genome_prefix);
+
+    release();
+
+    m_flags = flags;
+
+    const std::string bwt_string  = std::string( genome_prefix ) + ".bwt";
+    const std::string rbwt_string = std::string( genome_prefix ) + ".rbwt";
+    const std::string sa_string   = std::string( genome_prefix ) + ".sa";
+    const std::string rsa_string  = std::string( genome_prefix ) + ".rsa";
+
+    const uint32 bwt_page_size = page_elements( page_bytes, sizeof(uint4),  2u );
+    const uint32 sa_page_size  = page_elements( page_bytes, sizeof(uint32), 1u );
+
+    // open the BWTs and compute their per-page counts
+    if (flags & FORWARD)
+    {
+        log_info(stderr, "scanning bwt... started\n");
+        m_bwt_occ_loader = new BwtOccLoader;
+        if (m_bwt_occ_loader->open( bwt_string.c_str(), m_count_table, bwt_page_size, m_seq_length, m_primary, m_L2 ) == false)
+        {
+            release();
+            return 0;
+        }
+        log_info(stderr, "scanning bwt... done\n");
+    }
+    if (flags & REVERSE)
+    {
+        log_info(stderr, "scanning rbwt... started\n");
+        m_rbwt_occ_loader = new BwtOccLoader;
+        if (m_rbwt_occ_loader->open( rbwt_string.c_str(), m_count_table, bwt_page_size, m_seq_length, m_rprimary, m_L2 ) == false)
+        {
+            release();
+            return 0;
+        }
+        log_info(stderr, "scanning rbwt... done\n");
+    }
+    log_verbose(stderr, "  length: %u\n", m_seq_length);
+
+    if (flags & SA)
+    {
+        if (flags & FORWARD)
+        {
+            m_ssa_loader = new SSALoader;
+            if (m_ssa_loader->open( sa_string.c_str(), m_seq_length, m_primary, sa_page_size ) == false)
+            {
+                delete m_ssa_loader;
+                m_ssa_loader = NULL;
+            }
+        }
+        if (flags & REVERSE)
+        {
+            m_rssa_loader = new SSALoader;
+            if (m_rssa_loader->open( rsa_string.c_str(), m_seq_length, m_rprimary, sa_page_size ) == false)
+            {
+                delete m_rssa_loader;
+                m_rssa_loader = NULL;
+            }
+        }
+    }
+
+    // split the cache budget among the tables in proportion to their size
+    const uint64 bwt_occ_bytes = m_bwt_occ_loader  ? m_bwt_occ_loader->size()  * sizeof(uint4)  : 0u;
+    const uint64 rbwt_occ_bytes= m_rbwt_occ_loader ? m_rbwt_occ_loader->size() * sizeof(uint4)  : 0u;
+    const uint64 ssa_bytes     = m_ssa_loader      ? m_ssa_loader->size()      * sizeof(uint32) : 0u;
+    const uint64 rssa_bytes    = m_rssa_loader     ? m_rssa_loader->size()     * sizeof(uint32) : 0u;
+    const uint64 total_bytes   = nvbio::max( bwt_occ_bytes + rbwt_occ_bytes + ssa_bytes + rssa_bytes, uint64(1u) );
+
+    const double fraction = double( cache_bytes ) / double( total_bytes );
+
+    if (m_bwt_occ_loader)
+    {
+        m_bwt_occ_cache.setup(
+            m_bwt_occ_loader->size(),
+            bwt_page_size,
+            uint32( double( bwt_occ_bytes ) * fraction / double( bwt_page_size * sizeof(uint4) ) ),
+            m_bwt_occ_loader );
+    }
+    if (m_rbwt_occ_loader)
+    {
+        m_rbwt_occ_cache.setup(
+            m_rbwt_occ_loader->size(),
+            bwt_page_size,
+            uint32( double( rbwt_occ_bytes ) * fraction / double( bwt_page_size * sizeof(uint4) ) ),
+            m_rbwt_occ_loader );
+    }
+    if (m_ssa_loader)
+    {
+        m_ssa_cache.setup(
+            m_ssa_loader->size(),
+            sa_page_size,
+            uint32( double( ssa_bytes ) * fraction / double( sa_page_size * sizeof(uint32) ) ),
+            m_ssa_loader );
+
+        m_ssa = ssa_type( ssa_iterator_type( &m_ssa_cache ) );
+    }
+    if (m_rssa_loader)
+    {
+        m_rssa_cache.setup(
+            m_rssa_loader->size(),
+            sa_page_size,
+            uint32( double( rssa_bytes ) * fraction / double( sa_page_size * sizeof(uint32) ) ),
+            m_rssa_loader );
+
+        m_rssa = ssa_type( ssa_iterator_type( &m_rssa_cache ) );
+    }
+
+    if (flags & FORWARD) log_visible(stderr, "   primary : %u\n", m_primary);
+    if (flags & REVERSE) log_visible(stderr, "  rprimary : %u\n", m_rprimary);
+
+    log_visible(stderr, "  cache    : %.1f MB (%.1f MB on disk)\n",
+        float( memory_footprint() )  / float(1024*1024),
+        float( total_bytes )         / float(1024*1024));
+
+    log_visible(stderr, "FMIndexDataPaged: loading... done\n");
+    return 1;
+}
+
+// pin the pages holding the occurrence blocks of a given BWT range
+//
+void FMIndexDataPaged::pin_range(const uint2 range, const bool reverse)
+{
+    PageCache<uint4>& cache = reverse ? m_rbwt_occ_cache : m_bwt_occ_cache;
+
+    // the OCC block of row i is stored at element 2*(i/OCC_INT)+1
+    const uint32 first = uint32( (2u * ((range.x ? range.x-1 : 0u) / OCC_INT) + 1u) / cache.page_size() );
+    const uint32 last  = uint32( (2u * (range.y                    / OCC_INT) + 1u) / cache.page_size() );
+    for (uint32 p = first; p <= last && p < cache.pages(); ++p)
+        cache.pin( p );
+}
+
+// unpin the pages pinned by a pin_range() call
+//
+void FMIndexDataPaged::unpin_range(const uint2 range, const bool reverse)
+{
+    PageCache<uint4>& cache = reverse ? m_rbwt_occ_cache : m_bwt_occ_cache;
+
+    const uint32 first = uint32( (2u * ((range.x ? range.x-1 : 0u) / OCC_INT) + 1u) / cache.page_size() );
+    const uint32 last  = uint32( (2u * (range.y                    / OCC_INT) + 1u) / cache.page_size() );
+    for (uint32 p = first; p <= last && p < cache.pages(); ++p)
+        cache.unpin( p );
+}
+
+// return the total number of bytes reserved for the caches
+//
+uint64 FMIndexDataPaged::memory_footprint() const
+{
+    return m_bwt_occ_cache.memory_footprint() +
+           m_rbwt_occ_cache.memory_footprint() +
+           m_ssa_cache.memory_footprint() +
+           m_rssa_cache.memory_footprint();
+}
+
+// return the total number of page cache hits
+//
+uint64 FMIndexDataPaged::hits() const
+{
+    return m_bwt_occ_cache.hits() +
+           m_rbwt_occ_cache.hits() +
+           m_ssa_cache.hits() +
+           m_rssa_cache.hits();
+}
+
+// return the total number of page cache misses
+//
+uint64 FMIndexDataPaged::misses() const
+{
+    return m_bwt_occ_cache.misses() +
+           m_rbwt_occ_cache.misses() +
+           m_ssa_cache.misses() +
+           m_rssa_cache.misses();
+}
+
+// reset the page cache counters
+//
+void FMIndexDataPaged::reset_stats()
+{
+    m_bwt_occ_cache.reset_stats();
+    m_rbwt_occ_cache.reset_stats();
+    m_ssa_cache.reset_stats();
+    m_rssa_cache.reset_stats();
+}
+
+} // namespace io
+} // namespace nvbio
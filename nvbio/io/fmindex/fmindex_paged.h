@@ -0,0 +1,194 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/io/fmindex/fmindex.h>
+#include <nvbio/basic/page_cache.h>
+#include <nvbio/basic/deinterleaved_iterator.h>
+#include <nvbio/basic/packedstream.h>
+#include <nvbio/fmindex/fmindex.h>
+#include <nvbio/fmindex/ssa.h>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup FMIndexIO
+///@{
+
+///
+/// An out-of-core host FM-index, which keeps only a bounded cache of its occurrence tables
+/// and sampled suffix arrays in RAM, paging fixed-size blocks in from the original
+/// <i>.bwt</i>/<i>.sa</i> files on demand and recycling them with an LRU policy.
+///\par
+/// The occurrence blocks are rebuilt from the corresponding BWT pages when loaded, starting
+/// from a small table of per-page base counts computed with a single streaming pass at
+/// load time, so that the index files need not be modified.
+///\par
+/// The index() and rindex() methods return regular fm_index views, so that all the host
+/// search and locate algorithms (e.g. match(), locate(), the backtracking routines) can
+/// run unchanged on indices larger than the available memory - provided they are used
+/// on the host.
+///
+struct FMIndexDataPaged
+{
+    static const uint32 FORWARD = FMIndexDataCore::FORWARD;
+    static const uint32 REVERSE = FMIndexDataCore::REVERSE;
+    static const uint32 SA      = FMIndexDataCore::SA;
+
+    static const uint32 BWT_BITS             = FMIndexDataCore::BWT_BITS;
+    static const bool   BWT_BIG_ENDIAN       = FMIndexDataCore::BWT_BIG_ENDIAN;
+    static const uint32 BWT_SYMBOLS_PER_WORD = FMIndexDataCore::BWT_SYMBOLS_PER_WORD;
+
+    static const uint32 OCC_INT = FMIndexDataCore::OCC_INT;
+    static const uint32 SA_INT  = FMIndexDataCore::SA_INT;
+
+    typedef page_cache_iterator<uint4>                              bwt_occ_type;
+    typedef deinterleaved_iterator<2,0,bwt_occ_type>                bwt_type;
+    typedef deinterleaved_iterator<2,1,bwt_occ_type>                occ_type;
+    typedef page_cache_iterator<uint32>                             ssa_iterator_type;
+
+    typedef const uint32*                                           count_table_type;
+    typedef SSA_index_multiple_context<SA_INT,ssa_iterator_type>    ssa_type;
+    typedef PackedStream<bwt_type,uint8,BWT_BITS,BWT_BIG_ENDIAN>    bwt_stream_type;
+
+    typedef rank_dictionary<
+        BWT_BITS,
+        OCC_INT,
+        bwt_stream_type,
+        occ_type,
+        count_table_type>                                           rank_dict_type;
+
+    typedef fm_index<rank_dict_type, ssa_type>                      fm_index_type;
+    typedef fm_index<rank_dict_type, null_type>             partial_fm_index_type;
+
+    struct BwtOccLoader;
+    struct SSALoader;
+
+     FMIndexDataPaged();                                            ///< empty constructor
+    ~FMIndexDataPaged();                                            ///< destructor
+
+    /// open a genome index, reserving a fixed amount of memory for the page caches
+    ///
+    /// \param genome_prefix            prefix file name
+    /// \param cache_bytes              total number of bytes reserved for the page caches,
+    ///                                 split among the loaded tables in proportion to their size
+    /// \param flags                    loading flags specifying which elements to load
+    /// \param page_bytes               the size of each page, in bytes
+    int load(
+        const char*  genome_prefix,
+        const uint64 cache_bytes,
+        const uint32 flags      = FORWARD | REVERSE | SA,
+        const uint32 page_bytes = 64*1024);
+
+    uint32        flags()           const { return m_flags; }               ///< return loading flags
+    uint32        length()          const { return m_seq_length; }          ///< return sequence length
+    uint32        primary()         const { return m_primary; }             ///< return the primary key
+    uint32        rprimary()        const { return m_rprimary; }            ///< return the reverse primary key
+    bool          has_ssa()         const { return m_ssa.m_ssa.m_cache  != NULL; }  ///< return whether the sampled suffix array is present
+    bool          has_rssa()        const { return m_rssa.m_ssa.m_cache != NULL; }  ///< return whether the reverse sampled suffix array is present
+    const uint32* count_table()     const { return m_count_table; }         ///< return the count table
+    const uint32* L2()              const { return m_L2; }                  ///< return the L2 table
+
+    PageCache<uint4>&   bwt_occ_cache()  { return m_bwt_occ_cache; }        ///< return the forward BWT/OCC page cache
+    PageCache<uint4>&  rbwt_occ_cache()  { return m_rbwt_occ_cache; }       ///< return the reverse BWT/OCC page cache
+    PageCache<uint32>&      ssa_cache()  { return m_ssa_cache; }            ///< return the forward SSA page cache
+    PageCache<uint32>&     rssa_cache()  { return m_rssa_cache; }           ///< return the reverse SSA page cache
+
+    /// pin the pages holding the occurrence blocks of a given BWT range, so that they are
+    /// never evicted until a matching unpin_range() call
+    ///
+    void pin_range(const uint2 range, const bool reverse = false);
+
+    /// unpin the pages pinned by a pin_range() call
+    ///
+    void unpin_range(const uint2 range, const bool reverse = false);
+
+    uint64 memory_footprint() const;                                    ///< return the total number of bytes reserved for the caches
+    uint64 hits()             const;                                    ///< return the total number of page cache hits
+    uint64 misses()           const;                                    ///< return the total number of page cache misses
+    void   reset_stats();                                               ///< reset the page cache counters
+
+    /// iterators access
+    ///
+    occ_type  occ_iterator() const { return occ_type( bwt_occ_type( &m_bwt_occ_cache ) ); }
+    occ_type rocc_iterator() const { return occ_type( bwt_occ_type( &m_rbwt_occ_cache ) ); }
+
+    bwt_type  bwt_iterator() const { return bwt_type( bwt_occ_type( &m_bwt_occ_cache ) ); }
+    bwt_type rbwt_iterator() const { return bwt_type( bwt_occ_type( &m_rbwt_occ_cache ) ); }
+
+    ssa_type  ssa_iterator() const { return m_ssa; }
+    ssa_type rssa_iterator() const { return m_rssa; }
+
+    count_table_type count_table_iterator() const { return count_table_type( count_table() ); }
+
+    rank_dict_type  rank_dict() const { return rank_dict_type( bwt_stream_type(  bwt_iterator() ),  occ_iterator(), count_table_iterator() ); }
+    rank_dict_type rrank_dict() const { return rank_dict_type( bwt_stream_type( rbwt_iterator() ), rocc_iterator(), count_table_iterator() ); }
+
+    fm_index_type  index() const { return fm_index_type( length(),  primary(), L2(),  rank_dict(),  ssa_iterator() ); }
+    fm_index_type rindex() const { return fm_index_type( length(), rprimary(), L2(), rrank_dict(), rssa_iterator() ); }
+
+    partial_fm_index_type  partial_index() const { return partial_fm_index_type( length(),  primary(), L2(),  rank_dict(), null_type() ); }
+    partial_fm_index_type rpartial_index() const { return partial_fm_index_type( length(), rprimary(), L2(), rrank_dict(), null_type() ); }
+
+private:
+    FMIndexDataPaged(const FMIndexDataPaged&);
+    FMIndexDataPaged& operator=(const FMIndexDataPaged&);
+
+    void release();
+
+    uint32                      m_flags;
+    uint32                      m_seq_length;
+    uint32                      m_primary;
+    uint32                      m_rprimary;
+
+    BwtOccLoader*               m_bwt_occ_loader;
+    BwtOccLoader*               m_rbwt_occ_loader;
+    SSALoader*                  m_ssa_loader;
+    SSALoader*                  m_rssa_loader;
+
+    mutable PageCache<uint4>    m_bwt_occ_cache;
+    mutable PageCache<uint4>    m_rbwt_occ_cache;
+    mutable PageCache<uint32>   m_ssa_cache;
+    mutable PageCache<uint32>   m_rssa_cache;
+
+    ssa_type                    m_ssa;
+    ssa_type                    m_rssa;
+
+    uint32                      m_count_table[256];
+    uint32                      m_L2[5];
+};
+
+///@} // FMIndexIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
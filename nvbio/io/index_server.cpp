@@ -0,0 +1,157 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/io/index_server.h>
+#include <nvbio/basic/console.h>
+#include <string.h>
+
+#ifndef WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace nvbio {
+namespace io {
+
+#ifndef WIN32
+
+// connect to the daemon's control socket
+//
+bool IndexServerClient::connect(const char* socket_path)
+{
+    close();
+
+    sockaddr_un address;
+    memset( &address, 0, sizeof(address) );
+    address.sun_family = AF_UNIX;
+    if (strlen( socket_path ) >= sizeof(address.sun_path))
+    {
+        log_error(stderr, "index server socket path too long: \"%s\"\n", socket_path);
+        return false;
+    }
+    strcpy( address.sun_path, socket_path );
+
+    m_socket = socket( AF_UNIX, SOCK_STREAM, 0 );
+    if (m_socket == -1)
+        return false;
+
+    if (::connect( m_socket, (const sockaddr*)&address, sizeof(address) ) != 0)
+    {
+        log_error(stderr, "could not connect to index server \"%s\"\n", socket_path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+// close the connection
+//
+void IndexServerClient::close()
+{
+    if (m_socket != -1)
+        ::close( m_socket );
+
+    m_socket = -1;
+}
+
+// send a command and collect its full reply
+//
+bool IndexServerClient::command(const std::string& cmd, std::string& reply)
+{
+    reply.clear();
+    if (m_socket == -1)
+        return false;
+
+    const std::string line = cmd + "\n";
+    if (send( m_socket, line.c_str(), line.length(), 0 ) != ssize_t( line.length() ))
+        return false;
+
+    // read until the final "ok" or "error" line; the item lines of multi-line replies
+    // are indented, so that they can never be mistaken for it
+    size_t line_begin = 0;
+    while (1)
+    {
+        char c;
+        if (recv( m_socket, &c, 1u, 0 ) != 1)
+            return false;
+
+        reply.push_back( c );
+        if (c != '\n')
+            continue;
+
+        const std::string last = reply.substr( line_begin );
+        if (last.compare( 0, 2, "ok" ) == 0)
+            return true;
+        if (last.compare( 0, 5, "error" ) == 0)
+            return false;
+
+        line_begin = reply.length();
+    }
+}
+
+// attach to a named index
+//
+bool IndexServerClient::attach(const char* name, std::string& mapped_name)
+{
+    std::string reply;
+    if (command( std::string("attach ") + name, reply ) == false)
+    {
+        log_error(stderr, "could not attach to index \"%s\": %s", name, reply.c_str());
+        return false;
+    }
+
+    // the reply has the form "ok mapped-name\n"
+    mapped_name = reply.length() > 4 ? reply.substr( 3, reply.length() - 4 ) : std::string( name );
+    return true;
+}
+
+// detach from a named index
+//
+bool IndexServerClient::detach(const char* name)
+{
+    std::string reply;
+    return command( std::string("detach ") + name, reply );
+}
+
+#else
+
+bool IndexServerClient::connect(const char* socket_path)
+{
+    log_error(stderr, "index server connections are not supported on this platform\n");
+    return false;
+}
+void IndexServerClient::close() {}
+bool IndexServerClient::command(const std::string& cmd, std::string& reply) { return false; }
+bool IndexServerClient::attach(const char* name, std::string& mapped_name) { return false; }
+bool IndexServerClient::detach(const char* name) { return false; }
+
+#endif
+
+} // namespace io
+} // namespace nvbio
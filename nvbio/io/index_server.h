@@ -0,0 +1,110 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#pragma once
+
+#include <nvbio/basic/types.h>
+#include <string>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///
+/// A client of the nvFM-server daemon, which talks to it through its local control socket
+/// using a simple line-based protocol:
+///
+/// - <tt>load name genome-prefix</tt> : load a new index under a given name
+/// - <tt>swap name genome-prefix</tt> : load a new version of an index and atomically replace the current one
+/// - <tt>unload name</tt>             : unload an index, as soon as all its clients have detached
+/// - <tt>attach name</tt>             : attach to an index, returning the name of its memory mapped objects
+/// - <tt>detach name</tt>             : detach from an index
+/// - <tt>list</tt>                    : report all loaded indices, their clients and memory usage
+/// - <tt>shutdown</tt>                : stop the daemon
+///
+/// Each reply ends with a line starting with either <tt>ok</tt> or <tt>error</tt>.
+/// Clients stay attached until they detach or close their connection, so that
+/// an index can't be released while it's still in use:
+///
+///\code
+/// io::IndexServerClient server;
+/// server.connect( "/tmp/nvfm.sock" );
+///
+/// std::string mapped_name;
+/// if (server.attach( "hg19", mapped_name ))
+/// {
+///     io::FMIndexDataMMAP fmindex;
+///     fmindex.load( mapped_name.c_str() );
+///     ...
+/// }
+///\endcode
+///
+struct IndexServerClient
+{
+    /// constructor
+    ///
+    IndexServerClient() : m_socket( -1 ) {}
+
+    /// destructor
+    ///
+    ~IndexServerClient() { close(); }
+
+    /// connect to the daemon's control socket
+    ///
+    bool connect(const char* socket_path);
+
+    /// close the connection, implicitly detaching from all indices
+    ///
+    void close();
+
+    /// attach to a named index, returning the name of its memory mapped objects
+    ///
+    bool attach(const char* name, std::string& mapped_name);
+
+    /// detach from a named index
+    ///
+    bool detach(const char* name);
+
+    /// send a command and collect its full reply, returning true if the command succeeded
+    ///
+    bool command(const std::string& cmd, std::string& reply);
+
+    /// is connected?
+    ///
+    bool is_connected() const { return m_socket != -1; }
+
+private:
+    int m_socket;
+};
+
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,359 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/io/input_stream.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/omp.h>
+#include <zlib/zlib.h>
+#include <lz4/lz4.h>
+#include <lz4/xxhash.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace nvbio {
+
+GZInputFile::GZInputFile(const char* name)
+{
+    m_file = gzopen( name, "rb" );
+}
+GZInputFile::~GZInputFile()
+{
+    if (m_file)
+        gzclose( m_file );
+}
+
+uint32 GZInputFile::read(const uint32 bytes, void* buffer)
+{
+    if (bytes == 0 || m_file == NULL)
+        return 0;
+
+    const int r = gzread( m_file, buffer, bytes );
+    if (r < 0)
+    {
+        gzclose( m_file );
+        m_file = NULL;
+        return 0;
+    }
+    return uint32(r);
+}
+
+namespace {
+
+static const uint32 LZ4_MAGICNUMBER  = 0x184D2204;
+static const uint32 LZ4_UNCOMPRESSED = 0x80000000;      // uncompressed block flag
+static const uint32 LZ4_DICT_SIZE    = 64*1024;         // the maximum back-reference distance of linked blocks
+static const int32  LZ4_BAD_CHECKSUM = -0x7FFFFFFF - 1;  // the decoded size marking a block checksum mismatch
+
+// read a 32-bit word in little-endian order
+//
+inline uint32 read_le32(const uint8* src)
+{
+    return  uint32( src[0] )        |
+           (uint32( src[1] ) << 8)  |
+           (uint32( src[2] ) << 16) |
+           (uint32( src[3] ) << 24);
+}
+
+} // anonymous namespace
+
+ParallelLZ4InputFile::ParallelLZ4InputFile(const char* name) :
+    m_file( NULL ),
+    m_eos( false ),
+    m_error( false ),
+    m_linked( false ),
+    m_block_checksum( false ),
+    m_content_checksum( false ),
+    m_content_hash( NULL ),
+    m_block_size( 0 ),
+    m_n_blocks( 0 ),
+    m_dict_size( 0 ),
+    m_buffer_begin( 0 ),
+    m_buffer_end( 0 )
+{
+    m_file = (FILE*)fopen( name, "rb" );
+    if (m_file == NULL)
+        return;
+
+    if (read_header() == false)
+    {
+        fclose( (FILE*)m_file ); m_file = NULL;
+        return;
+    }
+
+    // linked blocks must be decoded serially, so there's no point in batching too many of them
+    m_n_blocks = m_linked ? 1u : nvbio::max( uint32( omp_get_max_threads() ) * 4u, 4u );
+
+    m_comp_buffer.resize( m_n_blocks * m_block_size );
+    m_comp_sizes.resize( m_n_blocks );
+    m_block_hashes.resize( m_n_blocks );
+    m_block_sizes.resize( m_n_blocks );
+
+    if (m_content_checksum)
+    {
+        m_content_hash = XXH32_createState();
+        XXH32_reset( (XXH32_state_t*)m_content_hash, 0u );
+    }
+
+    // reserve a prefix to hold the dictionary of linked blocks
+    m_buffer.resize( LZ4_DICT_SIZE + m_n_blocks * m_block_size );
+    m_buffer_begin = m_buffer_end = LZ4_DICT_SIZE;
+}
+ParallelLZ4InputFile::~ParallelLZ4InputFile()
+{
+    if (m_file)
+        fclose( (FILE*)m_file );
+
+    if (m_content_hash)
+        XXH32_freeState( (XXH32_state_t*)m_content_hash );
+}
+
+// parse the frame header
+//
+bool ParallelLZ4InputFile::read_header()
+{
+    uint8 header[19];
+    if (fread( header, 1u, 7u, (FILE*)m_file ) < 7u)
+    {
+        log_error(stderr, "LZ4 reader: truncated frame header\n");
+        return false;
+    }
+
+    if (read_le32( header ) != LZ4_MAGICNUMBER)
+    {
+        log_error(stderr, "LZ4 reader: invalid magic number\n");
+        return false;
+    }
+
+    const uint8 flags = header[4];
+    if ((flags >> 6) != 1u)
+    {
+        log_error(stderr, "LZ4 reader: unsupported frame version %u\n", uint32( flags >> 6 ));
+        return false;
+    }
+
+    m_linked           = ((flags >> 5) & 1u) == 0u;
+    m_block_checksum   = ((flags >> 4) & 1u) != 0u;
+    m_content_checksum = ((flags >> 2) & 1u) != 0u;
+
+    const uint32 block_size_id = (header[5] >> 4) & 7u;
+    if (block_size_id < 4u)
+    {
+        log_error(stderr, "LZ4 reader: invalid block size id %u\n", block_size_id);
+        return false;
+    }
+    m_block_size = 1u << (2u*block_size_id + 8u);
+
+    // read the optional content size and dictionary id fields, followed by the header checksum
+    const uint32 desc_size = 2u + ((flags & 8u) ? 8u : 0u) + ((flags & 1u) ? 4u : 0u);
+    if (desc_size > 2u && fread( header + 7u, 1u, desc_size - 2u, (FILE*)m_file ) < desc_size - 2u)
+    {
+        log_error(stderr, "LZ4 reader: truncated frame header\n");
+        return false;
+    }
+
+    const uint8 checkbits = uint8( (XXH32( header + 4, desc_size, 0 ) >> 8) & 0xFF );
+    if (header[4u + desc_size] != checkbits)
+    {
+        log_error(stderr, "LZ4 reader: frame header checksum mismatch\n");
+        return false;
+    }
+
+    return true;
+}
+
+// load and decompress the next batch of blocks, returning the number of decoded bytes
+//
+uint32 ParallelLZ4InputFile::decode_blocks()
+{
+    if (m_eos || m_file == NULL)
+        return 0;
+
+    FILE* file = (FILE*)m_file;
+
+    // read the next batch of compressed blocks
+    uint32 n_blocks = 0;
+    bool   end_mark = false;
+    uint32 content_checksum = 0u;
+    while (n_blocks < m_n_blocks)
+    {
+        uint8 word[4];
+        if (fread( word, 1u, 4u, file ) < 4u)
+        {
+            log_error(stderr, "LZ4 reader: truncated frame\n");
+            m_eos = m_error = true;
+            break;
+        }
+
+        const uint32 block_header = read_le32( word );
+        if (block_header == 0u)
+        {
+            // end mark, followed by the optional content checksum
+            m_eos = end_mark = true;
+
+            if (m_content_checksum)
+            {
+                if (fread( word, 1u, 4u, file ) < 4u)
+                {
+                    log_error(stderr, "LZ4 reader: truncated content checksum\n");
+                    m_error = true;
+                }
+                content_checksum = read_le32( word );
+            }
+            break;
+        }
+
+        const uint32 comp_size = block_header & ~LZ4_UNCOMPRESSED;
+        if (comp_size > m_block_size ||
+            fread( &m_comp_buffer[0] + n_blocks * m_block_size, 1u, comp_size, file ) < comp_size)
+        {
+            log_error(stderr, "LZ4 reader: corrupt block\n");
+            m_eos = m_error = true;
+            break;
+        }
+
+        // read the block checksum, verified before decoding the block
+        if (m_block_checksum)
+        {
+            if (fread( word, 1u, 4u, file ) < 4u)
+            {
+                log_error(stderr, "LZ4 reader: truncated frame\n");
+                m_eos = m_error = true;
+                break;
+            }
+            m_block_hashes[ n_blocks ] = read_le32( word );
+        }
+
+        m_comp_sizes[ n_blocks++ ] = block_header;
+    }
+
+    if (m_linked)
+    {
+        // move the tail of the previously decoded data right before the output, to serve as dictionary
+        const uint32 dict_size = nvbio::min( LZ4_DICT_SIZE, m_dict_size + m_buffer_end - LZ4_DICT_SIZE );
+        memmove( &m_buffer[0] + LZ4_DICT_SIZE - dict_size, &m_buffer[0] + m_buffer_end - dict_size, dict_size );
+        m_dict_size = dict_size;
+    }
+
+    #pragma omp parallel for if (m_linked == false)
+    for (int block = 0; block < int( n_blocks ); ++block)
+    {
+        const uint32 comp_size = m_comp_sizes[ block ] & ~LZ4_UNCOMPRESSED;
+        const char*  src       = (const char*)&m_comp_buffer[0] + block * m_block_size;
+              char*  dst       = (char*)&m_buffer[0] + LZ4_DICT_SIZE + block * m_block_size;
+
+        if (m_block_checksum && XXH32( src, comp_size, 0u ) != m_block_hashes[ block ])
+            m_block_sizes[ block ] = LZ4_BAD_CHECKSUM;
+        else if (m_comp_sizes[ block ] & LZ4_UNCOMPRESSED)
+        {
+            memcpy( dst, src, comp_size );
+            m_block_sizes[ block ] = int32( comp_size );
+        }
+        else if (m_linked == false)
+            m_block_sizes[ block ] = LZ4_decompress_safe( src, dst, comp_size, m_block_size );
+        else
+            m_block_sizes[ block ] = LZ4_decompress_safe_usingDict( src, dst, comp_size, m_block_size, dst - m_dict_size, m_dict_size );
+    }
+
+    // compact the decoded blocks, which may be smaller than the maximum block size
+    uint32 out = LZ4_DICT_SIZE;
+    for (uint32 block = 0; block < n_blocks; ++block)
+    {
+        if (m_block_sizes[ block ] < 0)
+        {
+            if (m_block_sizes[ block ] == LZ4_BAD_CHECKSUM)
+                log_error(stderr, "LZ4 reader: block checksum mismatch\n");
+            else
+                log_error(stderr, "LZ4 reader: corrupt block\n");
+
+            m_eos = m_error = true;
+            break;
+        }
+
+        const uint32 block_begin = LZ4_DICT_SIZE + block * m_block_size;
+        if (out != block_begin)
+            memmove( &m_buffer[0] + out, &m_buffer[0] + block_begin, m_block_sizes[ block ] );
+
+        out += uint32( m_block_sizes[ block ] );
+    }
+
+    // hash the decoded content, and check it against the frame's once complete
+    if (m_content_checksum && m_error == false)
+    {
+        XXH32_update( (XXH32_state_t*)m_content_hash, &m_buffer[0] + LZ4_DICT_SIZE, out - LZ4_DICT_SIZE );
+
+        if (end_mark && XXH32_digest( (XXH32_state_t*)m_content_hash ) != content_checksum)
+        {
+            log_error(stderr, "LZ4 reader: content checksum mismatch\n");
+            m_error = true;
+        }
+    }
+
+    m_buffer_begin = LZ4_DICT_SIZE;
+    m_buffer_end   = out;
+    return out - LZ4_DICT_SIZE;
+}
+
+uint32 ParallelLZ4InputFile::read(const uint32 bytes, void* buffer)
+{
+    uint8* dst = (uint8*)buffer;
+
+    uint32 n_read = 0;
+    while (n_read < bytes)
+    {
+        // refill the buffer if empty
+        if (m_buffer_begin == m_buffer_end &&
+            decode_blocks() == 0)
+            break;
+
+        const uint32 n_bytes = nvbio::min( bytes - n_read, m_buffer_end - m_buffer_begin );
+
+        memcpy( dst + n_read, &m_buffer[0] + m_buffer_begin, n_bytes );
+
+        m_buffer_begin += n_bytes;
+        n_read         += n_bytes;
+    }
+    return n_read;
+}
+
+// input file factory method
+//
+InputStream* open_input_file(const char* file_name, const char* compressor)
+{
+    if (compressor == NULL || strcmp( compressor, "" ) == 0 ||
+        strcmp( compressor, "gzip" ) == 0 || strcmp( compressor, "gz" ) == 0)
+        return new GZInputFile( file_name );
+    else if (strcmp( compressor, "lz4" ) == 0)
+        return new ParallelLZ4InputFile( file_name );
+
+    log_warning(stderr, "unknown input file compressor \"%s\"\n", compressor );
+    return NULL;
+}
+
+} // namespace nvbio
@@ -0,0 +1,136 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#include <nvbio/basic/types.h>
+#include <vector>
+
+#pragma once
+
+namespace nvbio {
+
+///@addtogroup IO
+///@{
+
+/// Base abstract input file class
+///
+struct InputStream
+{
+    /// virtual destructor
+    ///
+    virtual ~InputStream() {}
+
+    /// read a given number of bytes, returning the number of bytes actually read
+    ///
+    virtual uint32 read(const uint32 bytes, void* buffer) { return 0; }
+
+    /// is valid?
+    ///
+    virtual bool is_valid() const { return true; }
+};
+
+// gzip input file class; this also works for plain uncompressed files
+//
+struct GZInputFile : public InputStream
+{
+    /// constructor
+    ///
+    GZInputFile(const char* name);
+
+    /// destructor
+    ///
+    ~GZInputFile();
+
+    /// read a given number of bytes
+    ///
+    uint32 read(const uint32 bytes, void* buffer);
+
+    /// is valid?
+    ///
+    bool is_valid() const { return m_file != NULL; }
+
+    void* m_file;
+};
+
+// LZ4 input file class, matching ParallelLZ4OutputFile: frames made of independent
+// blocks are decompressed in parallel, batches of blocks at a time; frames with linked
+// blocks are supported too, though they are decoded serially.
+// The header, block and content checksums are verified whenever the frame declares them:
+// reading stops at the first corrupt block, and is_valid() returns false after any error
+//
+struct ParallelLZ4InputFile : public InputStream
+{
+    /// constructor
+    ///
+    ParallelLZ4InputFile(const char* name);
+
+    /// destructor
+    ///
+    ~ParallelLZ4InputFile();
+
+    /// read a given number of bytes
+    ///
+    uint32 read(const uint32 bytes, void* buffer);
+
+    /// is valid?
+    ///
+    bool is_valid() const { return m_file != NULL && m_error == false; }
+
+    /// parse the frame header
+    ///
+    bool read_header();
+
+    /// load and decompress the next batch of blocks, returning the number of decoded bytes
+    ///
+    uint32 decode_blocks();
+
+    void*               m_file;
+    bool                m_eos;
+    bool                m_error;
+    bool                m_linked;
+    bool                m_block_checksum;
+    bool                m_content_checksum;
+    void*               m_content_hash;
+    uint32              m_block_size;
+    uint32              m_n_blocks;
+    std::vector<uint8>  m_comp_buffer;
+    std::vector<uint32> m_comp_sizes;
+    std::vector<uint32> m_block_hashes;
+    std::vector<int32>  m_block_sizes;
+    std::vector<uint8>  m_buffer;
+    uint32              m_dict_size;
+    uint32              m_buffer_begin;
+    uint32              m_buffer_end;
+};
+
+/// input file factory method
+///
+InputStream* open_input_file(const char* file_name, const char* compressor);
+
+///@} // IO
+
+} // namespace nvbio
@@ -27,8 +27,13 @@
 
 #include <nvbio/io/output_stream.h>
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/omp.h>
 #include <zlib/zlib.h>
+#include <lz4/lz4.h>
+#include <lz4/lz4hc.h>
 #include <lz4/lz4frame.h>
+#include <lz4/xxhash.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -135,6 +140,204 @@ uint32 LZ4OutputFile::write(const uint32 bytes, const void* buffer)
     return bytes;
 }
 
+namespace {
+
+static const uint32 LZ4_MAGICNUMBER    = 0x184D2204;
+static const uint32 LZ4_UNCOMPRESSED   = 0x80000000;                            // uncompressed block flag
+
+// write a 32-bit word in little-endian order
+//
+inline void write_le32(uint8* dst, const uint32 v)
+{
+    dst[0] = uint8( v );
+    dst[1] = uint8( v >> 8 );
+    dst[2] = uint8( v >> 16 );
+    dst[3] = uint8( v >> 24 );
+}
+
+} // anonymous namespace
+
+ParallelLZ4OutputFile::ParallelLZ4OutputFile(const char* name, const char* comp, const uint32 block_size_id, const bool checksums) :
+    m_file( NULL ), m_level( 0 ), m_block_size( 0 ), m_checksums( checksums ), m_content_hash( NULL ), m_n_blocks( 0 ), m_buffer_size( 0 )
+{
+    if (block_size_id < 4u || block_size_id > 7u)
+    {
+        log_error(stderr, "LZ4 writer: invalid block size id %u\n", block_size_id);
+        return;
+    }
+
+    m_file = (FILE*)fopen( name, "wb" );
+    if (m_file == NULL)
+        return;
+
+    // parse the compression level: levels below 3 select the fast compressor, the others LZ4-HC
+    if (comp && comp[0] >= '0' && comp[0] <= '9')
+        m_level = comp[0] - '0';
+
+    // the compression unit, in bytes
+    m_block_size = 1u << (2u*block_size_id + 8u);
+
+    // buffer enough blocks to keep all threads busy
+    m_n_blocks = nvbio::max( uint32( omp_get_max_threads() ) * 4u, 4u );
+
+    m_buffer.resize( m_n_blocks * m_block_size );
+    m_comp_buffer.resize( m_n_blocks * m_block_size );
+    m_comp_sizes.resize( m_n_blocks );
+    m_block_hashes.resize( m_n_blocks );
+
+    if (m_checksums)
+    {
+        m_content_hash = XXH32_createState();
+        XXH32_reset( (XXH32_state_t*)m_content_hash, 0u );
+    }
+
+    // write the frame header
+    uint8 header[7];
+    write_le32( header, LZ4_MAGICNUMBER );
+    header[4] = (1u << 6) |                         // version '01'
+                (1u << 5) |                         // independent blocks
+                (m_checksums ? (1u << 4) : 0u) |    // block checksums
+                (m_checksums ? (1u << 2) : 0u);     // content checksum
+    header[5] = uint8( block_size_id << 4 );        // maximum block size
+    header[6] = uint8( (XXH32( header + 4, 2, 0 ) >> 8) & 0xFF );
+
+    if (fwrite( header, 1u, 7u, (FILE*)m_file ) < 7u)
+    {
+        // an error has occurred, shutdown the file
+        fclose( (FILE*)m_file ); m_file = NULL;
+    }
+}
+ParallelLZ4OutputFile::~ParallelLZ4OutputFile()
+{
+    if (m_file)
+    {
+        // flush any remaining data
+        if (m_buffer_size)
+            encode_blocks( m_buffer_size, &m_buffer[0] );
+    }
+
+    // write the end mark, followed by the content checksum
+    if (m_file)
+    {
+        uint8 eos[8];
+        write_le32( eos, 0u );
+        if (m_checksums)
+            write_le32( eos + 4, XXH32_digest( (XXH32_state_t*)m_content_hash ) );
+
+        fwrite( eos, 1u, m_checksums ? 8u : 4u, (FILE*)m_file );
+        fclose( (FILE*)m_file );
+    }
+
+    if (m_content_hash)
+        XXH32_freeState( (XXH32_state_t*)m_content_hash );
+}
+
+uint32 ParallelLZ4OutputFile::write(const uint32 bytes, const void* buffer)
+{
+    if (bytes == 0 || m_file == NULL)
+        return 0;
+
+    const uint32 batch_size = m_n_blocks * m_block_size;
+
+    const uint8* src     = (const uint8*)buffer;
+          uint32 n_bytes = bytes;
+
+    if (m_buffer_size)
+    {
+        //
+        // we have some pending bytes in the buffer, let's add as much as we can and
+        // eventually output a batch if full
+        //
+        const uint32 n_needed = nvbio::min( batch_size - m_buffer_size, n_bytes );
+
+        memcpy( &m_buffer[0] + m_buffer_size, src, n_needed );
+
+        m_buffer_size += n_needed;
+        src           += n_needed;
+        n_bytes       -= n_needed;
+
+        if (m_buffer_size == batch_size)
+        {
+            encode_blocks( m_buffer_size, &m_buffer[0] );
+            m_buffer_size = 0;
+        }
+    }
+
+    // encode all full batches directly from the source, and buffer the remainder
+    while (n_bytes >= batch_size && m_file)
+    {
+        encode_blocks( batch_size, src );
+
+        src     += batch_size;
+        n_bytes -= batch_size;
+    }
+    if (n_bytes)
+    {
+        memcpy( &m_buffer[0] + m_buffer_size, src, n_bytes );
+        m_buffer_size += n_bytes;
+    }
+    return m_file ? bytes : 0;
+}
+
+// compress a batch of blocks in parallel and write them to the output
+//
+void ParallelLZ4OutputFile::encode_blocks(const uint32 n_bytes, const uint8* src)
+{
+    const int n_blocks = int( util::divide_ri( n_bytes, m_block_size ) );
+
+    #pragma omp parallel for
+    for (int block = 0; block < n_blocks; ++block)
+    {
+        const uint32 block_begin = uint32( block ) * m_block_size;
+        const uint32 block_size  = nvbio::min( m_block_size, n_bytes - block_begin );
+
+        const char* block_src = (const char*)src + block_begin;
+              char* block_dst = (char*)&m_comp_buffer[0] + block_begin;
+
+        // limit the output so that incompressible blocks can be stored verbatim
+        m_comp_sizes[ block ] = m_level < 3 ?
+            (uint32)LZ4_compress_limitedOutput( block_src, block_dst, block_size, block_size-1 ) :
+            (uint32)LZ4_compressHC2_limitedOutput( block_src, block_dst, block_size, block_size-1, m_level );
+
+        // block checksums cover the block data as stored
+        if (m_checksums)
+        {
+            m_block_hashes[ block ] = m_comp_sizes[ block ] ?
+                XXH32( block_dst, m_comp_sizes[ block ], 0u ) :
+                XXH32( block_src, block_size, 0u );
+        }
+    }
+
+    // the content checksum covers the uncompressed stream, in order
+    if (m_checksums)
+        XXH32_update( (XXH32_state_t*)m_content_hash, src, n_bytes );
+
+    // write down all blocks in order
+    for (int block = 0; block < n_blocks && m_file; ++block)
+    {
+        const uint32 block_begin  = uint32( block ) * m_block_size;
+        const uint32 block_size   = nvbio::min( m_block_size, n_bytes - block_begin );
+        const uint32 n_compressed = m_comp_sizes[ block ];
+
+        uint8 block_header[4];
+        write_le32( block_header, n_compressed ? n_compressed : (block_size | LZ4_UNCOMPRESSED) );
+
+        const uint8* block_data = n_compressed ? &m_comp_buffer[0] + block_begin : src + block_begin;
+        const uint32 data_size  = n_compressed ? n_compressed : block_size;
+
+        uint8 block_hash[4];
+        write_le32( block_hash, m_checksums ? m_block_hashes[ block ] : 0u );
+
+        if (fwrite( block_header, 1u, 4u, (FILE*)m_file ) < 4u ||
+            fwrite( block_data, 1u, data_size, (FILE*)m_file ) < data_size ||
+            (m_checksums && fwrite( block_hash, 1u, 4u, (FILE*)m_file ) < 4u))
+        {
+            // an error has occurred, shutdown the file
+            fclose( (FILE*)m_file ); m_file = NULL;
+        }
+    }
+}
+
 // output file factory method
 //
 OutputStream* open_output_file(const char* file_name, const char* compressor, const char* options)
@@ -144,7 +347,7 @@ OutputStream* open_output_file(const char* file_name, const char* compressor, co
     else if (strcmp( compressor, "gzip" ) == 0 || strcmp( compressor, "gz" ) == 0)
         return new GZOutputFile( file_name, options );
     else if (strcmp( compressor, "lz4" ) == 0)
-        return new LZ4OutputFile( file_name, options );
+        return new ParallelLZ4OutputFile( file_name, options );
 
     log_warning(stderr, "unknown output file compressor \"%s\"\n", compressor );
     return NULL;
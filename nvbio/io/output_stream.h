@@ -100,6 +100,49 @@ struct LZ4OutputFile : public OutputStream
     std::vector<uint8>  m_buffer;
 };
 
+// LZ4 output file class compressing fixed-size, independent blocks in parallel
+// and emitting a standard LZ4 frame
+//
+struct ParallelLZ4OutputFile : public OutputStream
+{
+    /// constructor
+    ///
+    /// \param name            the output file name
+    /// \param comp            the compression level, as a single digit
+    /// \param block_size_id   the LZ4 block size id: 4 = 64 KB, 5 = 256 KB, 6 = 1 MB, 7 = 4 MB
+    /// \param checksums       whether to emit block and content checksums
+    ///
+    ParallelLZ4OutputFile(const char* name, const char* comp, const uint32 block_size_id = 6u, const bool checksums = false);
+
+    /// destructor
+    ///
+    ~ParallelLZ4OutputFile();
+
+    /// write a given number of bytes
+    ///
+    uint32 write(const uint32 bytes, const void* buffer);
+
+    /// is valid?
+    ///
+    bool is_valid() const { return m_file != NULL; }
+
+    /// compress a batch of blocks in parallel and write them to the output
+    ///
+    void encode_blocks(const uint32 n_bytes, const uint8* src);
+
+    void*               m_file;
+    int                 m_level;
+    uint32              m_block_size;
+    bool                m_checksums;
+    void*               m_content_hash;
+    uint32              m_n_blocks;
+    std::vector<uint8>  m_buffer;
+    uint32              m_buffer_size;
+    std::vector<uint8>  m_comp_buffer;
+    std::vector<uint32> m_comp_sizes;
+    std::vector<uint32> m_block_hashes;
+};
+
 /// output file factory method
 ///
 OutputStream* open_output_file(const char* file_name, const char* compressor, const char* options);
@@ -30,6 +30,7 @@
 #include <zlib/zlib.h>
 
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/profiling.h>
 #include <nvbio/basic/packedstream.h>
 #include <nvbio/io/sequence/sequence_bam.h>
 #include <nvbio/io/sequence/sequence_sam.h>
@@ -181,6 +182,8 @@ bool SequenceDataFile_BAM::rewind()
 // grab the next chunk of reads from the file, up to max_reads
 int SequenceDataFile_BAM::nextChunk(SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps)
 {
+    NVBIO_PROFILE_REGION( "io/bam-parse" );
+
     if (max_bps < SequenceDataFile::LONG_READ)
         return 0;
 
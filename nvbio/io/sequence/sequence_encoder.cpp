@@ -26,7 +26,10 @@
  */
 
 #include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/basic/packedstream_transcode.h>
 #include <stdio.h>
+#include <algorithm>
+#include <vector>
 
 namespace nvbio {
 namespace io {
@@ -162,7 +165,7 @@ struct sequence_string
     // quality operator
     uint8 quality(const uint32 i) const
     {
-        const uint32 index = (FLAGS & REVERSE) ? m_len - i - 1u : i;
+        const uint32 index = (FLAGS & SequenceDataEncoder::REVERSE_OP) ? m_len - i - 1u : i;
 
         return m_qual[index];
     }
@@ -240,19 +243,30 @@ void encode(
     const uint8*                                                                    sequence,
     const uint8*                                                                    quality,
     typename SequenceDataEdit<ALPHABET,SequenceDataView>::sequence_stream_type      stream,
-    char*                                                                           qual_stream)
+    char*                                                                           qual_stream,
+    std::vector<uint32>&                                                            scratch)
 {
-    const sequence_string<ALPHABET,SequenceDataEncoder::REVERSE_OP>              r_sequence( sequence_len, sequence, quality );
-    const sequence_string<ALPHABET,SequenceDataEncoder::REVERSE_COMPLEMENT_OP>   rc_sequence( sequence_len, sequence, quality );
+    typedef typename SequenceDataEdit<ALPHABET,SequenceDataView>::sequence_stream_type sequence_stream_type;
+
     const sequence_string<ALPHABET,SequenceDataEncoder::COMPLEMENT_OP>           fc_sequence( sequence_len, sequence, quality );
     const sequence_string<ALPHABET,SequenceDataEncoder::NO_OP>                   f_sequence( sequence_len, sequence, quality );
 
     if (conversion_flags & SequenceDataEncoder::REVERSE_OP)
     {
+        // encode the forward strand in a temporary stream, and reverse it a word at a time
+        const uint32 words = util::divide_ri( sequence_len, SequenceDataTraits<ALPHABET>::SEQUENCE_SYMBOLS_PER_WORD );
+        if (scratch.size() < words + 1u)
+            scratch.resize( words + 1u );
+
+        sequence_stream_type forward( &scratch[0] );
+
         if (conversion_flags & SequenceDataEncoder::COMPLEMENT_OP)
-            encode<ALPHABET>( quality_encoding, rc_sequence, stream, qual_stream );
+            encode<ALPHABET>( quality_encoding, fc_sequence, forward, qual_stream );
         else
-            encode<ALPHABET>( quality_encoding, r_sequence,  stream, qual_stream );
+            encode<ALPHABET>( quality_encoding, f_sequence,  forward, qual_stream );
+
+        packed_reverse( sequence_len, forward, stream );
+        std::reverse( qual_stream, qual_stream + sequence_len );
     }
     else
     {
@@ -373,7 +387,8 @@ struct SequenceDataEncoderImpl : public SequenceDataEncoder
             base_pairs,
             quality,
             stream + m_data->m_sequence_stream_len,
-            nvbio::raw_pointer( m_data->m_qual_vec ) + m_data->m_sequence_stream_len );
+            nvbio::raw_pointer( m_data->m_qual_vec ) + m_data->m_sequence_stream_len,
+            m_scratch );
 
         // update sequence and bp counts
         m_data->m_n_seqs++;
@@ -415,8 +430,9 @@ struct SequenceDataEncoderImpl : public SequenceDataEncoder
     const SequenceDataInfo* info() const { return m_data; }
 
 private:
-    SequenceDataHost* m_data;
-    bool              m_append;
+    SequenceDataHost*   m_data;
+    bool                m_append;
+    std::vector<uint32> m_scratch;      // temporary storage for reversed strands
 };
 
 // create a sequence encoder
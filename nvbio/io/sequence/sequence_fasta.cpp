@@ -29,6 +29,7 @@
 #include <nvbio/io/sequence/sequence_encoder.h>
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/timer.h>
+#include <nvbio/basic/profiling.h>
 
 #include <string.h>
 #include <ctype.h>
@@ -152,6 +153,8 @@ bool SequenceDataFile_FASTA_gz::rewind()
 //
 int SequenceDataFile_FASTA_gz::nextChunk(SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps)
 {
+    NVBIO_PROFILE_REGION( "io/fasta-parse" );
+
     const uint32 read_mult =
         ((m_options.flags & FORWARD)            ? 1u : 0u) +
         ((m_options.flags & REVERSE)            ? 1u : 0u) +
@@ -29,6 +29,7 @@
 #include <nvbio/io/sequence/sequence_encoder.h>
 #include <nvbio/basic/types.h>
 #include <nvbio/basic/timer.h>
+#include <nvbio/basic/profiling.h>
 
 #include <string.h>
 #include <ctype.h>
@@ -47,6 +48,8 @@ namespace io {
 
 int SequenceDataFile_FASTQ_parser::nextChunk(SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps)
 {
+    NVBIO_PROFILE_REGION( "io/fastq-parse" );
+
     uint32 n_reads = 0;
     uint32 n_bps   = 0;
     char   marker;
@@ -32,6 +32,18 @@
 namespace nvbio {
 namespace io {
 
+// set the page size and NUMA placement options of the mapped objects
+//
+void SequenceDataMMAPServer::set_mapping_options(const MappingOptions& options)
+{
+    m_info_file.set_options( options );
+    m_sequence_file.set_options( options );
+    m_sequence_index_file.set_options( options );
+    m_qual_file.set_options( options );
+    m_name_file.set_options( options );
+    m_name_index_file.set_options( options );
+}
+
 // load a sequence from file
 //
 // \param alphabet                 the alphabet to use for encoding
@@ -49,10 +61,46 @@ bool SequenceDataMMAPServer::load(
     // TODO: check the extension; if there's no extension, assume it's a pac index
     bool r = load_pac( alphabet, this, file_name, mapped_name, load_flags, qualities );
 
+    // publish the per-node replicas, if requested
+    if (r)
+    {
+        try
+        {
+            m_info_file.replicate();
+            m_sequence_file.replicate();
+            m_sequence_index_file.replicate();
+            m_qual_file.replicate();
+            m_name_file.replicate();
+            m_name_index_file.replicate();
+        }
+        catch (ServerMappedFile::mapping_error e)
+        {
+            log_error(stderr, "  mapping error while replicating file: %s (code: %u)\n", e.m_file_name, e.m_code );
+            r = false;
+        }
+        catch (ServerMappedFile::view_error e)
+        {
+            log_error(stderr, "  view error while replicating file: %s (code: %u)\n", e.m_file_name, e.m_code );
+            r = false;
+        }
+    }
+
     log_visible(stderr, "SequenceDataMMAPServer::loading... done\n");
     return r;
 }
 
+// return the total number of bytes of shared memory used by the mapped objects
+//
+uint64 SequenceDataMMAPServer::memory_footprint() const
+{
+    return m_info_file.size() +
+           m_sequence_file.size() +
+           m_sequence_index_file.size() +
+           m_qual_file.size() +
+           m_name_file.size() +
+           m_name_index_file.size();
+}
+
 std::string SequenceDataMMAPServer::info_file_name(const char* name)            { return std::string("nvbio.") + std::string( name ) + ".seq_info";}
 std::string SequenceDataMMAPServer::sequence_file_name(const char* name)        { return std::string("nvbio.") + std::string( name ) + ".seq"; }
 std::string SequenceDataMMAPServer::sequence_index_file_name(const char* name)  { return std::string("nvbio.") + std::string( name ) + ".seq_index"; }
@@ -77,7 +125,7 @@ bool SequenceDataMMAP::load(const char* file_name)
 
         this->SequenceDataInfo::operator=( *info );
 
-        const uint64 index_file_size    = info->size()  * sizeof(uint32);
+        const uint64 index_file_size    = (info->size() + 1u) * sizeof(uint32);
         const uint64 seq_file_size      = info->words() * sizeof(uint32);
         const uint64 qual_file_size     = info->qs()    * sizeof(char);
         const uint64 name_file_size     = info->m_name_stream_len * sizeof(char);
@@ -86,7 +134,7 @@ bool SequenceDataMMAP::load(const char* file_name)
         m_sequence_index_ptr  = (uint32*)m_sequence_index_file.init( seqIndexName.c_str(), index_file_size );
         m_qual_ptr            = qual_file_size ? (char*)m_qual_file.init( qualName.c_str(), qual_file_size ) : NULL;
         m_name_ptr            =   (char*)m_name_file.init( nameName.c_str(), name_file_size );
-        m_name_index_ptr      = (uint32*)m_sequence_index_file.init( nameIndexName.c_str(), index_file_size );
+        m_name_index_ptr      = (uint32*)m_name_index_file.init( nameIndexName.c_str(), index_file_size );
     }
     catch (MappedFile::mapping_error error)
     {
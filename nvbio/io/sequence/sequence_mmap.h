@@ -48,6 +48,11 @@ namespace io {
 ///
 struct SequenceDataMMAPServer
 {
+    /// set the page size and NUMA placement options of the mapped objects;
+    /// must be called before load()
+    ///
+    void set_mapping_options(const MappingOptions& options);
+
     /// load a sequence from file
     ///
     /// \param alphabet                 the alphabet to use for encoding
@@ -60,6 +65,10 @@ struct SequenceDataMMAPServer
         const SequenceFlags     load_flags  = io::SequenceFlags( io::SEQUENCE_DATA | io::SEQUENCE_QUALS | io::SEQUENCE_NAMES ),
         const QualityEncoding   qualities   = Phred33);
 
+    /// return the total number of bytes of shared memory used by the mapped objects
+    ///
+    uint64 memory_footprint() const;
+
     static std::string info_file_name(const char* name);
     static std::string sequence_file_name(const char* name);
     static std::string sequence_index_file_name(const char* name);
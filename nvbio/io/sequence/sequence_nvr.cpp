@@ -0,0 +1,801 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <nvbio/io/sequence/sequence_nvr.h>
+#include <nvbio/io/sequence/sequence_encoder.h>
+#include <nvbio/io/sequence/sequence_access.h>
+#include <nvbio/basic/console.h>
+#include <nvbio/basic/profiling.h>
+#include <nvbio/strings/alphabet.h>
+#include <zlib/zlib.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+namespace nvbio {
+namespace io {
+
+namespace { // anonymous namespace
+
+// name token opcodes
+enum NVRTokenOp
+{
+    NVR_TOKEN_END     = 0,  // end of name
+    NVR_TOKEN_MATCH   = 1,  // same token as in the previous name
+    NVR_TOKEN_DELTA   = 2,  // numeric token, followed by a 1-byte increment over the previous one
+    NVR_TOKEN_LITERAL = 3,  // literal token, followed by a null-terminated string
+};
+
+inline uint64 align8(const uint64 x) { return (x + 7u) & ~uint64(7u); }
+
+inline bool is_digit(const char c) { return c >= '0' && c <= '9'; }
+
+inline bool is_separator(const char c)
+{
+    return c == ':' || c == '_' || c == '/' || c == ' ' || c == '.' || c == '-' || c == '#' || c == '|';
+}
+
+// split a name in runs of digits, runs of other characters and single separators
+//
+void tokenise(const char* name, std::vector<std::string>& tokens)
+{
+    tokens.clear();
+    for (const char* p = name; *p != '\0';)
+    {
+        const char* begin = p;
+        if (is_separator( *p ))
+            ++p;
+        else if (is_digit( *p ))
+        {
+            while (is_digit( *p ))
+                ++p;
+        }
+        else
+        {
+            while (*p != '\0' && is_digit( *p ) == false && is_separator( *p ) == false)
+                ++p;
+        }
+        tokens.push_back( std::string( begin, p ) );
+    }
+}
+
+// parse a numeric token which can be re-printed verbatim, i.e. without leading zeros
+//
+bool parse_number(const std::string& token, uint64* value)
+{
+    if (token.empty() || token.size() > 18u || is_digit( token[0] ) == false)
+        return false;
+    if (token[0] == '0' && token.size() > 1u)
+        return false;
+
+    uint64 r = 0;
+    for (uint32 i = 0; i < token.size(); ++i)
+    {
+        if (is_digit( token[i] ) == false)
+            return false;
+        r = r*10u + uint64( token[i] - '0' );
+    }
+    *value = r;
+    return true;
+}
+
+// encode a tokenised name against the tokens of the previous name
+//
+void encode_name(
+    const std::vector<std::string>& prev,
+    const std::vector<std::string>& tokens,
+    std::vector<char>&              out)
+{
+    for (uint32 i = 0; i < tokens.size(); ++i)
+    {
+        const std::string& token = tokens[i];
+
+        if (i < prev.size())
+        {
+            if (token == prev[i])
+            {
+                out.push_back( char(NVR_TOKEN_MATCH) );
+                continue;
+            }
+
+            uint64 value, prev_value;
+            if (parse_number( token, &value ) &&
+                parse_number( prev[i], &prev_value ) &&
+                value > prev_value &&
+                value - prev_value < 256u)
+            {
+                out.push_back( char(NVR_TOKEN_DELTA) );
+                out.push_back( char(value - prev_value) );
+                continue;
+            }
+        }
+        out.push_back( char(NVR_TOKEN_LITERAL) );
+        out.insert( out.end(), token.begin(), token.end() );
+        out.push_back( '\0' );
+    }
+    out.push_back( char(NVR_TOKEN_END) );
+}
+
+// decode the tokenised names of a block
+//
+bool decode_names(
+    const char*         in,
+    const char*         in_end,
+    const uint32        n_seqs,
+    NVRNameStorage*     names)
+{
+    names->m_name_vec.clear();
+    names->m_name_index_vec.resize( n_seqs + 1u );
+    names->m_name_index_vec[0] = 0u;
+
+    std::vector<std::string> prev;
+    std::vector<std::string> tokens;
+
+    for (uint32 i = 0; i < n_seqs; ++i)
+    {
+        tokens.clear();
+        while (1)
+        {
+            if (in >= in_end)
+                return false;
+
+            const uint8 op = uint8( *in++ );
+            if (op == NVR_TOKEN_END)
+                break;
+
+            const uint32 t = uint32( tokens.size() );
+            if (op == NVR_TOKEN_MATCH)
+            {
+                if (t >= prev.size())
+                    return false;
+
+                tokens.push_back( prev[t] );
+            }
+            else if (op == NVR_TOKEN_DELTA)
+            {
+                uint64 prev_value;
+                if (in >= in_end || t >= prev.size() || parse_number( prev[t], &prev_value ) == false)
+                    return false;
+
+                char buffer[32];
+                sprintf( buffer, "%llu", (unsigned long long)(prev_value + uint8( *in++ )) );
+                tokens.push_back( std::string( buffer ) );
+            }
+            else if (op == NVR_TOKEN_LITERAL)
+            {
+                const char* end = (const char*)memchr( in, '\0', in_end - in );
+                if (end == NULL)
+                    return false;
+
+                tokens.push_back( std::string( in, end ) );
+                in = end + 1;
+            }
+            else
+                return false;
+        }
+
+        for (uint32 t = 0; t < tokens.size(); ++t)
+            names->m_name_vec.insert( names->m_name_vec.end(), tokens[t].begin(), tokens[t].end() );
+        names->m_name_vec.push_back( '\0' );
+        names->m_name_index_vec[i+1] = uint32( names->m_name_vec.size() );
+
+        prev.swap( tokens );
+    }
+    return true;
+}
+
+// bin a phred quality to the 8 Illumina levels
+//
+inline char bin_quality(const char q)
+{
+    const uint8 p = uint8(q);
+    return char(
+        p <  2 ? p  :
+        p < 10 ? 6  :
+        p < 20 ? 15 :
+        p < 25 ? 22 :
+        p < 30 ? 27 :
+        p < 35 ? 33 :
+        p < 40 ? 37 :
+                 40 );
+}
+
+} // anonymous namespace
+
+// compute the section offsets of a block payload
+//
+NVRBlockLayout::NVRBlockLayout(const NVRBlockHeader& block, const uint32 flags)
+{
+    uint64 offset = 0;
+
+    sequence_index = offset; offset += align8( sizeof(uint32) * (block.n_seqs + 1u) );
+    sequence       = offset; offset += align8( sizeof(uint32) * block.n_words );
+    quals          = offset; offset += (flags & NVR_QUALITIES)       ? align8( block.n_bps ) : 0u;
+    name_index     = offset; offset += (flags & NVR_TOKENISED_NAMES) ? 0u : align8( sizeof(uint32) * (block.n_seqs + 1u) );
+    names          = offset; offset += align8( block.name_bytes );
+    size           = offset;
+}
+
+// check whether the file name points to an .nvr container
+//
+bool is_nvr_file(const char* sequence_file_name)
+{
+    const uint32 len = uint32( strlen( sequence_file_name ) );
+    return len >= strlen(".nvr") &&
+        strcmp( &sequence_file_name[len - strlen(".nvr")], ".nvr" ) == 0;
+}
+
+// map a file and validate its header and block index
+//
+bool SequenceDataNVR::load(const char* file_name)
+{
+    const uint8* data = (const uint8*)m_file.init( file_name );
+    if (data == NULL)
+    {
+        log_error(stderr, "unable to map \"%s\"\n", file_name);
+        return false;
+    }
+
+    const uint64 file_size = m_file.size();
+    if (file_size < sizeof(NVRFileHeader))
+    {
+        log_error(stderr, "\"%s\" is not an NVR file\n", file_name);
+        return false;
+    }
+
+    const NVRFileHeader* header = (const NVRFileHeader*)data;
+    if (header->magic != NVR_MAGIC)
+    {
+        log_error(stderr, "\"%s\" is not an NVR file\n", file_name);
+        return false;
+    }
+    if (header->version != NVR_VERSION)
+    {
+        log_error(stderr, "\"%s\": unsupported NVR version %u\n", file_name, header->version);
+        return false;
+    }
+    if (header->index_offset < sizeof(NVRFileHeader) ||
+        header->index_offset + uint64( header->n_blocks ) * sizeof(NVRIndexEntry) > file_size)
+    {
+        log_error(stderr, "\"%s\": truncated NVR file\n", file_name);
+        return false;
+    }
+
+    const NVRIndexEntry* index = (const NVRIndexEntry*)(data + header->index_offset);
+
+    // make sure all blocks are in range
+    for (uint32 b = 0; b < header->n_blocks; ++b)
+    {
+        if (index[b].offset + sizeof(NVRBlockHeader) > header->index_offset)
+        {
+            log_error(stderr, "\"%s\": corrupted NVR block index\n", file_name);
+            return false;
+        }
+
+        const NVRBlockHeader* block = (const NVRBlockHeader*)(data + index[b].offset);
+        const NVRBlockLayout  layout( *block, header->flags );
+
+        if (layout.size != block->payload_size ||
+            index[b].offset + sizeof(NVRBlockHeader) + block->payload_size > header->index_offset)
+        {
+            log_error(stderr, "\"%s\": corrupted NVR block %u\n", file_name, b);
+            return false;
+        }
+    }
+
+    m_header = header;
+    m_index  = index;
+    return true;
+}
+
+// return the block containing a given read
+//
+uint32 SequenceDataNVR::find_block(const uint64 read_id) const
+{
+    uint32 lo = 0;
+    uint32 hi = blocks();
+    while (hi - lo > 1u)
+    {
+        const uint32 mid = (lo + hi) / 2u;
+        if (m_index[mid].first_seq <= read_id)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+const NVRBlockHeader* SequenceDataNVR::block_header(const uint32 b) const
+{
+    return (const NVRBlockHeader*)((const uint8*)m_file.data() + m_index[b].offset);
+}
+
+// verify the checksum of a block
+//
+bool SequenceDataNVR::check(const uint32 b) const
+{
+    const NVRBlockHeader* block   = block_header(b);
+    const uint8*          payload = (const uint8*)(block + 1);
+
+    return uint32( crc32( 0u, payload, uInt( block->payload_size ) ) ) == block->crc;
+}
+
+// return a zero-copy view of a block
+//
+ConstSequenceDataView SequenceDataNVR::block(const uint32 b, NVRNameStorage* names) const
+{
+    const NVRBlockHeader* block   = block_header(b);
+    const NVRBlockLayout  layout( *block, m_header->flags );
+    const uint8*          payload = (const uint8*)(block + 1);
+
+    SequenceDataInfo info;
+    info.m_alphabet              = alphabet();
+    info.m_n_seqs                = block->n_seqs;
+    info.m_name_stream_len       = block->name_stream_len;
+    info.m_sequence_stream_len   = block->n_bps;
+    info.m_sequence_stream_words = block->n_words;
+    info.m_has_qualities         = (m_header->flags & NVR_QUALITIES) ? 1u : 0u;
+    info.m_min_sequence_len      = block->min_sequence_len;
+    info.m_max_sequence_len      = block->max_sequence_len;
+    info.m_avg_sequence_len      = block->n_seqs ? uint32( util::divide_ri( block->n_bps, block->n_seqs ) ) : 0u;
+
+    const char*   name_stream = (const char*)(payload + layout.names);
+    const uint32* name_index  = (const uint32*)(payload + layout.name_index);
+
+    if (m_header->flags & NVR_TOKENISED_NAMES)
+    {
+        if (names && decode_names( name_stream, name_stream + block->name_bytes, block->n_seqs, names ))
+        {
+            name_stream = &names->m_name_vec[0];
+            name_index  = &names->m_name_index_vec[0];
+        }
+        else
+        {
+            if (names)
+                log_warning(stderr, "failed decoding the names of NVR block %u\n", b);
+
+            name_stream = NULL;
+            name_index  = NULL;
+            info.m_name_stream_len = 0;
+        }
+    }
+
+    return ConstSequenceDataView(
+        info,
+        (const uint32*)(payload + layout.sequence),
+        (const uint32*)(payload + layout.sequence_index),
+        (m_header->flags & NVR_QUALITIES) ? (const char*)(payload + layout.quals) : (const char*)NULL,
+        name_stream,
+        name_index );
+}
+
+// constructor
+//
+SequenceDataFile_NVR::SequenceDataFile_NVR(
+    const char*     read_file_name,
+    const Options&  options)
+  : SequenceDataFile( options ),
+    m_block( 0 ),
+    m_read( 0 )
+{
+    m_file_state = m_nvr.load( read_file_name ) ? FILE_OK : FILE_OPEN_FAILED;
+}
+
+// rewind the file
+//
+bool SequenceDataFile_NVR::rewind()
+{
+    if (m_file_state != FILE_OK && m_file_state != FILE_EOF)
+        return false;
+
+    m_view       = ConstSequenceDataView();
+    m_block      = 0;
+    m_read       = 0;
+    m_file_state = FILE_OK;
+    return true;
+}
+
+// get next read chunk from file
+//
+int SequenceDataFile_NVR::nextChunk(SequenceDataEncoder* output, uint32 max_reads, uint32 max_bps)
+{
+    NVBIO_PROFILE_REGION( "io/nvr-parse" );
+
+    switch (m_nvr.alphabet())
+    {
+    case DNA:       return next_reads<DNA>( output, max_reads, max_bps );
+    case DNA_N:     return next_reads<DNA_N>( output, max_reads, max_bps );
+    case DNA_IUPAC: return next_reads<DNA_IUPAC>( output, max_reads, max_bps );
+    case PROTEIN:   return next_reads<PROTEIN>( output, max_reads, max_bps );
+    case RNA:       return next_reads<RNA>( output, max_reads, max_bps );
+    case RNA_N:     return next_reads<RNA_N>( output, max_reads, max_bps );
+    case ASCII:     return next_reads<ASCII>( output, max_reads, max_bps );
+    default:        break;
+    }
+    log_error(stderr, "unsupported NVR alphabet %u\n", uint32( m_nvr.alphabet() ));
+    m_file_state = FILE_PARSE_ERROR;
+    return 0;
+}
+
+template <Alphabet ALPHABET>
+int SequenceDataFile_NVR::next_reads(SequenceDataEncoder* output, uint32 max_reads, uint32 max_bps)
+{
+    typedef SequenceDataAccess<ALPHABET,ConstSequenceDataView> access_type;
+
+    const uint32 read_mult =
+        ((m_options.flags & FORWARD)            ? 1u : 0u) +
+        ((m_options.flags & REVERSE)            ? 1u : 0u) +
+        ((m_options.flags & FORWARD_COMPLEMENT) ? 1u : 0u) +
+        ((m_options.flags & REVERSE_COMPLEMENT) ? 1u : 0u);
+
+    const uint32 strand_flags[4] = { FORWARD, REVERSE, FORWARD_COMPLEMENT, REVERSE_COMPLEMENT };
+    const SequenceDataEncoder::StrandOp strand_ops[4] = {
+        SequenceDataEncoder::NO_OP,
+        SequenceDataEncoder::REVERSE_OP,
+        SequenceDataEncoder::COMPLEMENT_OP,
+        SequenceDataEncoder::REVERSE_COMPLEMENT_OP };
+
+    const uint8 best_quality = 93u;
+
+    uint32 n_reads = 0;
+    uint32 n_bps   = 0;
+
+    while (n_reads + read_mult                             <= max_reads &&
+           n_bps   + read_mult*SequenceDataFile::LONG_READ <= max_bps)
+    {
+        // move to the next block
+        if (m_read >= m_view.size())
+        {
+            if (m_block >= m_nvr.blocks())
+            {
+                m_file_state = FILE_EOF;
+                break;
+            }
+            if (m_nvr.check( m_block ) == false)
+            {
+                log_error(stderr, "checksum mismatch in NVR block %u\n", m_block);
+                m_file_state = FILE_STREAM_ERROR;
+                break;
+            }
+            m_view = m_nvr.block( m_block++, &m_names );
+            m_read = 0;
+            continue;
+        }
+
+        const access_type access( m_view );
+
+        const typename access_type::sequence_string read = access.get_read( m_read );
+        const uint32 read_len = read.length();
+
+        if (m_read_bp.size() < read_len + 1u)
+        {
+            m_read_bp.resize( read_len + 1u );
+            m_read_q.resize( read_len + 1u );
+        }
+
+        to_string<ALPHABET>( read.begin(), read_len, (char*)&m_read_bp[0] );
+
+        if (m_view.has_qualities())
+        {
+            const typename access_type::qual_string qual = access.get_quals( m_read );
+            for (uint32 i = 0; i < read_len; ++i)
+                m_read_q[i] = uint8( qual[i] );
+        }
+        else
+            std::fill( m_read_q.begin(), m_read_q.begin() + read_len, best_quality );
+
+        const char* name = m_view.name_stream() ?
+            m_view.name_stream() + m_view.name_index()[ m_read ] : "";
+
+        ++m_read;
+
+        if (read_len == 0)
+            continue;
+
+        // the stored qualities are already in the Phred scale
+        for (uint32 s = 0; s < 4; ++s)
+        {
+            if (m_options.flags & strand_flags[s])
+            {
+                output->push_back(
+                                read_len,
+                                name,
+                                &m_read_bp[0],
+                                &m_read_q[0],
+                                Phred,
+                                m_options.max_sequence_len,
+                                m_options.trim3,
+                                m_options.trim5,
+                                strand_ops[s] );
+            }
+        }
+
+        n_bps   += read_mult * read_len;
+        n_reads += read_mult;
+    }
+    return n_reads;
+}
+
+// constructor
+//
+SequenceDataOutputFile_NVR::SequenceDataOutputFile_NVR(
+    const char* file_name,
+    const char* options)
+  : m_file_name( file_name ),
+    m_ok( true ),
+    m_offset( sizeof(NVRFileHeader) )
+{
+    memset( &m_header, 0, sizeof(NVRFileHeader) );
+    memset( &m_block,  0, sizeof(NVRBlockHeader) );
+    m_header.magic            = NVR_MAGIC;
+    m_header.version          = NVR_VERSION;
+    m_header.alphabet         = uint32(-1);
+    m_header.flags            = NVR_QUALITIES;
+    m_header.reads_per_block  = DEFAULT_READS_PER_BLOCK;
+    m_header.min_sequence_len = uint32(-1);
+
+    // parse the options
+    if (options)
+    {
+        if (strstr( options, "noqual" )) m_header.flags &= ~NVR_QUALITIES;
+        if (strstr( options, "binned" )) m_header.flags |= NVR_BINNED_QUALITIES;
+        if (strstr( options, "tokens" )) m_header.flags |= NVR_TOKENISED_NAMES;
+
+        const char* block = strstr( options, "block=" );
+        if (block)
+            m_header.reads_per_block = nvbio::max( uint32( atoi( block + strlen("block=") ) ), 1u );
+    }
+    if ((m_header.flags & NVR_QUALITIES) == 0)
+        m_header.flags &= ~NVR_BINNED_QUALITIES;
+
+    m_file = fopen( file_name, "wb" );
+    if (m_file == NULL)
+    {
+        log_error(stderr, "unable to open \"%s\" for writing\n", file_name);
+        m_ok = false;
+        return;
+    }
+
+    // write a placeholder header, to be rewritten at the end
+    if (fwrite( &m_header, sizeof(NVRFileHeader), 1u, m_file ) != 1u)
+        m_ok = false;
+}
+
+// destructor
+//
+SequenceDataOutputFile_NVR::~SequenceDataOutputFile_NVR()
+{
+    if (m_file == NULL)
+        return;
+
+    flush_block();
+
+    if (m_header.alphabet == uint32(-1))
+        m_header.alphabet = uint32( DNA );
+
+    // write the block index
+    m_header.index_offset = m_offset;
+    m_header.n_blocks     = uint32( m_index.size() );
+    if (m_index.size() &&
+        fwrite( &m_index[0], sizeof(NVRIndexEntry), m_index.size(), m_file ) != m_index.size())
+        m_ok = false;
+
+    // and rewrite the header
+    if (fseek( m_file, 0, SEEK_SET ) != 0 ||
+        fwrite( &m_header, sizeof(NVRFileHeader), 1u, m_file ) != 1u)
+        m_ok = false;
+
+    if (m_ok == false)
+        log_error(stderr, "failed writing \"%s\"\n", m_file_name);
+
+    fclose( m_file );
+}
+
+// next batch
+//
+void SequenceDataOutputFile_NVR::next(const SequenceDataHost& sequence_data)
+{
+    if (m_ok == false || sequence_data.size() == 0)
+        return;
+
+    if (m_header.alphabet == uint32(-1))
+    {
+        m_header.alphabet = uint32( sequence_data.alphabet() );
+        if (sequence_data.has_qualities() == false)
+            m_header.flags &= ~(NVR_QUALITIES | NVR_BINNED_QUALITIES);
+    }
+    else if (m_header.alphabet != uint32( sequence_data.alphabet() ))
+    {
+        log_error(stderr, "\"%s\": all batches of an NVR file must share the same alphabet\n", m_file_name);
+        m_ok = false;
+        return;
+    }
+
+    switch (sequence_data.alphabet())
+    {
+    case DNA:       append<DNA>( sequence_data );       break;
+    case DNA_N:     append<DNA_N>( sequence_data );     break;
+    case DNA_IUPAC: append<DNA_IUPAC>( sequence_data ); break;
+    case PROTEIN:   append<PROTEIN>( sequence_data );   break;
+    case RNA:       append<RNA>( sequence_data );       break;
+    case RNA_N:     append<RNA_N>( sequence_data );     break;
+    case ASCII:     append<ASCII>( sequence_data );     break;
+    default:
+        log_error(stderr, "\"%s\": unsupported alphabet\n", m_file_name);
+        m_ok = false;
+    }
+}
+
+// append a batch to the current block, flushing full blocks as they fill up
+//
+template <Alphabet ALPHABET>
+void SequenceDataOutputFile_NVR::append(const SequenceDataHost& sequence_data)
+{
+    typedef SequenceDataAccess<ALPHABET,ConstSequenceDataView>  access_type;
+    typedef typename access_type::sequence_string               sequence_string;
+    typedef typename access_type::qual_string                   qual_string;
+
+    typedef SequenceDataTraits<ALPHABET> sequence_traits;
+    typedef PackedStream<
+        uint32*,uint8,
+        sequence_traits::SEQUENCE_BITS,
+        sequence_traits::SEQUENCE_BIG_ENDIAN>   output_stream_type;
+
+    const ConstSequenceDataView view( sequence_data );
+    const access_type           access( view );
+
+    const bool has_quals = (m_header.flags & NVR_QUALITIES) != 0;
+    const bool binned    = (m_header.flags & NVR_BINNED_QUALITIES) != 0;
+    const bool tokens    = (m_header.flags & NVR_TOKENISED_NAMES) != 0;
+
+    for (uint32 i = 0; i < access.size(); ++i)
+    {
+        if (m_block.n_seqs == 0)
+        {
+            // start a new block
+            m_sequence_index.assign( 1u, 0u );
+            m_name_index.assign( 1u, 0u );
+            m_sequence.clear();
+            m_quals.clear();
+            m_names.clear();
+            m_prev_tokens.clear();
+            m_block.min_sequence_len = uint32(-1);
+            m_block.max_sequence_len = 0u;
+        }
+
+        const sequence_string read     = access.get_read(i);
+        const uint32          read_len = read.length();
+
+        // repack the read at the end of the block
+        const uint32 n_words = uint32( util::divide_ri( m_block.n_bps + read_len, sequence_traits::SEQUENCE_SYMBOLS_PER_WORD ) );
+        if (m_sequence.size() < n_words)
+            m_sequence.resize( n_words, 0u );
+
+        if (read_len)
+        {
+            output_stream_type out( &m_sequence[0] );
+            for (uint32 j = 0; j < read_len; ++j)
+                out[ m_block.n_bps + j ] = read[j];
+        }
+
+        if (has_quals)
+        {
+            const qual_string qual = access.get_quals(i);
+            for (uint32 j = 0; j < read_len; ++j)
+                m_quals.push_back( binned ? bin_quality( qual[j] ) : qual[j] );
+        }
+
+        // store the name
+        const char* name = view.name_stream() + view.name_index()[i];
+        if (tokens)
+        {
+            tokenise( name, m_tokens );
+            encode_name( m_prev_tokens, m_tokens, m_names );
+            m_prev_tokens.swap( m_tokens );
+
+            m_block.name_stream_len += uint32( strlen( name ) ) + 1u;
+        }
+        else
+        {
+            m_names.insert( m_names.end(), name, name + strlen( name ) + 1u );
+            m_name_index.push_back( uint32( m_names.size() ) );
+
+            m_block.name_stream_len = uint32( m_names.size() );
+        }
+
+        m_block.n_seqs++;
+        m_block.n_bps  += read_len;
+        m_block.n_words = n_words;
+        m_block.min_sequence_len = nvbio::min( m_block.min_sequence_len, read_len );
+        m_block.max_sequence_len = nvbio::max( m_block.max_sequence_len, read_len );
+        m_sequence_index.push_back( m_block.n_bps );
+
+        if (m_block.n_seqs == m_header.reads_per_block)
+            flush_block();
+    }
+}
+
+// write out the current block
+//
+void SequenceDataOutputFile_NVR::flush_block()
+{
+    if (m_block.n_seqs == 0 || m_ok == false)
+        return;
+
+    NVBIO_PROFILE_REGION( "io/nvr-write" );
+
+    m_block.name_bytes = uint32( m_names.size() );
+
+    const NVRBlockLayout layout( m_block, m_header.flags );
+    m_block.payload_size = layout.size;
+
+    // assemble the payload
+    m_payload.resize( layout.size );
+    std::fill( m_payload.begin(), m_payload.end(), uint8(0) );
+
+    memcpy( &m_payload[ layout.sequence_index ], &m_sequence_index[0], sizeof(uint32) * m_sequence_index.size() );
+    if (m_sequence.size())
+        memcpy( &m_payload[ layout.sequence ], &m_sequence[0], sizeof(uint32) * m_block.n_words );
+    if ((m_header.flags & NVR_QUALITIES) && m_quals.size())
+        memcpy( &m_payload[ layout.quals ], &m_quals[0], m_quals.size() );
+    if ((m_header.flags & NVR_TOKENISED_NAMES) == 0)
+        memcpy( &m_payload[ layout.name_index ], &m_name_index[0], sizeof(uint32) * m_name_index.size() );
+    if (m_names.size())
+        memcpy( &m_payload[ layout.names ], &m_names[0], m_names.size() );
+
+    m_block.crc = uint32( crc32( 0u, &m_payload[0], uInt( layout.size ) ) );
+
+    if (fwrite( &m_block, sizeof(NVRBlockHeader), 1u, m_file ) != 1u ||
+        fwrite( &m_payload[0], 1u, layout.size, m_file ) != layout.size)
+    {
+        m_ok = false;
+        return;
+    }
+
+    // record the block in the index
+    NVRIndexEntry entry;
+    entry.offset    = m_offset;
+    entry.first_seq = m_header.n_seqs;
+    m_index.push_back( entry );
+
+    // update the file statistics
+    m_header.n_seqs += m_block.n_seqs;
+    m_header.n_bps  += m_block.n_bps;
+    m_header.min_sequence_len = nvbio::min( m_header.min_sequence_len, m_block.min_sequence_len );
+    m_header.max_sequence_len = nvbio::max( m_header.max_sequence_len, m_block.max_sequence_len );
+
+    m_offset += sizeof(NVRBlockHeader) + layout.size;
+
+    memset( &m_block, 0, sizeof(NVRBlockHeader) );
+}
+
+// return whether the stream is ok
+//
+bool SequenceDataOutputFile_NVR::is_ok() { return m_file && m_ok; }
+
+} // namespace io
+} // namespace nvbio
@@ -0,0 +1,327 @@
+/*
+ * nvbio
+ * Copyright (c) 2011-2014, NVIDIA CORPORATION. All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *    * Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *    * Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *    * Neither the name of the NVIDIA CORPORATION nor the
+ *      names of its contributors may be used to endorse or promote products
+ *      derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NVIDIA CORPORATION BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <nvbio/io/sequence/sequence.h>
+#include <nvbio/io/sequence/sequence_priv.h>
+#include <nvbio/basic/mmap.h>
+#include <stdio.h>
+#include <vector>
+#include <string>
+
+namespace nvbio {
+namespace io {
+
+///@addtogroup IO
+///@{
+
+///@addtogroup SequenceIO
+///@{
+
+///
+/// \page nvr_format_page The NVR read container
+///
+/// An .nvr file is a compact, random-access binary container for read collections,
+/// laid out so that each of its blocks can be memory mapped and consumed as a
+/// ConstSequenceDataView without any parsing or copies:
+///
+///\verbatim
+/// NVRFileHeader
+/// block[0]:  NVRBlockHeader | sequence_index | sequence words | qualities | name_index | names
+/// block[1]:  ...
+/// NVRIndexEntry[n_blocks]
+///\endverbatim
+///
+/// - every block holds a fixed number of reads (except for the last one), stored
+///   with the native packing of the file's alphabet (i.e. 2 bits per base for DNA,
+///   4 bits per base for DNA_N) and with block-relative sequence and name indices;
+/// - all sections are 8-byte aligned, and each block payload is protected by a crc32;
+/// - the trailing block index allows to seek to the block containing any given read;
+/// - qualities can be optionally dropped or binned to the 8 Illumina levels;
+/// - names can be optionally tokenised, i.e. delta-encoded against the previous name
+///   in the same block: in this case they are the only section which needs decoding.
+///
+/// .nvr files are written by open_output_sequence_file() (e.g. through nvExtractReads),
+/// and can be read either as a regular stream with open_sequence_file(), or mapped
+/// directly through SequenceDataNVR.
+///
+
+static const uint32 NVR_MAGIC   = 0x3152564Eu;     ///< "NVR1"
+static const uint32 NVR_VERSION = 1u;
+
+/// NVR file flags
+///
+enum NVRFlags
+{
+    NVR_QUALITIES        = 0x0001,   ///< qualities are stored
+    NVR_BINNED_QUALITIES = 0x0002,   ///< qualities have been binned
+    NVR_TOKENISED_NAMES  = 0x0004,   ///< names are tokenised
+};
+
+/// NVR file header
+///
+struct NVRFileHeader
+{
+    uint32 magic;               ///< NVR_MAGIC
+    uint32 version;             ///< NVR_VERSION
+    uint32 alphabet;            ///< the sequence alphabet
+    uint32 flags;               ///< a combination of NVRFlags
+    uint32 reads_per_block;     ///< the number of reads per block
+    uint32 n_blocks;            ///< the number of blocks
+    uint64 n_seqs;              ///< the total number of reads
+    uint64 n_bps;               ///< the total number of bases
+    uint64 index_offset;        ///< the file offset of the block index
+    uint32 max_sequence_len;    ///< the maximum read length
+    uint32 min_sequence_len;    ///< the minimum read length
+    uint64 reserved;
+};
+
+/// NVR block header
+///
+struct NVRBlockHeader
+{
+    uint32 n_seqs;              ///< the number of reads in the block
+    uint32 n_bps;               ///< the number of bases in the block
+    uint32 n_words;             ///< the number of sequence words
+    uint32 name_stream_len;     ///< the length of the decoded name stream
+    uint32 name_bytes;          ///< the number of stored name bytes
+    uint32 min_sequence_len;    ///< the minimum read length
+    uint32 max_sequence_len;    ///< the maximum read length
+    uint32 crc;                 ///< the crc32 of the block payload
+    uint64 payload_size;        ///< the size of the block payload, in bytes
+};
+
+/// NVR block index entry
+///
+struct NVRIndexEntry
+{
+    uint64 offset;              ///< the file offset of the block header
+    uint64 first_seq;           ///< the global index of the first read in the block
+};
+
+/// the section offsets of an NVR block payload, relative to the payload itself
+///
+struct NVRBlockLayout
+{
+    NVRBlockLayout() {}
+    NVRBlockLayout(const NVRBlockHeader& block, const uint32 flags);
+
+    uint64 sequence_index;      ///< the offset of the sequence index
+    uint64 sequence;            ///< the offset of the sequence words
+    uint64 quals;               ///< the offset of the qualities
+    uint64 name_index;          ///< the offset of the name index
+    uint64 names;               ///< the offset of the names
+    uint64 size;                ///< the total payload size
+};
+
+/// decoding storage for tokenised names
+///
+struct NVRNameStorage
+{
+    std::vector<char>   m_name_vec;         ///< the decoded names
+    std::vector<uint32> m_name_index_vec;   ///< the decoded name index
+};
+
+///
+/// A memory mapped .nvr read container.
+/// Blocks are exposed as zero-copy ConstSequenceDataView's: only tokenised names, if
+/// present, need to be decoded in a user-provided NVRNameStorage.
+///
+///\code
+/// io::SequenceDataNVR reads;
+/// if (reads.load( "reads.nvr" ))
+/// {
+///     io::NVRNameStorage names;
+///     for (uint32 b = 0; b < reads.blocks(); ++b)
+///     {
+///         const io::ConstSequenceDataView view = reads.block( b, &names );
+///         const io::SequenceDataAccess<DNA,io::ConstSequenceDataView> access( view );
+///         do_something( access.sequence_string_set() );
+///     }
+/// }
+///\endcode
+///
+struct SequenceDataNVR
+{
+    /// constructor
+    ///
+    SequenceDataNVR() : m_header( NULL ), m_index( NULL ) {}
+
+    /// map a file and validate its header and block index
+    ///
+    bool load(const char* file_name);
+
+    /// return the file header
+    ///
+    const NVRFileHeader& header() const { return *m_header; }
+
+    /// return the alphabet
+    ///
+    Alphabet alphabet() const { return Alphabet( m_header->alphabet ); }
+
+    /// return the number of blocks
+    ///
+    uint32 blocks() const { return m_header->n_blocks; }
+
+    /// return the total number of reads
+    ///
+    uint64 size() const { return m_header->n_seqs; }
+
+    /// return the total number of bases
+    ///
+    uint64 bps() const { return m_header->n_bps; }
+
+    /// return the global index of the first read in a block
+    ///
+    uint64 first_seq(const uint32 b) const { return m_index[b].first_seq; }
+
+    /// return the block containing a given read
+    ///
+    uint32 find_block(const uint64 read_id) const;
+
+    /// verify the checksum of a block
+    ///
+    bool check(const uint32 b) const;
+
+    /// return a zero-copy view of a block; if the names are tokenised, they are decoded
+    /// in the given storage, or omitted if this is NULL
+    ///
+    ConstSequenceDataView block(const uint32 b, NVRNameStorage* names = NULL) const;
+
+private:
+    const NVRBlockHeader* block_header(const uint32 b) const;
+
+    MappedDiskFile          m_file;
+    const NVRFileHeader*    m_header;
+    const NVRIndexEntry*    m_index;
+
+    SequenceDataNVR(const SequenceDataNVR&);
+    SequenceDataNVR& operator=(const SequenceDataNVR&);
+};
+
+///@addtogroup SequenceIODetail
+///@{
+
+/// check whether the file name points to an .nvr container
+///
+bool is_nvr_file(const char* sequence_file_name);
+
+/// SequenceDataFile from an .nvr container
+///
+struct SequenceDataFile_NVR : public SequenceDataFile
+{
+    /// constructor
+    ///
+    SequenceDataFile_NVR(
+        const char*     read_file_name,
+        const Options&  options);
+
+    /// rewind the file
+    ///
+    virtual bool rewind();
+
+protected:
+    // get next read chunk from file and parse it (up to max reads)
+    // this can cause m_file_state to change
+    virtual int nextChunk(struct SequenceDataEncoder* output, uint32 max_reads, uint32 max_bps);
+
+private:
+    template <Alphabet ALPHABET>
+    int next_reads(struct SequenceDataEncoder* output, uint32 max_reads, uint32 max_bps);
+
+    SequenceDataNVR         m_nvr;
+    NVRNameStorage          m_names;
+    ConstSequenceDataView   m_view;
+    uint32                  m_block;        // the current block
+    uint32                  m_read;         // the next read in the current block
+
+    // temp buffers for the decoded base pairs and qualities
+    std::vector<uint8> m_read_bp;
+    std::vector<uint8> m_read_q;
+};
+
+/// SequenceDataOutputStream writing an .nvr container.
+/// The options string can contain a comma separated list of:
+///   - "noqual"        : drop qualities
+///   - "binned"        : bin qualities to the 8 Illumina levels
+///   - "tokens"        : tokenise names
+///   - "block=N"       : store N reads per block (default: 64K)
+///
+struct SequenceDataOutputFile_NVR : SequenceDataOutputStream
+{
+    static const uint32 DEFAULT_READS_PER_BLOCK = 64*1024;
+
+    /// constructor
+    ///
+    SequenceDataOutputFile_NVR(
+        const char* file_name,
+        const char* options);
+
+    /// destructor: flush the last block and write the block index
+    ///
+    ~SequenceDataOutputFile_NVR();
+
+    /// next batch
+    ///
+    void next(const SequenceDataHost& sequence_data);
+
+    /// return whether the stream is ok
+    ///
+    bool is_ok();
+
+private:
+    template <Alphabet ALPHABET>
+    void append(const SequenceDataHost& sequence_data);
+
+    void flush_block();
+
+    const char*                 m_file_name;
+    FILE*                       m_file;
+    bool                        m_ok;
+    NVRFileHeader               m_header;
+    std::vector<NVRIndexEntry>  m_index;
+    uint64                      m_offset;
+
+    // the block being assembled
+    NVRBlockHeader              m_block;
+    std::vector<uint32>         m_sequence_index;
+    std::vector<uint32>         m_sequence;
+    std::vector<char>           m_quals;
+    std::vector<uint32>         m_name_index;
+    std::vector<char>           m_names;
+    std::vector<std::string>    m_prev_tokens;
+    std::vector<std::string>    m_tokens;
+    std::vector<uint8>          m_payload;
+};
+
+///@} // SequenceIODetail
+///@} // SequenceIO
+///@} // IO
+
+} // namespace io
+} // namespace nvbio
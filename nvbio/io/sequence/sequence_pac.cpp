@@ -27,8 +27,11 @@
 
 #include <nvbio/io/sequence/sequence.h>
 #include <nvbio/io/sequence/sequence_mmap.h>
+#include <nvbio/io/sequence/sequence_pac.h>
 #include <nvbio/basic/bnt.h>
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/packedstream_transcode.h>
+#include <nvbio/basic/omp.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -58,6 +61,64 @@ uint64 block_fread(T* dst, const uint64 n, FILE* file)
 #endif
 }
 
+// convert a 2-bit DNA .pac symbol to a given alphabet: the DNA and RNA alphabets, with or
+// without N, share the codes of A,C,G,T/U, while all others go through the ASCII representation
+//
+template <Alphabet ALPHABET>
+struct pac_converter
+{
+    static const bool IDENTITY = (ALPHABET == DNA || ALPHABET == DNA_N || ALPHABET == RNA || ALPHABET == RNA_N);
+
+    uint8 operator() (const uint8 c) const { return IDENTITY ? c : from_char<ALPHABET>( dna_to_char( c ) ); }
+};
+
+// copy a 2-bit big-endian DNA pac stream into an output stream of a given alphabet,
+// converting whole words at a time when the symbols need no conversion
+//
+template <Alphabet ALPHABET, uint32 SYMBOL_SIZE = SequenceDataTraits<ALPHABET>::SEQUENCE_BITS, bool IDENTITY = pac_converter<ALPHABET>::IDENTITY>
+struct pac_copier
+{
+    template <typename pac_stream_type, typename output_stream_type>
+    static void copy(const uint32 seq_length, const pac_stream_type pac, output_stream_type out)
+    {
+        const pac_converter<ALPHABET> converter;
+        for (uint32 i = 0; i < seq_length; ++i)
+            out[i] = converter( pac[i] );
+    }
+};
+template <Alphabet ALPHABET>
+struct pac_copier<ALPHABET,2u,true>
+{
+    template <typename pac_stream_type, typename output_stream_type>
+    static void copy(const uint32 seq_length, const pac_stream_type pac, output_stream_type out)
+    {
+        packed_repack( seq_length, pac, out );
+    }
+};
+template <Alphabet ALPHABET>
+struct pac_copier<ALPHABET,4u,true>
+{
+    template <typename pac_stream_type, typename output_stream_type>
+    static void copy(const uint32 seq_length, const pac_stream_type pac, output_stream_type out)
+    {
+        packed_widen( seq_length, pac, out );
+    }
+};
+
+// convert the [begin,end) range of a .pac stream to the native layout of a given alphabet
+//
+template <Alphabet ALPHABET, typename pac_stream_type>
+void convert_pac_block(const pac_stream_type pac, uint32* words, const uint32 begin, const uint32 end)
+{
+    typedef SequenceDataTraits<ALPHABET> sequence_traits;
+
+    PackedStream<uint32*,uint8,sequence_traits::SEQUENCE_BITS,sequence_traits::SEQUENCE_BIG_ENDIAN> out( words );
+
+    const pac_converter<ALPHABET> converter;
+    for (uint32 i = begin; i < end; ++i)
+        out[i] = converter( pac[i] );
+}
+
 template <Alphabet         ALPHABET>
 bool load_pac(
     const char*     prefix,
@@ -141,7 +202,7 @@ bool load_pac(
             output_stream_type out( stream );
 
             // copy the pac stream into the output
-            assign( seq_length, pac, out ); // TODO: transform pac using a DNA -> ALPHABET conversion
+            pac_copier<ALPHABET>::copy( seq_length, pac, out );
         }
     }
     else
@@ -184,7 +245,7 @@ bool load_pac(
         output_stream_type out( stream );
 
         // copy the pac stream into the output
-        assign( seq_length, pac, out ); // TODO: transform pac using a DNA -> ALPHABET conversion
+        pac_copier<ALPHABET>::copy( seq_length, pac, out );
     }
     fclose( file );
     return true;
@@ -486,6 +547,163 @@ bool load_pac(
     return false;
 }
 
+// map the .pac file and load the .ann/.amb annotations of a BWA reference
+//
+bool SequenceDataPAC::load(const char* prefix)
+{
+    // prepare the sequence index
+    m_sequence_index_vec.resize( 1 );
+    m_sequence_index_vec[0] = 0;
+
+    // prepare the name index
+    m_name_index_vec.resize( 1 );
+    m_name_index_vec[0] = 0;
+
+    // load the BNS files
+    SequenceDataInfo info;
+    try
+    {
+        BNTLoader loader( m_sequence_index_vec, m_name_index_vec, m_name_vec );
+        load_bns( &loader, prefix );
+
+        info = loader.m_info;
+    }
+    catch (...)
+    {
+        log_error(stderr, "loading BNS files failed\n");
+        return false;
+    }
+
+    const std::string pac_file_name = std::string( prefix ) + ".pac";
+
+    m_pac_ptr = (const uint8*)m_pac_file.init( pac_file_name.c_str() );
+    if (m_pac_ptr == NULL)
+    {
+        log_warning(stderr, "unable to map %s\n", pac_file_name.c_str());
+        return false;
+    }
+
+    // the last byte of a .pac file stores the number of symbols in the previous one
+    const uint64 packed_file_len = m_pac_file.size() - 1u;
+    const uint32 last_byte_len   = m_pac_ptr[ packed_file_len ];
+    const uint64 seq_length      = (packed_file_len - 1u) * 4u + last_byte_len;
+    if (seq_length != info.bps())
+    {
+        log_error(stderr, "mismatching sequence lengths in %s, expected: %u, found: %llu\n", pac_file_name.c_str(), info.bps(), seq_length);
+        return false;
+    }
+
+    // setup all basic info
+    SequenceDataInfo::operator=( info );
+    m_alphabet              = DNA;
+    m_sequence_stream_words = uint32( util::divide_ri( seq_length, 16u ) );
+    m_name_stream_len       = uint32( m_name_vec.size() );
+    m_has_qualities         = false;
+    return true;
+}
+
+// convert the mapped sequence to the native layout of a given alphabet, in parallel
+//
+bool SequenceDataPAC::convert(const Alphabet alphabet, SequenceDataHost* sequence_data) const
+{
+    if (m_pac_ptr == NULL)
+        return false;
+
+    if (alphabet != DNA && alphabet != DNA_N && alphabet != RNA && alphabet != RNA_N && alphabet != PROTEIN)
+    {
+        log_error(stderr, "unsupported .pac conversion alphabet\n");
+        return false;
+    }
+
+    const uint32 bits             = bits_per_symbol( alphabet );
+    const uint32 symbols_per_word = 32 / bits;
+
+    const uint32 seq_length         = bps();
+    const uint32 seq_words          = uint32( util::divide_ri( seq_length, symbols_per_word ) );
+    const uint32 aligned_seq_words  = align<4>( seq_words );
+
+    // setup all basic info
+    sequence_data->SequenceDataInfo::operator=( *this );
+    sequence_data->m_alphabet               = alphabet;
+    sequence_data->m_sequence_stream_words  = aligned_seq_words;
+
+    sequence_data->m_sequence_index_vec = m_sequence_index_vec;
+    sequence_data->m_name_index_vec     = m_name_index_vec;
+    sequence_data->m_name_vec           = m_name_vec;
+
+    // alloc sequence storage
+    sequence_data->m_sequence_vec.resize( aligned_seq_words );
+    uint32* words = raw_pointer( sequence_data->m_sequence_vec );
+
+    // initialize the alignment slack
+    for (uint32 i = seq_words; i < aligned_seq_words; ++i)
+        words[i] = 0u;
+
+    if (alphabet == DNA)
+    {
+        // the native DNA layout packs 16 big-endian symbols per word, i.e. each output word
+        // is just the big-endian interpretation of 4 consecutive .pac bytes
+        const uint32 full_words = seq_length / 16u;
+
+        #pragma omp parallel for
+        for (int64 i = 0; i < int64( full_words ); ++i)
+        {
+            const uint8* in = m_pac_ptr + i*4u;
+            words[i] = (uint32( in[0] ) << 24) |
+                       (uint32( in[1] ) << 16) |
+                       (uint32( in[2] ) <<  8) |
+                        uint32( in[3] );
+        }
+
+        // the trailing word, if partial
+        if (full_words < seq_words)
+        {
+            const uint32 tail_bytes = uint32( util::divide_ri( seq_length, 4u ) ) - full_words*4u;
+
+            uint32 word = 0u;
+            for (uint32 j = 0; j < tail_bytes; ++j)
+                word |= uint32( m_pac_ptr[ full_words*4u + j ] ) << (24u - j*8u);
+
+            words[ full_words ] = word;
+        }
+    }
+    else
+    {
+        // build the input pac stream
+        const pac_stream_type pac( m_pac_ptr );
+
+        // process blocks of whole output words in parallel, so that no two threads touch the same word
+        const uint32 BLOCK_WORDS   = 16*1024;
+        const uint32 n_blocks      = uint32( util::divide_ri( seq_words, BLOCK_WORDS ) );
+
+        #pragma omp parallel for
+        for (int32 b = 0; b < int32( n_blocks ); ++b)
+        {
+            const uint32 begin = b * BLOCK_WORDS * symbols_per_word;
+            const uint32 end   = nvbio::min( begin + BLOCK_WORDS * symbols_per_word, seq_length );
+
+            switch (alphabet)
+            {
+            case DNA_N:
+                convert_pac_block<DNA_N>( pac, words, begin, end );
+                break;
+            case RNA:
+                convert_pac_block<RNA>( pac, words, begin, end );
+                break;
+            case RNA_N:
+                convert_pac_block<RNA_N>( pac, words, begin, end );
+                break;
+            case PROTEIN:
+                convert_pac_block<PROTEIN>( pac, words, begin, end );
+                break;
+
+            default: break;
+            }
+        }
+    }
+    return true;
+}
+
 ///@} // SequenceIO
 ///@} // IO
 
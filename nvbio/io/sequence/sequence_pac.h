@@ -28,6 +28,7 @@
 #pragma once
 
 #include <nvbio/io/sequence/sequence.h>
+#include <nvbio/basic/mmap.h>
 
 namespace nvbio {
 namespace io {
@@ -75,6 +76,83 @@ bool load_pac(
     const SequenceFlags             load_flags,
     const QualityEncoding           qualities);
 
+///
+/// A const view of sequence data whose symbols are stored in the BWA .pac format, i.e. as a
+/// big-endian stream of 2-bit symbols packed in bytes.
+/// Wrapping it in a SequenceDataAccess<DNA,PacSequenceDataView> yields a
+/// PackedStream<const uint8*,uint8,2,true> sequence stream, so that it can be used by
+/// all the code templated over the sequence data view type.
+///
+typedef SequenceDataViewCore<const uint32*,const uint8*,const char*,const char*> PacSequenceDataView;
+
+///
+/// Zero-copy DNA sequence data backed by a memory mapped BWA .pac file: as opposed to
+/// load_pac(), the sequence is neither read nor repacked, but paged in on demand.
+/// A conversion to the native SequenceDataHost layout is performed only if explicitly
+/// requested calling convert(), which runs in parallel.
+///
+///\code
+/// io::SequenceDataPAC reference;
+/// if (reference.load( "hg19" ))
+/// {
+///     const io::PacSequenceDataView view( reference );
+///     const io::SequenceDataAccess<DNA,io::PacSequenceDataView> access( view );
+///     do_something( access.sequence_string_set() );
+/// }
+///\endcode
+///
+struct SequenceDataPAC : public SequenceDataInfo
+{
+    typedef PacSequenceDataView                         plain_view_type;
+    typedef PacSequenceDataView                   const_plain_view_type;
+    typedef PackedStream<const uint8*,uint8,2,true>     pac_stream_type;
+
+    /// constructor
+    ///
+    SequenceDataPAC() : m_pac_ptr( NULL ) {}
+
+    /// map the .pac file and load the .ann/.amb annotations of a BWA reference
+    ///
+    /// \param prefix      the reference prefix
+    ///
+    bool load(const char* prefix);
+
+    /// convert to a plain view
+    ///
+    operator const_plain_view_type() const
+    {
+        return const_plain_view_type(
+            static_cast<const SequenceDataInfo&>( *this ),
+            m_pac_ptr,
+            raw_pointer( m_sequence_index_vec ),
+            (const char*)NULL,
+            raw_pointer( m_name_vec ),
+            raw_pointer( m_name_index_vec ) );
+    }
+
+    /// return the mapped .pac stream
+    ///
+    pac_stream_type pac_stream() const { return pac_stream_type( m_pac_ptr ); }
+
+    /// convert the mapped sequence to the native layout of a given alphabet, in parallel;
+    /// the supported alphabets are DNA, DNA_N, RNA, RNA_N and PROTEIN
+    ///
+    /// \param alphabet        the output alphabet
+    /// \param sequence_data   the output sequence data
+    ///
+    bool convert(const Alphabet alphabet, SequenceDataHost* sequence_data) const;
+
+    MappedDiskFile                  m_pac_file;             ///< the mapped .pac file
+    const uint8*                    m_pac_ptr;              ///< the mapped .pac contents
+    nvbio::vector<host_tag,uint32>  m_sequence_index_vec;   ///< the sequence index
+    nvbio::vector<host_tag,uint32>  m_name_index_vec;       ///< the name index
+    nvbio::vector<host_tag,char>    m_name_vec;             ///< the names
+
+private:
+    SequenceDataPAC(const SequenceDataPAC&);
+    SequenceDataPAC& operator=(const SequenceDataPAC&);
+};
+
 ///@} // SequenceIO
 ///@} // IO
 
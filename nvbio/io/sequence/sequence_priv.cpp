@@ -34,6 +34,7 @@
 #include <nvbio/io/sequence/sequence_sam.h>
 #include <nvbio/io/sequence/sequence_bam.h>
 #include <nvbio/io/sequence/sequence_pac.h>
+#include <nvbio/io/sequence/sequence_nvr.h>
 
 #include <nvbio/basic/shared_pointer.h>
 
@@ -111,6 +112,14 @@ SequenceDataStream *open_sequence_file(
             options );
     }
 
+    // check for the nvr container, which is never compressed
+    if (is_nvr_file( sequence_file_name ))
+    {
+        return new SequenceDataFile_NVR(
+            sequence_file_name,
+            options );
+    }
+
     // do we have a .gz suffix?
     if (len >= strlen(".gz"))
     {
@@ -291,6 +300,14 @@ SequenceDataOutputStream* open_output_sequence_file(
     const char* lz4 = "lz4";
     const char* compressor = NULL;
 
+    // check for the nvr container, which is never compressed
+    if (is_nvr_file( sequence_file_name ))
+    {
+        return new SequenceDataOutputFile_NVR(
+            sequence_file_name,
+            options );
+    }
+
     // do we have a .gz suffix?
     if (len >= strlen(".gz"))
     {
@@ -30,6 +30,7 @@
 #include <zlib/zlib.h>
 
 #include <nvbio/basic/console.h>
+#include <nvbio/basic/profiling.h>
 #include <nvbio/io/sequence/sequence_sam.h>
 #include <nvbio/io/sequence/sequence_encoder.h>
 
@@ -363,6 +364,8 @@ bool SequenceDataFile_SAM::rewind()
 // fetch the next chunk of reads (up to max_reads) from the file and push it into output
 int SequenceDataFile_SAM::nextChunk(SequenceDataEncoder *output, uint32 max_reads, uint32 max_bps)
 {
+    NVBIO_PROFILE_REGION( "io/sam-parse" );
+
     if (max_bps < SequenceDataFile::LONG_READ)
         return 0;
 
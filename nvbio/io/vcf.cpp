@@ -29,8 +29,13 @@
 
 #include <nvbio/basic/console.h>
 #include <nvbio/io/vcf.h>
-#include <nvbio/io/bufferedtextfile.h>
 #include <nvbio/basic/dna.h>
+#include <nvbio/basic/numbers.h>
+#include <nvbio/basic/mmap.h>
+#include <nvbio/basic/omp.h>
+
+#include <htslib/hts.h>
+#include <htslib/vcf.h>
 
 #include <stdlib.h>
 #include <string.h>
@@ -54,24 +59,22 @@ static bool get_end_position(uint32 *out, char *info)
             *sc = '\0';
         }
 
-        // now search for the next equal sign
+        // now search for the next equal sign: entries without one are flags,
+        // or the missing value marker '.', which carry no END tag
         eq = strchr(info, '=');
-        if (!eq)
+        if (eq)
         {
-            // no equal sign, malformed header
-            return false;
+            // zero out the equal sign
+            *eq = 0;
         }
 
-        // zero out the equal sign
-        *eq = 0;
-
         // check the key name
-        if (strcmp(info, "END") == 0)
+        if (eq && strcmp(info, "END") == 0)
         {
             // parse the END value
             char *endptr = NULL;
             uint32 position = strtoll(eq + 1, &endptr, 10);
-            if (!endptr || endptr == eq || *endptr != '\0')
+            if (!endptr || endptr == eq + 1 || *endptr != '\0')
             {
                 return false;
             }
@@ -91,44 +94,110 @@ static bool get_end_position(uint32 *out, char *info)
     return true;
 }
 
-// loads a VCF 4.2 file, appending the data to output
-bool loadVCF(SNPDatabase& output, const char *file_name)
+namespace {
+
+// a staged variant, referencing the strings stored in the text buffer of its chunk
+//
+struct StagedVariant
+{
+    uint32  chrom;          // offset of the NULL-terminated chromosome name
+    uint32  ref;            // offset of the NULL-terminated reference string
+    uint32  var;            // offset of the NULL-terminated variant string
+    uint32  ref_len;
+    uint32  var_len;
+    uint2   position;
+    uint8   quality;
+};
+
+// the staging area holding the variants parsed from a chunk of the input
+//
+struct VCFStaging
 {
-    BufferedTextFile file(file_name);
-    char *line, *end;
-    uint32 line_counter = 0;
+    VCFStaging() : n_lines( 0 ), n_warnings( 0 ), error_line( 0 ), error( NULL ), ref_symbols( 0 ), var_symbols( 0 ) {}
 
-    while((line = file.next_record(&end)))
+    // append a NULL-terminated string to the text buffer, returning its offset
+    uint32 push_string(const char* str, const uint32 len)
     {
-        line_counter++;
-        *end = '\0';
+        const uint32 offset = uint32( text.size() );
+        text.insert( text.end(), str, str + len );
+        text.push_back( '\0' );
+        return offset;
+    }
 
-        // strip out comments
-        char *comment = strchr(line, '#');
-        if (comment)
-            *comment = '\0';
+    std::vector<char>           text;
+    std::vector<StagedVariant>  variants;
+    uint32                      n_lines;        // the number of lines in this chunk
+    uint32                      n_warnings;     // the number of non-fatal parsing errors
+    uint32                      error_line;     // the chunk-relative line of the first fatal error, or 0
+    const char*                 error;          // the first fatal error message
+    uint64                      ref_symbols;    // the total length of the staged reference strings
+    uint64                      var_symbols;    // the total length of the staged variant strings
+};
+
+// convert a QUAL value to its 8-bit representation, saturating at 254 as 255 marks a missing value
+//
+uint8 quality_score(const float qual)
+{
+    return uint8( nvbio::min( nvbio::max( qual, 0.0f ), 254.0f ) );
+}
 
-        // skip all leading whitespace
-        while (*line == ' ' || *line == '\t' || *line == '\r')
-        {
-            line++;
-        }
+// stage a variant
+//
+void stage_variant(
+    VCFStaging&     staging,
+    const uint32    chrom,
+    const uint32    ref,
+    const uint32    ref_len,
+    const uint32    var,
+    const uint32    var_len,
+    const uint2     position,
+    const uint8     quality)
+{
+    StagedVariant variant;
+    variant.chrom    = chrom;
+    variant.ref      = ref;
+    variant.ref_len  = ref_len;
+    variant.var      = var;
+    variant.var_len  = var_len;
+    variant.position = position;
+    variant.quality  = quality;
+
+    staging.variants.push_back( variant );
+    staging.ref_symbols += ref_len;
+    staging.var_symbols += var_len;
+}
 
-        if (*line == '\0')
-        {
-            // empty line, skip
-            continue;
-        }
+// parse a single NULL-terminated VCF line, modifying it in place
+// returns NULL on success, or a description of the error
+//
+const char* parse_vcf_line(char* line, VCFStaging& staging)
+{
+    // strip out comments
+    char *comment = strchr(line, '#');
+    if (comment)
+        *comment = '\0';
 
-        // parse the entries in each record
-        char *chrom  = NULL;
-        char *pos    = NULL;
-        char *id     = NULL;
-        char *ref    = NULL;
-        char *alt    = NULL;
-        char *qual   = NULL;
-        char *filter = NULL;
-        char *info   = NULL;
+    // skip all leading whitespace
+    while (*line == ' ' || *line == '\t' || *line == '\r')
+    {
+        line++;
+    }
+
+    if (*line == '\0')
+    {
+        // empty line, skip
+        return NULL;
+    }
+
+    // parse the entries in each record
+    char *chrom  = NULL;
+    char *pos    = NULL;
+    char *id     = NULL;
+    char *ref    = NULL;
+    char *alt    = NULL;
+    char *qual   = NULL;
+    char *filter = NULL;
+    char *info   = NULL;
 
 // ugly macro to tokenize the string based on strchr
 #define NEXT(prev, next)                        \
@@ -144,97 +213,348 @@ bool loadVCF(SNPDatabase& output, const char *file_name)
         }                                       \
     }
 
-        chrom = line;
-        NEXT(chrom, pos);
-        NEXT(pos, id);
-        NEXT(id, ref);
-        NEXT(ref, alt);
-        NEXT(alt, qual);
-        NEXT(qual, filter);
-        NEXT(filter, info);
+    chrom = line;
+    NEXT(chrom, pos);
+    NEXT(pos, id);
+    NEXT(id, ref);
+    NEXT(ref, alt);
+    NEXT(alt, qual);
+    NEXT(qual, filter);
+    NEXT(filter, info);
+
+    if (!chrom || !pos || !id || !ref || !alt || !qual || !filter)
+        return "incomplete variant";
+
+#undef NEXT
+
+    // convert position and quality
+    char *endptr = NULL;
+    uint32 position = strtoll(pos, &endptr, 10);
+    if (!endptr || endptr == pos || *endptr != '\0')
+        return "invalid position";
 
-        if (!chrom || !pos || !id || !ref || !alt || !qual || !filter)
+    uint8 quality;
+    if (*qual == '.')
+    {
+        quality = 0xff;
+    } else {
+        // QUAL is a float, as also returned by htslib for compressed VCF and BCF files
+        quality = quality_score( strtof(qual, &endptr) );
+        if (!endptr || endptr == qual || *endptr != '\0')
         {
-            log_error(stderr, "Error parsing VCF file (line %d): incomplete variant\n", line_counter);
-            return false;
+            staging.n_warnings++;
+            quality = 0xff;
         }
+    }
 
-#undef NEXT
+    const uint32 ref_len = strlen(ref);
+
+    uint32 stop = position + ref_len;
+    // parse the info header looking for a stop position
+    if (info)
+    {
+        if (get_end_position(&stop, info) == false)
+            return "error parsing INFO line";
+    }
 
-        // convert position and quality
-        char *endptr = NULL;
-        uint32 position = strtoll(pos, &endptr, 10);
-        if (!endptr || endptr == pos || *endptr != '\0')
+    const uint32 chrom_offset = staging.push_string( chrom, strlen(chrom) );
+    const uint32 ref_offset   = staging.push_string( ref, ref_len );
+
+    // add an entry for each possible variant listed in this record
+    do {
+        char *next_base = strchr(alt, ',');
+        if (next_base)
+            *next_base = '\0';
+
+        // if this is a called monomorphic variant (i.e., a site which has been identified as always having the same allele)
+        // we store the reference string as the variant
+        if (strcmp(alt, ".") == 0)
+            stage_variant( staging, chrom_offset, ref_offset, ref_len, ref_offset, ref_len, make_uint2(position, stop), quality );
+        else
         {
-            log_error(stderr, "VCF file error (line %d): invalid position\n", line_counter);
-            return false;
+            const uint32 var_len = strlen(alt);
+            stage_variant( staging, chrom_offset, ref_offset, ref_len, staging.push_string( alt, var_len ), var_len, make_uint2(position, stop), quality );
         }
 
-        uint8 quality;
-        if (*qual == '.')
+        if (next_base)
+            alt = next_base + 1;
+        else
+            alt = NULL;
+    } while (alt && *alt != '\0');
+
+    return NULL;
+}
+
+// parse a line-aligned chunk of a text VCF file
+//
+void parse_vcf_chunk(const char* begin, const char* end, VCFStaging& staging)
+{
+    std::vector<char> line;
+
+    while (begin < end)
+    {
+        const char* eol = (const char*)memchr( begin, '\n', end - begin );
+        if (eol == NULL)
+            eol = end;
+
+        // copy the line, as the input is read-only
+        line.assign( begin, eol );
+        if (line.empty() == false && line.back() == '\r')
+            line.pop_back();
+        line.push_back( '\0' );
+
+        staging.n_lines++;
+
+        const char* error = parse_vcf_line( &line[0], staging );
+        if (error)
         {
-            quality = 0xff;
-        } else {
-            quality = (uint8) strtol(qual, &endptr, 10);
-            if (!endptr || endptr == qual || *endptr != '\0')
-            {
-                log_warning(stderr, "VCF file error (line %d): invalid quality\n", line_counter);
-                quality = 0xff;
-            }
+            staging.error      = error;
+            staging.error_line = staging.n_lines;
+            return;
         }
 
-        uint32 stop = position + strlen(ref);
-        // parse the info header looking for a stop position
-        if (info)
+        begin = eol + 1;
+    }
+}
+
+// parse a text VCF file in parallel, splitting it in line-aligned chunks
+//
+bool parse_vcf_text(const char* file_name, std::vector<VCFStaging>& chunks)
+{
+    MappedDiskFile file;
+    const char* data = (const char*)file.init( file_name );
+    if (data == NULL)
+    {
+        // an empty file is not an error
+        FILE* test = fopen( file_name, "rb" );
+        if (test)
+            fclose( test );
+        else
+            log_error(stderr, "unable to open VCF file \"%s\"\n", file_name);
+
+        return test != NULL;
+    }
+    file.advise_sequential();
+
+    const uint64 file_size = file.size();
+
+    // use a few chunks per thread to balance the load, but avoid tiny ones
+    const uint64 MIN_CHUNK_SIZE = 1024*1024;
+    const uint32 n_chunks = uint32( nvbio::max( nvbio::min( uint64( omp_get_max_threads() * 4 ), file_size / MIN_CHUNK_SIZE ), uint64(1u) ) );
+
+    // find the chunk boundaries, moving each to the beginning of the next line
+    std::vector<uint64> boundaries( n_chunks + 1u );
+    boundaries[0]        = 0;
+    boundaries[n_chunks] = file_size;
+    for (uint32 i = 1; i < n_chunks; ++i)
+    {
+        uint64 offset = nvbio::max( (file_size * i) / n_chunks, boundaries[i-1] );
+        while (offset < file_size && data[offset-1] != '\n')
+            ++offset;
+
+        boundaries[i] = offset;
+    }
+
+    chunks.resize( n_chunks );
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int32 i = 0; i < int32( n_chunks ); ++i)
+        parse_vcf_chunk( data + boundaries[i], data + boundaries[i+1], chunks[i] );
+
+    // report the first error, translating its location to a global line number
+    uint32 line_offset = 0;
+    for (uint32 i = 0; i < n_chunks; ++i)
+    {
+        if (chunks[i].error)
         {
-            bool ret;
-            ret = get_end_position(&stop, info);
-            if (ret == false)
-            {
-                log_warning(stderr, "VCF file error (line %d): error parsing INFO line\n", line_counter);
-                return false;
-            }
+            log_error(stderr, "VCF file error (line %u): %s\n", line_offset + chunks[i].error_line, chunks[i].error);
+            return false;
         }
+        line_offset += chunks[i].n_lines;
+    }
+    return true;
+}
+
+// parse a BGZF-compressed VCF or a BCF file through htslib
+//
+bool parse_vcf_hts(const char* file_name, VCFStaging& staging)
+{
+    htsFile* file = hts_open( file_name, "r" );
+    if (file == NULL)
+    {
+        log_error(stderr, "unable to open VCF file \"%s\"\n", file_name);
+        return false;
+    }
+
+    bcf_hdr_t* header = bcf_hdr_read( file );
+    if (header == NULL)
+    {
+        log_error(stderr, "unable to read the header of VCF file \"%s\"\n", file_name);
+        hts_close( file );
+        return false;
+    }
 
-        // add an entry for each possible variant listed in this record
-        do {
-            char *next_base = strchr(alt, ',');
-            if (next_base)
-                *next_base = '\0';
-
-            char *var;
-            // if this is a called monomorphic variant (i.e., a site which has been identified as always having the same allele)
-            // we store the reference string as the variant
-            if (strcmp(alt, ".") == 0)
-                var = ref;
-            else
-                var = alt;
-
-            const uint32 ref_len = strlen(ref);
+    bcf1_t* record = bcf_init();
+
+    int32* end_values = NULL;
+    int    n_end_values = 0;
+
+    bool success = true;
+
+    int ret;
+    while ((ret = bcf_read( file, header, record )) >= 0)
+    {
+        staging.n_lines++;
+
+        bcf_unpack( record, BCF_UN_STR | BCF_UN_INFO );
+
+        // htslib positions are 0-based
+        const uint32 position = uint32( record->pos ) + 1u;
+
+        const uint8 quality = bcf_float_is_missing( record->qual ) ? 0xff : quality_score( record->qual );
+
+        const char*  ref     = record->d.allele[0];
+        const uint32 ref_len = strlen(ref);
+
+        uint32 stop = position + ref_len;
+        if (bcf_get_info_int32( header, record, "END", &end_values, &n_end_values ) > 0)
+            stop = uint32( end_values[0] );
+
+        const char*  chrom        = bcf_hdr_id2name( header, record->rid );
+        const uint32 chrom_offset = staging.push_string( chrom, strlen(chrom) );
+        const uint32 ref_offset   = staging.push_string( ref, ref_len );
+
+        // a called monomorphic variant stores the reference string as the variant
+        if (record->n_allele <= 1)
+            stage_variant( staging, chrom_offset, ref_offset, ref_len, ref_offset, ref_len, make_uint2(position, stop), quality );
+
+        for (uint32 i = 1; i < record->n_allele; ++i)
+        {
+            const char*  var     = record->d.allele[i];
             const uint32 var_len = strlen(var);
+            stage_variant( staging, chrom_offset, ref_offset, ref_len, staging.push_string( var, var_len ), var_len, make_uint2(position, stop), quality );
+        }
+    }
+    if (ret < -1)
+    {
+        log_error(stderr, "VCF file error (record %u): error reading \"%s\"\n", staging.n_lines + 1u, file_name);
+        success = false;
+    }
+
+    free( end_values );
+    bcf_destroy( record );
+    bcf_hdr_destroy( header );
+    hts_close( file );
+    return success;
+}
+
+// merge the staged variants into the output database in a single pass.
+// the reference and variant strings of each chunk are placed at offsets aligned to
+// whole packed words, so that different chunks can be written concurrently
+//
+void merge_vcf_chunks(SNPDatabase& output, const std::vector<VCFStaging>& chunks)
+{
+    const uint32 n_chunks = uint32( chunks.size() );
+
+    const uint64 SYMBOLS_PER_WORD = 8u; // 4-bit symbols in 32-bit words
+
+    std::vector<uint64> variant_offsets( n_chunks + 1u );
+    std::vector<uint64> ref_offsets( n_chunks + 1u );
+    std::vector<uint64> var_offsets( n_chunks + 1u );
+
+    variant_offsets[0] = output.ref_variant_index.size();
+    ref_offsets[0]     = util::round_i( uint64( output.reference_sequences.size() ), SYMBOLS_PER_WORD );
+    var_offsets[0]     = util::round_i( uint64( output.variants.size() ),            SYMBOLS_PER_WORD );
 
-            SNP_sequence_index index(output.reference_sequences.size(), ref_len,
-                                     output.variants.size(), var_len);
-            output.ref_variant_index.push_back(index);
+    uint32 n_warnings = 0;
+    for (uint32 i = 0; i < n_chunks; ++i)
+    {
+        variant_offsets[i+1] = variant_offsets[i] + chunks[i].variants.size();
+        ref_offsets[i+1]     = util::round_i( ref_offsets[i] + chunks[i].ref_symbols, SYMBOLS_PER_WORD );
+        var_offsets[i+1]     = util::round_i( var_offsets[i] + chunks[i].var_symbols, SYMBOLS_PER_WORD );
+        n_warnings          += chunks[i].n_warnings;
+    }
+
+    if (n_warnings)
+        log_warning(stderr, "VCF file error: %u records with invalid quality\n", n_warnings);
+
+    // resize all the outputs once
+    const uint64 n_variants = variant_offsets[n_chunks];
+    output.reference_sequence_names.resize( n_variants );
+    output.sequence_positions.resize( n_variants );
+    output.ref_variant_index.resize( n_variants );
+    output.variant_qualities.resize( n_variants );
+    output.reference_sequences.resize( ref_offsets[n_chunks] );
+    output.variants.resize( var_offsets[n_chunks] );
 
-            output.reference_sequence_names.push_back(std::string(chrom));
-            output.sequence_positions.push_back(make_uint2(position, stop));
+    #pragma omp parallel for schedule(dynamic)
+    for (int32 i = 0; i < int32( n_chunks ); ++i)
+    {
+        const VCFStaging& chunk = chunks[i];
+        const char*       text  = chunk.text.empty() ? NULL : &chunk.text[0];
+
+        uint64 ref_offset = ref_offsets[i];
+        uint64 var_offset = var_offsets[i];
+
+        for (uint32 j = 0; j < chunk.variants.size(); ++j)
+        {
+            const StagedVariant& variant = chunk.variants[j];
+            const uint64         k       = variant_offsets[i] + j;
 
-            output.reference_sequences.resize(index.reference_start + ref_len);
-            string_to_iupac16(ref, output.reference_sequences.begin() + index.reference_start);
+            const SNP_sequence_index index( uint32( ref_offset ), variant.ref_len,
+                                            uint32( var_offset ), variant.var_len );
 
-            output.variants.resize(index.variant_start + var_len);
-            string_to_iupac16(var, output.variants.begin() + index.variant_start);
+            output.reference_sequence_names[k] = text + variant.chrom;
+            output.sequence_positions[k]       = variant.position;
+            output.ref_variant_index[k]        = index;
+            output.variant_qualities[k]        = variant.quality;
 
-            output.variant_qualities.push_back(quality);
+            string_to_iupac16( text + variant.ref, output.reference_sequences.begin() + index.reference_start );
+            string_to_iupac16( text + variant.var, output.variants.begin()            + index.variant_start );
 
-            if (next_base)
-                alt = next_base + 1;
-            else
-                alt = NULL;
-        } while (alt && *alt != '\0');
+            ref_offset += variant.ref_len;
+            var_offset += variant.var_len;
+        }
+    }
+}
+
+// check whether a file needs to be read through htslib, i.e. whether it is
+// BGZF/gzip-compressed or an uncompressed BCF
+//
+bool is_hts_vcf(const char* file_name)
+{
+    FILE* file = fopen( file_name, "rb" );
+    if (file == NULL)
+        return false;
+
+    uint8 magic[3] = { 0, 0, 0 };
+    const size_t n = fread( magic, 1, 3, file );
+    fclose( file );
+
+    return (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) ||
+           (n == 3 && magic[0] == 'B' && magic[1] == 'C' && magic[2] == 'F');
+}
+
+} // anonymous namespace
+
+// loads a VCF 4.2 file, appending the data to output.
+// Plain text files are memory mapped, split in line-aligned chunks and parsed in parallel,
+// while BGZF-compressed VCF and BCF files are decoded through htslib; in both cases the
+// parsed variants are staged and merged into the output in a single pass
+bool loadVCF(SNPDatabase& output, const char *file_name)
+{
+    std::vector<VCFStaging> chunks;
+
+    if (is_hts_vcf( file_name ))
+    {
+        chunks.resize( 1 );
+        if (parse_vcf_hts( file_name, chunks[0] ) == false)
+            return false;
     }
+    else if (parse_vcf_text( file_name, chunks ) == false)
+        return false;
 
+    merge_vcf_chunks( output, chunks );
     return true;
 }
 
@@ -87,6 +87,10 @@ struct SNPDatabase
 };
 
 // loads variant data from file_name and appends to output
+// plain text VCF files are parsed in parallel, while BGZF-compressed VCF and BCF files
+// are read through htslib (which nvbio pulls into the link of its applications)
+// note: the reference and variant strings appended by each parallel chunk start at
+// offsets aligned to whole packed words, so they may be separated by padding symbols
 bool loadVCF(SNPDatabase& output, const char *file_name);
 
 } // namespace io
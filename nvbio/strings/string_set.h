@@ -1012,6 +1012,13 @@ void copy(
 ///@addtogroup StringSetsModule
 ///@{
 
+///\par
+/// The host copy() functions run in parallel across all available OpenMP threads.
+/// Strings stored in packed streams of 32-bit words are read and written a whole word at a time;
+/// strided outputs are filled transposing tiles of adjacent strings, and packed concatenated
+/// outputs are split in ranges of whole words, so that no two threads ever write the same word.
+///
+
 /// copy a generic string set into a concatenated one
 ///
 /// \param in_string_set        input string set
@@ -29,6 +29,7 @@
 
 #include <nvbio/basic/algorithms.h>
 #include <nvbio/basic/exceptions.h>
+#include <vector>
 
 #if defined(__CUDACC__)
 
@@ -2051,68 +2052,632 @@ void copy(
 
 #endif // defined(__CUDACC__)
 
-template <typename out_string_set_type>
-struct copy_dispatch
+namespace priv {
+
+// number of adjacent strings transposed together by the host copies into strided layouts,
+// so that each row of the output is written out a cache line at a time
+const uint32 HOST_STRIDED_COPY_TILE = 64u;
+
+// number of output words assigned to each task by the host copies into packed
+// concatenated layouts
+const uint32 HOST_PACKED_COPY_BLOCK = 1024u;
+
+// bit offset of the s-th symbol of a packed 32-bit word
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+NVBIO_FORCEINLINE uint32 packed_symbol_shift(const uint32 s)
 {
-    // generic input set
-    template <typename in_string_set_type>
-    struct source_dispatch
+    return BIG_ENDIAN ? 32u - SYMBOL_SIZE - s*SYMBOL_SIZE : s*SYMBOL_SIZE;
+}
+
+// mask selecting the first n symbols of a packed 32-bit word
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+NVBIO_FORCEINLINE uint32 packed_head_mask(const uint32 n)
+{
+    const uint32 bits = n * SYMBOL_SIZE;
+    if (bits >= 32u)
+        return 0xFFFFFFFFu;
+
+    return BIG_ENDIAN ? ~(0xFFFFFFFFu >> bits) : (1u << bits) - 1u;
+}
+
+// shift the symbols of a packed 32-bit word forward by s slots
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+NVBIO_FORCEINLINE uint32 packed_shift_symbols(const uint32 word, const uint32 s)
+{
+    return BIG_ENDIAN ? word >> (s*SYMBOL_SIZE) : word << (s*SYMBOL_SIZE);
+}
+
+// read the symbols of a generic string one at a time
+//
+template <typename string_type>
+struct host_string_reader
+{
+    host_string_reader(const string_type& string) : m_string( string ) {}
+
+    uint32 length() const { return uint32( m_string.size() ); }
+
+    // unpack the whole string
+    template <typename out_iterator>
+    void unpack(out_iterator out) const
     {
-        static void enact(
-            const in_string_set_type&  in_string_set,
-            const out_string_set_type& out_string_set)
+        const uint32 len = length();
+        for (uint32 j = 0; j < len; ++j)
+            out[j] = m_string[j];
+    }
+
+    // pack the symbols [begin, begin + n) into the first n slots of a 32-bit word
+    template <uint32 OUT_SYMBOL_SIZE, bool OUT_BIG_ENDIAN>
+    uint32 pack(const uint32 begin, const uint32 n) const
+    {
+        const uint32 OUT_SYMBOL_MASK = (1u << OUT_SYMBOL_SIZE) - 1u;
+
+        uint32 word = 0u;
+        for (uint32 s = 0; s < n; ++s)
+            word |= (uint32( m_string[begin + s] ) & OUT_SYMBOL_MASK) << packed_symbol_shift<OUT_SYMBOL_SIZE,OUT_BIG_ENDIAN>( s );
+
+        return word;
+    }
+
+    string_type m_string;
+};
+
+// read the symbols of a string backed by a packed stream of 32-bit words a whole word at a time,
+// funnel-shifting adjacent storage words to realign them
+//
+template <typename string_type, typename InStream, uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+struct host_packed_string_reader
+{
+    static const uint32 SYMBOLS_PER_WORD = 32u / SYMBOL_SIZE;
+    static const uint32 SYMBOL_MASK      = (1u << SYMBOL_SIZE) - 1u;
+
+    host_packed_string_reader(const string_type& string) :
+        m_length( uint32( string.size() ) ),
+        m_stream( string.base().stream() ),
+        m_index( uint64( string.base().index() ) ) {}
+
+    uint32 length() const { return m_length; }
+
+    // return a word holding the symbols [begin, begin + n) in its first n slots, with n <= SYMBOLS_PER_WORD;
+    // the following storage word is only touched if it actually holds any of them
+    NVBIO_FORCEINLINE uint32 load(const uint32 begin, const uint32 n) const
+    {
+        const uint64 pos   = m_index + begin;
+        const uint64 w     = pos / SYMBOLS_PER_WORD;
+        const uint32 shift = uint32( pos % SYMBOLS_PER_WORD ) * SYMBOL_SIZE;
+
+        const uint32 lo = m_stream[w];
+        if (shift == 0u)
+            return lo;
+
+        if (shift + n*SYMBOL_SIZE <= 32u)
+            return BIG_ENDIAN ? lo << shift : lo >> shift;
+
+        const uint32 hi = m_stream[w+1];
+        return BIG_ENDIAN ?
+            (lo << shift) | (hi >> (32u - shift)) :
+            (lo >> shift) | (hi << (32u - shift));
+    }
+
+    // unpack the whole string
+    template <typename out_iterator>
+    void unpack(out_iterator out) const
+    {
+        for (uint32 j = 0; j < m_length; j += SYMBOLS_PER_WORD)
         {
-            if (out_string_set.size() != in_string_set.size() ||
-                out_string_set.stride() < out_string_set.size())
-                throw nvbio::runtime_error( "copy() : unmatched string set sizes" );
+            const uint32 n    = nvbio::min( SYMBOLS_PER_WORD, m_length - j );
+            const uint32 word = load( j, n );
 
-            const uint32 n_strings = in_string_set.size();
+            for (uint32 s = 0; s < n; ++s)
+                out[j + s] = (word >> packed_symbol_shift<SYMBOL_SIZE,BIG_ENDIAN>( s )) & SYMBOL_MASK;
+        }
+    }
+
+    // pack the symbols [begin, begin + n) into the first n slots of a 32-bit word
+    template <uint32 OUT_SYMBOL_SIZE, bool OUT_BIG_ENDIAN>
+    uint32 pack(const uint32 begin, const uint32 n) const
+    {
+        // matching layouts need no transcoding at all
+        if (OUT_SYMBOL_SIZE == SYMBOL_SIZE && OUT_BIG_ENDIAN == BIG_ENDIAN)
+            return load( begin, n ) & packed_head_mask<SYMBOL_SIZE,BIG_ENDIAN>( n );
+
+        const uint32 OUT_SYMBOL_MASK = (1u << OUT_SYMBOL_SIZE) - 1u;
 
-        #if 1
-            const uint32 BLOCK_SIZE = 16;
-            for (uint32 i_block = 0; i_block < n_strings; i_block += BLOCK_SIZE)
+        uint32 word = 0u;
+        for (uint32 s = 0; s < n; s += SYMBOLS_PER_WORD)
+        {
+            const uint32 m       = nvbio::min( SYMBOLS_PER_WORD, n - s );
+            const uint32 in_word = load( begin + s, m );
+
+            for (uint32 t = 0; t < m; ++t)
             {
-                const uint32 i_block_end = std::min( i_block + BLOCK_SIZE, n_strings );
+                const uint32 c = (in_word >> packed_symbol_shift<SYMBOL_SIZE,BIG_ENDIAN>( t )) & SYMBOL_MASK;
+                word |= (c & OUT_SYMBOL_MASK) << packed_symbol_shift<OUT_SYMBOL_SIZE,OUT_BIG_ENDIAN>( s + t );
+            }
+        }
+        return word;
+    }
+
+    uint32   m_length;
+    InStream m_stream;
+    uint64   m_index;
+};
+
+// select the reader to use for a given string type: strings backed by packed streams
+// of 32-bit words are read a word at a time, anything else symbol by symbol
+//
+template <typename string_type>
+struct host_string_reader_selector
+{
+    typedef host_string_reader<string_type> type;
+};
 
-                uint32 max_len = 0;
-                for (uint32 i = i_block; i < i_block_end; ++i)
-                    max_len = std::max( max_len, in_string_set[i].length() );
+template <typename InStream, typename SymbolType, uint32 SYMBOL_SIZE_T, bool BIG_ENDIAN_T, typename StreamIndexType, typename IndexType>
+struct host_string_reader_selector< vector_view< PackedStream<InStream,SymbolType,SYMBOL_SIZE_T,BIG_ENDIAN_T,StreamIndexType>, IndexType > >
+{
+    typedef vector_view< PackedStream<InStream,SymbolType,SYMBOL_SIZE_T,BIG_ENDIAN_T,StreamIndexType>, IndexType > string_type;
+    typedef typename std::iterator_traits<InStream>::value_type                                                       storage_type;
+
+    typedef typename if_true<
+        sizeof(storage_type) == sizeof(uint32),
+        host_packed_string_reader<string_type,InStream,SYMBOL_SIZE_T,BIG_ENDIAN_T>,
+        host_string_reader<string_type> >::type type;
+};
+
+// fill the offsets of a concatenated output set with the exclusive prefix sum of the
+// lengths of the strings in the input set, returning the total length
+//
+template <typename in_string_set_type, typename offset_iterator>
+uint32 host_concatenated_offsets(const in_string_set_type& in_string_set, offset_iterator offsets)
+{
+    const int32 n_strings = int32( in_string_set.size() );
+
+    #pragma omp parallel for
+    for (int32 i = 0; i < n_strings; ++i)
+        offsets[i+1] = in_string_set[i].size();
+
+    offsets[0] = 0u;
+    for (int32 i = 0; i < n_strings; ++i)
+        offsets[i+1] += offsets[i];
+
+    return offsets[n_strings];
+}
+
+// copy a generic string set into a concatenated one whose strings are stored in
+// packed streams of 32-bit words.
+// Writing adjacent strings in parallel is not safe, as their boundary words might be
+// shared: here each task owns a range of output words, and fills them walking over
+// all the strings they span, assembling whole words in registers before storing them.
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename in_string_set_type, typename OutStreamIterator, typename OutOffsetIterator>
+void host_copy_to_packed_concatenated(
+    const in_string_set_type&   in_string_set,
+    const OutStreamIterator     out_stream,
+    const uint64                out_index,
+    const OutOffsetIterator     out_offsets)
+{
+    typedef typename in_string_set_type::string_type                    in_string_type;
+    typedef typename host_string_reader_selector<in_string_type>::type  reader_type;
+
+    const uint32 SYMBOLS_PER_WORD = 32u / SYMBOL_SIZE;
 
-                for (uint32 j_block = 0; j_block < max_len; j_block += BLOCK_SIZE)
+    const uint32 n_strings = in_string_set.size();
+    const uint32 n_symbols = host_concatenated_offsets( in_string_set, out_offsets );
+    if (n_symbols == 0)
+        return;
+
+    // the range of global words spanned by the output
+    const uint64 word_begin = out_index / SYMBOLS_PER_WORD;
+    const uint64 word_end   = util::divide_ri( out_index + n_symbols, uint64( SYMBOLS_PER_WORD ) );
+    const int64  n_blocks   = int64( util::divide_ri( word_end - word_begin, uint64( HOST_PACKED_COPY_BLOCK ) ) );
+
+    #pragma omp parallel for
+    for (int64 b = 0; b < n_blocks; ++b)
+    {
+        const uint64 block_begin = word_begin + uint64(b) * HOST_PACKED_COPY_BLOCK;
+        const uint64 block_end   = nvbio::min( block_begin + HOST_PACKED_COPY_BLOCK, word_end );
+
+        // locate the string holding the first output symbol of this block
+        const uint32 first_symbol = uint32( nvbio::max( block_begin * SYMBOLS_PER_WORD, out_index ) - out_index );
+
+        uint32 string_id    = uint32( upper_bound( first_symbol, out_offsets, n_strings ) - out_offsets ) - 1u;
+        uint32 local_symbol = first_symbol - out_offsets[string_id];
+
+        reader_type reader( in_string_set[string_id] );
+
+        for (uint64 w = block_begin; w < block_end; ++w)
+        {
+            // compute the range of slots of this word covered by the output
+            const uint64 w_begin = w * SYMBOLS_PER_WORD;
+            const uint32 s_begin = uint32( nvbio::max( out_index, w_begin ) - w_begin );
+            const uint32 s_end   = uint32( nvbio::min( out_index + n_symbols, w_begin + SYMBOLS_PER_WORD ) - w_begin );
+
+            uint32 word = 0u;
+            for (uint32 s = s_begin; s < s_end;)
+            {
+                // skip to the next string with symbols left
+                while (local_symbol >= reader.length())
                 {
-                    for (uint32 i = i_block; i < i_block_end; ++i)
-                    {
-                        typename  in_string_set_type::string_type  in_string =  in_string_set[i];
-                        typename out_string_set_type::string_type out_string = out_string_set[i];
+                    reader       = reader_type( in_string_set[++string_id] );
+                    local_symbol = 0u;
+                }
+
+                const uint32 n = nvbio::min( reader.length() - local_symbol, s_end - s );
 
-                        const uint32 m = in_string.length();
-                        const uint32 j_block_end = std::min( j_block + BLOCK_SIZE, m );
+                word |= packed_shift_symbols<SYMBOL_SIZE,BIG_ENDIAN>(
+                    reader.template pack<SYMBOL_SIZE,BIG_ENDIAN>( local_symbol, n ), s );
 
-                        for (uint32 j = j_block; j < j_block_end; ++j)
-                            out_string[j] = in_string[j];
-                    }
+                local_symbol += n;
+                s            += n;
+            }
+
+            // preserve the symbols falling outside of the output in the boundary words
+            if (s_begin > 0u || s_end < SYMBOLS_PER_WORD)
+            {
+                const uint32 mask =
+                    packed_head_mask<SYMBOL_SIZE,BIG_ENDIAN>( s_end ) &
+                   ~packed_head_mask<SYMBOL_SIZE,BIG_ENDIAN>( s_begin );
+
+                word = (uint32( out_stream[w] ) & ~mask) | (word & mask);
+            }
+            out_stream[w] = word;
+        }
+    }
+}
+
+// copy a generic string set into a strided one, transposing tiles of adjacent strings
+// through a local buffer
+//
+template <typename in_string_set_type, typename OutStringIterator, typename OutLengthIterator>
+void host_copy_to_strided(
+    const in_string_set_type&   in_string_set,
+    const uint32                out_stride,
+    const OutStringIterator     out_string,
+    const OutLengthIterator     out_lengths)
+{
+    typedef typename in_string_set_type::string_type                        in_string_type;
+    typedef typename host_string_reader_selector<in_string_type>::type      reader_type;
+    typedef typename std::iterator_traits<OutStringIterator>::value_type    symbol_type;
+
+    const uint32 n_strings = in_string_set.size();
+    const int32  n_tiles   = int32( util::divide_ri( n_strings, HOST_STRIDED_COPY_TILE ) );
+
+    #pragma omp parallel
+    {
+        std::vector<symbol_type> tile;
+        uint32                   lengths[ HOST_STRIDED_COPY_TILE ];
+
+        #pragma omp for schedule(dynamic,16)
+        for (int32 t = 0; t < n_tiles; ++t)
+        {
+            const uint32 i_begin = uint32(t) * HOST_STRIDED_COPY_TILE;
+            const uint32 i_end   = nvbio::min( i_begin + HOST_STRIDED_COPY_TILE, n_strings );
+
+            uint32 max_len = 0u;
+            for (uint32 i = i_begin; i < i_end; ++i)
+            {
+                lengths[i - i_begin] = uint32( in_string_set[i].size() );
+                max_len = nvbio::max( max_len, lengths[i - i_begin] );
+            }
+            if (tile.size() < HOST_STRIDED_COPY_TILE * max_len)
+                tile.resize( HOST_STRIDED_COPY_TILE * max_len );
+
+            // unpack each string into its own row of the tile
+            for (uint32 i = i_begin; i < i_end; ++i)
+            {
+                if (lengths[i - i_begin])
+                    reader_type( in_string_set[i] ).unpack( &tile[ (i - i_begin) * max_len ] );
+
+                out_lengths[i] = lengths[i - i_begin];
+            }
+
+            // and write the tile out transposed, one output row at a time
+            for (uint32 j = 0; j < max_len; ++j)
+            {
+                for (uint32 i = i_begin; i < i_end; ++i)
+                {
+                    if (j < lengths[i - i_begin])
+                        out_string[ j * out_stride + i ] = tile[ (i - i_begin) * max_len + j ];
                 }
             }
-        #else
-            for (uint32 i = 0; i < n_strings; ++i)
+        }
+    }
+}
+
+// copy a generic string set into a strided one whose strings are stored in packed
+// streams of 32-bit words, assembling whole words in a local tile of adjacent strings
+// before writing them out transposed
+//
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN, typename in_string_set_type, typename OutStreamIterator, typename OutLengthIterator>
+void host_copy_to_strided_packed(
+    const in_string_set_type&   in_string_set,
+    const uint32                out_stride,
+    const OutStreamIterator     out_stream,
+    const OutLengthIterator     out_lengths)
+{
+    typedef typename in_string_set_type::string_type                    in_string_type;
+    typedef typename host_string_reader_selector<in_string_type>::type  reader_type;
+
+    const uint32 SYMBOLS_PER_WORD = 32u / SYMBOL_SIZE;
+
+    const uint32 n_strings = in_string_set.size();
+    const int32  n_tiles   = int32( util::divide_ri( n_strings, HOST_STRIDED_COPY_TILE ) );
+
+    #pragma omp parallel
+    {
+        std::vector<uint32> tile;
+        uint32              n_words[ HOST_STRIDED_COPY_TILE ];
+
+        #pragma omp for schedule(dynamic,16)
+        for (int32 t = 0; t < n_tiles; ++t)
+        {
+            const uint32 i_begin = uint32(t) * HOST_STRIDED_COPY_TILE;
+            const uint32 i_end   = nvbio::min( i_begin + HOST_STRIDED_COPY_TILE, n_strings );
+
+            uint32 max_words = 0u;
+            for (uint32 i = i_begin; i < i_end; ++i)
+            {
+                n_words[i - i_begin] = util::divide_ri( uint32( in_string_set[i].size() ), SYMBOLS_PER_WORD );
+                max_words = nvbio::max( max_words, n_words[i - i_begin] );
+            }
+            if (tile.size() < HOST_STRIDED_COPY_TILE * max_words)
+                tile.resize( HOST_STRIDED_COPY_TILE * max_words );
+
+            // pack each string into its own row of the tile
+            for (uint32 i = i_begin; i < i_end; ++i)
             {
-                typename  in_string_set_type::string_type  in_string =  in_string_set[i];
-                typename out_string_set_type::string_type out_string = out_string_set[i];
+                const reader_type reader( in_string_set[i] );
+                const uint32      length = reader.length();
 
-                const uint32 m = in_string.length();
-                for (uint32 j = 0; j < m; ++j)
-                    out_string[j] = in_string[j];
+                uint32* row = max_words ? &tile[ (i - i_begin) * max_words ] : NULL;
+                for (uint32 w = 0; w < n_words[i - i_begin]; ++w)
+                {
+                    const uint32 begin = w * SYMBOLS_PER_WORD;
+                    row[w] = reader.template pack<SYMBOL_SIZE,BIG_ENDIAN>( begin, nvbio::min( SYMBOLS_PER_WORD, length - begin ) );
+                }
+
+                out_lengths[i] = length;
+            }
+
+            // and write the tile out transposed, one output row at a time
+            for (uint32 w = 0; w < max_words; ++w)
+            {
+                for (uint32 i = i_begin; i < i_end; ++i)
+                {
+                    if (w < n_words[i - i_begin])
+                        out_stream[ w * out_stride + i ] = tile[ (i - i_begin) * max_words + w ];
+                }
             }
-        #endif
         }
-    };
+    }
+}
+
+// copy a generic string set into a strided or strided-packed one whose layout is not
+// supported by the word-level paths, one string per task
+//
+template <typename in_string_set_type, typename out_string_set_type>
+void host_copy_generic_strided(
+    const in_string_set_type&   in_string_set,
+    const out_string_set_type&  out_string_set)
+{
+    const int32 n_strings = int32( in_string_set.size() );
+
+    #pragma omp parallel for
+    for (int32 i = 0; i < n_strings; ++i)
+    {
+        typename in_string_set_type::string_type in_string = in_string_set[i];
+
+        const uint32 length = uint32( in_string.size() );
+        out_string_set.lengths()[i] = length;
+
+        typename out_string_set_type::string_type out_string = out_string_set[i];
+        for (uint32 j = 0; j < length; ++j)
+            out_string[j] = in_string[j];
+    }
+}
+
+// select between the word-level and the generic copy into a packed concatenated set
+//
+template <bool WORD_LEVEL, uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+struct host_packed_concatenated_copy
+{
+    template <typename in_string_set_type, typename out_string_set_type>
+    static void enact(const in_string_set_type& in_string_set, const out_string_set_type& out_string_set)
+    {
+        const uint32 n_strings = in_string_set.size();
+
+        host_concatenated_offsets( in_string_set, out_string_set.offsets() );
+
+        // serial, as strings might share words
+        for (uint32 i = 0; i < n_strings; ++i)
+        {
+            typename  in_string_set_type::string_type  in_string =  in_string_set[i];
+            typename out_string_set_type::string_type out_string = out_string_set[i];
+
+            const uint32 m = uint32( in_string.size() );
+            for (uint32 j = 0; j < m; ++j)
+                out_string[j] = in_string[j];
+        }
+    }
+};
+
+template <uint32 SYMBOL_SIZE, bool BIG_ENDIAN>
+struct host_packed_concatenated_copy<true,SYMBOL_SIZE,BIG_ENDIAN>
+{
+    template <typename in_string_set_type, typename out_string_set_type>
+    static void enact(const in_string_set_type& in_string_set, const out_string_set_type& out_string_set)
+    {
+        host_copy_to_packed_concatenated<SYMBOL_SIZE,BIG_ENDIAN>(
+            in_string_set,
+            out_string_set.base_string().stream(),
+            uint64( out_string_set.base_string().index() ),
+            out_string_set.offsets() );
+    }
+};
+
+// select between the word-level and the generic copy into a strided-packed set
+//
+template <bool WORD_LEVEL>
+struct host_strided_packed_copy
+{
+    template <typename in_string_set_type, typename out_string_set_type>
+    static void enact(const in_string_set_type& in_string_set, const out_string_set_type& out_string_set)
+    {
+        host_copy_generic_strided( in_string_set, out_string_set );
+    }
+};
+
+template <>
+struct host_strided_packed_copy<true>
+{
+    template <typename in_string_set_type, typename out_string_set_type>
+    static void enact(const in_string_set_type& in_string_set, const out_string_set_type& out_string_set)
+    {
+        host_copy_to_strided_packed<
+            out_string_set_type::SYMBOL_SIZE,
+            out_string_set_type::BIG_ENDIAN>(
+            in_string_set,
+            out_string_set.stride(),
+            out_string_set.base_stream(),
+            out_string_set.lengths() );
+    }
+};
+
+} // namespace priv
+
+template <typename out_string_set_type>
+struct copy_dispatch {};
+
+//
+// concatenated output set
+//
+template <
+    typename OutStringIterator,
+    typename OutOffsetIterator>
+struct copy_dispatch<
+    ConcatenatedStringSet<OutStringIterator,OutOffsetIterator>
+    >
+{
+    typedef ConcatenatedStringSet<OutStringIterator,OutOffsetIterator> out_string_set_type;
 
     template <typename in_string_set_type>
     static void enact(
-            const in_string_set_type&  in_string_set,
-                  out_string_set_type& out_string_set)
+        const in_string_set_type&  in_string_set,
+              out_string_set_type& out_string_set)
     {
-        return source_dispatch<in_string_set_type>::enact( in_string_set, out_string_set );
+        typedef typename in_string_set_type::string_type                            in_string_type;
+        typedef typename priv::host_string_reader_selector<in_string_type>::type    reader_type;
+
+        if (out_string_set.size() != in_string_set.size())
+            throw nvbio::runtime_error( "copy() : unmatched string set sizes" );
+
+        priv::host_concatenated_offsets( in_string_set, out_string_set.offsets() );
+
+        // each string owns its own output symbols: unpack them in parallel
+        const int32 n_strings = int32( in_string_set.size() );
+
+        #pragma omp parallel for schedule(dynamic,256)
+        for (int32 i = 0; i < n_strings; ++i)
+        {
+            const reader_type reader( in_string_set[i] );
+            if (reader.length())
+                reader.unpack( out_string_set.base_string() + out_string_set.offsets()[i] );
+        }
+    }
+};
+
+//
+// packed-concatenated output set
+//
+template <
+    typename SymbolType,
+    uint32   SYMBOL_SIZE_T,
+    bool     BIG_ENDIAN_T,
+    typename OutStreamIterator,
+    typename OutOffsetIterator>
+struct copy_dispatch<
+    ConcatenatedStringSet<
+        PackedStream<OutStreamIterator,SymbolType,SYMBOL_SIZE_T,BIG_ENDIAN_T>,
+        OutOffsetIterator >
+    >
+{
+    typedef ConcatenatedStringSet<
+        PackedStream<OutStreamIterator,SymbolType,SYMBOL_SIZE_T,BIG_ENDIAN_T>,
+        OutOffsetIterator >
+        out_string_set_type;
+
+    typedef typename std::iterator_traits<OutStreamIterator>::value_type storage_type;
+
+    template <typename in_string_set_type>
+    static void enact(
+        const in_string_set_type&  in_string_set,
+              out_string_set_type& out_string_set)
+    {
+        if (out_string_set.size() != in_string_set.size())
+            throw nvbio::runtime_error( "copy() : unmatched string set sizes" );
+
+        priv::host_packed_concatenated_copy<sizeof(storage_type) == sizeof(uint32),SYMBOL_SIZE_T,BIG_ENDIAN_T>::enact( in_string_set, out_string_set );
+    }
+};
+
+//
+// strided output set
+//
+template <
+    typename OutStringIterator,
+    typename OutLengthIterator>
+struct copy_dispatch<
+    StridedStringSet<OutStringIterator,OutLengthIterator>
+    >
+{
+    typedef StridedStringSet<OutStringIterator,OutLengthIterator> out_string_set_type;
+
+    template <typename in_string_set_type>
+    static void enact(
+        const in_string_set_type&  in_string_set,
+              out_string_set_type& out_string_set)
+    {
+        if (out_string_set.size() != in_string_set.size() ||
+            out_string_set.stride() < out_string_set.size())
+            throw nvbio::runtime_error( "copy() : unmatched string set sizes" );
+
+        priv::host_copy_to_strided(
+            in_string_set,
+            out_string_set.stride(),
+            out_string_set.base_string(),
+            out_string_set.lengths() );
+    }
+};
+
+//
+// strided-packed output set
+//
+template <
+    typename OutStreamIterator,
+    typename SymbolType,
+    uint32   SYMBOL_SIZE_T,
+    bool     BIG_ENDIAN_T,
+    typename OutLengthIterator>
+struct copy_dispatch<
+    StridedPackedStringSet<OutStreamIterator,SymbolType,SYMBOL_SIZE_T,BIG_ENDIAN_T,OutLengthIterator>
+    >
+{
+    typedef StridedPackedStringSet<OutStreamIterator,SymbolType,SYMBOL_SIZE_T,BIG_ENDIAN_T,OutLengthIterator> out_string_set_type;
+
+    typedef typename std::iterator_traits<OutStreamIterator>::value_type storage_type;
+
+    template <typename in_string_set_type>
+    static void enact(
+        const in_string_set_type&  in_string_set,
+              out_string_set_type& out_string_set)
+    {
+        if (out_string_set.size() != in_string_set.size() ||
+            out_string_set.stride() < out_string_set.size())
+            throw nvbio::runtime_error( "copy() : unmatched string set sizes" );
+
+        priv::host_strided_packed_copy<sizeof(storage_type) == sizeof(uint32)>::enact( in_string_set, out_string_set );
     }
 };
 
@@ -31,8 +31,10 @@
 #include <nvbio/basic/packed_vector.h>
 #include <nvbio/basic/primitives.h>
 #include <nvbio/basic/cuda/sort.h>
+#include <nvbio/basic/omp.h>
 #include <thrust/sort.h>
 #include <algorithm>
+#include <iterator>
 #include <stack>
 
 namespace nvbio {
@@ -53,6 +55,10 @@ namespace nvbio {
 /// For the sake of comparison, notice that the \ref rank_dictionary class, which is based on a standard sampled occurrence
 /// table built directly on top of the original string T, needs O(s) storage - exponentially more in the number of bits
 /// per symbol <i>b = log(s)</i>.
+///\par
+/// Two layouts are provided: WaveletTree keeps the bit-planes and the occurrence samples in two separate
+/// arrays, while InterleavedWaveletTree packs each rank sample together with the bits it refers to in
+/// a single 64-byte block, so that each rank query touches a single cache line per level.
 ///
 
 ///@addtogroup WaveletTreeModule
@@ -142,6 +148,11 @@ struct WaveletTree
     NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
     IndexIterator occ() const { return m_occ; }
 
+    /// return the i-th bit of the concatenated bit-planes
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 bit(const index_type i) const { return uint32( m_bits[i] ); }
+
     /// return the number of bits set to b in the range [0,r] within node n at level l
     ///
     NVBIO_HOST_DEVICE
@@ -274,12 +285,253 @@ struct WaveletTreeStorage
 };
 
 
+///
+/// A shallow Wavelet Tree class using an interleaved layout: the concatenated bit-planes are split in blocks
+/// of BLOCK_BITS bits, each stored in BLOCK_WORDS 32-bit words, i.e. a 64-byte cache line, together with the
+/// number of ones preceding the block. The first word of each block holds the occurrence sample, and the
+/// remaining ones hold the block's bits.
+/// Compared to WaveletTree, this saves one cache miss per level for each rank query, and reduces
+/// the size of the occurrence samples from one word per bit-string word to one word per block.
+///
+/// \tparam BlockIterator       an iterator to the uint32 array of interleaved blocks;
+///                             iterator_system<BlockIterator>::type is used to determine whether
+///                             to apply host or device algorithms
+///
+/// \tparam IndexIterator       an iterator to an integer array representing the sequence splits of the
+///                             Wavelet Tree's nodes, encoded as a full binary heap; the array must
+///                             contain at least (2^SYMBOL_SIZE) - 1 entries
+///
+/// \tparam SymbolType          the unsigned integer type used to encode symbols (e.g. uint8, uint16, uint32...)
+///
+template <typename BlockIterator, typename IndexIterator, typename SymbolType = uint8>
+struct InterleavedWaveletTree
+{
+    static const uint32 BLOCK_WORDS = 16u;                          ///< the number of words per block
+    static const uint32 BLOCK_BITS  = (BLOCK_WORDS - 1u) * 32u;     ///< the number of bit-plane bits per block
+
+    // define the system tag
+    typedef typename iterator_system<BlockIterator>::type                   system_tag;
+    typedef typename std::iterator_traits<IndexIterator>::value_type        index_type;
+    typedef SymbolType                                                      symbol_type;
+    typedef SymbolType                                                      value_type;
+    typedef BlockIterator                                                   block_iterator;
+    typedef IndexIterator                                                   index_iterator;
+    typedef InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>  text_type;   // the text is the wavelet tree itself
+
+    typedef typename vector_type<index_type,2>::type                        range_type;
+    typedef null_type                                                       vector_type; // unsupported, would require knowing alphabet size
+
+    /// constructor
+    ///
+    NVBIO_HOST_DEVICE
+    InterleavedWaveletTree(
+        const uint32            _symbol_size = 0,
+        const index_type        _size        = 0,
+        const BlockIterator     _blocks      = BlockIterator(),
+        const IndexIterator     _nodes       = IndexIterator(),
+        const IndexIterator     _occ         = IndexIterator()) :
+        m_symbol_size( _symbol_size ),
+        m_size  ( _size ),
+        m_blocks( _blocks ),
+        m_nodes ( _nodes ),
+        m_occ   ( _occ ) {}
+
+    /// resize the tree
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    void resize(const uint32 _size, const uint32 _symbol_size)
+    {
+        m_size        = _size;
+        m_symbol_size = _symbol_size;
+    }
+
+    /// return the number of symbols in the alphabet
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 symbol_count() const { return 1u << m_symbol_size; }
+
+    /// return the number of bits per symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 symbol_size() const { return m_symbol_size; }
+
+    /// return the number of symbols
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    index_type size() const { return m_size; }
+
+    /// return the interleaved blocks
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    BlockIterator blocks() const { return m_blocks; }
+
+    /// return the node splits
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    IndexIterator splits() const { return m_nodes; }
+
+    /// return the number of ones preceding each node
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    IndexIterator occ() const { return m_occ; }
+
+    /// return the i-th bit of the concatenated bit-planes
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 bit(const index_type i) const;
+
+    /// return the number of bits set to b in the range [0,r] within node n at level l
+    ///
+    NVBIO_HOST_DEVICE
+    index_type rank(const uint32 l, const uint32 node, const index_type node_begin, const index_type r, const uint8 b) const;
+
+    /// return the i-th symbol
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    SymbolType operator[] (const index_type i) const;
+
+    /// return the i-th symbol - unary functor form
+    ///
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    SymbolType operator() (const index_type i) const { return this->operator[](i); }
+
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE       text_type& text()       { return *this; }
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE const text_type& text() const { return *this; }
+
+    uint32              m_symbol_size;
+    index_type          m_size;
+    BlockIterator       m_blocks;
+    IndexIterator       m_nodes;
+    IndexIterator       m_occ;
+};
+
+///
+/// An interleaved Wavelet Tree storage class, holding the blocks of interleaved bit-planes and
+/// occurrence samples, the tree structure itself, and the number of ones preceding each node.
+/// The blocks are aligned to a 64-byte boundary at allocation time, so that each of them spans
+/// a single cache line.
+///
+/// \tparam SystemTag           the system memory space where this object's data is allocated
+/// \tparam IndexType           the type of integers used to index this string
+/// \tparam SymbolType          the unsigned integer type used to encode symbols (e.g. uint8, uint16, uint32...)
+///
+template <typename SystemTag, typename IndexType = uint32, typename SymbolType = uint8>
+struct InterleavedWaveletTreeStorage
+{
+    // define the system tag
+    typedef SystemTag                                       system_tag;
+    typedef IndexType                                       index_type;
+    typedef SymbolType                                      symbol_type;
+
+    typedef nvbio::vector<system_tag,uint32>                block_vector_type;
+    typedef nvbio::vector<system_tag,index_type>            index_vector_type;
+    typedef typename block_vector_type::iterator                  block_iterator;
+    typedef typename block_vector_type::const_iterator      const_block_iterator;
+    typedef typename index_vector_type::iterator                  index_iterator;
+    typedef typename index_vector_type::const_iterator      const_index_iterator;
+
+    typedef InterleavedWaveletTree<      block_iterator,      index_iterator,symbol_type>       plain_view_type;
+    typedef InterleavedWaveletTree<const_block_iterator,const_index_iterator,symbol_type> const_plain_view_type;
+
+    static const uint32 BLOCK_WORDS = plain_view_type::BLOCK_WORDS;
+    static const uint32 BLOCK_BITS  = plain_view_type::BLOCK_BITS;
+
+    /// constructor
+    ///
+    InterleavedWaveletTreeStorage() :
+        m_symbol_size( 0u ),
+        m_size( 0u ),
+        m_offset( 0u ) {}
+
+    /// resize the tree
+    ///
+    void resize(const uint32 _size, const uint32 _symbol_size)
+    {
+        m_size        = _size;
+        m_symbol_size = _symbol_size;
+
+        const uint32 n_symbols = 1u << _symbol_size;
+        const uint32 n_words   = util::divide_ri( m_size * m_symbol_size, 32u );
+        const uint32 n_blocks  = util::divide_ri( n_words, BLOCK_WORDS - 1u );
+
+        // allocate enough slack to align the first block to a cache line
+        m_blocks.resize( n_blocks * BLOCK_WORDS + BLOCK_WORDS - 1u );
+        m_nodes.resize( n_symbols );
+        m_occ.resize( n_symbols );
+
+        const size_t address = reinterpret_cast<size_t>( raw_pointer( m_blocks ) );
+        m_offset = uint32( ((BLOCK_WORDS*4u - (address & (BLOCK_WORDS*4u - 1u))) & (BLOCK_WORDS*4u - 1u)) / 4u );
+    }
+
+    /// return the number of bits per symbol
+    ///
+    NVBIO_HOST_DEVICE
+    uint32 symbol_size() const { return m_symbol_size; }
+
+    /// return the number of symbols
+    ///
+    NVBIO_HOST_DEVICE
+    index_type size() const { return m_size; }
+
+    /// return the interleaved blocks
+    ///
+    block_iterator blocks() { return m_blocks.begin() + m_offset; }
+
+    /// return the nodes
+    ///
+    index_iterator splits() { return m_nodes.begin(); }
+
+    /// return the occurrences
+    ///
+    index_iterator occ() { return m_occ.begin(); }
+
+    /// return the interleaved blocks
+    ///
+    const_block_iterator blocks() const { return m_blocks.begin() + m_offset; }
+
+    /// return the nodes
+    ///
+    const_index_iterator splits() const { return m_nodes.begin(); }
+
+    /// return the occurrences
+    ///
+    const_index_iterator occ() const { return m_occ.begin(); }
+
+    operator plain_view_type()
+    {
+        return plain_view_type(
+            m_symbol_size,
+            m_size,
+            blocks(),
+            splits(),
+            occ() );
+    }
+    operator const_plain_view_type() const
+    {
+        return const_plain_view_type(
+            m_symbol_size,
+            m_size,
+            blocks(),
+            splits(),
+            occ() );
+    }
+
+    uint32              m_symbol_size;
+    index_type          m_size;
+    uint32              m_offset;
+    block_vector_type   m_blocks;
+    index_vector_type   m_nodes;
+    index_vector_type   m_occ;
+};
+
 /// \relates WaveletTree
 /// \relates WaveletTreeStorage
 ///
 /// build a Wavelet Tree out of a string: the output consists of a bit-string representing
 /// the different bit-planes of the output Wavelet Tree, and the tree structure itself,
 /// a binary heap, recording the sequence split of each node.
+/// On the host, each level is built with a parallel stable partition of the symbols
+/// across all available OpenMP threads.
 ///
 /// \tparam string_iterator     the string type: must provide a random access iterator
 ///                             interface as well as define a proper stream_traits<StringType>
@@ -293,6 +545,35 @@ void setup(
     const string_iterator&                                  string,
     WaveletTreeStorage<system_tag,index_type,symbol_type>&  out_tree);
 
+/// \relates InterleavedWaveletTreeStorage
+///
+/// build an interleaved Wavelet Tree out of a string, using the same algorithm as for
+/// the plain WaveletTreeStorage.
+///
+/// \tparam string_iterator     the string type: must provide a random access iterator
+///                             interface as well as define a proper stream_traits<StringType>
+///                             expansion; particularly, stream_traits<StringType>::SYMBOL_SIZE
+///                             is used to infer the number of bits needed to represent the
+///                             symbols in the string's alphabet
+///
+template <typename system_tag, typename string_iterator, typename index_type, typename symbol_type>
+void setup(
+    const index_type                                                    string_len,
+    const string_iterator&                                              string,
+    InterleavedWaveletTreeStorage<system_tag,index_type,symbol_type>&   out_tree);
+
+/// \relates InterleavedWaveletTreeStorage
+///
+/// convert a plain Wavelet Tree to the interleaved layout
+///
+/// \param in_tree      the input wavelet tree
+/// \param out_tree     the output interleaved wavelet tree
+///
+template <typename system_tag, typename index_type, typename symbol_type>
+void interleave(
+    const WaveletTreeStorage<system_tag,index_type,symbol_type>&        in_tree,
+    InterleavedWaveletTreeStorage<system_tag,index_type,symbol_type>&   out_tree);
+
 /// \relates WaveletTree
 /// fetch the text character at position i in the wavelet tree
 ///
@@ -333,6 +614,46 @@ rank(
     const typename WaveletTree<BitStreamIterator,IndexIterator,SymbolType>::range_type  range,
     const uint32                                                                        c);
 
+/// \relates InterleavedWaveletTree
+/// fetch the text character at position i in the wavelet tree
+///
+/// \param tree         the wavelet tree
+/// \param i            the index of the character to extract
+///
+template <typename BlockIterator, typename IndexIterator, typename IndexType, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+SymbolType text(const InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>& tree, const IndexType i);
+
+/// \relates InterleavedWaveletTree
+/// fetch the number of occurrences of character c in the substring [0,i]
+///
+/// \param tree         the wavelet tree
+/// \param i            the end of the query range [0,i]
+/// \param c            the query character
+///
+template <typename BlockIterator, typename IndexIterator, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::index_type
+rank(
+    const          InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>&              tree,
+    const typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::index_type   i,
+    const uint32                                                                                c);
+
+/// \relates InterleavedWaveletTree
+/// fetch the number of occurrences of character c in the substring [0,i]
+///
+/// \param tree         the wavelet tree
+/// \param i            the end of the query range [0,i]
+/// \param c            the query character
+///
+template <typename BlockIterator, typename IndexIterator, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::range_type
+rank(
+    const          InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>&              tree,
+    const typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::range_type   range,
+    const uint32                                                                                c);
+
 /// \relates WaveletTreeStorage
 ///
 /// plain_view specialization
@@ -352,6 +673,25 @@ typename WaveletTreeStorage<SystemTag,IndexType,SymbolType>::const_plain_view_ty
     return tree;
 }
 
+/// \relates InterleavedWaveletTreeStorage
+///
+/// plain_view specialization
+///
+template <typename SystemTag, typename IndexType, typename SymbolType>
+typename InterleavedWaveletTreeStorage<SystemTag,IndexType,SymbolType>::plain_view_type plain_view(InterleavedWaveletTreeStorage<SystemTag,IndexType,SymbolType>& tree)
+{
+    return tree;
+}
+/// \relates InterleavedWaveletTreeStorage
+///
+/// plain_view specialization
+///
+template <typename SystemTag, typename IndexType, typename SymbolType>
+typename InterleavedWaveletTreeStorage<SystemTag,IndexType,SymbolType>::const_plain_view_type plain_view(const InterleavedWaveletTreeStorage<SystemTag,IndexType,SymbolType>& tree)
+{
+    return tree;
+}
+
 ///@} WaveletTreeModule
 ///@} Strings
 
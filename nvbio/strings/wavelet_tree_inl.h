@@ -111,6 +111,241 @@ struct node_type
     index_range  i_range;
 };
 
+// build all the bit-planes of a Wavelet Tree on the host.
+// At level l the symbols are grouped by their leading l bits, i.e. by the node they belong to:
+// the l-th bit-plane is written out in parallel, each thread owning a disjoint set of words,
+// and the symbols are then stably partitioned by their (l+1)-th leading bit with a parallel
+// counting sort, where each thread scatters its own chunk of the input.
+//
+// \return    a pointer to the fully sorted symbols, either keys or temp
+//
+template <typename index_type, typename symbol_type>
+symbol_type* host_build_bit_planes(
+    const index_type    string_len,
+    const uint32        symbol_size,
+    symbol_type*        keys,
+    symbol_type*        temp,
+    uint32*             words)
+{
+    const uint32 max_threads = (uint32)omp_get_max_threads();
+
+    std::vector<uint64> counts( max_threads << symbol_size );
+
+    for (uint32 l = 0; l < symbol_size; ++l)
+    {
+        const uint32 bit = symbol_size - l - 1u;
+
+        // copy the l-th bit-plane to the output, skipping the bits belonging to the
+        // neighbouring levels in the boundary words
+        const uint64 plane_begin = uint64( string_len ) * l;
+        const uint64 plane_end   = plane_begin + string_len;
+
+        const int64 word_begin = int64( plane_begin / 32u );
+        const int64 word_end   = int64( util::divide_ri( plane_end, uint64(32u) ) );
+
+        #pragma omp parallel for
+        for (int64 w = word_begin; w < word_end; ++w)
+        {
+            const uint64 bit_begin = nvbio::max( uint64(w) * 32u,       plane_begin );
+            const uint64 bit_end   = nvbio::min( uint64(w) * 32u + 32u, plane_end );
+
+            uint32 mask = 0u;
+            uint32 word = 0u;
+            for (uint64 i = bit_begin; i < bit_end; ++i)
+            {
+                const uint32 shift = 31u - uint32(i & 31u);
+
+                mask |= 1u << shift;
+                word |= uint32( (keys[ i - plane_begin ] >> bit) & 1u ) << shift;
+            }
+            words[w] = (words[w] & ~mask) | word;
+        }
+
+        // stably partition each node by the l-th bit, i.e. sort by the leading l+1 bits
+        const uint32 n_buckets = 2u << l;
+
+        #pragma omp parallel
+        {
+            const uint32 n_threads = (uint32)omp_get_num_threads();
+            const uint32 tid       = (uint32)omp_get_thread_num();
+
+            const uint64 chunk     = util::divide_ri( uint64( string_len ), uint64( n_threads ) );
+            const uint64 begin     = nvbio::min( chunk * tid, uint64( string_len ) );
+            const uint64 end       = nvbio::min( begin + chunk, uint64( string_len ) );
+
+            uint64* thread_counts = &counts[ tid * n_buckets ];
+            for (uint32 b = 0; b < n_buckets; ++b)
+                thread_counts[b] = 0u;
+
+            for (uint64 i = begin; i < end; ++i)
+                ++thread_counts[ keys[i] >> bit ];
+
+            #pragma omp barrier
+
+            // compute the output offsets of each (bucket,thread) pair
+            #pragma omp single
+            {
+                uint64 offset = 0u;
+                for (uint32 b = 0; b < n_buckets; ++b)
+                {
+                    for (uint32 t = 0; t < n_threads; ++t)
+                    {
+                        const uint64 count = counts[ t * n_buckets + b ];
+                        counts[ t * n_buckets + b ] = offset;
+                        offset += count;
+                    }
+                }
+            }
+
+            for (uint64 i = begin; i < end; ++i)
+                temp[ thread_counts[ keys[i] >> bit ]++ ] = keys[i];
+        }
+        std::swap( keys, temp );
+    }
+    return keys;
+}
+
+// a private functor used to gather the interleaved blocks out of the plain bit-string
+// and occurrence table
+//
+template <uint32 BLOCK_WORDS, typename WordIterator, typename OccIterator>
+struct interleave_functor
+{
+    typedef uint32  argument_type;
+    typedef uint32  result_type;
+
+    // constructor
+    //
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    interleave_functor(
+        const uint32        _n_words,
+        const WordIterator  _words,
+        const OccIterator   _occ) :
+        n_words( _n_words ), words( _words ), occ( _occ ) {}
+
+    // unary transform operator
+    //
+    NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+    uint32 operator() (const uint32 i) const
+    {
+        const uint32 block = i / BLOCK_WORDS;
+        const uint32 word  = i & (BLOCK_WORDS-1u);
+
+        // the first word of each block holds the occurrence sample at its first bit-string word
+        if (word == 0u)
+            return uint32( occ[ block * (BLOCK_WORDS-1u) ] );
+
+        const uint32 word_index = block * (BLOCK_WORDS-1u) + word - 1u;
+        return word_index < n_words ? uint32( words[ word_index ] ) : 0u;
+    }
+
+    const uint32        n_words;
+    const WordIterator  words;
+    const OccIterator   occ;
+};
+
+// fetch the number of occurrences of character c in the substring [0,i] of
+// a generic wavelet tree, traversing it from the root down to the leaf containing c
+//
+template <typename tree_type>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename tree_type::index_type tree_rank(
+    const          tree_type&               tree,
+    const typename tree_type::index_type    i,
+    const uint32                            c)
+{
+    typedef typename tree_type::index_type index_type;
+
+    const uint32 symbol_size = tree.symbol_size();
+
+    // traverse the tree from the root node down to the leaf containing c
+    uint32     node     = 0u;
+    index_type range_lo = 0u;
+    index_type range_hi = tree.size();
+
+    index_type r = i+1;
+    
+    for (uint32 l = 0; l < symbol_size; ++l)
+    {
+        // we got to an empty node, the rank must be zero
+        if (range_lo == range_hi)
+            return 0u;
+
+        // select the l-th level bit of c
+        const uint32 b = (c >> (symbol_size - l - 1u)) & 1u;
+
+        // r is the new relative rank of c within the child node
+        r = r ? tree.rank( l, node, range_lo, r-1, b ) : 0u;
+
+        // compute the base (i.e. left) child node
+        const uint32 child = node*2u + 1u;
+
+        const uint32 split = tree.splits()[ node ];
+
+        if (b == 1)
+        {
+            // descend into the right node
+            range_lo = split;
+            node = child + 1u;
+        }
+        else
+        {
+            //  descend into the left node
+            range_hi = split;
+            node     = child;
+        }
+    }
+    return r;
+}
+
+// fetch the text character at position i of a generic wavelet tree
+//
+template <typename tree_type, typename IndexType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename tree_type::symbol_type tree_text(const tree_type& tree, const IndexType i)
+{
+    typedef typename tree_type::symbol_type SymbolType;
+
+    const uint32 symbol_size = tree.symbol_size();
+    const uint32 string_len  = tree.size();
+
+    // traverse the tree from the root node down to the leaf containing c
+    uint32    node     = 0u;
+    IndexType range_lo = 0u;
+
+    IndexType r = i;
+
+    SymbolType c = 0;
+
+    for (uint32 l = 0; l < symbol_size; ++l)
+    {
+        // read the character in position r at level l
+        const uint32 b = tree.bit( r + range_lo + string_len*l );
+
+        // insert b at the proper level in c
+        c |= b << (symbol_size - l - 1u);
+
+        // r is the new relative rank of c within the child node
+        r = r ? tree.rank( l, node, range_lo, r-1, b ) : 0u;
+
+        // compute the base (i.e. left) child node
+        const uint32 child = node*2u + 1u;
+
+        if (b == 1)
+        {
+            // descend into the right node
+            range_lo = tree.splits()[ node ];
+            node = child + 1u;
+        }
+        else
+        {
+            //  descend into the left node
+            node = child;
+        }
+    }
+    return c;
+}
+
 } // namespace wtree
 } // namespace priv
 
@@ -183,32 +418,16 @@ void setup(
         // copy the input to the temporary sorting string
         thrust::copy( string, string + string_len, sorted_string.begin() );
 
-        // loop through all bit planes in the range [0,symbol_size)
-        for (uint32 i = 0; i < symbol_size; ++i)
-        {
-            const uint32 bit = symbol_size - i - 1u;
-
-            // copy the i-th bit-plane to the output
-            nvbio::assign(
-                string_len,
-                thrust::make_transform_iterator(
-                    sorted_string.begin(),
-                    select_bit_functor<symbol_type>(bit) ),
-                out_tree.bits() + string_len * i );
-
-            // extract the leading bits
-            nvbio::transform<system_tag>(
-                string_len,
-                sorted_string.begin(),
-                sorted_string.begin() + string_len,
-                leading_bits<symbol_type>( i + 1u ) );
-
-            // sort by the leading i+1 bits
-            thrust::sort_by_key( sorted_string.begin() + string_len, sorted_string.begin() + string_len, sorted_string.begin() );
-        }
+        // build all bit-planes, partitioning each level in parallel
+        const symbol_type* sorted = priv::wtree::host_build_bit_planes(
+            string_len,
+            symbol_size,
+            raw_pointer( sorted_string ),
+            raw_pointer( sorted_string ) + string_len,
+            raw_pointer( out_tree.m_bits.m_storage ) );
 
         // setup the pointer to the fully sorted string
-        sorted_keys = sorted_string.begin();
+        sorted_keys = sorted_string.begin() + (sorted - raw_pointer( sorted_string ));
     }
 
     //
@@ -385,48 +604,7 @@ rank(
     const typename WaveletTree<BitStreamIterator,IndexIterator,SymbolType>::index_type  i,
     const uint32                                                                        c)
 {
-    typedef typename WaveletTree<BitStreamIterator,IndexIterator,SymbolType>::index_type index_type;
-
-    const uint32 symbol_size = tree.symbol_size();
-
-    // traverse the tree from the root node down to the leaf containing c
-    uint32     node     = 0u;
-    index_type range_lo = 0u;
-    index_type range_hi = tree.size();
-
-    index_type r = i+1;
-    
-    for (uint32 l = 0; l < symbol_size; ++l)
-    {
-        // we got to an empty node, the rank must be zero
-        if (range_lo == range_hi)
-            return 0u;
-
-        // select the l-th level bit of c
-        const uint32 b = (c >> (symbol_size - l - 1u)) & 1u;
-
-        // r is the new relative rank of c within the child node
-        r = r ? tree.rank( l, node, range_lo, r-1, b ) : 0u;
-
-        // compute the base (i.e. left) child node
-        const uint32 child = node*2u + 1u;
-
-        const uint32 split = tree.splits()[ node ];
-
-        if (b == 1)
-        {
-            // descend into the right node
-            range_lo = split;
-            node = child + 1u;
-        }
-        else
-        {
-            //  descend into the left node
-            range_hi = split;
-            node     = child;
-        }
-    }
-    return r;
+    return priv::wtree::tree_rank( tree, i, c );
 }
 
 // \relates WaveletTree
@@ -456,44 +634,170 @@ template <typename BitStreamIterator, typename IndexIterator, typename IndexType
 NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
 SymbolType text(const WaveletTree<BitStreamIterator,IndexIterator,SymbolType>& tree, const IndexType i)
 {
-    const uint32 symbol_size = tree.symbol_size();
-    const uint32 string_len  = tree.size();
+    return priv::wtree::tree_text( tree, i );
+}
 
-    // traverse the tree from the root node down to the leaf containing c
-    uint32    node     = 0u;
-    IndexType range_lo = 0u;
+//
+// build an interleaved Wavelet Tree out of a string
+//
+template <typename system_tag, typename string_iterator, typename index_type, typename symbol_type>
+void setup(
+    const index_type                                                    string_len,
+    const string_iterator&                                              string,
+    InterleavedWaveletTreeStorage<system_tag,index_type,symbol_type>&   out_tree)
+{
+    // build a plain wavelet tree
+    WaveletTreeStorage<system_tag,index_type,symbol_type> tree;
+    setup( string_len, string, tree );
 
-    IndexType r = i;
+    // and convert it to the interleaved layout
+    interleave( tree, out_tree );
+}
 
-    SymbolType c = 0;
+//
+// convert a plain Wavelet Tree to the interleaved layout
+//
+template <typename system_tag, typename index_type, typename symbol_type>
+void interleave(
+    const WaveletTreeStorage<system_tag,index_type,symbol_type>&        in_tree,
+    InterleavedWaveletTreeStorage<system_tag,index_type,symbol_type>&   out_tree)
+{
+    typedef InterleavedWaveletTreeStorage<system_tag,index_type,symbol_type>    out_tree_type;
+    typedef typename WaveletTreeStorage<system_tag,index_type,symbol_type>::const_bit_iterator      bit_iterator;
+    typedef typename WaveletTreeStorage<system_tag,index_type,symbol_type>::const_index_iterator    occ_iterator;
+    typedef typename bit_iterator::storage_iterator                                                 words_iterator;
 
-    for (uint32 l = 0; l < symbol_size; ++l)
-    {
-        // read the character in position r at level l
-        const uint32 b = tree.bits()[ r + range_lo + string_len*l ];
+    const uint32 symbol_size = in_tree.symbol_size();
+    const uint32 string_len  = in_tree.size();
+    const uint32 n_symbols   = 1u << symbol_size;
 
-        // insert b at the proper level in c
-        c |= b << (symbol_size - l - 1u);
+    // resize the output tree
+    out_tree.resize( string_len, symbol_size );
 
-        // r is the new relative rank of c within the child node
-        r = r ? tree.rank( l, node, range_lo, r-1, b ) : 0u;
+    // copy the tree structure, and the number of ones preceding each node
+    thrust::copy( in_tree.splits(), in_tree.splits() + n_symbols,   out_tree.splits() );
+    thrust::copy( in_tree.occ(),    in_tree.occ()    + n_symbols,   out_tree.occ() );
 
-        // compute the base (i.e. left) child node
-        const uint32 child = node*2u + 1u;
+    const uint32 n_words  = util::divide_ri( string_len * symbol_size, 32u );
+    const uint32 n_blocks = util::divide_ri( n_words, out_tree_type::BLOCK_WORDS - 1u );
 
-        if (b == 1)
-        {
-            // descend into the right node
-            range_lo = tree.splits()[ node ];
-            node = child + 1u;
-        }
-        else
-        {
-            //  descend into the left node
-            node = child;
-        }
-    }
-    return c;
+    // gather the occurrence samples and the bit-string words into blocks
+    nvbio::transform<system_tag>(
+        n_blocks * out_tree_type::BLOCK_WORDS,
+        thrust::make_counting_iterator<uint32>(0u),
+        out_tree.blocks(),
+        priv::wtree::interleave_functor<out_tree_type::BLOCK_WORDS,words_iterator,occ_iterator>(
+            n_words,
+            in_tree.bits().stream(),
+            in_tree.occ() + n_symbols ) );
+}
+
+// return the i-th symbol
+//
+template <typename BlockIterator, typename IndexIterator, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+SymbolType InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::operator[] (const index_type i) const
+{
+    return text( *this, i );
+}
+
+// return the i-th bit of the concatenated bit-planes
+//
+template <typename BlockIterator, typename IndexIterator, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+uint32 InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::bit(const index_type i) const
+{
+    const index_type block     = i / BLOCK_BITS;
+    const uint32     block_bit = uint32( i - block * BLOCK_BITS );
+
+    const uint32 word = m_blocks[ block * BLOCK_WORDS + 1u + block_bit / 32u ];
+    return (word >> (31u - (block_bit & 31u))) & 1u;
+}
+
+// return the number of bits set to b in the range [0,r] within node n at level l
+//
+template <typename BlockIterator, typename IndexIterator, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::index_type
+InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::rank(const uint32 l, const uint32 node, const index_type node_begin, const index_type r, const uint8 b) const
+{
+    // the global index of the beginning of the node is given by its local index into its level,
+    // plus the global offset of the level into the bit string, which contains size() symbols
+    // per level
+    const index_type global_node_begin = node_begin + l * size();
+
+    const index_type ones  = m_occ[ node ];                         // # of occurrences of 1's preceding the node's beginning
+    const index_type zeros = global_node_begin - ones;              // # of occurrences of 0's preceding the node's beginning
+    const index_type offset = b ? ones : zeros;                     // number of occurrences of b at the node's beginning
+
+    const index_type global_index = nvbio::min(
+        global_node_begin + r,                                      // the global position of r in the bit-string
+        size() * (l+1u) - 1u );                                     // maximum index for this level
+
+    const index_type block      = global_index / BLOCK_BITS;        // the block containing the global index
+    const uint32     block_bit  = uint32( global_index - block * BLOCK_BITS );
+    const uint32     block_word = block_bit / 32u;
+
+    const BlockIterator block_words = m_blocks + block * BLOCK_WORDS;
+
+    // start from the block's occurrence sample, and add the popcount of all the preceding words
+    index_type block_ones = block_words[0];
+    for (uint32 w = 0; w < block_word; ++w)
+        block_ones += popc( uint32( block_words[w + 1u] ) );
+
+    // add the inclusive popcount within the word containing the global index
+    block_ones += popc_nbit<1u>( uint32( block_words[block_word + 1u] ), 1u, ~block_bit & 31u );
+
+    const index_type occ = b ? block_ones : global_index + 1u - block_ones;
+    return occ - offset;
+}
+
+// \relates InterleavedWaveletTree
+// fetch the number of occurrences of character c in the substring [0,i]
+//
+// \param dict         the rank dictionary
+// \param i            the end of the query range [0,i]
+// \param c            the query character
+//
+template <typename BlockIterator, typename IndexIterator, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::index_type
+rank(
+    const          InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>&              tree,
+    const typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::index_type   i,
+    const uint32                                                                                c)
+{
+    return priv::wtree::tree_rank( tree, i, c );
+}
+
+// \relates InterleavedWaveletTree
+// fetch the number of occurrences of character c in the substring [0,i]
+//
+// \param dict         the rank dictionary
+// \param i            the end of the query range [0,i]
+// \param c            the query character
+//
+template <typename BlockIterator, typename IndexIterator, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::range_type
+rank(
+    const          InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>&              tree,
+    const typename InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>::range_type   range,
+    const uint32                                                                                c)
+{
+    return make_vector(
+        rank( tree, range.x, c ),
+        rank( tree, range.y, c ) );
+}
+
+// \relates InterleavedWaveletTree
+// fetch the text character at position i in the rank dictionary
+//
+template <typename BlockIterator, typename IndexIterator, typename IndexType, typename SymbolType>
+NVBIO_FORCEINLINE NVBIO_HOST_DEVICE
+SymbolType text(const InterleavedWaveletTree<BlockIterator,IndexIterator,SymbolType>& tree, const IndexType i)
+{
+    return priv::wtree::tree_text( tree, i );
 }
 
 } // namespace nvbio
@@ -28,6 +28,7 @@
 #include <nvbio/sufsort/file_bwt_lz4.h>
 #include <lz4/lz4.h>
 #include <lz4/lz4hc.h>
+#include <lz4/xxhash.h>
 
 namespace nvbio {
 
@@ -64,14 +65,16 @@ static const int _1BIT  = 0x01;
 static const int _2BITS = 0x03;
 static const int _3BITS = 0x07;
 
-static const uint32 BLOCK_SIZE             = 4*1024*1024;
+static const int    BLOCK_SIZE_ID          = 6;             // 4 = 64 KB, 5 = 256 KB, 6 = 1 MB, 7 = 4 MB
+static const uint32 BLOCK_SIZE             = 1024*1024;     // the compression unit, in bytes
 static const unsigned int LZ4S_MAGICNUMBER = 0x184D2204;
 static const unsigned int LZ4S_EOS         = 0;
+static const uint32 NUM_BLOCKS             = 32;            // the number of blocks compressed in parallel
 
 // constructor
 //
 LZ4FileWriter::LZ4FileWriter(FILE* _file) :
-    m_file(NULL), m_buffer(BLOCK_SIZE), m_buffer_size(0), m_comp_buffer(BLOCK_SIZE)
+    m_file(NULL), m_buffer(NUM_BLOCKS*BLOCK_SIZE), m_comp_buffer(NUM_BLOCKS*BLOCK_SIZE), m_buffer_size(0)
 {
     if (_file != NULL)
         open( _file );
@@ -90,9 +93,7 @@ void LZ4FileWriter::open(FILE* _file)
     const int blockIndependence = 1;
     const int blockChecksum     = 0;
     const int streamChecksum    = 0;
-    const int blockSizeId       = 7; // 64 KB   (4 = 64 KB, 5 = 256 KB, 6 = 1 MB, 7 = 4 MB)
-
-    unsigned int checkbits = 0;
+    const int blockSizeId       = BLOCK_SIZE_ID;
 
     // write the archive header
     char out_buff[7];
@@ -102,9 +103,7 @@ void LZ4FileWriter::open(FILE* _file)
     *(out_buff+4) |= (blockChecksum & _1BIT) << 4;
     *(out_buff+4) |= (streamChecksum & _1BIT) << 2;
     *(out_buff+5)  = (char)((blockSizeId & _3BITS) << 4);
-    //checkbits = XXH32((out_buff+4), 2, LZ4S_CHECKSUM_SEED);
-    //checkbits = LZ4S_GetCheckBits_FromXXH(checkbits);
-    *(out_buff+6)  = (unsigned char)checkbits;
+    *(out_buff+6)  = (unsigned char)((XXH32( out_buff+4, 2, 0 ) >> 8) & 0xFF);
     fwrite( out_buff, 1, 7, m_file );
 }
 
@@ -137,13 +136,15 @@ void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
     // convert input to a uint8 pointer
     const uint8* src = (const uint8*)_src;
 
+    const uint32 NB = NUM_BLOCKS;
+
     if (m_buffer_size)
     {
         //
         // we have some pending bytes in the buffer, let's add as much as we can and
         // eventually output a block if full
         //
-        const uint32 n_needed = nvbio::min( BLOCK_SIZE - m_buffer_size, n_bytes );
+        const uint32 n_needed = nvbio::min( NB*BLOCK_SIZE - m_buffer_size, n_bytes );
 
         // copy the given block from the source
         memcpy( &m_buffer[0] + m_buffer_size, src, n_needed );
@@ -152,7 +153,7 @@ void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
         src           += n_needed;
         n_bytes       -= n_needed;
 
-        if (m_buffer_size == BLOCK_SIZE)
+        if (m_buffer_size == NB*BLOCK_SIZE)
         {
             encode_block( m_buffer_size, &m_buffer[0] );
             m_buffer_size = 0;
@@ -164,14 +165,14 @@ void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
     // we have terminated the source (i.e. n_bytes = 0)
     //
 
-    for (uint32 block_begin = 0; block_begin < n_bytes; block_begin += BLOCK_SIZE)
+    for (uint32 block_begin = 0; block_begin < n_bytes; block_begin += NB*BLOCK_SIZE)
     {
-        const uint32 block_end = nvbio::min( block_begin + BLOCK_SIZE, n_bytes );
+        const uint32 block_end = nvbio::min( block_begin + NB*BLOCK_SIZE, n_bytes );
 
-        if (block_end - block_begin == BLOCK_SIZE)
+        if (block_end - block_begin == NB*BLOCK_SIZE)
         {
             // encode directly without buffering
-            encode_block( BLOCK_SIZE, src + block_begin );
+            encode_block( NB*BLOCK_SIZE, src + block_begin );
         }
         else
         {
@@ -182,23 +183,35 @@ void LZ4FileWriter::write(uint32 n_bytes, const void* _src)
     }
 }
 
-// encode a given block and write it to the output
+// encode a given set of independent blocks in parallel and write them to the output
 //
 void LZ4FileWriter::encode_block(uint32 n_bytes, const uint8* src)
 {
-    const uint32 n_compressed = (uint32)LZ4_compressHC_limitedOutput( (const char*)src, (char*)&m_comp_buffer[0], n_bytes, n_bytes-1 );
+    uint32 block_sizes[NUM_BLOCKS];
 
-    if (n_compressed)
+    #pragma omp parallel for
+    for (int block = 0; block < int( n_bytes ); block += BLOCK_SIZE)
     {
-        const uint32 block_header = LITTLE_ENDIAN_32( n_compressed );
-        fwrite( &block_header, sizeof(uint32), 1u, m_file );
-        fwrite( &m_comp_buffer[0], sizeof(uint8), n_compressed, m_file );
+        const uint32 block_size = nvbio::min( BLOCK_SIZE, uint32( n_bytes - block ) );
+        block_sizes[ block/BLOCK_SIZE ] = (uint32)LZ4_compressHC_limitedOutput( (const char*)src + block, (char*)&m_comp_buffer[0] + block, block_size, block_size-1 );
     }
-    else
+
+    for (int block = 0; block < int( n_bytes ); block += BLOCK_SIZE)
     {
-        const uint32 block_header = LITTLE_ENDIAN_32( n_bytes | 0x80000000);   // Add Uncompressed flag
-        fwrite( &block_header, sizeof(uint32), 1u, m_file );
-        fwrite( src, sizeof(uint8), n_bytes, m_file );
+        const uint32 block_size   = nvbio::min( BLOCK_SIZE, uint32( n_bytes - block ) );
+        const uint32 n_compressed = block_sizes[ block/BLOCK_SIZE ];
+        if (n_compressed)
+        {
+            const uint32 block_header = LITTLE_ENDIAN_32( n_compressed );
+            fwrite( &block_header, sizeof(uint32), 1u, m_file );
+            fwrite( &m_comp_buffer[0] + block, sizeof(uint8), n_compressed, m_file );
+        }
+        else
+        {
+            const uint32 block_header = LITTLE_ENDIAN_32( block_size | 0x80000000);   // Add Uncompressed flag
+            fwrite( &block_header, sizeof(uint32), 1u, m_file );
+            fwrite( src + block, sizeof(uint8), block_size, m_file );
+        }
     }
 }
 
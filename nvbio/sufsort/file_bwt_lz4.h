@@ -54,7 +54,7 @@ struct LZ4FileWriter
     void write(uint32 n_bytes, const void* _src);
 
 private:
-    /// encode a given block and write it to the output
+    /// encode a given set of blocks in parallel and write them to the output
     ///
     void encode_block(uint32 n_bytes, const uint8* src);
 
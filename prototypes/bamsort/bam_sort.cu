@@ -685,19 +685,49 @@ void duplicate_unsorted_bam(const char* in_fname, const char* out_fname, int num
 	}
 }
 
-//TODO: overlap load with device compute
 int main(int argc, char **argv)
 {
 	if(argc < 3) {
-		printf("Usage: ./bamsort <bam_file> <out_file> \n");
+		printf("Usage: ./bamsort [options] <bam_file> <out_file> \n");
+		printf("options:\n");
+		printf("  -n            sort by read name instead of coordinate\n");
+		printf("  -m <MB>       memory budget for the in-memory runs [768]\n");
+		printf("  -t <threads>  number of host threads [all cores]\n");
+		printf("  -T <prefix>   prefix of the temporary run files [out_file]\n");
+		printf("  -gpu          use the GPU pipeline (coordinate order only)\n");
 		exit(1);
 	}
 
+	bamsort_host_options options;
+	bool use_gpu = false;
+
+	int arg = 1;
+	for(; arg < argc - 2; arg++) {
+		if(strcmp(argv[arg], "-n") == 0) {
+			options.by_name = true;
+		} else if(strcmp(argv[arg], "-m") == 0) {
+			options.max_memory = uint64(atoi(argv[++arg])) * 1024u * 1024u;
+		} else if(strcmp(argv[arg], "-t") == 0) {
+			options.n_threads = uint32(atoi(argv[++arg]));
+		} else if(strcmp(argv[arg], "-T") == 0) {
+			options.tmp_prefix = argv[++arg];
+		} else if(strcmp(argv[arg], "-gpu") == 0) {
+			use_gpu = true;
+		} else {
+			printf("Unknown option %s\n", argv[arg]);
+			exit(1);
+		}
+	}
+
 	try {
-		//generate_unsorted_bam(argv[1], argv[2]);
-		//duplicate_unsorted_bam(argv[1], argv[2], 1000);
-		bamsort_pipeline_basic(argv[1], argv[2]);
-		//bamsort_pipeline_multigpu(argv[1], argv[2]);
+		//generate_unsorted_bam(argv[arg], argv[arg+1]);
+		//duplicate_unsorted_bam(argv[arg], argv[arg+1], 1000);
+		//bamsort_pipeline_multigpu(argv[arg], argv[arg+1]);
+		if(use_gpu) {
+			bamsort_pipeline_basic(argv[arg], argv[arg+1]);
+		} else {
+			bamsort_pipeline_host(argv[arg], argv[arg+1], options);
+		}
 	} catch (nvbio::runtime_error& e) {
 		printf("%s\n", e.what());
 		exit(1);
@@ -232,3 +232,24 @@ struct is_less
 		return x <= pivot;
 	}
 };
+
+/** Host Sort Pipeline (bounded-memory, multi-core) **/
+
+// maximum number of runs merged in a single pass
+#define H_MAX_MERGE_FANIN 64
+
+// host sorter options
+struct bamsort_host_options
+{
+	bool by_name;           // sort by read name instead of coordinate
+	uint64 max_memory;      // memory budget for the in-memory runs (bytes)
+	uint32 n_threads;       // number of host threads (0 = all cores)
+	std::string tmp_prefix; // prefix of the temporary run files (defaults to the output file name)
+
+	bamsort_host_options() : by_name(false), max_memory(uint64(768u) * 1024u * 1024u), n_threads(0u) { }
+};
+
+// sort a BAM file with bounded memory:
+// fixed-memory runs are sorted in parallel on the host and spilled to BGZF temporary files,
+// which are then k-way merged into the output
+void bamsort_pipeline_host(const char* in_fname, const char* out_fname, const bamsort_host_options& options);
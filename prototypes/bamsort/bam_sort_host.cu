@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) 2012-14, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * NVIDIA CORPORATION and its licensors retain all intellectual property
+ * and proprietary rights in and to this software, related documentation
+ * and any modifications thereto.  Any use, reproduction, disclosure or
+ * distribution of this software and related documentation without an express
+ * license agreement from NVIDIA CORPORATION is strictly prohibited.
+ *
+ *
+ *
+ *
+ *
+ *
+ *
+ *
+ */
+
+
+#include <nvbio/basic/types.h>
+#include <nvbio/basic/vector.h>
+#include <nvbio/basic/primitives.h>
+#include <nvbio/basic/threads.h>
+#include <nvbio/basic/timer.h>
+#include <nvbio/basic/system.h>
+#include <nvbio/basic/omp.h>
+#include <nvbio/basic/exceptions.h>
+
+#include <htslib/sam.h>
+#include <htslib/hts.h>
+#include <htslib/bgzf.h>
+
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include "bam_io.h"
+#include "bam_sort.h"
+
+using namespace nvbio;
+
+/** --------- Host Sorting Utilities -------- **/
+
+// a run of alignment records; the record buffers are reused from one run to the next
+struct bamsort_run
+{
+	std::vector<bam1_t*> recs;
+	uint64 n_recs;
+	uint64 bytes; // decoded record bytes
+	bool eof;
+
+	bamsort_run() : n_recs(0), bytes(0), eof(false) { }
+	~bamsort_run()
+	{
+		for(uint64 i = 0; i < recs.size(); i++) {
+			bam_destroy1(recs[i]);
+		}
+	}
+};
+
+// decodes records into a run until the memory budget is reached
+// returns false if no records were read
+bool load_run(samFile* fp, bam_hdr_t* header, bamsort_run& run, const uint64 budget)
+{
+	run.n_recs = 0;
+	run.bytes = 0;
+	while(run.bytes < budget) {
+		if(run.n_recs == run.recs.size()) {
+			run.recs.push_back(bam_init1());
+		}
+		bam1_t* b = run.recs[run.n_recs];
+		if(sam_read1(fp, header, b) < 0) {
+			run.eof = true;
+			break;
+		}
+		// account for the record itself as well as its sort key and index
+		run.bytes += b->l_data + sizeof(bam1_t) + sizeof(uint64) + sizeof(uint32);
+		run.n_recs++;
+	}
+	return run.n_recs > 0;
+}
+
+// background BAM decoder: decodes the next run while the current one is being consumed,
+// using a pair of run buffers
+struct bamsort_loader : public Thread<bamsort_loader>
+{
+	bamsort_loader(const char* fname, const uint64 budget) : budget(budget), decode_time(0.0f), n_loaded(0), n_released(0), done(false), cancelled(false)
+	{
+		fp = sam_open(fname, "r");
+		if(fp == NULL) {
+			throw nvbio::runtime_error("Could not open %s", fname);
+		}
+		header = sam_hdr_read(fp);
+		if(header == NULL) {
+			sam_close(fp);
+			throw nvbio::runtime_error("Error parsing BAM file header");
+		}
+	}
+
+	~bamsort_loader()
+	{
+		bam_hdr_destroy(header);
+		sam_close(fp);
+	}
+
+	void run()
+	{
+		for(uint32 i = 0; ; i++) {
+			// wait for the buffer to be released
+			while(i - released() >= 2u) {
+				if(is_cancelled()) {
+					return;
+				}
+				yield();
+			}
+
+			bamsort_run& r = runs[i & 1u];
+			Timer timer;
+			timer.start();
+			const bool loaded = load_run(fp, header, r, budget);
+			timer.stop();
+
+			ScopedLock guard(&lock);
+			decode_time += timer.seconds();
+			if(loaded) {
+				n_loaded++;
+			}
+			if(!loaded || r.eof) {
+				done = true;
+				break;
+			}
+		}
+	}
+
+	// waits for the i-th run; returns NULL if there are no more runs
+	bamsort_run* acquire(const uint32 i)
+	{
+		while(1) {
+			{
+				ScopedLock guard(&lock);
+				if(n_loaded > i) {
+					return &runs[i & 1u];
+				}
+				if(done) {
+					return NULL;
+				}
+			}
+			yield();
+		}
+	}
+
+	// releases the oldest acquired run
+	void release()
+	{
+		ScopedLock guard(&lock);
+		n_released++;
+	}
+
+	uint32 released()
+	{
+		ScopedLock guard(&lock);
+		return n_released;
+	}
+
+	// stops decoding, letting the thread be joined while some runs are still unconsumed
+	void cancel()
+	{
+		ScopedLock guard(&lock);
+		cancelled = true;
+	}
+
+	bool is_cancelled()
+	{
+		ScopedLock guard(&lock);
+		return cancelled;
+	}
+
+	samFile* fp;
+	bam_hdr_t* header;
+	uint64 budget;
+	bamsort_run runs[2];
+	float decode_time;
+
+	Mutex lock;
+	volatile uint32 n_loaded;
+	volatile uint32 n_released;
+	volatile bool done;
+	volatile bool cancelled;
+};
+
+// compares two records by read name, then by mate (READ1 before READ2)
+inline int bam_name_cmp(const bam1_t* a, const bam1_t* b)
+{
+	const int c = strcmp(bam_get_qname(a), bam_get_qname(b));
+	if(c) {
+		return c;
+	}
+	return int(a->core.flag & (BAM_FREAD1 | BAM_FREAD2)) - int(b->core.flag & (BAM_FREAD1 | BAM_FREAD2));
+}
+
+// generates the sort key of a record
+// coordinate order: unmapped reads (refID = -1) will have the largest key,
+// ties are broken by strand
+// name order: the first 8 characters of the read name, packed in big-endian order;
+// records with the same key are ordered by bam_name_cmp
+inline uint64 bam_sort_key(const bam1_t* b, const bool by_name)
+{
+	if(by_name) {
+		const char* name = bam_get_qname(b);
+		uint64 key = 0;
+		uint32 i = 0;
+		for(; i < 8 && name[i]; i++) {
+			key = (key << 8) | uint8(name[i]);
+		}
+		return key << (8 * (8 - i));
+	}
+	uint64 key = uint64(uint32(b->core.tid)) << 32;
+	key |= uint64(uint32(b->core.pos + 1)) << 1;
+	key |= ((b->core.flag & BAM_FREVERSE) != 0);
+	return key;
+}
+
+// orders record indices with equal name keys
+struct bam_name_less
+{
+	bam_name_less(const bamsort_run& run) : recs(&run.recs[0]) { }
+
+	bool operator() (const uint32 a, const uint32 b) const
+	{
+		const int c = bam_name_cmp(recs[a], recs[b]);
+		return c < 0 || (c == 0 && a < b);
+	}
+
+	bam1_t* const* recs;
+};
+
+// sorts a run in memory: the keys are generated in parallel and
+// sorted with the host radix path; name ties are resolved on the full names
+void sort_run(const bamsort_run& run, const bool by_name, H_VectorU64& keys, H_VectorU32& ids, nvbio::vector<host_tag, uint8>& temp_storage)
+{
+	const int64 n = int64(run.n_recs);
+	keys.resize(n);
+	ids.resize(n);
+
+	#pragma omp parallel for
+	for(int64 i = 0; i < n; i++) {
+		keys[i] = bam_sort_key(run.recs[i], by_name);
+		ids[i] = uint32(i);
+	}
+
+	radix_sort(uint32(n), keys.begin(), ids.begin(), temp_storage);
+
+	if(by_name) {
+		// resolve the records sharing the same name prefix
+		int64 i = 0;
+		while(i < n) {
+			int64 j = i + 1;
+			while(j < n && keys[j] == keys[i]) {
+				j++;
+			}
+			if(j - i > 1) {
+				std::sort(ids.begin() + i, ids.begin() + j, bam_name_less(run));
+			}
+			i = j;
+		}
+	}
+}
+
+// sets the SO tag of the @HD header line
+void set_sort_order(bam_hdr_t* header, const char* order)
+{
+	std::string text(header->text ? header->text : "", header->l_text);
+	const std::string so = std::string("SO:") + order;
+	if(text.compare(0, 3, "@HD") == 0) {
+		const size_t eol = std::min(text.find('\n'), text.size());
+		std::string hd = text.substr(0, eol);
+		const size_t so_pos = hd.find("\tSO:");
+		if(so_pos != std::string::npos) {
+			const size_t so_end = std::min(hd.find('\t', so_pos + 1), hd.size());
+			hd.replace(so_pos + 1, so_end - so_pos - 1, so);
+		} else {
+			hd += "\t" + so;
+		}
+		text = hd + text.substr(eol);
+	} else {
+		text = "@HD\tVN:1.4\t" + so + "\n" + text;
+	}
+	free(header->text);
+	header->l_text = uint32(text.size());
+	header->text = (char*)malloc(text.size() + 1);
+	memcpy(header->text, text.c_str(), text.size() + 1);
+}
+
+// opens a BAM file for writing with parallel BGZF compression
+samFile* open_bam_output(const char* fname, const char* mode, bam_hdr_t* header, const uint32 n_threads)
+{
+	samFile* fp = sam_open(fname, mode);
+	if(fp == NULL) {
+		throw nvbio::runtime_error("Could not open %s for writing", fname);
+	}
+	if(n_threads > 1) {
+		hts_set_threads(fp, int(n_threads));
+	}
+	sam_hdr_write(fp, header);
+	return fp;
+}
+
+// min-heap entry of the k-way merge
+struct bamsort_merge_entry
+{
+	uint64 key;
+	uint32 run;
+	bam1_t* rec;
+};
+
+// orders the merge entries; the run index makes the merge stable
+struct bamsort_merge_greater
+{
+	bamsort_merge_greater(const bool by_name) : by_name(by_name) { }
+
+	bool operator() (const bamsort_merge_entry& a, const bamsort_merge_entry& b) const
+	{
+		if(a.key != b.key) {
+			return a.key > b.key;
+		}
+		if(by_name) {
+			const int c = bam_name_cmp(a.rec, b.rec);
+			if(c) {
+				return c > 0;
+			}
+		}
+		return a.run > b.run;
+	}
+
+	bool by_name;
+};
+
+// k-way merge of sorted run files into out_fname
+// each run is decoded ahead on its own thread, while the output is compressed by the BGZF worker threads
+// returns the number of decoded bytes
+uint64 merge_runs(const std::vector<std::string>& runs, const char* out_fname, const char* mode,
+		bam_hdr_t* header, const bamsort_host_options& options, const uint32 n_threads)
+{
+	const uint32 k = uint32(runs.size());
+	const uint64 budget = nvbio::max(options.max_memory / (2u * k), uint64(1u) << 20);
+
+	std::vector<bamsort_loader*> loaders(k);
+	std::vector<bamsort_run*> current(k);
+	std::vector<uint32> run_ids(k, 0u);
+	std::vector<uint64> cursors(k, 0u);
+
+	std::priority_queue<bamsort_merge_entry, std::vector<bamsort_merge_entry>, bamsort_merge_greater> heap(
+			bamsort_merge_greater(options.by_name));
+
+	for(uint32 r = 0; r < k; r++) {
+		loaders[r] = new bamsort_loader(runs[r].c_str(), budget);
+		loaders[r]->create();
+	}
+	for(uint32 r = 0; r < k; r++) {
+		current[r] = loaders[r]->acquire(0u);
+		if(current[r]) {
+			bamsort_merge_entry e = { bam_sort_key(current[r]->recs[0], options.by_name), r, current[r]->recs[0] };
+			heap.push(e);
+		}
+	}
+
+	samFile* out = open_bam_output(out_fname, mode, header, n_threads);
+	uint64 bytes = 0;
+	bool failed = false;
+	while(!heap.empty()) {
+		const bamsort_merge_entry e = heap.top();
+		heap.pop();
+
+		if(sam_write1(out, header, e.rec) < 0) {
+			failed = true;
+			break;
+		}
+		bytes += e.rec->l_data + sizeof(bam1_core_t);
+
+		// advance the run
+		const uint32 r = e.run;
+		if(++cursors[r] == current[r]->n_recs) {
+			loaders[r]->release();
+			current[r] = loaders[r]->acquire(++run_ids[r]);
+			cursors[r] = 0;
+		}
+		if(current[r]) {
+			bam1_t* b = current[r]->recs[cursors[r]];
+			bamsort_merge_entry next = { bam_sort_key(b, options.by_name), r, b };
+			heap.push(next);
+		}
+	}
+	if(sam_close(out) < 0) {
+		failed = true;
+	}
+
+	for(uint32 r = 0; r < k; r++) {
+		if(failed) {
+			loaders[r]->cancel();
+		}
+		loaders[r]->join();
+		delete loaders[r];
+	}
+	if(failed) {
+		throw nvbio::runtime_error("Error writing %s", out_fname);
+	}
+	return bytes;
+}
+
+// prints the throughput of a phase
+void report_phase(const char* name, const uint64 n_recs, const uint64 bytes, const float seconds)
+{
+	const float t = nvbio::max(seconds, 1.0e-6f);
+	printf("%-16s: %.4fs, %.2f M records/s, %.2f MB/s\n",
+			name, seconds, float(n_recs) * 1.0e-6f / t, float(bytes) / (1024.0f * 1024.0f * t));
+}
+
+/** ------ Host Sorting Pipeline ---------- **/
+
+// bounded-memory host sort:
+// 1. the input is decoded in fixed-memory runs on a background thread (two run buffers share the budget)
+// 2. each run is sorted in parallel and spilled to a temporary BGZF file with parallel compression
+// 3. the runs are k-way merged, in multiple passes if there are more than H_MAX_MERGE_FANIN of them
+void bamsort_pipeline_host(const char* in_fname, const char* out_fname, const bamsort_host_options& options)
+{
+	const uint32 n_threads = options.n_threads ? options.n_threads : uint32(omp_get_num_procs());
+	omp_set_num_threads(n_threads);
+
+	const std::string tmp_prefix = options.tmp_prefix.length() ? options.tmp_prefix : std::string(out_fname);
+	const char* sort_order = options.by_name ? "queryname" : "coordinate";
+
+	Timer timer_all;
+	timer_all.start();
+
+	// 1. generate the sorted runs
+	bamsort_loader loader(in_fname, nvbio::max(options.max_memory / 2u, uint64(1u) << 20));
+	bam_hdr_t* header = bam_hdr_dup(loader.header);
+	set_sort_order(header, sort_order);
+
+	loader.create();
+
+	H_VectorU64 keys;
+	H_VectorU32 ids;
+	nvbio::vector<host_tag, uint8> temp_storage;
+
+	std::vector<std::string> runs;
+	uint64 n_recs = 0, n_bytes = 0;
+	float sort_time = 0.0f, spill_time = 0.0f;
+
+	Timer timer;
+	timer.start();
+	for(uint32 i = 0; ; i++) {
+		bamsort_run* run = loader.acquire(i);
+		if(run == NULL) {
+			break;
+		}
+
+		Timer phase_timer;
+		phase_timer.start();
+		sort_run(*run, options.by_name, keys, ids, temp_storage);
+		phase_timer.stop();
+		sort_time += phase_timer.seconds();
+
+		// if the whole input fits in a single run, write the output directly
+		const bool single_run = (i == 0 && run->eof);
+
+		char run_fname[1024];
+		snprintf(run_fname, sizeof(run_fname), "%s.tmp.%04u.bam", tmp_prefix.c_str(), i);
+
+		phase_timer.start();
+		samFile* fp = single_run ?
+				open_bam_output(out_fname, "wb", header, n_threads) :
+				open_bam_output(run_fname, "wb1", header, n_threads);
+		bool failed = false;
+		for(uint64 j = 0; j < run->n_recs && !failed; j++) {
+			failed = sam_write1(fp, header, run->recs[ids[j]]) < 0;
+		}
+		if(sam_close(fp) < 0) {
+			failed = true;
+		}
+		if(failed) {
+			loader.cancel();
+			loader.join();
+			bam_hdr_destroy(header);
+			for(uint32 r = 0; r < runs.size(); r++) {
+				remove(runs[r].c_str());
+			}
+			throw nvbio::runtime_error("Error writing %s", single_run ? out_fname : run_fname);
+		}
+		phase_timer.stop();
+		spill_time += phase_timer.seconds();
+
+		n_recs += run->n_recs;
+		n_bytes += run->bytes;
+		if(!single_run) {
+			runs.push_back(run_fname);
+		}
+		loader.release();
+		printf("Sorted run %u: %llu records\n", i, (unsigned long long) run->n_recs);
+	}
+	loader.join();
+	timer.stop();
+
+	report_phase("Decode", n_recs, n_bytes, loader.decode_time);
+	report_phase("Sort", n_recs, n_bytes, sort_time);
+	report_phase(runs.size() ? "Spill" : "Write", n_recs, n_bytes, spill_time);
+	report_phase("Run generation", n_recs, n_bytes, timer.seconds());
+	printf("Number of runs  : %u\n", uint32(runs.size()));
+
+	// release the run buffers before merging
+	keys = H_VectorU64();
+	ids = H_VectorU32();
+	temp_storage = nvbio::vector<host_tag, uint8>();
+
+	// 2. merge the runs
+	if(runs.size()) {
+		timer.start();
+		uint32 pass = 0;
+		while(runs.size() > H_MAX_MERGE_FANIN) {
+			// intermediate pass: merge groups of runs into new temporary runs
+			std::vector<std::string> merged;
+			for(uint32 g = 0; g < runs.size(); g += H_MAX_MERGE_FANIN) {
+				const uint32 g_end = nvbio::min(g + H_MAX_MERGE_FANIN, uint32(runs.size()));
+				const std::vector<std::string> group(runs.begin() + g, runs.begin() + g_end);
+
+				char run_fname[1024];
+				snprintf(run_fname, sizeof(run_fname), "%s.tmp.p%u.%04u.bam", tmp_prefix.c_str(), pass + 1, g / H_MAX_MERGE_FANIN);
+				merge_runs(group, run_fname, "wb1", header, options, n_threads);
+				merged.push_back(run_fname);
+
+				for(uint32 r = 0; r < group.size(); r++) {
+					remove(group[r].c_str());
+				}
+			}
+			runs.swap(merged);
+			pass++;
+		}
+		const uint64 bytes = merge_runs(runs, out_fname, "wb", header, options, n_threads);
+		timer.stop();
+
+		for(uint32 r = 0; r < runs.size(); r++) {
+			remove(runs[r].c_str());
+		}
+		report_phase("Merge", n_recs, bytes, timer.seconds());
+	}
+
+	timer_all.stop();
+	report_phase("Total", n_recs, n_bytes, timer_all.seconds());
+	printf("Peak RSS        : %.2f MB\n", float(peak_resident_memory()) / (1024.0f * 1024.0f));
+
+	bam_hdr_destroy(header);
+}